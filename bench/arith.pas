@@ -0,0 +1,27 @@
+program arith;
+var
+   i, n : integer;
+   pi, term, sign, x, y : real;
+begin
+    n := 10000000;
+    pi := 0.0;
+    sign := 1.0;
+    i := 0;
+    while i < n do
+    begin
+        term := sign / (2 * i + 1);
+        pi := pi + term;
+        sign := -sign;
+        i := i + 1;
+    end
+    pi := pi * 4;
+    x := 1.0;
+    y := 0.0;
+    i := 0;
+    while i < n do
+    begin
+        y := y + x * x - x / 3.0;
+        x := x + 0.000001;
+        i := i + 1;
+    end
+end.
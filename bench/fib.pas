@@ -0,0 +1,12 @@
+program recursion;
+var
+   n, result : integer;
+function fib(n: integer): integer;
+begin
+    if n < 2 then fib := n;
+    else fib := fib(n - 1) + fib(n - 2);
+end
+begin
+    n := 32;
+    result := fib(n);
+end.
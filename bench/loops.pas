@@ -0,0 +1,18 @@
+program loops;
+var
+   i, j, n, sum : integer;
+begin
+    n := 3000;
+    sum := 0;
+    i := 0;
+    while i < n do
+    begin
+        j := 0;
+        while j < n do
+        begin
+            sum := sum + (i * j) mod 7;
+            j := j + 1;
+        end
+        i := i + 1;
+    end
+end.
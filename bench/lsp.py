@@ -0,0 +1,101 @@
+# Mede o tempo do servidor de --lsp em um arquivo de 50 mil linhas: a abertura, cada tecla digitada dentro de um
+# procedimento no meio do arquivo até chegar os diagnósticos dela, com a mediana e o p99, e os símbolos do documento
+# Só a função editada é verificada de novo, então o tempo por tecla deve ficar bem abaixo do da abertura
+# Uso: python3 bench/lsp.py [linhas, padrão 50000] [PascalSyntaxAnalyzer]
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 50000
+psa = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, '..', 'bin', 'PascalSyntaxAnalyzer')
+
+
+def send(p, message):
+    body = json.dumps(message).encode()
+    p.stdin.write(b'Content-Length: %d\r\n\r\n' % len(body) + body)
+    p.stdin.flush()
+
+
+def receive(p):
+    header = b''
+    while not header.endswith(b'\r\n\r\n'):
+        header += p.stdout.read(1)
+    return json.loads(p.stdout.read(int(re.search(rb'Content-Length: (\d+)', header).group(1))))
+
+
+def request(p, id, method, params):
+    send(p, {'jsonrpc': '2.0', 'id': id, 'method': method, 'params': params})
+    while True:
+        message = receive(p)
+        if message.get('id') == id:
+            return message
+
+
+def position(text, offset):
+    before = text[:offset]
+    start = before.rfind('\n') + 1
+    return {'line': before.count('\n'), 'character': len(before[start:].encode('utf-16-le')) // 2}
+
+
+# Os símbolos vêm em árvore, o programa contém os procedimentos
+def count(symbols):
+    return sum(1 + count(s.get('children', [])) for s in symbols)
+
+
+def milliseconds(start):
+    return (time.perf_counter() - start) * 1000
+
+
+lines = ['program Big;', 'var a : integer;']
+procedures = 0
+while len(lines) < size:
+    lines += ['procedure p%d(x: integer);' % procedures, 'var t : integer;', 'begin',
+              '    t := x * %d + (x - 3) div 2;' % procedures,
+              '    if t > 10 then t := t mod 7; else begin t := -t; end',
+              '    while t < 100 do begin t := t + 1; end', 'end']
+    procedures += 1
+lines += ['begin', '    a := 1;', 'end.']
+text = '\n'.join(lines) + '\n'
+
+p = subprocess.Popen([psa, '--lsp'], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+request(p, 1, 'initialize', {'capabilities': {}})
+uri = 'file:///big.pas'
+
+start = time.perf_counter()
+send(p, {'jsonrpc': '2.0', 'method': 'textDocument/didOpen',
+         'params': {'textDocument': {'uri': uri, 'languageId': 'pascal', 'version': 1, 'text': text}}})
+receive(p)
+print('%d linhas, %d bytes, abertura em %.1f ms' % (len(lines), len(text), milliseconds(start)))
+
+# As teclas deixam o procedimento do meio com erro e depois o corrigem, sem erros os símbolos são todos listados
+middle = 'x * %d' % (procedures // 2)
+offset = text.index(middle) + len(middle)
+times = []
+for version, key in enumerate(' + (a - 12345)', 2):
+    at = position(text, offset)
+    text = text[:offset] + key + text[offset:]
+    offset += 1
+
+    start = time.perf_counter()
+    send(p, {'jsonrpc': '2.0', 'method': 'textDocument/didChange',
+             'params': {'textDocument': {'uri': uri, 'version': version},
+                        'contentChanges': [{'range': {'start': at, 'end': at}, 'text': key}]}})
+    diagnostics = receive(p)['params']['diagnostics']
+    times.append(milliseconds(start))
+
+times.sort()
+print('%d teclas até os diagnósticos: mediana %.2f ms, p99 %.2f ms, máximo %.2f ms, %d erro(s) no fim' %
+      (len(times), times[len(times) // 2], times[min(len(times) - 1, len(times) * 99 // 100)], times[-1],
+       len(diagnostics)))
+
+start = time.perf_counter()
+symbols = request(p, 2, 'textDocument/documentSymbol', {'textDocument': {'uri': uri}})['result']
+print('%d símbolos do documento em %.1f ms' % (count(symbols), milliseconds(start)))
+
+request(p, 3, 'shutdown', None)
+send(p, {'jsonrpc': '2.0', 'method': 'exit', 'params': None})
+p.wait()
\ No newline at end of file
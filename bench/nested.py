@@ -0,0 +1,28 @@
+# Gera um programa com procedimentos aninhados uns dentro dos outros, cada um com muitas variáveis locais e
+# atribuições que usam as locais, o parâmetro do próprio nível e uma variável global
+# Os nomes das locais se repetem em todos os níveis, então cada nível esconde as locais dos níveis de fora
+# Uso: python3 bench/nested.py <níveis> <locais por nível> <atribuições por nível>
+import sys
+
+depth, count, uses = int(sys.argv[1]), int(sys.argv[2]), int(sys.argv[3])
+out = ['program nested;', 'var', '   g : integer;']
+
+
+def procedure(level):
+    indent = '    ' * level
+    out.append('%sprocedure p%d(a%d: integer);' % (indent, level, level))
+    out.append('%svar' % indent)
+    for i in range(0, count, 20):
+        names = ', '.join('v%d' % j for j in range(i, min(i + 20, count)))
+        out.append('%s   %s : integer;' % (indent, names))
+    if level + 1 < depth:
+        procedure(level + 1)
+    out.append('%sbegin' % indent)
+    for i in range(uses):
+        out.append('%s    v%d := v%d + a%d + g;' % (indent, i % count, i * 7 % count, level))
+    out.append('%send' % indent)
+
+
+procedure(0)
+out += ['begin', '    g := 1;', 'end.']
+print('\n'.join(out))
\ No newline at end of file
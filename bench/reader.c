@@ -0,0 +1,180 @@
+// Mede o tempo de ler para a memória os arquivos cujos caminhos chegam pela entrada, um por linha, de três formas:
+// um srReadFile por arquivo, a thread de leitura do SourceReader com preads e a mesma thread com io_uring
+// Um único consumidor pega os arquivos na ordem em que a thread os lê, como um worker do --batch
+// Com `frio`, as páginas de cada arquivo são tiradas do cache antes de cada forma, sem precisar de root
+// Uso: ReaderBench <frio|quente> < lista
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "reader.h"
+
+typedef struct {
+    char    **paths;
+    uint64_t *sizes;
+    uint32_t  size;
+} Corpus;
+
+bool     readCorpus(Corpus *c);
+void     evict(Corpus *c);
+double   now(void);
+uint64_t readOneByOne(Corpus *c);
+uint64_t readAhead(Corpus *c, bool uring);
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 || (strcmp(argv[1], "frio") != 0 && strcmp(argv[1], "quente") != 0)) {
+        fprintf(stderr, "Uso: %s <frio|quente> < lista\n", argv[0]);
+        return 1;
+    }
+
+    bool   cold = strcmp(argv[1], "frio") == 0;
+    Corpus c;
+    if (!readCorpus(&c)) {
+        return 1;
+    }
+
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < c.size; i++) {
+        bytes += c.sizes[i];
+    }
+    printf("%" PRIu32 " arquivos, %.1f MB, cache %s\n", c.size, bytes / 1048576.0, argv[1]);
+
+    const char *names[] = {"um por vez", "thread com preads", "thread com io_uring"};
+    for (int mode = 0; mode < 3; mode++) {
+        if (cold) {
+            evict(&c);
+        } else {
+            readOneByOne(&c);
+        }
+
+        double   start = now();
+        uint64_t read  = mode == 0 ? readOneByOne(&c) : readAhead(&c, mode == 2);
+        double   end   = now();
+
+        if (read != bytes) {
+            printf("%-20s leu %" PRIu64 " de %" PRIu64 " bytes\n", names[mode], read, bytes);
+            return 1;
+        }
+        printf("%-20s %8.3f s\n", names[mode], end - start);
+    }
+
+    return 0;
+}
+
+// Read the paths from the standard input and stat every file
+bool readCorpus(Corpus *c) {
+    uint32_t capacity = 1024;
+    c->paths          = (char **)malloc(sizeof(char *) * capacity);
+    c->sizes          = (uint64_t *)malloc(sizeof(uint64_t) * capacity);
+    c->size           = 0;
+
+    char line[4096];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '\0') {
+            continue;
+        }
+
+        struct stat st;
+        if (stat(line, &st) != 0) {
+            fprintf(stderr, "%s: não foi possível abrir o arquivo\n", line);
+            return false;
+        }
+
+        if (c->size == capacity) {
+            capacity *= 2;
+            c->paths = (char **)realloc(c->paths, sizeof(char *) * capacity);
+            c->sizes = (uint64_t *)realloc(c->sizes, sizeof(uint64_t) * capacity);
+        }
+        c->paths[c->size]   = strdup(line);
+        c->sizes[c->size++] = st.st_size;
+    }
+
+    return true;
+}
+
+// Drop the cached pages of every file, the inodes stay cached
+void evict(Corpus *c) {
+    sync();
+
+    for (uint32_t i = 0; i < c->size; i++) {
+        int fd = open(c->paths[i], O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+// Monotonic time in seconds
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Read every file with srReadFile, one after the other, returns the bytes read
+uint64_t readOneByOne(Corpus *c) {
+    uint64_t read = 0;
+
+    for (uint32_t i = 0; i < c->size; i++) {
+        char *buffer = srReadFile(c->paths[i]);
+        if (buffer) {
+            read += strlen(buffer);
+            free(buffer);
+        }
+    }
+
+    return read;
+}
+
+// Take every file from a SourceReader, with its thread reading through io_uring or preads, returns the bytes read
+uint64_t readAhead(Corpus *c, bool uring) {
+    SourceReader *r     = srNew(c->size, 256);
+    uint32_t     *order = (uint32_t *)malloc(sizeof(uint32_t) * (c->size + 1));
+
+    for (uint32_t i = 0; i < c->size; i++) {
+        r->sources[i].path = c->paths[i];
+        r->sources[i].size = c->sizes[i];
+        order[i]           = i;
+    }
+
+    // srStart always tries io_uring, the preads are the thread's fallback when the ring can't be set up
+    if (uring) {
+        srStart(r, order);
+    } else {
+        r->order   = order;
+        order      = NULL;
+        r->started = pthread_create(&r->thread, NULL, srReadAhead, r) == 0;
+    }
+    free(order);
+
+    if (uring && !r->uring) {
+        printf("io_uring indisponível, a thread usa preads\n");
+    }
+
+    uint64_t read = 0;
+    for (uint32_t i = 0; i < c->size; i++) {
+        char *buffer = srTake(r, i);
+        if (buffer) {
+            read += strlen(buffer);
+            free(buffer);
+        }
+    }
+
+    srFree(r);
+
+    return read;
+}
\ No newline at end of file
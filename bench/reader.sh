@@ -0,0 +1,43 @@
+#!/bin/sh
+# Gera um corpus de arquivos pequenos, 50 mil por padrão, e mede com o ReaderBench o tempo de lê-los com o cache frio
+# e quente, um srReadFile por arquivo e pela thread de leitura com preads e com io_uring, e depois o --batch inteiro
+# O cache frio descarta as páginas de cada arquivo com posix_fadvise, os inodes continuam no cache
+# Uso: bench/reader.sh [arquivos] [ReaderBench] [PascalSyntaxAnalyzer]
+set -e
+
+dir=$(cd "$(dirname "$0")" && pwd)
+count=${1:-50000}
+bench=${2:-$dir/../build/bench/ReaderBench}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Mil arquivos por pasta, cada um com de 1 a 12 procedimentos, de algumas centenas de bytes a alguns KB
+LC_ALL=C awk -v count="$count" -v tmp="$tmp" 'BEGIN {
+    srand(1)
+    for (i = 0; i < count; i++) {
+        if (i % 1000 == 0) {
+            folder = sprintf("%s/d%03d", tmp, i / 1000)
+            system("mkdir " folder)
+        }
+        file = sprintf("%s/f%d.pas", folder, i)
+        printf "program F%d;\nvar\n   a : integer;\n", i > file
+        procedures = 1 + int(rand() * 12)
+        for (j = 0; j < procedures; j++) {
+            printf "procedure p%d(x: integer);\nvar\n   t : integer;\nbegin\n    t := x * %d + 7;\n" \
+                "    while t < 100 do begin t := t + %d; end\nend\n", j, i, j + 1 > file
+        }
+        printf "begin\n    a := 0;\nend.\n" > file
+        close(file)
+        print file > (tmp "/lista")
+    }
+}'
+
+"$bench" frio < "$tmp/lista"
+"$bench" quente < "$tmp/lista"
+
+# O lote inteiro, com os .ast escritos ao lado das entradas, o xargs o divide se a lista não couber
+start=$(date +%s.%N)
+xargs "$psa" --batch -j "$(nproc)" < "$tmp/lista" > /dev/null
+end=$(date +%s.%N)
+echo "$start $end" | awk '{ printf "--batch -j %d, cache quente: %.3f s\n", '"$(nproc)"', $2 - $1 }'
\ No newline at end of file
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Compara o tempo de cada programa da pasta com --interp, na máquina virtual, com --jit, compilado com
+# --emit-asm e traduzido com --emit-c para o gcc com -O0 e -O2
+# Uso: bench/run.sh [PascalSyntaxAnalyzer]
+set -e
+
+dir=$(cd "$(dirname "$0")" && pwd)
+psa=${1:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Melhor de três execuções, em segundos
+best() {
+    best=
+    for _ in 1 2 3; do
+        start=$(date +%s.%N)
+        "$@" > /dev/null 2>&1
+        end=$(date +%s.%N)
+        best=$(echo "$start $end $best" | awk '{ t = $2 - $1; if ($3 != "" && $3 < t) t = $3; printf "%.3f", t }')
+    done
+    echo "$best"
+}
+
+printf '%-10s %8s %8s %8s %8s %8s %8s\n' programa interp vm jit nativo gcc-O0 gcc-O2
+for pas in "$dir"/*.pas; do
+    name=$(basename "$pas" .pas)
+    "$psa" --emit-asm "$pas" "$tmp/$name.s" > /dev/null
+    "$psa" --emit-c "$pas" "$tmp/$name.c" > /dev/null
+    cc -o "$tmp/$name-asm" "$tmp/$name.s"
+    gcc -std=c99 -O0 -o "$tmp/$name-O0" "$tmp/$name.c"
+    gcc -std=c99 -O2 -o "$tmp/$name-O2" "$tmp/$name.c"
+
+    printf '%-10s %8s %8s %8s %8s %8s %8s\n' "$name" "$(best "$psa" --interp "$pas")" "$(best "$psa" --run "$pas")" \
+        "$(best "$psa" --jit "$pas")" "$(best "$tmp/$name-asm")" "$(best "$tmp/$name-O0")" "$(best "$tmp/$name-O2")"
+done
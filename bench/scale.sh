@@ -0,0 +1,74 @@
+#!/bin/sh
+# Gera programas de 1 MB até o tamanho máximo, dobrando a cada passo, e mede o tempo com --check, no uso arquivo e
+# com --pipeline, que escreve a mesma saída com o léxico em uma thread própria.
+# O tempo por MB deve ficar estável se a análise for linear. Depois de medir, acrescenta um token após o `end.`
+# final e confere se o erro aponta a última linha do arquivo.
+# Uso: bench/scale.sh [máximo em MB, padrão 4096] [PascalSyntaxAnalyzer]
+set -e
+
+dir=$(cd "$(dirname "$0")" && pwd)
+max=${1:-4096}
+psa=${2:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Escreve em $2 um programa válido com pelo menos $1 MB, repetindo procedimentos até atingir o tamanho
+generate() {
+    LC_ALL=C awk -v size="$1" 'BEGIN {
+        limit = size * 1048576
+        text = "program Scale;\nvar\n   a : integer;\n   s : real;\n"
+        printf "%s", text
+        bytes = length(text)
+        for (i = 0; bytes < limit; i++) {
+            text = sprintf("procedure p%d(x: integer; var y: real);\nvar\n   t, u : integer;\nbegin\n" \
+                "    t := x * %d + 7;\n    if t > 10 then u := t mod 7; else begin u := -t; end\n" \
+                "    while u < 100 do begin u := u + t; y := y + 0.5; end\nend\n", i, i)
+            printf "%s", text
+            bytes += length(text)
+        }
+        printf "begin\n    a := 0;\nend.\n"
+    }' > "$2"
+}
+
+# Tempo de uma execução, em segundos, ou - se o comando falhar
+elapsed() {
+    start=$(date +%s.%N)
+    if "$@" > /dev/null 2>&1; then
+        end=$(date +%s.%N)
+        echo "$start $end" | awk '{ printf "%.3f", $2 - $1 }'
+    else
+        echo -
+    fi
+}
+
+# Segundos por MB, ou - se não houver tempo
+perMb() {
+    echo "$1 $2" | awk '{ if ($1 == "-") print "-"; else printf "%.4f", $1 / $2 }'
+}
+
+printf '%8s %12s %8s %8s %8s %8s %8s %8s %8s\n' MB linhas check s/MB arquivo s/MB pipeline s/MB linha
+size=1
+while [ "$size" -le "$max" ]; do
+    pas=$tmp/scale.pas
+    generate "$size" "$pas"
+    lines=$(wc -l < "$pas")
+    check=$(elapsed "$psa" --check "$pas")
+    file=$(elapsed "$psa" "$pas" "$tmp/scale.out")
+    rm -f "$tmp/scale.out"
+    pipeline=$(elapsed "$psa" --pipeline "$pas" "$tmp/scale.out")
+    rm -f "$tmp/scale.out"
+
+    # O token extra fica na linha seguinte à última, e o erro deve apontar essa linha
+    echo x >> "$pas"
+    line=$("$psa" --check "$pas" 2>&1 | sed -n 's/.*Linha \([0-9]*\):.*/\1/p' | head -n 1)
+    if [ "$line" = "$((lines + 1))" ]; then
+        status=ok
+    else
+        status="erro: linha ${line:-?}, esperada $((lines + 1))"
+    fi
+    rm -f "$pas"
+
+    printf '%8s %12s %8s %8s %8s %8s %8s %8s %8s\n' "$size" "$lines" "$check" "$(perMb "$check" "$size")" "$file" \
+        "$(perMb "$file" "$size")" "$pipeline" "$(perMb "$pipeline" "$size")" "$status"
+    size=$((size * 2))
+done
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Mede o tempo de analisar cada arquivo e o de resolver os nomes da árvore com a tabela de símbolos, o melhor de sete
+// execuções de cada, e conta os símbolos declarados e os usos resolvidos
+// Uso: SymbolsBench <entrada>...
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "symbols.h"
+
+double now(void);
+bool   measure(char *file);
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!measure(argv[i])) {
+            failed++;
+        }
+    }
+
+    return failed > 0;
+}
+
+// Monotonic time in milliseconds
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+// Time parsing and resolving a file and print the best of seven runs of each
+bool measure(char *file) {
+    double   parse   = 0;
+    double   resolve = 0;
+    uint32_t symbols = 0;
+    uint64_t uses    = 0;
+
+    for (int run = 0; run < 7; run++) {
+        char *input = srReadFile(file);
+        if (!input) {
+            printf("%s: não foi possível abrir o arquivo\n", file);
+            return false;
+        }
+
+        Lexer  *l = lNew(input);
+        Parser *p = pNew(l);
+
+        double      start   = now();
+        astProgram *program = pParseProgram(p);
+        double      parsed  = now();
+        if (p->errors->size > 0) {
+            printf("%s: %s\n", file, p->errors->data[0]);
+            return false;
+        }
+
+        SymbolTable *t = syNew();
+        syResolve(t, program);
+        double resolved = now();
+        if (t->errors->size > 0) {
+            printf("%s: %s\n", file, t->errors->data[0]);
+            return false;
+        }
+
+        if (run == 0 || parsed - start < parse) {
+            parse = parsed - start;
+        }
+        if (run == 0 || resolved - parsed < resolve) {
+            resolve = resolved - parsed;
+        }
+        symbols = t->size - 1;
+        uses    = t->uses;
+
+        syFree(t);
+        astProgramFree(program);
+        lFree(l);
+        pFree(p);
+    }
+
+    printf("%-24s %10.2f %10.2f %10" PRIu32 " %10" PRIu64 "\n", file, parse, resolve, symbols, uses);
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Mede a tabela de símbolos com o SymbolsBench em programas de nested.py: muitos níveis com muitas locais, muitos
+# níveis rasos e poucos níveis com dezenas de milhares de locais
+# O tempo de resolver deve acompanhar o número de usos e não a profundidade nem o tamanho da tabela
+# Uso: bench/symbols.sh [SymbolsBench]
+set -e
+
+dir=$(cd "$(dirname "$0")" && pwd)
+bench=${1:-$dir/../build/bench/SymbolsBench}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+python3 "$dir/nested.py" 50 2000 200 > "$tmp/50x2000.pas"
+python3 "$dir/nested.py" 200 100 20 > "$tmp/200x100.pas"
+python3 "$dir/nested.py" 2 50000 100000 > "$tmp/2x50000.pas"
+
+# Os arquivos aparecem sem a pasta temporária
+bench=$(cd "$(dirname "$bench")" && pwd)/$(basename "$bench")
+cd "$tmp"
+
+printf '%-24s %11s %10s %11s %10s\n' arquivo 'análise ms' 'nomes ms' símbolos usos
+"$bench" 50x2000.pas 200x100.pas 2x50000.pas
\ No newline at end of file
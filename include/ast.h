@@ -1,35 +1,46 @@
 #ifndef AST_H
 #define AST_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "token.h"
 
-void astAppendToString(char** buffer, char* str);
+// Growable string, keeps its length so appending doesn't rescan it
+typedef struct {
+    char*  data;      // Null-terminated string, owned by whoever takes it
+    size_t length;    // String length
+    size_t capacity;  // Allocated bytes
+} astString;
+
+void  astAppendToString(astString* buffer, char* str);
+void* astGrowArray(void* array, uint32_t size, uint32_t* capacity, size_t elementSize);
 
 //
 // Generic AST nodes (pseudo OOP interfaces/abstract)
 //
 
-// Base AST node
+// Base AST node, `toString` gets the nesting level of the node, which sets the indentation of its nested lines
 typedef struct astNode {
     Token* token;
     void (*free)(struct astNode*);
-    char* (*toString)(struct astNode*);
+    char* (*toString)(struct astNode*, uint32_t);
 } astNode;
 
 // Statements
 typedef struct astStatement {
     Token* token;
     void (*free)(struct astStatement*);
-    char* (*toString)(struct astStatement*);
+    char* (*toString)(struct astStatement*, uint32_t);
 } astStatement;
 
 // Expressions
 typedef struct astExpression {
     Token* token;
     void (*free)(struct astExpression*);
-    char* (*toString)(struct astExpression*);
+    char* (*toString)(struct astExpression*, uint32_t);
+    uint32_t type;  // Type id cached by the type checker, 0 until checked, every expression node has it here
 } astExpression;
 
 //
@@ -78,139 +89,158 @@ astProgram* astProgramNew(Token* token);
 void        astProgramFree(astProgram* p);
 char*       astProgramToString(astProgram* p);
 
+char* astNestedToString(astStatement* s, uint32_t level);
+
+// Streaming text output, receives the top-level statements from the parser statement sink
+typedef struct {
+    FILE* file;     // Output file
+    bool  started;  // Program header already written
+} astTextSink;
+
+astTextSink* astTextSinkNew(FILE* file);
+void         astTextSinkFree(astTextSink* sink);
+void         astTextSinkStatement(void* ctx, astProgram* p, astStatement* s);
+void         astTextSinkEnd(astTextSink* sink);
+
 // Block statement, e.g. `begin <statements> end`
 struct astBlockStmt {
-    Token* token;                      // Not used
-    void (*free)(astBlockStmt*);       // Destructor
-    char* (*toString)(astBlockStmt*);  // String representation (for debugging)
+    Token* token;                                // Not used
+    void (*free)(astBlockStmt*);                 // Destructor
+    char* (*toString)(astBlockStmt*, uint32_t);  // String representation (for debugging)
 
-    astStatement** statements;         // Series of statements
-    uint32_t       size;               // Number of statements
+    astStatement** statements;                   // Series of statements
+    uint32_t       size;                         // Number of statements
+    uint32_t       capacity;                     // Allocated slots
 };
 
 astBlockStmt* astBlockStmtNew(Token* token);
 void          astBlockStmtFree(astBlockStmt* b);
-char*         astBlockStmtToString(astBlockStmt* b);
+char*         astBlockStmtToString(astBlockStmt* b, uint32_t level);
 
 // Variable declaration block, e.g. `var x: integer; y: real;`
 struct astVarStmt {
-    Token* token;                       // token::VAR
-    void (*free)(astVarStmt*);          // Destructor
-    char* (*toString)(astVarStmt*);     // String representation (for debugging)
+    Token* token;                              // token::VAR
+    void (*free)(astVarStmt*);                 // Destructor
+    char* (*toString)(astVarStmt*, uint32_t);  // String representation (for debugging)
 
-    astDeclarationStmt** declarations;  // Series of declaration statements
-    uint16_t             size;          // Number of declaration statements
+    astDeclarationStmt** declarations;         // Series of declaration statements
+    uint32_t             size;                 // Number of declaration statements
+    uint32_t             capacity;             // Allocated slots
 };
 
 astVarStmt* astVarStmtNew(Token* token);
 void        astVarStmtFree(astVarStmt* v);
-char*       astVarStmtToString(astVarStmt* v);
+char*       astVarStmtToString(astVarStmt* v, uint32_t level);
 
 // Variable declaration statement, e.g. `x, y: integer`
 struct astDeclarationStmt {
-    Token* token;                            // token::IDENT
-    void (*free)(astDeclarationStmt*);       // Destructor
-    char* (*toString)(astDeclarationStmt*);  // String representation (for debugging)
-
-    astIdentifierExpr** identifier;          // Series of identifiers
-    uint16_t            size;                // Number of identifiers
-    astTypeExpr*        type;                // Variable(s) type
+    Token* token;                                      // token::IDENT, reference to the first identifier token
+    void (*free)(astDeclarationStmt*);                 // Destructor
+    char* (*toString)(astDeclarationStmt*, uint32_t);  // String representation (for debugging)
+
+    astIdentifierExpr** identifier;                    // Series of identifiers
+    uint32_t            size;                          // Number of identifiers
+    uint32_t            capacity;                      // Allocated slots
+    astTypeExpr*        type;                          // Variable(s) type
 };
 
 astDeclarationStmt* astDeclarationStmtNew(Token* token);
 void                astDeclarationStmtFree(astDeclarationStmt* d);
-char*               astDeclarationStmtToString(astDeclarationStmt* d);
+char*               astDeclarationStmtToString(astDeclarationStmt* d, uint32_t level);
 
 /*
 Function statement, e.g. `function myFunction(x: integer): real; begin end`
 Also a procedure statement when `returnType` is `NULL`
 */
 struct astFunctionStmt {
-    Token* token;                         // token::FUNCTION
-    void (*free)(astFunctionStmt*);       // Destructor
-    char* (*toString)(astFunctionStmt*);  // String representation (for debugging)
-
-    astIdentifierExpr* identifier;        // Function name
-    astParameterStmt** parameters;        // Function parameters
-    uint16_t           size;              // Number of parameters
-    astTypeExpr*       returnType;        // Function return type
-    astBlockStmt*      block;             // Block statement
+    Token* token;                                   // token::FUNCTION
+    void (*free)(astFunctionStmt*);                 // Destructor
+    char* (*toString)(astFunctionStmt*, uint32_t);  // String representation (for debugging)
+
+    astIdentifierExpr* identifier;                  // Function name
+    astParameterStmt** parameters;                  // Function parameters
+    uint32_t           size;                        // Number of parameters
+    uint32_t           capacity;                    // Allocated slots
+    astTypeExpr*       returnType;                  // Function return type
+    astBlockStmt*      block;                       // Block statement
 };
 
 astFunctionStmt* astFunctionStmtNew(Token* token);
 void             astFunctionStmtFree(astFunctionStmt* f);
-char*            astFunctionStmtToString(astFunctionStmt* f);
+char*            astFunctionStmtToString(astFunctionStmt* f, uint32_t level);
 
 // Function parameter statement, e.g. `x, y: integer` or `var x, y: integer`
 struct astParameterStmt {
-    Token* token;                          // token::IDENT or token::VAR
-    void (*free)(astParameterStmt*);       // Destructor
-    char* (*toString)(astParameterStmt*);  // String representation (for debugging)
-
-    astDeclarationStmt** declarations;     // Series of declaration statements
-    uint16_t             size;             // Number of declaration statements
-    bool                 isVar;            // Is a reference parameter
+    Token* token;                                    // Not used
+    void (*free)(astParameterStmt*);                 // Destructor
+    char* (*toString)(astParameterStmt*, uint32_t);  // String representation (for debugging)
+
+    astDeclarationStmt** declarations;               // Series of declaration statements
+    uint32_t             size;                       // Number of declaration statements
+    uint32_t             capacity;                   // Allocated slots
+    bool                 isVar;                      // Is a reference parameter
 };
 
 astParameterStmt* astParameterStmtNew(Token* token);
 void              astParameterStmtFree(astParameterStmt* p);
-char*             astParameterStmtToString(astParameterStmt* p);
+char*             astParameterStmtToString(astParameterStmt* p, uint32_t level);
 
 // Begin-end statement, e.g. `begin <statements> end`
 struct astBeginEndStmt {
-    Token* token;                         // token::BEGIN
-    void (*free)(astBeginEndStmt*);       // Destructor
-    char* (*toString)(astBeginEndStmt*);  // String representation (for debugging)
+    Token* token;                                   // token::BEGIN
+    void (*free)(astBeginEndStmt*);                 // Destructor
+    char* (*toString)(astBeginEndStmt*, uint32_t);  // String representation (for debugging)
 
-    astExpressionStmt** statements;       // Series of expressions
-    uint32_t            size;             // Number of expressions
+    astExpressionStmt** statements;                 // Series of expressions
+    uint32_t            size;                       // Number of expressions
+    uint32_t            capacity;                   // Allocated slots
 };
 
 astBeginEndStmt* astBeginEndStmtNew(Token* token);
 void             astBeginEndStmtFree(astBeginEndStmt* b);
-char*            astBeginEndStmtToString(astBeginEndStmt* b);
+char*            astBeginEndStmtToString(astBeginEndStmt* b, uint32_t level);
 
 // Conditional statement, e.g. `if <condition> then <consequence> else <alternative>`
 struct astConditionalStmt {
-    Token* token;                            // token::IF
-    void (*free)(astConditionalStmt*);       // Destructor
-    char* (*toString)(astConditionalStmt*);  // String representation (for debugging)
+    Token* token;                                      // token::IF
+    void (*free)(astConditionalStmt*);                 // Destructor
+    char* (*toString)(astConditionalStmt*, uint32_t);  // String representation (for debugging)
 
-    astExpression* condition;                // Condition
-    astStatement*  consequence;              // Consequence
-    astStatement*  alternative;              // Alternative
+    astExpression* condition;                          // Condition
+    astStatement*  consequence;                        // Consequence
+    astStatement*  alternative;                        // Alternative
 };
 
 astConditionalStmt* astConditionalStmtNew(Token* token);
 void                astConditionalStmtFree(astConditionalStmt* c);
-char*               astConditionalStmtToString(astConditionalStmt* c);
+char*               astConditionalStmtToString(astConditionalStmt* c, uint32_t level);
 
 // While statement, e.g. `while <condition> do <body>`
 struct astWhileStmt {
-    Token* token;                      // token::WHILE
-    void (*free)(astWhileStmt*);       // Destructor
-    char* (*toString)(astWhileStmt*);  // String representation (for debugging)
+    Token* token;                                // token::WHILE
+    void (*free)(astWhileStmt*);                 // Destructor
+    char* (*toString)(astWhileStmt*, uint32_t);  // String representation (for debugging)
 
-    astExpression* condition;          // Condition
-    astStatement*  body;               // Body
+    astExpression* condition;                    // Condition
+    astStatement*  body;                         // Body
 };
 
 astWhileStmt* astWhileStmtNew(Token* token);
 void          astWhileStmtFree(astWhileStmt* w);
-char*         astWhileStmtToString(astWhileStmt* w);
+char*         astWhileStmtToString(astWhileStmt* w, uint32_t level);
 
 // Expression statement, e.g. `5 + 5`
 struct astExpressionStmt {
-    Token* token;                           // First token of the expression
-    void (*free)(astExpressionStmt*);       // Destructor
-    char* (*toString)(astExpressionStmt*);  // String representation (for debugging)
+    Token* token;                                     // First token of the expression, not owned
+    void (*free)(astExpressionStmt*);                 // Destructor
+    char* (*toString)(astExpressionStmt*, uint32_t);  // String representation (for debugging)
 
-    astExpression* expr;                    // Expression
+    astExpression* expr;                              // Expression
 };
 
 astExpressionStmt* astExpressionStmtNew(Token* token);
 void               astExpressionStmtFree(astExpressionStmt* e);
-char*              astExpressionStmtToString(astExpressionStmt* e);
+char*              astExpressionStmtToString(astExpressionStmt* e, uint32_t level);
 
 //
 // Expressions
@@ -218,150 +248,163 @@ char*              astExpressionStmtToString(astExpressionStmt* e);
 
 // Prefix expression, e.g. `-5`
 struct astPrefixExpr {
-    Token* token;                       // Operator token, e.g. token::MINUS
-    void (*free)(astPrefixExpr*);       // Destructor
-    char* (*toString)(astPrefixExpr*);  // String representation (for debugging)
+    Token* token;                                 // Operator token, e.g. token::MINUS
+    void (*free)(astPrefixExpr*);                 // Destructor
+    char* (*toString)(astPrefixExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                // Type id cached by the type checker, 0 until checked
 
-    char*          op;                  // Operator
-    astExpression* right;               // Right-hand side expression
+    char*          op;                            // Operator
+    astExpression* right;                         // Right-hand side expression
 };
 
 astPrefixExpr* astPrefixExprNew(Token* token);
 void           astPrefixExprFree(astPrefixExpr* p);
-char*          astPrefixExprToString(astPrefixExpr* p);
+char*          astPrefixExprToString(astPrefixExpr* p, uint32_t level);
 
 // Infix expression, e.g. `5 + 5`
 struct astInfixExpr {
-    Token* token;                      // Operator token, e.g. token::PLUS
-    void (*free)(astInfixExpr*);       // Destructor
-    char* (*toString)(astInfixExpr*);  // String representation (for debugging)
-
-    char*          op;                 // Operator
-    astExpression* left;               // Left-hand side expression
-    astExpression* right;              // Right-hand side expression
+    Token* token;                                // Operator token, e.g. token::PLUS
+    void (*free)(astInfixExpr*);                 // Destructor
+    char* (*toString)(astInfixExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                               // Type id cached by the type checker, 0 until checked
+
+    char*          op;                           // Operator
+    astExpression* left;                         // Left-hand side expression
+    astExpression* right;                        // Right-hand side expression
 };
 
 astInfixExpr* astInfixExprNew(Token* token);
 void          astInfixExprFree(astInfixExpr* i);
-char*         astInfixExprToString(astInfixExpr* i);
+char*         astInfixExprToString(astInfixExpr* i, uint32_t level);
 
 // Assignment expression, e.g. `x := 5`
 struct astAssignmentExpr {
-    Token* token;                           // token::ASSIGN
-    void (*free)(astAssignmentExpr*);       // Destructor
-    char* (*toString)(astAssignmentExpr*);  // String representation (for debugging)
+    Token* token;                                     // token::ASSIGN
+    void (*free)(astAssignmentExpr*);                 // Destructor
+    char* (*toString)(astAssignmentExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                    // Type id cached by the type checker, 0 until checked
 
-    astIdentifierExpr* identifier;          // Identifier
-    astExpression*     value;               // Value
+    astIdentifierExpr* identifier;                    // Identifier
+    astExpression*     value;                         // Value
 };
 
 astAssignmentExpr* astAssignmentExprNew(Token* token);
 void               astAssignmentExprFree(astAssignmentExpr* a);
-char*              astAssignmentExprToString(astAssignmentExpr* a);
+char*              astAssignmentExprToString(astAssignmentExpr* a, uint32_t level);
 
 // Identifier expression, e.g. `foo`
 struct astIdentifierExpr {
-    Token* token;                           // token::IDENT
-    void (*free)(astIdentifierExpr*);       // Destructor
-    char* (*toString)(astIdentifierExpr*);  // String representation (for debugging)
+    Token* token;                                     // token::IDENT
+    void (*free)(astIdentifierExpr*);                 // Destructor
+    char* (*toString)(astIdentifierExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                    // Type id cached by the type checker, 0 until checked
 
-    char* value;                            // Identifier name
+    char*    value;                                   // Identifier name
+    uint32_t symbol;                                  // Symbol bound by the symbol table, 0 until resolved
 };
 
 astIdentifierExpr* astIdentifierExprNew(Token* token);
 void               astIdentifierExprFree(astIdentifierExpr* i);
-char*              astIdentifierExprToString(astIdentifierExpr* i);
+char*              astIdentifierExprToString(astIdentifierExpr* i, uint32_t level);
 
 // Integer literal expression, e.g. `5`
 struct astIntegerExpr {
-    Token* token;                        // token::INT
-    void (*free)(astIntegerExpr*);       // Destructor
-    char* (*toString)(astIntegerExpr*);  // String representation (for debugging)
+    Token* token;                                  // token::INT
+    void (*free)(astIntegerExpr*);                 // Destructor
+    char* (*toString)(astIntegerExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                 // Type id cached by the type checker, 0 until checked
 
-    int64_t value;                       // Integer value
+    int64_t value;                                 // Integer value
 };
 
 astIntegerExpr* astIntegerExprNew(Token* token);
 void            astIntegerExprFree(astIntegerExpr* i);
-char*           astIntegerExprToString(astIntegerExpr* i);
+char*           astIntegerExprToString(astIntegerExpr* i, uint32_t level);
 
 // Float literal expression, e.g. `5.0`
 struct astFloatExpr {
-    Token* token;                      // token::FLOAT
-    void (*free)(astFloatExpr*);       // Destructor
-    char* (*toString)(astFloatExpr*);  // String representation (for debugging)
+    Token* token;                                // token::FLOAT
+    void (*free)(astFloatExpr*);                 // Destructor
+    char* (*toString)(astFloatExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                               // Type id cached by the type checker, 0 until checked
 
-    double value;                      // Float value
+    double value;                                // Float value
 };
 
 astFloatExpr* astFloatExprNew(Token* token);
 void          astFloatExprFree(astFloatExpr* f);
-char*         astFloatExprToString(astFloatExpr* f);
+char*         astFloatExprToString(astFloatExpr* f, uint32_t level);
 
 // Boolean literal expression, e.g. `true` or `false`
 struct astBooleanExpr {
-    Token* token;                        // token::TRUE or token::FALSE
-    void (*free)(astBooleanExpr*);       // Destructor
-    char* (*toString)(astBooleanExpr*);  // String representation (for debugging)
+    Token* token;                                  // token::TRUE or token::FALSE
+    void (*free)(astBooleanExpr*);                 // Destructor
+    char* (*toString)(astBooleanExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                 // Type id cached by the type checker, 0 until checked
 
-    bool value;                          // Boolean value
+    bool value;                                    // Boolean value
 };
 
 astBooleanExpr* astBooleanExprNew(Token* token);
 void            astBooleanExprFree(astBooleanExpr* b);
-char*           astBooleanExprToString(astBooleanExpr* b);
+char*           astBooleanExprToString(astBooleanExpr* b, uint32_t level);
 
 // String literal expression, e.g. `"hello"`
 struct astStringExpr {
-    Token* token;                       // token::STRING
-    void (*free)(astStringExpr*);       // Destructor
-    char* (*toString)(astStringExpr*);  // String representation (for debugging)
+    Token* token;                                 // token::STRING
+    void (*free)(astStringExpr*);                 // Destructor
+    char* (*toString)(astStringExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                                // Type id cached by the type checker, 0 until checked
 
-    char* value;                        // String value
+    char* value;                                  // String value
 };
 
 astStringExpr* astStringExprNew(Token* token);
 void           astStringExprFree(astStringExpr* s);
-char*          astStringExprToString(astStringExpr* s);
+char*          astStringExprToString(astStringExpr* s, uint32_t level);
 
 // Character literal expression, e.g. `'a'`
 struct astCharExpr {
-    Token* token;                     // token::CHAR
-    void (*free)(astCharExpr*);       // Destructor
-    char* (*toString)(astCharExpr*);  // String representation (for debugging)
+    Token* token;                               // token::CHAR
+    void (*free)(astCharExpr*);                 // Destructor
+    char* (*toString)(astCharExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                              // Type id cached by the type checker, 0 until checked
 
-    char value;                       // Character value
+    char value;                                 // Character value
 };
 
 astCharExpr* astCharExprNew(Token* token);
 void         astCharExprFree(astCharExpr* c);
-char*        astCharExprToString(astCharExpr* c);
+char*        astCharExprToString(astCharExpr* c, uint32_t level);
 
 // Type expression, e.g. `integer`
 struct astTypeExpr {
-    Token* token;                     // token::INTEGER, token::REAL, token::BOOLEAN, token::CHARACTER, token::STRING
-    void (*free)(astTypeExpr*);       // Destructor
-    char* (*toString)(astTypeExpr*);  // String representation (for debugging)
+    Token* token;                               // token::INTEGER, token::REAL, token::BOOLEAN, token::CHARACTER, token::STRING
+    void (*free)(astTypeExpr*);                 // Destructor
+    char* (*toString)(astTypeExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                              // Type id cached by the type checker, 0 until checked
 
-    char* value;                      // Type name
+    char* value;                                // Type name
 };
 
 astTypeExpr* astTypeExprNew(Token* token);
 void         astTypeExprFree(astTypeExpr* t);
-char*        astTypeExprToString(astTypeExpr* t);
+char*        astTypeExprToString(astTypeExpr* t, uint32_t level);
 
 struct astCallExpr {
-    Token* token;                     // token::IDENT
-    void (*free)(astCallExpr*);       // Destructor
-    char* (*toString)(astCallExpr*);  // String representation (for debugging)
-
-    astIdentifierExpr* identifier;    // Function name
-    astExpression**    arguments;     // Function arguments
-    uint16_t           size;          // Number of arguments
+    Token* token;                               // token::IDENT
+    void (*free)(astCallExpr*);                 // Destructor
+    char* (*toString)(astCallExpr*, uint32_t);  // String representation (for debugging)
+    uint32_t type;                              // Type id cached by the type checker, 0 until checked
+
+    astIdentifierExpr* identifier;              // Function name
+    astExpression**    arguments;               // Function arguments
+    uint32_t           size;                    // Number of arguments
+    uint32_t           capacity;                // Allocated slots
 };
 
 astCallExpr* astCallExprNew(Token* token);
 void         astCallExprFree(astCallExpr* c);
-char*        astCallExprToString(astCallExpr* c);
+char*        astCallExprToString(astCallExpr* c, uint32_t level);
 
 #endif  // AST_H
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "error.h"
+#include "hashmap.h"
+#include "parser.h"
+#include "reader.h"
+
+// A file of the batch, its AST is written to `<input>.ast`
+typedef struct {
+    char       *input;   // Input file name
+    uint64_t    size;    // Input size in bytes, used for scheduling
+    eErrorList *errors;  // Diagnostics, set once the file is parsed
+} BatchFile;
+
+// Work-stealing deque of file indexes, the owner pops from the bottom and thieves steal from the top
+typedef struct {
+    uint32_t       *tasks;
+    uint32_t        top;     // First task left
+    uint32_t        bottom;  // One past the last task left
+    pthread_mutex_t lock;
+} BatchDeque;
+
+/*
+Parses many files concurrently, one task per file.
+Every worker starts with its own deque and steals from the others once it runs dry,
+so a large file only keeps its own worker busy.
+The keyword and dispatch tables are built once and only read by the workers.
+*/
+typedef struct {
+    BatchFile *files;     // Files in the order they were given, diagnostics are reported in this order
+    uint32_t   size;      // Number of files
+    uint32_t   capacity;  // Allocated slots
+
+    BatchDeque   *deques;   // One deque per worker
+    uint32_t      workers;  // Number of workers
+    SourceReader *reader;   // Reads the files ahead of the workers
+
+    HashMap *keywords;  // Shared keyword table
+    Parser  *tables;    // Shared parser dispatch tables
+} Batch;
+
+// Worker thread argument
+typedef struct {
+    Batch   *b;
+    uint32_t id;
+} BatchWorker;
+
+Batch *bNew();
+void   bFree(Batch *b);
+
+bool bAddInput(Batch *b, char *input);
+void bAddFile(Batch *b, char *input, uint64_t size);
+void bAddDirectory(Batch *b, char *dir);
+int  bCompareNames(const void *a, const void *b);
+
+void  bRun(Batch *b, uint32_t workers);
+int   bCompareSizes(const void *a, const void *b);
+void *bWork(void *arg);
+bool  bNextTask(Batch *b, uint32_t id, uint32_t *task);
+void  bParseFile(Batch *b, BatchFile *f);
+
+uint32_t bReport(Batch *b);
+
+#endif  // BATCH_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PB_CLOCK_INTERVAL 1024  // Tokens scanned between two reads of the clock and the cancel flag, a power of two
+
+// Limits of a parse, a zero limit is no limit
+typedef struct {
+    uint64_t     maxTokens;    // Tokens scanned, the end of the input isn't counted
+    uint32_t     maxDepth;     // Nesting of blocks, statements and expressions
+    uint64_t     maxAstBytes;  // Bytes of the tokens handed to the tree, literals included
+    uint32_t     maxErrors;    // Diagnostics before the parse stops
+    uint64_t     deadline;     // Wall-clock deadline in pbNow nanoseconds, shared by every budget made with these options
+    atomic_bool *cancel;       // Set by any thread to stop the parse, NULL if it can't be cancelled
+} ParseOptions;
+
+// Why a parse stopped early
+typedef enum {
+    PB_OK = 0,     // Within budget
+    PB_TOKENS,     // Too many tokens
+    PB_DEPTH,      // Nested too deep
+    PB_AST_BYTES,  // Tree too large
+    PB_ERRORS,     // Too many diagnostics
+    PB_DEADLINE,   // Out of time
+    PB_CANCELLED,  // Cancelled by another thread
+} pbStatus;
+
+/*
+Budget of a single check or parse, shared by its lexer and its checker or parser.
+Once any limit is hit the lexer only scans the end of the input, so every loop of the parser winds down at its next token.
+The diagnostics that follow are artifacts of the cut input, they're replaced by a single one that says why the parse stopped.
+*/
+typedef struct {
+    ParseOptions options;
+
+    uint64_t tokens;    // Tokens scanned
+    uint64_t astBytes;  // Bytes of tokens allocated
+    uint32_t depth;     // Current nesting
+    pbStatus status;    // First limit hit
+    bool     reported;  // The diagnostic of `status` was added
+} ParseBudget;
+
+ParseBudget *pbNew(ParseOptions *options);
+void         pbFree(ParseBudget *b);
+
+bool pbTick(ParseBudget *b);
+bool pbAllocate(ParseBudget *b, uint64_t bytes);
+bool pbEnter(ParseBudget *b);
+void pbLeave(ParseBudget *b);
+bool pbErrors(ParseBudget *b, uint32_t errors);
+void pbStop(ParseBudget *b, pbStatus status);
+bool pbReport(ParseBudget *b, char *buffer, uint32_t size, uint64_t line);
+
+char    *pbMessage(pbStatus status);
+uint64_t pbNow(void);
+
+#endif  // BUDGET_H
\ No newline at end of file
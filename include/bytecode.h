@@ -0,0 +1,197 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "error.h"
+#include "token.h"
+#include "types.h"
+
+#define BC_ANY           UINT32_MAX   // Destination of an expression that may end in any register
+#define BC_MAX_REGISTERS 65535        // Registers of a frame, the width of the `a` and `b` operands
+#define BC_MAX_FUNCTIONS 65535        // Functions of a program, the width of the `b` operand of CALL
+#define BC_MAX_C         0xFFFFFF     // Largest unsigned `c` operand, jump targets and constant indices
+#define BC_MIN_IMMEDIATE (-0x800000)  // Smallest signed `c` operand
+#define BC_MAX_IMMEDIATE 0x7FFFFF     // Largest signed `c` operand
+
+/*
+Opcodes, `a` is the destination register unless noted, `b` and `c` the operands.
+Integers, booleans and chars share the integer instructions, booleans are 0 or 1.
+The J*I and J*IK instructions are compare-and-branch superinstructions, they jump to `c` when the comparison holds.
+*/
+typedef enum {
+    BC_HALT = 0,  // End of the program
+    BC_MOVE,      // a = b
+    BC_LOADI,     // a = signed c
+    BC_LOADK,     // a = constant c
+    BC_GETG,      // a = global c
+    BC_SETG,      // global c = a
+    BC_GETUP,     // a = register c of the frame b static links up
+    BC_SETUP,     // register c of the frame b static links up = a
+    BC_ADDR,      // a = address of register b
+    BC_ADDRG,     // a = address of global c
+    BC_ADDRUP,    // a = address of register c of the frame b static links up
+    BC_LOADREF,   // a = variable b points to
+    BC_STOREREF,  // variable a points to = b
+
+    BC_ADDI,   // a = b + c
+    BC_SUBI,   // a = b - c
+    BC_MULI,   // a = b * c
+    BC_DIVI,   // a = b div c
+    BC_MODI,   // a = b mod c
+    BC_ADDIK,  // a = b + signed c
+    BC_SUBIK,  // a = b - signed c
+    BC_NEGI,   // a = -b
+
+    BC_ADDF,  // a = b + c
+    BC_SUBF,  // a = b - c
+    BC_MULF,  // a = b * c
+    BC_DIVF,  // a = b / c
+    BC_NEGF,  // a = -b
+    BC_I2F,   // a = real of integer b
+
+    BC_EQI,  // a = b = c
+    BC_NEI,  // a = b <> c
+    BC_LTI,  // a = b < c
+    BC_LEI,  // a = b <= c
+    BC_EQF,  // a = b = c
+    BC_NEF,  // a = b <> c
+    BC_LTF,  // a = b < c
+    BC_LEF,  // a = b <= c
+    BC_EQS,  // a = b = c
+    BC_NES,  // a = b <> c
+    BC_LTS,  // a = b < c
+    BC_LES,  // a = b <= c
+
+    BC_NOT,     // a = not b
+    BC_AND,     // a = b and c
+    BC_OR,      // a = b or c
+    BC_CONCAT,  // a = b + c, strings
+    BC_C2S,     // a = string of char b
+
+    BC_JMP,    // Jump to c
+    BC_JMPF,   // Jump to c if a is false
+    BC_JMPT,   // Jump to c if a is true
+    BC_JLTI,   // Jump to c if a < b
+    BC_JLEI,   // Jump to c if a <= b
+    BC_JEQI,   // Jump to c if a = b
+    BC_JNEI,   // Jump to c if a <> b
+    BC_JLTIK,  // Jump to c if a < signed b
+    BC_JLEIK,  // Jump to c if a <= signed b
+    BC_JGTIK,  // Jump to c if a > signed b
+    BC_JGEIK,  // Jump to c if a >= signed b
+    BC_JEQIK,  // Jump to c if a = signed b
+    BC_JNEIK,  // Jump to c if a <> signed b
+
+    BC_CALL,  // Call function b with its frame at register a and its static link c links up, the result lands in a
+    BC_RET,   // Return from the function
+
+    BC_OPCODES,  // Number of opcodes
+} bcOp;
+
+// Instruction, 8 bytes
+typedef struct {
+    uint64_t op : 8;  // Opcode
+    uint64_t a : 16;  // Register
+    uint64_t b : 16;  // Register, function index, number of static links, or signed immediate
+    uint64_t c : 24;  // Register, jump target, constant or global index, or signed immediate
+} bcInstr;
+
+// Register, the instruction tells what it holds
+typedef union bcValue {
+    int64_t        i;  // integer, boolean or char
+    double         r;  // real
+    char          *s;  // string, NULL for the empty string
+    union bcValue *p;  // Variable of a reference parameter
+} bcValue;
+
+// Compiled function, the program body is a function too
+typedef struct {
+    char     *name;        // Function name
+    bcInstr  *code;        // Instructions
+    uint64_t *lines;       // Source line of each instruction
+    uint32_t  size;        // Number of instructions
+    uint32_t  capacity;    // Allocated slots
+    uint32_t  parameters;  // Parameters, the first registers of the frame
+    uint32_t  result;      // Register of the result, BC_ANY for procedures and the program
+    uint32_t  registers;   // Frame size
+    uint32_t  depth;       // Scope depth of the body, 0 for the program
+} bcFunction;
+
+// Variable of the program scope, kept so the program can show its results
+typedef struct {
+    char    *name;  // Variable name
+    uint32_t type;  // Type id
+    uint32_t slot;  // Register in the frame of the program body
+} bcGlobal;
+
+// Compiled program, function 0 is the program body
+typedef struct {
+    bcFunction *functions;         // Functions
+    uint32_t    size;              // Number of functions
+    uint32_t    functionCapacity;  // Allocated slots
+
+    bcValue *constants;         // Constants
+    uint32_t constantSize;      // Number of constants
+    uint32_t constantCapacity;  // Allocated slots
+
+    char   **strings;         // String constants, owned by the program
+    uint32_t stringSize;      // Number of strings
+    uint32_t stringCapacity;  // Allocated slots
+
+    bcGlobal *globals;         // Variables of the program scope in declaration order
+    uint32_t  globalSize;      // Number of variables
+    uint32_t  globalCapacity;  // Allocated slots
+} bcProgram;
+
+// Compiler state, a typed tree is compiled in one walk
+typedef struct {
+    bcProgram   *program;   // Program being built
+    TypeChecker *types;     // Types and symbols of the tree
+    uint32_t    *slots;     // Register of each variable symbol, function index of each function symbol
+    uint32_t     index;     // Index of the function being compiled
+    uint32_t     depth;     // Scope depth of the function being compiled
+    uint32_t     top;       // First free register
+    uint64_t     line;      // Line of the statement being compiled
+    bool         failed;    // A limit of the virtual machine was exceeded, reported once
+    eErrorList  *errors;    // Programs the virtual machine can't hold
+} bcCompiler;
+
+bcProgram *bcCompile(TypeChecker *types, astProgram *program, eErrorList *errors);
+void       bcFree(bcProgram *program);
+
+void     bcCompileBlock(bcCompiler *c, astBlockStmt *block);
+void     bcCompileFunction(bcCompiler *c, astFunctionStmt *function);
+void     bcCompileLocals(bcCompiler *c, astDeclarationStmt **declarations, uint32_t size);
+void     bcCompileStatement(bcCompiler *c, astStatement *s);
+uint32_t bcCompileJump(bcCompiler *c, astExpression *condition, bool when);
+uint32_t bcCompileExpression(bcCompiler *c, astExpression *e, uint32_t dst);
+uint32_t bcCompileConverted(bcCompiler *c, astExpression *e, uint32_t type, uint32_t dst);
+uint32_t bcCompileInfix(bcCompiler *c, astInfixExpr *infix, uint32_t dst);
+uint32_t bcCompileVariable(bcCompiler *c, astIdentifierExpr *identifier, uint32_t dst);
+uint32_t bcCompileCall(bcCompiler *c, astIdentifierExpr *callee, astExpression **arguments, uint32_t size,
+                       uint32_t dst);
+void     bcCompileAssignment(bcCompiler *c, astAssignmentExpr *assignment);
+void     bcCompileAddress(bcCompiler *c, astIdentifierExpr *identifier, uint32_t dst);
+uint32_t bcSnapshot(bcCompiler *c, uint32_t reg, uint32_t mark, astExpression *later);
+bool     bcHasCall(bcCompiler *c, astExpression *e);
+
+uint32_t bcEmit(bcCompiler *c, bcOp op, uint32_t a, uint32_t b, uint32_t cc);
+void     bcPatch(bcCompiler *c, uint32_t jump, uint32_t target);
+uint32_t bcTemporary(bcCompiler *c);
+uint32_t bcDestination(bcCompiler *c, uint32_t dst);
+uint32_t bcConstant(bcCompiler *c, bcValue value);
+uint32_t bcString(bcCompiler *c, char *value);
+uint32_t bcNewFunction(bcProgram *program, char *name);
+void     bcError(bcCompiler *c, char *msg);
+bool     bcIsSmall(astExpression *e, int64_t min, int64_t max, int64_t *value);
+
+bcOp      bcOperator(TokenType op, uint32_t type);
+bcOp      bcBranch(TokenType op, bool immediate);
+TokenType bcNegation(TokenType op);
+
+char *bcOpName(bcOp op);
+
+#endif  // BYTECODE_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef CGEN_H
+#define CGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "symbols.h"
+#include "types.h"
+
+// How cgEmitDeclarations writes the variables of a block
+typedef enum {
+    CG_GLOBAL = 0,  // `static` C globals, zeroed
+    CG_LOCAL,       // C locals, zeroed
+    CG_FIELD,       // Fields of a frame struct
+    CG_FIELD_INIT,  // Statements setting the string fields of a frame to "", the rest is zeroed with the frame
+} cgDeclaration;
+
+// Function of the program, lowered to a C function of its own since C has no nested functions
+typedef struct {
+    astFunctionStmt *function;  // Function, NULL for the program body
+    uint32_t         parent;    // Index of the function it's declared in, 0 for the program scope
+    uint32_t         depth;     // Scope depth of the body, 0 for the program
+    bool             framed;    // Has nested functions, so its variables live in a struct they reach through a pointer
+} cgFunction;
+
+// Operand evaluated into a temporary ahead of the statement that uses it
+typedef struct {
+    astExpression *expr;    // Operand
+    uint32_t       number;  // Its temporary is `pas_t<number>`
+} cgTemporary;
+
+/*
+C generator, lowers a typed tree to a portable C99 program.
+Variables of the program scope become C globals. Each function becomes a top-level C function, and one that has nested
+functions keeps its variables in a frame struct, so the nested ones reach them through a chain of `pas_up` pointers,
+the static links of the VM spelled out. `var` parameters become pointers.
+C leaves the order of operands and arguments unspecified, so once one of them calls a function or can stop on a
+division, the operands are evaluated into temporaries ahead of the statement, left to right as the VM runs them.
+The program prints its variables at the end, as `--run` does, so both can be diffed.
+*/
+typedef struct {
+    FILE        *out;      // Output
+    TypeChecker *types;    // Types and symbols of the tree
+    astProgram  *program;  // Program being written
+
+    cgFunction *functions;         // Functions, index 0 is the program body
+    uint32_t    size;              // Number of functions
+    uint32_t    functionCapacity;  // Allocated slots
+
+    uint32_t *slots;    // Function index of each function symbol
+    uint32_t  current;  // Function being written
+    uint32_t  indent;   // Indentation level
+
+    cgTemporary   *temporaries;        // Temporaries of the statement being written, in source order
+    cgTemporary   *sorted;             // The same ones sorted by operand, to look one up
+    uint32_t       temporarySize;      // Number of temporaries
+    uint32_t       temporaryCapacity;  // Allocated slots of both
+    uint32_t       temporaryNumber;    // Number of the next temporary of the function being written
+    astExpression *defining;           // Operand whose temporary is being written, so it's written out in full
+} CGen;
+
+bool cgEmitProgram(TypeChecker *types, astProgram *program, FILE *out);
+
+void cgCollect(CGen *g, astBlockStmt *block, uint32_t parent);
+void cgEmitPrelude(CGen *g);
+void cgEmitDeclarations(CGen *g, astBlockStmt *block, cgDeclaration mode);
+void cgEmitFrame(CGen *g, uint32_t index);
+void cgEmitSignature(CGen *g, uint32_t index);
+void cgEmitFunction(CGen *g, uint32_t index);
+void cgEmitBlock(CGen *g, astBlockStmt *block);
+void cgEmitStatement(CGen *g, astStatement *s);
+void cgEmitBody(CGen *g, astStatement *s);
+void cgEmitExpression(CGen *g, astExpression *e);
+void cgEmitConverted(CGen *g, astExpression *e, uint32_t type);
+void cgEmitInfix(CGen *g, astInfixExpr *infix);
+void cgEmitCall(CGen *g, astIdentifierExpr *callee, astExpression **arguments, uint32_t size);
+void cgEmitVariable(CGen *g, astIdentifierExpr *identifier, bool address);
+void cgEmitFramePath(CGen *g, uint32_t depth);
+void cgEmitString(CGen *g, char *value);
+void cgEmitIndent(CGen *g);
+
+bool         cgOrder(CGen *g, astExpression *e);
+bool         cgOrderOperands(CGen *g, astExpression **operands, uint32_t size, uint32_t *parameters);
+bool         cgIsLiteral(astExpression *e);
+uint32_t     cgFindTemporaries(CGen *g, astExpression *e);
+void         cgEmitTemporaries(CGen *g);
+cgTemporary *cgTemporaryOf(CGen *g, astExpression *e);
+int          cgCompareTemporaries(const void *a, const void *b);
+
+char *cgType(uint32_t type);
+char *cgZero(uint32_t type);
+
+#endif  // CGEN_H
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef CHECKER_H
+#define CHECKER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "error.h"
+#include "events.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token.h"
+
+/*
+Check of a function, kept so a later check of an edited copy of the input can skip the function if its source didn't change.
+A check only depends on the bytes from its `function` token up to `read` and on the line it starts at,
+so it's reused when the checker reaches the same token again with those bytes untouched.
+*/
+typedef struct {
+    uint64_t start;  // Offset of the `function` or `procedure` token
+    uint64_t read;   // Offset past the last byte the check looked at
+    uint64_t line;   // Line of the `function` or `procedure` token
+
+    TokenSpan curToken;   // Current token after the check
+    TokenSpan peekToken;  // Peek token after the check
+    uint64_t  position;   // Lexer position after the check
+    uint64_t  endLine;    // Lexer line after the check
+    uint64_t  lineStart;  // Lexer line start after the check
+    uint64_t  vars;       // Identifiers the check counted
+    uint64_t  literals;   // Literals the check counted
+
+    uint32_t errors;      // First diagnostic of the check in the list diagnostics
+    uint32_t errorCount;  // Number of diagnostics, nested functions included
+} cMemo;
+
+// Function checks of one input, by start offset
+typedef struct {
+    cMemo   *data;
+    uint32_t size;
+    uint32_t capacity;
+
+    eErrorList *errors;  // Diagnostics of the check the list was recorded in
+} cMemoList;
+
+/*
+Syntax checker, a validating recogniser for the same grammar as the parser.
+It walks the input with token spans instead of tokens and builds no AST,
+so the only allocations are the ones made by its setup and by the diagnostics.
+When `events` is set, the checker reports every node it recognises through it.
+*/
+typedef struct {
+    Lexer *l;
+
+    TokenSpan curToken;
+    TokenSpan peekToken;
+
+    eErrorList   *errors;
+    EventHandler *events;
+
+    uint32_t assignCounter;
+
+    cMemoList *reuse;   // Function checks of an earlier version of the input, NULL to check everything
+    cMemoList *record;  // Function checks of this check are recorded here, NULL to not record them
+} Checker;
+
+Checker *cNew(Lexer *l);
+void     cFree(Checker *c);
+
+void cAddError(Checker *c, char *error);
+void cBudgetError(Checker *c);
+void cCustomError(Checker *c, char *msg);
+void cPeekError(Checker *c, char *str);
+void cNoPrefixParseFnError(Checker *c, TokenSpan *t);
+
+void cEnter(Checker *c, EventKind kind, TokenSpan *t);
+void cExit(Checker *c, EventKind kind);
+void cLeaf(Checker *c, EventKind kind);
+
+void cNextToken(Checker *c);
+bool cCurTokenIs(Checker *c, TokenType t);
+bool cPeekTokenIs(Checker *c, TokenType t);
+bool cExpectPeek(Checker *c, TokenType t, char *msg);
+
+Precedence cPrecedence(TokenType t);
+bool       cHasPrefixParseFn(TokenType t);
+bool       cHasInfixParseFn(TokenType t);
+
+bool cCheckProgram(Checker *c);
+
+void cCheckBlockStmt(Checker *c);
+void cCheckVarStmt(Checker *c, bool isGlobal);
+bool cCheckDeclarationStmt(Checker *c);
+void cCheckFunctionStmt(Checker *c);
+void cCheckFunction(Checker *c);
+bool cCheckParameterStmt(Checker *c);
+void cCheckBeginEndStmt(Checker *c);
+void cCheckConditionalStmt(Checker *c);
+void cCheckWhileStmt(Checker *c);
+void cCheckExpressionStmt(Checker *c);
+
+void cCheckExpression(Checker *c, Precedence pr);
+void cCheckPrefixExpr(Checker *c);
+void cCheckInfixExpr(Checker *c);
+void cCheckGroupedExpr(Checker *c);
+void cCheckAssignmentExpr(Checker *c);
+void cCheckTypeExpr(Checker *c);
+void cCheckCallExpr(Checker *c);
+
+cMemoList *cMemoNew();
+void       cMemoFree(cMemoList *m);
+void       cMemoAdopt(cMemoList *m, Checker *c);
+void       cMemoShift(cMemoList *m, uint64_t start, uint64_t end, uint64_t length);
+cMemo     *cMemoFind(cMemoList *m, uint64_t start);
+bool       cMemoReuse(Checker *c);
+uint32_t   cMemoBegin(Checker *c);
+void       cMemoEnd(Checker *c, uint32_t index);
+void       cMemoAddError(eErrorList *e, char *error, int64_t lines);
+
+#endif  // CHECKER_H
\ No newline at end of file
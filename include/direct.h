@@ -0,0 +1,166 @@
+#ifndef DIRECT_H
+#define DIRECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bytecode.h"
+#include "error.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token.h"
+#include "types.h"
+
+// What an expression compiled so far is
+typedef enum {
+    DC_NONE = 0,   // No value, an assignment, a procedure call or an ill-typed expression
+    DC_NAME,       // Name not read yet, it can still be assigned to, called or passed by reference
+    DC_VALUE,      // Register or literal
+    DC_RESULT,     // Result of a call in the first register of its arguments, not taken yet
+    DC_NEGATION,   // `-` of a register or literal, not computed yet
+    DC_OPERATION,  // Infix operation, not computed yet
+} dcKind;
+
+// Operand of an operation, a register or a literal
+typedef struct {
+    bool     literal;   // Not loaded yet, `value` holds it
+    bool     prefixed;  // Integer literal folded from a `-`, only the immediate forms see it as a literal
+    uint32_t reg;       // Register holding the value
+    uint32_t mark;      // First temporary the operand may hold, a value there is converted in place
+    uint32_t type;      // Type id
+    bcValue  value;     // Value of a literal, the constant index of a string literal
+} dcOperand;
+
+/*
+Expression compiled so far, its last instructions are held back until its use is known.
+An operation is computed straight into the register it's assigned to, a comparison in a condition becomes a
+compare-and-branch, and a name is only read once it's known not to be assigned to, called or passed by reference.
+The left operand of an operation is only loaded or converted once the right one is typed, its instructions are then
+moved in front of the ones of the right operand, whose temporaries move up a register if the left one needs one.
+*/
+typedef struct {
+    uint8_t   kind;      // dcKind
+    uint32_t  type;      // Type id of the value, TY_NONE for a name not typed yet
+    uint32_t  symbol;    // Symbol of a name, 0 if it isn't declared
+    uint8_t   op;        // Operator token of an operation
+    uint32_t  nots;      // `not`s applied to the boolean it holds, from the innermost out
+    dcOperand left;      // Register or literal of a value, operand of a negation, left operand of an operation
+    dcOperand right;     // Right operand of an operation
+    uint32_t  mark;      // First register of the temporaries the expression holds
+    uint64_t  line;      // Line of the token the tree would give the expression, for diagnostics and calls of a name
+    uint64_t  codeLine;  // Line the instruction of an operation gets, the last line set inside it
+} dcItem;
+
+// Name being declared, kept until its type is read
+typedef struct {
+    TokenSpan name;       // Identifier
+    uint32_t  type;       // Type id
+    bool      reference;  // `var` parameter
+} dcDeclaration;
+
+/*
+Single-pass compiler, writes bytecode while it recognises the input, without building a tree.
+It walks the grammar of the checker with token spans, resolving and typing names and expressions as they're read,
+and backpatches the jumps of `if` and `while`. The condition of a `while` is set aside and written after its body,
+so the program has the layout, the runtime errors and the diagnostics bcCompile gives the tree of the same input.
+What outlives a statement is the bytecode and the declared names, so memory follows the size of the bytecode.
+*/
+typedef struct {
+    Lexer *l;
+
+    TokenSpan curToken;
+    TokenSpan peekToken;
+
+    bcCompiler   bc;            // Program, function, registers and line being written, slots indexed by symbol
+    TypeChecker *types;         // Scopes, symbols and signatures, and the name, type and size errors
+    uint32_t     slotCapacity;  // Allocated slots of bc.slots
+
+    uint32_t *open;          // Function symbols being compiled, innermost last
+    uint32_t  openSize;      // Number of functions
+    uint32_t  openCapacity;  // Allocated slots
+
+    dcDeclaration *declarations;         // Names of the declaration or parameter list being read
+    uint32_t       declarationSize;      // Number of names
+    uint32_t       declarationCapacity;  // Allocated slots
+
+    uint32_t *pending;          // Argument errors of the calls being compiled, dropped if the count is wrong
+    uint32_t  pendingSize;      // Number of errors
+    uint32_t  pendingCapacity;  // Allocated slots
+
+    char    *buffer;          // Literal or name being read
+    uint32_t bufferCapacity;  // Allocated bytes
+
+    uint32_t assignCounter;
+    uint64_t lines;  // Times an operator, call or assignment set the line, tells if an operand set it
+    uint64_t calls;  // Calls written, tells if an operand calls a function
+
+    eErrorList *errors;  // Syntax errors, same messages as the checker
+    eErrorList *limits;  // Limits of the virtual machine the program exceeds, bc.errors
+} DirectCompiler;
+
+bcProgram *dcCompile(Lexer *l, eErrorList *errors);
+
+void dcNextToken(DirectCompiler *d);
+bool dcCurTokenIs(DirectCompiler *d, TokenType t);
+bool dcPeekTokenIs(DirectCompiler *d, TokenType t);
+bool dcExpectPeek(DirectCompiler *d, TokenType t, char *msg);
+
+bool dcCompileProgram(DirectCompiler *d);
+void dcCompileBlockStmt(DirectCompiler *d);
+void dcCompileVarStmt(DirectCompiler *d);
+bool dcCompileDeclarationStmt(DirectCompiler *d, bool reference);
+void dcCompileFunctionStmt(DirectCompiler *d);
+bool dcCompileParameterStmt(DirectCompiler *d);
+void dcCompileBeginEndStmt(DirectCompiler *d);
+bool dcCompileBody(DirectCompiler *d);
+void dcCompileConditionalStmt(DirectCompiler *d);
+void dcCompileWhileStmt(DirectCompiler *d);
+void dcCompileExpressionStmt(DirectCompiler *d);
+void dcCompileCondition(DirectCompiler *d, dcItem *condition);
+
+void     dcCompileExpression(DirectCompiler *d, Precedence pr, dcItem *o);
+void     dcCompileLiteral(DirectCompiler *d, dcItem *o);
+void     dcCompileName(DirectCompiler *d, dcItem *o);
+void     dcCompilePrefixExpr(DirectCompiler *d, dcItem *o);
+void     dcCompileGroupedExpr(DirectCompiler *d, dcItem *o);
+void     dcCompileInfixExpr(DirectCompiler *d, dcItem *o, uint64_t lines);
+void     dcCompileAssignmentExpr(DirectCompiler *d, dcItem *o, uint32_t errors);
+void     dcCompileCallExpr(DirectCompiler *d, dcItem *o, uint32_t errors);
+void     dcCompileArgument(DirectCompiler *d, dcItem *callee, uint32_t index, uint32_t base);
+uint32_t dcCompileTypeExpr(DirectCompiler *d);
+
+void     dcCheckName(DirectCompiler *d, dcItem *o);
+void     dcRead(DirectCompiler *d, dcItem *o);
+uint32_t dcValue(DirectCompiler *d, dcItem *o, uint32_t dst);
+uint32_t dcConverted(DirectCompiler *d, dcItem *o, uint32_t type, uint32_t dst);
+uint32_t dcJump(DirectCompiler *d, dcItem *o, bool when);
+uint32_t dcOperation(DirectCompiler *d, dcItem *o, uint32_t dst);
+uint32_t dcNot(DirectCompiler *d, dcItem *o, uint32_t value, uint32_t dst);
+uint32_t dcResult(DirectCompiler *d, uint32_t base, uint32_t dst);
+bool     dcPrepare(DirectCompiler *d, dcOperand *left, dcOperand *right, uint32_t type, uint32_t at, bool call);
+uint32_t dcOperandValue(DirectCompiler *d, dcOperand *operand, uint32_t dst);
+uint32_t dcOperandConverted(DirectCompiler *d, dcOperand *operand, uint32_t type);
+uint32_t dcVariable(DirectCompiler *d, uint32_t symbol, uint32_t dst);
+void     dcCall(DirectCompiler *d, uint32_t symbol, uint32_t base, uint64_t line);
+void     dcAddress(DirectCompiler *d, uint32_t symbol, uint32_t dst);
+bool     dcIsSmall(dcOperand *operand, int64_t min, int64_t max, int64_t *value);
+bool     dcWidens(uint32_t from, uint32_t to);
+uint32_t dcCommonType(TokenType op, uint32_t left, uint32_t right, uint32_t type);
+void     dcShift(DirectCompiler *d, uint32_t from, uint32_t mark);
+void     dcMove(DirectCompiler *d, uint32_t at, uint32_t from);
+
+uint32_t dcDeclare(DirectCompiler *d, TokenSpan *name, syKind kind, uint32_t type);
+uint32_t dcLookup(DirectCompiler *d, TokenSpan *name);
+char    *dcSpan(DirectCompiler *d, TokenSpan *t);
+bool     dcIsOpen(DirectCompiler *d, uint32_t symbol);
+
+void dcAddError(DirectCompiler *d, char *error);
+void dcBudgetError(DirectCompiler *d);
+void dcCustomError(DirectCompiler *d, char *msg);
+void dcPeekError(DirectCompiler *d, char *str);
+void dcNoPrefixParseFnError(DirectCompiler *d, TokenSpan *t);
+void dcInsertError(DirectCompiler *d, uint32_t index, char *error);
+void dcRemoveError(DirectCompiler *d, uint32_t index);
+void dcDropErrors(DirectCompiler *d, uint32_t size);
+
+#endif  // DIRECT_H
\ No newline at end of file
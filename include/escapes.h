@@ -0,0 +1,29 @@
+#ifndef ESCAPES_H
+#define ESCAPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "types.h"
+
+// Called on each expression before its operands, the operands are skipped when it returns false
+typedef bool (*esVisitor)(void *context, astExpression *e);
+
+/*
+Finds the variables of a typed tree that have to live in memory instead of in registers or SSA values.
+A variable escapes when a body at a depth other than its own reads or writes it, or when it's passed by reference,
+and a function result escapes when it's assigned outside its own body.
+A reference parameter passed on by reference doesn't escape, it only hands over the address it already holds.
+*/
+typedef struct {
+    TypeChecker *types;    // Types and symbols of the tree
+    bool        *escapes;  // Set for each escaping symbol, indexed by symbol
+    esVisitor    visit;    // Called on every expression scanned, NULL if unused
+    void        *context;  // Passed to `visit`
+} Escapes;
+
+void esScanStatement(Escapes *x, astStatement *s, uint32_t depth);
+void esScanExpression(Escapes *x, astExpression *e, uint32_t depth);
+
+#endif  // ESCAPES_H
\ No newline at end of file
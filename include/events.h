@@ -0,0 +1,90 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+#include "ast.h"
+#include "lexer.h"
+#include "token.h"
+
+/*
+Parse events, emitted by the checker as it recognises each node.
+Every `enter` is matched by an `exit`, also when the node has errors.
+The `enter` token is the token the parser would store in the node, the `exit` token is the last token consumed.
+
+Expressions are emitted in parse order, so the left operand of an infix, assignment or call expression
+is entered and exited before the operator itself is entered.
+*/
+typedef enum {
+    EV_PROGRAM = 0,      // `program` token
+    EV_BLOCK,            // Token before the block
+    EV_VAR,              // `var` token
+    EV_DECLARATION,      // First identifier
+    EV_FUNCTION,         // `function` or `procedure` token
+    EV_PARAMETER,        // `var` token for reference parameters, otherwise the token before the parameter
+    EV_BEGIN_END,        // `begin` token
+    EV_CONDITIONAL,      // `if` token
+    EV_WHILE,            // `while` token
+    EV_EXPRESSION_STMT,  // First token of the expression
+    EV_PREFIX,           // Operator token
+    EV_INFIX,            // Operator token, adopts the previous expression as its left operand
+    EV_ASSIGNMENT,       // `:=` token, adopts the previous expression as its identifier
+    EV_IDENTIFIER,       // Identifier token
+    EV_INTEGER,          // Integer literal token
+    EV_FLOAT,            // Float literal token
+    EV_BOOLEAN,          // `true` or `false` token
+    EV_STRING,           // String literal token
+    EV_CHAR,             // Character literal token
+    EV_TYPE,             // Type token
+    EV_CALL,             // `(` token, adopts the previous expression as the function name
+} EventKind;
+
+// Event callbacks, `ctx` is passed back untouched
+typedef struct {
+    void (*enter)(void *ctx, EventKind kind, TokenSpan *token);
+    void (*exit)(void *ctx, EventKind kind, TokenSpan *token);
+    void *ctx;
+} EventHandler;
+
+//
+// AST builder, rebuilds the tree pParseProgram would build from the events
+//
+
+// Node built from an event, with the first token of its source for expression statements
+typedef struct {
+    EventKind kind;
+    void     *node;
+    Token    *first;
+} evChild;
+
+// Node being built, one per entered event
+typedef struct {
+    EventKind kind;
+    TokenSpan token;
+    evChild  *children;
+    uint32_t  size;
+    uint32_t  capacity;
+} evFrame;
+
+typedef struct {
+    Lexer      *l;
+    evFrame    *frames;
+    uint32_t    depth;
+    uint32_t    capacity;
+    astProgram *program;
+} AstBuilder;
+
+AstBuilder *evBuilderNew(Lexer *l);
+void        evBuilderFree(AstBuilder *b);
+
+void evBuilderEnter(void *ctx, EventKind kind, TokenSpan *token);
+void evBuilderExit(void *ctx, EventKind kind, TokenSpan *token);
+
+void    evFrameAppend(evFrame *f, evChild child);
+evChild evBuildNode(AstBuilder *b, evFrame *f);
+
+astProgram *evParseProgram(Lexer *l, eErrorList **errors);
+
+EventKind evKindOf(void *node);
+
+#endif  // EVENTS_H
\ No newline at end of file
@@ -0,0 +1,214 @@
+#ifndef EXEC_H
+#define EXEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "error.h"
+#include "types.h"
+
+#define EX_CHUNK      1024          // Nodes allocated at once
+#define EX_STACK_SIZE (256u << 20)  // Native stack of a run, every call of the program nests a few closures deeper
+
+typedef struct exNode     exNode;
+typedef struct exFrame    exFrame;
+typedef struct exFunction exFunction;
+typedef struct Executor   Executor;
+
+// Closure of a node, runs it in a frame, a statement's value is unused
+typedef bcValue (*exClosure)(exNode *n, exFrame *f);
+
+/*
+Node of the tree specialised once into a closure, a function pointer and the operands it works on.
+Until it first runs, a node is a lazy closure that holds the node of the tree it stands for and the function it's in,
+and the first run converts it in place, so the parent keeps pointing at it.
+*/
+struct exNode {
+    exClosure   eval;      // Closure
+    exNode     *a;         // Left operand, operand, condition, or value of an assignment
+    exNode     *b;         // Right operand, consequence or body
+    exNode     *c;         // Alternative
+    exNode    **list;      // Statements of a block, arguments of a call
+    uint32_t    size;      // Number of statements or arguments
+    uint32_t    slot;      // Slot of a variable, of the result of a function, or of a local operand
+    uint32_t    links;     // Static links up to the frame of a variable
+    bcValue     k;         // Constant, or constant right operand
+    uint64_t    line;      // Line of the runtime error the node can stop on, the line the VM reports
+    exFunction *function;  // Callee of a call, function a lazy node is in
+    void       *ast;       // Node of the tree of a lazy node
+};
+
+// Function of the program, its frame holds the parameters, the result and the variables in that order
+struct exFunction {
+    char     *name;        // Function name, owned by the tree
+    uint32_t  depth;       // Scope depth of the body, 0 for the program
+    uint32_t  parameters;  // Parameters, the first slots of the frame
+    uint32_t  result;      // Slot of the result, BC_ANY for procedures and the program
+    uint32_t  size;        // Slots of a frame
+    exNode   *body;        // Statements of the block
+};
+
+// Frame of a call in progress, on the native stack of the call
+struct exFrame {
+    bcValue    *slots;     // Parameters, result and variables of the call
+    bcValue    *globals;   // Variables of the program
+    exFrame    *link;      // Frame of the function the running one is declared in, the static link
+    exFunction *function;  // Function running in the frame
+    Executor   *x;         // Run the frame belongs to
+};
+
+/*
+Executor of a typed tree, runs a program without compiling it first.
+Each node becomes a closure the first time it runs, with its names resolved to frame slots and static links, its
+literals taken from the tree and its operators specialised by type and by operand, so a node is converted once and a
+node that never runs is never converted. The frames, the limits and the runtime errors are the ones of the VM, so a
+program leaves the same globals behind or stops with the same error.
+*/
+struct Executor {
+    TypeChecker *types;    // Symbols and signatures of the tree
+    astProgram  *program;  // Program, not owned
+
+    uint32_t    *slots;      // Slot of each variable and parameter symbol
+    exFunction **functions;  // Function of each function and procedure symbol, NULL until a call to it is converted
+    exFunction   main;       // Program body
+
+    void   **blocks;         // Memory of the nodes, argument and statement lists and functions
+    uint32_t blockSize;      // Number of blocks
+    uint32_t blockCapacity;  // Allocated slots
+    exNode  *chunk;          // Chunk new nodes are taken from, EX_CHUNK nodes
+    uint32_t used;           // Nodes taken from the chunk
+    uint64_t converted;      // Nodes converted so far
+
+    bcValue *stack;  // Slots of every frame, the program frame first so its slots are the globals
+    bcValue *top;    // First free slot
+    bcValue *end;    // End of the stack
+    uint32_t depth;  // Calls in progress
+
+    char   **strings;         // Strings built while running, freed with the executor
+    uint32_t stringSize;      // Number of strings
+    uint32_t stringCapacity;  // Allocated slots
+
+    uint64_t    budget;     // Loop iterations and calls left before the run gives up, 0 for no limit
+    bool        exhausted;  // The run gave up on its budget, without an error
+    bool        failed;     // The run stopped on a runtime error or on its budget
+    eErrorList *errors;     // Runtime error, the run stops at the first one
+};
+
+Executor *exNew(TypeChecker *types, astProgram *program);
+void      exFree(Executor *x);
+bool      exRun(Executor *x);
+void     *exMain(void *executor);
+void      exPrintGlobals(Executor *x, FILE *out);
+
+void       *exAllocate(Executor *x, size_t size);
+exNode     *exNodeNew(Executor *x);
+exNode     *exLazyNew(Executor *x, exFunction *scope, void *ast);
+exFunction *exFunctionOf(Executor *x, uint32_t symbol);
+uint32_t    exLayout(Executor *x, astDeclarationStmt **declarations, uint32_t size, uint32_t slot);
+
+void     exConvert(Executor *x, exNode *n);
+void     exConvertBlock(Executor *x, exNode *n, astStatement **statements, uint32_t size);
+void     exConvertInfix(Executor *x, exNode *n, astInfixExpr *infix);
+void     exConvertVariable(Executor *x, exNode *n, astIdentifierExpr *identifier);
+void     exConvertCall(Executor *x, exNode *n, astIdentifierExpr *callee, astExpression **arguments, uint32_t size);
+void     exConvertAssignment(Executor *x, exNode *n, astAssignmentExpr *assignment);
+exNode  *exConverted(Executor *x, exFunction *scope, astExpression *e, uint32_t type);
+exNode  *exAddressOf(Executor *x, exFunction *scope, astIdentifierExpr *identifier);
+bool     exIsConstant(astExpression *e, bcValue *value);
+bool     exIsLocal(Executor *x, exFunction *scope, astExpression *e, uint32_t *slot);
+uint64_t exLine(Executor *x, astExpression *e, uint64_t line);
+
+void  exFail(exFrame *f, uint64_t line, char *msg);
+bool  exSpend(Executor *x);
+char *exString(Executor *x, char *left, char *right);
+
+bcValue exLazy(exNode *n, exFrame *f);
+bcValue exNothing(exNode *n, exFrame *f);
+bcValue exSequence(exNode *n, exFrame *f);
+bcValue exIf(exNode *n, exFrame *f);
+bcValue exWhile(exNode *n, exFrame *f);
+
+bcValue exConstant(exNode *n, exFrame *f);
+bcValue exLocal(exNode *n, exFrame *f);
+bcValue exLocalRef(exNode *n, exFrame *f);
+bcValue exGlobal(exNode *n, exFrame *f);
+bcValue exUp(exNode *n, exFrame *f);
+bcValue exUpRef(exNode *n, exFrame *f);
+
+bcValue exSetLocal(exNode *n, exFrame *f);
+bcValue exSetLocalRef(exNode *n, exFrame *f);
+bcValue exSetGlobal(exNode *n, exFrame *f);
+bcValue exSetUp(exNode *n, exFrame *f);
+bcValue exSetUpRef(exNode *n, exFrame *f);
+
+bcValue exAddress(exNode *n, exFrame *f);
+bcValue exAddressGlobal(exNode *n, exFrame *f);
+bcValue exAddressUp(exNode *n, exFrame *f);
+
+bcValue exCall(exNode *n, exFrame *f);
+
+// Integer operators, K takes a constant right operand, L a local left operand and a constant right one
+bcValue exAddI(exNode *n, exFrame *f);
+bcValue exAddIK(exNode *n, exFrame *f);
+bcValue exAddIL(exNode *n, exFrame *f);
+bcValue exSubI(exNode *n, exFrame *f);
+bcValue exSubIK(exNode *n, exFrame *f);
+bcValue exSubIL(exNode *n, exFrame *f);
+bcValue exMulI(exNode *n, exFrame *f);
+bcValue exMulIK(exNode *n, exFrame *f);
+bcValue exMulIL(exNode *n, exFrame *f);
+bcValue exDivI(exNode *n, exFrame *f);
+bcValue exModI(exNode *n, exFrame *f);
+bcValue exNegI(exNode *n, exFrame *f);
+
+bcValue exEqI(exNode *n, exFrame *f);
+bcValue exEqIK(exNode *n, exFrame *f);
+bcValue exEqIL(exNode *n, exFrame *f);
+bcValue exNeI(exNode *n, exFrame *f);
+bcValue exNeIK(exNode *n, exFrame *f);
+bcValue exNeIL(exNode *n, exFrame *f);
+bcValue exLtI(exNode *n, exFrame *f);
+bcValue exLtIK(exNode *n, exFrame *f);
+bcValue exLtIL(exNode *n, exFrame *f);
+bcValue exLeI(exNode *n, exFrame *f);
+bcValue exLeIK(exNode *n, exFrame *f);
+bcValue exLeIL(exNode *n, exFrame *f);
+bcValue exGtI(exNode *n, exFrame *f);
+bcValue exGtIK(exNode *n, exFrame *f);
+bcValue exGtIL(exNode *n, exFrame *f);
+bcValue exGeI(exNode *n, exFrame *f);
+bcValue exGeIK(exNode *n, exFrame *f);
+bcValue exGeIL(exNode *n, exFrame *f);
+
+bcValue exAddF(exNode *n, exFrame *f);
+bcValue exSubF(exNode *n, exFrame *f);
+bcValue exMulF(exNode *n, exFrame *f);
+bcValue exDivF(exNode *n, exFrame *f);
+bcValue exNegF(exNode *n, exFrame *f);
+bcValue exI2F(exNode *n, exFrame *f);
+
+bcValue exEqF(exNode *n, exFrame *f);
+bcValue exNeF(exNode *n, exFrame *f);
+bcValue exLtF(exNode *n, exFrame *f);
+bcValue exLeF(exNode *n, exFrame *f);
+bcValue exGtF(exNode *n, exFrame *f);
+bcValue exGeF(exNode *n, exFrame *f);
+
+bcValue exEqS(exNode *n, exFrame *f);
+bcValue exNeS(exNode *n, exFrame *f);
+bcValue exLtS(exNode *n, exFrame *f);
+bcValue exLeS(exNode *n, exFrame *f);
+bcValue exGtS(exNode *n, exFrame *f);
+bcValue exGeS(exNode *n, exFrame *f);
+bcValue exConcat(exNode *n, exFrame *f);
+bcValue exC2S(exNode *n, exFrame *f);
+
+bcValue exNot(exNode *n, exFrame *f);
+bcValue exAnd(exNode *n, exFrame *f);
+bcValue exOr(exNode *n, exFrame *f);
+
+#endif  // EXEC_H
\ No newline at end of file
@@ -0,0 +1,245 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "types.h"
+
+#define IR_NONE       UINT32_MAX    // No value or block
+#define IR_STACK_SIZE (256u << 20)  // Native stack of the construction, a read recurses once per block it goes back
+
+// Lattice of a value in irSccp, a value only falls
+#define IR_TOP    0  // Not computed yet
+#define IR_KNOWN  1  // One constant
+#define IR_BOTTOM 2  // Varies
+
+/*
+Instructions of the SSA form, each one is the value it computes.
+Integers, booleans and chars share the integer instructions, `>` and `>=` are `<` and `<=` with swapped operands.
+Variables only their own function reads and writes are SSA values. The rest live in memory, in the frames like in the
+VM, and are reached by IR_LOAD, IR_STORE and IR_ADDR, where a reference parameter stands for the variable it points to.
+*/
+typedef enum {
+    IR_CONST = 0,  // k
+    IR_PARAM,      // Parameter k.i of the function
+    IR_PHI,        // One operand per predecessor of the block, in the order of its predecessors
+
+    IR_ADDI,  // a + b
+    IR_SUBI,  // a - b
+    IR_MULI,  // a * b
+    IR_DIVI,  // a div b, stops the program if b is 0
+    IR_MODI,  // a mod b, stops the program if b is 0
+    IR_NEGI,  // -a
+
+    IR_ADDF,  // a + b
+    IR_SUBF,  // a - b
+    IR_MULF,  // a * b
+    IR_DIVF,  // a / b, stops the program if b is 0
+    IR_NEGF,  // -a
+    IR_I2F,   // Real of integer a
+
+    IR_EQI,  // a = b
+    IR_NEI,  // a <> b
+    IR_LTI,  // a < b
+    IR_LEI,  // a <= b
+    IR_EQF,  // a = b
+    IR_NEF,  // a <> b
+    IR_LTF,  // a < b
+    IR_LEF,  // a <= b
+    IR_EQS,  // a = b
+    IR_NES,  // a <> b
+    IR_LTS,  // a < b
+    IR_LES,  // a <= b
+
+    IR_NOT,     // not a
+    IR_AND,     // a and b, both evaluated
+    IR_OR,      // a or b, both evaluated
+    IR_CONCAT,  // a + b, strings
+    IR_C2S,     // String of char a
+
+    IR_LOAD,   // Variable `symbol` in memory
+    IR_STORE,  // Variable `symbol` in memory = a
+    IR_ADDR,   // Address of variable `symbol`, a `var` argument
+    IR_CALL,   // Call of function `symbol` with the operands as arguments
+
+    IR_JUMP,    // Jump to the only successor
+    IR_BRANCH,  // Jump to the first successor if a holds, to the second otherwise
+    IR_RETURN,  // End of the function, with its result, or with every variable of the program for the program body
+
+    IR_OPS,  // Number of opcodes
+} irOp;
+
+// Instruction, and the value it computes
+typedef struct {
+    uint8_t   op;           // Opcode
+    bool      dead;         // Removed, its uses go to `replacement` when it has one
+    uint32_t  type;         // Type id of the value, TY_NONE for instructions without one
+    uint32_t  block;        // Block holding it
+    uint32_t *args;         // Operands
+    uint32_t  size;         // Number of operands
+    uint32_t  capacity;     // Allocated slots
+    uint32_t  symbol;       // Variable of a load, store, address or phi, function of a call
+    uint32_t  replacement;  // Value that took its place, IR_NONE if none
+    bcValue   k;            // Constant, parameter index
+    uint64_t  line;         // Line of the runtime error it can stop on, the line the VM reports
+} irInstr;
+
+// Basic block, its phis come first and its terminator last
+typedef struct {
+    uint32_t *instrs;    // Instructions
+    uint32_t  size;      // Number of instructions
+    uint32_t  capacity;  // Allocated slots
+
+    uint32_t *preds;         // Predecessors
+    uint32_t  predSize;      // Number of predecessors
+    uint32_t  predCapacity;  // Allocated slots
+    uint32_t  succs[2];      // Successors, the one taken when the branch holds first
+    uint32_t  succSize;      // Number of successors
+
+    uint32_t *incomplete;          // Phis read before the block was sealed, their operands wait for the predecessors
+    uint32_t  incompleteSize;      // Number of phis
+    uint32_t  incompleteCapacity;  // Allocated slots
+
+    bool sealed;  // Every predecessor is known
+    bool dead;    // Unreachable, removed
+} irBlock;
+
+// Function of the program, the program body is function 0, block 0 is the entry of each one
+typedef struct {
+    char    *name;        // Function name, owned by the tree
+    uint32_t symbol;      // Function symbol, 0 for the program body
+    uint32_t depth;       // Scope depth of the body, 0 for the program
+    uint32_t parameters;  // Parameters in SSA form
+
+    irInstr *instrs;         // Values
+    uint32_t size;           // Number of values
+    uint32_t capacity;       // Allocated slots
+    irBlock *blocks;         // Blocks
+    uint32_t blockSize;      // Number of blocks
+    uint32_t blockCapacity;  // Allocated slots
+} irFunction;
+
+// Stages of irBuild and irOptimize
+typedef enum {
+    IR_BUILD = 0,  // Construction from the tree
+    IR_SCCP,       // Sparse conditional constant propagation
+    IR_GVN,        // Global value numbering
+    IR_DCE,        // Dead code elimination
+    IR_PASSES,     // Number of stages
+} irPass;
+
+// Size of the program after a stage, and the time the stage took
+typedef struct {
+    uint64_t time;          // Nanoseconds
+    uint64_t blocks;        // Reachable blocks
+    uint64_t instructions;  // Instructions, phis excluded
+    uint64_t phis;          // Phis
+} irStats;
+
+/*
+SSA form of a typed tree, with a control flow graph for `if` and `while`.
+Each function is built straight from the tree with the on-the-fly construction of Braun et al.: a variable read looks
+up its definition in the current block and then in the predecessors, a block still missing predecessors gets phis that
+are completed when it is sealed, and a phi that only repeats one value is replaced by it.
+The evaluation order, the runtime errors and their lines are the ones of the VM, so a backend of the form behaves like
+it, and the passes keep every instruction that can stop the program, call a function or write memory.
+*/
+typedef struct {
+    TypeChecker *types;    // Types and symbols of the tree
+    astProgram  *program;  // Program, not owned
+
+    irFunction *functions;         // Functions, in declaration order
+    uint32_t    size;              // Number of functions
+    uint32_t    functionCapacity;  // Allocated slots
+
+    bool     *escapes;         // Variable symbols kept in memory, a nested function or a `var` argument reaches them
+    uint32_t *globals;         // Variables of the program in declaration order, the operands of its IR_RETURN
+    uint32_t  globalSize;      // Number of variables
+    uint32_t  globalCapacity;  // Allocated slots
+
+    uint32_t  current;      // Function being built
+    uint32_t  block;        // Block being filled
+    uint64_t *defKeys;      // Definitions of the function being built, variable symbol and block
+    uint32_t *defValues;    // Value of each definition
+    uint32_t  defSize;      // Number of definitions
+    uint32_t  defCapacity;  // Slots, a power of two
+
+    irStats stats[IR_PASSES];  // Size after each stage
+} irProgram;
+
+// State of irSccp over one function
+typedef struct {
+    irFunction *f;           // Function
+    uint8_t    *state;       // Lattice state of each value
+    bcValue    *values;      // Constant of each IR_KNOWN value
+    bool       *executable;  // Blocks an edge reaches
+    uint32_t   *edges;       // First flag of each block in `reached`
+    bool       *reached;     // Edges that can be taken, one flag per predecessor of each block
+    uint32_t   *userStart;   // First user of each value in `users`
+    uint32_t   *users;       // Instructions with each value as an operand
+    uint32_t   *flow;        // Blocks to visit, the block shifted left once, plus 1 to visit only its phis
+    uint32_t    flowSize;    // Number of blocks to visit
+    uint32_t   *ssa;         // Values whose state fell, their users are visited again
+    uint32_t    ssaSize;     // Number of values
+} irSccpState;
+
+irProgram *irBuild(TypeChecker *types, astProgram *program);
+void      *irMain(void *program);
+void       irOptimize(irProgram *p);
+void       irFree(irProgram *p);
+void       irCount(irProgram *p, irStats *stats);
+void       irPrint(irProgram *p, FILE *out);
+
+void     irScanBlock(irProgram *p, astBlockStmt *block, uint32_t depth);
+void     irBuildFunction(irProgram *p, astFunctionStmt *function, uint32_t depth);
+void     irBuildBlock(irProgram *p, astBlockStmt *block);
+void     irBuildStatement(irProgram *p, astStatement *s);
+uint32_t irBuildExpression(irProgram *p, astExpression *e);
+uint32_t irBuildConverted(irProgram *p, astExpression *e, uint32_t type);
+uint32_t irBuildInfix(irProgram *p, astInfixExpr *infix);
+uint32_t irBuildCall(irProgram *p, astIdentifierExpr *callee, astExpression **arguments, uint32_t size);
+void     irBuildAssignment(irProgram *p, astAssignmentExpr *assignment);
+uint32_t irRead(irProgram *p, uint32_t symbol, uint32_t type);
+bool     irInSsa(irProgram *p, uint32_t symbol);
+uint64_t irLine(irProgram *p, astExpression *e, uint64_t line);
+
+uint32_t irNewFunction(irProgram *p, char *name, uint32_t symbol, uint32_t depth);
+uint32_t irNewBlock(irFunction *f);
+uint32_t irEmit(irFunction *f, uint32_t block, irOp op, uint32_t type);
+void     irAddArg(irFunction *f, uint32_t value, uint32_t arg);
+uint32_t irConstant(irFunction *f, uint32_t block, uint32_t type, bcValue k);
+uint32_t irZero(irFunction *f, uint32_t type);
+uint32_t irPhi(irFunction *f, uint32_t block, uint32_t symbol, uint32_t type);
+void     irEdge(irFunction *f, uint32_t from, uint32_t to);
+void     irTerminate(irProgram *p, irOp op, uint32_t arg, uint32_t to, uint32_t otherwise);
+
+uint32_t irDefinition(irProgram *p, uint32_t symbol, uint32_t block);
+void     irWriteVariable(irProgram *p, uint32_t symbol, uint32_t block, uint32_t value);
+uint32_t irReadVariable(irProgram *p, uint32_t symbol, uint32_t block, uint32_t type);
+uint32_t irReadRecursive(irProgram *p, uint32_t symbol, uint32_t block, uint32_t type);
+uint32_t irAddPhiOperands(irProgram *p, uint32_t phi);
+uint32_t irRemoveTrivialPhi(irFunction *f, uint32_t phi);
+void     irSeal(irProgram *p, uint32_t block);
+uint32_t irResolve(irFunction *f, uint32_t value);
+
+void     irSccp(irFunction *f);
+void     irVisit(irSccpState *s, uint32_t v);
+void     irReach(irSccpState *s, uint32_t from, uint32_t to);
+void     irLower(irSccpState *s, uint32_t v, uint8_t state, bcValue value);
+bool     irFold(irOp op, bcValue a, bcValue b, bcValue *result);
+void     irGvn(irFunction *f);
+bool     irSame(irFunction *f, uint32_t a, uint32_t b);
+void     irDce(irFunction *f);
+bool     irIsPure(irFunction *f, irInstr *in);
+void     irRemoveEdge(irFunction *f, uint32_t from, uint32_t to);
+void     irCleanPhis(irFunction *f);
+void     irCompact(irFunction *f);
+uint32_t irDominators(irFunction *f, uint32_t *order, uint32_t *idom);
+
+char *irOpName(irOp op);
+
+#endif  // IR_H
\ No newline at end of file
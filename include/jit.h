@@ -0,0 +1,231 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bytecode.h"
+#include "vm.h"
+
+// Machine code needs x86-64 and the System V calling convention, every other host runs on the VM
+#if defined(__x86_64__) && defined(__linux__) && !defined(JIT_DISABLED)
+#define JIT_AVAILABLE
+#endif
+
+#define JIT_MAX_HOLES   4          // Holes of a stencil
+#define JIT_FUEL        (1 << 16)  // Loop iterations and calls between two checks of the deadline
+#define JIT_ZERO_INLINE 8          // Registers a call zeroes with a store each, more take a single `rep stosq`
+
+// What a hole of a stencil is patched with
+typedef enum {
+    JIT_HOLE_A = 0,        // disp32, offset of register `a`
+    JIT_HOLE_B,            // disp32, offset of register `b`
+    JIT_HOLE_C,            // disp32, offset of register `c`
+    JIT_HOLE_IMMEDIATE,    // imm32, signed immediate of the instruction
+    JIT_HOLE_PC,           // imm32, index of the instruction, for the line of a runtime error
+    JIT_HOLE_COUNT,        // imm32, registers a call zeroes
+    JIT_HOLE_SIZE,         // imm32, bytes of the frame of a callee
+    JIT_HOLE_CONSTANT,     // imm64, bits of a constant
+    JIT_HOLE_FUNCTION,     // imm64, address of the bcFunction of a callee
+    JIT_HOLE_MESSAGE,      // imm64, address of the message of a runtime error
+    JIT_HOLE_FAIL,         // imm64, address of jitFail
+    JIT_HOLE_TICK,         // imm64, address of jitTick
+    JIT_HOLE_COMPARE,      // imm64, address of jitCompareStrings
+    JIT_HOLE_STRING,       // imm64, address of vmString
+    JIT_HOLE_CHAR,         // imm64, address of jitCharString
+    JIT_HOLE_TARGET,       // rel32, instruction a jump goes to
+    JIT_HOLE_CALL,         // rel32, first instruction of a callee
+    JIT_HOLE_ERROR,        // rel32, runtime error exit of the instruction
+    JIT_HOLE_EXIT,         // rel32, the exit that unwinds a failed run
+} jitHoleKind;
+
+// Hole of a stencil
+typedef struct {
+    uint8_t offset;  // Byte of the stencil the hole starts at
+    uint8_t kind;    // jitHoleKind
+} jitHole;
+
+// Machine code of one operation with holes for its operands, copied as is and then patched
+typedef struct {
+    char   *code;                  // Machine code, the holes are zeroed
+    uint8_t size;                  // Bytes of code
+    uint8_t holeCount;             // Number of holes
+    jitHole holes[JIT_MAX_HOLES];  // Holes
+} jitStencil;
+
+// Stencils, in the order of jitStencils
+typedef enum {
+    JIT_ENTRY = 0,  // Called from C, saves the registers the code takes over and runs the program body
+    JIT_EXIT,       // Unwinds the native stack of a run stopped by a runtime error
+    JIT_PROLOGUE,   // Start of a function
+    JIT_TICK,       // Counts down the fuel, checks the deadline once it runs out
+    JIT_FAIL,       // Runtime error exit of an instruction
+    JIT_HALT,
+    JIT_MOVE,
+    JIT_LOADI,
+    JIT_LOADK,
+    JIT_GETG,
+    JIT_SETG,
+    JIT_FRAME,  // rcx = running frame, the start of a walk up the static links
+    JIT_LINK,   // rcx = static link of rcx
+    JIT_GETUP,
+    JIT_SETUP,
+    JIT_ADDRUP,
+    JIT_ADDR,
+    JIT_ADDRG,
+    JIT_LOADREF,
+    JIT_STOREREF,
+    JIT_ADDI,
+    JIT_SUBI,
+    JIT_MULI,
+    JIT_AND,
+    JIT_OR,
+    JIT_DIVI,
+    JIT_MODI,
+    JIT_ADDIK,
+    JIT_SUBIK,
+    JIT_NEGI,
+    JIT_ADDF,
+    JIT_SUBF,
+    JIT_MULF,
+    JIT_DIVF,
+    JIT_NEGF,
+    JIT_I2F,
+    JIT_EQI,
+    JIT_NEI,
+    JIT_LTI,
+    JIT_LEI,
+    JIT_EQF,
+    JIT_NEF,
+    JIT_LTF,
+    JIT_LEF,
+    JIT_EQS,
+    JIT_NES,
+    JIT_LTS,
+    JIT_LES,
+    JIT_NOT,
+    JIT_CONCAT,
+    JIT_C2S,
+    JIT_JMP,
+    JIT_JMPF,
+    JIT_JMPT,
+    JIT_JLTI,
+    JIT_JLEI,
+    JIT_JEQI,
+    JIT_JNEI,
+    JIT_JLTIK,
+    JIT_JLEIK,
+    JIT_JGTIK,
+    JIT_JGEIK,
+    JIT_JEQIK,
+    JIT_JNEIK,
+    JIT_CALL,    // Checks the frame limits of a call and starts the walk to its static link
+    JIT_ENTER,   // Pushes the frame of a callee and moves to its registers
+    JIT_ZERO,    // Zeroes a register of a callee
+    JIT_ZEROS,   // Zeroes a run of registers of a callee
+    JIT_INVOKE,  // Calls a callee
+    JIT_RESULT,  // Copies the result of a function to the first register of its frame
+    JIT_RET,
+
+    JIT_STENCILS,  // Number of stencils
+} jitStencilId;
+
+// Values the holes of a copied stencil are patched with
+typedef struct {
+    int64_t  a;          // Register `a`
+    int64_t  b;          // Register `b`
+    int64_t  c;          // Register `c`
+    int64_t  immediate;  // Signed immediate
+    uint32_t pc;         // Index of the instruction
+    uint32_t count;      // Registers to zero
+    uint32_t size;       // Bytes of the frame of a callee
+    uint64_t constant;   // Bits of a constant
+    void    *function;   // bcFunction of a callee
+    char    *message;    // Message of a runtime error
+    uint32_t target;     // Index of the instruction a jump goes to
+    uint32_t callee;     // Index of a callee
+    uint32_t error;      // Runtime error exit
+} jitPatch;
+
+// Relative hole patched once the code it points to is written
+typedef struct {
+    uint32_t at;     // Offset of the hole
+    uint8_t  kind;   // JIT_HOLE_TARGET, JIT_HOLE_CALL, JIT_HOLE_ERROR or JIT_HOLE_EXIT
+    uint32_t index;  // Instruction, function or error exit
+} jitFixup;
+
+// Runtime error exit of an instruction, written after the function it belongs to
+typedef struct {
+    uint32_t pc;   // Index of the instruction
+    char    *msg;  // Error
+} jitError;
+
+/*
+State of a run the code reaches through r14, the stencils depend on this layout.
+While the code runs, rbx holds the registers of the running frame, r12 the running vmFrame and r13 the globals.
+*/
+typedef struct {
+    VM      *vm;        // +0, machine whose stack, frames and strings the run uses
+    bcValue *end;       // +8, end of the register stack
+    vmFrame *last;      // +16, last frame
+    void    *stack;     // +24, native stack pointer at the entry, restored by the exit
+    int64_t  fuel;      // +32, loop iterations and calls left before the deadline is checked
+    uint64_t deadline;  // +40, pbNow() the run must end by, 0 for none
+} jitContext;
+
+/*
+Copy-and-patch compiler, writes a compiled program as x86-64 machine code without a compiler round-trip.
+Each bytecode instruction becomes a copy of its stencil, precompiled machine code with holes that are patched with the
+register offsets, constants, jump targets and helper addresses of the instruction.
+The code runs on the registers, frames and strings of a VM, so it stops with the same runtime errors and leaves the
+same globals behind. It's written to writable memory that is made executable once it's done, so no page is ever
+writable and executable at once, and a host whose policy forbids executable mappings runs on the VM instead.
+*/
+typedef struct {
+    bcProgram *program;  // Compiled program, not owned
+
+    uint8_t  *code;             // Machine code, written to the heap and then mapped executable
+    uint32_t  size;             // Bytes of code
+    uint32_t  capacity;         // Allocated bytes
+    uint64_t  mappedSize;       // Bytes of the executable mapping, 0 before it's mapped
+    uint32_t  entry;            // Offset of JIT_ENTRY
+    uint32_t  exit;             // Offset of JIT_EXIT
+    uint32_t *functions;        // Offset of each function
+    uint32_t *instructions;     // Offset of each instruction, the functions one after the other
+    uint32_t  instructionBase;  // Index in instructions of the first instruction of the function being written
+
+    jitFixup *fixups;         // Relative holes of the program
+    uint32_t  fixupSize;      // Number of holes
+    uint32_t  fixupCapacity;  // Allocated slots
+
+    jitError *errors;         // Runtime error exits of the function being written
+    uint32_t  errorSize;      // Number of exits
+    uint32_t  errorCapacity;  // Allocated slots
+    uint32_t *exits;          // Offset of each runtime error exit of the program
+    uint32_t  exitSize;       // Number of exits
+    uint32_t  exitCapacity;   // Allocated slots
+
+    uint64_t compileTime;  // Nanoseconds the compile took
+} Jit;
+
+// JIT_ENTRY, called with the context, the registers of the program body, its frame, the globals and its code
+typedef bool (*jitEntryPoint)(jitContext *context, bcValue *base, vmFrame *frame, bcValue *globals, uint8_t *code);
+
+Jit *jitNew(bcProgram *program);
+void jitFree(Jit *jit);
+bool jitRun(Jit *jit, VM *vm, uint64_t deadline);
+
+void     jitCompileFunction(Jit *jit, uint32_t index);
+void     jitCompileInstruction(Jit *jit, bcFunction *f, uint32_t pc);
+void     jitCompileWalk(Jit *jit, uint32_t links);
+uint32_t jitCopy(Jit *jit, jitStencilId id, jitPatch *patch);
+uint32_t jitErrorExit(Jit *jit, uint32_t pc, char *msg);
+bool     jitResolve(Jit *jit);
+bool     jitMap(Jit *jit);
+
+bool  jitTick(jitContext *context, vmFrame *frame, uint32_t pc);
+void  jitFail(jitContext *context, vmFrame *frame, uint32_t pc, char *msg);
+int   jitCompareStrings(char *left, char *right);
+char *jitCharString(VM *vm, int64_t ch);
+
+#endif  // JIT_H
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+
+#define JS_MAX_DEPTH 512  // Nesting deeper than this is rejected instead of overflowing the stack
+
+typedef enum {
+    JS_NULL = 0,
+    JS_BOOLEAN,
+    JS_NUMBER,
+    JS_STRING,
+    JS_ARRAY,
+    JS_OBJECT,
+} jsType;
+
+// Parsed JSON value, arrays and objects own their items
+typedef struct jsValue {
+    jsType type;
+
+    bool   boolean;
+    double number;
+    char  *string;  // Decoded to UTF-8, null-terminated
+
+    char           **keys;      // Object keys, NULL for arrays
+    struct jsValue **items;     // Array items or object values
+    uint32_t         size;      // Number of items
+    uint32_t         capacity;  // Allocated slots
+} jsValue;
+
+typedef struct {
+    char    *input;
+    uint64_t length;
+    uint64_t position;
+    uint32_t depth;
+} jsParser;
+
+jsValue *jsParse(char *input, uint64_t length);
+void     jsFree(jsValue *v);
+
+jsValue *jsParseValue(jsParser *p);
+jsValue *jsParseArray(jsParser *p);
+jsValue *jsParseObject(jsParser *p);
+char    *jsParseString(jsParser *p);
+bool     jsParseLiteral(jsParser *p, char *literal);
+void     jsSkipWhitespace(jsParser *p);
+jsValue *jsNew(jsType type);
+bool     jsAdd(jsValue *v, char *key, jsValue *item);
+
+jsValue *jsGet(jsValue *object, char *key);
+char    *jsString(jsValue *v);
+int64_t  jsInteger(jsValue *v, int64_t fallback);
+
+void jsAppendString(astString *buffer, char *str);
+
+#endif  // JSON_H
\ No newline at end of file
@@ -4,22 +4,28 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "budget.h"
 #include "error.h"
 #include "token.h"
 
 typedef struct {
-    char       *input;         // input to be tokenized
-    uint32_t    position;      // current position in input (points to current char)
-    uint32_t    readPosition;  // current reading position in input (after current char)
-    char        ch;            // current char under examination
-    HashMap    *keywords;      // keywords hashmap
-    uint16_t    varCounter;    // variable counter
-    uint16_t    litCounter;    // literal counter
-    uint16_t    line;          // current line
-    eErrorList *errors;        // list of errors
+    char        *input;         // input to be tokenized
+    uint64_t     length;        // input length
+    uint64_t     position;      // current position in input (points to current char)
+    uint64_t     readPosition;  // current reading position in input (after current char)
+    char         ch;            // current char under examination
+    HashMap     *keywords;      // keywords hashmap
+    bool         ownsKeywords;  // keywords hashmap is freed with the lexer, shared ones are read-only
+    uint64_t     varCounter;    // variable counter
+    uint64_t     litCounter;    // literal counter
+    uint64_t     line;          // current line
+    uint64_t     lineStart;     // input offset of the current line
+    eErrorList  *errors;        // list of errors
+    ParseBudget *budget;        // limits of the parse, NULL for none
 } Lexer;
 
 Lexer *lNew(char *input);
+Lexer *lNewWithKeywords(char *input, HashMap *keywords);
 void   lFree(Lexer *l);
 
 void lReadChar(Lexer *l);
@@ -28,12 +34,15 @@ void lSkipWhitespace(Lexer *l);
 char lPeekChar(Lexer *l);
 
 Token *lNextToken(Lexer *l);
-Token *lCompoundableToken(Lexer *l, char *nextCh, TokenType singleToken, TokenType *compoundToken);
-
-char     *lReadIdentifier(Lexer *l);
-TokenType lReadNumber(Lexer *l, char **literal);
-TokenType lReadString(Lexer *l, char **literal);
-TokenType lReadCharLiteral(Lexer *l, char **literal);
+void   lScanToken(Lexer *l, TokenSpan *t);
+Token *lSpanToken(Lexer *l, TokenSpan *t);
+void   lSpanLiteral(Lexer *l, TokenSpan *t, char *buffer, uint32_t size);
+void   lCompoundableToken(Lexer *l, char *nextCh, TokenType singleToken, TokenType *compoundToken, TokenSpan *t);
+
+void lReadIdentifier(Lexer *l, TokenSpan *t);
+void lReadNumber(Lexer *l, TokenSpan *t);
+void lReadString(Lexer *l, TokenSpan *t);
+void lReadCharLiteral(Lexer *l, TokenSpan *t);
 
 bool lIsPossibleTerminator(char ch);
 
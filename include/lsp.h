@@ -0,0 +1,110 @@
+#ifndef LSP_H
+#define LSP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "checker.h"
+#include "hashmap.h"
+#include "json.h"
+#include "parser.h"
+#include "token.h"
+
+#define LSP_MAX_MESSAGE (256u << 20)
+#define LSP_MAX_SCOPES  256  // Functions nested deeper than this are searched as if they were at this depth
+
+/*
+Document open in the editor, kept in sync through incremental changes.
+Every change is checked right away, reusing the checks of the functions it didn't touch.
+The tree is only built when a request needs it, and is kept until the next change.
+*/
+typedef struct {
+    char   *uri;
+    int64_t version;
+
+    char    *text;      // Contents, null-terminated
+    uint64_t length;    // Bytes of contents
+    uint64_t capacity;  // Allocated bytes
+
+    uint64_t *lines;         // Offset of the start of every line
+    uint32_t  lineCount;     // Number of lines
+    uint32_t  lineCapacity;  // Allocated slots
+
+    cMemoList  *checks;   // Function checks and diagnostics of the current contents
+    astProgram *program;  // Tree of the last contents without errors, NULL if there were none yet
+    bool        parsed;   // `program` is the tree of the current contents
+} lspDocument;
+
+// Language server over stdio, answers requests in order on a single thread
+typedef struct {
+    FILE *in;
+    FILE *out;
+
+    lspDocument **documents;  // Open documents
+    uint32_t      size;       // Number of documents
+    uint32_t      capacity;   // Allocated slots
+
+    HashMap *keywords;  // Shared keyword table
+    Parser  *tables;    // Shared parser dispatch tables
+
+    bool initialized;  // `initialize` was answered
+    bool shutdown;     // `shutdown` was answered, only `exit` is expected
+} LanguageServer;
+
+// Scopes around the identifier a definition is looked up for
+typedef struct {
+    uint64_t line;    // Line of the identifier
+    uint64_t column;  // Byte column of the identifier
+
+    astProgram      *program;
+    astFunctionStmt *scopes[LSP_MAX_SCOPES];  // Functions around the current node, innermost last
+    uint32_t         depth;                   // Number of functions around the current node
+
+    Token *found;  // Token of the declaration, NULL until found
+    bool   done;   // The identifier was reached
+} lspLookup;
+
+LanguageServer *lspNew(FILE *in, FILE *out);
+void            lspFree(LanguageServer *s);
+int             lspRun(LanguageServer *s);
+
+char *lspReadMessage(LanguageServer *s, uint64_t *length);
+void  lspSend(LanguageServer *s, astString *body);
+void  lspRespond(LanguageServer *s, jsValue *id, char *result);
+void  lspRespondError(LanguageServer *s, jsValue *id, int32_t code, char *message);
+void  lspAppendId(astString *buffer, jsValue *id);
+bool  lspHandle(LanguageServer *s, jsValue *message);
+
+void lspInitialize(LanguageServer *s, jsValue *id);
+void lspDidOpen(LanguageServer *s, jsValue *params);
+void lspDidChange(LanguageServer *s, jsValue *params);
+void lspDidClose(LanguageServer *s, jsValue *params);
+void lspDocumentSymbols(LanguageServer *s, jsValue *id, jsValue *params);
+void lspDefinition(LanguageServer *s, jsValue *id, jsValue *params);
+
+lspDocument *lspDocumentNew(char *uri, char *text, int64_t version);
+void         lspDocumentFree(lspDocument *d);
+lspDocument *lspFindDocument(LanguageServer *s, jsValue *params);
+bool         lspApplyChange(lspDocument *d, jsValue *change);
+void         lspReplace(lspDocument *d, uint64_t start, uint64_t end, char *text);
+void         lspIndexLines(lspDocument *d, uint64_t start, uint64_t end, uint64_t length);
+uint64_t     lspOffset(lspDocument *d, jsValue *position);
+uint64_t     lspCharacter(lspDocument *d, uint64_t line, uint64_t column);
+
+void        lspCheck(LanguageServer *s, lspDocument *d);
+void        lspPublish(LanguageServer *s, lspDocument *d);
+astProgram *lspParse(LanguageServer *s, lspDocument *d);
+
+void lspAppendRange(astString *buffer, lspDocument *d, Token *t);
+void lspAppendSymbol(astString *buffer, lspDocument *d, Token *name, uint32_t kind, char *detail);
+void lspAppendDeclarations(astString *buffer, lspDocument *d, astDeclarationStmt **declarations, uint32_t size);
+void lspAppendBlockSymbols(astString *buffer, lspDocument *d, astBlockStmt *b);
+
+void   lspVisit(lspLookup *lookup, void *node);
+Token *lspResolve(lspLookup *lookup, char *name);
+Token *lspResolveDeclarations(astDeclarationStmt **declarations, uint32_t size, char *name);
+Token *lspResolveBlock(astBlockStmt *b, char *name);
+
+#endif  // LSP_H
\ No newline at end of file
@@ -0,0 +1,232 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "error.h"
+#include "symbols.h"
+#include "types.h"
+
+#define NC_NONE       UINT32_MAX  // No virtual register
+#define NC_INT_REGS   11          // Allocatable general registers, the first NC_SAVED_REGS preserved across calls
+#define NC_SAVED_REGS 5           // rbx and r12 to r15
+#define NC_REAL_REGS  14          // Allocatable xmm registers, none preserved across calls
+#define NC_MAX_CALLS  65535       // Calls in progress, as many as the frames of the VM
+
+// Register class of a virtual register
+typedef enum {
+    NC_INT = 0,  // integer, boolean, char or address, in a general register
+    NC_REAL,     // real, in an xmm register
+} ncClass;
+
+/*
+Instructions of the lowered form, three-address code over unlimited virtual registers.
+`a` is the destination unless noted, `b` and `c` the operands, and `c` is replaced by `imm` when `immediate` is set.
+Memory operands are `base` and `imm`, relative to the frame in `c`, or to the running frame when `c` is NC_NONE.
+*/
+typedef enum {
+    NC_LABEL = 0,  // Label a
+    NC_JUMP,       // Jump to label a
+    NC_BRANCH,     // Jump to label a if b `cc` c holds, or if it doesn't when `inverted` is set
+    NC_MOVE,       // a = b
+    NC_LOADI,      // a = imm
+    NC_LOADF,      // a = real constant imm
+    NC_ADD,        // a = b + c
+    NC_SUB,        // a = b - c
+    NC_MUL,        // a = b * c
+    NC_DIV,        // a = b div c
+    NC_MOD,        // a = b mod c
+    NC_AND,        // a = b and c
+    NC_OR,         // a = b or c
+    NC_XOR,        // a = b xor c, `not` of a boolean
+    NC_NEG,        // a = -b
+    NC_SHL,        // a = b shifted left by imm
+    NC_SAR,        // a = b shifted right by imm, copying the sign bit
+    NC_SHR,        // a = b shifted right by imm, filling with zeros
+    NC_MULHI,      // a = high 64 bits of the 128-bit product of b and imm
+    NC_FADD,       // a = b + c
+    NC_FSUB,       // a = b - c
+    NC_FMUL,       // a = b * c
+    NC_FDIV,       // a = b / c, `imm` set when c is a constant other than zero
+    NC_FNEG,       // a = -b
+    NC_CVT,        // a = real of integer b
+    NC_SET,        // a = b `cc` c
+    NC_LOAD,       // a = memory
+    NC_STORE,      // memory = b
+    NC_ADDR,       // a = address of memory
+    NC_FRAME,      // a = frame imm static links up
+    NC_ARG,        // Outgoing argument imm = b
+    NC_CALL,       // a = call of function imm, NC_NONE for procedures
+    NC_RET,        // Return b, NC_NONE for procedures
+    NC_EXIT,       // End of the program, show the variables of the program
+} ncOp;
+
+// Where a variable lives
+typedef enum {
+    NC_REGISTER = 0,  // Virtual register `imm` of the function declaring it
+    NC_SLOT,          // Slot `imm` of a frame, at -8(imm + 1) from its frame pointer
+    NC_ARG_SLOT,      // Incoming argument `imm` of a frame, at 16 + 8 imm from its frame pointer
+    NC_GLOBAL,        // Variable of the program scope, symbol `imm`
+    NC_DEREF,         // Variable the address in `c` points to
+} ncBase;
+
+// Instruction
+typedef struct {
+    uint8_t  op;         // Opcode
+    uint8_t  cc;         // Comparison of NC_BRANCH and NC_SET, a token type from EQ to GTE
+    uint8_t  base;       // Base of the memory operand
+    bool     real;       // NC_BRANCH and NC_SET compare reals
+    bool     immediate;  // The operand `c` is `imm`
+    bool     inverted;   // NC_BRANCH jumps when the comparison doesn't hold
+    uint32_t a;          // Destination, or label
+    uint32_t b;          // Operand
+    uint32_t c;          // Operand, or frame of the memory operand
+    int64_t  imm;        // Immediate, constant, slot, function or number of static links
+    uint64_t line;       // Source line, for the runtime errors
+} ncInstr;
+
+// Home of a variable symbol
+typedef struct {
+    uint8_t  base;   // NC_REGISTER, NC_SLOT, NC_ARG_SLOT or NC_GLOBAL
+    uint32_t index;  // Virtual register, slot, argument or symbol
+} ncHome;
+
+// Runtime error exit of a function
+typedef struct {
+    uint64_t line;  // Source line
+    char    *msg;   // Error
+} ncStub;
+
+// Function of the program, lowered to a function of its own with its static link as the first argument
+typedef struct {
+    astFunctionStmt *function;   // Function, NULL for the program body
+    char            *name;       // Name, the program name for the program body
+    uint32_t         parent;     // Index of the function it's declared in, 0 for the program scope
+    uint32_t         depth;      // Scope depth of the body, 0 for the program
+    uint32_t         slots;      // Variables in the frame, a nested function or a `var` argument reaches them
+    uint32_t         arguments;  // Incoming arguments, the static link first when the parent isn't the program
+} ncFunction;
+
+// Live range of a virtual register, positions are instruction indices
+typedef struct {
+    uint32_t reg;    // Virtual register
+    uint32_t start;  // First position
+    uint32_t end;    // Last position
+    bool     call;   // A call happens inside the range, so only a preserved register can hold it
+} ncInterval;
+
+/*
+x86-64 native code generator, writes a typed tree as GNU assembler text for the System V ABI.
+Each function is lowered to three-address code over virtual registers, which a linear scan allocator maps to machine
+registers after a liveness analysis, spilling the ranges that end last when it runs out.
+Variables only their own function touches are virtual registers too. The ones a nested function or a `var` argument
+reaches live in the frame, and nested functions find them through static links, like the frames of the VM.
+Integers, reals, booleans and chars are supported, strings are not.
+The program body runs on a stack of its own, large enough for the calls the VM allows, and a call past that limit
+stops the program with the same error.
+*/
+typedef struct {
+    FILE        *out;      // Output
+    TypeChecker *types;    // Types and symbols of the tree
+    astProgram  *program;  // Program being written
+
+    ncFunction *functions;         // Functions, index 0 is the program body
+    uint32_t    size;              // Number of functions
+    uint32_t    functionCapacity;  // Allocated slots
+
+    uint32_t *slots;    // Function index of each function symbol
+    ncHome   *homes;    // Home of each variable symbol, and of the result of each function symbol
+    bool     *escapes;  // Symbols a nested function or a `var` argument reaches
+
+    uint32_t current;  // Function being lowered
+    uint64_t line;     // Line of the statement being lowered
+
+    ncInstr *code;          // Lowered code of the current function
+    uint32_t codeSize;      // Number of instructions
+    uint32_t codeCapacity;  // Allocated slots
+
+    uint8_t *classes;           // Class of each virtual register
+    bool    *variables;         // Virtual registers holding a variable, never retargeted
+    uint32_t registers;         // Number of virtual registers
+    uint32_t registerCapacity;  // Allocated slots
+    uint32_t labels;            // Number of labels
+    uint32_t outgoing;          // Most arguments of a call
+
+    int32_t *locations;  // Machine register of each virtual register, or -1 - spill slot
+    uint32_t spills;     // Spill slots
+    uint32_t spillBase;  // Frame slots before the first spill slot
+    uint32_t saved;      // Preserved registers used, one bit each
+
+    ncStub  *stubs;         // Runtime error exits of the current function
+    uint32_t stubSize;      // Number of exits
+    uint32_t stubCapacity;  // Allocated slots
+    uint32_t largestFrame;  // Largest frame of the functions written, sizes the stack the program runs on
+
+    double  *constants;         // Real constants of the program
+    uint32_t constantSize;      // Number of constants
+    uint32_t constantCapacity;  // Allocated slots
+
+    bool        failed;  // The program uses something the generator doesn't support, reported once
+    eErrorList *errors;  // Unsupported programs
+} Native;
+
+bool ncEmitProgram(TypeChecker *types, astProgram *program, FILE *out, eErrorList *errors);
+
+void ncCollect(Native *g, astBlockStmt *block, uint32_t parent);
+void ncScanBlock(Native *g, astBlockStmt *block, uint32_t index);
+bool ncScanExpression(void *context, astExpression *e);
+void ncScanDeclarations(Native *g, astDeclarationStmt **declarations, uint32_t size);
+void ncPlace(Native *g, uint32_t index);
+void ncPlaceDeclarations(Native *g, astDeclarationStmt **declarations, uint32_t size, uint32_t index);
+
+void     ncLowerFunction(Native *g, uint32_t index);
+void     ncLowerZero(Native *g, uint32_t symbol);
+void     ncLowerStatement(Native *g, astStatement *s);
+void     ncLowerBranch(Native *g, astExpression *condition, bool when, uint32_t label);
+uint32_t ncLowerExpression(Native *g, astExpression *e);
+uint32_t ncLowerConverted(Native *g, astExpression *e, uint32_t type);
+uint32_t ncLowerInfix(Native *g, astInfixExpr *infix);
+bool     ncLowerConstant(Native *g, ncOp op, uint32_t d, uint32_t a, int64_t k);
+void     ncMagic(int64_t divisor, int64_t *magic, uint32_t *shift);
+uint32_t ncLowerCall(Native *g, astIdentifierExpr *callee, astExpression **arguments, uint32_t size);
+uint32_t ncLowerVariable(Native *g, astIdentifierExpr *identifier);
+void     ncLowerAssignment(Native *g, astAssignmentExpr *assignment);
+uint32_t ncLowerAddress(Native *g, astIdentifierExpr *identifier);
+void     ncLocate(Native *g, uint32_t symbol, ncInstr *memory);
+
+uint32_t ncEmit(Native *g, ncOp op, uint32_t a, uint32_t b, uint32_t c);
+uint32_t ncEmitImmediate(Native *g, ncOp op, uint32_t a, uint32_t b, int64_t imm);
+uint32_t ncEmitWide(Native *g, ncOp op, uint32_t a, uint32_t b, int64_t imm);
+uint32_t ncEmitMemory(Native *g, ncOp op, uint32_t reg, ncInstr *memory);
+uint32_t ncRegister(Native *g, ncClass class);
+uint32_t ncLabel(Native *g);
+uint32_t ncConstant(Native *g, double value);
+uint32_t ncTypeOf(Native *g, uint32_t symbol);
+uint32_t ncOwnerOf(Native *g, uint32_t symbol);
+bool     ncIsImmediate(astExpression *e, int64_t *value);
+bool     ncIsConstant(astExpression *e, int64_t *value);
+void     ncError(Native *g, char *msg);
+
+int      ncCompareIntervals(const void *a, const void *b);
+void     ncAllocate(Native *g);
+uint32_t ncUses(ncInstr *in, uint32_t *uses);
+uint32_t ncDefines(ncInstr *in);
+
+void     ncEmitFunction(Native *g, uint32_t index);
+void     ncEmitInstr(Native *g, ncInstr *in);
+void     ncEmitMove(Native *g, char *from, char *to, bool real);
+void     ncEmitBinary(Native *g, ncInstr *in, char *op, bool commutative);
+void     ncEmitCompare(Native *g, ncInstr *in);
+void     ncEmitStub(Native *g, uint64_t line, char *msg);
+void     ncEmitString(Native *g, char *value);
+void     ncEmitGlobals(Native *g);
+uint64_t ncStackSize(Native *g);
+char    *ncLocation(Native *g, uint32_t reg, char *buffer);
+char    *ncOperand(Native *g, ncInstr *in, char *buffer);
+char    *ncAddress(Native *g, ncInstr *in, char *buffer);
+char    *ncCondition(uint8_t cc, bool inverted);
+
+#endif  // NATIVE_H
\ No newline at end of file
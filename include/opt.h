@@ -0,0 +1,111 @@
+#ifndef OPT_H
+#define OPT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "error.h"
+#include "token.h"
+#include "types.h"
+
+// Passes of opOptimize, in the order they run
+typedef enum {
+    OP_FOLD = 0,  // Constant folding and algebraic simplification
+    OP_HOIST,     // Loop-invariant code motion
+    OP_PASSES,    // Number of passes
+} opPass;
+
+// Size of the tree after a pass, and the time the pass took
+typedef struct {
+    uint64_t time;   // Nanoseconds
+    uint64_t nodes;  // Nodes of the tree
+} opStats;
+
+/*
+Line an operand sets for the runtime errors of the operators it's in while it's folded, see exLine.
+A division reports the line the last operator or call inside it set, so an operand that is folded away can move that
+line. An operator that stays takes the line back on its own token, and an operand whose line a division still needs
+is only folded away when the line the division falls back to is the same.
+*/
+typedef struct {
+    bool     consumed;  // A division the operand is inside reports the line it sets
+    uint64_t fallback;  // Line the division falls back to when the operand sets none, 0 if its parent takes it back
+    uint64_t before;    // Line the operand set before folding, 0 if none
+    uint64_t after;     // Line the folded operand sets, 0 if none
+} opContext;
+
+/*
+Optimizer of a typed tree, rewrites it in place before a backend compiles it.
+Folding evaluates operators over literals the way the VM would, wrapping integers and keeping every operand that
+calls, so a backend of the rewritten tree leaves the same globals behind or stops with the same error, on the same
+line. A division by a literal zero stays to stop the runs that reach it, and is reported as a warning.
+Hoisting then moves the expressions a `while` computes the same way on every iteration to temporaries assigned right
+before it. Only the expressions that can't stop the program move, so running them once even when the loop never runs
+changes nothing.
+*/
+typedef struct {
+    TypeChecker *types;    // Symbols and types of the tree
+    astProgram  *program;  // Program, not owned
+
+    opStats  stats[OP_PASSES];  // Size after each pass
+    uint64_t nodes;             // Nodes of the tree before the passes
+    uint64_t folded;            // Operators evaluated over literals
+    uint64_t simplified;        // Operators that were an identity on one operand
+    uint64_t pruned;            // Statements dropped on a constant condition
+    uint64_t hoisted;           // Expressions moved out of loops
+    uint64_t loops;             // Loops expressions were moved out of
+
+    bool     *shared;    // Variables a call or a write through a reference parameter can change, per symbol
+    uint32_t *killed;    // Last loop assigning each variable, per symbol
+    uint32_t  symbols;   // Symbols of the tree without the temporaries, the size of both arrays
+    uint32_t  loop;      // Loop being hoisted from, numbered from 1
+    bool      clobbers;  // The loop calls or writes a shared variable, so every shared one may change
+
+    astBlockStmt    *block;        // Block of the function being hoisted from
+    astVarStmt      *var;          // Its variables, where the temporaries are declared, NULL until there's one
+    astFunctionStmt *scope;        // The function, NULL for the program
+    uint32_t         depth;        // Scope depth of its body
+    uint32_t         temporaries;  // Temporaries declared
+
+    eErrorList *warnings;  // Divisions by zero in source order
+} Optimizer;
+
+Optimizer *opNew(TypeChecker *types, astProgram *program);
+void       opFree(Optimizer *o);
+void       opOptimize(Optimizer *o);
+uint64_t   opCount(void *node);
+
+void           opFoldBlock(Optimizer *o, astBlockStmt *block);
+astStatement  *opFoldStatement(Optimizer *o, astStatement *s);
+astExpression *opFoldExpression(Optimizer *o, astExpression *e, opContext *c);
+astExpression *opFoldPrefix(Optimizer *o, astPrefixExpr *prefix, opContext *c);
+astExpression *opFoldInfix(Optimizer *o, astInfixExpr *infix, opContext *c);
+astExpression *opIdentity(astInfixExpr *infix, bool *right);
+bool           opEvaluate(TokenType op, uint32_t type, bcValue a, bcValue b, bcValue *result);
+
+void               opScanBlock(Optimizer *o, astBlockStmt *block, uint32_t depth);
+void               opScanStatement(Optimizer *o, astStatement *s, uint32_t depth);
+void               opScanExpression(Optimizer *o, astExpression *e, uint32_t depth);
+void               opHoistBlock(Optimizer *o, astBlockStmt *block, astFunctionStmt *scope, uint32_t depth);
+astStatement      *opHoistLoops(Optimizer *o, astStatement *s);
+astStatement      *opHoistLoop(Optimizer *o, astWhileStmt *loop);
+void               opHoistStatement(Optimizer *o, astStatement *s, astBeginEndStmt *header);
+astExpression     *opHoistExpression(Optimizer *o, astExpression *e, opContext *c, astBeginEndStmt *header);
+void               opKillStatement(Optimizer *o, astStatement *s);
+void               opKillExpression(Optimizer *o, astExpression *e);
+bool               opKilled(Optimizer *o, uint32_t symbol);
+bool               opInvariant(Optimizer *o, astExpression *e);
+astIdentifierExpr *opTemporary(Optimizer *o, uint32_t type);
+astIdentifierExpr *opUse(astIdentifierExpr *temporary, Token *at);
+uint64_t           opLine(Optimizer *o, astExpression *e);
+
+bool           opIsLiteral(astExpression *e, bcValue *value);
+bool           opIsZero(astExpression *e);
+bool           opIsOne(astExpression *e);
+astExpression *opLiteral(astExpression *at, uint32_t type, bcValue value);
+astStatement  *opEmpty(Token *at);
+bool           opReplaceable(opContext *c, uint64_t after);
+
+#endif  // OPT_H
\ No newline at end of file
@@ -21,9 +21,18 @@ typedef enum {
     INDEX         // array[index]
 } Precedence;
 
+// Produces the next token, the parser reads straight from the lexer when there's no other source
+typedef Token *(*pTokenSource)(void *ctx);
+
+// Receives a top-level statement of the program block as soon as it's parsed, the statement is freed afterwards
+typedef void (*pStmtSink)(void *ctx, astProgram *program, astStatement *stmt);
+
 typedef struct {
     Lexer *l;
 
+    pTokenSource tokenSource;
+    void        *sourceCtx;
+
     Token *curToken;
     Token *peekToken;
 
@@ -32,14 +41,26 @@ typedef struct {
     HashMap *prefixParseFns;
     HashMap *infixParseFns;
 
+    bool ownsTables;  // Dispatch tables are freed with the parser
+
     eErrorList *errors;
 
-    uint16_t assignCounter;
+    uint32_t assignCounter;
+
+    pStmtSink   stmtSink;
+    void       *sinkCtx;
+    astProgram *program;
+    uint32_t    blockDepth;
 } Parser;
 
 Parser *pNew(Lexer *l);
+Parser *pNewWithSource(Lexer *l, pTokenSource source, void *ctx);
+Parser *pNewTables();
+Parser *pNewShared(Lexer *l, pTokenSource source, void *ctx, Parser *tables);
 void    pFree(Parser *p);
 
+void pAddError(Parser *p, char *error);
+void pBudgetError(Parser *p);
 void pCustomError(Parser *p, char *msg);
 void pPeekError(Parser *p, char *str);
 void pNoPrefixParseFnError(Parser *p, Token *t);
@@ -66,6 +87,10 @@ Precedence pCurPrecedence(Parser *p);
 Precedence pPeekPrecedence(Parser *p);
 
 astProgram *pParseProgram(Parser *p);
+astProgram *pDropProgram(Parser *p, astProgram *program);
+void        pDropToken(Parser *p);
+
+void pBlockAppend(Parser *p, astBlockStmt *b, astStatement *s);
 
 astBlockStmt       *pParseBlockStmt(Parser *p);
 astVarStmt         *pParseVarStmt(Parser *p, bool isGlobal);
@@ -0,0 +1,101 @@
+#ifndef PASCALFRONT_H
+#define PASCALFRONT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+Embeddable front end, the lexer, parser and AST of the analyzer behind opaque handles.
+A context holds the read-only tables every parse shares, so any number of threads can parse with the same context at once.
+A result belongs to the thread that made it until it's handed over, results are never shared behind the caller's back.
+Only the declarations in this header are exported from libpascalfront.
+*/
+
+#define PF_API_VERSION 1  // Bumped when a declaration in this header changes
+
+#if defined(_WIN32)
+#define PF_API __declspec(dllexport)
+#else
+#define PF_API __attribute__((visibility("default")))
+#endif  // _WIN32
+
+typedef struct pfContext pfContext;
+typedef struct pfResult  pfResult;
+
+// Node kinds, in the same order as the analyzer's parse events
+typedef enum {
+    PF_PROGRAM = 0,
+    PF_BLOCK,
+    PF_VAR,
+    PF_DECLARATION,
+    PF_FUNCTION,
+    PF_PARAMETER,
+    PF_BEGIN_END,
+    PF_CONDITIONAL,
+    PF_WHILE,
+    PF_EXPRESSION_STMT,
+    PF_PREFIX,
+    PF_INFIX,
+    PF_ASSIGNMENT,
+    PF_IDENTIFIER,
+    PF_INTEGER,
+    PF_FLOAT,
+    PF_BOOLEAN,
+    PF_STRING,
+    PF_CHAR,
+    PF_TYPE,
+    PF_CALL,
+} pfNodeKind;
+
+/*
+Node handed to the walk callbacks, only valid during the callback.
+Children are visited in a fixed order per kind, a missing child isn't visited and leaves a gap in `index`:
+    PF_PROGRAM          identifier, block
+    PF_BLOCK            statements...
+    PF_VAR              declarations...
+    PF_DECLARATION      type, identifiers...
+    PF_FUNCTION         identifier, return type, block, parameters...
+    PF_PARAMETER        declarations..., `flags` is 1 for reference parameters
+    PF_BEGIN_END        statements...
+    PF_CONDITIONAL      condition, consequence, alternative
+    PF_WHILE            condition, body
+    PF_EXPRESSION_STMT  expression
+    PF_PREFIX           right
+    PF_INFIX            left, right
+    PF_ASSIGNMENT       identifier, value
+    PF_CALL             identifier, arguments...
+Literals have no children.
+*/
+typedef struct {
+    pfNodeKind  kind;
+    const char *literal;   // Token literal, NULL when the node has no token
+    uint64_t    line;      // Token line, 0 when the node has no token
+    uint32_t    index;     // Position among the children of the parent, 0 for the program
+    uint32_t    children;  // Number of child slots, missing children included
+    uint32_t    flags;     // Kind specific
+} pfNode;
+
+// Walk callbacks, `enter` returns false to skip the children of the node, `exit` is called either way
+typedef struct {
+    bool (*enter)(void *ctx, const pfNode *node);
+    void (*exit)(void *ctx, const pfNode *node);
+} pfVisitor;
+
+PF_API uint32_t pfVersion(void);
+
+PF_API pfContext *pfContextNew(void);
+PF_API void       pfContextFree(pfContext *ctx);
+
+PF_API pfResult *pfParse(pfContext *ctx, const char *source, uint64_t length);
+PF_API void      pfResultFree(pfResult *r);
+
+PF_API bool        pfHasTree(pfResult *r);
+PF_API uint32_t    pfErrorCount(pfResult *r);
+PF_API const char *pfError(pfResult *r, uint32_t index);
+
+PF_API char       *pfToString(pfResult *r);
+PF_API void        pfStringFree(char *str);
+PF_API const void *pfSerialize(pfResult *r, uint64_t *length);
+PF_API bool        pfWalk(pfResult *r, const pfVisitor *visitor, void *ctx);
+
+#endif  // PASCALFRONT_H
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lexer.h"
+#include "token.h"
+
+/*
+Lexer running on its own thread, feeding tokens to a single consumer through a lock-free ring.
+The producer waits while the ring is full, so at most `capacity` tokens are ever buffered.
+Once the `EOF` token is handed over the lexer belongs to the consumer again.
+*/
+typedef struct {
+    Lexer *l;
+
+    Token  **ring;      // Token slots, owned by the ring until consumed
+    uint32_t capacity;  // Number of slots, a power of two
+    uint32_t mask;      // capacity - 1
+
+    _Atomic uint64_t head;  // Next slot to write, only written by the producer
+    _Atomic uint64_t tail;  // Next slot to read, only written by the consumer
+    _Atomic bool     stop;  // Asks the producer to give up early
+
+    bool      done;    // EOF already consumed, the consumer reads the lexer directly
+    pthread_t thread;  // Producer thread
+} TokenPipeline;
+
+TokenPipeline *tpNew(Lexer *l, uint32_t capacity);
+void           tpFree(TokenPipeline *tp);
+
+void  *tpProduce(void *arg);
+Token *tpNextToken(void *ctx);
+
+#endif  // PIPELINE_H
\ No newline at end of file
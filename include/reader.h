@@ -0,0 +1,101 @@
+#ifndef READER_H
+#define READER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif  // __linux__
+
+// Source file states, a source is read either by the reader thread or by the worker that needs it first
+typedef enum {
+    SR_PENDING = 0,  // Not read yet
+    SR_READING,      // Being read by the reader thread
+    SR_READY,        // Read, waiting to be taken
+    SR_TAKEN,        // Handed to a worker
+} srState;
+
+typedef struct {
+    char    *path;    // File path, not owned
+    uint64_t size;    // Expected size, the file is read until EOF anyway
+    char    *buffer;  // Contents, NULL if the file couldn't be read
+    uint64_t read;    // Bytes read so far
+    int      fd;      // Open file while it's being read
+
+    _Atomic int state;  // srState
+} srSource;
+
+#ifdef __linux__
+// io_uring submission and completion rings, set up with the raw system calls
+typedef struct {
+    int      fd;
+    uint32_t entries;
+
+    _Atomic uint32_t    *sqHead;
+    _Atomic uint32_t    *sqTail;
+    uint32_t            *sqMask;
+    uint32_t            *sqArray;
+    struct io_uring_sqe *sqes;
+
+    _Atomic uint32_t    *cqHead;
+    _Atomic uint32_t    *cqTail;
+    uint32_t            *cqMask;
+    struct io_uring_cqe *cqes;
+
+    void  *sqRing;
+    void  *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    size_t sqesSize;
+} srRing;
+#endif  // __linux__
+
+/*
+Reads source files ahead of the workers that parse them.
+Reads are submitted in batches through io_uring, or done with plain preads on the reader thread when io_uring isn't available.
+At most `window` files are kept read and not yet taken, a worker that needs a file the reader hasn't reached reads it itself.
+*/
+typedef struct {
+    srSource *sources;  // Files, in the caller's order
+    uint32_t  size;     // Number of files
+    uint32_t *order;    // Order the reader goes through the files in
+    uint32_t  window;   // Files read ahead at most
+
+    uint32_t ahead;  // Files read and not taken, guarded by `lock`
+    bool     stop;   // Asks the reader thread to stop, guarded by `lock`
+
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;  // A file became ready or was taken
+    pthread_t       thread;
+    bool            started;
+
+    bool uring;  // Reads go through io_uring
+#ifdef __linux__
+    srRing ring;
+#endif  // __linux__
+} SourceReader;
+
+SourceReader *srNew(uint32_t size, uint32_t window);
+void          srFree(SourceReader *r);
+
+bool  srStart(SourceReader *r, uint32_t *order);
+char *srTake(SourceReader *r, uint32_t index);
+void  srPublish(SourceReader *r, srSource *s);
+
+void *srReadAhead(void *arg);
+void  srReadAheadSync(SourceReader *r);
+bool  srOpen(srSource *s);
+void  srReadSync(srSource *s);
+char *srReadFile(char *path);
+
+#ifdef __linux__
+bool srRingSetup(srRing *ring, uint32_t entries);
+void srRingFree(srRing *ring);
+void srReadAheadRing(SourceReader *r);
+void srRingSubmitRead(srRing *ring, srSource *s, uint32_t index);
+#endif  // __linux__
+
+#endif  // READER_H
\ No newline at end of file
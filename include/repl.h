@@ -1,9 +1,17 @@
 #ifndef REPL_H
 #define REPL_H
 
+#include <stdbool.h>
+
+#include "ast.h"
 #include "lexer.h"
+#include "types.h"
+
+#define REPL_BUDGET 1000000  // Loop iterations and calls a program runs on the executor before it's compiled
 
-void rStartRepl();
+void rStartRepl(bool optimize);
+void rRun(astProgram *program, bool optimize);
+void rCompile(TypeChecker *y, astProgram *program);
 
 void rLexerNewInput(Lexer *l, char *input);
 void rFreeLexerNoInput(Lexer *l);
@@ -0,0 +1,147 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "budget.h"
+#include "error.h"
+#include "hashmap.h"
+#include "parser.h"
+#include "shard.h"
+
+#define SV_MAGIC       0x31534150  // "PAS1" in little-endian order
+#define SV_MAX_REQUEST (256u << 20)
+
+// Limits of every request, so a single adversarial source can't hold the loop or exhaust the server's memory
+#define SV_MAX_TOKENS    (32u << 20)
+#define SV_MAX_DEPTH     1024
+#define SV_MAX_AST_BYTES (1u << 30)
+#define SV_MAX_ERRORS    1000
+#define SV_TIMEOUT_MS    2000  // Wall-clock time of a request, its check, parse and run together
+#define SV_MAX_REGION    (1u << 30)   // Encoding buffer of a binary response, a larger tree is refused
+#define SV_KEEP_REGION   (64u << 20)  // Largest encoding buffer kept between requests
+
+/*
+Parse requests and responses over a Unix domain socket.
+A request is an svRequest followed by `length` bytes, either a path the server opens or the source itself.
+A response is an svResponse followed by the diagnostics, each one null-terminated, and then the AST.
+A connection can send any number of requests, responses come back in the same order.
+*/
+typedef enum {
+    SV_PATH = 0,  // The payload is a file path, relative to the server's working directory
+    SV_BYTES,     // The payload is the source
+} svSource;
+
+typedef enum {
+    SV_DIAGNOSTICS = 0,  // Only the diagnostics, checked without building the AST
+    SV_TEXT,             // The AST as text, the same text the file mode writes
+    SV_BINARY,           // The AST as a shard region, the program node is the first node after the shHeader
+    SV_RUN,              // The program is type checked and run as machine code, the variables it ends with as text
+} svFormat;
+
+typedef enum {
+    SV_OK = 0,       // No diagnostics, the AST follows
+    SV_ERRORS,       // Diagnostics and no AST
+    SV_BAD_REQUEST,  // Unknown source or format, the diagnostic says which
+} svStatus;
+
+typedef struct {
+    uint32_t magic;    // SV_MAGIC
+    uint8_t  source;   // svSource
+    uint8_t  format;   // svFormat
+    uint16_t padding;
+    uint32_t length;   // Payload bytes, at most SV_MAX_REQUEST
+} svRequest;
+
+typedef struct {
+    uint32_t status;        // svStatus
+    uint32_t errors;        // Number of diagnostics
+    uint64_t errorsLength;  // Bytes of diagnostics
+    uint64_t astLength;     // Bytes of AST
+} svResponse;
+
+// Client connection, requests are read into `input` and answered from `output`
+typedef struct {
+    int      fd;
+    uint32_t index;  // Slot in the server connection list
+
+    char    *input;          // Bytes received and not handled yet
+    uint64_t inputSize;      // Bytes in `input`
+    uint64_t inputCapacity;  // Allocated bytes
+
+    char    *output;          // Response being sent
+    uint64_t outputSize;      // Bytes in `output`
+    uint64_t outputCapacity;  // Allocated bytes
+    uint64_t sent;            // Bytes of `output` already sent
+    bool     writing;         // Waiting for the socket to take the rest of the response
+} svConnection;
+
+/*
+Long-lived parse server, a single epoll loop serving every connection.
+The keyword and dispatch tables are built once and reused by every request,
+which saves the process startup and table setup a run of the analyzer pays per file.
+*/
+typedef struct {
+    char *path;      // Socket path, removed when the server stops
+    int   listener;  // Listening socket
+    int   epoll;     // Event loop
+    int   signals;   // SIGINT and SIGTERM, stop the server
+
+    svConnection **connections;  // Open connections
+    uint32_t       size;         // Number of connections
+    uint32_t       capacity;     // Allocated slots
+
+    HashMap     *keywords;  // Shared keyword table
+    Parser      *tables;    // Shared parser dispatch tables
+    ParseOptions limits;    // Limits of every request, the deadline is set per request
+    uint64_t     requests;  // Requests served
+
+    shHeader *region;          // Encoding buffer of binary responses, reused while it's at most SV_KEEP_REGION
+    uint64_t  regionCapacity;  // Allocated bytes
+} Server;
+
+Server *svNew(char *path);
+void    svFree(Server *s);
+void    svRun(Server *s);
+
+void svAccept(Server *s);
+void svClose(Server *s, svConnection *c);
+void svRead(Server *s, svConnection *c);
+void svProcess(Server *s, svConnection *c);
+bool svFlush(Server *s, svConnection *c);
+void svHandle(Server *s, svConnection *c, svRequest *request, char *payload);
+void svAppend(svConnection *c, void *data, uint64_t length);
+void svRespond(svConnection *c, svStatus status, eErrorList *errors, char *ast, uint64_t astLength);
+void svExecute(svConnection *c, astProgram *program, uint64_t deadline);
+
+//
+// Client side
+//
+
+// Load generator connection, sends its requests one after the other and records their latencies
+typedef struct {
+    char     *path;       // Socket path
+    svFormat  format;     // Requested format
+    char    **sources;    // Sources sent, in turn
+    uint32_t *lengths;    // Source lengths
+    uint32_t  count;      // Number of sources
+    uint32_t  requests;   // Requests to send
+    uint32_t  first;      // Source of the first request, so connections don't all send the same one
+
+    uint64_t *latencies;  // Nanoseconds per request
+    uint32_t  done;       // Requests answered
+    uint32_t  failed;     // Requests with a transport error
+} svLoadWorker;
+
+int  svConnect(char *path);
+bool svSendAll(int fd, void *data, uint64_t length);
+bool svRecvAll(int fd, void *data, uint64_t length);
+bool svRoundTrip(int fd, svRequest *request, char *payload, svResponse *response, char **body);
+
+void *svLoadWork(void *arg);
+int   svLoad(char *path, svFormat format, char **inputs, uint32_t count, uint32_t connections, uint32_t requests);
+int   svCompareLatencies(const void *a, const void *b);
+
+#endif  // SERVER_H
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ast.h"
+#include "batch.h"
+#include "events.h"
+
+/*
+Encoded AST node, stored in a shared region and addressed by its offset from the start of the region.
+Offsets instead of pointers, so the region reads the same wherever it's mapped.
+Children are in a fixed order per kind, a missing child is offset 0:
+    EV_PROGRAM          identifier, block
+    EV_BLOCK            statements...
+    EV_VAR              declarations...
+    EV_DECLARATION      type, identifiers...
+    EV_FUNCTION         identifier, return type, block, parameters...
+    EV_PARAMETER        declarations..., `flags` is 1 for reference parameters
+    EV_BEGIN_END        statements...
+    EV_CONDITIONAL      condition, consequence, alternative
+    EV_WHILE            condition, body
+    EV_EXPRESSION_STMT  expression
+    EV_PREFIX           right
+    EV_INFIX            left, right
+    EV_ASSIGNMENT       identifier, value
+    EV_CALL             identifier, arguments...
+Literals have no children.
+*/
+typedef struct {
+    uint8_t  kind;        // EventKind
+    uint8_t  type;        // TokenType of the node token
+    uint16_t flags;       // Kind specific
+    uint32_t count;       // Number of children
+    uint64_t literal;     // Offset of the token literal, 0 when the node has no token
+    uint64_t line;        // Token line
+    uint64_t children[];  // Offsets of the children
+} shNode;
+
+// File states, a worker marks a file started before parsing it so a crash can be pinned on it
+typedef enum {
+    SH_PENDING = 0,  // Not parsed yet
+    SH_STARTED,      // Being parsed, still started after the worker exits means the worker died on it
+    SH_DONE,         // Parsed, diagnostics and tree are in the region
+    SH_CRASHED,      // The worker died parsing it
+    SH_FULL,         // The region ran out of space
+} shState;
+
+// Result of a file, the tree is only there when the file has no errors
+typedef struct {
+    uint32_t state;    // shState
+    uint32_t errors;   // Number of diagnostics
+    uint64_t error;    // Offset of the diagnostic offsets
+    uint64_t program;  // Offset of the program node
+} shResult;
+
+// Start of a shared region, written by the worker and read by the parent once the worker exited
+typedef struct {
+    uint64_t used;      // Bytes used, the next allocation starts here
+    uint64_t capacity;  // Bytes mapped
+    uint32_t size;      // Number of files in the shard
+    uint32_t next;      // Next file to parse
+    uint32_t full;      // An allocation didn't fit, the file being encoded is dropped
+    uint32_t padding;
+    uint64_t results;   // Offset of the results, one per file
+    uint64_t files;     // Offset of the batch indexes of the files
+} shHeader;
+
+/*
+A shard of the batch, parsed by forked worker processes one at a time.
+A worker that dies only takes the file it was parsing with it, the next worker picks up after that file.
+*/
+typedef struct {
+    shHeader *region;  // Shared region
+    int       fd;      // memfd backing the region, -1 for an anonymous mapping
+    pid_t     pid;     // Running worker, 0 when none
+    int       status;  // Exit status of the last worker
+} Shard;
+
+// Statement sink context, encodes the top-level statements as the parser hands them over
+typedef struct {
+    shHeader *region;
+    uint64_t *statements;  // Offsets of the encoded statements
+    uint32_t  size;        // Number of statements
+    uint32_t  capacity;    // Allocated slots
+} shEncoder;
+
+void shRun(Batch *b, uint32_t workers);
+bool shSpawn(Batch *b, Shard *s);
+void shWork(Batch *b, Shard *s);
+void shParseFile(Batch *b, shHeader *region, uint32_t index, shResult *result);
+void shCrashed(Batch *b, Shard *s);
+void shCollect(Batch *b, Shard *s);
+void shWriteFile(BatchFile *f, shHeader *region, shResult *result);
+
+bool shMap(Shard *s, uint64_t capacity);
+void shUnmap(Shard *s);
+
+void    *shAt(shHeader *region, uint64_t offset);
+uint64_t shAlloc(shHeader *region, uint64_t size);
+uint64_t shEncodeString(shHeader *region, char *str);
+uint64_t shNodeNew(shHeader *region, EventKind kind, Token *token, uint32_t count);
+uint64_t shEncode(shHeader *region, void *node);
+void     shEncodeStatement(void *ctx, astProgram *p, astStatement *s);
+
+void  *shDecode(shHeader *region, uint64_t offset);
+Token *shDecodeToken(shHeader *region, shNode *n);
+Token *shFirstToken(astExpression *e);
+
+#endif  // SHARD_H
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "error.h"
+
+typedef enum {
+    SY_PROGRAM = 0,  // Program name
+    SY_VARIABLE,     // Variable of a `var` block
+    SY_PARAMETER,    // Function parameter
+    SY_FUNCTION,     // Function, also the variable of its result inside it
+    SY_PROCEDURE,    // Procedure
+} syKind;
+
+// Declared name, identifiers are bound to symbols by their index, a symbol fits in a 64-byte cache line
+typedef struct {
+    char    *name;       // Declared name, owned by the tree or by whoever declared it
+    uint32_t hash;       // Hash of the name
+    syKind   kind;       // What declared the name
+    uint32_t depth;      // Scope depth, 0 for the program scope
+    uint32_t shadowed;   // Symbol of the same name this one hides, 0 if none
+    uint32_t typeId;     // Type id set by the type checker, the signature of functions, 0 until checked
+    bool     reference;  // Reference parameter, declared with `var`
+    bool     temporary;  // Variable the optimizer introduced, its name isn't bound and it isn't a program variable
+
+    astIdentifierExpr *identifier;  // Declaring identifier, NULL for a name declared without a tree
+    astTypeExpr       *type;        // Declared type, result type of functions, NULL for procedures and the program
+    astFunctionStmt   *function;    // Function of SY_FUNCTION and SY_PROCEDURE symbols, NULL for the rest
+    astFunctionStmt   *scope;       // Function the symbol is declared in, NULL for the program scope
+} sySymbol;
+
+// Slot of the name table, a slot keeps its name once taken, so probe chains never break
+typedef struct {
+    char    *name;    // Name, NULL for an empty slot
+    uint32_t hash;    // Hash of the name
+    uint32_t symbol;  // Visible symbol of the name, 0 if none is in scope
+} syEntry;
+
+/*
+Symbol table, resolves every identifier of a tree to the symbol of its declaration.
+Each name has one slot in a single open-addressing table, holding the innermost visible symbol of that name.
+Declaring a name logs the symbol in an undo log, and leaving a scope pops the log back to where the scope started,
+restoring the symbols each one hid, so a scope costs the symbols it declares and not the size of the table.
+*/
+typedef struct {
+    syEntry *entries;   // Name table
+    uint32_t names;     // Taken slots
+    uint32_t capacity;  // Slots, a power of two
+
+    sySymbol *symbols;         // Declared symbols, index 0 is never used
+    uint32_t  size;            // Number of symbols, the unused one included
+    uint32_t  symbolCapacity;  // Allocated slots
+
+    uint32_t *undo;          // Symbols declared in the open scopes, innermost last
+    uint32_t  undoSize;      // Number of symbols in the log
+    uint32_t  undoCapacity;  // Allocated slots
+
+    uint32_t         depth;  // Current scope depth
+    astFunctionStmt *scope;  // Function of the current scope, NULL for the program scope
+
+    uint64_t    uses;    // Identifier uses resolved, including the unresolved ones
+    eErrorList *errors;  // Undeclared and redeclared names
+} SymbolTable;
+
+SymbolTable *syNew();
+void         syFree(SymbolTable *t);
+
+bool      syResolve(SymbolTable *t, astProgram *program);
+sySymbol *sySymbolOf(SymbolTable *t, astIdentifierExpr *identifier);
+
+void syResolveBlock(SymbolTable *t, astBlockStmt *block);
+void syResolveFunction(SymbolTable *t, astFunctionStmt *function);
+void syResolveDeclarations(SymbolTable *t, astDeclarationStmt **declarations, uint32_t size, syKind kind,
+                           bool reference);
+void syResolveNode(SymbolTable *t, void *node);
+void syUse(SymbolTable *t, astIdentifierExpr *identifier);
+
+uint32_t syDeclare(SymbolTable *t, astIdentifierExpr *identifier, syKind kind, astTypeExpr *type);
+uint32_t syDeclareName(SymbolTable *t, char *name, uint64_t line, syKind kind);
+uint32_t syTemporary(SymbolTable *t, astIdentifierExpr *identifier, astTypeExpr *type, uint32_t depth,
+                     astFunctionStmt *scope);
+uint32_t syLookup(SymbolTable *t, char *name);
+uint32_t syEnter(SymbolTable *t);
+void     syLeave(SymbolTable *t, uint32_t mark);
+
+syEntry *syFind(SymbolTable *t, char *name, uint32_t hash);
+void     syGrow(SymbolTable *t);
+uint32_t syHash(char *name);
+
+#endif  // SYMBOLS_H
\ No newline at end of file
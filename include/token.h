@@ -96,8 +96,19 @@ typedef enum {
 typedef struct {
     TokenType type;
     char     *literal;
+    uint64_t  line;    // line the lexer was on after reading the token
+    uint64_t  column;  // bytes from the start of the line to the token
 } Token;
 
+// Token that doesn't own its literal, the literal is a slice of the lexer input
+typedef struct {
+    TokenType type;
+    uint64_t  start;   // literal offset in the input
+    uint64_t  length;  // literal length
+    uint64_t  line;    // line the lexer was on after reading the token
+    uint64_t  column;  // bytes from the start of the line to the token
+} TokenSpan;
+
 Token *tNewToken(TokenType type, char *literal);
 void   tFreeToken(Token *t);
 
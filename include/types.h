@@ -0,0 +1,92 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "error.h"
+#include "symbols.h"
+#include "token.h"
+
+#define TY_REFERENCE 0x80000000u  // Set on the parameter types of a signature that are passed by reference
+
+// Type ids of the builtin types, signatures are interned after them
+typedef enum {
+    TY_NONE = 0,  // Not checked yet
+    TY_ERROR,     // Ill-typed, already reported, accepted anywhere so one error doesn't cascade
+    TY_VOID,      // No value, the type of procedure calls and assignments
+    TY_INTEGER,   // integer
+    TY_REAL,      // real
+    TY_BOOLEAN,   // boolean
+    TY_CHAR,      // char
+    TY_STRING,    // string
+    TY_BUILTINS,  // Id of the first signature
+} tyBuiltin;
+
+// Signature of a function or procedure, equal signatures share one type id
+typedef struct {
+    uint32_t  result;      // Result type, TY_VOID for procedures
+    uint32_t *parameters;  // Parameter types, TY_REFERENCE set on the reference ones
+    uint32_t  size;        // Number of parameters
+    uint32_t  hash;        // Hash of the result and parameter types
+} tySignature;
+
+/*
+Type checker, types a tree in a single walk that also resolves its names.
+Every expression node caches its type id, and every symbol the type id of its declaration, so a use of a name costs a
+lookup in the symbol table and nothing else. Types are told apart by id, never by name: declared types come from the
+token of their type expression, and signatures are interned, so two signatures are equal only if their ids are.
+*/
+typedef struct {
+    SymbolTable *symbols;  // Scopes and bindings, resolved in the same walk
+
+    tySignature *signatures;         // Interned signatures, the id of each one is TY_BUILTINS plus its index
+    uint32_t     size;               // Number of signatures
+    uint32_t     signatureCapacity;  // Allocated slots
+
+    uint32_t *slots;         // Signature ids by hash, open addressing, 0 for an empty slot
+    uint32_t  slotCapacity;  // Slots, a power of two
+
+    uint32_t *parameters;         // Parameter types of the signature being built
+    uint32_t  parameterCapacity;  // Allocated slots
+
+    astFunctionStmt **functions;         // Functions being checked, innermost last
+    uint32_t          depth;             // Number of functions being checked
+    uint32_t          functionCapacity;  // Allocated slots
+
+    uint64_t    expressions;  // Expressions typed
+    eErrorList *errors;       // Name and type errors in source order, owned by the symbol table
+} TypeChecker;
+
+TypeChecker *tyNew();
+void         tyFree(TypeChecker *y);
+
+bool tyCheck(TypeChecker *y, astProgram *program);
+
+void     tyCheckBlock(TypeChecker *y, astBlockStmt *block);
+void     tyCheckBlockStatement(TypeChecker *y, astStatement *s);
+void     tyCheckFunction(TypeChecker *y, astFunctionStmt *function);
+void     tyCheckDeclarations(TypeChecker *y, astDeclarationStmt **declarations, uint32_t size, syKind kind,
+                             bool reference);
+void     tyCheckStatement(TypeChecker *y, astStatement *s);
+void     tyCheckCondition(TypeChecker *y, astExpression *condition);
+uint32_t tyCheckExpression(TypeChecker *y, astExpression *e);
+uint32_t tyCheckPrefix(TypeChecker *y, astPrefixExpr *prefix);
+uint32_t tyCheckInfix(TypeChecker *y, astInfixExpr *infix);
+uint32_t tyCheckAssignment(TypeChecker *y, astAssignmentExpr *assignment);
+uint32_t tyCheckIdentifier(TypeChecker *y, astIdentifierExpr *identifier);
+uint32_t tyCheckCallExpr(TypeChecker *y, astCallExpr *call);
+uint32_t tyCheckCall(TypeChecker *y, astIdentifierExpr *callee, astExpression **arguments, uint32_t size);
+void     tyCheckArgument(TypeChecker *y, astIdentifierExpr *callee, uint32_t index, uint32_t parameter,
+                         astExpression *argument);
+
+uint32_t     tyOfTypeExpr(astTypeExpr *type);
+uint32_t     tyOperator(TokenType op, uint32_t left, uint32_t right);
+bool         tyAssignable(uint32_t target, uint32_t value);
+bool         tyIsOpen(TypeChecker *y, astFunctionStmt *function);
+uint32_t     tyIntern(TypeChecker *y, uint32_t result, uint32_t *parameters, uint32_t size);
+tySignature *tySignatureOf(TypeChecker *y, uint32_t type);
+char        *tyName(uint32_t type);
+
+#endif  // TYPES_H
\ No newline at end of file
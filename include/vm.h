@@ -0,0 +1,55 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bytecode.h"
+
+#define VM_STACK_SIZE (1u << 20)  // Registers shared by every frame, 8 MiB
+#define VM_MAX_FRAMES (1u << 16)  // Calls in progress
+
+// Dispatch through a table of label addresses where the compiler has them, through a switch otherwise
+#if defined(__GNUC__) && !defined(VM_SWITCH_DISPATCH)
+#define VM_COMPUTED_GOTO
+#endif
+
+// Frame of a call in progress
+typedef struct vmFrame {
+    bcFunction     *function;  // Function running in the frame
+    bcInstr        *ip;        // Instruction to resume once the call the frame made returns
+    bcValue        *base;      // First register
+    struct vmFrame *link;      // Frame of the function the running one is declared in, the static link
+} vmFrame;
+
+/*
+Register virtual machine, runs a compiled program.
+Every frame is a window of one fixed stack of registers, so a call passes its arguments by placing them where the
+callee's frame starts, and the addresses taken for reference parameters stay valid for the whole run.
+*/
+typedef struct {
+    bcProgram *program;  // Program being run, not owned
+    bcValue   *stack;    // Registers, the program frame comes first so its registers are the globals
+    vmFrame   *frames;   // Calls in progress, the program body first
+
+    char   **strings;         // Strings built while running, freed with the machine
+    uint32_t stringSize;      // Number of strings
+    uint32_t stringCapacity;  // Allocated slots
+
+    uint64_t    executed;  // Instructions run, only counted when built with VM_COUNT
+    eErrorList *errors;    // Runtime error, the run stops at the first one
+} VM;
+
+VM  *vmNew(bcProgram *program);
+void vmFree(VM *vm);
+
+bool  vmRun(VM *vm);
+char *vmString(VM *vm, char *left, char *right);
+void  vmError(VM *vm, vmFrame *frame, bcInstr *ip, char *msg);
+void  vmPrintGlobals(VM *vm, FILE *out);
+
+void   vmBenchmark(FILE *out, uint64_t iterations);
+double vmBenchmarkOp(bcOp op, uint32_t a, uint32_t b, uint32_t c, uint64_t iterations);
+
+#endif  // VM_H
\ No newline at end of file
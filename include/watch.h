@@ -0,0 +1,76 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "error.h"
+#include "hashmap.h"
+#include "parser.h"
+
+#define WT_QUIET_MS 5  // Events closer together than this are handled in the same round
+
+// Source file kept in memory, with the tree and diagnostics of its last contents
+typedef struct {
+    char    *path;
+    uint64_t hash;     // Hash of the last contents checked
+    bool     checked;  // `hash`, `program` and `errors` are set
+
+    astProgram *program;  // Tree of the last contents, NULL if they had errors
+    eErrorList *errors;   // Diagnostics of the last contents
+    bool        pending;  // Changed since it was last checked
+} wtFile;
+
+// Directory watched for changes
+typedef struct {
+    int   wd;  // inotify watch descriptor
+    char *path;
+} wtDirectory;
+
+/*
+Watch mode, every `.pas` file of a directory tree is parsed once and kept in memory.
+inotify reports the files that were written, moved or removed, and only those are checked again.
+Events that arrive together are coalesced, so a file saved in several steps is only checked once per round.
+*/
+typedef struct {
+    char *root;
+    int   inotify;  // Change notifications
+    int   signals;  // SIGINT and SIGTERM, stop watching
+
+    wtFile  *files;     // Known files, sorted by path
+    uint32_t size;      // Number of files
+    uint32_t capacity;  // Allocated slots
+
+    wtDirectory *directories;        // Watched directories, sorted by watch descriptor
+    uint32_t     directoryCount;     // Number of directories
+    uint32_t     directoryCapacity;  // Allocated slots
+
+    HashMap *keywords;  // Shared keyword table
+    Parser  *tables;    // Shared parser dispatch tables
+    uint32_t failed;    // Files whose last contents had errors
+    bool     rescan;    // Events were dropped, every directory must be walked again
+} Watcher;
+
+Watcher *wtNew(char *root);
+void     wtFree(Watcher *w);
+void     wtRun(Watcher *w);
+
+void     wtAddDirectory(Watcher *w, char *dir);
+uint32_t wtFindDirectory(Watcher *w, int wd);
+void     wtRemoveDirectory(Watcher *w, uint32_t index);
+void     wtDropDirectory(Watcher *w, char *dir);
+wtFile  *wtFind(Watcher *w, char *path, bool create);
+void     wtRemove(Watcher *w, uint32_t index);
+uint32_t wtLowerBound(Watcher *w, char *path);
+
+bool     wtRead(Watcher *w);
+bool     wtEvent(Watcher *w, int wd, uint32_t mask, char *name);
+uint32_t wtCheckPending(Watcher *w, bool report);
+bool     wtCheckFile(Watcher *w, wtFile *f, char *input);
+void     wtReport(wtFile *f);
+void     wtClear(Watcher *w, wtFile *f);
+uint64_t wtHash(char *data);
+double   wtMilliseconds(void);
+
+#endif  // WATCH_H
\ No newline at end of file
@@ -2,38 +2,268 @@
 // Desenvolvido com Linux Fedora 39 - Kernel 6.8.10-200.x86_64
 // Compilador Clang 17.0.6 x86_64
 
+#include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif  // _WIN32
 
 #include "ast.h"
+#include "bytecode.h"
+#include "cgen.h"
+#include "checker.h"
+#include "direct.h"
+#include "exec.h"
+#include "ir.h"
+#include "jit.h"
 #include "lexer.h"
+#include "lsp.h"
+#include "native.h"
+#include "opt.h"
 #include "parser.h"
 #include "repl.h"
+#include "symbols.h"
+#include "types.h"
+#include "vm.h"
+
+// Threads, mmap, fork, io_uring and Unix sockets, the modes that use them are stubbed on Windows
+#ifndef _WIN32
+#include "batch.h"
+#include "pipeline.h"
+#include "reader.h"
+#include "server.h"
+#include "shard.h"
+#include "watch.h"
+#endif  // _WIN32
 
-char *stringFromFile(char *filename);
+char      *stringFromFile(char *filename);
+int        parseFile(char *inputFile, char *outputFile, bool pipelined);
+int        checkFiles(int count, char *files[]);
+int        resolveFiles(int count, char *files[], bool typed);
+int        runFile(char *file, bool jit, bool optimize);
+Optimizer *optimizeTree(char *file, TypeChecker *y, astProgram *program);
+int        runDirect(char *file);
+int        runTree(char *file, bool optimize);
+int        ssaFiles(int count, char *files[], bool dump);
+int        optFiles(int count, char *files[], bool dump);
+int        emitFile(char *inputFile, char *outputFile, bool native, bool optimize);
+int        batchFiles(int count, char *inputs[], bool isolated);
+int        serve(char *path);
+int        loadServer(int count, char *args[]);
+int        languageServer();
+int        watchDirectory(char *dir);
 
 int main(int argc, char *argv[]) {
+    // -O right after the mode optimizes the tree before it's compiled, written or run
+    bool optimize = argc > 2 && strcmp(argv[2], "-O") == 0;
+
+    if (argc > 2 && strcmp(argv[1], "--check") == 0) {
+        return checkFiles(argc - 2, argv + 2);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--resolve") == 0) {
+        return resolveFiles(argc - 2, argv + 2, false);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--types") == 0) {
+        return resolveFiles(argc - 2, argv + 2, true);
+    }
+
+    if (argc == 3 + optimize && strcmp(argv[1], "--run") == 0) {
+        return runFile(argv[2 + optimize], false, optimize);
+    }
+
+    if (argc == 3 + optimize && strcmp(argv[1], "--jit") == 0) {
+        return runFile(argv[2 + optimize], true, optimize);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--run-opt") == 0) {
+        return runFile(argv[2], false, true);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--direct") == 0) {
+        return runDirect(argv[2]);
+    }
+
+    if (argc == 3 + optimize && strcmp(argv[1], "--interp") == 0) {
+        return runTree(argv[2 + optimize], optimize);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--ssa") == 0) {
+        return ssaFiles(argc - 2, argv + 2, false);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--ssa-dump") == 0) {
+        return ssaFiles(1, argv + 2, true);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--opt") == 0) {
+        return optFiles(argc - 2, argv + 2, false);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--opt-dump") == 0) {
+        return optFiles(1, argv + 2, true);
+    }
+
+    if (argc == 4 + optimize && strcmp(argv[1], "--emit-c") == 0) {
+        return emitFile(argv[2 + optimize], argv[3 + optimize], false, optimize);
+    }
+
+    if (argc == 4 + optimize && strcmp(argv[1], "--emit-asm") == 0) {
+        return emitFile(argv[2 + optimize], argv[3 + optimize], true, optimize);
+    }
+
+    if ((argc == 2 || argc == 3) && strcmp(argv[1], "--vm-bench") == 0) {
+        vmBenchmark(stdout, argc == 3 ? strtoull(argv[2], NULL, 10) : 10000000);
+        return 0;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+        return batchFiles(argc - 2, argv + 2, false);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--shards") == 0) {
+        return batchFiles(argc - 2, argv + 2, true);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0) {
+        return serve(argv[2]);
+    }
+
+    if (argc > 3 && strcmp(argv[1], "--load") == 0) {
+        return loadServer(argc - 2, argv + 2);
+    }
+
+    if (argc == 2 && strcmp(argv[1], "--lsp") == 0) {
+        return languageServer();
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--watch") == 0) {
+        return watchDirectory(argv[2]);
+    }
+
+    if (argc == 4 && strcmp(argv[1], "--pipeline") == 0) {
+#ifndef _WIN32
+        return parseFile(argv[2], argv[3], true);
+#else
+        printf("Pipeline indisponivel no Windows\n");
+        return 1;
+#endif  // _WIN32
+    }
+
     if (argc == 1 || (argc != 3 && argc != 2)) {
         printf(
             "Ajuda\n"
             "Uso arquivo: %s <entrada> <saida> <configuração>\n"
             "entrada: arquivo de entrada\n"
             "saida: arquivo de saida\n"
-            "\n\nUso REPL: %s repl\n",
+            "\n\nUso verificação: %s --check <entrada>...\n"
+            "Apenas verifica a sintaxe, sem construir a árvore sintática\n"
+            "\n\nUso resolução: %s --resolve <entrada>...\n"
+            "Verifica se cada identificador usado foi declarado e se nenhum nome é declarado duas vezes no mesmo escopo\n"
+            "\n\nUso tipos: %s --types <entrada>...\n"
+            "Igual ao uso resolução, verificando também os tipos de cada expressão, atribuição e chamada\n"
+            "\n\nUso execução: %s --run [-O] <entrada>\n"
+            "Compila o programa para bytecode, executa na máquina virtual e mostra as variáveis do programa\n"
+            "-O: otimiza a árvore sintática antes de compilar, também aceito por --jit, --interp, --emit-c, --emit-asm "
+            "e repl\n"
+            "\n\nUso JIT: %s --jit [-O] <entrada>\n"
+            "Igual ao uso execução, com o bytecode compilado para código de máquina x86-64 antes de executar\n"
+            "\n\nUso execução otimizada: %s --run-opt <entrada>\n"
+            "Igual ao uso execução com -O\n"
+            "\n\nUso direto: %s --direct <entrada>\n"
+            "Igual ao uso execução, compilando para bytecode durante a análise, sem construir a árvore sintática, "
+            "que por isso não é otimizada\n"
+            "\n\nUso interpretação: %s --interp [-O] <entrada>\n"
+            "Igual ao uso execução, executando a árvore sintática sem compilar, cada nó convertido ao ser executado\n"
+            "\n\nUso SSA: %s --ssa <entrada>...\n"
+            "Constrói a forma SSA de cada programa, otimiza e mostra o tempo e o tamanho após cada etapa\n"
+            "\n\nUso SSA detalhado: %s --ssa-dump <entrada>\n"
+            "Igual ao uso SSA, mostrando também as instruções de cada função após as otimizações\n"
+            "\n\nUso otimização: %s --opt <entrada>...\n"
+            "Dobra as constantes e simplifica a árvore sintática de cada programa, mostra o tamanho após cada etapa\n"
+            "\n\nUso otimização detalhada: %s --opt-dump <entrada>\n"
+            "Igual ao uso otimização, mostrando também a árvore sintática otimizada\n"
+            "\n\nUso C: %s --emit-c [-O] <entrada> <saida>\n"
+            "Traduz o programa para C99, que ao final mostra as variáveis do programa como no uso execução\n"
+            "\n\nUso nativo: %s --emit-asm [-O] <entrada> <saida>\n"
+            "Gera assembly x86-64 do GNU as, montado com cc, para programas sem strings\n"
+            "\n\nUso medição: %s --vm-bench [iterações]\n"
+            "Mede o tempo de cada instrução da máquina virtual\n"
+            "\n\nUso pipeline: %s --pipeline <entrada> <saida>\n"
+            "Igual ao uso arquivo, com a análise léxica em uma thread separada\n"
+            "\n\nUso lote: %s --batch [-j <threads>] <entrada>...\n"
+            "entrada: arquivo, diretório ou padrão glob, cada árvore é escrita em <arquivo>.ast\n"
+            "\n\nUso lote isolado: %s --shards [-j <processos>] <entrada>...\n"
+            "Igual ao uso lote, cada grupo de arquivos é analisado em um processo separado\n"
+            "\n\nUso servidor: %s --serve <socket>\n"
+            "Atende pedidos de análise em um socket Unix até receber SIGINT ou SIGTERM\n"
+            "\n\nUso carga: %s --load <socket> [-c <conexões>] [-n <pedidos>] [-f diag|text|binary|run] <entrada>...\n"
+            "Envia as entradas ao servidor e mostra a latência p50 e p99\n"
+            "\n\nUso editor: %s --lsp\n"
+            "Servidor Language Server Protocol na entrada e saída padrão\n"
+            "\n\nUso observação: %s --watch <diretório>\n"
+            "Analisa os arquivos .pas do diretório e reanalisa cada arquivo alterado até receber SIGINT ou SIGTERM\n"
+            "\n\nUso REPL: %s repl [-O]\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
             argv[0], argv[0]);
         return 1;
     }
 
     if (strcmp(argv[1], "repl") == 0) {
-        rStartRepl();
+        rStartRepl(optimize);
         return 0;
     }
 
+    return parseFile(argv[1], argv[2], false);
+}
+
+// Parse a file and write its AST to the output file
+int parseFile(char *inputFile, char *outputFile, bool pipelined) {
     // Would probably have been better to just read the file directly in the lexer
-    char       *input   = stringFromFile(argv[1]);
-    Lexer      *l       = lNew(input);
-    Parser     *p       = pNew(l);
+    char  *input = stringFromFile(inputFile);
+    Lexer *l     = lNew(input);
+
+    // The tree streams to a file next to the output, which replaces it only once the whole program parsed
+    char *temporary = (char *)malloc(strlen(outputFile) + sizeof(".tmp"));
+    sprintf(temporary, "%s.tmp", outputFile);
+
+    FILE *file = fopen(temporary, "w");
+    if (!file) {
+        printf("Nao foi possivel abrir o arquivo %s\n", outputFile);
+        free(temporary);
+        lFree(l);
+        return 1;
+    }
+
+    // The lexer runs ahead on its own thread, the parser consumes its tokens as they're ready
+#ifndef _WIN32
+    TokenPipeline *tp = NULL;
+    Parser        *p  = NULL;
+    if (pipelined) {
+        tp = tpNew(l, 4096);
+    }
+
+    if (tp) {
+        p = pNewWithSource(l, tpNextToken, tp);
+    } else {
+        p = pNew(l);
+    }
+#else
+    Parser *p = pNew(l);
+#endif  // _WIN32
+
+    // Each top-level procedure is written and freed as soon as it's parsed
+    astTextSink *sink = astTextSinkNew(file);
+    p->stmtSink       = astTextSinkStatement;
+    p->sinkCtx        = sink;
+
     astProgram *program = pParseProgram(p);
 
     if (p->errors->size > 0) {
@@ -41,46 +271,742 @@ int main(int argc, char *argv[]) {
             printf("Erro %04d: %s\n", i + 1, p->errors->data[i]);
         }
 
+        fclose(file);
+        remove(temporary);
+        free(temporary);
+
+        astTextSinkFree(sink);
+        astProgramFree(program);
+#ifndef _WIN32
+        if (tp) {
+            tpFree(tp);
+        }
+#endif  // _WIN32
+        lFree(l);
+        pFree(p);
+
+        return 1;
+    }
+
+    astTextSinkEnd(sink);
+    fprintf(file, "\n");
+
+    // rename doesn't replace an existing file on Windows
+    bool written = fclose(file) == 0;
+#ifdef _WIN32
+    remove(outputFile);
+#endif
+    written = written && rename(temporary, outputFile) == 0;
+    if (!written) {
+        printf("Nao foi possivel escrever o arquivo %s\n", outputFile);
+        remove(temporary);
+    } else {
+        printf("Programa analisado com sucesso!\n");
+    }
+    free(temporary);
+
+    astTextSinkFree(sink);
+    astProgramFree(program);
+#ifndef _WIN32
+    if (tp) {
+        tpFree(tp);
+    }
+#endif  // _WIN32
+    lFree(l);
+    pFree(p);
+
+    return written ? 0 : 1;
+}
+
+// Check the syntax of each file, printing only the errors
+int checkFiles(int count, char *files[]) {
+    int failed = 0;
+
+    for (int i = 0; i < count; i++) {
+        char    *input = stringFromFile(files[i]);
+        Lexer   *l     = lNew(input);
+        Checker *c     = cNew(l);
+
+        if (!cCheckProgram(c)) {
+            for (uint32_t j = 0; j < c->errors->size; j++) {
+                printf("%s: Erro %04d: %s\n", files[i], j + 1, c->errors->data[j]);
+            }
+            failed++;
+        }
+
+        cFree(c);
+        lFree(l);
+    }
+
+    if (failed > 0) {
+        printf("%d de %d arquivo(s) com erros\n", failed, count);
+        return 1;
+    }
+
+    printf("%d arquivo(s) verificado(s) com sucesso!\n", count);
+
+    return 0;
+}
+
+// Parse each file and bind its identifiers to their declarations, printing only the errors
+// Typed files are also type checked, in the same walk that binds their identifiers
+int resolveFiles(int count, char *files[], bool typed) {
+    int failed = 0;
+
+    for (int i = 0; i < count; i++) {
+        char   *input = stringFromFile(files[i]);
+        Lexer  *l     = lNew(input);
+        Parser *p     = pNew(l);
+
+        astProgram *program = pParseProgram(p);
+        eErrorList *errors  = p->errors;
+
+        // Names are only resolved in a tree without syntax errors
+        SymbolTable *t = NULL;
+        TypeChecker *y = NULL;
+        if (errors->size == 0 && typed) {
+            y = tyNew();
+            tyCheck(y, program);
+            errors = y->errors;
+        } else if (errors->size == 0) {
+            t = syNew();
+            syResolve(t, program);
+            errors = t->errors;
+        }
+
+        if (errors->size > 0) {
+            for (uint32_t j = 0; j < errors->size; j++) {
+                printf("%s: Erro %04d: %s\n", files[i], j + 1, errors->data[j]);
+            }
+            failed++;
+        }
+
+        if (t) {
+            syFree(t);
+        }
+        if (y) {
+            tyFree(y);
+        }
         astProgramFree(program);
         lFree(l);
         pFree(p);
+    }
 
+    if (failed > 0) {
+        printf("%d de %d arquivo(s) com erros\n", failed, count);
         return 1;
     }
 
-    FILE *file = fopen(argv[2], "w");
+    printf("%d arquivo(s) resolvido(s) com sucesso!\n", count);
 
-    fprintf(file, "%s\n", astProgramToString(program));
+    return 0;
+}
 
-    fclose(file);
+// Parse, type check and compile a file, then run it and print the variables of the program
+// With `jit` the bytecode runs as machine code, or on the virtual machine when the host can't run it
+// With `optimize` the tree is optimized before it's compiled
+int runFile(char *file, bool jit, bool optimize) {
+    char   *input = stringFromFile(file);
+    Lexer  *l     = lNew(input);
+    Parser *p     = pNew(l);
 
-    printf("Programa analisado com sucesso!\n");
+    astProgram *program = pParseProgram(p);
+    eErrorList *errors  = p->errors;
 
+    // Only a well-typed tree is compiled, the compiler trusts the types cached on it
+    TypeChecker *y  = NULL;
+    Optimizer   *o  = NULL;
+    bcProgram   *bc = NULL;
+    VM          *vm = NULL;
+    if (errors->size == 0) {
+        y = tyNew();
+        tyCheck(y, program);
+        errors = y->errors;
+    }
+    if (errors->size == 0 && optimize) {
+        o = optimizeTree(file, y, program);
+    }
+    if (errors->size == 0) {
+        bc = bcCompile(y, program, errors);
+    }
+    if (bc) {
+        vm = vmNew(bc);
+
+        Jit *code = jit ? jitNew(bc) : NULL;
+        if (jit && !code) {
+            fprintf(stderr, "JIT indisponível, executando na máquina virtual\n");
+        }
+        if (code) {
+            fprintf(stderr, "JIT: %" PRIu32 " bytes de código de máquina em %.1f µs\n", code->size,
+                    code->compileTime / 1000.0);
+        }
+
+        if (code ? !jitRun(code, vm, 0) : !vmRun(vm)) {
+            errors = vm->errors;
+        }
+        if (code) {
+            jitFree(code);
+        }
+#ifdef VM_COUNT
+        fprintf(stderr, "Execução: %" PRIu64 " instruções\n", vm->executed);
+#endif
+    }
+
+    int failed = errors->size > 0;
+    for (uint32_t j = 0; j < errors->size; j++) {
+        printf("%s: Erro %04d: %s\n", file, j + 1, errors->data[j]);
+    }
+    if (!failed) {
+        vmPrintGlobals(vm, stdout);
+    }
+
+    if (vm) {
+        vmFree(vm);
+    }
+    if (bc) {
+        bcFree(bc);
+    }
+    if (o) {
+        opFree(o);
+    }
+    if (y) {
+        tyFree(y);
+    }
     astProgramFree(program);
     lFree(l);
     pFree(p);
 
-    return 0;
+    return failed;
+}
+
+// Optimize a well-typed tree in place, printing the warnings and the time the passes took to stderr
+Optimizer *optimizeTree(char *file, TypeChecker *y, astProgram *program) {
+    Optimizer *o = opNew(y, program);
+    opOptimize(o);
+    for (uint32_t j = 0; j < o->warnings->size; j++) {
+        fprintf(stderr, "%s: Aviso %04d: %s\n", file, j + 1, o->warnings->data[j]);
+    }
+
+    uint64_t time = 0;
+    for (uint32_t j = 0; j < OP_PASSES; j++) {
+        time += o->stats[j].time;
+    }
+    fprintf(stderr, "Otimização: %" PRIu64 " de %" PRIu64 " nós em %.1f µs\n", o->stats[OP_PASSES - 1].nodes, o->nodes,
+            time / 1000.0);
+
+    return o;
+}
+
+// Compile a file to bytecode while it's parsed, without the tree, then run it like runFile without `jit`
+// There's no tree for the optimizer to rewrite, so this mode never runs optimized
+int runDirect(char *file) {
+    char  *input = stringFromFile(file);
+    Lexer *l     = lNew(input);
+
+    eErrorList *errors = eNew();
+    uint64_t    start  = pbNow();
+    bcProgram  *bc     = dcCompile(l, errors);
+    uint64_t    time   = pbNow() - start;
+
+    eErrorList *reported = errors;
+    VM         *vm       = NULL;
+    if (bc) {
+        uint32_t instructions = 0;
+        for (uint32_t i = 0; i < bc->size; i++) {
+            instructions += bc->functions[i].size;
+        }
+        fprintf(stderr, "Compilação direta: %" PRIu32 " instruções em %.1f µs\n", instructions, time / 1000.0);
+
+        vm = vmNew(bc);
+        if (!vmRun(vm)) {
+            reported = vm->errors;
+        }
+    }
+
+    int failed = reported->size > 0;
+    for (uint32_t j = 0; j < reported->size; j++) {
+        printf("%s: Erro %04d: %s\n", file, j + 1, reported->data[j]);
+    }
+    if (!failed) {
+        vmPrintGlobals(vm, stdout);
+    }
+
+    if (vm) {
+        vmFree(vm);
+    }
+    if (bc) {
+        bcFree(bc);
+    }
+    eFree(errors);
+    lFree(l);
+
+    return failed;
+}
+
+// Parse and type check a file, then run the tree without compiling it and print the variables of the program
+// With `optimize` the tree is optimized before it runs
+int runTree(char *file, bool optimize) {
+    char   *input = stringFromFile(file);
+    Lexer  *l     = lNew(input);
+    Parser *p     = pNew(l);
+
+    astProgram *program = pParseProgram(p);
+    eErrorList *errors  = p->errors;
+
+    TypeChecker *y = NULL;
+    Optimizer   *o = NULL;
+    Executor    *x = NULL;
+    if (errors->size == 0) {
+        y = tyNew();
+        tyCheck(y, program);
+        errors = y->errors;
+    }
+    if (errors->size == 0 && optimize) {
+        o = optimizeTree(file, y, program);
+    }
+    if (errors->size == 0) {
+        x = exNew(y, program);
+    }
+    if (x) {
+        uint64_t start = pbNow();
+        if (!exRun(x)) {
+            errors = x->errors;
+        }
+        uint64_t time = pbNow() - start;
+
+        fprintf(stderr, "Interpretação: %" PRIu64 " nós convertidos, %.1f µs de execução\n", x->converted,
+                time / 1000.0);
+    }
+
+    int failed = errors->size > 0;
+    for (uint32_t j = 0; j < errors->size; j++) {
+        printf("%s: Erro %04d: %s\n", file, j + 1, errors->data[j]);
+    }
+    if (!failed) {
+        exPrintGlobals(x, stdout);
+    }
+
+    if (x) {
+        exFree(x);
+    }
+    if (o) {
+        opFree(o);
+    }
+    if (y) {
+        tyFree(y);
+    }
+    astProgramFree(program);
+    lFree(l);
+    pFree(p);
+
+    return failed;
+}
+
+// Build the SSA form of each file and optimize it, then print the time and the size after each stage over all of them
+// With `dump` the instructions of each function are printed after the passes
+int ssaFiles(int count, char *files[], bool dump) {
+    char   *names[IR_PASSES] = {"construção", "sccp", "gvn", "dce"};
+    irStats totals[IR_PASSES];
+    memset(totals, 0, sizeof(totals));
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        char   *input = stringFromFile(files[i]);
+        Lexer  *l     = lNew(input);
+        Parser *p     = pNew(l);
+
+        astProgram *program = pParseProgram(p);
+        eErrorList *errors  = p->errors;
+
+        // Only a well-typed tree is built, the builder trusts the types cached on it
+        TypeChecker *y  = NULL;
+        irProgram   *ir = NULL;
+        if (errors->size == 0) {
+            y = tyNew();
+            tyCheck(y, program);
+            errors = y->errors;
+        }
+        if (errors->size == 0) {
+            ir = irBuild(y, program);
+        }
+
+        if (errors->size > 0) {
+            for (uint32_t j = 0; j < errors->size; j++) {
+                printf("%s: Erro %04d: %s\n", files[i], j + 1, errors->data[j]);
+            }
+            failed++;
+        }
+
+        if (ir) {
+            irOptimize(ir);
+            if (dump) {
+                irPrint(ir, stdout);
+                printf("\n");
+            }
+
+            for (uint32_t j = 0; j < IR_PASSES; j++) {
+                totals[j].time += ir->stats[j].time;
+                totals[j].blocks += ir->stats[j].blocks;
+                totals[j].instructions += ir->stats[j].instructions;
+                totals[j].phis += ir->stats[j].phis;
+            }
+            irFree(ir);
+        }
+
+        if (y) {
+            tyFree(y);
+        }
+        astProgramFree(program);
+        lFree(l);
+        pFree(p);
+    }
+
+    // printf pads by bytes, so each continuation byte of an accented letter widens the name's column by one
+    printf("etapa         tempo (µs)    blocos  instruções      phis\n");
+    for (uint32_t j = 0; j < IR_PASSES; j++) {
+        int width = 12;
+        for (char *c = names[j]; *c; c++) {
+            width += (*c & 0xc0) == 0x80;
+        }
+        printf("%-*s%12.1f%10" PRIu64 "%12" PRIu64 "%10" PRIu64 "\n", width, names[j], totals[j].time / 1000.0,
+               totals[j].blocks, totals[j].instructions, totals[j].phis);
+    }
+    printf("%d arquivo(s), %d com erros\n", count, failed);
+
+    return failed > 0;
+}
+
+// Optimize the tree of each file, then print the time and the size after each pass over all of them
+// With `dump` the optimized tree is printed
+int optFiles(int count, char *files[], bool dump) {
+    char    *names[OP_PASSES] = {"dobra", "invariantes"};
+    opStats  totals[OP_PASSES];
+    uint64_t nodes      = 0;
+    uint64_t folded     = 0;
+    uint64_t simplified = 0;
+    uint64_t pruned     = 0;
+    uint64_t hoisted    = 0;
+    uint64_t loops      = 0;
+    memset(totals, 0, sizeof(totals));
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        char   *input = stringFromFile(files[i]);
+        Lexer  *l     = lNew(input);
+        Parser *p     = pNew(l);
+
+        astProgram *program = pParseProgram(p);
+        eErrorList *errors  = p->errors;
+
+        // Only a well-typed tree is optimized, the passes trust the types cached on it
+        TypeChecker *y = NULL;
+        Optimizer   *o = NULL;
+        if (errors->size == 0) {
+            y = tyNew();
+            tyCheck(y, program);
+            errors = y->errors;
+        }
+        if (errors->size == 0) {
+            o = opNew(y, program);
+            opOptimize(o);
+        }
+
+        if (errors->size > 0) {
+            for (uint32_t j = 0; j < errors->size; j++) {
+                printf("%s: Erro %04d: %s\n", files[i], j + 1, errors->data[j]);
+            }
+            failed++;
+        }
+
+        if (o) {
+            for (uint32_t j = 0; j < o->warnings->size; j++) {
+                printf("%s: Aviso %04d: %s\n", files[i], j + 1, o->warnings->data[j]);
+            }
+            if (dump) {
+                char *tree = astProgramToString(program);
+                printf("%s\n", tree);
+                free(tree);
+            }
+
+            for (uint32_t j = 0; j < OP_PASSES; j++) {
+                totals[j].time += o->stats[j].time;
+                totals[j].nodes += o->stats[j].nodes;
+            }
+            nodes += o->nodes;
+            folded += o->folded;
+            simplified += o->simplified;
+            pruned += o->pruned;
+            hoisted += o->hoisted;
+            loops += o->loops;
+            opFree(o);
+        }
+
+        if (y) {
+            tyFree(y);
+        }
+        astProgramFree(program);
+        lFree(l);
+        pFree(p);
+    }
+
+    // printf pads by bytes, so each continuation byte of an accented letter widens the name's column by one
+    printf("etapa         tempo (µs)       nós\n");
+    printf("%-12s%12s%10" PRIu64 "\n", "original", "", nodes);
+    for (uint32_t j = 0; j < OP_PASSES; j++) {
+        int width = 12;
+        for (char *c = names[j]; *c; c++) {
+            width += (*c & 0xc0) == 0x80;
+        }
+        printf("%-*s%12.1f%10" PRIu64 "\n", width, names[j], totals[j].time / 1000.0, totals[j].nodes);
+    }
+
+    uint64_t last = totals[OP_PASSES - 1].nodes;
+    printf("%" PRIu64 " operadores dobrados, %" PRIu64 " identidades simplificadas, %" PRIu64
+           " comandos removidos, %+.1f%% nós\n",
+           folded, simplified, pruned, nodes ? 100.0 * ((double)last - (double)nodes) / (double)nodes : 0.0);
+    printf("%" PRIu64 " expressões invariantes retiradas de %" PRIu64 " laços\n", hoisted, loops);
+    printf("%d arquivo(s), %d com erros\n", count, failed);
+
+    return failed > 0;
+}
+
+// Parse and type check a file, then write it as a C program or as x86-64 assembly to the output file
+// With `optimize` the tree is optimized before it's written
+int emitFile(char *inputFile, char *outputFile, bool native, bool optimize) {
+    char   *input = stringFromFile(inputFile);
+    Lexer  *l     = lNew(input);
+    Parser *p     = pNew(l);
+
+    astProgram *program = pParseProgram(p);
+    eErrorList *errors  = p->errors;
+
+    // Only a well-typed tree is written, the generator trusts the types cached on it
+    TypeChecker *y = NULL;
+    Optimizer   *o = NULL;
+    if (errors->size == 0) {
+        y = tyNew();
+        tyCheck(y, program);
+        errors = y->errors;
+    }
+    if (errors->size == 0 && optimize) {
+        o = optimizeTree(inputFile, y, program);
+    }
+
+    int failed = errors->size > 0;
+    for (uint32_t j = 0; j < errors->size; j++) {
+        printf("%s: Erro %04d: %s\n", inputFile, j + 1, errors->data[j]);
+    }
+
+    if (!failed) {
+        FILE *out = fopen(outputFile, "w");
+        if (!out) {
+            printf("Nao foi possivel abrir o arquivo %s\n", outputFile);
+            failed = 1;
+        } else {
+            failed = native ? !ncEmitProgram(y, program, out, y->errors) : !cgEmitProgram(y, program, out);
+            failed |= fclose(out) != 0;
+        }
+
+        // The native generator reports the programs it can't write, their partial output is removed
+        for (uint32_t j = 0; native && j < y->errors->size; j++) {
+            printf("%s: Erro %04d: %s\n", inputFile, j + 1, y->errors->data[j]);
+        }
+        if (native && y->errors->size > 0) {
+            remove(outputFile);
+        }
+    }
+
+    if (o) {
+        opFree(o);
+    }
+    if (y) {
+        tyFree(y);
+    }
+    astProgramFree(program);
+    lFree(l);
+    pFree(p);
+
+    return failed;
 }
 
 // Read a file and return its content as a string
 char *stringFromFile(char *filename) {
-    FILE *file = fopen(filename, "r");
+#ifndef _WIN32
+    char *buffer = srReadFile(filename);
+#else
+    char *buffer = NULL;
+    FILE *file   = fopen(filename, "rb");
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        int64_t length = ftell(file);
+        fseek(file, 0, SEEK_SET);
 
-    if (!file) {
+        buffer = (char *)malloc(length + 1);
+        if (buffer) {
+            buffer[fread(buffer, 1, length, file)] = '\0';
+        }
+        fclose(file);
+    }
+#endif  // _WIN32
+
+    if (!buffer) {
         printf("Nao foi possivel abrir o arquivo %s\n", filename);
         exit(1);
     }
 
-    fseek(file, 0, SEEK_END);
-    int64_t length = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    return buffer;
+}
+
+// Parse many files concurrently, printing the errors in the order the files were given
+// Isolated batches parse in worker processes, so a file that crashes the parser only fails itself
+int batchFiles(int count, char *inputs[], bool isolated) {
+#ifndef _WIN32
+    uint32_t workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 2 && strcmp(inputs[0], "-j") == 0) {
+        workers = atoi(inputs[1]);
+        count -= 2;
+        inputs += 2;
+    }
+
+    Batch *b = bNew();
+    for (int i = 0; i < count; i++) {
+        if (!bAddInput(b, inputs[i])) {
+            printf("Nenhum arquivo encontrado para %s\n", inputs[i]);
+        }
+    }
 
-    char *buffer = malloc(length + 1);
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
+    if (isolated) {
+        shRun(b, workers);
+    } else {
+        bRun(b, workers);
+    }
 
-    fclose(file);
+    uint32_t failed = bReport(b);
+    uint32_t total  = b->size;
 
-    return buffer;
+    bFree(b);
+
+    if (failed > 0) {
+        printf("%u de %u arquivo(s) com erros\n", failed, total);
+        return 1;
+    }
+
+    printf("%u arquivo(s) analisado(s) com sucesso!\n", total);
+
+    return 0;
+#else
+    (void)count;
+    (void)inputs;
+    (void)isolated;
+    printf("Analise em lote indisponivel no Windows\n");
+    return 1;
+#endif  // _WIN32
+}
+
+// Serve parse requests on a Unix socket until stopped
+int serve(char *path) {
+#ifdef __linux__
+    Server *s = svNew(path);
+    if (!s) {
+        printf("Nao foi possivel abrir o socket %s\n", path);
+        return 1;
+    }
+
+    printf("Servidor aguardando pedidos em %s\n", path);
+    fflush(stdout);
+
+    svRun(s);
+
+    printf("%" PRIu64 " pedido(s) atendido(s)\n", s->requests);
+
+    svFree(s);
+
+    return 0;
+#else
+    printf("Servidor disponivel apenas no Linux\n");
+    return 1;
+#endif  // __linux__
+}
+
+// Send files to a running server and report the request latencies
+int loadServer(int count, char *args[]) {
+#ifndef _WIN32
+    char    *path        = args[0];
+    uint32_t connections = 4;
+    uint32_t requests    = 1000;
+    svFormat format      = SV_TEXT;
+
+    count--;
+    args++;
+
+    while (count > 2 && args[0][0] == '-') {
+        if (strcmp(args[0], "-c") == 0) {
+            connections = atoi(args[1]);
+        } else if (strcmp(args[0], "-n") == 0) {
+            requests = atoi(args[1]);
+        } else if (strcmp(args[0], "-f") == 0) {
+            if (strcmp(args[1], "diag") == 0) {
+                format = SV_DIAGNOSTICS;
+            } else if (strcmp(args[1], "binary") == 0) {
+                format = SV_BINARY;
+            } else if (strcmp(args[1], "run") == 0) {
+                format = SV_RUN;
+            } else {
+                format = SV_TEXT;
+            }
+        } else {
+            break;
+        }
+
+        count -= 2;
+        args += 2;
+    }
+
+    return svLoad(path, format, args, count, connections, requests);
+#else
+    (void)count;
+    (void)args;
+    printf("Carga indisponivel no Windows\n");
+    return 1;
+#endif  // _WIN32
+}
+
+// Serve an editor over stdin and stdout until it asks the server to exit
+int languageServer() {
+    LanguageServer *s = lspNew(stdin, stdout);
+    if (!s) {
+        return 1;
+    }
+
+    int status = lspRun(s);
+    lspFree(s);
+
+    return status;
+}
+
+// Keep every file of a directory checked, checking again only the files that change
+int watchDirectory(char *dir) {
+#ifdef __linux__
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        printf("Nao foi possivel abrir o diretorio %s\n", dir);
+        return 1;
+    }
+
+    Watcher *w = wtNew(dir);
+    if (!w) {
+        printf("Nao foi possivel observar o diretorio %s\n", dir);
+        return 1;
+    }
+
+    wtRun(w);
+
+    uint32_t failed = w->failed;
+    wtFree(w);
+
+    return failed > 0 ? 1 : 0;
+#else
+    printf("Observacao disponivel apenas no Linux\n");
+    return 1;
+#endif  // __linux__
 }
\ No newline at end of file
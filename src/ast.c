@@ -6,29 +6,87 @@
 
 #include "token.h"
 
-uint32_t indentLevel = 0;
-
 // Function for appending a string to another string, allocating memory as needed
-void astAppendToString(char** buffer, char* str) {
-    if (*buffer == NULL) {
-        *buffer = (char*)malloc(strlen(str) + 1);
-        strcpy(*buffer, str);
-    } else {
-        *buffer = (char*)realloc(*buffer, strlen(*buffer) + strlen(str) + 1);
-        strcat(*buffer, str);
+void astAppendToString(astString* buffer, char* str) {
+    size_t length = strlen(str);
+
+    if (buffer->length + length + 1 > buffer->capacity) {
+        while (buffer->length + length + 1 > buffer->capacity) {
+            buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 64;
+        }
+        buffer->data = (char*)realloc(buffer->data, buffer->capacity);
     }
+
+    memcpy(buffer->data + buffer->length, str, length + 1);
+    buffer->length += length;
+}
+
+// Function for making room for one more element in a node array, doubling its capacity when it's full
+void* astGrowArray(void* array, uint32_t size, uint32_t* capacity, size_t elementSize) {
+    if (size < *capacity) {
+        return array;
+    }
+
+    *capacity = *capacity ? *capacity * 2 : 4;
+    return realloc(array, elementSize * *capacity);
 }
 
 // Function for creating an indentation string
-char* indentString() {
-    char* indent = (char*)malloc(indentLevel + 1);
-    for (uint32_t i = 0; i < indentLevel; i++) {
+char* indentString(uint32_t level) {
+    char* indent = (char*)malloc(level + 1);
+    for (uint32_t i = 0; i < level; i++) {
         indent[i] = '\t';
     }
-    indent[indentLevel] = '\0';
+    indent[level] = '\0';
     return indent;
 }
 
+// Convert a statement to a string as if it was nested `level` levels deep in the tree
+char* astNestedToString(astStatement* s, uint32_t level) {
+    return s->toString(s, level);
+}
+
+//
+// Streaming text output
+//
+
+// Create a new text sink writing to an open file
+astTextSink* astTextSinkNew(FILE* file) {
+    astTextSink* sink = (astTextSink*)malloc(sizeof(astTextSink));
+    if (sink == NULL) {
+        return NULL;
+    }
+
+    sink->file    = file;
+    sink->started = false;
+
+    return sink;
+}
+
+// Free the text sink, doesn't close the file
+void astTextSinkFree(astTextSink* sink) { free(sink); }
+
+// Statement sink callback, writes a top-level statement exactly where astProgramToString would
+void astTextSinkStatement(void* ctx, astProgram* p, astStatement* s) {
+    astTextSink* sink = (astTextSink*)ctx;
+
+    if (!sink->started) {
+        fprintf(sink->file, "Program: {\n\tIdentifier: %s\n\tBlock: {\n", p->identifier->value);
+        sink->started = true;
+    }
+
+    char* stmt = astNestedToString(s, 2);
+    fprintf(sink->file, "\t\t%s\n", stmt);
+    free(stmt);
+}
+
+// Write the end of the program, the output is then the same as astProgramToString
+void astTextSinkEnd(astTextSink* sink) {
+    if (sink->started) {
+        fprintf(sink->file, "\t}\n}\n");
+    }
+}
+
 //
 // Program
 //
@@ -69,17 +127,19 @@ void astProgramFree(astProgram* p) {
 
 // Convert the program node to a string
 char* astProgramToString(astProgram* p) {
-    char* buffer = NULL;
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Program: {\n\tIdentifier: ");
-    astAppendToString(&buffer, p->identifier->toString(p->identifier));
-    astAppendToString(&buffer, "\n");
 
-    indentLevel++;
+    char* identifier = p->identifier->toString(p->identifier, 0);
+    astAppendToString(&buffer, identifier);
+    free(identifier);
+
+    astAppendToString(&buffer, "\n");
 
-    char* indent = indentString();
+    char* indent = indentString(1);
 
-    char* block = p->block->toString(p->block);
+    char* block = p->block->toString(p->block, 1);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, block);
@@ -89,9 +149,7 @@ char* astProgramToString(astProgram* p) {
 
     astAppendToString(&buffer, "}\n");
 
-    indentLevel--;
-
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -108,6 +166,7 @@ astBlockStmt* astBlockStmtNew(Token* token) {
     b->token      = token;
     b->statements = NULL;
     b->size       = 0;
+    b->capacity   = 0;
 
     b->free     = astBlockStmtFree;
     b->toString = astBlockStmtToString;
@@ -135,30 +194,30 @@ void astBlockStmtFree(astBlockStmt* b) {
 }
 
 // Convert the block statement node to a string
-char* astBlockStmtToString(astBlockStmt* b) {
-    char* buffer = NULL;
+char* astBlockStmtToString(astBlockStmt* b, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Block: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     for (uint32_t i = 0; i < b->size; i++) {
-        char* stmt = b->statements[i]->toString(b->statements[i]);
+        char* stmt = b->statements[i]->toString(b->statements[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, stmt);
         astAppendToString(&buffer, "\n");
         free(stmt);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}\n");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -175,6 +234,7 @@ astVarStmt* astVarStmtNew(Token* token) {
     v->token        = token;
     v->declarations = NULL;
     v->size         = 0;
+    v->capacity     = 0;
 
     v->free     = astVarStmtFree;
     v->toString = astVarStmtToString;
@@ -188,7 +248,7 @@ void astVarStmtFree(astVarStmt* v) {
         tFreeToken(v->token);
 
         if (v->declarations) {
-            for (uint16_t i = 0; i < v->size; i++) {
+            for (uint32_t i = 0; i < v->size; i++) {
                 if (v->declarations[i]) {
                     v->declarations[i]->free(v->declarations[i]);
                 }
@@ -202,29 +262,29 @@ void astVarStmtFree(astVarStmt* v) {
 }
 
 // Convert the var statement node to a string
-char* astVarStmtToString(astVarStmt* v) {
-    char* buffer = NULL;
+char* astVarStmtToString(astVarStmt* v, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Var: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
-    for (uint16_t i = 0; i < v->size; i++) {
-        char* decl = v->declarations[i]->toString(v->declarations[i]);
+    for (uint32_t i = 0; i < v->size; i++) {
+        char* decl = v->declarations[i]->toString(v->declarations[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, decl);
         astAppendToString(&buffer, "\n");
         free(decl);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -241,6 +301,7 @@ astDeclarationStmt* astDeclarationStmtNew(Token* token) {
     d->token      = token;
     d->identifier = NULL;
     d->size       = 0;
+    d->capacity   = 0;
     d->type       = NULL;
 
     d->free     = astDeclarationStmtFree;
@@ -252,10 +313,10 @@ astDeclarationStmt* astDeclarationStmtNew(Token* token) {
 // Free the declaration node
 void astDeclarationStmtFree(astDeclarationStmt* d) {
     if (d) {
-        tFreeToken(d->token);
+        // Doesn't free the token because it's a reference to the token of the first identifier
 
         if (d->identifier) {
-            for (uint16_t i = 0; i < d->size; i++) {
+            for (uint32_t i = 0; i < d->size; i++) {
                 if (d->identifier[i]) {
                     d->identifier[i]->free(d->identifier[i]);
                 }
@@ -273,18 +334,18 @@ void astDeclarationStmtFree(astDeclarationStmt* d) {
 }
 
 // Convert the declaration node to a string
-char* astDeclarationStmtToString(astDeclarationStmt* d) {
-    char* buffer = NULL;
+char* astDeclarationStmtToString(astDeclarationStmt* d, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Declaration: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Identifiers: {");
 
-    for (uint16_t i = 0; i < d->size; i++) {
-        char* id = d->identifier[i]->toString(d->identifier[i]);
+    for (uint32_t i = 0; i < d->size; i++) {
+        char* id = d->identifier[i]->toString(d->identifier[i], level);
         astAppendToString(&buffer, id);
         free(id);
 
@@ -298,22 +359,22 @@ char* astDeclarationStmtToString(astDeclarationStmt* d) {
     astAppendToString(&buffer, "Type: ");
 
     if (d->type) {
-        char* type = d->type->toString(d->type);
+        char* type = d->type->toString(d->type, level);
         astAppendToString(&buffer, type);
         free(type);
     }
 
     astAppendToString(&buffer, "\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -331,6 +392,7 @@ astFunctionStmt* astFunctionStmtNew(Token* token) {
     f->identifier = NULL;
     f->parameters = NULL;
     f->size       = 0;
+    f->capacity   = 0;
     f->returnType = NULL;
     f->block      = NULL;
 
@@ -350,7 +412,7 @@ void astFunctionStmtFree(astFunctionStmt* f) {
         }
 
         if (f->parameters) {
-            for (uint16_t i = 0; i < f->size; i++) {
+            for (uint32_t i = 0; i < f->size; i++) {
                 if (f->parameters[i]) {
                     f->parameters[i]->free(f->parameters[i]);
                 }
@@ -372,20 +434,20 @@ void astFunctionStmtFree(astFunctionStmt* f) {
 }
 
 // Convert the function statement node to a string
-char* astFunctionStmtToString(astFunctionStmt* f) {
-    char* buffer = NULL;
+char* astFunctionStmtToString(astFunctionStmt* f, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     if (f->returnType) {
         astAppendToString(&buffer, "Function: {\n");
     } else {
         astAppendToString(&buffer, "Procedure: {\n");
     }
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Identifier: ");
-    char* id = f->identifier->toString(f->identifier);
+    char* id = f->identifier->toString(f->identifier, level);
     astAppendToString(&buffer, id);
     free(id);
     astAppendToString(&buffer, "\n");
@@ -394,19 +456,19 @@ char* astFunctionStmtToString(astFunctionStmt* f) {
     astAppendToString(&buffer, "Parameters: {\n");
 
     free(indent);
-    indentLevel++;
-    indent = indentString();
+    level++;
+    indent = indentString(level);
 
-    for (uint16_t i = 0; i < f->size; i++) {
-        char* param = f->parameters[i]->toString(f->parameters[i]);
+    for (uint32_t i = 0; i < f->size; i++) {
+        char* param = f->parameters[i]->toString(f->parameters[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, param);
         astAppendToString(&buffer, "\n");
         free(param);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}\n");
@@ -414,26 +476,26 @@ char* astFunctionStmtToString(astFunctionStmt* f) {
     if (f->returnType) {
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, "Return type: ");
-        char* type = f->returnType->toString(f->returnType);
+        char* type = f->returnType->toString(f->returnType, level);
         astAppendToString(&buffer, type);
         free(type);
         astAppendToString(&buffer, "\n");
     }
 
-    char* block = f->block->toString(f->block);
+    char* block = f->block->toString(f->block, level);
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, block);
     free(block);
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -450,6 +512,7 @@ astParameterStmt* astParameterStmtNew(Token* token) {
     p->token        = token;
     p->declarations = NULL;
     p->size         = 0;
+    p->capacity     = 0;
     p->isVar        = false;
 
     p->free     = astParameterStmtFree;
@@ -461,10 +524,10 @@ astParameterStmt* astParameterStmtNew(Token* token) {
 // Free the parameter node
 void astParameterStmtFree(astParameterStmt* p) {
     if (p) {
-        tFreeToken(p->token);
+        // Doesn't free the token because it's a reference to the token in the AST
 
         if (p->declarations) {
-            for (uint16_t i = 0; i < p->size; i++) {
+            for (uint32_t i = 0; i < p->size; i++) {
                 if (p->declarations[i]) {
                     p->declarations[i]->free(p->declarations[i]);
                 }
@@ -478,12 +541,12 @@ void astParameterStmtFree(astParameterStmt* p) {
 }
 
 // Convert the parameter node to a string
-char* astParameterStmtToString(astParameterStmt* p) {
-    char* buffer = NULL;
+char* astParameterStmtToString(astParameterStmt* p, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Parameter block: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     if (p->isVar) {
         astAppendToString(&buffer, indent);
@@ -495,33 +558,33 @@ char* astParameterStmtToString(astParameterStmt* p) {
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Declarations: {\n");
-    indentLevel++;
+    level++;
     free(indent);
-    indent = indentString();
+    indent = indentString(level);
 
-    for (uint16_t i = 0; i < p->size; i++) {
-        char* decl = p->declarations[i]->toString(p->declarations[i]);
+    for (uint32_t i = 0; i < p->size; i++) {
+        char* decl = p->declarations[i]->toString(p->declarations[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, decl);
         astAppendToString(&buffer, "\n");
         free(decl);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -538,6 +601,7 @@ astBeginEndStmt* astBeginEndStmtNew(Token* token) {
     b->token      = token;
     b->statements = NULL;
     b->size       = 0;
+    b->capacity   = 0;
 
     b->free     = astBeginEndStmtFree;
     b->toString = astBeginEndStmtToString;
@@ -565,29 +629,30 @@ void astBeginEndStmtFree(astBeginEndStmt* b) {
 }
 
 // Convert the begin-end statement node to a string
-char* astBeginEndStmtToString(astBeginEndStmt* b) {
-    char* buffer = NULL;
+char* astBeginEndStmtToString(astBeginEndStmt* b, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Begin: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     for (uint32_t i = 0; i < b->size; i++) {
-        char* stmt = b->statements[i]->toString(b->statements[i]);
+        char* stmt = b->statements[i]->toString(b->statements[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, stmt);
         astAppendToString(&buffer, "\n");
         free(stmt);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
-    return buffer;
+    free(indent);
+    return buffer.data;
 }
 
 //
@@ -634,16 +699,16 @@ void astConditionalStmtFree(astConditionalStmt* c) {
 }
 
 // Convert the conditional node to a string
-char* astConditionalStmtToString(astConditionalStmt* c) {
-    char* buffer = NULL;
+char* astConditionalStmtToString(astConditionalStmt* c, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Conditional: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Condition: ");
-    char* condition = c->condition->toString(c->condition);
+    char* condition = c->condition->toString(c->condition, level);
     astAppendToString(&buffer, condition);
     free(condition);
     astAppendToString(&buffer, "\n");
@@ -652,17 +717,17 @@ char* astConditionalStmtToString(astConditionalStmt* c) {
     astAppendToString(&buffer, "Consequence: {\n");
 
     free(indent);
-    indentLevel++;
-    indent = indentString();
+    level++;
+    indent = indentString(level);
 
-    char* cons = c->consequence->toString(c->consequence);
+    char* cons = c->consequence->toString(c->consequence, level);
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, cons);
     astAppendToString(&buffer, "\n");
     free(cons);
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}\n");
@@ -672,31 +737,31 @@ char* astConditionalStmtToString(astConditionalStmt* c) {
         astAppendToString(&buffer, "Alternative: {\n");
 
         free(indent);
-        indentLevel++;
-        indent = indentString();
+        level++;
+        indent = indentString(level);
 
-        char* alt = c->alternative->toString(c->alternative);
+        char* alt = c->alternative->toString(c->alternative, level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, alt);
         astAppendToString(&buffer, "\n");
         free(alt);
 
-        indentLevel--;
-        indent[indentLevel] = '\0';
+        level--;
+        indent[level] = '\0';
 
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, "}\n");
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -738,16 +803,16 @@ void astWhileStmtFree(astWhileStmt* w) {
 }
 
 // Convert the while loop node to a string
-char* astWhileStmtToString(astWhileStmt* w) {
-    char* buffer = NULL;
+char* astWhileStmtToString(astWhileStmt* w, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "While: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Condition: ");
-    char* condition = w->condition->toString(w->condition);
+    char* condition = w->condition->toString(w->condition, level);
     astAppendToString(&buffer, condition);
     free(condition);
     astAppendToString(&buffer, "\n");
@@ -756,30 +821,30 @@ char* astWhileStmtToString(astWhileStmt* w) {
     astAppendToString(&buffer, "Body: {\n");
 
     free(indent);
-    indentLevel++;
-    indent = indentString();
+    level++;
+    indent = indentString(level);
 
-    char* body = w->body->toString(w->body);
+    char* body = w->body->toString(w->body, level);
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, body);
     astAppendToString(&buffer, "\n");
     free(body);
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -805,7 +870,7 @@ astExpressionStmt* astExpressionStmtNew(Token* token) {
 // Free the expression statement node
 void astExpressionStmtFree(astExpressionStmt* e) {
     if (e) {
-        tFreeToken(e->token);
+        // Doesn't free the token because it's a reference to the first token of the expression
 
         if (e->expr) {
             e->expr->free(e->expr);
@@ -816,23 +881,23 @@ void astExpressionStmtFree(astExpressionStmt* e) {
 }
 
 // Convert the expression statement node to a string
-char* astExpressionStmtToString(astExpressionStmt* e) {
-    char* buffer = NULL;
+char* astExpressionStmtToString(astExpressionStmt* e, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Expression: {\n");
 
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
     astAppendToString(&buffer, indent);
 
-    char* expr = e->expr->toString(e->expr);
+    char* expr = e->expr->toString(e->expr, level);
     astAppendToString(&buffer, expr);
     free(expr);
 
     astAppendToString(&buffer, "\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
@@ -840,7 +905,7 @@ char* astExpressionStmtToString(astExpressionStmt* e) {
 
     free(indent);
 
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -860,6 +925,7 @@ astPrefixExpr* astPrefixExprNew(Token* token) {
 
     p->free     = astPrefixExprFree;
     p->toString = astPrefixExprToString;
+    p->type     = 0;
 
     return p;
 }
@@ -878,21 +944,21 @@ void astPrefixExprFree(astPrefixExpr* p) {
 }
 
 // Convert the prefix expression node to a string
-char* astPrefixExprToString(astPrefixExpr* p) {
-    char* buffer = NULL;
+char* astPrefixExprToString(astPrefixExpr* p, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "(");
     astAppendToString(&buffer, p->token->literal);
 
     if (p->right) {
-        char* right = p->right->toString(p->right);
+        char* right = p->right->toString(p->right, level);
         astAppendToString(&buffer, right);
         free(right);
     }
 
     astAppendToString(&buffer, ")");
 
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -913,6 +979,7 @@ astInfixExpr* astInfixExprNew(Token* token) {
 
     i->free     = astInfixExprFree;
     i->toString = astInfixExprToString;
+    i->type     = 0;
 
     return i;
 }
@@ -935,13 +1002,13 @@ void astInfixExprFree(astInfixExpr* i) {
 }
 
 // Convert the infix expression node to a string
-char* astInfixExprToString(astInfixExpr* i) {
-    char* buffer = NULL;
+char* astInfixExprToString(astInfixExpr* i, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "(");
 
     if (i->left) {
-        char* left = i->left->toString(i->left);
+        char* left = i->left->toString(i->left, level);
         astAppendToString(&buffer, left);
         free(left);
     }
@@ -953,14 +1020,14 @@ char* astInfixExprToString(astInfixExpr* i) {
     }
 
     if (i->right) {
-        char* right = i->right->toString(i->right);
+        char* right = i->right->toString(i->right, level);
         astAppendToString(&buffer, right);
         free(right);
     }
 
     astAppendToString(&buffer, ")");
 
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -980,6 +1047,7 @@ astAssignmentExpr* astAssignmentExprNew(Token* token) {
 
     a->free     = astAssignmentExprFree;
     a->toString = astAssignmentExprToString;
+    a->type     = 0;
 
     return a;
 }
@@ -1002,36 +1070,36 @@ void astAssignmentExprFree(astAssignmentExpr* a) {
 }
 
 // Convert the assignment node to a string
-char* astAssignmentExprToString(astAssignmentExpr* a) {
-    char* buffer = NULL;
+char* astAssignmentExprToString(astAssignmentExpr* a, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Assignment: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Identifier: ");
-    char* id = a->identifier->toString(a->identifier);
+    char* id = a->identifier->toString(a->identifier, level);
     astAppendToString(&buffer, id);
     free(id);
     astAppendToString(&buffer, "\n");
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Value: ");
-    char* value = a->value->toString(a->value);
+    char* value = a->value->toString(a->value, level);
     astAppendToString(&buffer, value);
     free(value);
     astAppendToString(&buffer, "\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1045,11 +1113,13 @@ astIdentifierExpr* astIdentifierExprNew(Token* token) {
         return NULL;
     }
 
-    id->token = token;
-    id->value = token->literal;
+    id->token  = token;
+    id->value  = token->literal;
+    id->symbol = 0;
 
     id->free     = astIdentifierExprFree;
     id->toString = astIdentifierExprToString;
+    id->type     = 0;
 
     return id;
 }
@@ -1063,10 +1133,11 @@ void astIdentifierExprFree(astIdentifierExpr* id) {
 }
 
 // Convert the identifier node to a string
-char* astIdentifierExprToString(astIdentifierExpr* id) {
-    char* buffer = NULL;
+char* astIdentifierExprToString(astIdentifierExpr* id, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, id->token->literal);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1085,6 +1156,7 @@ astIntegerExpr* astIntegerExprNew(Token* token) {
 
     integer->free     = astIntegerExprFree;
     integer->toString = astIntegerExprToString;
+    integer->type     = 0;
 
     return integer;
 }
@@ -1098,10 +1170,11 @@ void astIntegerExprFree(astIntegerExpr* integer) {
 }
 
 // Convert the integer node to a string
-char* astIntegerExprToString(astIntegerExpr* integer) {
-    char* buffer = NULL;
+char* astIntegerExprToString(astIntegerExpr* integer, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, integer->token->literal);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1120,6 +1193,7 @@ astFloatExpr* astFloatExprNew(Token* token) {
 
     f->free     = astFloatExprFree;
     f->toString = astFloatExprToString;
+    f->type     = 0;
 
     return f;
 }
@@ -1133,10 +1207,11 @@ void astFloatExprFree(astFloatExpr* f) {
 }
 
 // Convert the float node to a string
-char* astFloatExprToString(astFloatExpr* f) {
-    char* buffer = NULL;
+char* astFloatExprToString(astFloatExpr* f, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, f->token->literal);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1155,6 +1230,7 @@ astBooleanExpr* astBooleanExprNew(Token* token) {
 
     b->free     = astBooleanExprFree;
     b->toString = astBooleanExprToString;
+    b->type     = 0;
 
     return b;
 }
@@ -1168,10 +1244,11 @@ void astBooleanExprFree(astBooleanExpr* b) {
 }
 
 // Convert the boolean node to a string
-char* astBooleanExprToString(astBooleanExpr* b) {
-    char* buffer = NULL;
+char* astBooleanExprToString(astBooleanExpr* b, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, b->token->literal);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1190,6 +1267,7 @@ astStringExpr* astStringExprNew(Token* token) {
 
     s->free     = astStringExprFree;
     s->toString = astStringExprToString;
+    s->type     = 0;
 
     return s;
 }
@@ -1203,12 +1281,13 @@ void astStringExprFree(astStringExpr* s) {
 }
 
 // Convert the string node to a string
-char* astStringExprToString(astStringExpr* s) {
-    char* buffer = NULL;
+char* astStringExprToString(astStringExpr* s, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, "\"");
     astAppendToString(&buffer, s->token->literal);
     astAppendToString(&buffer, "\"");
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1227,6 +1306,7 @@ astCharExpr* astCharExprNew(Token* token) {
 
     c->free     = astCharExprFree;
     c->toString = astCharExprToString;
+    c->type     = 0;
 
     return c;
 }
@@ -1240,12 +1320,13 @@ void astCharExprFree(astCharExpr* c) {
 }
 
 // Convert the character node to a string
-char* astCharExprToString(astCharExpr* c) {
-    char* buffer = NULL;
+char* astCharExprToString(astCharExpr* c, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, "'");
     astAppendToString(&buffer, c->token->literal);
     astAppendToString(&buffer, "'");
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1264,6 +1345,7 @@ astTypeExpr* astTypeExprNew(Token* token) {
 
     type->free     = astTypeExprFree;
     type->toString = astTypeExprToString;
+    type->type     = 0;
 
     return type;
 }
@@ -1277,10 +1359,11 @@ void astTypeExprFree(astTypeExpr* type) {
 }
 
 // Convert the type node to a string
-char* astTypeExprToString(astTypeExpr* type) {
-    char* buffer = NULL;
+char* astTypeExprToString(astTypeExpr* type, uint32_t level) {
+    (void)level;
+    astString buffer = {NULL, 0, 0};
     astAppendToString(&buffer, type->token->literal);
-    return buffer;
+    return buffer.data;
 }
 
 //
@@ -1298,9 +1381,11 @@ astCallExpr* astCallExprNew(Token* token) {
     c->identifier = NULL;
     c->arguments  = NULL;
     c->size       = 0;
+    c->capacity   = 0;
 
     c->free     = astCallExprFree;
     c->toString = astCallExprToString;
+    c->type     = 0;
 
     return c;
 }
@@ -1315,7 +1400,7 @@ void astCallExprFree(astCallExpr* c) {
         }
 
         if (c->arguments) {
-            for (uint16_t i = 0; i < c->size; i++) {
+            for (uint32_t i = 0; i < c->size; i++) {
                 if (c->arguments[i]) {
                     c->arguments[i]->free(c->arguments[i]);
                 }
@@ -1329,16 +1414,16 @@ void astCallExprFree(astCallExpr* c) {
 }
 
 // Convert the function call node to a string
-char* astCallExprToString(astCallExpr* c) {
-    char* buffer = NULL;
+char* astCallExprToString(astCallExpr* c, uint32_t level) {
+    astString buffer = {NULL, 0, 0};
 
     astAppendToString(&buffer, "Call: {\n");
-    indentLevel++;
-    char* indent = indentString();
+    level++;
+    char* indent = indentString(level);
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "Identifier: ");
-    char* id = c->identifier->toString(c->identifier);
+    char* id = c->identifier->toString(c->identifier, level);
     astAppendToString(&buffer, id);
     free(id);
     astAppendToString(&buffer, "\n");
@@ -1347,30 +1432,30 @@ char* astCallExprToString(astCallExpr* c) {
     astAppendToString(&buffer, "Arguments: {\n");
 
     free(indent);
-    indentLevel++;
-    indent = indentString();
+    level++;
+    indent = indentString(level);
 
-    for (uint16_t i = 0; i < c->size; i++) {
-        char* arg = c->arguments[i]->toString(c->arguments[i]);
+    for (uint32_t i = 0; i < c->size; i++) {
+        char* arg = c->arguments[i]->toString(c->arguments[i], level);
         astAppendToString(&buffer, indent);
         astAppendToString(&buffer, arg);
         astAppendToString(&buffer, "\n");
         free(arg);
     }
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
     astAppendToString(&buffer, "}\n");
 
-    indentLevel--;
-    indent[indentLevel] = '\0';
+    level--;
+    indent[level] = '\0';
 
     astAppendToString(&buffer, indent);
 
     astAppendToString(&buffer, "}");
 
     free(indent);
-    return buffer;
+    return buffer.data;
 }
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "batch.h"
+
+#include <dirent.h>
+#include <glob.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "ast.h"
+#include "error.h"
+#include "hash.h"
+#include "hashmap.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "token.h"
+
+// Create an empty batch with the shared tables
+Batch *bNew() {
+    Batch *b = (Batch *)malloc(sizeof(Batch));
+    if (!b) {
+        return NULL;
+    }
+
+    b->files    = NULL;
+    b->size     = 0;
+    b->capacity = 0;
+    b->deques   = NULL;
+    b->workers  = 0;
+    b->reader   = NULL;
+
+    b->keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(b->keywords);
+
+    b->tables = pNewTables();
+
+    return b;
+}
+
+// Free the batch and the diagnostics of its files
+void bFree(Batch *b) {
+    for (uint32_t i = 0; i < b->size; i++) {
+        free(b->files[i].input);
+        if (b->files[i].errors) {
+            eFree(b->files[i].errors);
+        }
+    }
+
+    free(b->files);
+    hmFree(b->keywords);
+    pFree(b->tables);
+    free(b);
+}
+
+// Add a file to the batch
+void bAddFile(Batch *b, char *input, uint64_t size) {
+    if (b->size >= b->capacity) {
+        b->capacity = b->capacity ? b->capacity * 2 : 64;
+        b->files    = (BatchFile *)realloc(b->files, sizeof(BatchFile) * b->capacity);
+    }
+
+    b->files[b->size] = (BatchFile){strdup(input), size, NULL};
+    b->size++;
+}
+
+// Compare directory entry names, so directories are always walked in the same order
+int bCompareNames(const void *a, const void *b) { return strcmp(*(char **)a, *(char **)b); }
+
+// Add every `.pas` file of a directory and its subdirectories
+void bAddDirectory(Batch *b, char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+
+    char   **names    = NULL;
+    uint32_t size     = 0;
+    uint32_t capacity = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(d))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        if (size >= capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            names    = (char **)realloc(names, sizeof(char *) * capacity);
+        }
+
+        names[size] = (char *)malloc(strlen(dir) + strlen(entry->d_name) + 2);
+        sprintf(names[size], "%s/%s", dir, entry->d_name);
+        size++;
+    }
+
+    closedir(d);
+
+    qsort(names, size, sizeof(char *), bCompareNames);
+
+    for (uint32_t i = 0; i < size; i++) {
+        struct stat st;
+        if (stat(names[i], &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                bAddDirectory(b, names[i]);
+            } else {
+                size_t length = strlen(names[i]);
+                if (S_ISREG(st.st_mode) && length > 4 && strcmp(names[i] + length - 4, ".pas") == 0) {
+                    bAddFile(b, names[i], st.st_size);
+                }
+            }
+        }
+
+        free(names[i]);
+    }
+
+    free(names);
+}
+
+// Add an input to the batch, either a file, a directory or a glob pattern
+bool bAddInput(Batch *b, char *input) {
+    if (strpbrk(input, "*?[")) {
+        glob_t matches;
+        if (glob(input, 0, NULL, &matches) != 0) {
+            return false;
+        }
+
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            bAddInput(b, matches.gl_pathv[i]);
+        }
+
+        globfree(&matches);
+        return true;
+    }
+
+    struct stat st;
+    if (stat(input, &st) != 0) {
+        // Reported as a diagnostic of the file when it's parsed
+        bAddFile(b, input, 0);
+        return true;
+    }
+
+    if (S_ISDIR(st.st_mode)) {
+        bAddDirectory(b, input);
+    } else {
+        bAddFile(b, input, st.st_size);
+    }
+
+    return true;
+}
+
+//
+// Scheduling
+//
+
+// Compare files by size, smallest first
+int bCompareSizes(const void *a, const void *b) {
+    uint64_t sizeA = (*(BatchFile **)a)->size;
+    uint64_t sizeB = (*(BatchFile **)b)->size;
+    return (sizeA > sizeB) - (sizeA < sizeB);
+}
+
+// Parse every file of the batch with a number of worker threads
+void bRun(Batch *b, uint32_t workers) {
+    if (workers == 0) {
+        workers = 1;
+    }
+    if (workers > b->size && b->size > 0) {
+        workers = b->size;
+    }
+
+    // Deal the files by size, so every worker starts with its share of large files
+    BatchFile **order = (BatchFile **)malloc(sizeof(BatchFile *) * (b->size + 1));
+    for (uint32_t i = 0; i < b->size; i++) {
+        order[i] = &b->files[i];
+    }
+
+    qsort(order, b->size, sizeof(BatchFile *), bCompareSizes);
+
+    // Files are read ahead in the order the owners pop them, largest first
+    b->reader = srNew(b->size, 256);
+    if (b->reader) {
+        uint32_t *readOrder = (uint32_t *)malloc(sizeof(uint32_t) * (b->size + 1));
+        for (uint32_t i = 0; i < b->size; i++) {
+            b->reader->sources[i].path = b->files[i].input;
+            b->reader->sources[i].size = b->files[i].size;
+            readOrder[b->size - 1 - i] = order[i] - b->files;
+        }
+
+        srStart(b->reader, readOrder);
+        free(readOrder);
+    }
+
+    b->workers = workers;
+    b->deques  = (BatchDeque *)malloc(sizeof(BatchDeque) * workers);
+    for (uint32_t i = 0; i < workers; i++) {
+        b->deques[i].tasks  = (uint32_t *)malloc(sizeof(uint32_t) * (b->size / workers + 1));
+        b->deques[i].top    = 0;
+        b->deques[i].bottom = 0;
+        pthread_mutex_init(&b->deques[i].lock, NULL);
+    }
+
+    // Smallest files at the top for the thieves, largest at the bottom for the owner
+    for (uint32_t i = 0; i < b->size; i++) {
+        BatchDeque *d         = &b->deques[i % workers];
+        d->tasks[d->bottom++] = order[i] - b->files;
+    }
+
+    free(order);
+
+    pthread_t   *threads = (pthread_t *)malloc(sizeof(pthread_t) * workers);
+    BatchWorker *args    = (BatchWorker *)malloc(sizeof(BatchWorker) * workers);
+
+    // The calling thread is worker 0, the deques of workers that fail to start are drained by the others
+    uint32_t started = 1;
+    for (; started < workers; started++) {
+        args[started] = (BatchWorker){b, started};
+        if (pthread_create(&threads[started], NULL, bWork, &args[started]) != 0) {
+            break;
+        }
+    }
+
+    args[0] = (BatchWorker){b, 0};
+    bWork(&args[0]);
+
+    for (uint32_t i = 1; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (b->reader) {
+        srFree(b->reader);
+        b->reader = NULL;
+    }
+
+    for (uint32_t i = 0; i < workers; i++) {
+        pthread_mutex_destroy(&b->deques[i].lock);
+        free(b->deques[i].tasks);
+    }
+
+    free(b->deques);
+    free(threads);
+    free(args);
+
+    b->deques  = NULL;
+    b->workers = 0;
+}
+
+// Worker thread, parses files until every deque is empty
+void *bWork(void *arg) {
+    BatchWorker *w = (BatchWorker *)arg;
+
+    uint32_t task;
+    while (bNextTask(w->b, w->id, &task)) {
+        bParseFile(w->b, &w->b->files[task]);
+    }
+
+    return NULL;
+}
+
+// Take the next task, from the bottom of the worker's own deque or from the top of another one
+bool bNextTask(Batch *b, uint32_t id, uint32_t *task) {
+    for (uint32_t i = 0; i < b->workers; i++) {
+        BatchDeque *d     = &b->deques[(id + i) % b->workers];
+        bool        found = false;
+
+        pthread_mutex_lock(&d->lock);
+        if (d->top < d->bottom) {
+            if (i == 0) {
+                d->bottom--;
+                *task = d->tasks[d->bottom];
+            } else {
+                *task = d->tasks[d->top];
+                d->top++;
+            }
+            found = true;
+        }
+        pthread_mutex_unlock(&d->lock);
+
+        if (found) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Parse a file and write its AST next to it, keeping the diagnostics
+void bParseFile(Batch *b, BatchFile *f) {
+    char *input = b->reader ? srTake(b->reader, f - b->files) : srReadFile(f->input);
+    if (!input) {
+        f->errors = eNew();
+        eAdd(f->errors, "Nao foi possivel abrir o arquivo");
+        return;
+    }
+
+    char *outputFile = (char *)malloc(strlen(f->input) + 5);
+    sprintf(outputFile, "%s.ast", f->input);
+
+    FILE *file = fopen(outputFile, "w");
+    if (!file) {
+        f->errors = eNew();
+        eAdd(f->errors, "Nao foi possivel abrir o arquivo de saida");
+        free(outputFile);
+        free(input);
+        return;
+    }
+
+    Lexer  *l = lNewWithKeywords(input, b->keywords);
+    Parser *p = pNewShared(l, NULL, NULL, b->tables);
+
+    astTextSink *sink = astTextSinkNew(file);
+    p->stmtSink       = astTextSinkStatement;
+    p->sinkCtx        = sink;
+
+    astProgram *program = pParseProgram(p);
+
+    if (p->errors->size > 0) {
+        fclose(file);
+        remove(outputFile);
+    } else {
+        astTextSinkEnd(sink);
+        fprintf(file, "\n");
+        fclose(file);
+    }
+
+    // The file takes the diagnostics
+    f->errors = p->errors;
+    p->errors = eNew();
+
+    astTextSinkFree(sink);
+    astProgramFree(program);
+    lFree(l);
+    pFree(p);
+    free(outputFile);
+}
+
+// Print the diagnostics in input order, returns the number of files with errors
+uint32_t bReport(Batch *b) {
+    uint32_t failed = 0;
+
+    for (uint32_t i = 0; i < b->size; i++) {
+        BatchFile *f = &b->files[i];
+        if (!f->errors || f->errors->size == 0) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < f->errors->size; j++) {
+            printf("%s: Erro %04d: %s\n", f->input, j + 1, f->errors->data[j]);
+        }
+        failed++;
+    }
+
+    return failed;
+}
\ No newline at end of file
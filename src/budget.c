@@ -0,0 +1,152 @@
+#include "budget.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Create a budget with the limits of `options`, nothing is spent yet
+ParseBudget *pbNew(ParseOptions *options) {
+    ParseBudget *b = (ParseBudget *)malloc(sizeof(ParseBudget));
+    if (!b) {
+        return NULL;
+    }
+
+    b->options  = *options;
+    b->tokens   = 0;
+    b->astBytes = 0;
+    b->depth    = 0;
+    b->status   = PB_OK;
+    b->reported = false;
+
+    return b;
+}
+
+// Free the budget, the cancel flag belongs to the caller
+void pbFree(ParseBudget *b) { free(b); }
+
+// Count a scanned token, false once the parse is over budget
+// The clock and the cancel flag are only read every PB_CLOCK_INTERVAL tokens, so a token costs an increment
+bool pbTick(ParseBudget *b) {
+    if (b->status != PB_OK) {
+        return false;
+    }
+
+    b->tokens++;
+    if (b->options.maxTokens && b->tokens > b->options.maxTokens) {
+        pbStop(b, PB_TOKENS);
+        return false;
+    }
+
+    if ((b->tokens & (PB_CLOCK_INTERVAL - 1)) == 0) {
+        if (b->options.cancel && atomic_load_explicit(b->options.cancel, memory_order_relaxed)) {
+            pbStop(b, PB_CANCELLED);
+            return false;
+        }
+
+        if (b->options.deadline && pbNow() > b->options.deadline) {
+            pbStop(b, PB_DEADLINE);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Count bytes handed to the tree, false if they don't fit, nothing is counted then
+bool pbAllocate(ParseBudget *b, uint64_t bytes) {
+    if (b->status != PB_OK) {
+        return false;
+    }
+
+    if (b->options.maxAstBytes && b->astBytes + bytes > b->options.maxAstBytes) {
+        pbStop(b, PB_AST_BYTES);
+        return false;
+    }
+
+    b->astBytes += bytes;
+    return true;
+}
+
+// Enter a nested node, false if it's nested too deep, the node must not be entered then
+// Every successful enter is matched by a pbLeave, a NULL budget is never exceeded
+bool pbEnter(ParseBudget *b) {
+    if (!b) {
+        return true;
+    }
+
+    if (b->options.maxDepth && b->depth >= b->options.maxDepth) {
+        pbStop(b, PB_DEPTH);
+        return false;
+    }
+
+    b->depth++;
+    return true;
+}
+
+// Leave a nested node
+void pbLeave(ParseBudget *b) {
+    if (b) {
+        b->depth--;
+    }
+}
+
+// Check the number of diagnostics so far, false once there are as many as the limit allows
+bool pbErrors(ParseBudget *b, uint32_t errors) {
+    if (b->options.maxErrors && errors >= b->options.maxErrors) {
+        pbStop(b, PB_ERRORS);
+        return false;
+    }
+
+    return true;
+}
+
+// Stop the parse, only the first reason is kept
+void pbStop(ParseBudget *b, pbStatus status) {
+    if (b->status == PB_OK) {
+        b->status = status;
+    }
+}
+
+// Write the diagnostic of why the parse stopped, false if it didn't stop or the diagnostic was already written
+bool pbReport(ParseBudget *b, char *buffer, uint32_t size, uint64_t line) {
+    if (b->status == PB_OK || b->reported) {
+        return false;
+    }
+
+    snprintf(buffer, size, "Linha %" PRIu64 ": Análise interrompida, %s", line, pbMessage(b->status));
+    b->reported = true;
+
+    return true;
+}
+
+// Description of why a parse stopped
+char *pbMessage(pbStatus status) {
+    switch (status) {
+        case PB_TOKENS:
+            return "limite de tokens excedido";
+        case PB_DEPTH:
+            return "limite de aninhamento excedido";
+        case PB_AST_BYTES:
+            return "limite de memória da árvore sintática excedido";
+        case PB_ERRORS:
+            return "limite de erros excedido";
+        case PB_DEADLINE:
+            return "tempo limite excedido";
+        case PB_CANCELLED:
+            return "cancelada";
+        default:
+            return "dentro dos limites";
+    }
+}
+
+// Monotonic time in nanoseconds, the clock of ParseOptions deadlines
+uint64_t pbNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
\ No newline at end of file
@@ -0,0 +1,813 @@
+#include "bytecode.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "error.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Compile a program the type checker accepted, returns NULL if it doesn't fit the virtual machine
+bcProgram *bcCompile(TypeChecker *types, astProgram *program, eErrorList *errors) {
+    if (!program) {
+        return NULL;
+    }
+
+    bcProgram *p = (bcProgram *)calloc(1, sizeof(bcProgram));
+    if (!p) {
+        return NULL;
+    }
+
+    bcCompiler c;
+    c.program = p;
+    c.types   = types;
+    c.slots   = (uint32_t *)calloc(types->symbols->size, sizeof(uint32_t));
+    c.index   = bcNewFunction(p, program->identifier ? program->identifier->value : "program");
+    c.depth   = 0;
+    c.top     = 0;
+    c.line    = program->token ? program->token->line : 0;
+    c.failed  = false;
+    c.errors  = errors;
+
+    bcCompileBlock(&c, program->block);
+    bcEmit(&c, BC_HALT, 0, 0, 0);
+
+    free(c.slots);
+
+    if (c.failed) {
+        bcFree(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+// Free a compiled program
+void bcFree(bcProgram *program) {
+    for (uint32_t i = 0; i < program->size; i++) {
+        free(program->functions[i].name);
+        free(program->functions[i].code);
+        free(program->functions[i].lines);
+    }
+    for (uint32_t i = 0; i < program->stringSize; i++) {
+        free(program->strings[i]);
+    }
+    for (uint32_t i = 0; i < program->globalSize; i++) {
+        free(program->globals[i].name);
+    }
+
+    free(program->functions);
+    free(program->constants);
+    free(program->strings);
+    free(program->globals);
+    free(program);
+}
+
+//
+// Walk
+//
+
+// Compile a block in the frame of the current function, variables take the registers after the parameters
+void bcCompileBlock(bcCompiler *c, astBlockStmt *block) {
+    if (!block) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        astStatement *s = block->statements[i];
+
+        switch (evKindOf(s)) {
+            case EV_VAR: {
+                astVarStmt *var = (astVarStmt *)s;
+                bcCompileLocals(c, var->declarations, var->size);
+                break;
+            }
+            case EV_FUNCTION:
+                bcCompileFunction(c, (astFunctionStmt *)s);
+                break;
+            default:
+                bcCompileStatement(c, s);
+                break;
+        }
+    }
+}
+
+// Compile a function into a function of its own, its frame holds the parameters, the result, the variables and the
+// temporaries in that order
+void bcCompileFunction(bcCompiler *c, astFunctionStmt *function) {
+    if (!function->identifier) {
+        return;
+    }
+
+    if (c->program->size >= BC_MAX_FUNCTIONS) {
+        c->line = function->token->line;
+        bcError(c, "Programa grande demais para a máquina virtual");
+        return;
+    }
+
+    uint32_t index                         = bcNewFunction(c->program, function->identifier->value);
+    c->slots[function->identifier->symbol] = index;
+
+    uint32_t enclosing = c->index;
+    uint32_t depth     = c->depth;
+    uint32_t top       = c->top;
+
+    c->index = index;
+    c->depth = depth + 1;
+    c->top   = 0;
+    c->line  = function->token->line;
+
+    c->program->functions[index].depth = c->depth;
+
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        if (parameter) {
+            bcCompileLocals(c, parameter->declarations, parameter->size);
+        }
+    }
+    c->program->functions[index].parameters = c->top;
+
+    if (function->returnType) {
+        c->program->functions[index].result = bcTemporary(c);
+    }
+
+    bcCompileBlock(c, function->block);
+    bcEmit(c, BC_RET, 0, 0, 0);
+
+    c->index = enclosing;
+    c->depth = depth;
+    c->top   = top;
+}
+
+// Give each declared name a register of the current frame, the variables of the program are also kept as globals
+void bcCompileLocals(bcCompiler *c, astDeclarationStmt **declarations, uint32_t size) {
+    bcProgram *p = c->program;
+
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        if (!declaration) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < declaration->size; j++) {
+            astIdentifierExpr *identifier = declaration->identifier[j];
+            if (!identifier) {
+                continue;
+            }
+
+            uint32_t slot                = bcTemporary(c);
+            c->slots[identifier->symbol] = slot;
+
+            // The optimizer's temporaries take registers but aren't variables of the program
+            if (c->depth == 0 && !sySymbolOf(c->types->symbols, identifier)->temporary) {
+                p->globals = (bcGlobal *)astGrowArray(p->globals, p->globalSize, &p->globalCapacity, sizeof(bcGlobal));
+
+                bcGlobal *g = &p->globals[p->globalSize++];
+                g->name     = strdup(identifier->value);
+                g->type     = identifier->type;
+                g->slot     = slot;
+            }
+        }
+    }
+}
+
+// Compile a statement, the temporaries it takes are free again once it's done
+void bcCompileStatement(bcCompiler *c, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    uint32_t mark = c->top;
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                bcCompileStatement(c, (astStatement *)beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+
+            c->line      = conditional->token->line;
+            uint32_t end = bcCompileJump(c, conditional->condition, false);
+            bcCompileStatement(c, conditional->consequence);
+
+            if (conditional->alternative) {
+                uint32_t skip = bcEmit(c, BC_JMP, 0, 0, 0);
+                bcPatch(c, end, c->program->functions[c->index].size);
+                bcCompileStatement(c, conditional->alternative);
+                end = skip;
+            }
+
+            bcPatch(c, end, c->program->functions[c->index].size);
+            break;
+        }
+        case EV_WHILE: {
+            // The test sits after the body, so each iteration runs a single jump
+            astWhileStmt *loop = (astWhileStmt *)s;
+
+            c->line       = loop->token->line;
+            uint32_t test = bcEmit(c, BC_JMP, 0, 0, 0);
+            uint32_t body = c->program->functions[c->index].size;
+            bcCompileStatement(c, loop->body);
+
+            bcPatch(c, test, c->program->functions[c->index].size);
+            c->line = loop->token->line;
+            bcPatch(c, bcCompileJump(c, loop->condition, true), body);
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *statement = (astExpressionStmt *)s;
+
+            c->line = statement->token ? statement->token->line : c->line;
+            bcCompileExpression(c, statement->expr, BC_ANY);
+            break;
+        }
+        default:
+            break;
+    }
+
+    c->top = mark;
+}
+
+// Compile a jump taken when a condition is `when`, returns the jump to patch with its target
+// Integer comparisons become a single compare-and-branch instruction, with the right operand inline if it's small
+uint32_t bcCompileJump(bcCompiler *c, astExpression *condition, bool when) {
+    if (evKindOf(condition) == EV_PREFIX && ((astPrefixExpr *)condition)->token->type == NOT) {
+        return bcCompileJump(c, ((astPrefixExpr *)condition)->right, !when);
+    }
+
+    if (evKindOf(condition) == EV_INFIX) {
+        astInfixExpr *infix = (astInfixExpr *)condition;
+        TokenType     op    = infix->token->type;
+        uint32_t      type  = infix->left->type;
+
+        bool comparison = op == EQ || op == NOT_EQ || op == LT || op == GT || op == LTE || op == GTE;
+        bool integral   = type == infix->right->type && (type == TY_INTEGER || type == TY_BOOLEAN || type == TY_CHAR);
+
+        if (comparison && integral) {
+            if (!when) {
+                op = bcNegation(op);
+            }
+
+            c->line = infix->token->line;
+
+            int64_t immediate;
+            if (bcIsSmall(infix->right, INT16_MIN, INT16_MAX, &immediate)) {
+                uint32_t a = bcCompileExpression(c, infix->left, BC_ANY);
+                return bcEmit(c, bcBranch(op, true), a, (uint32_t)immediate & 0xFFFF, 0);
+            }
+
+            uint32_t mark = c->top;
+            uint32_t a    = bcSnapshot(c, bcCompileExpression(c, infix->left, BC_ANY), mark, infix->right);
+            uint32_t b    = bcCompileExpression(c, infix->right, BC_ANY);
+            if (op == GT || op == GTE) {
+                return bcEmit(c, bcBranch(op, false), b, a, 0);
+            }
+            return bcEmit(c, bcBranch(op, false), a, b, 0);
+        }
+    }
+
+    uint32_t value = bcCompileExpression(c, condition, BC_ANY);
+    return bcEmit(c, when ? BC_JMPT : BC_JMPF, value, 0, 0);
+}
+
+// Compile an expression into `dst`, or into any register if `dst` is BC_ANY, returns the register holding the value
+// Variables are read in place, so with BC_ANY a variable costs no instruction
+uint32_t bcCompileExpression(bcCompiler *c, astExpression *e, uint32_t dst) {
+    if (!e) {
+        return BC_ANY;
+    }
+
+    int64_t immediate;
+    if (bcIsSmall(e, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        uint32_t d = bcDestination(c, dst);
+        bcEmit(c, BC_LOADI, d, 0, (uint32_t)immediate & BC_MAX_C);
+        return d;
+    }
+
+    bcValue value;
+    switch (evKindOf(e)) {
+        case EV_INTEGER: {
+            value.i    = ((astIntegerExpr *)e)->value;
+            uint32_t d = bcDestination(c, dst);
+            bcEmit(c, BC_LOADK, d, 0, bcConstant(c, value));
+            return d;
+        }
+        case EV_FLOAT: {
+            value.r    = ((astFloatExpr *)e)->value;
+            uint32_t d = bcDestination(c, dst);
+            bcEmit(c, BC_LOADK, d, 0, bcConstant(c, value));
+            return d;
+        }
+        case EV_STRING: {
+            uint32_t d = bcDestination(c, dst);
+            bcEmit(c, BC_LOADK, d, 0, bcString(c, ((astStringExpr *)e)->value));
+            return d;
+        }
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(c->types->symbols, identifier);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                return bcCompileCall(c, identifier, NULL, 0, dst);
+            }
+            return bcCompileVariable(c, identifier, dst);
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            return bcCompileCall(c, call->identifier, call->arguments, call->size, dst);
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+
+            uint32_t mark  = c->top;
+            uint32_t right = bcCompileExpression(c, prefix->right, BC_ANY);
+            c->top         = mark;
+
+            uint32_t d = bcDestination(c, dst);
+            if (prefix->token->type == NOT) {
+                bcEmit(c, BC_NOT, d, right, 0);
+            } else {
+                bcEmit(c, prefix->type == TY_REAL ? BC_NEGF : BC_NEGI, d, right, 0);
+            }
+            return d;
+        }
+        case EV_INFIX:
+            return bcCompileInfix(c, (astInfixExpr *)e, dst);
+        case EV_ASSIGNMENT:
+            bcCompileAssignment(c, (astAssignmentExpr *)e);
+            return BC_ANY;
+        default:
+            return BC_ANY;
+    }
+}
+
+// Compile an expression converted to a type it's assignable to, integers widen to real and characters to string
+uint32_t bcCompileConverted(bcCompiler *c, astExpression *e, uint32_t type, uint32_t dst) {
+    if (e->type == TY_INTEGER && type == TY_REAL && evKindOf(e) == EV_INTEGER) {
+        bcValue value;
+        value.r    = (double)((astIntegerExpr *)e)->value;
+        uint32_t d = bcDestination(c, dst);
+        bcEmit(c, BC_LOADK, d, 0, bcConstant(c, value));
+        return d;
+    }
+
+    if ((e->type == TY_INTEGER && type == TY_REAL) || (e->type == TY_CHAR && type == TY_STRING)) {
+        uint32_t mark  = c->top;
+        uint32_t value = bcCompileExpression(c, e, BC_ANY);
+        c->top         = mark;
+
+        uint32_t d = bcDestination(c, dst);
+        bcEmit(c, type == TY_REAL ? BC_I2F : BC_C2S, d, value, 0);
+        return d;
+    }
+
+    return bcCompileExpression(c, e, dst);
+}
+
+// Compile an infix expression, the operands are converted to the type the operator computes in
+// `>` and `>=` swap their operands, and adding or subtracting a small constant takes it inline
+uint32_t bcCompileInfix(bcCompiler *c, astInfixExpr *infix, uint32_t dst) {
+    TokenType op    = infix->token->type;
+    uint32_t  left  = infix->left->type;
+    uint32_t  right = infix->right->type;
+    uint32_t  mark  = c->top;
+
+    c->line = infix->token->line;
+
+    int64_t immediate;
+    if (infix->type == TY_INTEGER && (op == PLUS || op == MINUS) &&
+        bcIsSmall(infix->right, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        uint32_t a = bcCompileExpression(c, infix->left, BC_ANY);
+        c->top     = mark;
+        uint32_t d = bcDestination(c, dst);
+        bcEmit(c, op == PLUS ? BC_ADDIK : BC_SUBIK, d, a, (uint32_t)immediate & BC_MAX_C);
+        return d;
+    }
+    if (infix->type == TY_INTEGER && op == PLUS &&
+        bcIsSmall(infix->left, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        uint32_t b = bcCompileExpression(c, infix->right, BC_ANY);
+        c->top     = mark;
+        uint32_t d = bcDestination(c, dst);
+        bcEmit(c, BC_ADDIK, d, b, (uint32_t)immediate & BC_MAX_C);
+        return d;
+    }
+
+    // Type the operands are compared or computed in
+    uint32_t type = TY_INTEGER;
+    if (left == TY_REAL || right == TY_REAL || op == SLASH) {
+        type = TY_REAL;
+    } else if (left == TY_STRING || right == TY_STRING || infix->type == TY_STRING) {
+        type = TY_STRING;
+    }
+
+    // Evaluated left to right like the operands of a compare-and-branch, only the registers are swapped
+    uint32_t a = bcSnapshot(c, bcCompileConverted(c, infix->left, type, BC_ANY), mark, infix->right);
+    uint32_t b = bcCompileConverted(c, infix->right, type, BC_ANY);
+    c->top     = mark;
+    uint32_t d = bcDestination(c, dst);
+
+    if (op == GT || op == GTE) {
+        uint32_t swap = a;
+        a             = b;
+        b             = swap;
+    }
+
+    bcEmit(c, bcOperator(op, type), d, a, b);
+    return d;
+}
+
+// Copy a variable read in place to a temporary if the operand after it calls a function, the call could change the
+// variable through a `var` parameter or a nested function before the instruction reads the register
+uint32_t bcSnapshot(bcCompiler *c, uint32_t reg, uint32_t mark, astExpression *later) {
+    if (reg >= mark || !bcHasCall(c, later)) {
+        return reg;
+    }
+
+    uint32_t copy = bcTemporary(c);
+    bcEmit(c, BC_MOVE, copy, reg, 0);
+    return copy;
+}
+
+// Check if evaluating an expression calls a function
+bool bcHasCall(bcCompiler *c, astExpression *e) {
+    if (!e) {
+        return false;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_CALL:
+            return true;
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(c->types->symbols, (astIdentifierExpr *)e);
+            return s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE;
+        }
+        case EV_PREFIX:
+            return bcHasCall(c, ((astPrefixExpr *)e)->right);
+        case EV_INFIX:
+            return bcHasCall(c, ((astInfixExpr *)e)->left) || bcHasCall(c, ((astInfixExpr *)e)->right);
+        default:
+            return false;
+    }
+}
+
+// Compile a read of a variable, from the current frame, the program frame, or a frame up the static links
+uint32_t bcCompileVariable(bcCompiler *c, astIdentifierExpr *identifier, uint32_t dst) {
+    sySymbol *s    = sySymbolOf(c->types->symbols, identifier);
+    uint32_t  slot = c->slots[identifier->symbol];
+
+    if (s->depth == c->depth && !s->reference) {
+        if (dst == BC_ANY || dst == slot) {
+            return slot;
+        }
+        bcEmit(c, BC_MOVE, dst, slot, 0);
+        return dst;
+    }
+
+    uint32_t d = bcDestination(c, dst);
+    if (s->depth == c->depth) {
+        bcEmit(c, BC_LOADREF, d, slot, 0);
+        return d;
+    }
+
+    if (s->depth == 0) {
+        bcEmit(c, BC_GETG, d, 0, slot);
+    } else {
+        bcEmit(c, BC_GETUP, d, c->depth - s->depth, slot);
+    }
+    if (s->reference) {
+        bcEmit(c, BC_LOADREF, d, d, 0);
+    }
+
+    return d;
+}
+
+// Compile a call, the arguments go in consecutive registers that become the first registers of the callee's frame
+uint32_t bcCompileCall(bcCompiler *c, astIdentifierExpr *callee, astExpression **arguments, uint32_t size,
+                       uint32_t dst) {
+    sySymbol    *s         = sySymbolOf(c->types->symbols, callee);
+    tySignature *signature = tySignatureOf(c->types, s->typeId);
+    uint32_t     base      = c->top;
+
+    for (uint32_t i = 0; i < size; i++) {
+        bcTemporary(c);
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        if (signature->parameters[i] & TY_REFERENCE) {
+            bcCompileAddress(c, (astIdentifierExpr *)arguments[i], base + i);
+        } else {
+            bcCompileConverted(c, arguments[i], signature->parameters[i], base + i);
+        }
+    }
+
+    c->line = callee->token->line;
+    bcEmit(c, BC_CALL, base, c->slots[callee->symbol], c->depth - s->depth);
+    c->top = base;
+
+    if (s->kind == SY_PROCEDURE) {
+        return BC_ANY;
+    }
+
+    if (dst == BC_ANY) {
+        return bcTemporary(c);
+    }
+
+    bcEmit(c, BC_MOVE, dst, base, 0);
+    return dst;
+}
+
+// Compile an assignment, assigning to the name of a function sets the result register of its frame
+void bcCompileAssignment(bcCompiler *c, astAssignmentExpr *assignment) {
+    astIdentifierExpr *identifier = assignment->identifier;
+    sySymbol          *s          = sySymbolOf(c->types->symbols, identifier);
+
+    uint32_t depth = s->depth;
+    uint32_t slot  = c->slots[identifier->symbol];
+    if (s->kind == SY_FUNCTION) {
+        depth = s->depth + 1;
+        slot  = c->program->functions[slot].result;
+    }
+
+    c->line = assignment->token->line;
+
+    // A variable of the current frame is computed in place
+    if (depth == c->depth && !s->reference) {
+        bcCompileConverted(c, assignment->value, identifier->type, slot);
+        return;
+    }
+
+    uint32_t mark  = c->top;
+    uint32_t value = bcCompileConverted(c, assignment->value, identifier->type, BC_ANY);
+
+    if (depth == c->depth) {
+        bcEmit(c, BC_STOREREF, slot, value, 0);
+    } else if (depth == 0) {
+        bcEmit(c, BC_SETG, value, 0, slot);
+    } else if (!s->reference) {
+        bcEmit(c, BC_SETUP, value, c->depth - depth, slot);
+    } else {
+        uint32_t pointer = bcTemporary(c);
+        bcEmit(c, BC_GETUP, pointer, c->depth - depth, slot);
+        bcEmit(c, BC_STOREREF, pointer, value, 0);
+    }
+
+    c->top = mark;
+}
+
+// Compile the address of a variable passed by reference, a reference parameter passes on the address it holds
+void bcCompileAddress(bcCompiler *c, astIdentifierExpr *identifier, uint32_t dst) {
+    sySymbol *s    = sySymbolOf(c->types->symbols, identifier);
+    uint32_t  slot = c->slots[identifier->symbol];
+
+    if (s->depth == c->depth) {
+        bcEmit(c, s->reference ? BC_MOVE : BC_ADDR, dst, slot, 0);
+    } else if (s->reference) {
+        bcEmit(c, BC_GETUP, dst, c->depth - s->depth, slot);
+    } else if (s->depth == 0) {
+        bcEmit(c, BC_ADDRG, dst, 0, slot);
+    } else {
+        bcEmit(c, BC_ADDRUP, dst, c->depth - s->depth, slot);
+    }
+}
+
+//
+// Code
+//
+
+// Append an instruction to the function being compiled, returns its index
+uint32_t bcEmit(bcCompiler *c, bcOp op, uint32_t a, uint32_t b, uint32_t cc) {
+    bcFunction *f = &c->program->functions[c->index];
+
+    if (f->size == f->capacity) {
+        f->capacity = f->capacity ? f->capacity * 2 : 16;
+        f->code     = (bcInstr *)realloc(f->code, f->capacity * sizeof(bcInstr));
+        f->lines    = (uint64_t *)realloc(f->lines, f->capacity * sizeof(uint64_t));
+    }
+
+    if (f->size > BC_MAX_C) {
+        bcError(c, "Programa grande demais para a máquina virtual");
+    }
+
+    bcInstr *instr = &f->code[f->size];
+    instr->op      = op;
+    instr->a       = a;
+    instr->b       = b;
+    instr->c       = cc;
+
+    f->lines[f->size] = c->line;
+
+    return f->size++;
+}
+
+// Point a jump of the function being compiled at an instruction
+void bcPatch(bcCompiler *c, uint32_t jump, uint32_t target) {
+    c->program->functions[c->index].code[jump].c = target;
+}
+
+// Take the next free register of the frame
+uint32_t bcTemporary(bcCompiler *c) {
+    bcFunction *f = &c->program->functions[c->index];
+
+    if (c->top >= BC_MAX_REGISTERS) {
+        bcError(c, "Programa grande demais para a máquina virtual");
+        return 0;
+    }
+
+    uint32_t r = c->top++;
+    if (c->top > f->registers) {
+        f->registers = c->top;
+    }
+
+    return r;
+}
+
+// Register an expression compiled into `dst` ends in, a new temporary for BC_ANY
+uint32_t bcDestination(bcCompiler *c, uint32_t dst) {
+    return dst == BC_ANY ? bcTemporary(c) : dst;
+}
+
+// Add a constant to the program, returns its index
+uint32_t bcConstant(bcCompiler *c, bcValue value) {
+    bcProgram *p = c->program;
+
+    if (p->constantSize > BC_MAX_C) {
+        bcError(c, "Programa grande demais para a máquina virtual");
+        return 0;
+    }
+
+    p->constants = (bcValue *)astGrowArray(p->constants, p->constantSize, &p->constantCapacity, sizeof(bcValue));
+    p->constants[p->constantSize] = value;
+
+    return p->constantSize++;
+}
+
+// Add a string constant to the program, the program keeps its own copy, returns its constant index
+uint32_t bcString(bcCompiler *c, char *value) {
+    bcProgram *p = c->program;
+
+    p->strings = (char **)astGrowArray(p->strings, p->stringSize, &p->stringCapacity, sizeof(char *));
+    p->strings[p->stringSize] = strdup(value);
+
+    bcValue constant;
+    constant.s = *value ? p->strings[p->stringSize] : NULL;
+    p->stringSize++;
+
+    return bcConstant(c, constant);
+}
+
+// Add an empty function to a program, returns its index
+uint32_t bcNewFunction(bcProgram *program, char *name) {
+    program->functions = (bcFunction *)astGrowArray(program->functions, program->size, &program->functionCapacity,
+                                                    sizeof(bcFunction));
+
+    bcFunction *f = &program->functions[program->size];
+    f->name       = strdup(name);
+    f->code       = NULL;
+    f->lines      = NULL;
+    f->size       = 0;
+    f->capacity   = 0;
+    f->parameters = 0;
+    f->result     = BC_ANY;
+    f->registers  = 0;
+    f->depth      = 0;
+
+    return program->size++;
+}
+
+// Report a limit of the virtual machine the program exceeds, only the first one is reported
+void bcError(bcCompiler *c, char *msg) {
+    if (c->failed) {
+        return;
+    }
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": %s", c->line, msg);
+    eAdd(c->errors, error);
+
+    c->failed = true;
+}
+
+// Check if an expression is an integer, char or boolean literal between `min` and `max`, and get its value
+bool bcIsSmall(astExpression *e, int64_t min, int64_t max, int64_t *value) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            *value = ((astIntegerExpr *)e)->value;
+            break;
+        case EV_CHAR:
+            *value = (unsigned char)((astCharExpr *)e)->value;
+            break;
+        case EV_BOOLEAN:
+            *value = ((astBooleanExpr *)e)->value;
+            break;
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+            if (prefix->token->type != MINUS || evKindOf(prefix->right) != EV_INTEGER ||
+                ((astIntegerExpr *)prefix->right)->value == INT64_MIN) {
+                return false;
+            }
+            *value = -((astIntegerExpr *)prefix->right)->value;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    return *value >= min && *value <= max;
+}
+
+// Instruction of an infix operator computing in `type`, `>` and `>=` take their operands swapped
+bcOp bcOperator(TokenType op, uint32_t type) {
+    switch (op) {
+        case PLUS:
+            return type == TY_STRING ? BC_CONCAT : type == TY_REAL ? BC_ADDF : BC_ADDI;
+        case MINUS:
+            return type == TY_REAL ? BC_SUBF : BC_SUBI;
+        case ASTERISK:
+            return type == TY_REAL ? BC_MULF : BC_MULI;
+        case SLASH:
+            return BC_DIVF;
+        case DIV:
+            return BC_DIVI;
+        case MOD:
+            return BC_MODI;
+        case EQ:
+            return type == TY_STRING ? BC_EQS : type == TY_REAL ? BC_EQF : BC_EQI;
+        case NOT_EQ:
+            return type == TY_STRING ? BC_NES : type == TY_REAL ? BC_NEF : BC_NEI;
+        case LT:
+        case GT:
+            return type == TY_STRING ? BC_LTS : type == TY_REAL ? BC_LTF : BC_LTI;
+        case LTE:
+        case GTE:
+            return type == TY_STRING ? BC_LES : type == TY_REAL ? BC_LEF : BC_LEI;
+        case AND:
+            return BC_AND;
+        case OR:
+            return BC_OR;
+        default:
+            return BC_HALT;
+    }
+}
+
+// Compare-and-branch instruction of a comparison, `>` and `>=` without an immediate take their operands swapped
+bcOp bcBranch(TokenType op, bool immediate) {
+    switch (op) {
+        case EQ:
+            return immediate ? BC_JEQIK : BC_JEQI;
+        case NOT_EQ:
+            return immediate ? BC_JNEIK : BC_JNEI;
+        case LT:
+            return immediate ? BC_JLTIK : BC_JLTI;
+        case GT:
+            return immediate ? BC_JGTIK : BC_JLTI;
+        case LTE:
+            return immediate ? BC_JLEIK : BC_JLEI;
+        default:
+            return immediate ? BC_JGEIK : BC_JLEI;
+    }
+}
+
+// Comparison that holds exactly when `op` doesn't
+TokenType bcNegation(TokenType op) {
+    switch (op) {
+        case EQ:
+            return NOT_EQ;
+        case NOT_EQ:
+            return EQ;
+        case LT:
+            return GTE;
+        case GT:
+            return LTE;
+        case LTE:
+            return GT;
+        default:
+            return LT;
+    }
+}
+
+// Mnemonic of an opcode
+char *bcOpName(bcOp op) {
+    char *names[] = {
+        "HALT",  "MOVE",  "LOADI", "LOADK",  "GETG",  "SETG",  "GETUP", "SETUP", "ADDR",  "ADDRG", "ADDRUP", "LOADREF",
+        "STOREREF",
+        "ADDI",  "SUBI",  "MULI",  "DIVI",   "MODI",  "ADDIK", "SUBIK", "NEGI",
+        "ADDF",  "SUBF",  "MULF",  "DIVF",   "NEGF",  "I2F",
+        "EQI",   "NEI",   "LTI",   "LEI",    "EQF",   "NEF",   "LTF",   "LEF",   "EQS",   "NES",   "LTS",    "LES",
+        "NOT",   "AND",   "OR",    "CONCAT", "C2S",
+        "JMP",   "JMPF",  "JMPT",  "JLTI",   "JLEI",  "JEQI",  "JNEI",  "JLTIK", "JLEIK", "JGTIK", "JGEIK",  "JEQIK",
+        "JNEIK",
+        "CALL",  "RET",
+    };
+
+    return op < BC_OPCODES ? names[op] : "?";
+}
\ No newline at end of file
@@ -0,0 +1,943 @@
+#include "cgen.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Write a program the type checker accepted as C99, returns false if the output couldn't be written
+bool cgEmitProgram(TypeChecker *types, astProgram *program, FILE *out) {
+    if (!program) {
+        return false;
+    }
+
+    CGen g;
+    g.out              = out;
+    g.types            = types;
+    g.program          = program;
+    g.functions        = NULL;
+    g.size             = 0;
+    g.functionCapacity = 0;
+    g.slots            = (uint32_t *)calloc(types->symbols->size, sizeof(uint32_t));
+    g.current          = 0;
+    g.indent           = 0;
+
+    g.temporaries       = NULL;
+    g.sorted            = NULL;
+    g.temporarySize     = 0;
+    g.temporaryCapacity = 0;
+    g.temporaryNumber   = 0;
+    g.defining          = NULL;
+
+    // Function 0 is the program body
+    g.functions = (cgFunction *)astGrowArray(g.functions, g.size, &g.functionCapacity, sizeof(cgFunction));
+    g.functions[g.size++] = (cgFunction){NULL, 0, 0, false};
+    cgCollect(&g, program->block, 0);
+
+    cgEmitPrelude(&g);
+    cgEmitDeclarations(&g, program->block, CG_GLOBAL);
+    fprintf(out, "\n");
+
+    for (uint32_t i = 1; i < g.size; i++) {
+        cgEmitFrame(&g, i);
+    }
+    for (uint32_t i = 1; i < g.size; i++) {
+        cgEmitSignature(&g, i);
+        fprintf(out, ";\n");
+    }
+    for (uint32_t i = 1; i < g.size; i++) {
+        fprintf(out, "\n");
+        cgEmitFunction(&g, i);
+    }
+
+    // The body of the program, then its variables, the same way `--run` shows them
+    fprintf(out, "\nint main(void) {\n");
+    g.current         = 0;
+    g.indent          = 1;
+    g.temporaryNumber = 0;
+    cgEmitBlock(&g, program->block);
+
+    for (uint32_t i = 0; i < program->block->size; i++) {
+        astStatement *s = program->block->statements[i];
+        if (evKindOf(s) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)s;
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                // The optimizer's temporaries aren't variables of the program
+                if (sySymbolOf(types->symbols, declaration->identifier[k])->temporary) {
+                    continue;
+                }
+
+                char *name = declaration->identifier[k]->value;
+                switch (tyOfTypeExpr(declaration->type)) {
+                    case TY_INTEGER:
+                        fprintf(out, "    printf(\"%s = %%\" PRId64 \"\\n\", v_%s);\n", name, name);
+                        break;
+                    case TY_REAL:
+                        fprintf(out, "    printf(\"%s = %%.17g\\n\", v_%s);\n", name, name);
+                        break;
+                    case TY_BOOLEAN:
+                        fprintf(out, "    printf(\"%s = %%s\\n\", v_%s ? \"true\" : \"false\");\n", name, name);
+                        break;
+                    case TY_CHAR:
+                        fprintf(out, "    printf(\"%s = '%%c'\\n\", v_%s);\n", name, name);
+                        break;
+                    default:
+                        fprintf(out, "    printf(\"%s = \\\"%%s\\\"\\n\", v_%s);\n", name, name);
+                        break;
+                }
+            }
+        }
+    }
+    fprintf(out, "    return 0;\n}\n");
+
+    free(g.functions);
+    free(g.slots);
+    free(g.temporaries);
+    free(g.sorted);
+
+    return !ferror(out);
+}
+
+// Number the functions declared in a block and in the functions it declares, a function with nested functions is
+// framed
+void cgCollect(CGen *g, astBlockStmt *block, uint32_t parent) {
+    if (!block) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (evKindOf(s) != EV_FUNCTION || !((astFunctionStmt *)s)->identifier) {
+            continue;
+        }
+
+        astFunctionStmt *function = (astFunctionStmt *)s;
+        uint32_t         depth    = g->functions[parent].depth + 1;
+
+        g->functions = (cgFunction *)astGrowArray(g->functions, g->size, &g->functionCapacity, sizeof(cgFunction));
+        g->functions[g->size] = (cgFunction){function, parent, depth, false};
+
+        uint32_t index                         = g->size++;
+        g->slots[function->identifier->symbol] = index;
+        if (parent != 0) {
+            g->functions[parent].framed = true;
+        }
+
+        cgCollect(g, function->block, index);
+    }
+}
+
+// Includes and runtime helpers, integer arithmetic wraps around and division by zero stops the program, as on the VM
+void cgEmitPrelude(CGen *g) {
+    fprintf(g->out, "// Gerado a partir de `%s` por PascalSyntaxAnalyzer --emit-c\n",
+            g->program->identifier ? g->program->identifier->value : "");
+    fputs("#include <inttypes.h>\n"
+          "#include <stdbool.h>\n"
+          "#include <stdint.h>\n"
+          "#include <stdio.h>\n"
+          "#include <stdlib.h>\n"
+          "#include <string.h>\n"
+          "\n"
+          "#define PAS_ADD(a, b) ((int64_t)((uint64_t)(a) + (uint64_t)(b)))\n"
+          "#define PAS_SUB(a, b) ((int64_t)((uint64_t)(a) - (uint64_t)(b)))\n"
+          "#define PAS_MUL(a, b) ((int64_t)((uint64_t)(a) * (uint64_t)(b)))\n"
+          "#define PAS_NEG(a)    ((int64_t)(0 - (uint64_t)(a)))\n"
+          "\n"
+          "static inline void pas_fail(uint64_t line, const char *where, const char *msg) {\n"
+          "    fprintf(stderr, \"Linha %\" PRIu64 \": Erro de execução em `%s`: %s\\n\", line, where, msg);\n"
+          "    exit(1);\n"
+          "}\n"
+          "\n"
+          "static inline int64_t pas_div(int64_t a, int64_t b, uint64_t line, const char *where) {\n"
+          "    if (b == 0) {\n"
+          "        pas_fail(line, where, \"divisão por zero\");\n"
+          "    }\n"
+          "    return b == -1 ? PAS_NEG(a) : a / b;\n"
+          "}\n"
+          "\n"
+          "static inline int64_t pas_mod(int64_t a, int64_t b, uint64_t line, const char *where) {\n"
+          "    if (b == 0) {\n"
+          "        pas_fail(line, where, \"divisão por zero\");\n"
+          "    }\n"
+          "    return b == -1 ? 0 : a % b;\n"
+          "}\n"
+          "\n"
+          "static inline double pas_divf(double a, double b, uint64_t line, const char *where) {\n"
+          "    if (b == 0) {\n"
+          "        pas_fail(line, where, \"divisão por zero\");\n"
+          "    }\n"
+          "    return a / b;\n"
+          "}\n"
+          "\n"
+          "static inline const char *pas_concat(const char *a, const char *b) {\n"
+          "    size_t left = strlen(a), right = strlen(b);\n"
+          "    char  *s    = (char *)malloc(left + right + 1);\n"
+          "    memcpy(s, a, left);\n"
+          "    memcpy(s + left, b, right + 1);\n"
+          "    return s;\n"
+          "}\n"
+          "\n"
+          "static inline const char *pas_chr(char c) {\n"
+          "    char *s = (char *)malloc(2);\n"
+          "    s[0]    = c;\n"
+          "    s[1]    = '\\0';\n"
+          "    return s;\n"
+          "}\n"
+          "\n",
+          g->out);
+}
+
+// Write the variables declared by the `var` blocks of a block
+void cgEmitDeclarations(CGen *g, astBlockStmt *block, cgDeclaration mode) {
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (evKindOf(s) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)s;
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            if (!declaration) {
+                continue;
+            }
+
+            uint32_t type = tyOfTypeExpr(declaration->type);
+            for (uint32_t k = 0; k < declaration->size; k++) {
+                char *name = declaration->identifier[k]->value;
+                switch (mode) {
+                    case CG_GLOBAL:
+                        fprintf(g->out, "static %sv_%s = %s;\n", cgType(type), name, cgZero(type));
+                        break;
+                    case CG_LOCAL:
+                        cgEmitIndent(g);
+                        fprintf(g->out, "%sv_%s = %s;\n", cgType(type), name, cgZero(type));
+                        break;
+                    case CG_FIELD:
+                        fprintf(g->out, "    %sv_%s;\n", cgType(type), name);
+                        break;
+                    case CG_FIELD_INIT:
+                        if (type == TY_STRING) {
+                            cgEmitIndent(g);
+                            fprintf(g->out, "pas_fr.v_%s = \"\";\n", name);
+                        }
+                        break;
+                }
+            }
+        }
+    }
+}
+
+// Write the frame struct of a framed function, its parameters, result and variables, and the frame it's nested in
+void cgEmitFrame(CGen *g, uint32_t index) {
+    cgFunction *f = &g->functions[index];
+    if (!f->framed) {
+        return;
+    }
+
+    fprintf(g->out, "struct pas_frame_%u {\n", index);
+    if (f->parent != 0) {
+        fprintf(g->out, "    struct pas_frame_%u *up;\n", f->parent);
+    }
+
+    for (uint32_t i = 0; i < f->function->size; i++) {
+        astParameterStmt *parameter = f->function->parameters[i];
+        for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+            astDeclarationStmt *declaration = parameter->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                fprintf(g->out, "    %s%sv_%s;\n", cgType(tyOfTypeExpr(declaration->type)), parameter->isVar ? "*" : "",
+                        declaration->identifier[k]->value);
+            }
+        }
+    }
+
+    if (f->function->returnType) {
+        fprintf(g->out, "    %spas_result;\n", cgType(tyOfTypeExpr(f->function->returnType)));
+    }
+
+    cgEmitDeclarations(g, f->function->block, CG_FIELD);
+    fprintf(g->out, "};\n\n");
+}
+
+// Write the C signature of a function, a nested function takes the frame of the function it's declared in first
+void cgEmitSignature(CGen *g, uint32_t index) {
+    cgFunction      *f        = &g->functions[index];
+    astFunctionStmt *function = f->function;
+
+    fprintf(g->out, "static %sf%u_%s(", function->returnType ? cgType(tyOfTypeExpr(function->returnType)) : "void ",
+            index, function->identifier->value);
+
+    bool first = true;
+    if (f->parent != 0) {
+        fprintf(g->out, "struct pas_frame_%u *pas_up", f->parent);
+        first = false;
+    }
+
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+            astDeclarationStmt *declaration = parameter->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                fprintf(g->out, "%s%s%sv_%s", first ? "" : ", ", cgType(tyOfTypeExpr(declaration->type)),
+                        parameter->isVar ? "*" : "", declaration->identifier[k]->value);
+                first = false;
+            }
+        }
+    }
+
+    fprintf(g->out, "%s)", first ? "void" : "");
+}
+
+// Write a function, a framed one first copies its parameters into its frame
+void cgEmitFunction(CGen *g, uint32_t index) {
+    cgFunction      *f        = &g->functions[index];
+    astFunctionStmt *function = f->function;
+    uint32_t         result   = function->returnType ? tyOfTypeExpr(function->returnType) : TY_VOID;
+
+    g->current         = index;
+    g->indent          = 1;
+    g->temporaryNumber = 0;
+
+    cgEmitSignature(g, index);
+    fprintf(g->out, " {\n");
+
+    if (f->framed) {
+        fprintf(g->out, "    struct pas_frame_%u pas_fr;\n", index);
+        fprintf(g->out, "    memset(&pas_fr, 0, sizeof(pas_fr));\n");
+        if (f->parent != 0) {
+            fprintf(g->out, "    pas_fr.up = pas_up;\n");
+        }
+
+        for (uint32_t i = 0; i < function->size; i++) {
+            astParameterStmt *parameter = function->parameters[i];
+            for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+                astDeclarationStmt *declaration = parameter->declarations[j];
+                for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                    fprintf(g->out, "    pas_fr.v_%s = v_%s;\n", declaration->identifier[k]->value,
+                            declaration->identifier[k]->value);
+                }
+            }
+        }
+
+        if (result == TY_STRING) {
+            fprintf(g->out, "    pas_fr.pas_result = \"\";\n");
+        }
+        cgEmitDeclarations(g, function->block, CG_FIELD_INIT);
+    } else {
+        if (f->parent != 0) {
+            fprintf(g->out, "    (void)pas_up;\n");
+        }
+        if (result != TY_VOID) {
+            fprintf(g->out, "    %spas_result = %s;\n", cgType(result), cgZero(result));
+        }
+        cgEmitDeclarations(g, function->block, CG_LOCAL);
+    }
+
+    cgEmitBlock(g, function->block);
+
+    if (result != TY_VOID) {
+        fprintf(g->out, "    return %spas_result;\n", f->framed ? "pas_fr." : "");
+    }
+    fprintf(g->out, "}\n");
+}
+
+// Write the statements of a block, its variables and functions are written elsewhere
+void cgEmitBlock(CGen *g, astBlockStmt *block) {
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (evKindOf(s) != EV_BEGIN_END) {
+            continue;
+        }
+
+        astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+        for (uint32_t j = 0; j < beginEnd->size; j++) {
+            cgEmitStatement(g, (astStatement *)beginEnd->statements[j]);
+        }
+    }
+}
+
+// Write a statement
+void cgEmitStatement(CGen *g, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END:
+            cgEmitIndent(g);
+            fprintf(g->out, "{\n");
+            cgEmitBody(g, s);
+            cgEmitIndent(g);
+            fprintf(g->out, "}\n");
+            break;
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+
+            cgFindTemporaries(g, conditional->condition);
+            cgEmitTemporaries(g);
+
+            cgEmitIndent(g);
+            fprintf(g->out, "if (");
+            cgEmitExpression(g, conditional->condition);
+            fprintf(g->out, ") {\n");
+            cgEmitBody(g, conditional->consequence);
+
+            if (conditional->alternative) {
+                cgEmitIndent(g);
+                fprintf(g->out, "} else {\n");
+                cgEmitBody(g, conditional->alternative);
+            }
+
+            cgEmitIndent(g);
+            fprintf(g->out, "}\n");
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+
+            cgEmitIndent(g);
+            if (cgFindTemporaries(g, loop->condition) == 0) {
+                fprintf(g->out, "while (");
+                cgEmitExpression(g, loop->condition);
+                fprintf(g->out, ") {\n");
+            } else {
+                // The temporaries are evaluated again on every iteration, so the test moves inside the loop
+                fprintf(g->out, "while (true) {\n");
+                g->indent++;
+                cgEmitTemporaries(g);
+                cgEmitIndent(g);
+                fprintf(g->out, "if (!");
+                cgEmitExpression(g, loop->condition);
+                fprintf(g->out, ") {\n");
+                cgEmitIndent(g);
+                fprintf(g->out, "    break;\n");
+                cgEmitIndent(g);
+                fprintf(g->out, "}\n");
+                g->indent--;
+            }
+            cgEmitBody(g, loop->body);
+            cgEmitIndent(g);
+            fprintf(g->out, "}\n");
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpression *e = ((astExpressionStmt *)s)->expr;
+
+            cgFindTemporaries(g, e);
+            cgEmitTemporaries(g);
+
+            cgEmitIndent(g);
+            if (evKindOf(e) == EV_ASSIGNMENT) {
+                astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+                cgEmitVariable(g, assignment->identifier, false);
+                fprintf(g->out, " = ");
+                cgEmitConverted(g, assignment->value, assignment->identifier->type);
+            } else if (e && e->type == TY_VOID) {
+                cgEmitExpression(g, e);
+            } else {
+                fprintf(g->out, "(void)");
+                cgEmitExpression(g, e);
+            }
+            fprintf(g->out, ";\n");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Write the statements of the body of an `if` or `while` inside the braces already written, one level deeper
+void cgEmitBody(CGen *g, astStatement *s) {
+    g->indent++;
+
+    if (s && evKindOf(s) == EV_BEGIN_END) {
+        astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+        for (uint32_t i = 0; i < beginEnd->size; i++) {
+            cgEmitStatement(g, (astStatement *)beginEnd->statements[i]);
+        }
+    } else {
+        cgEmitStatement(g, s);
+    }
+
+    g->indent--;
+}
+
+// Write an expression, parenthesized wherever C precedence could regroup it
+void cgEmitExpression(CGen *g, astExpression *e) {
+    if (!e) {
+        return;
+    }
+
+    cgTemporary *temporary = cgTemporaryOf(g, e);
+    if (temporary) {
+        fprintf(g->out, "pas_t%u", temporary->number);
+        return;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            fprintf(g->out, "INT64_C(%" PRId64 ")", ((astIntegerExpr *)e)->value);
+            break;
+        case EV_FLOAT: {
+            char number[64];
+            snprintf(number, sizeof(number), "%.17g", ((astFloatExpr *)e)->value);
+            fprintf(g->out, "%s%s", number, strpbrk(number, ".eEni") ? "" : ".0");
+            break;
+        }
+        case EV_BOOLEAN:
+            fprintf(g->out, "%s", ((astBooleanExpr *)e)->value ? "true" : "false");
+            break;
+        case EV_CHAR:
+            fprintf(g->out, "((char)%d)", (unsigned char)((astCharExpr *)e)->value);
+            break;
+        case EV_STRING:
+            cgEmitString(g, ((astStringExpr *)e)->value);
+            break;
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(g->types->symbols, identifier);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                cgEmitCall(g, identifier, NULL, 0);
+            } else {
+                cgEmitVariable(g, identifier, false);
+            }
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            cgEmitCall(g, call->identifier, call->arguments, call->size);
+            break;
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+            if (prefix->token->type == NOT) {
+                fprintf(g->out, "(!");
+            } else {
+                fprintf(g->out, prefix->type == TY_REAL ? "(-" : "PAS_NEG(");
+            }
+            cgEmitExpression(g, prefix->right);
+            fprintf(g->out, ")");
+            break;
+        }
+        case EV_INFIX:
+            cgEmitInfix(g, (astInfixExpr *)e);
+            break;
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            fprintf(g->out, "(void)(");
+            cgEmitVariable(g, assignment->identifier, false);
+            fprintf(g->out, " = ");
+            cgEmitConverted(g, assignment->value, assignment->identifier->type);
+            fprintf(g->out, ")");
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Write an expression converted to a type it's assignable to, integers widen to real and characters to string
+void cgEmitConverted(CGen *g, astExpression *e, uint32_t type) {
+    if (e->type == TY_INTEGER && type == TY_REAL) {
+        fprintf(g->out, "((double)");
+        cgEmitExpression(g, e);
+        fprintf(g->out, ")");
+    } else if (e->type == TY_CHAR && type == TY_STRING) {
+        fprintf(g->out, "pas_chr(");
+        cgEmitExpression(g, e);
+        fprintf(g->out, ")");
+    } else {
+        cgEmitExpression(g, e);
+    }
+}
+
+// Write an infix expression, the operands are converted to the type the operator computes in
+// `and` and `or` evaluate both operands, as Pascal doesn't promise short-circuit evaluation
+void cgEmitInfix(CGen *g, astInfixExpr *infix) {
+    TokenType op = infix->token->type;
+
+    uint32_t type = TY_INTEGER;
+    if (infix->left->type == TY_REAL || infix->right->type == TY_REAL || op == SLASH) {
+        type = TY_REAL;
+    } else if (infix->left->type == TY_STRING || infix->right->type == TY_STRING || infix->type == TY_STRING) {
+        type = TY_STRING;
+    }
+
+    char *where = g->current ? g->functions[g->current].function->identifier->value
+                             : (g->program->identifier ? g->program->identifier->value : "");
+
+    // Calls: wrapping arithmetic, checked division and strings
+    char *call = NULL;
+    switch (op) {
+        case PLUS:
+            call = type == TY_STRING ? "pas_concat(" : type == TY_INTEGER ? "PAS_ADD(" : NULL;
+            break;
+        case MINUS:
+            call = type == TY_INTEGER ? "PAS_SUB(" : NULL;
+            break;
+        case ASTERISK:
+            call = type == TY_INTEGER ? "PAS_MUL(" : NULL;
+            break;
+        case SLASH:
+            call = "pas_divf(";
+            break;
+        case DIV:
+            call = "pas_div(";
+            break;
+        case MOD:
+            call = "pas_mod(";
+            break;
+        default:
+            break;
+    }
+
+    if (call) {
+        fprintf(g->out, "%s", call);
+        cgEmitConverted(g, infix->left, type);
+        fprintf(g->out, ", ");
+        cgEmitConverted(g, infix->right, type);
+        if (op == SLASH || op == DIV || op == MOD) {
+            fprintf(g->out, ", %" PRIu64 ", \"%s\"", infix->token->line, where);
+        }
+        fprintf(g->out, ")");
+        return;
+    }
+
+    char *symbol = "";
+    switch (op) {
+        case PLUS:
+            symbol = "+";
+            break;
+        case MINUS:
+            symbol = "-";
+            break;
+        case ASTERISK:
+            symbol = "*";
+            break;
+        case EQ:
+            symbol = "==";
+            break;
+        case NOT_EQ:
+            symbol = "!=";
+            break;
+        case LT:
+            symbol = "<";
+            break;
+        case GT:
+            symbol = ">";
+            break;
+        case LTE:
+            symbol = "<=";
+            break;
+        case GTE:
+            symbol = ">=";
+            break;
+        case AND:
+            symbol = "&";
+            break;
+        case OR:
+            symbol = "|";
+            break;
+        default:
+            break;
+    }
+
+    if (type == TY_STRING) {
+        fprintf(g->out, "(strcmp(");
+        cgEmitConverted(g, infix->left, type);
+        fprintf(g->out, ", ");
+        cgEmitConverted(g, infix->right, type);
+        fprintf(g->out, ") %s 0)", symbol);
+        return;
+    }
+
+    fprintf(g->out, "(");
+    cgEmitConverted(g, infix->left, type);
+    fprintf(g->out, " %s ", symbol);
+    cgEmitConverted(g, infix->right, type);
+    fprintf(g->out, ")");
+}
+
+// Write a call, a nested function gets the frame of the function it's declared in, and `var` arguments their address
+void cgEmitCall(CGen *g, astIdentifierExpr *callee, astExpression **arguments, uint32_t size) {
+    sySymbol    *s         = sySymbolOf(g->types->symbols, callee);
+    tySignature *signature = tySignatureOf(g->types, s->typeId);
+    uint32_t     index     = g->slots[callee->symbol];
+    uint32_t     depth     = g->functions[g->current].depth;
+
+    fprintf(g->out, "f%u_%s(", index, callee->value);
+
+    bool first = true;
+    if (s->depth > 0) {
+        if (s->depth == depth) {
+            fprintf(g->out, "&pas_fr");
+        } else {
+            fprintf(g->out, "pas_up");
+            for (uint32_t i = s->depth + 1; i < depth; i++) {
+                fprintf(g->out, "->up");
+            }
+        }
+        first = false;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        fprintf(g->out, "%s", first ? "" : ", ");
+        if (signature->parameters[i] & TY_REFERENCE) {
+            cgEmitVariable(g, (astIdentifierExpr *)arguments[i], true);
+        } else {
+            cgEmitConverted(g, arguments[i], signature->parameters[i]);
+        }
+        first = false;
+    }
+
+    fprintf(g->out, ")");
+}
+
+// Write a variable, or its address, the name of a function stands for its result
+void cgEmitVariable(CGen *g, astIdentifierExpr *identifier, bool address) {
+    sySymbol *s = sySymbolOf(g->types->symbols, identifier);
+
+    if (s->kind == SY_FUNCTION) {
+        cgEmitFramePath(g, s->depth + 1);
+        fprintf(g->out, "pas_result");
+        return;
+    }
+
+    if (address == s->reference) {
+        cgEmitFramePath(g, s->depth);
+        fprintf(g->out, "v_%s", identifier->value);
+        return;
+    }
+
+    fprintf(g->out, address ? "(&" : "(*");
+    cgEmitFramePath(g, s->depth);
+    fprintf(g->out, "v_%s)", identifier->value);
+}
+
+// Write the path to the variables of the function whose body is at `depth`, as seen from the function being written
+void cgEmitFramePath(CGen *g, uint32_t depth) {
+    cgFunction *f = &g->functions[g->current];
+
+    if (depth == 0) {
+        return;
+    }
+
+    if (depth == f->depth) {
+        fprintf(g->out, "%s", f->framed ? "pas_fr." : "");
+        return;
+    }
+
+    fprintf(g->out, "pas_up->");
+    for (uint32_t i = depth + 1; i < f->depth; i++) {
+        fprintf(g->out, "up->");
+    }
+}
+
+// Write a C string literal, anything but printable ASCII is escaped, and so is `?` so no trigraph forms
+void cgEmitString(CGen *g, char *value) {
+    fputc('"', g->out);
+
+    for (unsigned char *ch = (unsigned char *)value; *ch; ch++) {
+        if (*ch == '"' || *ch == '\\' || *ch == '?') {
+            fprintf(g->out, "\\%c", *ch);
+        } else if (*ch >= 0x20 && *ch < 0x7F) {
+            fputc(*ch, g->out);
+        } else {
+            fprintf(g->out, "\\%03o", *ch);
+        }
+    }
+
+    fputc('"', g->out);
+}
+
+// Write the indentation of the current level
+void cgEmitIndent(CGen *g) {
+    for (uint32_t i = 0; i < g->indent; i++) {
+        fputs("    ", g->out);
+    }
+}
+
+// C type of a type id, spaced to be followed by a declarator
+char *cgType(uint32_t type) {
+    switch (type) {
+        case TY_INTEGER:
+            return "int64_t ";
+        case TY_REAL:
+            return "double ";
+        case TY_BOOLEAN:
+            return "bool ";
+        case TY_CHAR:
+            return "char ";
+        default:
+            return "const char *";
+    }
+}
+
+// C zero value of a type id, strings start empty
+char *cgZero(uint32_t type) {
+    switch (type) {
+        case TY_REAL:
+            return "0.0";
+        case TY_BOOLEAN:
+            return "false";
+        case TY_STRING:
+            return "\"\"";
+        default:
+            return "0";
+    }
+}
+
+// Find the operands of an expression that go to temporaries so it runs left to right, returns whether the expression
+// calls a function or can stop on a division
+bool cgOrder(CGen *g, astExpression *e) {
+    if (!e) {
+        return false;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(g->types->symbols, (astIdentifierExpr *)e);
+            return s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE;
+        }
+        case EV_CALL: {
+            astCallExpr *call      = (astCallExpr *)e;
+            sySymbol    *s         = sySymbolOf(g->types->symbols, call->identifier);
+            tySignature *signature = tySignatureOf(g->types, s->typeId);
+            cgOrderOperands(g, call->arguments, call->size, signature->parameters);
+            return true;
+        }
+        case EV_PREFIX:
+            return cgOrder(g, ((astPrefixExpr *)e)->right);
+        case EV_INFIX: {
+            astInfixExpr  *infix       = (astInfixExpr *)e;
+            astExpression *operands[2] = {infix->left, infix->right};
+            TokenType      op          = infix->token->type;
+            return cgOrderOperands(g, operands, 2, NULL) || op == SLASH || op == DIV || op == MOD;
+        }
+        case EV_ASSIGNMENT:
+            cgOrder(g, ((astAssignmentExpr *)e)->value);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Order the operands of an infix or the arguments of a call, once one of them has effects every one that isn't a
+// literal goes to a temporary, after the temporaries of the operands to its left and before those of the ones to its
+// right. `var` arguments are addresses, there's nothing to evaluate
+bool cgOrderOperands(CGen *g, astExpression **operands, uint32_t size, uint32_t *parameters) {
+    uint32_t *starts  = (uint32_t *)malloc((size + 1) * sizeof(uint32_t));
+    bool      effects = false;
+    uint32_t  values  = 0;
+
+    for (uint32_t i = 0; i < size; i++) {
+        starts[i] = g->temporarySize;
+        if (parameters && parameters[i] & TY_REFERENCE) {
+            continue;
+        }
+
+        effects |= cgOrder(g, operands[i]);
+        values += !cgIsLiteral(operands[i]);
+    }
+
+    starts[size] = g->temporarySize;
+
+    if (effects && values > 1) {
+        // An operand's temporary goes right after those of its own operands, each insertion moves the rest one up
+        uint32_t inserted = 0;
+        for (uint32_t i = 0; i < size; i++) {
+            if ((parameters && parameters[i] & TY_REFERENCE) || cgIsLiteral(operands[i])) {
+                continue;
+            }
+
+            g->temporaries = (cgTemporary *)astGrowArray(g->temporaries, g->temporarySize, &g->temporaryCapacity,
+                                                         sizeof(cgTemporary));
+
+            uint32_t at = starts[i + 1] + inserted++;
+            memmove(g->temporaries + at + 1, g->temporaries + at, (g->temporarySize - at) * sizeof(cgTemporary));
+            g->temporaries[at] = (cgTemporary){operands[i], 0};
+            g->temporarySize++;
+        }
+    }
+
+    free(starts);
+    return effects;
+}
+
+
+// Whether an expression is a literal, reading one can't be told apart in any order
+bool cgIsLiteral(astExpression *e) {
+    if (!e) {
+        return false;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+        case EV_FLOAT:
+        case EV_BOOLEAN:
+        case EV_CHAR:
+        case EV_STRING:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Find the temporaries of the expression of a statement and number them, returns how many there are
+uint32_t cgFindTemporaries(CGen *g, astExpression *e) {
+    g->temporarySize = 0;
+    cgOrder(g, e);
+
+    g->sorted = (cgTemporary *)realloc(g->sorted, g->temporaryCapacity * sizeof(cgTemporary));
+    for (uint32_t i = 0; i < g->temporarySize; i++) {
+        g->temporaries[i].number = g->temporaryNumber++;
+        g->sorted[i]             = g->temporaries[i];
+    }
+    qsort(g->sorted, g->temporarySize, sizeof(cgTemporary), cgCompareTemporaries);
+
+    return g->temporarySize;
+}
+
+// Write the temporaries found for a statement, in source order, each one reads those written before it
+void cgEmitTemporaries(CGen *g) {
+    for (uint32_t i = 0; i < g->temporarySize; i++) {
+        cgTemporary *temporary = &g->temporaries[i];
+
+        cgEmitIndent(g);
+        fprintf(g->out, "%spas_t%u = ", cgType(temporary->expr->type), temporary->number);
+        g->defining = temporary->expr;
+        cgEmitExpression(g, temporary->expr);
+        g->defining = NULL;
+        fprintf(g->out, ";\n");
+    }
+}
+
+// Temporary holding the value of an operand of the statement being written, NULL if it's written out
+cgTemporary *cgTemporaryOf(CGen *g, astExpression *e) {
+    if (g->temporarySize == 0 || e == g->defining) {
+        return NULL;
+    }
+
+    cgTemporary key = {e, 0};
+    return (cgTemporary *)bsearch(&key, g->sorted, g->temporarySize, sizeof(cgTemporary), cgCompareTemporaries);
+}
+
+// Compare two temporaries by the address of their operand
+int cgCompareTemporaries(const void *a, const void *b) {
+    uintptr_t left  = (uintptr_t)((cgTemporary *)a)->expr;
+    uintptr_t right = (uintptr_t)((cgTemporary *)b)->expr;
+    return (left > right) - (left < right);
+}
\ No newline at end of file
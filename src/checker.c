@@ -0,0 +1,906 @@
+#include "checker.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "budget.h"
+#include "error.h"
+#include "lexer.h"
+#include "token.h"
+
+//
+// General and setup functions
+//
+
+// Create a new syntax checker
+Checker *cNew(Lexer *l) {
+    Checker *c = (Checker *)malloc(sizeof(Checker));
+    if (!c) {
+        return NULL;
+    }
+
+    c->l      = l;
+    c->errors = eNew();
+    c->events = NULL;
+    c->reuse  = NULL;
+    c->record = NULL;
+
+    // Read two tokens, so curToken and peekToken are both set
+    cNextToken(c);
+    cNextToken(c);
+
+    c->assignCounter = 0;
+
+    return c;
+}
+
+// Free the syntax checker
+void cFree(Checker *c) {
+    eFree(c->errors);
+    free(c);
+}
+
+// Emit an enter event for a node starting at the given token
+void cEnter(Checker *c, EventKind kind, TokenSpan *t) {
+    if (c->events) {
+        c->events->enter(c->events->ctx, kind, t);
+    }
+}
+
+// Emit an exit event for a node ending at the current token
+void cExit(Checker *c, EventKind kind) {
+    if (c->events) {
+        c->events->exit(c->events->ctx, kind, &c->curToken);
+    }
+}
+
+// Emit the enter and exit events of a single token node
+void cLeaf(Checker *c, EventKind kind) {
+    cEnter(c, kind, &c->curToken);
+    cExit(c, kind);
+}
+
+// Get the next token, setting the current and peek tokens
+void cNextToken(Checker *c) {
+    c->curToken = c->peekToken;
+    lScanToken(c->l, &c->peekToken);
+}
+
+// Check if the current token is of a given type
+bool cCurTokenIs(Checker *c, TokenType t) { return c->curToken.type == t; }
+
+// Check if the peek token is of a given type
+bool cPeekTokenIs(Checker *c, TokenType t) { return c->peekToken.type == t; }
+
+// Check if the peek token is of a given type, and advance the token if it is
+bool cExpectPeek(Checker *c, TokenType t, char *msg) {
+    if (cPeekTokenIs(c, t)) {
+        cNextToken(c);
+        return true;
+    } else {
+        cPeekError(c, msg);
+        return false;
+    }
+}
+
+// Get the precedence of a token, same table as pInitPrecedences
+Precedence cPrecedence(TokenType t) {
+    switch (t) {
+        case ASSIGN:
+            return ASSIGNMENT;
+        case OR:
+            return LOGICAL_OR;
+        case AND:
+            return LOGICAL_AND;
+        case EQ:
+        case NOT_EQ:
+            return EQUALITY;
+        case LT:
+        case GT:
+        case LTE:
+        case GTE:
+            return LESSGREATER;
+        case PLUS:
+        case MINUS:
+            return SUM;
+        case SLASH:
+        case ASTERISK:
+        case MOD:
+        case DIV:
+            return PRODUCT;
+        case LPAREN:
+            return CALL;
+        case LBRACKET:
+            return INDEX;
+        default:
+            return LOWEST;
+    }
+}
+
+// Check if a token starts an expression, same table as pInitPrefixParseFns
+bool cHasPrefixParseFn(TokenType t) {
+    switch (t) {
+        case IDENT:
+        case INT:
+        case FLOAT:
+        case TRUE:
+        case FALSE:
+        case STR:
+        case CHAR:
+        case MINUS:
+        case NOT:
+        case LPAREN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Check if a token continues an expression, same table as pInitInfixParseFns
+bool cHasInfixParseFn(TokenType t) {
+    switch (t) {
+        case ASSIGN:
+        case PLUS:
+        case MINUS:
+        case ASTERISK:
+        case SLASH:
+        case MOD:
+        case DIV:
+        case EQ:
+        case NOT_EQ:
+        case LT:
+        case GT:
+        case LTE:
+        case GTE:
+        case AND:
+        case OR:
+        case LPAREN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//
+// Checking functions, each one mirrors its pParse counterpart
+//
+
+// Program checking function, entry point of the checker, returns true if the program is valid
+bool cCheckProgram(Checker *c) {
+    cEnter(c, EV_PROGRAM, &c->curToken);
+
+    if (!cExpectPeek(c, IDENT, "IDENT")) {
+        cExit(c, EV_PROGRAM);
+        return false;
+    }
+
+    cLeaf(c, EV_IDENTIFIER);
+
+    if (!cExpectPeek(c, SEMICOLON, ";")) {
+        cExit(c, EV_PROGRAM);
+        return false;
+    }
+
+    cCheckBlockStmt(c);
+
+    if (!cExpectPeek(c, DOT, ".")) {
+        cExit(c, EV_PROGRAM);
+        return false;
+    }
+
+    if (!cExpectPeek(c, _EOF, "EOF")) {
+        cExit(c, EV_PROGRAM);
+        return false;
+    }
+
+    cExit(c, EV_PROGRAM);
+
+    return c->errors->size == 0;
+}
+
+//
+// Statement checking functions
+//
+
+// Block statement checking function
+void cCheckBlockStmt(Checker *c) {
+    cEnter(c, EV_BLOCK, &c->curToken);
+
+    if (cPeekTokenIs(c, VAR)) {
+        cNextToken(c);
+        cCheckVarStmt(c, true);
+    }
+
+    while (cPeekTokenIs(c, PROCEDURE) || cPeekTokenIs(c, FUNCTION)) {
+        cNextToken(c);
+        cCheckFunctionStmt(c);
+    }
+
+    if (cPeekTokenIs(c, BEGIN)) {
+        cNextToken(c);
+        cCheckBeginEndStmt(c);
+    } else {
+        cCustomError(c, "Bloco inválido, esperava-se `BEGIN`");
+        cExit(c, EV_BLOCK);
+        return;
+    }
+
+    cExpectPeek(c, END, "END");
+
+    cExit(c, EV_BLOCK);
+}
+
+// Var statement checking function
+void cCheckVarStmt(Checker *c, bool isGlobal) {
+    cEnter(c, EV_VAR, &c->curToken);
+
+    while (cPeekTokenIs(c, IDENT)) {
+        cNextToken(c);
+        cCheckDeclarationStmt(c);
+
+        if (isGlobal) {
+            if (!cExpectPeek(c, SEMICOLON, ";")) {
+                cExit(c, EV_VAR);
+                return;
+            }
+        }
+    }
+
+    cExit(c, EV_VAR);
+}
+
+// Declaration statement checking function
+bool cCheckDeclarationStmt(Checker *c) {
+    cEnter(c, EV_DECLARATION, &c->curToken);
+    cLeaf(c, EV_IDENTIFIER);
+
+    while (cPeekTokenIs(c, COMMA)) {
+        cNextToken(c);
+        cNextToken(c);
+
+        cLeaf(c, EV_IDENTIFIER);
+    }
+
+    if (!cExpectPeek(c, COLON, ":")) {
+        cExit(c, EV_DECLARATION);
+        return false;
+    }
+
+    cNextToken(c);
+
+    cCheckTypeExpr(c);
+
+    cExit(c, EV_DECLARATION);
+
+    return true;
+}
+
+// Function/Procedure statement checking function, reuses the check of an earlier version of the input when it can
+void cCheckFunctionStmt(Checker *c) {
+    // Events need every node, a reused check has none
+    if (c->reuse && !c->events && cMemoReuse(c)) {
+        return;
+    }
+
+    if (c->record) {
+        uint32_t memo = cMemoBegin(c);
+        cCheckFunction(c);
+        cMemoEnd(c, memo);
+    } else {
+        cCheckFunction(c);
+    }
+}
+
+// Function/Procedure checking, from the `function` or `procedure` token to the end of its block
+void cCheckFunction(Checker *c) {
+    bool isFunction = cCurTokenIs(c, FUNCTION);
+
+    cEnter(c, EV_FUNCTION, &c->curToken);
+
+    if (!cExpectPeek(c, IDENT, "IDENT")) {
+        cExit(c, EV_FUNCTION);
+        return;
+    }
+
+    cLeaf(c, EV_IDENTIFIER);
+
+    if (cPeekTokenIs(c, LPAREN)) {
+        cNextToken(c);
+
+        while (!cPeekTokenIs(c, RPAREN)) {
+            if (!cCheckParameterStmt(c)) {
+                cCustomError(c, "Parâmetro inválido");
+                cExit(c, EV_FUNCTION);
+                return;
+            }
+
+            if (!cPeekTokenIs(c, RPAREN)) {
+                if (!cExpectPeek(c, SEMICOLON, ";")) {
+                    cExit(c, EV_FUNCTION);
+                    return;
+                }
+            }
+        }
+
+        if (!cExpectPeek(c, RPAREN, ")")) {
+            cExit(c, EV_FUNCTION);
+            return;
+        }
+    }
+
+    if (isFunction) {
+        if (!cExpectPeek(c, COLON, ":")) {
+            cExit(c, EV_FUNCTION);
+            return;
+        }
+
+        cNextToken(c);
+
+        cCheckTypeExpr(c);
+    }
+
+    if (!cExpectPeek(c, SEMICOLON, ";")) {
+        cExit(c, EV_FUNCTION);
+        return;
+    }
+
+    // Functions nest through their blocks
+    if (!pbEnter(c->l->budget)) {
+        cBudgetError(c);
+        cExit(c, EV_FUNCTION);
+        return;
+    }
+
+    cCheckBlockStmt(c);
+
+    pbLeave(c->l->budget);
+
+    cExit(c, EV_FUNCTION);
+}
+
+// Parameter statement checking function
+bool cCheckParameterStmt(Checker *c) {
+    if (cPeekTokenIs(c, VAR)) {
+        cNextToken(c);
+    }
+
+    cEnter(c, EV_PARAMETER, &c->curToken);
+
+    if (!cExpectPeek(c, IDENT, "IDENT")) {
+        cExit(c, EV_PARAMETER);
+        return false;
+    }
+
+    if (!cCheckDeclarationStmt(c)) {
+        cCustomError(c, "Declaração de parâmetro inválida");
+        cExit(c, EV_PARAMETER);
+        return false;
+    }
+
+    while (cPeekTokenIs(c, COMMA)) {
+        cNextToken(c);
+        cNextToken(c);
+
+        if (!cCheckDeclarationStmt(c)) {
+            cCustomError(c, "Declaração de parâmetro inválida");
+            cExit(c, EV_PARAMETER);
+            return false;
+        }
+    }
+
+    cExit(c, EV_PARAMETER);
+
+    return true;
+}
+
+// Begin/End statement checking function
+void cCheckBeginEndStmt(Checker *c) {
+    cEnter(c, EV_BEGIN_END, &c->curToken);
+
+    while (!cPeekTokenIs(c, END) && !cPeekTokenIs(c, _EOF)) {
+        cNextToken(c);
+        cCheckExpressionStmt(c);
+    }
+
+    cExit(c, EV_BEGIN_END);
+}
+
+// Conditional statement checking function
+void cCheckConditionalStmt(Checker *c) {
+    cEnter(c, EV_CONDITIONAL, &c->curToken);
+
+    cNextToken(c);
+    cCheckExpression(c, LOWEST);
+
+    if (!cExpectPeek(c, THEN, "THEN")) {
+        cExit(c, EV_CONDITIONAL);
+        return;
+    }
+
+    cNextToken(c);
+
+    if (cCurTokenIs(c, BEGIN)) {
+        cCheckBeginEndStmt(c);
+
+        if (!cExpectPeek(c, END, "END")) {
+            cExit(c, EV_CONDITIONAL);
+            return;
+        }
+    } else {
+        cCheckExpressionStmt(c);
+    }
+
+    if (cPeekTokenIs(c, ELSE)) {
+        cNextToken(c);
+        cNextToken(c);
+
+        if (cCurTokenIs(c, BEGIN)) {
+            cCheckBeginEndStmt(c);
+
+            if (!cExpectPeek(c, END, "END")) {
+                cExit(c, EV_CONDITIONAL);
+                return;
+            }
+        } else {
+            cCheckExpressionStmt(c);
+        }
+    }
+
+    cExit(c, EV_CONDITIONAL);
+}
+
+// While statement checking function
+void cCheckWhileStmt(Checker *c) {
+    cEnter(c, EV_WHILE, &c->curToken);
+
+    cNextToken(c);
+    cCheckExpression(c, LOWEST);
+
+    if (!cExpectPeek(c, DO, "DO")) {
+        cExit(c, EV_WHILE);
+        return;
+    }
+
+    cNextToken(c);
+
+    if (cCurTokenIs(c, BEGIN)) {
+        cCheckBeginEndStmt(c);
+
+        if (!cExpectPeek(c, END, "END")) {
+            cExit(c, EV_WHILE);
+            return;
+        }
+    } else {
+        cCheckExpressionStmt(c);
+    }
+
+    cExit(c, EV_WHILE);
+}
+
+// Expression statement checking function
+void cCheckExpressionStmt(Checker *c) {
+    // Statements nest through conditionals and loops
+    if (cCurTokenIs(c, IF) || cCurTokenIs(c, WHILE)) {
+        if (!pbEnter(c->l->budget)) {
+            cBudgetError(c);
+            return;
+        }
+
+        if (cCurTokenIs(c, IF)) {
+            cCheckConditionalStmt(c);
+        } else {
+            cCheckWhileStmt(c);
+        }
+
+        pbLeave(c->l->budget);
+        return;
+    }
+
+    cEnter(c, EV_EXPRESSION_STMT, &c->curToken);
+
+    c->assignCounter = 0;
+
+    cCheckExpression(c, LOWEST);
+
+    if (!cExpectPeek(c, SEMICOLON, ";")) {
+        cExit(c, EV_EXPRESSION_STMT);
+        return;
+    }
+
+    if (c->assignCounter > 1) {
+        cCustomError(c, "Multiplos operadores de atribuição em uma única expressão");
+    }
+
+    cExit(c, EV_EXPRESSION_STMT);
+}
+
+//
+// Expression checking functions
+//
+
+// Expression checking function
+void cCheckExpression(Checker *c, Precedence pr) {
+    // Every nested expression passes through here
+    if (!pbEnter(c->l->budget)) {
+        cBudgetError(c);
+        return;
+    }
+
+    if (!cHasPrefixParseFn(c->curToken.type)) {
+        cNoPrefixParseFnError(c, &c->curToken);
+        pbLeave(c->l->budget);
+        return;
+    }
+
+    switch (c->curToken.type) {
+        case MINUS:
+        case NOT:
+            cCheckPrefixExpr(c);
+            break;
+        case LPAREN:
+            cCheckGroupedExpr(c);
+            break;
+        case IDENT:
+            cLeaf(c, EV_IDENTIFIER);
+            break;
+        case INT:
+            cLeaf(c, EV_INTEGER);
+            break;
+        case FLOAT:
+            cLeaf(c, EV_FLOAT);
+            break;
+        case TRUE:
+        case FALSE:
+            cLeaf(c, EV_BOOLEAN);
+            break;
+        case STR:
+            cLeaf(c, EV_STRING);
+            break;
+        default:
+            cLeaf(c, EV_CHAR);
+            break;
+    }
+
+    while (!cPeekTokenIs(c, SEMICOLON) && pr < cPrecedence(c->peekToken.type)) {
+        if (!cHasInfixParseFn(c->peekToken.type)) {
+            break;
+        }
+
+        cNextToken(c);
+
+        switch (c->curToken.type) {
+            case ASSIGN:
+                cCheckAssignmentExpr(c);
+                break;
+            case LPAREN:
+                cCheckCallExpr(c);
+                break;
+            default:
+                cCheckInfixExpr(c);
+                break;
+        }
+    }
+
+    pbLeave(c->l->budget);
+}
+
+// Prefix expression checking function
+void cCheckPrefixExpr(Checker *c) {
+    cEnter(c, EV_PREFIX, &c->curToken);
+
+    cNextToken(c);
+    cCheckExpression(c, PREFIX);
+
+    cExit(c, EV_PREFIX);
+}
+
+// Infix expression checking function
+void cCheckInfixExpr(Checker *c) {
+    cEnter(c, EV_INFIX, &c->curToken);
+
+    Precedence pr = cPrecedence(c->curToken.type);
+    cNextToken(c);
+    cCheckExpression(c, pr);
+
+    cExit(c, EV_INFIX);
+}
+
+// Grouped expression checking function
+void cCheckGroupedExpr(Checker *c) {
+    cNextToken(c);
+
+    cCheckExpression(c, LOWEST);
+
+    cExpectPeek(c, RPAREN, ")");
+}
+
+// Assignment expression checking function
+void cCheckAssignmentExpr(Checker *c) {
+    c->assignCounter++;
+
+    cEnter(c, EV_ASSIGNMENT, &c->curToken);
+
+    cNextToken(c);
+    cCheckExpression(c, ASSIGNMENT);
+
+    cExit(c, EV_ASSIGNMENT);
+}
+
+// Type expression checking function
+void cCheckTypeExpr(Checker *c) {
+    if (!cCurTokenIs(c, INTEGER) && !cCurTokenIs(c, REAL) && !cCurTokenIs(c, BOOLEAN) && !cCurTokenIs(c, CHARACTER) &&
+        !cCurTokenIs(c, STRING)) {
+        cCustomError(c, "Tipo inválido");
+        return;
+    }
+
+    cLeaf(c, EV_TYPE);
+}
+
+// Call expression checking function
+void cCheckCallExpr(Checker *c) {
+    cEnter(c, EV_CALL, &c->curToken);
+
+    if (cPeekTokenIs(c, RPAREN)) {
+        cNextToken(c);
+        cExit(c, EV_CALL);
+        return;
+    }
+
+    cNextToken(c);
+
+    cCheckExpression(c, LOWEST);
+
+    while (cPeekTokenIs(c, COMMA)) {
+        cNextToken(c);
+        cNextToken(c);
+
+        cCheckExpression(c, LOWEST);
+    }
+
+    cExpectPeek(c, RPAREN, ")");
+
+    cExit(c, EV_CALL);
+}
+
+//
+// Error handling, same messages as the parser
+//
+
+// Add a custom error to the checker error list
+void cCustomError(Checker *c, char *msg) {
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": %s", c->l->line, msg);
+
+    cAddError(c, error);
+}
+
+// Add a peek error to the checker error list
+void cPeekError(Checker *c, char *str) {
+    char literal[128];
+    lSpanLiteral(c->l, &c->peekToken, literal, sizeof(literal));
+
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Esperava-se que o próximo token fosse: `%s`, em vez disso, obteve: `%s`",
+            c->l->line, str, literal);
+
+    cAddError(c, error);
+}
+
+// Add a missing prefix parse function error to the checker error list
+void cNoPrefixParseFnError(Checker *c, TokenSpan *t) {
+    char literal[128];
+    lSpanLiteral(c->l, t, literal, sizeof(literal));
+
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Nenhuma função de análise de prefixo encontrada para: `%s`", c->l->line,
+            literal);
+
+    cAddError(c, error);
+}
+
+// Add an error to the checker error list, once the check is over budget only the error that says why is added
+void cAddError(Checker *c, char *error) {
+    ParseBudget *b = c->l->budget;
+    if (b && b->status != PB_OK) {
+        cBudgetError(c);
+        return;
+    }
+
+    eAdd(c->errors, error);
+
+    if (b) {
+        pbErrors(b, c->errors->size);
+    }
+}
+
+// Add the error that says why the check stopped early, only the first time
+void cBudgetError(Checker *c) {
+    char error[160];
+    if (pbReport(c->l->budget, error, sizeof(error), c->l->line)) {
+        eAdd(c->errors, error);
+    }
+}
+
+//
+// Function check reuse
+//
+
+// Create an empty list of function checks
+cMemoList *cMemoNew() {
+    cMemoList *m = (cMemoList *)malloc(sizeof(cMemoList));
+    if (!m) {
+        return NULL;
+    }
+
+    m->data     = NULL;
+    m->size     = 0;
+    m->capacity = 0;
+    m->errors   = eNew();
+
+    return m;
+}
+
+// Free the list of function checks
+void cMemoFree(cMemoList *m) {
+    if (m) {
+        free(m->data);
+        eFree(m->errors);
+        free(m);
+    }
+}
+
+// Keep the diagnostics of the check the list was recorded in, the checker is left with an empty list
+void cMemoAdopt(cMemoList *m, Checker *c) {
+    eFree(m->errors);
+    m->errors = c->errors;
+    c->errors = eNew();
+}
+
+// Follow an edit that replaced the bytes from `start` to `end` with `length` bytes, dropping the checks it touched
+void cMemoShift(cMemoList *m, uint64_t start, uint64_t end, uint64_t length) {
+    uint32_t kept = 0;
+
+    for (uint32_t i = 0; i < m->size; i++) {
+        cMemo *memo = &m->data[i];
+
+        if (memo->start >= end) {
+            memo->start           = memo->start - (end - start) + length;
+            memo->read            = memo->read - (end - start) + length;
+            memo->position        = memo->position - (end - start) + length;
+            memo->curToken.start  = memo->curToken.start - (end - start) + length;
+            memo->peekToken.start = memo->peekToken.start - (end - start) + length;
+
+            if (memo->lineStart >= end) {
+                memo->lineStart = memo->lineStart - (end - start) + length;
+            }
+        } else if (memo->read > start) {
+            continue;
+        }
+
+        m->data[kept++] = *memo;
+    }
+
+    m->size = kept;
+}
+
+// Check of the function starting at `start`, NULL if there's none
+cMemo *cMemoFind(cMemoList *m, uint64_t start) {
+    uint32_t low  = 0;
+    uint32_t high = m->size;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+
+        if (m->data[middle].start < start) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low < m->size && m->data[low].start == start ? &m->data[low] : NULL;
+}
+
+// Skip the function at the current token if an earlier check of it still holds, returns false if there's none
+bool cMemoReuse(Checker *c) {
+    cMemo *memo = cMemoFind(c->reuse, c->curToken.start);
+    if (!memo) {
+        return false;
+    }
+
+    // The source is the same, only the lines before it can have changed
+    int64_t  lines = (int64_t)c->curToken.line - (int64_t)memo->line;
+    uint32_t first = c->errors->size;
+
+    for (uint32_t i = 0; i < memo->errorCount; i++) {
+        cMemoAddError(c->errors, c->reuse->errors->data[memo->errors + i], lines);
+    }
+
+    if (c->record) {
+        // The function and the ones nested in it start before its last token, the next function starts after it
+        cMemo *last = c->reuse->data + c->reuse->size;
+        for (cMemo *m = memo; m < last && m->start <= memo->curToken.start; m++) {
+            uint32_t index = cMemoBegin(c);
+            cMemo   *copy  = &c->record->data[index];
+
+            *copy = *m;
+            copy->line += lines;
+            copy->endLine += lines;
+            copy->curToken.line += lines;
+            copy->peekToken.line += lines;
+            copy->errors = first + (m->errors - memo->errors);
+        }
+    }
+
+    c->curToken = memo->curToken;
+    c->curToken.line += lines;
+    c->peekToken = memo->peekToken;
+    c->peekToken.line += lines;
+
+    Lexer *l        = c->l;
+    l->position     = memo->position;
+    l->readPosition = memo->position + 1;
+    l->ch           = l->position < l->length ? l->input[l->position] : 0;
+    l->line         = memo->endLine + lines;
+    l->lineStart    = memo->lineStart;
+    l->varCounter += memo->vars;
+    l->litCounter += memo->literals;
+
+    return true;
+}
+
+// Record the start of a function check, returns its slot, which stays put while nested functions are recorded after it
+uint32_t cMemoBegin(Checker *c) {
+    cMemoList *m = c->record;
+
+    if (m->size == m->capacity) {
+        m->capacity = m->capacity ? m->capacity * 2 : 16;
+        m->data     = (cMemo *)realloc(m->data, m->capacity * sizeof(cMemo));
+    }
+
+    cMemo *memo    = &m->data[m->size];
+    memo->start    = c->curToken.start;
+    memo->line     = c->curToken.line;
+    memo->errors   = c->errors->size;
+    memo->vars     = c->l->varCounter;
+    memo->literals = c->l->litCounter;
+
+    return m->size++;
+}
+
+// Record the state a function check ended in
+void cMemoEnd(Checker *c, uint32_t index) {
+    cMemo *memo = &c->record->data[index];
+    Lexer *l    = c->l;
+
+    memo->read       = l->readPosition + 1;  // The lexer peeks one byte past the current one
+    memo->curToken   = c->curToken;
+    memo->peekToken  = c->peekToken;
+    memo->position   = l->position;
+    memo->endLine    = l->line;
+    memo->lineStart  = l->lineStart;
+    memo->vars       = l->varCounter - memo->vars;
+    memo->literals   = l->litCounter - memo->literals;
+    memo->errorCount = c->errors->size - memo->errors;
+}
+
+// Add a diagnostic of a reused check, moved `lines` lines down
+void cMemoAddError(eErrorList *e, char *error, int64_t lines) {
+    if (lines == 0 || strncmp(error, "Linha ", 6) != 0) {
+        eAdd(e, error);
+        return;
+    }
+
+    char    *rest = NULL;
+    uint64_t line = strtoull(error + 6, &rest, 10);
+
+    char moved[352];
+    snprintf(moved, sizeof(moved), "Linha %" PRIu64 "%s", line + lines, rest);
+
+    eAdd(e, moved);
+}
\ No newline at end of file
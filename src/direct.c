@@ -0,0 +1,1670 @@
+#include "direct.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "checker.h"
+#include "error.h"
+#include "lexer.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Compile a program straight from its source, returns NULL if it has errors, which are added to `errors`
+// The errors are the ones runFile reports for the same input: syntax errors, else name and type errors, else the
+// limits of the virtual machine the program exceeds
+bcProgram *dcCompile(Lexer *l, eErrorList *errors) {
+    bcProgram *p = (bcProgram *)calloc(1, sizeof(bcProgram));
+    if (!p) {
+        return NULL;
+    }
+
+    DirectCompiler d;
+    memset(&d, 0, sizeof(DirectCompiler));
+    d.l      = l;
+    d.types  = tyNew();
+    d.errors = eNew();
+    d.limits = eNew();
+
+    d.bc.program = p;
+    d.bc.types   = d.types;
+    d.bc.slots   = NULL;
+    d.bc.index   = 0;
+    d.bc.depth   = 0;
+    d.bc.top     = 0;
+    d.bc.line    = 0;
+    d.bc.failed  = false;
+    d.bc.errors  = d.limits;
+
+    dcNextToken(&d);
+    dcNextToken(&d);
+
+    dcCompileProgram(&d);
+
+    eErrorList *reported = d.errors->size ? d.errors : d.types->errors->size ? d.types->errors : d.limits;
+    for (uint32_t i = 0; i < reported->size; i++) {
+        eAdd(errors, reported->data[i]);
+    }
+    bool failed = reported->size > 0 || p->size == 0;
+
+    // The names were declared without a tree to own them
+    SymbolTable *t = d.types->symbols;
+    for (uint32_t i = 1; i < t->size; i++) {
+        free(t->symbols[i].name);
+    }
+
+    tyFree(d.types);
+    free(d.bc.slots);
+    free(d.open);
+    free(d.declarations);
+    free(d.pending);
+    free(d.buffer);
+    eFree(d.errors);
+    eFree(d.limits);
+
+    if (failed) {
+        bcFree(p);
+        return NULL;
+    }
+
+    return p;
+}
+
+// Get the next token, setting the current and peek tokens
+void dcNextToken(DirectCompiler *d) {
+    d->curToken = d->peekToken;
+    lScanToken(d->l, &d->peekToken);
+}
+
+// Check if the current token is of a given type
+bool dcCurTokenIs(DirectCompiler *d, TokenType t) { return d->curToken.type == t; }
+
+// Check if the peek token is of a given type
+bool dcPeekTokenIs(DirectCompiler *d, TokenType t) { return d->peekToken.type == t; }
+
+// Check if the peek token is of a given type, and advance the token if it is
+bool dcExpectPeek(DirectCompiler *d, TokenType t, char *msg) {
+    if (dcPeekTokenIs(d, t)) {
+        dcNextToken(d);
+        return true;
+    } else {
+        dcPeekError(d, msg);
+        return false;
+    }
+}
+
+//
+// Statement compiling functions, each one mirrors its cCheck counterpart
+//
+
+// Program compiling function, the program body is function 0
+bool dcCompileProgram(DirectCompiler *d) {
+    d->bc.line = d->curToken.line;
+
+    if (!dcExpectPeek(d, IDENT, "IDENT")) {
+        return false;
+    }
+
+    dcDeclare(d, &d->curToken, SY_PROGRAM, TY_NONE);
+    d->bc.index = bcNewFunction(d->bc.program, dcSpan(d, &d->curToken));
+
+    if (!dcExpectPeek(d, SEMICOLON, ";")) {
+        return false;
+    }
+
+    dcCompileBlockStmt(d);
+    bcEmit(&d->bc, BC_HALT, 0, 0, 0);
+
+    if (!dcExpectPeek(d, DOT, ".")) {
+        return false;
+    }
+
+    if (!dcExpectPeek(d, _EOF, "EOF")) {
+        return false;
+    }
+
+    return d->errors->size == 0;
+}
+
+// Block statement compiling function
+void dcCompileBlockStmt(DirectCompiler *d) {
+    if (dcPeekTokenIs(d, VAR)) {
+        dcNextToken(d);
+        dcCompileVarStmt(d);
+    }
+
+    while (dcPeekTokenIs(d, PROCEDURE) || dcPeekTokenIs(d, FUNCTION)) {
+        dcNextToken(d);
+        dcCompileFunctionStmt(d);
+    }
+
+    if (dcPeekTokenIs(d, BEGIN)) {
+        dcNextToken(d);
+        dcCompileBeginEndStmt(d);
+    } else {
+        dcCustomError(d, "Bloco inválido, esperava-se `BEGIN`");
+        return;
+    }
+
+    dcExpectPeek(d, END, "END");
+}
+
+// Var statement compiling function, each name takes the next register of the frame, a global at the program scope
+void dcCompileVarStmt(DirectCompiler *d) {
+    bcCompiler  *c = &d->bc;
+    bcProgram   *p = c->program;
+    SymbolTable *t = d->types->symbols;
+
+    while (dcPeekTokenIs(d, IDENT)) {
+        dcNextToken(d);
+
+        d->declarationSize = 0;
+        if (dcCompileDeclarationStmt(d, false)) {
+            for (uint32_t i = 0; i < d->declarationSize; i++) {
+                dcDeclaration *declaration = &d->declarations[i];
+
+                uint32_t symbol  = dcDeclare(d, &declaration->name, SY_VARIABLE, declaration->type);
+                uint32_t slot    = bcTemporary(c);
+                c->slots[symbol] = slot;
+
+                if (c->depth == 0) {
+                    p->globals = (bcGlobal *)astGrowArray(p->globals, p->globalSize, &p->globalCapacity,
+                                                          sizeof(bcGlobal));
+
+                    bcGlobal *g = &p->globals[p->globalSize++];
+                    g->name     = strdup(t->symbols[symbol].name);
+                    g->type     = declaration->type;
+                    g->slot     = slot;
+                }
+            }
+        }
+
+        if (!dcExpectPeek(d, SEMICOLON, ";")) {
+            return;
+        }
+    }
+}
+
+// Declaration statement compiling function, the names are kept with their type until they're declared
+bool dcCompileDeclarationStmt(DirectCompiler *d, bool reference) {
+    uint32_t first = d->declarationSize;
+
+    d->declarations = (dcDeclaration *)astGrowArray(d->declarations, d->declarationSize, &d->declarationCapacity,
+                                                    sizeof(dcDeclaration));
+    d->declarations[d->declarationSize++].name = d->curToken;
+
+    while (dcPeekTokenIs(d, COMMA)) {
+        dcNextToken(d);
+        dcNextToken(d);
+
+        d->declarations = (dcDeclaration *)astGrowArray(d->declarations, d->declarationSize,
+                                                        &d->declarationCapacity, sizeof(dcDeclaration));
+        d->declarations[d->declarationSize++].name = d->curToken;
+    }
+
+    if (!dcExpectPeek(d, COLON, ":")) {
+        return false;
+    }
+
+    dcNextToken(d);
+
+    uint32_t type = dcCompileTypeExpr(d);
+    for (uint32_t i = first; i < d->declarationSize; i++) {
+        d->declarations[i].type      = type;
+        d->declarations[i].reference = reference;
+    }
+
+    return true;
+}
+
+// Function/Procedure compiling function, into a function of its own like bcCompileFunction
+void dcCompileFunctionStmt(DirectCompiler *d) {
+    bcCompiler  *c          = &d->bc;
+    TypeChecker *y          = d->types;
+    SymbolTable *t          = y->symbols;
+    bool         isFunction = dcCurTokenIs(d, FUNCTION);
+    uint64_t     line       = d->curToken.line;
+
+    if (!dcExpectPeek(d, IDENT, "IDENT")) {
+        return;
+    }
+
+    TokenSpan name     = d->curToken;
+    d->declarationSize = 0;
+
+    if (dcPeekTokenIs(d, LPAREN)) {
+        dcNextToken(d);
+
+        while (!dcPeekTokenIs(d, RPAREN)) {
+            if (!dcCompileParameterStmt(d)) {
+                dcCustomError(d, "Parâmetro inválido");
+                return;
+            }
+
+            if (!dcPeekTokenIs(d, RPAREN)) {
+                if (!dcExpectPeek(d, SEMICOLON, ";")) {
+                    return;
+                }
+            }
+        }
+
+        if (!dcExpectPeek(d, RPAREN, ")")) {
+            return;
+        }
+    }
+
+    uint32_t result = TY_VOID;
+    if (isFunction) {
+        if (!dcExpectPeek(d, COLON, ":")) {
+            return;
+        }
+
+        dcNextToken(d);
+
+        result = dcCompileTypeExpr(d);
+    }
+
+    if (!dcExpectPeek(d, SEMICOLON, ";")) {
+        return;
+    }
+
+    // Functions nest through their blocks
+    if (!pbEnter(d->l->budget)) {
+        dcBudgetError(d);
+        return;
+    }
+
+    uint32_t size = d->declarationSize;
+    for (uint32_t i = 0; i < size; i++) {
+        y->parameters    = (uint32_t *)astGrowArray(y->parameters, i, &y->parameterCapacity, sizeof(uint32_t));
+        y->parameters[i] = d->declarations[i].type | (d->declarations[i].reference ? TY_REFERENCE : 0);
+    }
+
+    uint32_t signature = tyIntern(y, result, y->parameters, size);
+    uint32_t symbol    = dcDeclare(d, &name, isFunction ? SY_FUNCTION : SY_PROCEDURE, signature);
+
+    if (c->program->size >= BC_MAX_FUNCTIONS) {
+        c->line = line;
+        bcError(c, "Programa grande demais para a máquina virtual");
+    }
+
+    uint32_t index   = bcNewFunction(c->program, t->symbols[symbol].name);
+    c->slots[symbol] = index;
+
+    uint32_t enclosing = c->index;
+    uint32_t depth     = c->depth;
+    uint32_t top       = c->top;
+
+    c->index = index;
+    c->depth = depth + 1;
+    c->top   = 0;
+    c->line  = line;
+
+    c->program->functions[index].depth = c->depth;
+
+    d->open = (uint32_t *)astGrowArray(d->open, d->openSize, &d->openCapacity, sizeof(uint32_t));
+    d->open[d->openSize++] = symbol;
+
+    uint32_t mark = syEnter(t);
+
+    for (uint32_t i = 0; i < size; i++) {
+        dcDeclaration *declaration = &d->declarations[i];
+
+        uint32_t parameter               = dcDeclare(d, &declaration->name, SY_PARAMETER, declaration->type);
+        t->symbols[parameter].reference = declaration->reference;
+        c->slots[parameter]              = bcTemporary(c);
+    }
+    c->program->functions[index].parameters = c->top;
+
+    if (isFunction) {
+        c->program->functions[index].result = bcTemporary(c);
+    }
+
+    d->declarationSize = 0;
+
+    dcCompileBlockStmt(d);
+    bcEmit(c, BC_RET, 0, 0, 0);
+
+    syLeave(t, mark);
+    d->openSize--;
+
+    c->index = enclosing;
+    c->depth = depth;
+    c->top   = top;
+
+    pbLeave(d->l->budget);
+}
+
+// Parameter statement compiling function
+bool dcCompileParameterStmt(DirectCompiler *d) {
+    bool reference = false;
+    if (dcPeekTokenIs(d, VAR)) {
+        dcNextToken(d);
+        reference = true;
+    }
+
+    if (!dcExpectPeek(d, IDENT, "IDENT")) {
+        return false;
+    }
+
+    if (!dcCompileDeclarationStmt(d, reference)) {
+        dcCustomError(d, "Declaração de parâmetro inválida");
+        return false;
+    }
+
+    while (dcPeekTokenIs(d, COMMA)) {
+        dcNextToken(d);
+        dcNextToken(d);
+
+        if (!dcCompileDeclarationStmt(d, reference)) {
+            dcCustomError(d, "Declaração de parâmetro inválida");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Begin/End statement compiling function
+void dcCompileBeginEndStmt(DirectCompiler *d) {
+    while (!dcPeekTokenIs(d, END) && !dcPeekTokenIs(d, _EOF)) {
+        dcNextToken(d);
+        dcCompileExpressionStmt(d);
+    }
+}
+
+// Body of an `if`, an `else` or a `while`, returns false if the `end` of a begin/end body is missing
+bool dcCompileBody(DirectCompiler *d) {
+    if (dcCurTokenIs(d, BEGIN)) {
+        dcCompileBeginEndStmt(d);
+        return dcExpectPeek(d, END, "END");
+    }
+
+    dcCompileExpressionStmt(d);
+    return true;
+}
+
+// Conditional statement compiling function, the jumps past each branch are patched once the branch is written
+void dcCompileConditionalStmt(DirectCompiler *d) {
+    bcCompiler *c    = &d->bc;
+    uint32_t    mark = c->top;
+
+    c->line = d->curToken.line;
+
+    dcNextToken(d);
+
+    dcItem condition;
+    dcCompileExpression(d, LOWEST, &condition);
+    dcCompileCondition(d, &condition);
+    uint32_t end = dcJump(d, &condition, false);
+
+    if (!dcExpectPeek(d, THEN, "THEN")) {
+        c->top = mark;
+        return;
+    }
+
+    dcNextToken(d);
+
+    if (dcCompileBody(d) && dcPeekTokenIs(d, ELSE)) {
+        dcNextToken(d);
+        dcNextToken(d);
+
+        uint32_t skip = bcEmit(c, BC_JMP, 0, 0, 0);
+        bcPatch(c, end, c->program->functions[c->index].size);
+        dcCompileBody(d);
+        end = skip;
+    }
+
+    bcPatch(c, end, c->program->functions[c->index].size);
+    c->top = mark;
+}
+
+// While statement compiling function, the test sits after the body like in bcCompileStatement
+// The condition is read first, so its code is set aside while the body is written and then copied after it
+void dcCompileWhileStmt(DirectCompiler *d) {
+    bcCompiler *c    = &d->bc;
+    uint32_t    mark = c->top;
+    uint64_t    line = d->curToken.line;
+
+    c->line       = line;
+    uint32_t test = bcEmit(c, BC_JMP, 0, 0, 0);
+    uint32_t body = c->program->functions[c->index].size;
+
+    dcNextToken(d);
+
+    dcItem condition;
+    dcCompileExpression(d, LOWEST, &condition);
+    dcCompileCondition(d, &condition);
+    uint32_t jump = dcJump(d, &condition, true) - body;
+
+    bcFunction *f     = &c->program->functions[c->index];
+    uint32_t    size  = f->size - body;
+    bcInstr    *code  = (bcInstr *)malloc(size * sizeof(bcInstr));
+    uint64_t   *lines = (uint64_t *)malloc(size * sizeof(uint64_t));
+    memcpy(code, &f->code[body], size * sizeof(bcInstr));
+    memcpy(lines, &f->lines[body], size * sizeof(uint64_t));
+    f->size = body;
+
+    c->top  = mark;
+    c->line = line;
+
+    if (dcExpectPeek(d, DO, "DO")) {
+        dcNextToken(d);
+        dcCompileBody(d);
+    }
+
+    uint32_t start = c->program->functions[c->index].size;
+    bcPatch(c, test, start);
+
+    for (uint32_t i = 0; i < size; i++) {
+        c->line = lines[i];
+        bcEmit(c, code[i].op, code[i].a, code[i].b, code[i].c);
+    }
+    bcPatch(c, start + jump, body);
+
+    free(code);
+    free(lines);
+
+    c->top = mark;
+}
+
+// Expression statement compiling function, the temporaries it takes are free again once it's done
+void dcCompileExpressionStmt(DirectCompiler *d) {
+    // Statements nest through conditionals and loops
+    if (dcCurTokenIs(d, IF) || dcCurTokenIs(d, WHILE)) {
+        if (!pbEnter(d->l->budget)) {
+            dcBudgetError(d);
+            return;
+        }
+
+        if (dcCurTokenIs(d, IF)) {
+            dcCompileConditionalStmt(d);
+        } else {
+            dcCompileWhileStmt(d);
+        }
+
+        pbLeave(d->l->budget);
+        return;
+    }
+
+    bcCompiler *c    = &d->bc;
+    uint32_t    mark = c->top;
+
+    c->line          = d->curToken.line;
+    d->assignCounter = 0;
+
+    dcItem o;
+    dcCompileExpression(d, LOWEST, &o);
+    dcValue(d, &o, BC_ANY);
+    c->top = mark;
+
+    if (!dcExpectPeek(d, SEMICOLON, ";")) {
+        return;
+    }
+
+    if (d->assignCounter > 1) {
+        dcCustomError(d, "Multiplos operadores de atribuição em uma única expressão");
+    }
+}
+
+// Type the condition of an `if` or `while`
+void dcCompileCondition(DirectCompiler *d, dcItem *condition) {
+    dcCheckName(d, condition);
+
+    if (condition->type != TY_BOOLEAN && condition->type != TY_ERROR) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Condição deve ser `boolean`, obteve `%s`", condition->line,
+                 tyName(condition->type));
+        eAdd(d->types->errors, error);
+    }
+}
+
+//
+// Expression compiling functions
+//
+
+// Expression compiling function, leaves in `o` what the expression compiled to so far
+void dcCompileExpression(DirectCompiler *d, Precedence pr, dcItem *o) {
+    memset(o, 0, sizeof(dcItem));
+    o->type = TY_ERROR;
+    o->line = d->curToken.line;
+    o->mark = d->bc.top;
+
+    // Every nested expression passes through here
+    if (!pbEnter(d->l->budget)) {
+        dcBudgetError(d);
+        return;
+    }
+
+    if (!cHasPrefixParseFn(d->curToken.type)) {
+        dcNoPrefixParseFnError(d, &d->curToken);
+        pbLeave(d->l->budget);
+        return;
+    }
+
+    uint64_t lines  = d->lines;
+    uint32_t errors = d->types->errors->size;
+
+    switch (d->curToken.type) {
+        case MINUS:
+        case NOT:
+            dcCompilePrefixExpr(d, o);
+            break;
+        case LPAREN:
+            dcCompileGroupedExpr(d, o);
+            break;
+        case IDENT:
+            dcCompileName(d, o);
+            break;
+        default:
+            dcCompileLiteral(d, o);
+            break;
+    }
+
+    while (!dcPeekTokenIs(d, SEMICOLON) && pr < cPrecedence(d->peekToken.type)) {
+        if (!cHasInfixParseFn(d->peekToken.type)) {
+            break;
+        }
+
+        dcNextToken(d);
+
+        switch (d->curToken.type) {
+            case ASSIGN:
+                dcCompileAssignmentExpr(d, o, errors);
+                break;
+            case LPAREN:
+                dcCompileCallExpr(d, o, errors);
+                break;
+            default:
+                dcCompileInfixExpr(d, o, lines);
+                break;
+        }
+    }
+
+    pbLeave(d->l->budget);
+}
+
+// Literal compiling function, the literal is only loaded once its use is known
+void dcCompileLiteral(DirectCompiler *d, dcItem *o) {
+    dcOperand *v = &o->left;
+    o->kind      = DC_VALUE;
+    v->literal   = true;
+    v->mark      = d->bc.top;
+
+    switch (d->curToken.type) {
+        case INT:
+            v->type    = TY_INTEGER;
+            v->value.i = strtoll(dcSpan(d, &d->curToken), NULL, 10);
+            break;
+        case FLOAT:
+            v->type    = TY_REAL;
+            v->value.r = strtod(dcSpan(d, &d->curToken), NULL);
+            break;
+        case TRUE:
+        case FALSE:
+            v->type    = TY_BOOLEAN;
+            v->value.i = dcCurTokenIs(d, TRUE);
+            break;
+        case STR:
+            v->type    = TY_STRING;
+            v->value.i = bcString(&d->bc, dcSpan(d, &d->curToken));
+            break;
+        default:
+            v->type    = TY_CHAR;
+            v->value.i = d->curToken.length ? (unsigned char)d->l->input[d->curToken.start] : 0;
+            break;
+    }
+
+    o->type = v->type;
+}
+
+// Name compiling function, the name is resolved now and typed once it's known not to be called or assigned to
+void dcCompileName(DirectCompiler *d, dcItem *o) {
+    o->kind   = DC_NAME;
+    o->type   = TY_NONE;
+    o->symbol = dcLookup(d, &d->curToken);
+}
+
+// Prefix expression compiling function, `-` of a small integer literal folds into the literal
+// `not`s pile up on the boolean they apply to, so a condition can take them as a jump on the opposite outcome
+void dcCompilePrefixExpr(DirectCompiler *d, dcItem *o) {
+    TokenSpan token = d->curToken;
+    uint32_t  mark  = d->bc.top;
+
+    dcNextToken(d);
+
+    dcItem right;
+    dcCompileExpression(d, PREFIX, &right);
+    dcCheckName(d, &right);
+
+    dcOperand *v = &right.left;
+    if (right.type == TY_ERROR) {
+        right.kind = DC_NONE;
+    } else if (token.type == MINUS && (right.type == TY_INTEGER || right.type == TY_REAL)) {
+        if (right.kind == DC_VALUE && v->literal && !v->prefixed && right.type == TY_INTEGER &&
+            v->value.i >= -BC_MAX_IMMEDIATE && v->value.i <= -(int64_t)BC_MIN_IMMEDIATE) {
+            v->value.i  = -v->value.i;
+            v->prefixed = true;
+        } else {
+            dcRead(d, &right);
+            right.kind = right.kind == DC_VALUE ? DC_NEGATION : DC_NONE;
+        }
+    } else if (token.type == NOT && right.type == TY_BOOLEAN) {
+        if (right.kind != DC_VALUE && right.kind != DC_OPERATION) {
+            dcRead(d, &right);
+        }
+        right.nots++;
+    } else {
+        char op[128];
+        lSpanLiteral(d->l, &token, op, sizeof(op));
+
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Operador `%s` não se aplica a `%s`", token.line, op,
+                 tyName(right.type));
+        eAdd(d->types->errors, error);
+
+        right.kind = DC_NONE;
+        right.type = TY_ERROR;
+    }
+
+    *o      = right;
+    o->line = token.line;
+    o->mark = mark;
+}
+
+// Grouped expression compiling function
+void dcCompileGroupedExpr(DirectCompiler *d, dcItem *o) {
+    dcNextToken(d);
+
+    dcCompileExpression(d, LOWEST, o);
+
+    dcExpectPeek(d, RPAREN, ")");
+}
+
+// Infix expression compiling function, the operation is held back until its use is known
+// `lines` is the line count when the expression started, the left operand set the line if it changed since
+void dcCompileInfixExpr(DirectCompiler *d, dcItem *o, uint64_t lines) {
+    bcCompiler *c     = &d->bc;
+    TokenSpan   token = d->curToken;
+    uint32_t    mark  = o->mark;
+
+    // The operator sets the line before its left operand is compiled, which only keeps it if it sets none itself
+    if (d->lines == lines) {
+        c->line = token.line;
+    }
+    d->lines++;
+
+    dcRead(d, o);
+
+    // The temporaries of the right operand are counted on their own, in case they move up a register
+    bcFunction *f         = &c->program->functions[c->index];
+    uint32_t    registers = f->registers;
+    uint32_t    at        = f->size;
+    uint64_t    calls     = d->calls;
+    f->registers          = c->top;
+
+    dcNextToken(d);
+
+    dcItem right;
+    dcCompileExpression(d, cPrecedence(token.type), &right);
+    dcRead(d, &right);
+
+    f             = &c->program->functions[c->index];
+    uint32_t peak = f->registers;
+    f->registers  = registers > peak ? registers : peak;
+
+    uint32_t type = TY_ERROR;
+    if (o->type != TY_ERROR && right.type != TY_ERROR) {
+        type = tyOperator(token.type, o->type, right.type);
+        if (type == TY_NONE) {
+            char op[128];
+            lSpanLiteral(d->l, &token, op, sizeof(op));
+
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": Operador `%s` não se aplica a `%s` e `%s`", token.line,
+                     op, tyName(o->type), tyName(right.type));
+            eAdd(d->types->errors, error);
+
+            type = TY_ERROR;
+        }
+    }
+
+    if (type == TY_ERROR || o->kind != DC_VALUE || right.kind != DC_VALUE) {
+        o->kind = DC_NONE;
+        o->type = type;
+        o->line = token.line;
+        return;
+    }
+
+    // Mirrors bcCompileInfix: adding a small literal leaves the other operand as is, the rest converts both
+    int64_t immediate;
+    bool    addRight = type == TY_INTEGER && (token.type == PLUS || token.type == MINUS) &&
+                    dcIsSmall(&right.left, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate);
+    bool addLeft = !addRight && type == TY_INTEGER && token.type == PLUS &&
+                   dcIsSmall(&o->left, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate);
+
+    if (!addLeft) {
+        uint32_t to = addRight ? o->left.type : dcCommonType(token.type, o->left.type, right.left.type, type);
+        if (dcPrepare(d, &o->left, &right.left, to, at, d->calls != calls)) {
+            f = &c->program->functions[c->index];
+            if (peak + 1 > BC_MAX_REGISTERS) {
+                bcError(c, "Programa grande demais para a máquina virtual");
+            } else if (peak + 1 > f->registers) {
+                f->registers = peak + 1;
+            }
+        }
+    }
+
+    o->kind     = DC_OPERATION;
+    o->type     = type;
+    o->op       = token.type;
+    o->right    = right.left;
+    o->nots     = 0;
+    o->line     = token.line;
+    o->codeLine = c->line;
+    o->mark     = mark;
+}
+
+// Assignment expression compiling function, mirrors tyCheckAssignment and bcCompileAssignment
+// `errors` is the error count when the expression started, the errors of a target that isn't a name are dropped
+void dcCompileAssignmentExpr(DirectCompiler *d, dcItem *o, uint32_t errors) {
+    bcCompiler  *c    = &d->bc;
+    SymbolTable *t    = d->types->symbols;
+    uint64_t     line = d->curToken.line;
+
+    d->assignCounter++;
+
+    uint32_t target = TY_ERROR;
+    uint32_t symbol = o->kind == DC_NAME ? o->symbol : 0;
+    if (o->kind == DC_NAME) {
+        sySymbol *s = symbol ? &t->symbols[symbol] : NULL;
+        if (s && (s->kind == SY_VARIABLE || s->kind == SY_PARAMETER)) {
+            target = s->typeId;
+        } else if (s && s->kind == SY_FUNCTION && dcIsOpen(d, symbol)) {
+            target = tySignatureOf(d->types, s->typeId)->result;
+        } else if (s) {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": Não é possível atribuir a `%.127s`", line, s->name);
+            eAdd(d->types->errors, error);
+        }
+    } else {
+        dcDropErrors(d, errors);
+
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Atribuição deve ter um identificador à esquerda", line);
+        eAdd(d->types->errors, error);
+    }
+
+    c->line = line;
+    d->lines++;
+
+    uint32_t mark = c->top;
+
+    dcNextToken(d);
+
+    dcItem value;
+    dcCompileExpression(d, ASSIGNMENT, &value);
+    dcCheckName(d, &value);
+
+    if (target != TY_ERROR && value.type != TY_ERROR && !tyAssignable(target, value.type)) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Atribuição incompatível, `%.127s` é `%s` e o valor é `%s`",
+                 line, t->symbols[symbol].name, tyName(target), tyName(value.type));
+        eAdd(d->types->errors, error);
+    } else if (target != TY_ERROR && value.type != TY_ERROR) {
+        sySymbol *s     = &t->symbols[symbol];
+        uint32_t  depth = s->depth;
+        uint32_t  slot  = c->slots[symbol];
+        if (s->kind == SY_FUNCTION) {
+            depth = s->depth + 1;
+            slot  = c->program->functions[slot].result;
+        }
+
+        // A variable of the current frame is computed in place
+        if (depth == c->depth && !s->reference) {
+            dcConverted(d, &value, target, slot);
+        } else {
+            uint32_t reg = dcConverted(d, &value, target, BC_ANY);
+
+            if (depth == c->depth) {
+                bcEmit(c, BC_STOREREF, slot, reg, 0);
+            } else if (depth == 0) {
+                bcEmit(c, BC_SETG, reg, 0, slot);
+            } else if (!s->reference) {
+                bcEmit(c, BC_SETUP, reg, c->depth - depth, slot);
+            } else {
+                uint32_t pointer = bcTemporary(c);
+                bcEmit(c, BC_GETUP, pointer, c->depth - depth, slot);
+                bcEmit(c, BC_STOREREF, pointer, reg, 0);
+            }
+
+            c->top = mark;
+        }
+    }
+
+    o->kind = DC_NONE;
+    o->type = TY_VOID;
+    o->line = line;
+}
+
+// Call expression compiling function, mirrors tyCheckCall and bcCompileCall
+// The arguments are compiled into consecutive registers as they're read, the call is written after the last one
+void dcCompileCallExpr(DirectCompiler *d, dcItem *o, uint32_t errors) {
+    bcCompiler  *c    = &d->bc;
+    SymbolTable *t    = d->types->symbols;
+    uint64_t     line = d->curToken.line;
+
+    tySignature *signature = NULL;
+    if (o->kind == DC_NAME) {
+        sySymbol *s = o->symbol ? &t->symbols[o->symbol] : NULL;
+        if (s && (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE)) {
+            signature = tySignatureOf(d->types, s->typeId);
+        } else if (s) {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` não é uma função nem um procedimento", o->line,
+                     s->name);
+            eAdd(d->types->errors, error);
+        }
+    } else {
+        dcDropErrors(d, errors);
+
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Apenas funções e procedimentos podem ser chamados", line);
+        eAdd(d->types->errors, error);
+    }
+
+    uint32_t size = signature ? signature->size : 0;
+    uint32_t base = c->top;
+    for (uint32_t i = 0; i < size; i++) {
+        bcTemporary(c);
+    }
+
+    dcItem  *callee  = signature ? o : NULL;
+    uint32_t first   = d->types->errors->size;
+    uint32_t pending = d->pendingSize;
+    uint32_t count   = 0;
+
+    if (dcPeekTokenIs(d, RPAREN)) {
+        dcNextToken(d);
+    } else {
+        dcNextToken(d);
+
+        dcCompileArgument(d, callee, count++, base);
+
+        while (dcPeekTokenIs(d, COMMA)) {
+            dcNextToken(d);
+            dcNextToken(d);
+
+            dcCompileArgument(d, callee, count++, base);
+        }
+
+        dcExpectPeek(d, RPAREN, ")");
+    }
+
+    // A wrong count is reported before the errors of the arguments, which are then only typed
+    if (signature && count != size) {
+        while (d->pendingSize > pending) {
+            dcRemoveError(d, d->pending[--d->pendingSize]);
+        }
+
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` espera %u argumento(s), obteve %u", o->line,
+                 t->symbols[o->symbol].name, size, count);
+        dcInsertError(d, first, error);
+    }
+    d->pendingSize = pending;
+
+    o->kind = DC_NONE;
+    if (signature && count == size) {
+        dcCall(d, o->symbol, base, o->line);
+
+        if (signature->result != TY_VOID) {
+            o->kind = DC_RESULT;
+        }
+    }
+
+    c->top  = base;
+    o->type = signature ? signature->result : TY_ERROR;
+    o->line = line;
+    o->mark = base;
+}
+
+// Compile an argument into its register, `callee` is NULL if the call is not checked against a signature
+void dcCompileArgument(DirectCompiler *d, dcItem *callee, uint32_t index, uint32_t base) {
+    bcCompiler  *c = &d->bc;
+    SymbolTable *t = d->types->symbols;
+
+    dcItem argument;
+    dcCompileExpression(d, LOWEST, &argument);
+    dcCheckName(d, &argument);
+
+    tySignature *signature = callee ? tySignatureOf(d->types, t->symbols[callee->symbol].typeId) : NULL;
+    if (!signature || index >= signature->size || argument.type == TY_ERROR) {
+        c->top = base + (signature ? signature->size : 0);
+        return;
+    }
+
+    char    *name      = t->symbols[callee->symbol].name;
+    uint32_t parameter = signature->parameters[index];
+
+    char error[320];
+    error[0] = '\0';
+
+    if (parameter & TY_REFERENCE) {
+        parameter &= ~TY_REFERENCE;
+
+        sySymbol *s = argument.kind == DC_NAME && argument.symbol ? &t->symbols[argument.symbol] : NULL;
+        if (!s || (s->kind != SY_VARIABLE && s->kind != SY_PARAMETER) || argument.type != parameter) {
+            snprintf(error, sizeof(error),
+                     "Linha %" PRIu64 ": Argumento %u de `%.127s` é passado por referência, deve ser uma variável `%s`",
+                     callee->line, index + 1, name, tyName(parameter));
+        } else {
+            dcAddress(d, argument.symbol, base + index);
+        }
+    } else if (!tyAssignable(parameter, argument.type)) {
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Argumento %u de `%.127s` deve ser `%s`, obteve `%s`",
+                 callee->line, index + 1, name, tyName(parameter), tyName(argument.type));
+    } else {
+        dcConverted(d, &argument, parameter, base + index);
+    }
+
+    // Kept apart until the count of the arguments is known to be right
+    if (error[0]) {
+        eAdd(d->types->errors, error);
+
+        d->pending = (uint32_t *)astGrowArray(d->pending, d->pendingSize, &d->pendingCapacity, sizeof(uint32_t));
+        d->pending[d->pendingSize++] = d->types->errors->size - 1;
+    }
+
+    c->top = base + signature->size;
+}
+
+// Type expression compiling function, returns the type id of the type name
+uint32_t dcCompileTypeExpr(DirectCompiler *d) {
+    switch (d->curToken.type) {
+        case INTEGER:
+            return TY_INTEGER;
+        case REAL:
+            return TY_REAL;
+        case BOOLEAN:
+            return TY_BOOLEAN;
+        case CHARACTER:
+            return TY_CHAR;
+        case STRING:
+            return TY_STRING;
+        default:
+            dcCustomError(d, "Tipo inválido");
+            return TY_ERROR;
+    }
+}
+
+//
+// Code
+//
+
+// Type a name used as a value like tyCheckIdentifier, a function or procedure named alone is called without arguments
+void dcCheckName(DirectCompiler *d, dcItem *o) {
+    if (o->kind != DC_NAME || o->type != TY_NONE) {
+        return;
+    }
+
+    if (!o->symbol) {
+        o->type = TY_ERROR;
+        return;
+    }
+
+    sySymbol *s = &d->types->symbols->symbols[o->symbol];
+    switch (s->kind) {
+        case SY_VARIABLE:
+        case SY_PARAMETER:
+            o->type = s->typeId;
+            break;
+        case SY_FUNCTION:
+        case SY_PROCEDURE: {
+            tySignature *signature = tySignatureOf(d->types, s->typeId);
+            if (signature->size != 0) {
+                char error[320];
+                snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` espera %u argumento(s), obteve %u",
+                         o->line, s->name, signature->size, 0);
+                eAdd(d->types->errors, error);
+            }
+            o->type = signature->result;
+            break;
+        }
+        default: {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` não tem valor", o->line, s->name);
+            eAdd(d->types->errors, error);
+            o->type = TY_ERROR;
+            break;
+        }
+    }
+}
+
+// Compute an expression used as an operand into a register, a literal stays one until the operation is written
+void dcRead(DirectCompiler *d, dcItem *o) {
+    dcCheckName(d, o);
+
+    if (o->kind == DC_VALUE && o->nots == 0) {
+        return;
+    }
+
+    uint32_t reg = BC_ANY;
+    if (o->kind != DC_NONE && o->type != TY_ERROR && o->type != TY_NONE) {
+        reg = dcValue(d, o, BC_ANY);
+    }
+    if (reg == BC_ANY) {
+        o->kind = DC_NONE;
+        return;
+    }
+
+    o->kind          = DC_VALUE;
+    o->nots          = 0;
+    o->left.literal  = false;
+    o->left.prefixed = false;
+    o->left.reg      = reg;
+    o->left.mark     = o->mark;
+    o->left.type     = o->type;
+}
+
+// Compile what an expression holds back into `dst`, or into any register if `dst` is BC_ANY, like bcCompileExpression
+uint32_t dcValue(DirectCompiler *d, dcItem *o, uint32_t dst) {
+    bcCompiler *c = &d->bc;
+
+    dcCheckName(d, o);
+    if (o->type == TY_ERROR || o->type == TY_NONE) {
+        return BC_ANY;
+    }
+
+    switch (o->kind) {
+        case DC_NAME: {
+            sySymbol *s = &d->types->symbols->symbols[o->symbol];
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                uint32_t base = c->top;
+                dcCall(d, o->symbol, base, o->line);
+                return s->kind == SY_PROCEDURE ? BC_ANY : dcResult(d, base, dst);
+            }
+            return dcVariable(d, o->symbol, dst);
+        }
+        case DC_VALUE:
+            if (o->nots == 0) {
+                return dcOperandValue(d, &o->left, dst);
+            }
+            return dcNot(d, o, dcOperandValue(d, &o->left, BC_ANY), dst);
+        case DC_RESULT:
+            return dcResult(d, o->mark, dst);
+        case DC_NEGATION: {
+            uint32_t value = dcOperandValue(d, &o->left, BC_ANY);
+            c->top         = o->mark;
+
+            uint32_t r = bcDestination(c, dst);
+            bcEmit(c, o->type == TY_REAL ? BC_NEGF : BC_NEGI, r, value, 0);
+            return r;
+        }
+        case DC_OPERATION:
+            if (o->nots == 0) {
+                return dcOperation(d, o, dst);
+            }
+            return dcNot(d, o, dcOperation(d, o, BC_ANY), dst);
+        default:
+            return BC_ANY;
+    }
+}
+
+// Compile an expression converted to a type it's assignable to, like bcCompileConverted
+uint32_t dcConverted(DirectCompiler *d, dcItem *o, uint32_t type, uint32_t dst) {
+    bcCompiler *c = &d->bc;
+
+    dcCheckName(d, o);
+
+    if (o->type == TY_INTEGER && type == TY_REAL && o->kind == DC_VALUE && o->left.literal && !o->left.prefixed) {
+        bcValue value;
+        value.r    = (double)o->left.value.i;
+        uint32_t r = bcDestination(c, dst);
+        bcEmit(c, BC_LOADK, r, 0, bcConstant(c, value));
+        return r;
+    }
+
+    if (dcWidens(o->type, type)) {
+        uint32_t value = dcValue(d, o, BC_ANY);
+        c->top         = o->mark;
+
+        uint32_t r = bcDestination(c, dst);
+        bcEmit(c, type == TY_REAL ? BC_I2F : BC_C2S, r, value, 0);
+        return r;
+    }
+
+    return dcValue(d, o, dst);
+}
+
+// Compile a jump taken when a condition is `when`, returns the jump to patch with its target, like bcCompileJump
+uint32_t dcJump(DirectCompiler *d, dcItem *o, bool when) {
+    bcCompiler *c = &d->bc;
+
+    dcCheckName(d, o);
+
+    if (o->nots % 2) {
+        when = !when;
+    }
+    o->nots = 0;
+
+    if (o->kind == DC_OPERATION) {
+        TokenType op   = o->op;
+        uint32_t  type = o->left.type;
+
+        bool comparison = op == EQ || op == NOT_EQ || op == LT || op == GT || op == LTE || op == GTE;
+        bool integral   = type == o->right.type && (type == TY_INTEGER || type == TY_BOOLEAN || type == TY_CHAR);
+
+        if (comparison && integral) {
+            if (!when) {
+                op = bcNegation(op);
+            }
+
+            c->line = o->codeLine;
+
+            int64_t immediate;
+            if (dcIsSmall(&o->right, INT16_MIN, INT16_MAX, &immediate)) {
+                uint32_t a = dcOperandValue(d, &o->left, BC_ANY);
+                return bcEmit(c, bcBranch(op, true), a, (uint32_t)immediate & 0xFFFF, 0);
+            }
+
+            uint32_t a = dcOperandValue(d, &o->left, BC_ANY);
+            uint32_t b = dcOperandValue(d, &o->right, BC_ANY);
+            if (op == GT || op == GTE) {
+                return bcEmit(c, bcBranch(op, false), b, a, 0);
+            }
+            return bcEmit(c, bcBranch(op, false), a, b, 0);
+        }
+    }
+
+    uint32_t value = dcValue(d, o, BC_ANY);
+    return bcEmit(c, when ? BC_JMPT : BC_JMPF, value, 0, 0);
+}
+
+// Write an operation held back into `dst`, like bcCompileInfix once its left operand is in its register
+uint32_t dcOperation(DirectCompiler *d, dcItem *o, uint32_t dst) {
+    bcCompiler *c  = &d->bc;
+    TokenType   op = o->op;
+
+    c->line = o->codeLine;
+
+    int64_t immediate;
+    if (o->type == TY_INTEGER && (op == PLUS || op == MINUS) &&
+        dcIsSmall(&o->right, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        uint32_t a = dcOperandValue(d, &o->left, BC_ANY);
+        c->top     = o->mark;
+        uint32_t r = bcDestination(c, dst);
+        bcEmit(c, op == PLUS ? BC_ADDIK : BC_SUBIK, r, a, (uint32_t)immediate & BC_MAX_C);
+        return r;
+    }
+
+    // Only a small literal added to the right operand is still a literal
+    if (o->left.literal && dcIsSmall(&o->left, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        uint32_t b = dcOperandValue(d, &o->right, BC_ANY);
+        c->top     = o->mark;
+        uint32_t r = bcDestination(c, dst);
+        bcEmit(c, BC_ADDIK, r, b, (uint32_t)immediate & BC_MAX_C);
+        return r;
+    }
+
+    uint32_t type = dcCommonType(op, o->left.type, o->right.type, o->type);
+    uint32_t a    = o->left.reg;
+    uint32_t b    = dcOperandConverted(d, &o->right, type);
+    c->top        = o->mark;
+    uint32_t r    = bcDestination(c, dst);
+
+    if (op == GT || op == GTE) {
+        uint32_t swap = a;
+        a             = b;
+        b             = swap;
+    }
+
+    bcEmit(c, bcOperator(op, type), r, a, b);
+    return r;
+}
+
+// Apply the `not`s of a boolean in `value`, the last one into `dst`
+uint32_t dcNot(DirectCompiler *d, dcItem *o, uint32_t value, uint32_t dst) {
+    bcCompiler *c = &d->bc;
+
+    for (uint32_t i = 1; i <= o->nots; i++) {
+        c->top     = o->mark;
+        uint32_t r = i == o->nots ? bcDestination(c, dst) : bcTemporary(c);
+        bcEmit(c, BC_NOT, r, value, 0);
+        value = r;
+    }
+
+    return value;
+}
+
+// Take the result of a call from the first register of its arguments, into `dst` or into that register
+uint32_t dcResult(DirectCompiler *d, uint32_t base, uint32_t dst) {
+    if (dst == BC_ANY) {
+        return bcTemporary(&d->bc);
+    }
+
+    bcEmit(&d->bc, BC_MOVE, dst, base, 0);
+    return dst;
+}
+
+// Load or convert the left operand of an operation once its right operand is written, at `at` where the right one
+// starts, as bcCompileInfix would have before it. A variable read in place is copied if the right operand calls a
+// function, like bcSnapshot. Returns true if the left operand took the first temporary of the operation from the right
+// one, whose registers then move up one
+bool dcPrepare(DirectCompiler *d, dcOperand *left, dcOperand *right, uint32_t type, uint32_t at, bool call) {
+    bcCompiler *c     = &d->bc;
+    uint32_t    mark  = left->mark;
+    bool        widen = dcWidens(left->type, type);
+    bool        copy  = call && !left->literal && !widen && left->reg < mark;
+    bool        shift = left->literal || ((widen || copy) && left->reg < mark);
+
+    if (!left->literal && !widen && !copy) {
+        return false;
+    }
+
+    uint32_t top = c->top;
+    if (shift) {
+        dcShift(d, at, mark);
+        if (!right->literal && right->reg >= mark) {
+            right->reg++;
+        }
+        right->mark++;
+        top++;
+    }
+
+    uint32_t from = c->program->functions[c->index].size;
+    c->top        = mark;
+
+    left->reg      = copy ? dcOperandValue(d, left, bcTemporary(c)) : dcOperandConverted(d, left, type);
+    left->literal  = false;
+    left->prefixed = false;
+    left->type     = widen ? type : left->type;
+
+    dcMove(d, at, from);
+    c->top = top;
+
+    return shift;
+}
+
+// Load an operand into `dst`, or into any register if `dst` is BC_ANY
+uint32_t dcOperandValue(DirectCompiler *d, dcOperand *operand, uint32_t dst) {
+    bcCompiler *c = &d->bc;
+
+    if (!operand->literal) {
+        if (dst == BC_ANY || dst == operand->reg) {
+            return operand->reg;
+        }
+        bcEmit(c, BC_MOVE, dst, operand->reg, 0);
+        return dst;
+    }
+
+    uint32_t r = bcDestination(c, dst);
+
+    int64_t immediate;
+    if (dcIsSmall(operand, BC_MIN_IMMEDIATE, BC_MAX_IMMEDIATE, &immediate)) {
+        bcEmit(c, BC_LOADI, r, 0, (uint32_t)immediate & BC_MAX_C);
+    } else if (operand->type == TY_STRING) {
+        bcEmit(c, BC_LOADK, r, 0, (uint32_t)operand->value.i);
+    } else {
+        bcEmit(c, BC_LOADK, r, 0, bcConstant(c, operand->value));
+    }
+
+    return r;
+}
+
+// Load an operand converted to the type of its operation into a register, like bcCompileConverted with BC_ANY
+uint32_t dcOperandConverted(DirectCompiler *d, dcOperand *operand, uint32_t type) {
+    bcCompiler *c = &d->bc;
+
+    if (!dcWidens(operand->type, type)) {
+        return dcOperandValue(d, operand, BC_ANY);
+    }
+
+    if (operand->literal && operand->type == TY_INTEGER && !operand->prefixed) {
+        bcValue value;
+        value.r    = (double)operand->value.i;
+        uint32_t r = bcTemporary(c);
+        bcEmit(c, BC_LOADK, r, 0, bcConstant(c, value));
+        return r;
+    }
+
+    uint32_t value = dcOperandValue(d, operand, BC_ANY);
+    c->top         = operand->mark;
+
+    uint32_t r = bcTemporary(c);
+    bcEmit(c, type == TY_REAL ? BC_I2F : BC_C2S, r, value, 0);
+    return r;
+}
+
+// Compile a read of a variable, like bcCompileVariable
+uint32_t dcVariable(DirectCompiler *d, uint32_t symbol, uint32_t dst) {
+    bcCompiler *c    = &d->bc;
+    sySymbol   *s    = &d->types->symbols->symbols[symbol];
+    uint32_t    slot = c->slots[symbol];
+
+    if (s->depth == c->depth && !s->reference) {
+        if (dst == BC_ANY || dst == slot) {
+            return slot;
+        }
+        bcEmit(c, BC_MOVE, dst, slot, 0);
+        return dst;
+    }
+
+    uint32_t r = bcDestination(c, dst);
+    if (s->depth == c->depth) {
+        bcEmit(c, BC_LOADREF, r, slot, 0);
+        return r;
+    }
+
+    if (s->depth == 0) {
+        bcEmit(c, BC_GETG, r, 0, slot);
+    } else {
+        bcEmit(c, BC_GETUP, r, c->depth - s->depth, slot);
+    }
+    if (s->reference) {
+        bcEmit(c, BC_LOADREF, r, r, 0);
+    }
+
+    return r;
+}
+
+// Write a call whose arguments are in the registers from `base`, the temporaries from `base` are free again
+void dcCall(DirectCompiler *d, uint32_t symbol, uint32_t base, uint64_t line) {
+    bcCompiler *c = &d->bc;
+    sySymbol   *s = &d->types->symbols->symbols[symbol];
+
+    c->line = line;
+    d->lines++;
+    d->calls++;
+
+    bcEmit(c, BC_CALL, base, c->slots[symbol], c->depth - s->depth);
+    c->top = base;
+}
+
+// Compile the address of a variable passed by reference, like bcCompileAddress
+void dcAddress(DirectCompiler *d, uint32_t symbol, uint32_t dst) {
+    bcCompiler *c    = &d->bc;
+    sySymbol   *s    = &d->types->symbols->symbols[symbol];
+    uint32_t    slot = c->slots[symbol];
+
+    if (s->depth == c->depth) {
+        bcEmit(c, s->reference ? BC_MOVE : BC_ADDR, dst, slot, 0);
+    } else if (s->reference) {
+        bcEmit(c, BC_GETUP, dst, c->depth - s->depth, slot);
+    } else if (s->depth == 0) {
+        bcEmit(c, BC_ADDRG, dst, 0, slot);
+    } else {
+        bcEmit(c, BC_ADDRUP, dst, c->depth - s->depth, slot);
+    }
+}
+
+// Check if an operand is an integer, char or boolean literal between `min` and `max`, and get its value
+bool dcIsSmall(dcOperand *operand, int64_t min, int64_t max, int64_t *value) {
+    if (!operand->literal ||
+        (operand->type != TY_INTEGER && operand->type != TY_CHAR && operand->type != TY_BOOLEAN)) {
+        return false;
+    }
+
+    *value = operand->value.i;
+    return *value >= min && *value <= max;
+}
+
+// Check if a value of type `from` is converted to be used as `to`, integers widen to real and characters to string
+bool dcWidens(uint32_t from, uint32_t to) {
+    return (from == TY_INTEGER && to == TY_REAL) || (from == TY_CHAR && to == TY_STRING);
+}
+
+// Type the operands of an operation are compared or computed in, like bcCompileInfix
+uint32_t dcCommonType(TokenType op, uint32_t left, uint32_t right, uint32_t type) {
+    if (left == TY_REAL || right == TY_REAL || op == SLASH) {
+        return TY_REAL;
+    }
+    if (left == TY_STRING || right == TY_STRING || type == TY_STRING) {
+        return TY_STRING;
+    }
+    return TY_INTEGER;
+}
+
+// Move the registers from `mark` up one in the instructions from `from` on
+void dcShift(DirectCompiler *d, uint32_t from, uint32_t mark) {
+    bcFunction *f = &d->bc.program->functions[d->bc.index];
+
+    for (uint32_t i = from; i < f->size; i++) {
+        bcInstr *in = &f->code[i];
+
+        // Which of `a`, `b` and `c` are registers
+        bool a  = true;
+        bool b  = false;
+        bool cc = false;
+        switch (in->op) {
+            case BC_HALT:
+            case BC_JMP:
+            case BC_RET:
+                a = false;
+                break;
+            case BC_MOVE:
+            case BC_ADDR:
+            case BC_LOADREF:
+            case BC_STOREREF:
+            case BC_ADDIK:
+            case BC_SUBIK:
+            case BC_NEGI:
+            case BC_NEGF:
+            case BC_I2F:
+            case BC_NOT:
+            case BC_C2S:
+            case BC_JLTI:
+            case BC_JLEI:
+            case BC_JEQI:
+            case BC_JNEI:
+                b = true;
+                break;
+            case BC_ADDI:
+            case BC_SUBI:
+            case BC_MULI:
+            case BC_DIVI:
+            case BC_MODI:
+            case BC_ADDF:
+            case BC_SUBF:
+            case BC_MULF:
+            case BC_DIVF:
+            case BC_EQI:
+            case BC_NEI:
+            case BC_LTI:
+            case BC_LEI:
+            case BC_EQF:
+            case BC_NEF:
+            case BC_LTF:
+            case BC_LEF:
+            case BC_EQS:
+            case BC_NES:
+            case BC_LTS:
+            case BC_LES:
+            case BC_AND:
+            case BC_OR:
+            case BC_CONCAT:
+                b  = true;
+                cc = true;
+                break;
+            default:  // The rest take an immediate, a constant, a global, a frame or a function past `a`
+                break;
+        }
+
+        if (a && in->a >= mark) {
+            in->a++;
+        }
+        if (b && in->b >= mark) {
+            in->b++;
+        }
+        if (cc && in->c >= mark) {
+            in->c++;
+        }
+    }
+}
+
+// Move the instructions from `from` to the end in front of the ones from `at`
+void dcMove(DirectCompiler *d, uint32_t at, uint32_t from) {
+    bcFunction *f = &d->bc.program->functions[d->bc.index];
+
+    for (uint32_t i = from; i < f->size; i++, at++) {
+        bcInstr  instr = f->code[i];
+        uint64_t line  = f->lines[i];
+
+        memmove(&f->code[at + 1], &f->code[at], (i - at) * sizeof(bcInstr));
+        memmove(&f->lines[at + 1], &f->lines[at], (i - at) * sizeof(uint64_t));
+
+        f->code[at]  = instr;
+        f->lines[at] = line;
+    }
+}
+
+//
+// Names
+//
+
+// Declare a name in the current scope with its type id, the symbol keeps its own copy of the name
+uint32_t dcDeclare(DirectCompiler *d, TokenSpan *name, syKind kind, uint32_t type) {
+    SymbolTable *t = d->types->symbols;
+
+    uint32_t symbol           = syDeclareName(t, strdup(dcSpan(d, name)), name->line, kind);
+    t->symbols[symbol].typeId = type;
+
+    d->bc.slots = (uint32_t *)astGrowArray(d->bc.slots, symbol, &d->slotCapacity, sizeof(uint32_t));
+    d->bc.slots[symbol] = 0;
+
+    return symbol;
+}
+
+// Bind a use of a name to the innermost visible symbol of that name, like syUse
+uint32_t dcLookup(DirectCompiler *d, TokenSpan *name) {
+    SymbolTable *t = d->types->symbols;
+
+    t->uses++;
+
+    char    *value  = dcSpan(d, name);
+    uint32_t symbol = syLookup(t, value);
+    if (symbol == 0) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Identificador não declarado: `%.127s`", name->line, value);
+        eAdd(t->errors, error);
+    }
+
+    return symbol;
+}
+
+// Literal of a token in the buffer, lowercased like lSpanToken unless it's a string or char literal
+char *dcSpan(DirectCompiler *d, TokenSpan *t) {
+    if (t->length + 1 > d->bufferCapacity) {
+        d->bufferCapacity = (uint32_t)t->length + 1 > 64 ? (uint32_t)t->length + 1 : 64;
+        d->buffer         = (char *)realloc(d->buffer, d->bufferCapacity);
+    }
+
+    lSpanLiteral(d->l, t, d->buffer, d->bufferCapacity);
+    return d->buffer;
+}
+
+// Check if a function is being compiled, its name is then also the variable of its result
+bool dcIsOpen(DirectCompiler *d, uint32_t symbol) {
+    for (uint32_t i = d->openSize; i > 0; i--) {
+        if (d->open[i - 1] == symbol) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// Error handling, same messages as the checker and the type checker
+//
+
+// Add an error to the syntax error list, once the compile is over budget only the error that says why is added
+void dcAddError(DirectCompiler *d, char *error) {
+    ParseBudget *b = d->l->budget;
+    if (b && b->status != PB_OK) {
+        dcBudgetError(d);
+        return;
+    }
+
+    eAdd(d->errors, error);
+
+    if (b) {
+        pbErrors(b, d->errors->size);
+    }
+}
+
+// Add the error that says why the compile stopped early, only the first time
+void dcBudgetError(DirectCompiler *d) {
+    char error[160];
+    if (pbReport(d->l->budget, error, sizeof(error), d->l->line)) {
+        eAdd(d->errors, error);
+    }
+}
+
+// Add a custom error to the syntax error list
+void dcCustomError(DirectCompiler *d, char *msg) {
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": %s", d->l->line, msg);
+
+    dcAddError(d, error);
+}
+
+// Add a peek error to the syntax error list
+void dcPeekError(DirectCompiler *d, char *str) {
+    char literal[128];
+    lSpanLiteral(d->l, &d->peekToken, literal, sizeof(literal));
+
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Esperava-se que o próximo token fosse: `%s`, em vez disso, obteve: `%s`",
+            d->l->line, str, literal);
+
+    dcAddError(d, error);
+}
+
+// Add a missing prefix parse function error to the syntax error list
+void dcNoPrefixParseFnError(DirectCompiler *d, TokenSpan *t) {
+    char literal[128];
+    lSpanLiteral(d->l, t, literal, sizeof(literal));
+
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Nenhuma função de análise de prefixo encontrada para: `%s`", d->l->line,
+            literal);
+
+    dcAddError(d, error);
+}
+
+// Insert a type error before the error at `index`, for an error the tree reports before ones already added
+void dcInsertError(DirectCompiler *d, uint32_t index, char *error) {
+    eErrorList *e = d->types->errors;
+
+    eAdd(e, error);
+
+    char *added = e->data[e->size - 1];
+    memmove(&e->data[index + 1], &e->data[index], (e->size - 1 - index) * sizeof(char *));
+    e->data[index] = added;
+}
+
+// Remove the type error at `index`
+void dcRemoveError(DirectCompiler *d, uint32_t index) {
+    eErrorList *e = d->types->errors;
+
+    free(e->data[index]);
+    memmove(&e->data[index], &e->data[index + 1], (e->size - index - 1) * sizeof(char *));
+    e->size--;
+}
+
+// Drop the type errors past the first `size`, for an expression the tree never types
+void dcDropErrors(DirectCompiler *d, uint32_t size) {
+    eErrorList *e = d->types->errors;
+
+    while (e->size > size) {
+        free(e->data[--e->size]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "escapes.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ast.h"
+#include "events.h"
+#include "symbols.h"
+#include "types.h"
+
+// Scan a statement of a body at `depth`, the functions it declares are left to the caller
+void esScanStatement(Escapes *x, astStatement *s, uint32_t depth) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                esScanStatement(x, (astStatement *)beginEnd->statements[i], depth);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            esScanExpression(x, conditional->condition, depth);
+            esScanStatement(x, conditional->consequence, depth);
+            esScanStatement(x, conditional->alternative, depth);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+            esScanExpression(x, loop->condition, depth);
+            esScanStatement(x, loop->body, depth);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            esScanExpression(x, ((astExpressionStmt *)s)->expr, depth);
+            break;
+        default:
+            break;
+    }
+}
+
+// Scan an expression of a body at `depth`
+void esScanExpression(Escapes *x, astExpression *e, uint32_t depth) {
+    if (!e || (x->visit && !x->visit(x->context, e))) {
+        return;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(x->types->symbols, identifier);
+            if ((s->kind == SY_VARIABLE || s->kind == SY_PARAMETER) && s->depth != depth) {
+                x->escapes[identifier->symbol] = true;
+            }
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call      = (astCallExpr *)e;
+            sySymbol    *s         = sySymbolOf(x->types->symbols, call->identifier);
+            tySignature *signature = tySignatureOf(x->types, s->typeId);
+
+            for (uint32_t i = 0; i < call->size; i++) {
+                if (signature->parameters[i] & TY_REFERENCE) {
+                    astIdentifierExpr *argument = (astIdentifierExpr *)call->arguments[i];
+                    if (!sySymbolOf(x->types->symbols, argument)->reference) {
+                        x->escapes[argument->symbol] = true;
+                    }
+                }
+                esScanExpression(x, call->arguments[i], depth);
+            }
+            break;
+        }
+        case EV_PREFIX:
+            esScanExpression(x, ((astPrefixExpr *)e)->right, depth);
+            break;
+        case EV_INFIX:
+            esScanExpression(x, ((astInfixExpr *)e)->left, depth);
+            esScanExpression(x, ((astInfixExpr *)e)->right, depth);
+            break;
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            sySymbol          *s          = sySymbolOf(x->types->symbols, assignment->identifier);
+
+            // The result of a function belongs to its body, one depth below the function's name
+            if ((s->kind == SY_FUNCTION ? s->depth + 1 : s->depth) != depth) {
+                x->escapes[assignment->identifier->symbol] = true;
+            }
+            esScanExpression(x, assignment->value, depth);
+            break;
+        }
+        default:
+            break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "events.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ast.h"
+#include "checker.h"
+#include "error.h"
+#include "lexer.h"
+#include "token.h"
+
+//
+// AST builder
+//
+
+// Create a new AST builder, tokens are copied out of the lexer input
+AstBuilder *evBuilderNew(Lexer *l) {
+    AstBuilder *b = (AstBuilder *)malloc(sizeof(AstBuilder));
+    if (!b) {
+        return NULL;
+    }
+
+    b->l        = l;
+    b->depth    = 0;
+    b->capacity = 16;
+    b->frames   = (evFrame *)malloc(sizeof(evFrame) * b->capacity);
+    b->program  = NULL;
+
+    return b;
+}
+
+// Free the AST builder, the built program is owned by the caller
+void evBuilderFree(AstBuilder *b) {
+    for (uint32_t i = 0; i < b->depth; i++) {
+        free(b->frames[i].children);
+    }
+
+    free(b->frames);
+    free(b);
+}
+
+// Append a built node to a frame
+void evFrameAppend(evFrame *f, evChild child) {
+    if (f->size >= f->capacity) {
+        f->capacity = f->capacity ? f->capacity * 2 : 4;
+        f->children = (evChild *)realloc(f->children, sizeof(evChild) * f->capacity);
+    }
+
+    f->children[f->size] = child;
+    f->size++;
+}
+
+// Enter event callback, starts a new node
+void evBuilderEnter(void *ctx, EventKind kind, TokenSpan *token) {
+    AstBuilder *b = (AstBuilder *)ctx;
+
+    if (b->depth >= b->capacity) {
+        b->capacity *= 2;
+        b->frames = (evFrame *)realloc(b->frames, sizeof(evFrame) * b->capacity);
+    }
+
+    evFrame *f  = &b->frames[b->depth];
+    f->kind     = kind;
+    f->token    = *token;
+    f->children = NULL;
+    f->size     = 0;
+    f->capacity = 0;
+
+    // Operators are only recognised after their left-hand side, which is the last node of the parent
+    if ((kind == EV_INFIX || kind == EV_ASSIGNMENT || kind == EV_CALL) && b->depth > 0) {
+        evFrame *parent = &b->frames[b->depth - 1];
+        if (parent->size > 0) {
+            parent->size--;
+            evFrameAppend(f, parent->children[parent->size]);
+        }
+    }
+
+    b->depth++;
+}
+
+// Exit event callback, builds the node and hands it to its parent
+void evBuilderExit(void *ctx, EventKind kind, TokenSpan *token) {
+    AstBuilder *b = (AstBuilder *)ctx;
+    (void)token;
+
+    b->depth--;
+    evFrame *f     = &b->frames[b->depth];
+    evChild  child = evBuildNode(b, f);
+    free(f->children);
+
+    if (kind == EV_PROGRAM) {
+        b->program = (astProgram *)child.node;
+    } else if (b->depth > 0) {
+        evFrameAppend(&b->frames[b->depth - 1], child);
+    }
+}
+
+// Build the AST node of a frame from its children, same layout as the pParse functions
+evChild evBuildNode(AstBuilder *b, evFrame *f) {
+    evChild  result   = {f->kind, NULL, NULL};
+    evChild *children = f->children;
+
+    switch (f->kind) {
+        case EV_PROGRAM: {
+            astProgram *program = astProgramNew(lSpanToken(b->l, &f->token));
+            for (uint32_t i = 0; i < f->size; i++) {
+                if (children[i].kind == EV_IDENTIFIER) {
+                    program->identifier = (astIdentifierExpr *)children[i].node;
+                } else {
+                    program->block = (astBlockStmt *)children[i].node;
+                }
+            }
+            result.node = program;
+            break;
+        }
+        case EV_BLOCK: {
+            astBlockStmt *block = astBlockStmtNew(NULL);
+            if (f->size > 0) {
+                block->statements = (astStatement **)malloc(sizeof(astStatement *) * f->size);
+                for (uint32_t i = 0; i < f->size; i++) {
+                    block->statements[i] = (astStatement *)children[i].node;
+                }
+                block->size     = f->size;
+                block->capacity = f->size;
+            }
+            result.node = block;
+            break;
+        }
+        case EV_VAR: {
+            astVarStmt *var = astVarStmtNew(lSpanToken(b->l, &f->token));
+            if (f->size > 0) {
+                var->declarations = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *) * f->size);
+                for (uint32_t i = 0; i < f->size; i++) {
+                    var->declarations[i] = (astDeclarationStmt *)children[i].node;
+                }
+                var->size     = f->size;
+                var->capacity = f->size;
+            }
+            result.node = var;
+            break;
+        }
+        case EV_DECLARATION: {
+            astDeclarationStmt *decl = astDeclarationStmtNew(NULL);
+            decl->identifier         = (astIdentifierExpr **)malloc(sizeof(astIdentifierExpr *) * (f->size + 1));
+            for (uint32_t i = 0; i < f->size; i++) {
+                if (children[i].kind == EV_TYPE) {
+                    decl->type = (astTypeExpr *)children[i].node;
+                } else {
+                    decl->identifier[decl->size] = (astIdentifierExpr *)children[i].node;
+                    decl->size++;
+                }
+            }
+            decl->capacity = f->size + 1;
+            if (decl->size > 0) {
+                decl->token = decl->identifier[0]->token;
+            }
+            result.node = decl;
+            break;
+        }
+        case EV_FUNCTION: {
+            astFunctionStmt *function = astFunctionStmtNew(lSpanToken(b->l, &f->token));
+            for (uint32_t i = 0; i < f->size; i++) {
+                if (children[i].kind == EV_IDENTIFIER) {
+                    function->identifier = (astIdentifierExpr *)children[i].node;
+                } else if (children[i].kind == EV_PARAMETER) {
+                    function->parameters = (astParameterStmt **)astGrowArray(
+                        function->parameters, function->size, &function->capacity, sizeof(astParameterStmt *));
+                    function->parameters[function->size] = (astParameterStmt *)children[i].node;
+                    function->size++;
+                } else if (children[i].kind == EV_TYPE) {
+                    function->returnType = (astTypeExpr *)children[i].node;
+                } else {
+                    function->block = (astBlockStmt *)children[i].node;
+                }
+            }
+            result.node = function;
+            break;
+        }
+        case EV_PARAMETER: {
+            astParameterStmt *param = astParameterStmtNew(NULL);
+            param->isVar            = f->token.type == VAR;
+            if (f->size > 0) {
+                param->declarations = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *) * f->size);
+                for (uint32_t i = 0; i < f->size; i++) {
+                    param->declarations[i] = (astDeclarationStmt *)children[i].node;
+                }
+                param->size     = f->size;
+                param->capacity = f->size;
+            }
+            result.node = param;
+            break;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = astBeginEndStmtNew(lSpanToken(b->l, &f->token));
+            if (f->size > 0) {
+                beginEnd->statements = (astExpressionStmt **)malloc(sizeof(astExpressionStmt *) * f->size);
+                for (uint32_t i = 0; i < f->size; i++) {
+                    beginEnd->statements[i] = (astExpressionStmt *)children[i].node;
+                }
+                beginEnd->size     = f->size;
+                beginEnd->capacity = f->size;
+            }
+            result.node = beginEnd;
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = astConditionalStmtNew(lSpanToken(b->l, &f->token));
+            conditional->condition          = f->size > 0 ? (astExpression *)children[0].node : NULL;
+            conditional->consequence        = f->size > 1 ? (astStatement *)children[1].node : NULL;
+            conditional->alternative        = f->size > 2 ? (astStatement *)children[2].node : NULL;
+            result.node                     = conditional;
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = astWhileStmtNew(lSpanToken(b->l, &f->token));
+            loop->condition    = f->size > 0 ? (astExpression *)children[0].node : NULL;
+            loop->body         = f->size > 1 ? (astStatement *)children[1].node : NULL;
+            result.node        = loop;
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *stmt = astExpressionStmtNew(f->size > 0 ? children[0].first : NULL);
+            stmt->expr              = f->size > 0 ? (astExpression *)children[0].node : NULL;
+            result.node             = stmt;
+            break;
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = astPrefixExprNew(lSpanToken(b->l, &f->token));
+            prefix->right         = f->size > 0 ? (astExpression *)children[0].node : NULL;
+            result.node           = prefix;
+            result.first          = prefix->token;
+            break;
+        }
+        case EV_INFIX: {
+            astInfixExpr *infix = astInfixExprNew(lSpanToken(b->l, &f->token));
+            infix->left         = f->size > 0 ? (astExpression *)children[0].node : NULL;
+            infix->right        = f->size > 1 ? (astExpression *)children[1].node : NULL;
+            result.node         = infix;
+            result.first        = f->size > 0 ? children[0].first : infix->token;
+            break;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = astAssignmentExprNew(lSpanToken(b->l, &f->token));
+            assignment->identifier        = f->size > 0 ? (astIdentifierExpr *)children[0].node : NULL;
+            assignment->value             = f->size > 1 ? (astExpression *)children[1].node : NULL;
+            result.node                   = assignment;
+            result.first                  = f->size > 0 ? children[0].first : assignment->token;
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = astCallExprNew(lSpanToken(b->l, &f->token));
+            call->identifier  = f->size > 0 ? (astIdentifierExpr *)children[0].node : NULL;
+            if (f->size > 1) {
+                call->arguments = (astExpression **)malloc(sizeof(astExpression *) * (f->size - 1));
+                for (uint32_t i = 1; i < f->size; i++) {
+                    call->arguments[i - 1] = (astExpression *)children[i].node;
+                }
+                call->size     = f->size - 1;
+                call->capacity = f->size - 1;
+            }
+            result.node  = call;
+            result.first = f->size > 0 ? children[0].first : call->token;
+            break;
+        }
+        case EV_IDENTIFIER:
+            result.node = astIdentifierExprNew(lSpanToken(b->l, &f->token));
+            break;
+        case EV_INTEGER: {
+            astIntegerExpr *integer = astIntegerExprNew(lSpanToken(b->l, &f->token));
+            integer->value          = strtoll(integer->token->literal, NULL, 10);
+            result.node             = integer;
+            break;
+        }
+        case EV_FLOAT: {
+            astFloatExpr *real = astFloatExprNew(lSpanToken(b->l, &f->token));
+            real->value        = strtod(real->token->literal, NULL);
+            result.node        = real;
+            break;
+        }
+        case EV_BOOLEAN: {
+            astBooleanExpr *boolean = astBooleanExprNew(lSpanToken(b->l, &f->token));
+            boolean->value          = f->token.type == TRUE;
+            result.node             = boolean;
+            break;
+        }
+        case EV_STRING:
+            result.node = astStringExprNew(lSpanToken(b->l, &f->token));
+            break;
+        case EV_CHAR:
+            result.node = astCharExprNew(lSpanToken(b->l, &f->token));
+            break;
+        case EV_TYPE:
+            result.node = astTypeExprNew(lSpanToken(b->l, &f->token));
+            break;
+    }
+
+    // Leaves are the first token of their own source
+    if (!result.first && f->kind >= EV_IDENTIFIER && f->kind <= EV_CHAR) {
+        result.first = ((astExpression *)result.node)->token;
+    }
+
+    return result;
+}
+
+// Parse a program through the parse events, building the same AST as pParseProgram
+astProgram *evParseProgram(Lexer *l, eErrorList **errors) {
+    AstBuilder  *b       = evBuilderNew(l);
+    EventHandler handler = {evBuilderEnter, evBuilderExit, b};
+
+    Checker *c = cNew(l);
+    c->events  = &handler;
+
+    cCheckProgram(c);
+
+    astProgram *program = b->program;
+
+    // The caller takes the errors
+    *errors   = c->errors;
+    c->errors = eNew();
+
+    cFree(c);
+    evBuilderFree(b);
+
+    return program;
+}
+
+// Node kind of an AST node, told apart by its destructor
+EventKind evKindOf(void *node) {
+    void *f = (void *)((astNode *)node)->free;
+
+    if (f == (void *)astBlockStmtFree) {
+        return EV_BLOCK;
+    }
+    if (f == (void *)astVarStmtFree) {
+        return EV_VAR;
+    }
+    if (f == (void *)astDeclarationStmtFree) {
+        return EV_DECLARATION;
+    }
+    if (f == (void *)astFunctionStmtFree) {
+        return EV_FUNCTION;
+    }
+    if (f == (void *)astParameterStmtFree) {
+        return EV_PARAMETER;
+    }
+    if (f == (void *)astBeginEndStmtFree) {
+        return EV_BEGIN_END;
+    }
+    if (f == (void *)astConditionalStmtFree) {
+        return EV_CONDITIONAL;
+    }
+    if (f == (void *)astWhileStmtFree) {
+        return EV_WHILE;
+    }
+    if (f == (void *)astExpressionStmtFree) {
+        return EV_EXPRESSION_STMT;
+    }
+    if (f == (void *)astPrefixExprFree) {
+        return EV_PREFIX;
+    }
+    if (f == (void *)astInfixExprFree) {
+        return EV_INFIX;
+    }
+    if (f == (void *)astAssignmentExprFree) {
+        return EV_ASSIGNMENT;
+    }
+    if (f == (void *)astIdentifierExprFree) {
+        return EV_IDENTIFIER;
+    }
+    if (f == (void *)astIntegerExprFree) {
+        return EV_INTEGER;
+    }
+    if (f == (void *)astFloatExprFree) {
+        return EV_FLOAT;
+    }
+    if (f == (void *)astBooleanExprFree) {
+        return EV_BOOLEAN;
+    }
+    if (f == (void *)astStringExprFree) {
+        return EV_STRING;
+    }
+    if (f == (void *)astCharExprFree) {
+        return EV_CHAR;
+    }
+    if (f == (void *)astTypeExprFree) {
+        return EV_TYPE;
+    }
+    if (f == (void *)astCallExprFree) {
+        return EV_CALL;
+    }
+
+    return EV_PROGRAM;
+}
\ No newline at end of file
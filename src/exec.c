@@ -0,0 +1,1124 @@
+#include "exec.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "error.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+#include "vm.h"
+
+// Integer arithmetic wraps around like the virtual machine's
+#define EX_WRAP(x) ((int64_t)(uint64_t)(x))
+
+// Text of a string value
+#define EX_TEXT(s) ((s) ? (s) : "")
+
+// Operator on the values of two closures, `v` gets `expr` in its `member`
+#define EX_OPERATOR(name, member, expr)    \
+    bcValue name(exNode *n, exFrame *f) {  \
+        bcValue a = n->a->eval(n->a, f);   \
+        bcValue b = n->b->eval(n->b, f);   \
+        bcValue v;                         \
+        v.member = (expr);                 \
+        return v;                          \
+    }
+
+// Integer operator on two closures, on a closure and a constant, and on a local and a constant
+#define EX_INTEGER(name, expr)                   \
+    bcValue name(exNode *n, exFrame *f) {        \
+        int64_t a = n->a->eval(n->a, f).i;       \
+        int64_t b = n->b->eval(n->b, f).i;       \
+        bcValue v;                               \
+        v.i = (expr);                            \
+        return v;                                \
+    }                                            \
+    bcValue name##K(exNode *n, exFrame *f) {     \
+        int64_t a = n->a->eval(n->a, f).i;       \
+        int64_t b = n->k.i;                      \
+        bcValue v;                               \
+        v.i = (expr);                            \
+        return v;                                \
+    }                                            \
+    bcValue name##L(exNode *n, exFrame *f) {     \
+        int64_t a = f->slots[n->slot].i;         \
+        int64_t b = n->k.i;                      \
+        bcValue v;                               \
+        v.i = (expr);                            \
+        return v;                                \
+    }
+
+// Create an executor for a program the type checker accepted, the variables of the program get their slots
+Executor *exNew(TypeChecker *types, astProgram *program) {
+    Executor *x = (Executor *)calloc(1, sizeof(Executor));
+    if (!x) {
+        return NULL;
+    }
+
+    x->types     = types;
+    x->program   = program;
+    x->slots     = (uint32_t *)calloc(types->symbols->size, sizeof(uint32_t));
+    x->functions = (exFunction **)calloc(types->symbols->size, sizeof(exFunction *));
+    x->stack     = (bcValue *)calloc(VM_STACK_SIZE, sizeof(bcValue));
+    x->end       = x->stack + VM_STACK_SIZE;
+    x->errors    = eNew();
+
+    if (!x->slots || !x->functions || !x->stack) {
+        exFree(x);
+        return NULL;
+    }
+
+    astBlockStmt *block = program->block;
+    uint32_t      size  = 0;
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) == EV_VAR) {
+            astVarStmt *var = (astVarStmt *)block->statements[i];
+            size            = exLayout(x, var->declarations, var->size, size);
+        }
+    }
+
+    x->main.name       = program->identifier ? program->identifier->value : "program";
+    x->main.depth      = 0;
+    x->main.parameters = 0;
+    x->main.result     = BC_ANY;
+    x->main.size       = size;
+    x->main.body       = exLazyNew(x, &x->main, block);
+
+    x->top = x->stack + (size < VM_STACK_SIZE ? size : VM_STACK_SIZE);
+
+    return x;
+}
+
+// Free the executor, its nodes and the strings it built, the tree and the types are left alone
+void exFree(Executor *x) {
+    for (uint32_t i = 0; i < x->blockSize; i++) {
+        free(x->blocks[i]);
+    }
+    for (uint32_t i = 0; i < x->stringSize; i++) {
+        free(x->strings[i]);
+    }
+
+    free(x->blocks);
+    free(x->strings);
+    free(x->slots);
+    free(x->functions);
+    free(x->stack);
+    eFree(x->errors);
+    free(x);
+}
+
+// Run the program, returns false if it stopped on a runtime error
+// It runs on a thread with a stack of EX_STACK_SIZE, deep enough for as many calls as the virtual machine allows
+bool exRun(Executor *x) {
+    pthread_attr_t attributes;
+    pthread_t      thread;
+
+    bool started = pthread_attr_init(&attributes) == 0;
+    if (started) {
+        started = pthread_attr_setstacksize(&attributes, EX_STACK_SIZE) == 0 &&
+                  pthread_create(&thread, &attributes, exMain, x) == 0;
+        pthread_attr_destroy(&attributes);
+    }
+
+    if (started) {
+        pthread_join(thread, NULL);
+    } else {
+        exMain(x);
+    }
+
+    return !x->failed;
+}
+
+// Run the program body in the frame of the program, whose slots are the globals
+void *exMain(void *executor) {
+    Executor *x = (Executor *)executor;
+
+    exFrame frame;
+    frame.slots    = x->stack;
+    frame.globals  = x->stack;
+    frame.link     = NULL;
+    frame.function = &x->main;
+    frame.x        = x;
+
+    if (x->main.size > VM_STACK_SIZE) {
+        exFail(&frame, x->program->token ? x->program->token->line : 0, "estouro de pilha");
+        return NULL;
+    }
+
+    x->main.body->eval(x->main.body, &frame);
+    return NULL;
+}
+
+// Print the variables of the program scope as `name = value`, in the format of vmPrintGlobals
+void exPrintGlobals(Executor *x, FILE *out) {
+    astBlockStmt *block = x->program->block;
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)block->statements[i];
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            if (!declaration) {
+                continue;
+            }
+
+            for (uint32_t k = 0; k < declaration->size; k++) {
+                // The optimizer's temporaries aren't variables of the program
+                astIdentifierExpr *identifier = declaration->identifier[k];
+                if (!identifier || sySymbolOf(x->types->symbols, identifier)->temporary) {
+                    continue;
+                }
+
+                char   *name  = identifier->value;
+                bcValue value = x->stack[x->slots[identifier->symbol]];
+
+                switch (identifier->type) {
+                    case TY_INTEGER:
+                        fprintf(out, "%s = %" PRId64 "\n", name, value.i);
+                        break;
+                    case TY_REAL:
+                        fprintf(out, "%s = %.17g\n", name, value.r);
+                        break;
+                    case TY_BOOLEAN:
+                        fprintf(out, "%s = %s\n", name, value.i ? "true" : "false");
+                        break;
+                    case TY_CHAR:
+                        fprintf(out, "%s = '%c'\n", name, (char)value.i);
+                        break;
+                    case TY_STRING:
+                        fprintf(out, "%s = \"%s\"\n", name, EX_TEXT(value.s));
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+//
+// Conversion
+//
+
+// Allocate zeroed memory the executor frees with itself
+void *exAllocate(Executor *x, size_t size) {
+    void *block = calloc(1, size ? size : 1);
+    if (!block) {
+        fprintf(stderr, "Memória insuficiente\n");
+        exit(1);
+    }
+
+    x->blocks = (void **)astGrowArray(x->blocks, x->blockSize, &x->blockCapacity, sizeof(void *));
+    x->blocks[x->blockSize++] = block;
+
+    return block;
+}
+
+// Take a zeroed node, nodes come in chunks so converting a node costs no allocation of its own
+exNode *exNodeNew(Executor *x) {
+    if (!x->chunk || x->used == EX_CHUNK) {
+        x->chunk = (exNode *)exAllocate(x, EX_CHUNK * sizeof(exNode));
+        x->used  = 0;
+    }
+
+    return &x->chunk[x->used++];
+}
+
+// Take a node that converts a node of the tree the first time it runs, a missing node does nothing
+exNode *exLazyNew(Executor *x, exFunction *scope, void *ast) {
+    exNode *n   = exNodeNew(x);
+    n->eval     = ast ? exLazy : exNothing;
+    n->function = scope;
+    n->ast      = ast;
+
+    return n;
+}
+
+// Function of a function or procedure symbol, laid out the first time a call to it is converted
+exFunction *exFunctionOf(Executor *x, uint32_t symbol) {
+    if (x->functions[symbol]) {
+        return x->functions[symbol];
+    }
+
+    sySymbol        *s        = &x->types->symbols->symbols[symbol];
+    astFunctionStmt *function = s->function;
+    exFunction      *g        = (exFunction *)exAllocate(x, sizeof(exFunction));
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        if (parameter) {
+            size = exLayout(x, parameter->declarations, parameter->size, size);
+        }
+    }
+
+    g->name       = function->identifier->value;
+    g->depth      = s->depth + 1;
+    g->parameters = size;
+    g->result     = function->returnType ? size++ : BC_ANY;
+
+    astBlockStmt *block = function->block;
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) == EV_VAR) {
+            astVarStmt *var = (astVarStmt *)block->statements[i];
+            size            = exLayout(x, var->declarations, var->size, size);
+        }
+    }
+
+    g->size = size;
+    g->body = exLazyNew(x, g, block);
+
+    x->functions[symbol] = g;
+    return g;
+}
+
+// Give each declared name the next slot of a frame from `slot` on, returns the slot after the last one
+uint32_t exLayout(Executor *x, astDeclarationStmt **declarations, uint32_t size, uint32_t slot) {
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        if (!declaration) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < declaration->size; j++) {
+            if (declaration->identifier[j]) {
+                x->slots[declaration->identifier[j]->symbol] = slot++;
+            }
+        }
+    }
+
+    return slot;
+}
+
+// Convert a lazy node into the closure of the node of the tree it stands for, its children start out lazy
+void exConvert(Executor *x, exNode *n) {
+    exFunction *scope = n->function;
+    void       *ast   = n->ast;
+
+    x->converted++;
+
+    switch (evKindOf(ast)) {
+        case EV_BLOCK: {
+            astBlockStmt *block = (astBlockStmt *)ast;
+            exConvertBlock(x, n, block->statements, block->size);
+            break;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)ast;
+            exConvertBlock(x, n, (astStatement **)beginEnd->statements, beginEnd->size);
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)ast;
+
+            n->a    = exLazyNew(x, scope, conditional->condition);
+            n->b    = exLazyNew(x, scope, conditional->consequence);
+            n->c    = exLazyNew(x, scope, conditional->alternative);
+            n->eval = exIf;
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)ast;
+
+            n->a    = exLazyNew(x, scope, loop->condition);
+            n->b    = exLazyNew(x, scope, loop->body);
+            n->eval = exWhile;
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            // The statement is its expression, whose value goes unused
+            n->ast  = ((astExpressionStmt *)ast)->expr;
+            n->eval = exNothing;
+            if (n->ast) {
+                exConvert(x, n);
+            }
+            break;
+        }
+        case EV_INTEGER:
+            n->k.i  = ((astIntegerExpr *)ast)->value;
+            n->eval = exConstant;
+            break;
+        case EV_FLOAT:
+            n->k.r  = ((astFloatExpr *)ast)->value;
+            n->eval = exConstant;
+            break;
+        case EV_BOOLEAN:
+            n->k.i  = ((astBooleanExpr *)ast)->value;
+            n->eval = exConstant;
+            break;
+        case EV_CHAR:
+            n->k.i  = (unsigned char)((astCharExpr *)ast)->value;
+            n->eval = exConstant;
+            break;
+        case EV_STRING: {
+            char *value = ((astStringExpr *)ast)->value;
+            n->k.s      = *value ? value : NULL;
+            n->eval     = exConstant;
+            break;
+        }
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)ast;
+            sySymbol          *s          = sySymbolOf(x->types->symbols, identifier);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                exConvertCall(x, n, identifier, NULL, 0);
+            } else {
+                exConvertVariable(x, n, identifier);
+            }
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)ast;
+            exConvertCall(x, n, call->identifier, call->arguments, call->size);
+            break;
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)ast;
+
+            n->a = exLazyNew(x, scope, prefix->right);
+            if (prefix->token->type == NOT) {
+                n->eval = exNot;
+            } else {
+                n->eval = prefix->type == TY_REAL ? exNegF : exNegI;
+            }
+            break;
+        }
+        case EV_INFIX:
+            exConvertInfix(x, n, (astInfixExpr *)ast);
+            break;
+        case EV_ASSIGNMENT:
+            exConvertAssignment(x, n, (astAssignmentExpr *)ast);
+            break;
+        default:
+            n->eval = exNothing;
+            break;
+    }
+}
+
+// Convert the statements of a block or a begin-end, declarations take no part, a single statement takes the node
+void exConvertBlock(Executor *x, exNode *n, astStatement **statements, uint32_t size) {
+    exFunction   *scope = n->function;
+    astStatement *last  = NULL;
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (statements[i] && evKindOf(statements[i]) != EV_VAR && evKindOf(statements[i]) != EV_FUNCTION) {
+            last = statements[i];
+            count++;
+        }
+    }
+
+    if (count <= 1) {
+        n->ast  = last;
+        n->eval = exNothing;
+        if (last) {
+            exConvert(x, n);
+        }
+        return;
+    }
+
+    n->list = (exNode **)exAllocate(x, count * sizeof(exNode *));
+    for (uint32_t i = 0; i < size; i++) {
+        if (statements[i] && evKindOf(statements[i]) != EV_VAR && evKindOf(statements[i]) != EV_FUNCTION) {
+            n->list[n->size++] = exLazyNew(x, scope, statements[i]);
+        }
+    }
+
+    n->eval = exSequence;
+}
+
+/*
+Convert an infix expression, the operands are converted to the type the operator computes in, like bcCompileInfix.
+Integer operators take a constant right operand inline, and a local left operand as well if the right one is constant.
+*/
+void exConvertInfix(Executor *x, exNode *n, astInfixExpr *infix) {
+    exFunction *scope = n->function;
+    TokenType   op    = infix->token->type;
+    uint32_t    left  = infix->left->type;
+    uint32_t    right = infix->right->type;
+    uint32_t    slot  = 0;
+    bcValue     k;
+
+    // Type the operands are compared or computed in
+    uint32_t type = TY_INTEGER;
+    if (left == TY_REAL || right == TY_REAL || op == SLASH) {
+        type = TY_REAL;
+    } else if (left == TY_STRING || right == TY_STRING || infix->type == TY_STRING) {
+        type = TY_STRING;
+    }
+
+    if (type == TY_INTEGER && exIsConstant(infix->right, &k)) {
+        bool      local = exIsLocal(x, scope, infix->left, &slot);
+        exClosure eval  = NULL;
+
+        switch (op) {
+            case PLUS:
+                eval = local ? exAddIL : exAddIK;
+                break;
+            case MINUS:
+                eval = local ? exSubIL : exSubIK;
+                break;
+            case ASTERISK:
+                eval = local ? exMulIL : exMulIK;
+                break;
+            case EQ:
+                eval = local ? exEqIL : exEqIK;
+                break;
+            case NOT_EQ:
+                eval = local ? exNeIL : exNeIK;
+                break;
+            case LT:
+                eval = local ? exLtIL : exLtIK;
+                break;
+            case LTE:
+                eval = local ? exLeIL : exLeIK;
+                break;
+            case GT:
+                eval = local ? exGtIL : exGtIK;
+                break;
+            case GTE:
+                eval = local ? exGeIL : exGeIK;
+                break;
+            default:
+                break;
+        }
+
+        if (eval) {
+            n->k    = k;
+            n->slot = slot;
+            n->a    = local ? NULL : exLazyNew(x, scope, infix->left);
+            n->eval = eval;
+            return;
+        }
+    }
+
+    n->a = exConverted(x, scope, infix->left, type);
+    n->b = exConverted(x, scope, infix->right, type);
+
+    if (op == DIV || op == MOD || op == SLASH) {
+        n->line = exLine(x, (astExpression *)infix, 0);
+    }
+
+    switch (op) {
+        case PLUS:
+            n->eval = type == TY_STRING ? exConcat : type == TY_REAL ? exAddF : exAddI;
+            break;
+        case MINUS:
+            n->eval = type == TY_REAL ? exSubF : exSubI;
+            break;
+        case ASTERISK:
+            n->eval = type == TY_REAL ? exMulF : exMulI;
+            break;
+        case SLASH:
+            n->eval = exDivF;
+            break;
+        case DIV:
+            n->eval = exDivI;
+            break;
+        case MOD:
+            n->eval = exModI;
+            break;
+        case AND:
+            n->eval = exAnd;
+            break;
+        case OR:
+            n->eval = exOr;
+            break;
+        case EQ:
+            n->eval = type == TY_STRING ? exEqS : type == TY_REAL ? exEqF : exEqI;
+            break;
+        case NOT_EQ:
+            n->eval = type == TY_STRING ? exNeS : type == TY_REAL ? exNeF : exNeI;
+            break;
+        case LT:
+            n->eval = type == TY_STRING ? exLtS : type == TY_REAL ? exLtF : exLtI;
+            break;
+        case LTE:
+            n->eval = type == TY_STRING ? exLeS : type == TY_REAL ? exLeF : exLeI;
+            break;
+        case GT:
+            n->eval = type == TY_STRING ? exGtS : type == TY_REAL ? exGtF : exGtI;
+            break;
+        case GTE:
+            n->eval = type == TY_STRING ? exGeS : type == TY_REAL ? exGeF : exGeI;
+            break;
+        default:
+            n->eval = exNothing;
+            break;
+    }
+}
+
+// Convert a read of a variable, from the current frame, the program frame, or a frame up the static links
+void exConvertVariable(Executor *x, exNode *n, astIdentifierExpr *identifier) {
+    exFunction *scope = n->function;
+    sySymbol   *s     = sySymbolOf(x->types->symbols, identifier);
+
+    n->slot  = x->slots[identifier->symbol];
+    n->links = scope->depth - s->depth;
+
+    if (s->depth == scope->depth) {
+        n->eval = s->reference ? exLocalRef : exLocal;
+    } else if (s->depth == 0) {
+        n->eval = exGlobal;
+    } else {
+        n->eval = s->reference ? exUpRef : exUp;
+    }
+}
+
+// Convert a call, the arguments are computed into the slots that become the first slots of the callee's frame
+void exConvertCall(Executor *x, exNode *n, astIdentifierExpr *callee, astExpression **arguments, uint32_t size) {
+    exFunction  *scope     = n->function;
+    sySymbol    *s         = sySymbolOf(x->types->symbols, callee);
+    tySignature *signature = tySignatureOf(x->types, s->typeId);
+
+    n->list = size ? (exNode **)exAllocate(x, size * sizeof(exNode *)) : NULL;
+    n->size = size;
+    for (uint32_t i = 0; i < size; i++) {
+        if (signature->parameters[i] & TY_REFERENCE) {
+            n->list[i] = exAddressOf(x, scope, (astIdentifierExpr *)arguments[i]);
+        } else {
+            n->list[i] = exConverted(x, scope, arguments[i], signature->parameters[i]);
+        }
+    }
+
+    n->function = exFunctionOf(x, callee->symbol);
+    n->links    = scope->depth - s->depth;
+    n->line     = callee->token->line;
+    n->eval     = exCall;
+}
+
+// Convert an assignment, assigning to the name of a function sets the result slot of its frame
+void exConvertAssignment(Executor *x, exNode *n, astAssignmentExpr *assignment) {
+    exFunction        *scope      = n->function;
+    astIdentifierExpr *identifier = assignment->identifier;
+    sySymbol          *s          = sySymbolOf(x->types->symbols, identifier);
+
+    uint32_t depth = s->depth;
+    uint32_t slot  = x->slots[identifier->symbol];
+    if (s->kind == SY_FUNCTION) {
+        depth = s->depth + 1;
+        slot  = exFunctionOf(x, identifier->symbol)->result;
+    }
+
+    n->a     = exConverted(x, scope, assignment->value, identifier->type);
+    n->slot  = slot;
+    n->links = scope->depth - depth;
+
+    if (depth == scope->depth) {
+        n->eval = s->reference ? exSetLocalRef : exSetLocal;
+    } else if (depth == 0) {
+        n->eval = exSetGlobal;
+    } else {
+        n->eval = s->reference ? exSetUpRef : exSetUp;
+    }
+}
+
+// Node of an expression converted to a type it's assignable to, integers widen to real and characters to string
+exNode *exConverted(Executor *x, exFunction *scope, astExpression *e, uint32_t type) {
+    if (e->type == TY_INTEGER && type == TY_REAL && evKindOf(e) == EV_INTEGER) {
+        exNode *n = exNodeNew(x);
+        n->k.r    = (double)((astIntegerExpr *)e)->value;
+        n->eval   = exConstant;
+        return n;
+    }
+
+    if ((e->type == TY_INTEGER && type == TY_REAL) || (e->type == TY_CHAR && type == TY_STRING)) {
+        exNode *n = exNodeNew(x);
+        n->a      = exLazyNew(x, scope, e);
+        n->eval   = type == TY_REAL ? exI2F : exC2S;
+        return n;
+    }
+
+    return exLazyNew(x, scope, e);
+}
+
+// Node of the address of a variable passed by reference, a reference parameter passes on the address it holds
+exNode *exAddressOf(Executor *x, exFunction *scope, astIdentifierExpr *identifier) {
+    sySymbol *s = sySymbolOf(x->types->symbols, identifier);
+    exNode   *n = exNodeNew(x);
+
+    n->slot  = x->slots[identifier->symbol];
+    n->links = scope->depth - s->depth;
+
+    if (s->depth == scope->depth) {
+        n->eval = s->reference ? exLocal : exAddress;
+    } else if (s->reference) {
+        n->eval = exUp;
+    } else if (s->depth == 0) {
+        n->eval = exAddressGlobal;
+    } else {
+        n->eval = exAddressUp;
+    }
+
+    return n;
+}
+
+// Check if an expression is an integer, char or boolean literal, or a negated integer literal, and get its value
+bool exIsConstant(astExpression *e, bcValue *value) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            value->i = ((astIntegerExpr *)e)->value;
+            return true;
+        case EV_CHAR:
+            value->i = (unsigned char)((astCharExpr *)e)->value;
+            return true;
+        case EV_BOOLEAN:
+            value->i = ((astBooleanExpr *)e)->value;
+            return true;
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+            if (prefix->token->type != MINUS || evKindOf(prefix->right) != EV_INTEGER) {
+                return false;
+            }
+            value->i = EX_WRAP(0 - (uint64_t)((astIntegerExpr *)prefix->right)->value);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Check if an expression reads a variable of the current frame in place, not through a reference, and get its slot
+bool exIsLocal(Executor *x, exFunction *scope, astExpression *e, uint32_t *slot) {
+    if (evKindOf(e) != EV_IDENTIFIER) {
+        return false;
+    }
+
+    astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+    sySymbol          *s          = sySymbolOf(x->types->symbols, identifier);
+    if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE || s->depth != scope->depth || s->reference) {
+        return false;
+    }
+
+    *slot = x->slots[identifier->symbol];
+    return true;
+}
+
+/*
+Line the virtual machine gives the instructions that end an expression compiled when the line was `line`.
+bcCompile sets the line as it enters an operator or an assignment and after the arguments of a call, so the
+instruction of an operator carries the last line set inside it, its own unless an operand set one after it.
+*/
+uint64_t exLine(Executor *x, astExpression *e, uint64_t line) {
+    switch (evKindOf(e)) {
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)e;
+            return exLine(x, infix->right, exLine(x, infix->left, infix->token->line));
+        }
+        case EV_PREFIX:
+            return exLine(x, ((astPrefixExpr *)e)->right, line);
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            return exLine(x, assignment->value, assignment->token->line);
+        }
+        case EV_CALL:
+            return ((astCallExpr *)e)->identifier->token->line;
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(x->types->symbols, (astIdentifierExpr *)e);
+            return s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE ? e->token->line : line;
+        }
+        default:
+            return line;
+    }
+}
+
+//
+// Runtime
+//
+
+// Stop the run on a runtime error in the function of a frame, in the format of vmError, only the first one counts
+void exFail(exFrame *f, uint64_t line, char *msg) {
+    Executor *x = f->x;
+    if (x->failed) {
+        return;
+    }
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": Erro de execução em `%.127s`: %s", line, f->function->name,
+             msg);
+    eAdd(x->errors, error);
+
+    x->failed = true;
+}
+
+// Count a loop iteration or a call against the budget, once it's used up the run stops as on an error but reports none
+bool exSpend(Executor *x) {
+    if (x->budget == 0 || --x->budget > 0) {
+        return true;
+    }
+
+    x->exhausted = true;
+    x->failed    = true;
+    return false;
+}
+
+// Join two strings into a new one the executor owns, NULL stands for the empty string
+char *exString(Executor *x, char *left, char *right) {
+    size_t leftLength  = strlen(EX_TEXT(left));
+    size_t rightLength = strlen(EX_TEXT(right));
+    if (leftLength + rightLength == 0) {
+        return NULL;
+    }
+
+    char *s = (char *)malloc(leftLength + rightLength + 1);
+    memcpy(s, EX_TEXT(left), leftLength);
+    memcpy(s + leftLength, EX_TEXT(right), rightLength + 1);
+
+    x->strings = (char **)astGrowArray(x->strings, x->stringSize, &x->stringCapacity, sizeof(char *));
+    x->strings[x->stringSize++] = s;
+
+    return s;
+}
+
+// Convert the node on its first run, then run the closure it became
+bcValue exLazy(exNode *n, exFrame *f) {
+    exConvert(f->x, n);
+    return n->eval(n, f);
+}
+
+// Empty statement
+bcValue exNothing(exNode *n, exFrame *f) {
+    (void)f;
+    return n->k;
+}
+
+// Run statements in order until one stops on a runtime error
+bcValue exSequence(exNode *n, exFrame *f) {
+    Executor *x = f->x;
+
+    for (uint32_t i = 0; i < n->size; i++) {
+        exNode *s = n->list[i];
+        s->eval(s, f);
+        if (x->failed) {
+            break;
+        }
+    }
+
+    return n->k;
+}
+
+// if a then b else c
+bcValue exIf(exNode *n, exFrame *f) {
+    int64_t condition = n->a->eval(n->a, f).i;
+    if (f->x->failed) {
+        return n->k;
+    }
+
+    if (condition) {
+        n->b->eval(n->b, f);
+    } else {
+        n->c->eval(n->c, f);
+    }
+
+    return n->k;
+}
+
+// while a do b
+bcValue exWhile(exNode *n, exFrame *f) {
+    Executor *x = f->x;
+
+    while (n->a->eval(n->a, f).i) {
+        if (x->failed || !exSpend(x)) {
+            break;
+        }
+        n->b->eval(n->b, f);
+        if (x->failed) {
+            break;
+        }
+    }
+
+    return n->k;
+}
+
+// k
+bcValue exConstant(exNode *n, exFrame *f) {
+    (void)f;
+    return n->k;
+}
+
+// Variable of the current frame
+bcValue exLocal(exNode *n, exFrame *f) {
+    return f->slots[n->slot];
+}
+
+// Variable a reference parameter of the current frame points to
+bcValue exLocalRef(exNode *n, exFrame *f) {
+    return *f->slots[n->slot].p;
+}
+
+// Variable of the program
+bcValue exGlobal(exNode *n, exFrame *f) {
+    return f->globals[n->slot];
+}
+
+// Variable of the frame `links` static links up
+bcValue exUp(exNode *n, exFrame *f) {
+    for (uint32_t k = n->links; k > 0; k--) {
+        f = f->link;
+    }
+    return f->slots[n->slot];
+}
+
+// Variable a reference parameter of the frame `links` static links up points to
+bcValue exUpRef(exNode *n, exFrame *f) {
+    for (uint32_t k = n->links; k > 0; k--) {
+        f = f->link;
+    }
+    return *f->slots[n->slot].p;
+}
+
+// Variable of the current frame = a
+bcValue exSetLocal(exNode *n, exFrame *f) {
+    bcValue value     = n->a->eval(n->a, f);
+    f->slots[n->slot] = value;
+    return n->k;
+}
+
+// Variable a reference parameter of the current frame points to = a
+bcValue exSetLocalRef(exNode *n, exFrame *f) {
+    bcValue value        = n->a->eval(n->a, f);
+    *f->slots[n->slot].p = value;
+    return n->k;
+}
+
+// Variable of the program = a
+bcValue exSetGlobal(exNode *n, exFrame *f) {
+    bcValue value       = n->a->eval(n->a, f);
+    f->globals[n->slot] = value;
+    return n->k;
+}
+
+// Variable of the frame `links` static links up = a
+bcValue exSetUp(exNode *n, exFrame *f) {
+    bcValue  value = n->a->eval(n->a, f);
+    exFrame *up    = f;
+    for (uint32_t k = n->links; k > 0; k--) {
+        up = up->link;
+    }
+    up->slots[n->slot] = value;
+    return n->k;
+}
+
+// Variable a reference parameter of the frame `links` static links up points to = a
+bcValue exSetUpRef(exNode *n, exFrame *f) {
+    bcValue  value = n->a->eval(n->a, f);
+    exFrame *up    = f;
+    for (uint32_t k = n->links; k > 0; k--) {
+        up = up->link;
+    }
+    *up->slots[n->slot].p = value;
+    return n->k;
+}
+
+// Address of a variable of the current frame
+bcValue exAddress(exNode *n, exFrame *f) {
+    bcValue v;
+    v.p = &f->slots[n->slot];
+    return v;
+}
+
+// Address of a variable of the program
+bcValue exAddressGlobal(exNode *n, exFrame *f) {
+    bcValue v;
+    v.p = &f->globals[n->slot];
+    return v;
+}
+
+// Address of a variable of the frame `links` static links up
+bcValue exAddressUp(exNode *n, exFrame *f) {
+    for (uint32_t k = n->links; k > 0; k--) {
+        f = f->link;
+    }
+
+    bcValue v;
+    v.p = &f->slots[n->slot];
+    return v;
+}
+
+// Call a function, with the static link to the frame `links` up, the rest of the callee's frame starts zeroed
+// The arguments are computed before the limits are checked, so a call fails where the virtual machine's CALL does
+bcValue exCall(exNode *n, exFrame *f) {
+    Executor   *x      = f->x;
+    exFunction *callee = n->function;
+    bcValue    *slots  = x->top;
+    bcValue     result;
+
+    result.i = 0;
+    if (x->failed || !exSpend(x)) {
+        return result;
+    }
+
+    if ((uint64_t)(x->end - slots) < callee->size) {
+        for (uint32_t i = 0; i < n->size; i++) {
+            n->list[i]->eval(n->list[i], f);
+        }
+        exFail(f, n->line, "estouro de pilha");
+        return result;
+    }
+
+    x->top = slots + callee->size;
+    for (uint32_t i = 0; i < n->size; i++) {
+        slots[i] = n->list[i]->eval(n->list[i], f);
+    }
+
+    if (!x->failed && x->depth == VM_MAX_FRAMES - 1) {
+        exFail(f, n->line, "estouro de pilha");
+    }
+    if (x->failed) {
+        x->top = slots;
+        return result;
+    }
+
+    exFrame *link = f;
+    for (uint32_t k = n->links; k > 0; k--) {
+        link = link->link;
+    }
+
+    memset(slots + callee->parameters, 0, (callee->size - callee->parameters) * sizeof(bcValue));
+
+    exFrame frame;
+    frame.slots    = slots;
+    frame.globals  = f->globals;
+    frame.link     = link;
+    frame.function = callee;
+    frame.x        = x;
+
+    x->depth++;
+    callee->body->eval(callee->body, &frame);
+    x->depth--;
+
+    x->top = slots;
+    if (callee->result != BC_ANY) {
+        result = slots[callee->result];
+    }
+
+    return result;
+}
+
+EX_INTEGER(exAddI, EX_WRAP((uint64_t)a + (uint64_t)b))
+EX_INTEGER(exSubI, EX_WRAP((uint64_t)a - (uint64_t)b))
+EX_INTEGER(exMulI, EX_WRAP((uint64_t)a * (uint64_t)b))
+EX_INTEGER(exEqI, a == b)
+EX_INTEGER(exNeI, a != b)
+EX_INTEGER(exLtI, a < b)
+EX_INTEGER(exLeI, a <= b)
+EX_INTEGER(exGtI, a > b)
+EX_INTEGER(exGeI, a >= b)
+
+// a div b
+bcValue exDivI(exNode *n, exFrame *f) {
+    int64_t a = n->a->eval(n->a, f).i;
+    int64_t b = n->b->eval(n->b, f).i;
+    bcValue v;
+
+    if (b == 0) {
+        exFail(f, n->line, "divisão por zero");
+        v.i = 0;
+        return v;
+    }
+
+    v.i = b == -1 ? EX_WRAP(0 - (uint64_t)a) : a / b;
+    return v;
+}
+
+// a mod b
+bcValue exModI(exNode *n, exFrame *f) {
+    int64_t a = n->a->eval(n->a, f).i;
+    int64_t b = n->b->eval(n->b, f).i;
+    bcValue v;
+
+    if (b == 0) {
+        exFail(f, n->line, "divisão por zero");
+        v.i = 0;
+        return v;
+    }
+
+    v.i = b == -1 ? 0 : a % b;
+    return v;
+}
+
+// -a
+bcValue exNegI(exNode *n, exFrame *f) {
+    bcValue v;
+    v.i = EX_WRAP(0 - (uint64_t)n->a->eval(n->a, f).i);
+    return v;
+}
+
+EX_OPERATOR(exAddF, r, a.r + b.r)
+EX_OPERATOR(exSubF, r, a.r - b.r)
+EX_OPERATOR(exMulF, r, a.r * b.r)
+
+// a / b
+bcValue exDivF(exNode *n, exFrame *f) {
+    double  a = n->a->eval(n->a, f).r;
+    double  b = n->b->eval(n->b, f).r;
+    bcValue v;
+
+    if (b == 0) {
+        exFail(f, n->line, "divisão por zero");
+        v.r = 0;
+        return v;
+    }
+
+    v.r = a / b;
+    return v;
+}
+
+// -a
+bcValue exNegF(exNode *n, exFrame *f) {
+    bcValue v;
+    v.r = -n->a->eval(n->a, f).r;
+    return v;
+}
+
+// Real of integer a
+bcValue exI2F(exNode *n, exFrame *f) {
+    bcValue v;
+    v.r = (double)n->a->eval(n->a, f).i;
+    return v;
+}
+
+EX_OPERATOR(exEqF, i, a.r == b.r)
+EX_OPERATOR(exNeF, i, a.r != b.r)
+EX_OPERATOR(exLtF, i, a.r < b.r)
+EX_OPERATOR(exLeF, i, a.r <= b.r)
+EX_OPERATOR(exGtF, i, b.r < a.r)
+EX_OPERATOR(exGeF, i, b.r <= a.r)
+
+EX_OPERATOR(exEqS, i, strcmp(EX_TEXT(a.s), EX_TEXT(b.s)) == 0)
+EX_OPERATOR(exNeS, i, strcmp(EX_TEXT(a.s), EX_TEXT(b.s)) != 0)
+EX_OPERATOR(exLtS, i, strcmp(EX_TEXT(a.s), EX_TEXT(b.s)) < 0)
+EX_OPERATOR(exLeS, i, strcmp(EX_TEXT(a.s), EX_TEXT(b.s)) <= 0)
+EX_OPERATOR(exGtS, i, strcmp(EX_TEXT(b.s), EX_TEXT(a.s)) < 0)
+EX_OPERATOR(exGeS, i, strcmp(EX_TEXT(b.s), EX_TEXT(a.s)) <= 0)
+EX_OPERATOR(exConcat, s, exString(f->x, a.s, b.s))
+
+// String of char a
+bcValue exC2S(exNode *n, exFrame *f) {
+    char    ch[2] = {(char)n->a->eval(n->a, f).i, '\0'};
+    bcValue v;
+    v.s = exString(f->x, ch, NULL);
+    return v;
+}
+
+// not a
+bcValue exNot(exNode *n, exFrame *f) {
+    bcValue v;
+    v.i = !n->a->eval(n->a, f).i;
+    return v;
+}
+
+EX_OPERATOR(exAnd, i, a.i & b.i)
+EX_OPERATOR(exOr, i, a.i | b.i)
\ No newline at end of file
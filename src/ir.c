@@ -0,0 +1,1652 @@
+#include "ir.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "escapes.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Integer arithmetic wraps around like the virtual machine's
+#define IR_WRAP(x) ((int64_t)(uint64_t)(x))
+
+// Text of a string value
+#define IR_TEXT(s) ((s) ? (s) : "")
+
+// Definition slot without a definition
+#define IR_EMPTY UINT64_MAX
+
+// Build the SSA form of a program the type checker accepted, NULL if out of memory
+// A variable read far from its definition looks it up one block at a time, recursively, so the construction runs on a
+// thread with a stack of IR_STACK_SIZE
+irProgram *irBuild(TypeChecker *types, astProgram *program) {
+    irProgram *p = (irProgram *)calloc(1, sizeof(irProgram));
+    if (!p) {
+        return NULL;
+    }
+
+    p->types       = types;
+    p->program     = program;
+    p->escapes     = (bool *)calloc(types->symbols->size, sizeof(bool));
+    p->defCapacity = 1024;
+    p->defKeys     = (uint64_t *)malloc(p->defCapacity * sizeof(uint64_t));
+    p->defValues   = (uint32_t *)malloc(p->defCapacity * sizeof(uint32_t));
+
+    if (!p->escapes || !p->defKeys || !p->defValues) {
+        irFree(p);
+        return NULL;
+    }
+
+    pthread_attr_t attributes;
+    pthread_t      thread;
+    uint64_t       start = pbNow();
+
+    bool started = pthread_attr_init(&attributes) == 0;
+    if (started) {
+        started = pthread_attr_setstacksize(&attributes, IR_STACK_SIZE) == 0 &&
+                  pthread_create(&thread, &attributes, irMain, p) == 0;
+        pthread_attr_destroy(&attributes);
+    }
+
+    if (started) {
+        pthread_join(thread, NULL);
+    } else {
+        irMain(p);
+    }
+
+    p->stats[IR_BUILD].time = pbNow() - start;
+
+    irCount(p, &p->stats[IR_BUILD]);
+    return p;
+}
+
+// Find the variables that live in memory, then build the program body and the functions
+void *irMain(void *program) {
+    irProgram *p = (irProgram *)program;
+
+    irScanBlock(p, p->program->block, 0);
+    irBuildFunction(p, NULL, 0);
+    return NULL;
+}
+
+// Run the passes over every function: constant propagation, value numbering, then dead code elimination
+void irOptimize(irProgram *p) {
+    void (*passes[IR_PASSES])(irFunction *) = {NULL, irSccp, irGvn, irDce};
+
+    for (uint32_t pass = IR_SCCP; pass < IR_PASSES; pass++) {
+        uint64_t start = pbNow();
+        for (uint32_t i = 0; i < p->size; i++) {
+            passes[pass](&p->functions[i]);
+        }
+        p->stats[pass].time = pbNow() - start;
+
+        irCount(p, &p->stats[pass]);
+    }
+}
+
+// Free the SSA form, the tree and the types are left alone
+void irFree(irProgram *p) {
+    for (uint32_t i = 0; i < p->size; i++) {
+        irFunction *f = &p->functions[i];
+        for (uint32_t j = 0; j < f->size; j++) {
+            free(f->instrs[j].args);
+        }
+        for (uint32_t j = 0; j < f->blockSize; j++) {
+            free(f->blocks[j].instrs);
+            free(f->blocks[j].preds);
+            free(f->blocks[j].incomplete);
+        }
+        free(f->instrs);
+        free(f->blocks);
+    }
+
+    free(p->functions);
+    free(p->escapes);
+    free(p->globals);
+    free(p->defKeys);
+    free(p->defValues);
+    free(p);
+}
+
+// Count the reachable blocks, the instructions and the phis of the program
+void irCount(irProgram *p, irStats *stats) {
+    stats->blocks       = 0;
+    stats->instructions = 0;
+    stats->phis         = 0;
+
+    for (uint32_t i = 0; i < p->size; i++) {
+        irFunction *f = &p->functions[i];
+        for (uint32_t j = 0; j < f->blockSize; j++) {
+            irBlock *b = &f->blocks[j];
+            if (b->dead) {
+                continue;
+            }
+
+            stats->blocks++;
+            for (uint32_t k = 0; k < b->size; k++) {
+                if (f->instrs[b->instrs[k]].op == IR_PHI) {
+                    stats->phis++;
+                } else {
+                    stats->instructions++;
+                }
+            }
+        }
+    }
+}
+
+// Print each function as its blocks, one instruction per line
+void irPrint(irProgram *p, FILE *out) {
+    sySymbol *symbols = p->types->symbols->symbols;
+
+    for (uint32_t i = 0; i < p->size; i++) {
+        irFunction *f = &p->functions[i];
+        fprintf(out, "%s%s (profundidade %" PRIu32 ")\n", i ? "\n" : "", f->name, f->depth);
+
+        for (uint32_t j = 0; j < f->blockSize; j++) {
+            irBlock *b = &f->blocks[j];
+            if (b->dead) {
+                continue;
+            }
+
+            fprintf(out, "b%" PRIu32 ":", j);
+            for (uint32_t k = 0; k < b->predSize; k++) {
+                fprintf(out, "%s b%" PRIu32, k ? "," : " <-", b->preds[k]);
+            }
+            fprintf(out, "\n");
+
+            for (uint32_t k = 0; k < b->size; k++) {
+                uint32_t v  = b->instrs[k];
+                irInstr *in = &f->instrs[v];
+
+                fprintf(out, "    ");
+                if (in->type != TY_NONE) {
+                    fprintf(out, "v%" PRIu32 " = ", v);
+                }
+                fprintf(out, "%s", irOpName((irOp)in->op));
+
+                switch (in->op) {
+                    case IR_CONST:
+                        switch (in->type) {
+                            case TY_REAL:
+                                fprintf(out, " %.17g", in->k.r);
+                                break;
+                            case TY_BOOLEAN:
+                                fprintf(out, " %s", in->k.i ? "true" : "false");
+                                break;
+                            case TY_CHAR:
+                                fprintf(out, " '%c'", (char)in->k.i);
+                                break;
+                            case TY_STRING:
+                                fprintf(out, " \"%s\"", IR_TEXT(in->k.s));
+                                break;
+                            default:
+                                fprintf(out, " %" PRId64, in->k.i);
+                                break;
+                        }
+                        break;
+                    case IR_PARAM:
+                        fprintf(out, " %" PRId64, in->k.i);
+                        break;
+                    case IR_LOAD:
+                    case IR_STORE:
+                    case IR_ADDR:
+                    case IR_CALL:
+                        fprintf(out, " %s", symbols[in->symbol].name);
+                        break;
+                    default:
+                        break;
+                }
+
+                for (uint32_t l = 0; l < in->size; l++) {
+                    fprintf(out, "%s v%" PRIu32, l || in->op == IR_STORE || in->op == IR_CALL ? "," : "", in->args[l]);
+                }
+                for (uint32_t l = 0; in->op == IR_JUMP || in->op == IR_BRANCH ? l < b->succSize : false; l++) {
+                    fprintf(out, "%s b%" PRIu32, l || in->size ? "," : "", b->succs[l]);
+                }
+                if (in->line) {
+                    fprintf(out, "  ; linha %" PRIu64, in->line);
+                }
+                fprintf(out, "\n");
+            }
+        }
+    }
+}
+
+//
+// Escapes
+//
+
+// Find the variables of a body that live in memory, the nested functions are scanned one depth deeper
+void irScanBlock(irProgram *p, astBlockStmt *block, uint32_t depth) {
+    Escapes x = {p->types, p->escapes, NULL, NULL};
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (!s) {
+            continue;
+        }
+
+        switch (evKindOf(s)) {
+            case EV_VAR:
+                break;
+            case EV_FUNCTION:
+                irScanBlock(p, ((astFunctionStmt *)s)->block, depth + 1);
+                break;
+            default:
+                esScanStatement(&x, s, depth);
+                break;
+        }
+    }
+}
+
+//
+// Construction
+//
+
+/*
+Build the program body, or a function, then the functions declared in it.
+The parameters in SSA form are IR_PARAM values of the entry block, and the return reads the result, or every variable
+of the program so that the values the program leaves behind stay alive.
+*/
+void irBuildFunction(irProgram *p, astFunctionStmt *function, uint32_t depth) {
+    astBlockStmt *block  = function ? function->block : p->program->block;
+    uint32_t      symbol = function ? function->identifier->symbol : 0;
+    char         *name   = function ? function->identifier->value : "program";
+    if (!function && p->program->identifier) {
+        name = p->program->identifier->value;
+    }
+
+    p->current = irNewFunction(p, name, symbol, depth);
+    p->block   = irNewBlock(&p->functions[p->current]);
+    p->defSize = 0;
+    memset(p->defKeys, 0xff, p->defCapacity * sizeof(uint64_t));
+
+    irFunction *f              = &p->functions[p->current];
+    f->blocks[p->block].sealed = true;
+
+    for (uint32_t i = 0; function && i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+            astDeclarationStmt *declaration = parameter->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                astIdentifierExpr *identifier = declaration->identifier[k];
+                if (irInSsa(p, identifier->symbol)) {
+                    uint32_t v       = irEmit(f, p->block, IR_PARAM, identifier->type);
+                    f->instrs[v].k.i = f->parameters;
+                    irWriteVariable(p, identifier->symbol, p->block, v);
+                }
+                f->parameters++;
+            }
+        }
+    }
+
+    irBuildBlock(p, block);
+
+    uint32_t *values = NULL;
+    uint32_t  size   = 0;
+    if (function && function->returnType) {
+        sySymbol *s = &p->types->symbols->symbols[symbol];
+        values      = (uint32_t *)malloc(sizeof(uint32_t));
+        values[0]   = irRead(p, symbol, tySignatureOf(p->types, s->typeId)->result);
+        size        = 1;
+    }
+
+    for (uint32_t i = 0; !function && block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)block->statements[i];
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                astIdentifierExpr *identifier = declaration->identifier[k];
+                if (!identifier) {
+                    continue;
+                }
+
+                p->globals = (uint32_t *)astGrowArray(p->globals, p->globalSize, &p->globalCapacity, sizeof(uint32_t));
+                p->globals[p->globalSize++] = identifier->symbol;
+
+                values         = (uint32_t *)realloc(values, p->globalSize * sizeof(uint32_t));
+                values[size++] = irRead(p, identifier->symbol, identifier->type);
+            }
+        }
+    }
+
+    f            = &p->functions[p->current];
+    uint32_t ret = irEmit(f, p->block, IR_RETURN, TY_NONE);
+    for (uint32_t i = 0; i < size; i++) {
+        irAddArg(f, ret, values[i]);
+    }
+    free(values);
+
+    irCleanPhis(f);
+    irCompact(f);
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (evKindOf(s) == EV_FUNCTION && ((astFunctionStmt *)s)->identifier) {
+            irBuildFunction(p, (astFunctionStmt *)s, depth + 1);
+        }
+    }
+}
+
+// Build the statements of a body, declarations take no part
+void irBuildBlock(irProgram *p, astBlockStmt *block) {
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (s && evKindOf(s) != EV_VAR && evKindOf(s) != EV_FUNCTION) {
+            irBuildStatement(p, s);
+        }
+    }
+}
+
+/*
+Build a statement into the current block.
+An `if` branches to blocks of its own that join after it, and a `while` jumps to a header that tests the condition
+and branches to the body or past the loop. A block is sealed once all of its predecessors are known, the header of a
+loop only after its body jumps back to it.
+*/
+void irBuildStatement(irProgram *p, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    irFunction *f = &p->functions[p->current];
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                irBuildStatement(p, (astStatement *)beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+
+            uint32_t condition   = irBuildExpression(p, conditional->condition);
+            uint32_t consequence = irNewBlock(f);
+            uint32_t alternative = conditional->alternative ? irNewBlock(f) : IR_NONE;
+            uint32_t join        = irNewBlock(f);
+
+            irTerminate(p, IR_BRANCH, condition, consequence, alternative != IR_NONE ? alternative : join);
+
+            irSeal(p, consequence);
+            p->block = consequence;
+            irBuildStatement(p, conditional->consequence);
+            irTerminate(p, IR_JUMP, IR_NONE, join, IR_NONE);
+
+            if (alternative != IR_NONE) {
+                irSeal(p, alternative);
+                p->block = alternative;
+                irBuildStatement(p, conditional->alternative);
+                irTerminate(p, IR_JUMP, IR_NONE, join, IR_NONE);
+            }
+
+            irSeal(p, join);
+            p->block = join;
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+
+            uint32_t header = irNewBlock(f);
+            uint32_t body   = irNewBlock(f);
+            uint32_t exit   = irNewBlock(f);
+
+            irTerminate(p, IR_JUMP, IR_NONE, header, IR_NONE);
+
+            p->block           = header;
+            uint32_t condition = irBuildExpression(p, loop->condition);
+            irTerminate(p, IR_BRANCH, condition, body, exit);
+
+            irSeal(p, body);
+            p->block = body;
+            irBuildStatement(p, loop->body);
+            irTerminate(p, IR_JUMP, IR_NONE, header, IR_NONE);
+
+            irSeal(p, header);
+            irSeal(p, exit);
+            p->block = exit;
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            if (((astExpressionStmt *)s)->expr) {
+                irBuildExpression(p, ((astExpressionStmt *)s)->expr);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Build an expression into the current block, returns its value, IR_NONE for an assignment
+uint32_t irBuildExpression(irProgram *p, astExpression *e) {
+    irFunction *f = &p->functions[p->current];
+    bcValue     k;
+    k.i = 0;
+
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            k.i = ((astIntegerExpr *)e)->value;
+            return irConstant(f, p->block, TY_INTEGER, k);
+        case EV_FLOAT:
+            k.r = ((astFloatExpr *)e)->value;
+            return irConstant(f, p->block, TY_REAL, k);
+        case EV_BOOLEAN:
+            k.i = ((astBooleanExpr *)e)->value;
+            return irConstant(f, p->block, TY_BOOLEAN, k);
+        case EV_CHAR:
+            k.i = (unsigned char)((astCharExpr *)e)->value;
+            return irConstant(f, p->block, TY_CHAR, k);
+        case EV_STRING: {
+            char *value = ((astStringExpr *)e)->value;
+            k.s         = *value ? value : NULL;
+            return irConstant(f, p->block, TY_STRING, k);
+        }
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(p->types->symbols, identifier);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                return irBuildCall(p, identifier, NULL, 0);
+            }
+            return irRead(p, identifier->symbol, identifier->type);
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            return irBuildCall(p, call->identifier, call->arguments, call->size);
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+
+            uint32_t a  = irBuildExpression(p, prefix->right);
+            irOp     op = prefix->token->type == NOT ? IR_NOT : prefix->type == TY_REAL ? IR_NEGF : IR_NEGI;
+            uint32_t v  = irEmit(f, p->block, op, prefix->type);
+            irAddArg(f, v, a);
+            return v;
+        }
+        case EV_INFIX:
+            return irBuildInfix(p, (astInfixExpr *)e);
+        case EV_ASSIGNMENT:
+            irBuildAssignment(p, (astAssignmentExpr *)e);
+            return IR_NONE;
+        default:
+            return IR_NONE;
+    }
+}
+
+// Build an expression converted to a type it's assignable to, integers widen to real and characters to string
+uint32_t irBuildConverted(irProgram *p, astExpression *e, uint32_t type) {
+    irFunction *f = &p->functions[p->current];
+
+    if (e->type == TY_INTEGER && type == TY_REAL && evKindOf(e) == EV_INTEGER) {
+        bcValue k;
+        k.r = (double)((astIntegerExpr *)e)->value;
+        return irConstant(f, p->block, TY_REAL, k);
+    }
+
+    if ((e->type == TY_INTEGER && type == TY_REAL) || (e->type == TY_CHAR && type == TY_STRING)) {
+        uint32_t a = irBuildExpression(p, e);
+        uint32_t v = irEmit(f, p->block, type == TY_REAL ? IR_I2F : IR_C2S, type);
+        irAddArg(f, v, a);
+        return v;
+    }
+
+    return irBuildExpression(p, e);
+}
+
+// Build an infix expression, the operands are converted to the type the operator computes in, like bcCompileInfix
+uint32_t irBuildInfix(irProgram *p, astInfixExpr *infix) {
+    irFunction *f     = &p->functions[p->current];
+    TokenType   op    = infix->token->type;
+    uint32_t    left  = infix->left->type;
+    uint32_t    right = infix->right->type;
+
+    // Type the operands are compared or computed in
+    uint32_t type = TY_INTEGER;
+    if (left == TY_REAL || right == TY_REAL || op == SLASH) {
+        type = TY_REAL;
+    } else if (left == TY_STRING || right == TY_STRING || infix->type == TY_STRING) {
+        type = TY_STRING;
+    }
+
+    uint32_t a = irBuildConverted(p, infix->left, type);
+    uint32_t b = irBuildConverted(p, infix->right, type);
+
+    bool real   = type == TY_REAL;
+    bool string = type == TY_STRING;
+    bool swap   = op == GT || op == GTE;
+    irOp code;
+    switch (op) {
+        case PLUS:
+            code = string ? IR_CONCAT : real ? IR_ADDF : IR_ADDI;
+            break;
+        case MINUS:
+            code = real ? IR_SUBF : IR_SUBI;
+            break;
+        case ASTERISK:
+            code = real ? IR_MULF : IR_MULI;
+            break;
+        case SLASH:
+            code = IR_DIVF;
+            break;
+        case DIV:
+            code = IR_DIVI;
+            break;
+        case MOD:
+            code = IR_MODI;
+            break;
+        case AND:
+            code = IR_AND;
+            break;
+        case OR:
+            code = IR_OR;
+            break;
+        case EQ:
+            code = string ? IR_EQS : real ? IR_EQF : IR_EQI;
+            break;
+        case NOT_EQ:
+            code = string ? IR_NES : real ? IR_NEF : IR_NEI;
+            break;
+        case LT:
+        case GT:
+            code = string ? IR_LTS : real ? IR_LTF : IR_LTI;
+            break;
+        case LTE:
+        case GTE:
+            code = string ? IR_LES : real ? IR_LEF : IR_LEI;
+            break;
+        default:
+            return irZero(f, infix->type);
+    }
+
+    uint32_t v = irEmit(f, p->block, code, infix->type);
+    irAddArg(f, v, swap ? b : a);
+    irAddArg(f, v, swap ? a : b);
+
+    if (op == DIV || op == MOD || op == SLASH) {
+        f->instrs[v].line = irLine(p, (astExpression *)infix, 0);
+    }
+
+    return v;
+}
+
+// Build a call, a `var` argument passes the address of its variable
+uint32_t irBuildCall(irProgram *p, astIdentifierExpr *callee, astExpression **arguments, uint32_t size) {
+    sySymbol    *s         = sySymbolOf(p->types->symbols, callee);
+    tySignature *signature = tySignatureOf(p->types, s->typeId);
+    uint32_t    *values    = size ? (uint32_t *)malloc(size * sizeof(uint32_t)) : NULL;
+
+    for (uint32_t i = 0; i < size; i++) {
+        if (signature->parameters[i] & TY_REFERENCE) {
+            irFunction *f               = &p->functions[p->current];
+            values[i]                   = irEmit(f, p->block, IR_ADDR, TY_NONE);
+            f->instrs[values[i]].symbol = ((astIdentifierExpr *)arguments[i])->symbol;
+        } else {
+            values[i] = irBuildConverted(p, arguments[i], signature->parameters[i]);
+        }
+    }
+
+    irFunction *f = &p->functions[p->current];
+    uint32_t    v = irEmit(f, p->block, IR_CALL, signature->result == TY_VOID ? TY_NONE : signature->result);
+    for (uint32_t i = 0; i < size; i++) {
+        irAddArg(f, v, values[i]);
+    }
+    f->instrs[v].symbol = callee->symbol;
+    f->instrs[v].line   = callee->token->line;
+
+    free(values);
+    return v;
+}
+
+// Build an assignment, a variable in SSA form gets a new definition, any other one a store
+void irBuildAssignment(irProgram *p, astAssignmentExpr *assignment) {
+    astIdentifierExpr *identifier = assignment->identifier;
+    uint32_t           value      = irBuildConverted(p, assignment->value, identifier->type);
+
+    if (irInSsa(p, identifier->symbol)) {
+        irWriteVariable(p, identifier->symbol, p->block, value);
+        return;
+    }
+
+    irFunction *f = &p->functions[p->current];
+    uint32_t    v = irEmit(f, p->block, IR_STORE, TY_NONE);
+    irAddArg(f, v, value);
+    f->instrs[v].symbol = identifier->symbol;
+}
+
+// Read a variable of the current block, its current definition, or a load when it lives in memory
+uint32_t irRead(irProgram *p, uint32_t symbol, uint32_t type) {
+    if (irInSsa(p, symbol)) {
+        return irReadVariable(p, symbol, p->block, type);
+    }
+
+    irFunction *f       = &p->functions[p->current];
+    uint32_t    v       = irEmit(f, p->block, IR_LOAD, type);
+    f->instrs[v].symbol = symbol;
+    return v;
+}
+
+// Check if a variable, a parameter or the result of a function is kept in SSA form
+bool irInSsa(irProgram *p, uint32_t symbol) {
+    return !p->escapes[symbol] && !p->types->symbols->symbols[symbol].reference;
+}
+
+// Line the virtual machine gives the instructions that end an expression compiled when the line was `line`
+uint64_t irLine(irProgram *p, astExpression *e, uint64_t line) {
+    switch (evKindOf(e)) {
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)e;
+            return irLine(p, infix->right, irLine(p, infix->left, infix->token->line));
+        }
+        case EV_PREFIX:
+            return irLine(p, ((astPrefixExpr *)e)->right, line);
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            return irLine(p, assignment->value, assignment->token->line);
+        }
+        case EV_CALL:
+            return ((astCallExpr *)e)->identifier->token->line;
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(p->types->symbols, (astIdentifierExpr *)e);
+            return s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE ? e->token->line : line;
+        }
+        default:
+            return line;
+    }
+}
+
+// Add a function to the program, returns its index
+uint32_t irNewFunction(irProgram *p, char *name, uint32_t symbol, uint32_t depth) {
+    p->functions = (irFunction *)astGrowArray(p->functions, p->size, &p->functionCapacity, sizeof(irFunction));
+
+    irFunction *f = &p->functions[p->size];
+    memset(f, 0, sizeof(irFunction));
+    f->name   = name;
+    f->symbol = symbol;
+    f->depth  = depth;
+
+    return p->size++;
+}
+
+// Add an empty block to a function, returns its index
+uint32_t irNewBlock(irFunction *f) {
+    f->blocks = (irBlock *)astGrowArray(f->blocks, f->blockSize, &f->blockCapacity, sizeof(irBlock));
+
+    irBlock *b = &f->blocks[f->blockSize];
+    memset(b, 0, sizeof(irBlock));
+    b->succs[0] = IR_NONE;
+    b->succs[1] = IR_NONE;
+
+    return f->blockSize++;
+}
+
+// Append an instruction without operands to a block, returns its value
+uint32_t irEmit(irFunction *f, uint32_t block, irOp op, uint32_t type) {
+    f->instrs = (irInstr *)astGrowArray(f->instrs, f->size, &f->capacity, sizeof(irInstr));
+
+    irInstr *in = &f->instrs[f->size];
+    memset(in, 0, sizeof(irInstr));
+    in->op          = (uint8_t)op;
+    in->type        = type;
+    in->block       = block;
+    in->replacement = IR_NONE;
+
+    irBlock *b = &f->blocks[block];
+    b->instrs  = (uint32_t *)astGrowArray(b->instrs, b->size, &b->capacity, sizeof(uint32_t));
+    b->instrs[b->size++] = f->size;
+
+    return f->size++;
+}
+
+// Append an operand to an instruction
+void irAddArg(irFunction *f, uint32_t value, uint32_t arg) {
+    irInstr *in = &f->instrs[value];
+    in->args    = (uint32_t *)astGrowArray(in->args, in->size, &in->capacity, sizeof(uint32_t));
+    in->args[in->size++] = arg;
+}
+
+// Append a constant to a block
+uint32_t irConstant(irFunction *f, uint32_t block, uint32_t type, bcValue k) {
+    uint32_t v     = irEmit(f, block, IR_CONST, type);
+    f->instrs[v].k = k;
+    return v;
+}
+
+// Zero of a type at the start of the entry block, the value of a variable read before any assignment
+uint32_t irZero(irFunction *f, uint32_t type) {
+    uint32_t v = irEmit(f, 0, IR_CONST, type);
+
+    irBlock *b = &f->blocks[0];
+    memmove(b->instrs + 1, b->instrs, (b->size - 1) * sizeof(uint32_t));
+    b->instrs[0] = v;
+
+    return v;
+}
+
+// Add a phi of a variable after the phis of a block, without operands
+uint32_t irPhi(irFunction *f, uint32_t block, uint32_t symbol, uint32_t type) {
+    uint32_t v          = irEmit(f, block, IR_PHI, type);
+    f->instrs[v].symbol = symbol;
+
+    irBlock *b     = &f->blocks[block];
+    uint32_t phis  = 0;
+    while (phis < b->size - 1 && f->instrs[b->instrs[phis]].op == IR_PHI) {
+        phis++;
+    }
+    memmove(b->instrs + phis + 1, b->instrs + phis, (b->size - 1 - phis) * sizeof(uint32_t));
+    b->instrs[phis] = v;
+
+    return v;
+}
+
+// Add an edge of the control flow graph
+void irEdge(irFunction *f, uint32_t from, uint32_t to) {
+    irBlock *source = &f->blocks[from];
+    source->succs[source->succSize++] = to;
+
+    irBlock *target = &f->blocks[to];
+    target->preds = (uint32_t *)astGrowArray(target->preds, target->predSize, &target->predCapacity,
+                                             sizeof(uint32_t));
+    target->preds[target->predSize++] = from;
+}
+
+// End the current block with a jump, or with a branch on `arg` to `to` or `otherwise`
+void irTerminate(irProgram *p, irOp op, uint32_t arg, uint32_t to, uint32_t otherwise) {
+    irFunction *f = &p->functions[p->current];
+    uint32_t    v = irEmit(f, p->block, op, TY_NONE);
+
+    if (arg != IR_NONE) {
+        irAddArg(f, v, arg);
+    }
+    irEdge(f, p->block, to);
+    if (otherwise != IR_NONE) {
+        irEdge(f, p->block, otherwise);
+    }
+}
+
+//
+// On-the-fly SSA construction, Braun et al.
+//
+
+// Definition of a variable in a block, IR_NONE if the block doesn't define it
+uint32_t irDefinition(irProgram *p, uint32_t symbol, uint32_t block) {
+    uint64_t key  = (uint64_t)symbol << 32 | block;
+    uint32_t mask = p->defCapacity - 1;
+
+    for (uint32_t i = (uint32_t)(key * 0x9e3779b97f4a7c15u >> 32) & mask;; i = (i + 1) & mask) {
+        if (p->defKeys[i] == key) {
+            return p->defValues[i];
+        }
+        if (p->defKeys[i] == IR_EMPTY) {
+            return IR_NONE;
+        }
+    }
+}
+
+// Set the definition of a variable in a block
+void irWriteVariable(irProgram *p, uint32_t symbol, uint32_t block, uint32_t value) {
+    if ((p->defSize + 1) * 2 > p->defCapacity) {
+        uint64_t *keys     = p->defKeys;
+        uint32_t *values   = p->defValues;
+        uint32_t  capacity = p->defCapacity;
+
+        p->defCapacity = capacity * 2;
+        p->defKeys     = (uint64_t *)malloc(p->defCapacity * sizeof(uint64_t));
+        p->defValues   = (uint32_t *)malloc(p->defCapacity * sizeof(uint32_t));
+        p->defSize     = 0;
+        memset(p->defKeys, 0xff, p->defCapacity * sizeof(uint64_t));
+
+        for (uint32_t i = 0; i < capacity; i++) {
+            if (keys[i] != IR_EMPTY) {
+                irWriteVariable(p, (uint32_t)(keys[i] >> 32), (uint32_t)keys[i], values[i]);
+            }
+        }
+        free(keys);
+        free(values);
+    }
+
+    uint64_t key  = (uint64_t)symbol << 32 | block;
+    uint32_t mask = p->defCapacity - 1;
+
+    uint32_t i = (uint32_t)(key * 0x9e3779b97f4a7c15u >> 32) & mask;
+    while (p->defKeys[i] != key && p->defKeys[i] != IR_EMPTY) {
+        i = (i + 1) & mask;
+    }
+    if (p->defKeys[i] == IR_EMPTY) {
+        p->defKeys[i] = key;
+        p->defSize++;
+    }
+    p->defValues[i] = value;
+}
+
+// Value of a variable at the end of a block, the value of `type` it was last given on the way there
+uint32_t irReadVariable(irProgram *p, uint32_t symbol, uint32_t block, uint32_t type) {
+    uint32_t v = irDefinition(p, symbol, block);
+    if (v != IR_NONE) {
+        return irResolve(&p->functions[p->current], v);
+    }
+
+    return irReadRecursive(p, symbol, block, type);
+}
+
+/*
+Value of a variable the block doesn't define, looked up in the predecessors.
+A block still missing predecessors gets an empty phi completed when it's sealed, a block with one predecessor takes
+its value, and a join gets a phi, defined before its operands are read so a loop back to the block finds it.
+*/
+uint32_t irReadRecursive(irProgram *p, uint32_t symbol, uint32_t block, uint32_t type) {
+    irFunction *f = &p->functions[p->current];
+    irBlock    *b = &f->blocks[block];
+    uint32_t    v;
+
+    if (!b->sealed) {
+        v             = irPhi(f, block, symbol, type);
+        b             = &f->blocks[block];
+        b->incomplete = (uint32_t *)astGrowArray(b->incomplete, b->incompleteSize, &b->incompleteCapacity,
+                                                 sizeof(uint32_t));
+        b->incomplete[b->incompleteSize++] = v;
+    } else if (b->predSize == 1) {
+        v = irReadVariable(p, symbol, b->preds[0], type);
+    } else if (b->predSize == 0) {
+        v = irZero(f, type);
+    } else {
+        v = irPhi(f, block, symbol, type);
+        irWriteVariable(p, symbol, block, v);
+        v = irAddPhiOperands(p, v);
+    }
+
+    irWriteVariable(p, symbol, block, v);
+    return v;
+}
+
+// Give a phi the value of its variable in each predecessor, returns the phi or the one value it repeats
+uint32_t irAddPhiOperands(irProgram *p, uint32_t phi) {
+    irFunction *f     = &p->functions[p->current];
+    uint32_t    block = f->instrs[phi].block;
+
+    for (uint32_t i = 0; i < f->blocks[block].predSize; i++) {
+        uint32_t v = irReadVariable(p, f->instrs[phi].symbol, f->blocks[block].preds[i], f->instrs[phi].type);
+        irAddArg(f, phi, v);
+    }
+
+    return irRemoveTrivialPhi(f, phi);
+}
+
+/*
+Replace a phi whose operands are one value besides itself by that value, returns what the phi now stands for.
+The users of the phi aren't revisited, a read resolves the replacement and irCleanPhis removes the phis that
+become trivial in turn.
+*/
+uint32_t irRemoveTrivialPhi(irFunction *f, uint32_t phi) {
+    uint32_t same = IR_NONE;
+
+    for (uint32_t i = 0; i < f->instrs[phi].size; i++) {
+        uint32_t v = irResolve(f, f->instrs[phi].args[i]);
+        if (v == same || v == phi) {
+            continue;
+        }
+        if (same != IR_NONE) {
+            return phi;
+        }
+        same = v;
+    }
+
+    // Only the phi itself flows in, the variable is never assigned on the way
+    if (same == IR_NONE) {
+        same = irZero(f, f->instrs[phi].type);
+    }
+
+    f->instrs[phi].dead        = true;
+    f->instrs[phi].replacement = same;
+    return same;
+}
+
+// Mark a block as having all of its predecessors, and complete the phis read before
+void irSeal(irProgram *p, uint32_t block) {
+    irFunction *f = &p->functions[p->current];
+
+    for (uint32_t i = 0; i < f->blocks[block].incompleteSize; i++) {
+        irAddPhiOperands(p, f->blocks[block].incomplete[i]);
+    }
+
+    f->blocks[block].incompleteSize = 0;
+    f->blocks[block].sealed         = true;
+}
+
+// Value that stands for a value, following the replacements of removed instructions
+uint32_t irResolve(irFunction *f, uint32_t value) {
+    uint32_t v = value;
+    while (f->instrs[v].dead && f->instrs[v].replacement != IR_NONE) {
+        v = f->instrs[v].replacement;
+    }
+
+    // Shorten the chain for the next lookup
+    while (f->instrs[value].dead && f->instrs[value].replacement != IR_NONE && f->instrs[value].replacement != v) {
+        uint32_t next                = f->instrs[value].replacement;
+        f->instrs[value].replacement = v;
+        value                        = next;
+    }
+
+    return v;
+}
+
+//
+// Passes
+//
+
+/*
+Sparse conditional constant propagation, Wegman and Zadeck.
+Each value starts unknown and only falls, to one constant and then to varying, and a block is only visited once an
+edge into it can be taken, so a branch on a constant leaves the other side unreachable and a phi only meets the
+operands of reachable edges. A division that would stop the program and a concatenation, which allocates, are left
+for the run.
+*/
+void irSccp(irFunction *f) {
+    irSccpState s;
+    memset(&s, 0, sizeof(irSccpState));
+    s.f = f;
+
+    uint32_t edges = 0;
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        edges += f->blocks[i].predSize;
+    }
+
+    s.state      = (uint8_t *)calloc(f->size, sizeof(uint8_t));
+    s.values     = (bcValue *)calloc(f->size, sizeof(bcValue));
+    s.executable = (bool *)calloc(f->blockSize, sizeof(bool));
+    s.edges      = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    s.reached    = (bool *)calloc(edges + 1, sizeof(bool));
+    s.userStart  = (uint32_t *)calloc(f->size + 1, sizeof(uint32_t));
+    s.flow       = (uint32_t *)malloc((edges + 1) * sizeof(uint32_t));
+    s.ssa        = (uint32_t *)malloc((2 * f->size + 1) * sizeof(uint32_t));
+
+    edges = 0;
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        s.edges[i] = edges;
+        edges += f->blocks[i].predSize;
+    }
+    s.edges[f->blockSize] = edges;
+
+    // Users of each value, counted and then placed
+    uint32_t uses = 0;
+    for (uint32_t v = 0; v < f->size; v++) {
+        for (uint32_t i = 0; !f->instrs[v].dead && i < f->instrs[v].size; i++) {
+            s.userStart[f->instrs[v].args[i] + 1]++;
+            uses++;
+        }
+    }
+    for (uint32_t v = 0; v < f->size; v++) {
+        s.userStart[v + 1] += s.userStart[v];
+    }
+
+    uint32_t *next = (uint32_t *)malloc((f->size + 1) * sizeof(uint32_t));
+    s.users        = (uint32_t *)malloc((uses + 1) * sizeof(uint32_t));
+    memcpy(next, s.userStart, (f->size + 1) * sizeof(uint32_t));
+    for (uint32_t v = 0; v < f->size; v++) {
+        for (uint32_t i = 0; !f->instrs[v].dead && i < f->instrs[v].size; i++) {
+            s.users[next[f->instrs[v].args[i]]++] = v;
+        }
+    }
+    free(next);
+
+    s.executable[0] = true;
+    s.flow[s.flowSize++] = 0;
+
+    while (s.flowSize || s.ssaSize) {
+        if (s.flowSize) {
+            uint32_t entry = s.flow[--s.flowSize];
+            irBlock *b     = &f->blocks[entry >> 1];
+            for (uint32_t i = 0; i < b->size; i++) {
+                if (f->instrs[b->instrs[i]].op == IR_PHI || !(entry & 1)) {
+                    irVisit(&s, b->instrs[i]);
+                }
+            }
+            continue;
+        }
+
+        uint32_t v = s.ssa[--s.ssaSize];
+        for (uint32_t i = s.userStart[v]; i < s.userStart[v + 1]; i++) {
+            if (s.executable[f->instrs[s.users[i]].block]) {
+                irVisit(&s, s.users[i]);
+            }
+        }
+    }
+
+    // Unreachable blocks go, with the operands their edges gave to phis
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        if (s.executable[i] || f->blocks[i].dead) {
+            continue;
+        }
+
+        irBlock *b = &f->blocks[i];
+        b->dead    = true;
+        for (uint32_t j = 0; j < b->size; j++) {
+            f->instrs[b->instrs[j]].dead = true;
+        }
+        while (b->succSize) {
+            irRemoveEdge(f, i, b->succs[0]);
+        }
+    }
+
+    for (uint32_t v = 0; v < f->size; v++) {
+        irInstr *in = &f->instrs[v];
+        if (in->dead) {
+            continue;
+        }
+
+        if (s.state[v] == IR_KNOWN && in->op != IR_CONST && in->type != TY_NONE) {
+            in->op   = IR_CONST;
+            in->size = 0;
+            in->k    = s.values[v];
+            in->line = 0;
+        } else if (in->op == IR_BRANCH && s.state[in->args[0]] == IR_KNOWN) {
+            irBlock *b     = &f->blocks[in->block];
+            uint32_t taken = b->succs[s.values[in->args[0]].i ? 0 : 1];
+            irRemoveEdge(f, in->block, b->succs[s.values[in->args[0]].i ? 1 : 0]);
+
+            b           = &f->blocks[in->block];
+            b->succs[0] = taken;
+            in->op      = IR_JUMP;
+            in->size    = 0;
+        }
+    }
+
+    free(s.state);
+    free(s.values);
+    free(s.executable);
+    free(s.edges);
+    free(s.reached);
+    free(s.userStart);
+    free(s.users);
+    free(s.flow);
+    free(s.ssa);
+
+    irCleanPhis(f);
+    irCompact(f);
+}
+
+// Evaluate an instruction of a reachable block over the lattice
+void irVisit(irSccpState *s, uint32_t v) {
+    irFunction *f  = s->f;
+    irInstr    *in = &f->instrs[v];
+    if (in->dead) {
+        return;
+    }
+
+    switch (in->op) {
+        case IR_CONST:
+            irLower(s, v, IR_KNOWN, in->k);
+            return;
+        case IR_PHI:
+            for (uint32_t i = 0; i < in->size; i++) {
+                uint32_t a = in->args[i];
+                if (!s->reached[s->edges[in->block] + i] || s->state[a] == IR_TOP) {
+                    continue;
+                }
+                if (s->state[a] == IR_BOTTOM) {
+                    irLower(s, v, IR_BOTTOM, in->k);
+                    return;
+                }
+                if (s->state[v] == IR_KNOWN && s->values[v].i != s->values[a].i) {
+                    irLower(s, v, IR_BOTTOM, in->k);
+                    return;
+                }
+                irLower(s, v, IR_KNOWN, s->values[a]);
+            }
+            return;
+        case IR_JUMP:
+            irReach(s, in->block, f->blocks[in->block].succs[0]);
+            return;
+        case IR_BRANCH: {
+            uint32_t condition = in->args[0];
+            if (s->state[condition] == IR_TOP) {
+                return;
+            }
+
+            irBlock *b = &f->blocks[in->block];
+            if (s->state[condition] == IR_BOTTOM || s->values[condition].i) {
+                irReach(s, in->block, b->succs[0]);
+            }
+            if (s->state[condition] == IR_BOTTOM || !s->values[condition].i) {
+                irReach(s, in->block, b->succs[1]);
+            }
+            return;
+        }
+        case IR_RETURN:
+        case IR_STORE:
+            return;
+        case IR_PARAM:
+        case IR_LOAD:
+        case IR_ADDR:
+        case IR_CALL:
+        case IR_CONCAT:
+        case IR_C2S:
+            irLower(s, v, IR_BOTTOM, in->k);
+            return;
+        default:
+            break;
+    }
+
+    bcValue operands[2];
+    for (uint32_t i = 0; i < in->size; i++) {
+        if (s->state[in->args[i]] == IR_BOTTOM) {
+            irLower(s, v, IR_BOTTOM, in->k);
+            return;
+        }
+        if (s->state[in->args[i]] == IR_TOP) {
+            return;
+        }
+        operands[i] = s->values[in->args[i]];
+    }
+    if (in->size == 1) {
+        operands[1] = operands[0];
+    }
+
+    bcValue result;
+    if (irFold((irOp)in->op, operands[0], operands[1], &result)) {
+        irLower(s, v, IR_KNOWN, result);
+    } else {
+        irLower(s, v, IR_BOTTOM, in->k);
+    }
+}
+
+// Mark an edge as taken, visiting the whole target the first time it's reached and its phis after that
+void irReach(irSccpState *s, uint32_t from, uint32_t to) {
+    irBlock *b = &s->f->blocks[to];
+
+    for (uint32_t i = 0; i < b->predSize; i++) {
+        if (b->preds[i] != from || s->reached[s->edges[to] + i]) {
+            continue;
+        }
+
+        s->reached[s->edges[to] + i] = true;
+        s->flow[s->flowSize++]       = to << 1 | (s->executable[to] ? 1 : 0);
+        s->executable[to]            = true;
+        return;
+    }
+}
+
+// Lower the lattice state of a value, its users are visited again when it falls
+void irLower(irSccpState *s, uint32_t v, uint8_t state, bcValue value) {
+    if (s->state[v] >= state) {
+        return;
+    }
+
+    s->state[v]          = state;
+    s->values[v]         = value;
+    s->ssa[s->ssaSize++] = v;
+}
+
+// Compute an operator over constants like the virtual machine, false if it would stop the program or allocate
+bool irFold(irOp op, bcValue a, bcValue b, bcValue *result) {
+    switch (op) {
+        case IR_ADDI:
+            result->i = IR_WRAP((uint64_t)a.i + (uint64_t)b.i);
+            return true;
+        case IR_SUBI:
+            result->i = IR_WRAP((uint64_t)a.i - (uint64_t)b.i);
+            return true;
+        case IR_MULI:
+            result->i = IR_WRAP((uint64_t)a.i * (uint64_t)b.i);
+            return true;
+        case IR_DIVI:
+            if (b.i == 0) {
+                return false;
+            }
+            result->i = b.i == -1 ? IR_WRAP(0 - (uint64_t)a.i) : a.i / b.i;
+            return true;
+        case IR_MODI:
+            if (b.i == 0) {
+                return false;
+            }
+            result->i = b.i == -1 ? 0 : a.i % b.i;
+            return true;
+        case IR_NEGI:
+            result->i = IR_WRAP(0 - (uint64_t)a.i);
+            return true;
+        case IR_ADDF:
+            result->r = a.r + b.r;
+            return true;
+        case IR_SUBF:
+            result->r = a.r - b.r;
+            return true;
+        case IR_MULF:
+            result->r = a.r * b.r;
+            return true;
+        case IR_DIVF:
+            if (b.r == 0) {
+                return false;
+            }
+            result->r = a.r / b.r;
+            return true;
+        case IR_NEGF:
+            result->r = -a.r;
+            return true;
+        case IR_I2F:
+            result->r = (double)a.i;
+            return true;
+        case IR_EQI:
+            result->i = a.i == b.i;
+            return true;
+        case IR_NEI:
+            result->i = a.i != b.i;
+            return true;
+        case IR_LTI:
+            result->i = a.i < b.i;
+            return true;
+        case IR_LEI:
+            result->i = a.i <= b.i;
+            return true;
+        case IR_EQF:
+            result->i = a.r == b.r;
+            return true;
+        case IR_NEF:
+            result->i = a.r != b.r;
+            return true;
+        case IR_LTF:
+            result->i = a.r < b.r;
+            return true;
+        case IR_LEF:
+            result->i = a.r <= b.r;
+            return true;
+        case IR_EQS:
+            result->i = strcmp(IR_TEXT(a.s), IR_TEXT(b.s)) == 0;
+            return true;
+        case IR_NES:
+            result->i = strcmp(IR_TEXT(a.s), IR_TEXT(b.s)) != 0;
+            return true;
+        case IR_LTS:
+            result->i = strcmp(IR_TEXT(a.s), IR_TEXT(b.s)) < 0;
+            return true;
+        case IR_LES:
+            result->i = strcmp(IR_TEXT(a.s), IR_TEXT(b.s)) <= 0;
+            return true;
+        case IR_NOT:
+            result->i = !a.i;
+            return true;
+        case IR_AND:
+            result->i = a.i & b.i;
+            return true;
+        case IR_OR:
+            result->i = a.i | b.i;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+Global value numbering over the dominator tree.
+The blocks are walked from the entry down the tree with a table of the values computed so far on the way, so an
+instruction that computes what a dominating one already did, same operator, type, constant and operands, is replaced
+by it. Loads and calls read memory that may have changed and are never numbered.
+*/
+void irGvn(irFunction *f) {
+    uint32_t *order = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    uint32_t *idom  = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    uint32_t  count = irDominators(f, order, idom);
+
+    // Children of each block in the dominator tree
+    uint32_t *childStart = (uint32_t *)calloc(f->blockSize + 1, sizeof(uint32_t));
+    uint32_t *children   = (uint32_t *)malloc((count + 1) * sizeof(uint32_t));
+    for (uint32_t i = 1; i < count; i++) {
+        childStart[idom[order[i]] + 1]++;
+    }
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        childStart[i + 1] += childStart[i];
+    }
+    uint32_t *next = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    memcpy(next, childStart, (f->blockSize + 1) * sizeof(uint32_t));
+    for (uint32_t i = 1; i < count; i++) {
+        children[next[idom[order[i]]]++] = order[i];
+    }
+    free(next);
+
+    uint32_t buckets = 16;
+    while (buckets < 2 * f->size) {
+        buckets *= 2;
+    }
+    uint32_t *heads  = (uint32_t *)malloc(buckets * sizeof(uint32_t));
+    uint32_t *chain  = (uint32_t *)malloc((f->size + 1) * sizeof(uint32_t));
+    uint32_t *bucket = (uint32_t *)malloc((f->size + 1) * sizeof(uint32_t));
+    uint32_t *scoped = (uint32_t *)malloc((f->size + 1) * sizeof(uint32_t));
+    uint32_t *stack  = (uint32_t *)malloc((2 * count + 1) * sizeof(uint32_t));
+    memset(heads, 0xff, buckets * sizeof(uint32_t));
+
+    // The walk pushes a block twice, to enter it and then to leave it, with the values it numbered above `marks`
+    uint32_t *marks     = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    uint32_t  depth     = 0;
+    uint32_t  scopeSize = 0;
+    stack[depth++]      = 0;
+
+    while (depth) {
+        uint32_t entry = stack[--depth];
+        uint32_t block = entry >> 1;
+
+        if (entry & 1) {
+            while (scopeSize > marks[block]) {
+                uint32_t v       = scoped[--scopeSize];
+                heads[bucket[v]] = chain[v];
+            }
+            continue;
+        }
+
+        marks[block]   = scopeSize;
+        stack[depth++] = block << 1 | 1;
+        for (uint32_t i = childStart[block]; i < childStart[block + 1]; i++) {
+            stack[depth++] = children[i] << 1;
+        }
+
+        irBlock *b = &f->blocks[block];
+        for (uint32_t i = 0; i < b->size; i++) {
+            uint32_t v  = b->instrs[i];
+            irInstr *in = &f->instrs[v];
+            if (in->dead || in->op > IR_C2S) {
+                continue;
+            }
+
+            for (uint32_t j = 0; j < in->size; j++) {
+                in->args[j] = irResolve(f, in->args[j]);
+            }
+
+            // Commutative operators take their operands in one order
+            bool commutative = in->op == IR_ADDI || in->op == IR_MULI || in->op == IR_EQI || in->op == IR_NEI ||
+                               in->op == IR_ADDF || in->op == IR_MULF || in->op == IR_EQF || in->op == IR_NEF ||
+                               in->op == IR_EQS || in->op == IR_NES || in->op == IR_AND || in->op == IR_OR;
+            if (commutative && in->args[0] > in->args[1]) {
+                uint32_t a  = in->args[0];
+                in->args[0] = in->args[1];
+                in->args[1] = a;
+            }
+
+            uint64_t hash = (uint64_t)in->op * 31 + in->type;
+            hash          = hash * 0x100000001b3u ^ (uint64_t)in->k.i;
+            hash          = hash * 0x100000001b3u ^ (in->op == IR_PHI ? in->block : 0);
+            for (uint32_t j = 0; j < in->size; j++) {
+                hash = hash * 0x100000001b3u ^ in->args[j];
+            }
+            uint32_t slot = (uint32_t)(hash * 0x9e3779b97f4a7c15u >> 32) & (buckets - 1);
+
+            uint32_t same = heads[slot];
+            while (same != IR_NONE && !irSame(f, same, v)) {
+                same = chain[same];
+            }
+
+            if (same != IR_NONE) {
+                in->dead        = true;
+                in->replacement = same;
+                continue;
+            }
+
+            chain[v]            = heads[slot];
+            bucket[v]           = slot;
+            heads[slot]         = v;
+            scoped[scopeSize++] = v;
+        }
+    }
+
+    free(order);
+    free(idom);
+    free(childStart);
+    free(children);
+    free(heads);
+    free(chain);
+    free(bucket);
+    free(scoped);
+    free(stack);
+    free(marks);
+
+    irCleanPhis(f);
+    irCompact(f);
+}
+
+// Check if two instructions compute the same value
+bool irSame(irFunction *f, uint32_t a, uint32_t b) {
+    irInstr *x = &f->instrs[a];
+    irInstr *y = &f->instrs[b];
+
+    if (x->op != y->op || x->type != y->type || x->size != y->size || x->k.i != y->k.i) {
+        return false;
+    }
+    if (x->op == IR_PHI && x->block != y->block) {
+        return false;
+    }
+
+    return x->size == 0 || memcmp(x->args, y->args, x->size * sizeof(uint32_t)) == 0;
+}
+
+// Dead code elimination, keeps what stops the program, calls, writes memory or ends a block, and what they use
+void irDce(irFunction *f) {
+    bool     *live = (bool *)calloc(f->size + 1, sizeof(bool));
+    uint32_t *work = (uint32_t *)malloc((f->size + 1) * sizeof(uint32_t));
+    uint32_t  size = 0;
+
+    for (uint32_t v = 0; v < f->size; v++) {
+        if (!f->instrs[v].dead && !irIsPure(f, &f->instrs[v])) {
+            live[v]      = true;
+            work[size++] = v;
+        }
+    }
+
+    while (size) {
+        irInstr *in = &f->instrs[work[--size]];
+        for (uint32_t i = 0; i < in->size; i++) {
+            if (!live[in->args[i]]) {
+                live[in->args[i]] = true;
+                work[size++]      = in->args[i];
+            }
+        }
+    }
+
+    for (uint32_t v = 0; v < f->size; v++) {
+        if (!live[v]) {
+            f->instrs[v].dead = true;
+        }
+    }
+
+    free(live);
+    free(work);
+
+    irCompact(f);
+}
+
+// Check if an instruction can go when its value is unused, a division only when its divisor is a nonzero constant
+bool irIsPure(irFunction *f, irInstr *in) {
+    switch (in->op) {
+        case IR_STORE:
+        case IR_CALL:
+        case IR_JUMP:
+        case IR_BRANCH:
+        case IR_RETURN:
+            return false;
+        case IR_DIVI:
+        case IR_MODI:
+            return f->instrs[in->args[1]].op == IR_CONST && f->instrs[in->args[1]].k.i != 0;
+        case IR_DIVF:
+            return f->instrs[in->args[1]].op == IR_CONST && f->instrs[in->args[1]].k.r != 0;
+        default:
+            return true;
+    }
+}
+
+// Remove an edge of the control flow graph, and the operand it gave to each phi of the target
+void irRemoveEdge(irFunction *f, uint32_t from, uint32_t to) {
+    irBlock *source = &f->blocks[from];
+    for (uint32_t i = 0; i < source->succSize; i++) {
+        if (source->succs[i] == to) {
+            source->succs[i] = source->succs[--source->succSize];
+            break;
+        }
+    }
+
+    irBlock *target = &f->blocks[to];
+    for (uint32_t i = 0; i < target->predSize; i++) {
+        if (target->preds[i] != from) {
+            continue;
+        }
+
+        memmove(target->preds + i, target->preds + i + 1, (target->predSize - i - 1) * sizeof(uint32_t));
+        target->predSize--;
+
+        for (uint32_t j = 0; j < target->size; j++) {
+            irInstr *in = &f->instrs[target->instrs[j]];
+            if (in->op == IR_PHI && in->size > i) {
+                memmove(in->args + i, in->args + i + 1, (in->size - i - 1) * sizeof(uint32_t));
+                in->size--;
+            }
+        }
+        break;
+    }
+}
+
+// Replace the phis that repeat one value until none is left
+void irCleanPhis(irFunction *f) {
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+        for (uint32_t v = 0; v < f->size; v++) {
+            if (f->instrs[v].op == IR_PHI && !f->instrs[v].dead && irRemoveTrivialPhi(f, v) != v) {
+                changed = true;
+            }
+        }
+    }
+}
+
+// Point every operand at the value that stands for it, and drop the removed instructions from their blocks
+void irCompact(irFunction *f) {
+    for (uint32_t v = 0; v < f->size; v++) {
+        irInstr *in = &f->instrs[v];
+        for (uint32_t i = 0; !in->dead && i < in->size; i++) {
+            in->args[i] = irResolve(f, in->args[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        irBlock *b    = &f->blocks[i];
+        uint32_t size = 0;
+        for (uint32_t j = 0; j < b->size; j++) {
+            if (!f->instrs[b->instrs[j]].dead) {
+                b->instrs[size++] = b->instrs[j];
+            }
+        }
+        b->size = size;
+    }
+}
+
+/*
+Immediate dominators of the reachable blocks, Cooper, Harvey and Kennedy.
+`order` gets the reachable blocks in reverse postorder and `idom` the immediate dominator of each, the entry its own,
+IR_NONE for unreachable blocks. Returns the number of reachable blocks.
+*/
+uint32_t irDominators(irFunction *f, uint32_t *order, uint32_t *idom) {
+    uint32_t *number = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    uint32_t *stack  = (uint32_t *)malloc((f->blockSize + 1) * sizeof(uint32_t));
+    uint32_t *edge   = (uint32_t *)calloc(f->blockSize + 1, sizeof(uint32_t));
+    uint32_t  depth  = 0;
+    uint32_t  count  = 0;
+
+    for (uint32_t i = 0; i < f->blockSize; i++) {
+        number[i] = IR_NONE;
+        idom[i]   = IR_NONE;
+    }
+
+    // Postorder by a walk with an explicit stack, `number` marks the blocks seen
+    number[0]      = 0;
+    stack[depth++] = 0;
+    while (depth) {
+        uint32_t block = stack[depth - 1];
+        irBlock *b     = &f->blocks[block];
+
+        if (edge[block] < b->succSize) {
+            uint32_t next = b->succs[edge[block]++];
+            if (number[next] == IR_NONE) {
+                number[next]   = 0;
+                stack[depth++] = next;
+            }
+            continue;
+        }
+
+        order[count++] = block;
+        depth--;
+    }
+
+    for (uint32_t i = 0; i < count / 2; i++) {
+        uint32_t block       = order[i];
+        order[i]             = order[count - 1 - i];
+        order[count - 1 - i] = block;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        number[order[i]] = i;
+    }
+
+    idom[0]      = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = 1; i < count; i++) {
+            irBlock *b         = &f->blocks[order[i]];
+            uint32_t dominator = IR_NONE;
+
+            for (uint32_t j = 0; j < b->predSize; j++) {
+                uint32_t a = b->preds[j];
+                if (idom[a] == IR_NONE) {
+                    continue;
+                }
+                if (dominator == IR_NONE) {
+                    dominator = a;
+                    continue;
+                }
+
+                uint32_t c = dominator;
+                while (a != c) {
+                    while (number[a] > number[c]) {
+                        a = idom[a];
+                    }
+                    while (number[c] > number[a]) {
+                        c = idom[c];
+                    }
+                }
+                dominator = a;
+            }
+
+            if (idom[order[i]] != dominator) {
+                idom[order[i]] = dominator;
+                changed        = true;
+            }
+        }
+    }
+
+    free(number);
+    free(stack);
+    free(edge);
+    return count;
+}
+
+// Mnemonic of an opcode
+char *irOpName(irOp op) {
+    char *names[] = {
+        "CONST", "PARAM", "PHI",
+        "ADDI",  "SUBI",  "MULI", "DIVI", "MODI", "NEGI",
+        "ADDF",  "SUBF",  "MULF", "DIVF", "NEGF", "I2F",
+        "EQI",   "NEI",   "LTI",  "LEI",  "EQF",  "NEF",    "LTF", "LEF", "EQS", "NES", "LTS", "LES",
+        "NOT",   "AND",   "OR",   "CONCAT", "C2S",
+        "LOAD",  "STORE", "ADDR", "CALL",
+        "JMP",   "BRANCH", "RET",
+    };
+
+    return op < IR_OPS ? names[op] : "?";
+}
\ No newline at end of file
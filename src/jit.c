@@ -0,0 +1,662 @@
+#include "jit.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "error.h"
+#include "vm.h"
+
+/*
+Stencils, written by tools/stencils.py from the x86-64 code of tools/stencils.s, which is also in their comments, where
+A, B and C stand for register offsets, I for the immediate, K for a constant and the other capitals for the holes of the
+same name.
+Each hole is a relocation of the assembled code, so the zeroed bytes are exactly the ones the assembler left to the
+linker, and the relative ones all end their instruction. Edit the assembly and run the script, not this table.
+*/
+static const jitStencil jitStencils[JIT_STENCILS] = {
+    // JIT_ENTRY: push rbp; push rbx; push r12; push r13; push r14; push r15; sub rsp, 8; mov r14, rdi; mov rbx, rsi
+    // mov r12, rdx; mov r13, rcx; mov [r14+24], rsp; call r8; add rsp, 8; pop r15; pop r14; pop r13; pop r12; pop rbx
+    // pop rbp; ret
+    {"\x55\x53\x41\x54\x41\x55\x41\x56\x41\x57\x48\x83\xec\x08\x49\x89\xfe\x48\x89\xf3\x49\x89\xd4\x49"
+     "\x89\xcd\x49\x89\x66\x18\x41\xff\xd0\x48\x83\xc4\x08\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5b\x5d\xc3",
+     48, 0, {{0, 0}}},
+    // JIT_EXIT: mov rsp, [r14+24]; xor eax, eax; add rsp, 8; pop r15; pop r14; pop r13; pop r12; pop rbx; pop rbp; ret
+    {"\x49\x8b\x66\x18\x31\xc0\x48\x83\xc4\x08\x41\x5f\x41\x5e\x41\x5d\x41\x5c\x5b\x5d\xc3", 21, 0, {{0, 0}}},
+    // JIT_PROLOGUE: sub rsp, 8
+    {"\x48\x83\xec\x08", 4, 0, {{0, 0}}},
+    // JIT_TICK: sub [r14+32], 1; jnz 1f; mov rdi, r14; mov rsi, r12; mov edx, PC; movabs rax, TICK; call rax
+    // test al, al; jz EXIT; 1:
+    {"\x49\x83\x6e\x20\x01\x75\x1f\x4c\x89\xf7\x4c\x89\xe6\xba\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00"
+     "\x00\x00\x00\x00\xff\xd0\x84\xc0\x0f\x84\x00\x00\x00\x00",
+     38, 3, {{14, JIT_HOLE_PC}, {20, JIT_HOLE_TICK}, {34, JIT_HOLE_EXIT}}},
+    // JIT_FAIL: mov rdi, r14; mov rsi, r12; mov edx, PC; movabs rcx, MSG; movabs rax, FAIL; call rax; jmp EXIT
+    {"\x4c\x89\xf7\x4c\x89\xe6\xba\x00\x00\x00\x00\x48\xb9\x00\x00\x00\x00\x00\x00\x00\x00\x48\xb8\x00"
+     "\x00\x00\x00\x00\x00\x00\x00\xff\xd0\xe9\x00\x00\x00\x00",
+     38, 4, {{7, JIT_HOLE_PC}, {13, JIT_HOLE_MESSAGE}, {23, JIT_HOLE_FAIL}, {34, JIT_HOLE_EXIT}}},
+    // JIT_HALT: add rsp, 8; mov eax, 1; ret
+    {"\x48\x83\xc4\x08\xb8\x01\x00\x00\x00\xc3", 10, 0, {{0, 0}}},
+    // JIT_MOVE: mov rax, [rbx+B]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_B}, {10, JIT_HOLE_A}}},
+    // JIT_LOADI: mov [rbx+A], I
+    {"\x48\xc7\x83\x00\x00\x00\x00\x00\x00\x00\x00", 11, 2, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}}},
+    // JIT_LOADK: movabs rax, K; mov [rbx+A], rax
+    {"\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     17, 2, {{2, JIT_HOLE_CONSTANT}, {13, JIT_HOLE_A}}},
+    // JIT_GETG: mov rax, [r13+C]; mov [rbx+A], rax
+    {"\x49\x8b\x85\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_C}, {10, JIT_HOLE_A}}},
+    // JIT_SETG: mov rax, [rbx+A]; mov [r13+C], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x49\x89\x85\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_A}, {10, JIT_HOLE_C}}},
+    // JIT_FRAME: mov rcx, r12
+    {"\x4c\x89\xe1", 3, 0, {{0, 0}}},
+    // JIT_LINK: mov rcx, [rcx+24]
+    {"\x48\x8b\x49\x18", 4, 0, {{0, 0}}},
+    // JIT_GETUP: mov rcx, [rcx+16]; mov rax, [rcx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x49\x10\x48\x8b\x81\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     18, 2, {{7, JIT_HOLE_C}, {14, JIT_HOLE_A}}},
+    // JIT_SETUP: mov rcx, [rcx+16]; mov rax, [rbx+A]; mov [rcx+C], rax
+    {"\x48\x8b\x49\x10\x48\x8b\x83\x00\x00\x00\x00\x48\x89\x81\x00\x00\x00\x00",
+     18, 2, {{7, JIT_HOLE_A}, {14, JIT_HOLE_C}}},
+    // JIT_ADDRUP: mov rcx, [rcx+16]; lea rax, [rcx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x49\x10\x48\x8d\x81\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     18, 2, {{7, JIT_HOLE_C}, {14, JIT_HOLE_A}}},
+    // JIT_ADDR: lea rax, [rbx+B]; mov [rbx+A], rax
+    {"\x48\x8d\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_B}, {10, JIT_HOLE_A}}},
+    // JIT_ADDRG: lea rax, [r13+C]; mov [rbx+A], rax
+    {"\x49\x8d\x85\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_C}, {10, JIT_HOLE_A}}},
+    // JIT_LOADREF: mov rax, [rbx+B]; mov rax, [rax]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x8b\x00\x48\x89\x83\x00\x00\x00\x00",
+     17, 2, {{3, JIT_HOLE_B}, {13, JIT_HOLE_A}}},
+    // JIT_STOREREF: mov rax, [rbx+A]; mov rcx, [rbx+B]; mov [rax], rcx
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x8b\x8b\x00\x00\x00\x00\x48\x89\x08",
+     17, 2, {{3, JIT_HOLE_A}, {10, JIT_HOLE_B}}},
+    // JIT_ADDI: mov rax, [rbx+B]; add rax, [rbx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x03\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     21, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {17, JIT_HOLE_A}}},
+    // JIT_SUBI: mov rax, [rbx+B]; sub rax, [rbx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x2b\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     21, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {17, JIT_HOLE_A}}},
+    // JIT_MULI: mov rax, [rbx+B]; imul rax, [rbx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x0f\xaf\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     22, 3, {{3, JIT_HOLE_B}, {11, JIT_HOLE_C}, {18, JIT_HOLE_A}}},
+    // JIT_AND: mov rax, [rbx+B]; and rax, [rbx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x23\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     21, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {17, JIT_HOLE_A}}},
+    // JIT_OR: mov rax, [rbx+B]; or rax, [rbx+C]; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x0b\x83\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     21, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {17, JIT_HOLE_A}}},
+    // JIT_DIVI: mov rcx, [rbx+C]; test rcx, rcx; je ERROR; mov rax, [rbx+B]; cmp rcx, -1; jne 1f; neg rax; jmp 2f; 1:
+    // cqo; idiv rcx; 2:; mov [rbx+A], rax
+    {"\x48\x8b\x8b\x00\x00\x00\x00\x48\x85\xc9\x0f\x84\x00\x00\x00\x00\x48\x8b\x83\x00\x00\x00\x00\x48"
+     "\x83\xf9\xff\x75\x05\x48\xf7\xd8\xeb\x05\x48\x99\x48\xf7\xf9\x48\x89\x83\x00\x00\x00\x00",
+     46, 4, {{3, JIT_HOLE_C}, {12, JIT_HOLE_ERROR}, {19, JIT_HOLE_B}, {42, JIT_HOLE_A}}},
+    // JIT_MODI: mov rcx, [rbx+C]; test rcx, rcx; je ERROR; mov rax, [rbx+B]; cmp rcx, -1; jne 1f; xor eax, eax; jmp 2f
+    // 1:; cqo; idiv rcx; mov rax, rdx; 2:; mov [rbx+A], rax
+    {"\x48\x8b\x8b\x00\x00\x00\x00\x48\x85\xc9\x0f\x84\x00\x00\x00\x00\x48\x8b\x83\x00\x00\x00\x00\x48"
+     "\x83\xf9\xff\x75\x04\x31\xc0\xeb\x08\x48\x99\x48\xf7\xf9\x48\x89\xd0\x48\x89\x83\x00\x00\x00\x00",
+     48, 4, {{3, JIT_HOLE_C}, {12, JIT_HOLE_ERROR}, {19, JIT_HOLE_B}, {44, JIT_HOLE_A}}},
+    // JIT_ADDIK: mov rax, [rbx+B]; add rax, I; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x05\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_B}, {9, JIT_HOLE_IMMEDIATE}, {16, JIT_HOLE_A}}},
+    // JIT_SUBIK: mov rax, [rbx+B]; sub rax, I; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x2d\x00\x00\x00\x00\x48\x89\x83\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_B}, {9, JIT_HOLE_IMMEDIATE}, {16, JIT_HOLE_A}}},
+    // JIT_NEGI: mov rax, [rbx+B]; neg rax; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\xf7\xd8\x48\x89\x83\x00\x00\x00\x00",
+     17, 2, {{3, JIT_HOLE_B}, {13, JIT_HOLE_A}}},
+    // JIT_ADDF: movsd xmm0, [rbx+B]; addsd xmm0, [rbx+C]; movsd [rbx+A], xmm0
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\xf2\x0f\x58\x83\x00\x00\x00\x00\xf2\x0f\x11\x83\x00\x00\x00\x00",
+     24, 3, {{4, JIT_HOLE_B}, {12, JIT_HOLE_C}, {20, JIT_HOLE_A}}},
+    // JIT_SUBF: movsd xmm0, [rbx+B]; subsd xmm0, [rbx+C]; movsd [rbx+A], xmm0
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\xf2\x0f\x5c\x83\x00\x00\x00\x00\xf2\x0f\x11\x83\x00\x00\x00\x00",
+     24, 3, {{4, JIT_HOLE_B}, {12, JIT_HOLE_C}, {20, JIT_HOLE_A}}},
+    // JIT_MULF: movsd xmm0, [rbx+B]; mulsd xmm0, [rbx+C]; movsd [rbx+A], xmm0
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\xf2\x0f\x59\x83\x00\x00\x00\x00\xf2\x0f\x11\x83\x00\x00\x00\x00",
+     24, 3, {{4, JIT_HOLE_B}, {12, JIT_HOLE_C}, {20, JIT_HOLE_A}}},
+    // JIT_DIVF: movsd xmm1, [rbx+C]; xorpd xmm0, xmm0; ucomisd xmm1, xmm0; jp 1f; je ERROR; 1:; movsd xmm0, [rbx+B]
+    // divsd xmm0, xmm1; movsd [rbx+A], xmm0
+    {"\xf2\x0f\x10\x8b\x00\x00\x00\x00\x66\x0f\x57\xc0\x66\x0f\x2e\xc8\x7a\x06\x0f\x84\x00\x00\x00\x00"
+     "\xf2\x0f\x10\x83\x00\x00\x00\x00\xf2\x0f\x5e\xc1\xf2\x0f\x11\x83\x00\x00\x00\x00",
+     44, 4, {{4, JIT_HOLE_C}, {20, JIT_HOLE_ERROR}, {28, JIT_HOLE_B}, {40, JIT_HOLE_A}}},
+    // JIT_NEGF: mov rax, [rbx+B]; btc rax, 63; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x0f\xba\xf8\x3f\x48\x89\x83\x00\x00\x00\x00",
+     19, 2, {{3, JIT_HOLE_B}, {15, JIT_HOLE_A}}},
+    // JIT_I2F: pxor xmm0, xmm0; cvtsi2sd xmm0, [rbx+B]; movsd [rbx+A], xmm0
+    {"\x66\x0f\xef\xc0\xf2\x48\x0f\x2a\x83\x00\x00\x00\x00\xf2\x0f\x11\x83\x00\x00\x00\x00",
+     21, 2, {{9, JIT_HOLE_B}, {17, JIT_HOLE_A}}},
+    // JIT_EQI: mov rax, [rbx+B]; cmp rax, [rbx+C]; sete al; movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x94\xc0\x0f\xb6\xc0\x48\x89\x83\x00"
+     "\x00\x00\x00", 27, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {23, JIT_HOLE_A}}},
+    // JIT_NEI: mov rax, [rbx+B]; cmp rax, [rbx+C]; setne al; movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x95\xc0\x0f\xb6\xc0\x48\x89\x83\x00"
+     "\x00\x00\x00", 27, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {23, JIT_HOLE_A}}},
+    // JIT_LTI: mov rax, [rbx+B]; cmp rax, [rbx+C]; setl al; movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x9c\xc0\x0f\xb6\xc0\x48\x89\x83\x00"
+     "\x00\x00\x00", 27, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {23, JIT_HOLE_A}}},
+    // JIT_LEI: mov rax, [rbx+B]; cmp rax, [rbx+C]; setle al; movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x9e\xc0\x0f\xb6\xc0\x48\x89\x83\x00"
+     "\x00\x00\x00", 27, 3, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {23, JIT_HOLE_A}}},
+    // JIT_EQF: movsd xmm0, [rbx+B]; ucomisd xmm0, [rbx+C]; sete al; setnp cl; and al, cl; movzx eax, al
+    // mov [rbx+A], rax
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\x66\x0f\x2e\x83\x00\x00\x00\x00\x0f\x94\xc0\x0f\x9b\xc1\x20\xc8"
+     "\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00", 34, 3, {{4, JIT_HOLE_B}, {12, JIT_HOLE_C}, {30, JIT_HOLE_A}}},
+    // JIT_NEF: movsd xmm0, [rbx+B]; ucomisd xmm0, [rbx+C]; setne al; setp cl; or al, cl; movzx eax, al
+    // mov [rbx+A], rax
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\x66\x0f\x2e\x83\x00\x00\x00\x00\x0f\x95\xc0\x0f\x9a\xc1\x08\xc8"
+     "\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00", 34, 3, {{4, JIT_HOLE_B}, {12, JIT_HOLE_C}, {30, JIT_HOLE_A}}},
+    // JIT_LTF: movsd xmm0, [rbx+C]; ucomisd xmm0, [rbx+B]; seta al; movzx eax, al; mov [rbx+A], rax
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\x66\x0f\x2e\x83\x00\x00\x00\x00\x0f\x97\xc0\x0f\xb6\xc0\x48\x89"
+     "\x83\x00\x00\x00\x00", 29, 3, {{4, JIT_HOLE_C}, {12, JIT_HOLE_B}, {25, JIT_HOLE_A}}},
+    // JIT_LEF: movsd xmm0, [rbx+C]; ucomisd xmm0, [rbx+B]; setae al; movzx eax, al; mov [rbx+A], rax
+    {"\xf2\x0f\x10\x83\x00\x00\x00\x00\x66\x0f\x2e\x83\x00\x00\x00\x00\x0f\x93\xc0\x0f\xb6\xc0\x48\x89"
+     "\x83\x00\x00\x00\x00", 29, 3, {{4, JIT_HOLE_C}, {12, JIT_HOLE_B}, {25, JIT_HOLE_A}}},
+    // JIT_EQS: mov rdi, [rbx+B]; mov rsi, [rbx+C]; movabs rax, COMPARE; call rax; test eax, eax; sete al; movzx eax, al
+    // mov [rbx+A], rax
+    {"\x48\x8b\xbb\x00\x00\x00\x00\x48\x8b\xb3\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00"
+     "\xff\xd0\x85\xc0\x0f\x94\xc0\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00",
+     41, 4, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {16, JIT_HOLE_COMPARE}, {37, JIT_HOLE_A}}},
+    // JIT_NES: mov rdi, [rbx+B]; mov rsi, [rbx+C]; movabs rax, COMPARE; call rax; test eax, eax; setne al
+    // movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\xbb\x00\x00\x00\x00\x48\x8b\xb3\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00"
+     "\xff\xd0\x85\xc0\x0f\x95\xc0\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00",
+     41, 4, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {16, JIT_HOLE_COMPARE}, {37, JIT_HOLE_A}}},
+    // JIT_LTS: mov rdi, [rbx+B]; mov rsi, [rbx+C]; movabs rax, COMPARE; call rax; test eax, eax; setl al; movzx eax, al
+    // mov [rbx+A], rax
+    {"\x48\x8b\xbb\x00\x00\x00\x00\x48\x8b\xb3\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00"
+     "\xff\xd0\x85\xc0\x0f\x9c\xc0\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00",
+     41, 4, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {16, JIT_HOLE_COMPARE}, {37, JIT_HOLE_A}}},
+    // JIT_LES: mov rdi, [rbx+B]; mov rsi, [rbx+C]; movabs rax, COMPARE; call rax; test eax, eax; setle al
+    // movzx eax, al; mov [rbx+A], rax
+    {"\x48\x8b\xbb\x00\x00\x00\x00\x48\x8b\xb3\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00"
+     "\xff\xd0\x85\xc0\x0f\x9e\xc0\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00",
+     41, 4, {{3, JIT_HOLE_B}, {10, JIT_HOLE_C}, {16, JIT_HOLE_COMPARE}, {37, JIT_HOLE_A}}},
+    // JIT_NOT: cmp [rbx+B], 0; sete al; movzx eax, al; mov [rbx+A], rax
+    {"\x48\x83\xbb\x00\x00\x00\x00\x00\x0f\x94\xc0\x0f\xb6\xc0\x48\x89\x83\x00\x00\x00\x00",
+     21, 2, {{3, JIT_HOLE_B}, {17, JIT_HOLE_A}}},
+    // JIT_CONCAT: mov rdi, [r14]; mov rsi, [rbx+B]; mov rdx, [rbx+C]; movabs rax, STRING; call rax; mov [rbx+A], rax
+    {"\x49\x8b\x3e\x48\x8b\xb3\x00\x00\x00\x00\x48\x8b\x93\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00"
+     "\x00\x00\x00\xff\xd0\x48\x89\x83\x00\x00\x00\x00",
+     36, 4, {{6, JIT_HOLE_B}, {13, JIT_HOLE_C}, {19, JIT_HOLE_STRING}, {32, JIT_HOLE_A}}},
+    // JIT_C2S: mov rdi, [r14]; mov rsi, [rbx+B]; movabs rax, CHAR; call rax; mov [rbx+A], rax
+    {"\x49\x8b\x3e\x48\x8b\xb3\x00\x00\x00\x00\x48\xb8\x00\x00\x00\x00\x00\x00\x00\x00\xff\xd0\x48\x89"
+     "\x83\x00\x00\x00\x00", 29, 3, {{6, JIT_HOLE_B}, {12, JIT_HOLE_CHAR}, {25, JIT_HOLE_A}}},
+    // JIT_JMP: jmp TARGET
+    {"\xe9\x00\x00\x00\x00", 5, 1, {{1, JIT_HOLE_TARGET}}},
+    // JIT_JMPF: cmp [rbx+A], 0; je TARGET
+    {"\x48\x83\xbb\x00\x00\x00\x00\x00\x0f\x84\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_A}, {10, JIT_HOLE_TARGET}}},
+    // JIT_JMPT: cmp [rbx+A], 0; jne TARGET
+    {"\x48\x83\xbb\x00\x00\x00\x00\x00\x0f\x85\x00\x00\x00\x00", 14, 2, {{3, JIT_HOLE_A}, {10, JIT_HOLE_TARGET}}},
+    // JIT_JLTI: mov rax, [rbx+A]; cmp rax, [rbx+B]; jl TARGET
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x8c\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_A}, {10, JIT_HOLE_B}, {16, JIT_HOLE_TARGET}}},
+    // JIT_JLEI: mov rax, [rbx+A]; cmp rax, [rbx+B]; jle TARGET
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x8e\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_A}, {10, JIT_HOLE_B}, {16, JIT_HOLE_TARGET}}},
+    // JIT_JEQI: mov rax, [rbx+A]; cmp rax, [rbx+B]; je TARGET
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x84\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_A}, {10, JIT_HOLE_B}, {16, JIT_HOLE_TARGET}}},
+    // JIT_JNEI: mov rax, [rbx+A]; cmp rax, [rbx+B]; jne TARGET
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x3b\x83\x00\x00\x00\x00\x0f\x85\x00\x00\x00\x00",
+     20, 3, {{3, JIT_HOLE_A}, {10, JIT_HOLE_B}, {16, JIT_HOLE_TARGET}}},
+    // JIT_JLTIK: cmp [rbx+A], I; jl TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x8c\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_JLEIK: cmp [rbx+A], I; jle TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x8e\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_JGTIK: cmp [rbx+A], I; jg TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x8f\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_JGEIK: cmp [rbx+A], I; jge TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x8d\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_JEQIK: cmp [rbx+A], I; je TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x84\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_JNEIK: cmp [rbx+A], I; jne TARGET
+    {"\x48\x81\xbb\x00\x00\x00\x00\x00\x00\x00\x00\x0f\x85\x00\x00\x00\x00",
+     17, 3, {{3, JIT_HOLE_A}, {7, JIT_HOLE_IMMEDIATE}, {13, JIT_HOLE_TARGET}}},
+    // JIT_CALL: lea rax, [rbx+A]; cmp r12, [r14+16]; je ERROR; mov rdx, [r14+8]; sub rdx, rax; cmp rdx, SIZE; jb ERROR
+    // mov rcx, r12
+    {"\x48\x8d\x83\x00\x00\x00\x00\x4d\x3b\x66\x10\x0f\x84\x00\x00\x00\x00\x49\x8b\x56\x08\x48\x29\xc2"
+     "\x48\x81\xfa\x00\x00\x00\x00\x0f\x82\x00\x00\x00\x00\x4c\x89\xe1",
+     40, 4, {{3, JIT_HOLE_A}, {13, JIT_HOLE_ERROR}, {27, JIT_HOLE_SIZE}, {33, JIT_HOLE_ERROR}}},
+    // JIT_ENTER: add r12, 32; movabs rdx, FUNCTION; mov [r12], rdx; mov [r12+16], rax; mov [r12+24], rcx; mov rbx, rax
+    {"\x49\x83\xc4\x20\x48\xba\x00\x00\x00\x00\x00\x00\x00\x00\x49\x89\x14\x24\x49\x89\x44\x24\x10\x49"
+     "\x89\x4c\x24\x18\x48\x89\xc3", 31, 1, {{6, JIT_HOLE_FUNCTION}}},
+    // JIT_ZERO: mov [rbx+A], 0
+    {"\x48\xc7\x83\x00\x00\x00\x00\x00\x00\x00\x00", 11, 1, {{3, JIT_HOLE_A}}},
+    // JIT_ZEROS: lea rdi, [rbx+A]; mov ecx, COUNT; xor eax, eax; rep stosq
+    {"\x48\x8d\xbb\x00\x00\x00\x00\xb9\x00\x00\x00\x00\x31\xc0\xf3\x48\xab",
+     17, 2, {{3, JIT_HOLE_A}, {8, JIT_HOLE_COUNT}}},
+    // JIT_INVOKE: call CALL
+    {"\xe8\x00\x00\x00\x00", 5, 1, {{1, JIT_HOLE_CALL}}},
+    // JIT_RESULT: mov rax, [rbx+B]; mov [rbx], rax
+    {"\x48\x8b\x83\x00\x00\x00\x00\x48\x89\x03", 10, 1, {{3, JIT_HOLE_B}}},
+    // JIT_RET: sub r12, 32; mov rbx, [r12+16]; add rsp, 8; ret
+    {"\x49\x83\xec\x20\x49\x8b\x5c\x24\x10\x48\x83\xc4\x08\xc3", 14, 0, {{0, 0}}},
+};
+
+// Stencil of each opcode that copies a single stencil, in the order of bcOp
+static const uint8_t jitOpStencils[BC_OPCODES] = {
+    JIT_HALT, JIT_MOVE, JIT_LOADI, JIT_LOADK, JIT_GETG, JIT_SETG,
+    JIT_GETUP, JIT_SETUP, JIT_ADDR, JIT_ADDRG, JIT_ADDRUP, JIT_LOADREF, JIT_STOREREF,
+    JIT_ADDI, JIT_SUBI, JIT_MULI, JIT_DIVI, JIT_MODI, JIT_ADDIK, JIT_SUBIK, JIT_NEGI,
+    JIT_ADDF, JIT_SUBF, JIT_MULF, JIT_DIVF, JIT_NEGF, JIT_I2F,
+    JIT_EQI, JIT_NEI, JIT_LTI, JIT_LEI, JIT_EQF, JIT_NEF, JIT_LTF, JIT_LEF, JIT_EQS, JIT_NES, JIT_LTS, JIT_LES,
+    JIT_NOT, JIT_AND, JIT_OR, JIT_CONCAT, JIT_C2S,
+    JIT_JMP, JIT_JMPF, JIT_JMPT, JIT_JLTI, JIT_JLEI, JIT_JEQI, JIT_JNEI,
+    JIT_JLTIK, JIT_JLEIK, JIT_JGTIK, JIT_JGEIK, JIT_JEQIK, JIT_JNEIK,
+    JIT_CALL, JIT_RET,
+};
+
+// Compile a program to machine code, returns NULL if the host can't run it, the program runs on the VM then
+Jit *jitNew(bcProgram *program) {
+#ifndef JIT_AVAILABLE
+    (void)program;
+    return NULL;
+#else
+    uint64_t start = pbNow();
+
+    Jit *jit = (Jit *)calloc(1, sizeof(Jit));
+    if (!jit) {
+        return NULL;
+    }
+
+    uint64_t instructions = 0;
+    for (uint32_t i = 0; i < program->size; i++) {
+        instructions += program->functions[i].size;
+    }
+
+    jit->program      = program;
+    jit->functions    = (uint32_t *)malloc((program->size + 1) * sizeof(uint32_t));
+    jit->instructions = (uint32_t *)malloc((instructions + 1) * sizeof(uint32_t));
+
+    jitPatch none;
+    memset(&none, 0, sizeof(none));
+    jit->entry = jitCopy(jit, JIT_ENTRY, &none);
+    jit->exit  = jitCopy(jit, JIT_EXIT, &none);
+
+    for (uint32_t i = 0; i < program->size; i++) {
+        jitCompileFunction(jit, i);
+    }
+
+    if (!jit->functions || !jit->instructions || !jitResolve(jit) || !jitMap(jit)) {
+        jitFree(jit);
+        return NULL;
+    }
+
+    jit->compileTime = pbNow() - start;
+    return jit;
+#endif
+}
+
+// Free the compiled code, the program is left alone
+void jitFree(Jit *jit) {
+#ifdef JIT_AVAILABLE
+    if (jit->mappedSize) {
+        munmap(jit->code, jit->mappedSize);
+    } else {
+        free(jit->code);
+    }
+#else
+    free(jit->code);
+#endif
+
+    free(jit->functions);
+    free(jit->instructions);
+    free(jit->fixups);
+    free(jit->errors);
+    free(jit->exits);
+    free(jit);
+}
+
+// Run the compiled program on a machine like vmRun does, returns false if it stopped on a runtime error or went past
+// the deadline, a pbNow() time or 0 for none
+bool jitRun(Jit *jit, VM *vm, uint64_t deadline) {
+    bcFunction *f     = &jit->program->functions[0];
+    vmFrame    *frame = vm->frames;
+
+    frame->function = f;
+    frame->ip       = NULL;
+    frame->base     = vm->stack;
+    frame->link     = NULL;
+
+    if (f->registers > VM_STACK_SIZE) {
+        vmError(vm, frame, f->code + 1, "estouro de pilha");
+        return false;
+    }
+    memset(vm->stack, 0, f->registers * sizeof(bcValue));
+
+    jitContext context;
+    context.vm       = vm;
+    context.end      = vm->stack + VM_STACK_SIZE;
+    context.last     = vm->frames + VM_MAX_FRAMES - 1;
+    context.stack    = NULL;
+    context.fuel     = deadline ? JIT_FUEL : INT64_MAX;
+    context.deadline = deadline;
+
+    jitEntryPoint entry = (jitEntryPoint)(jit->code + jit->entry);
+    return entry(&context, vm->stack, frame, vm->stack, jit->code + jit->functions[0]);
+}
+
+// Copy the stencils of a function, then its runtime error exits
+void jitCompileFunction(Jit *jit, uint32_t index) {
+    bcFunction *f = &jit->program->functions[index];
+
+    jitPatch patch;
+    memset(&patch, 0, sizeof(patch));
+
+    // A function checks the fuel on entry and each loop before it jumps back, so recursion and loops both run out
+    jit->functions[index] = jitCopy(jit, JIT_PROLOGUE, &patch);
+    jitCopy(jit, JIT_TICK, &patch);
+
+    for (uint32_t pc = 0; pc < f->size; pc++) {
+        jit->instructions[jit->instructionBase + pc] = jit->size;
+        jitCompileInstruction(jit, f, pc);
+    }
+
+    for (uint32_t i = 0; i < jit->errorSize; i++) {
+        patch.pc      = jit->errors[i].pc;
+        patch.message = jit->errors[i].msg;
+
+        jit->exits = (uint32_t *)astGrowArray(jit->exits, jit->exitSize, &jit->exitCapacity, sizeof(uint32_t));
+        jit->exits[jit->exitSize++] = jitCopy(jit, JIT_FAIL, &patch);
+    }
+
+    jit->errorSize = 0;
+    jit->instructionBase += f->size;
+}
+
+// Copy the stencils of an instruction
+void jitCompileInstruction(Jit *jit, bcFunction *f, uint32_t pc) {
+    bcInstr in = f->code[pc];
+
+    jitPatch patch;
+    memset(&patch, 0, sizeof(patch));
+    patch.a      = (int64_t)in.a * sizeof(bcValue);
+    patch.b      = (int64_t)in.b * sizeof(bcValue);
+    patch.c      = (int64_t)in.c * sizeof(bcValue);
+    patch.pc     = pc;
+    patch.target = jit->instructionBase + in.c;
+
+    switch (in.op) {
+        case BC_LOADI:
+        case BC_ADDIK:
+        case BC_SUBIK:
+            patch.immediate = ((int64_t)in.c ^ 0x800000) - 0x800000;
+            break;
+        case BC_LOADK:
+            memcpy(&patch.constant, &jit->program->constants[in.c], sizeof(uint64_t));
+            break;
+        case BC_JLTIK:
+        case BC_JLEIK:
+        case BC_JGTIK:
+        case BC_JGEIK:
+        case BC_JEQIK:
+        case BC_JNEIK:
+            patch.immediate = (int16_t)in.b;
+            break;
+        case BC_DIVI:
+        case BC_MODI:
+        case BC_DIVF:
+            patch.error = jitErrorExit(jit, pc, "divisão por zero");
+            break;
+        case BC_GETUP:
+        case BC_SETUP:
+        case BC_ADDRUP:
+            jitCopy(jit, JIT_FRAME, &patch);
+            jitCompileWalk(jit, in.b);
+            break;
+        case BC_CALL: {
+            bcFunction *callee = &jit->program->functions[in.b];
+
+            patch.size  = callee->registers * sizeof(bcValue);
+            patch.error = jitErrorExit(jit, pc, "estouro de pilha");
+            jitCopy(jit, JIT_CALL, &patch);
+            jitCompileWalk(jit, in.c);
+
+            patch.function = callee;
+            jitCopy(jit, JIT_ENTER, &patch);
+
+            // The arguments are in place, the rest of the frame starts zeroed
+            if (callee->registers - callee->parameters <= JIT_ZERO_INLINE) {
+                for (uint32_t r = callee->parameters; r < callee->registers; r++) {
+                    patch.a = (int64_t)r * sizeof(bcValue);
+                    jitCopy(jit, JIT_ZERO, &patch);
+                }
+            } else {
+                patch.a     = (int64_t)callee->parameters * sizeof(bcValue);
+                patch.count = callee->registers - callee->parameters;
+                jitCopy(jit, JIT_ZEROS, &patch);
+            }
+
+            patch.callee = in.b;
+            jitCopy(jit, JIT_INVOKE, &patch);
+            return;
+        }
+        case BC_RET:
+            if (f->result != BC_ANY) {
+                patch.b = (int64_t)f->result * sizeof(bcValue);
+                jitCopy(jit, JIT_RESULT, &patch);
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (in.op >= BC_JMP && in.op <= BC_JNEIK && in.c <= pc) {
+        jitCopy(jit, JIT_TICK, &patch);
+    }
+
+    jitCopy(jit, jitOpStencils[in.op], &patch);
+}
+
+// Copy the walk up the static links that leaves the frame `links` levels up in rcx, JIT_CALL starts it itself
+void jitCompileWalk(Jit *jit, uint32_t links) {
+    jitPatch patch;
+    memset(&patch, 0, sizeof(patch));
+
+    for (uint32_t k = 0; k < links; k++) {
+        jitCopy(jit, JIT_LINK, &patch);
+    }
+}
+
+// Copy a stencil to the end of the code and patch its holes, returns its offset
+// Relative holes are recorded and patched by jitResolve, once the code they point to is written
+uint32_t jitCopy(Jit *jit, jitStencilId id, jitPatch *patch) {
+    const jitStencil *s = &jitStencils[id];
+
+    if (jit->size + s->size > jit->capacity) {
+        jit->capacity = jit->capacity ? jit->capacity * 2 : 4096;
+        jit->code     = (uint8_t *)realloc(jit->code, jit->capacity);
+    }
+
+    uint32_t at = jit->size;
+    memcpy(jit->code + at, s->code, s->size);
+    jit->size += s->size;
+
+    for (uint32_t i = 0; i < s->holeCount; i++) {
+        uint8_t *hole  = jit->code + at + s->holes[i].offset;
+        uint64_t value = 0;
+        uint32_t index = 0;
+        uint32_t width = 4;
+
+        switch (s->holes[i].kind) {
+            case JIT_HOLE_A:
+                value = (uint64_t)patch->a;
+                break;
+            case JIT_HOLE_B:
+                value = (uint64_t)patch->b;
+                break;
+            case JIT_HOLE_C:
+                value = (uint64_t)patch->c;
+                break;
+            case JIT_HOLE_IMMEDIATE:
+                value = (uint64_t)patch->immediate;
+                break;
+            case JIT_HOLE_PC:
+                value = patch->pc;
+                break;
+            case JIT_HOLE_COUNT:
+                value = patch->count;
+                break;
+            case JIT_HOLE_SIZE:
+                value = patch->size;
+                break;
+            case JIT_HOLE_CONSTANT:
+                value = patch->constant;
+                width = 8;
+                break;
+            case JIT_HOLE_FUNCTION:
+                value = (uint64_t)(uintptr_t)patch->function;
+                width = 8;
+                break;
+            case JIT_HOLE_MESSAGE:
+                value = (uint64_t)(uintptr_t)patch->message;
+                width = 8;
+                break;
+            case JIT_HOLE_FAIL:
+                value = (uint64_t)(uintptr_t)&jitFail;
+                width = 8;
+                break;
+            case JIT_HOLE_TICK:
+                value = (uint64_t)(uintptr_t)&jitTick;
+                width = 8;
+                break;
+            case JIT_HOLE_COMPARE:
+                value = (uint64_t)(uintptr_t)&jitCompareStrings;
+                width = 8;
+                break;
+            case JIT_HOLE_STRING:
+                value = (uint64_t)(uintptr_t)&vmString;
+                width = 8;
+                break;
+            case JIT_HOLE_CHAR:
+                value = (uint64_t)(uintptr_t)&jitCharString;
+                width = 8;
+                break;
+            default:
+                index = s->holes[i].kind == JIT_HOLE_TARGET ? patch->target
+                        : s->holes[i].kind == JIT_HOLE_CALL ? patch->callee
+                                                            : patch->error;
+
+                jit->fixups = (jitFixup *)astGrowArray(jit->fixups, jit->fixupSize, &jit->fixupCapacity,
+                                                       sizeof(jitFixup));
+                jit->fixups[jit->fixupSize++] = (jitFixup){at + s->holes[i].offset, s->holes[i].kind, index};
+                continue;
+        }
+
+        memcpy(hole, &value, width);
+    }
+
+    return at;
+}
+
+// Add a runtime error exit for an instruction of the function being written, returns its index in the program
+uint32_t jitErrorExit(Jit *jit, uint32_t pc, char *msg) {
+    jit->errors = (jitError *)astGrowArray(jit->errors, jit->errorSize, &jit->errorCapacity, sizeof(jitError));
+    jit->errors[jit->errorSize++] = (jitError){pc, msg};
+
+    return jit->exitSize + jit->errorSize - 1;
+}
+
+// Patch the relative holes, returns false if the code is too large for them
+bool jitResolve(Jit *jit) {
+    if (jit->size > INT32_MAX) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < jit->fixupSize; i++) {
+        jitFixup *fixup  = &jit->fixups[i];
+        uint32_t  target = jit->exit;
+
+        switch (fixup->kind) {
+            case JIT_HOLE_TARGET:
+                target = jit->instructions[fixup->index];
+                break;
+            case JIT_HOLE_CALL:
+                target = jit->functions[fixup->index];
+                break;
+            case JIT_HOLE_ERROR:
+                target = jit->exits[fixup->index];
+                break;
+            default:
+                break;
+        }
+
+        // Relative to the end of the hole, which is the end of its instruction
+        int32_t displacement = (int32_t)((int64_t)target - (int64_t)(fixup->at + 4));
+        memcpy(jit->code + fixup->at, &displacement, sizeof(displacement));
+    }
+
+    return true;
+}
+
+// Move the code to a mapping that is made executable once it's written, returns false if the host forbids it
+bool jitMap(Jit *jit) {
+#ifndef JIT_AVAILABLE
+    return false;
+#else
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t size = (jit->size + page - 1) / page * page;
+
+    void *code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        return false;
+    }
+
+    memcpy(code, jit->code, jit->size);
+    if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, size);
+        return false;
+    }
+
+    free(jit->code);
+    jit->code       = (uint8_t *)code;
+    jit->mappedSize = size;
+    return true;
+#endif
+}
+
+//
+// Helpers the code calls
+//
+
+// Refill the fuel of a run, returns false once it's past its deadline, with the error at the instruction `pc`
+bool jitTick(jitContext *context, vmFrame *frame, uint32_t pc) {
+    if (context->deadline && pbNow() > context->deadline) {
+        jitFail(context, frame, pc, "tempo de execução esgotado");
+        return false;
+    }
+
+    context->fuel = JIT_FUEL;
+    return true;
+}
+
+// Report a runtime error of the instruction `pc` of the running frame, the code unwinds right after
+void jitFail(jitContext *context, vmFrame *frame, uint32_t pc, char *msg) {
+    vmError(context->vm, frame, frame->function->code + pc + 1, msg);
+}
+
+// Compare two strings like strcmp, NULL stands for the empty string
+int jitCompareStrings(char *left, char *right) {
+    return strcmp(left ? left : "", right ? right : "");
+}
+
+// String of a char, owned by the machine
+char *jitCharString(VM *vm, int64_t ch) {
+    char s[2] = {(char)ch, '\0'};
+    return vmString(vm, s, NULL);
+}
\ No newline at end of file
@@ -0,0 +1,494 @@
+#include "json.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+
+//
+// Parsing
+//
+
+// Parse a JSON document, NULL if it's malformed
+jsValue *jsParse(char *input, uint64_t length) {
+    jsParser p = {input, length, 0, 0};
+
+    jsValue *v = jsParseValue(&p);
+    if (!v) {
+        return NULL;
+    }
+
+    jsSkipWhitespace(&p);
+    if (p.position != p.length) {
+        jsFree(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+// Free a value and everything in it
+void jsFree(jsValue *v) {
+    if (v) {
+        for (uint32_t i = 0; i < v->size; i++) {
+            if (v->keys) {
+                free(v->keys[i]);
+            }
+            jsFree(v->items[i]);
+        }
+
+        free(v->keys);
+        free(v->items);
+        free(v->string);
+        free(v);
+    }
+}
+
+// Create an empty value of a given type
+jsValue *jsNew(jsType type) {
+    jsValue *v = (jsValue *)calloc(1, sizeof(jsValue));
+    if (v) {
+        v->type = type;
+    }
+
+    return v;
+}
+
+// Append an item to an array, or a key and value to an object
+bool jsAdd(jsValue *v, char *key, jsValue *item) {
+    if (v->size == v->capacity) {
+        v->capacity = v->capacity ? v->capacity * 2 : 4;
+        v->items    = (jsValue **)realloc(v->items, v->capacity * sizeof(jsValue *));
+
+        if (v->type == JS_OBJECT) {
+            v->keys = (char **)realloc(v->keys, v->capacity * sizeof(char *));
+        }
+    }
+
+    if (v->type == JS_OBJECT) {
+        v->keys[v->size] = key;
+    }
+    v->items[v->size++] = item;
+
+    return true;
+}
+
+// Skip the whitespace between tokens
+void jsSkipWhitespace(jsParser *p) {
+    while (p->position < p->length) {
+        char ch = p->input[p->position];
+        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r') {
+            break;
+        }
+        p->position++;
+    }
+}
+
+// Parse any value
+jsValue *jsParseValue(jsParser *p) {
+    jsSkipWhitespace(p);
+
+    if (p->position >= p->length) {
+        return NULL;
+    }
+
+    jsValue *v = NULL;
+
+    switch (p->input[p->position]) {
+        case '{':
+            return jsParseObject(p);
+        case '[':
+            return jsParseArray(p);
+        case '"': {
+            char *str = jsParseString(p);
+            if (!str) {
+                return NULL;
+            }
+
+            v         = jsNew(JS_STRING);
+            v->string = str;
+            return v;
+        }
+        case 't':
+            if (!jsParseLiteral(p, "true")) {
+                return NULL;
+            }
+
+            v          = jsNew(JS_BOOLEAN);
+            v->boolean = true;
+            return v;
+        case 'f':
+            if (!jsParseLiteral(p, "false")) {
+                return NULL;
+            }
+
+            return jsNew(JS_BOOLEAN);
+        case 'n':
+            if (!jsParseLiteral(p, "null")) {
+                return NULL;
+            }
+
+            return jsNew(JS_NULL);
+        default: {
+            // strtod stops at the end of the number, the input isn't null-terminated so it's copied first
+            char     number[64];
+            uint64_t length = 0;
+            while (p->position + length < p->length && length < sizeof(number) - 1 &&
+                   strchr("+-0123456789.eE", p->input[p->position + length])) {
+                number[length] = p->input[p->position + length];
+                length++;
+            }
+            number[length] = '\0';
+
+            char  *end   = NULL;
+            double value = strtod(number, &end);
+            if (length == 0 || end != number + length) {
+                return NULL;
+            }
+
+            p->position += length;
+
+            v         = jsNew(JS_NUMBER);
+            v->number = value;
+            return v;
+        }
+    }
+}
+
+// Parse an array, the current character is the `[`
+jsValue *jsParseArray(jsParser *p) {
+    if (++p->depth > JS_MAX_DEPTH) {
+        return NULL;
+    }
+
+    jsValue *v = jsNew(JS_ARRAY);
+    p->position++;
+
+    jsSkipWhitespace(p);
+    if (p->position < p->length && p->input[p->position] == ']') {
+        p->position++;
+        p->depth--;
+        return v;
+    }
+
+    while (true) {
+        jsValue *item = jsParseValue(p);
+        if (!item) {
+            jsFree(v);
+            return NULL;
+        }
+
+        jsAdd(v, NULL, item);
+
+        jsSkipWhitespace(p);
+        if (p->position >= p->length) {
+            jsFree(v);
+            return NULL;
+        }
+
+        char ch = p->input[p->position++];
+        if (ch == ']') {
+            break;
+        }
+        if (ch != ',') {
+            jsFree(v);
+            return NULL;
+        }
+    }
+
+    p->depth--;
+    return v;
+}
+
+// Parse an object, the current character is the `{`
+jsValue *jsParseObject(jsParser *p) {
+    if (++p->depth > JS_MAX_DEPTH) {
+        return NULL;
+    }
+
+    jsValue *v = jsNew(JS_OBJECT);
+    p->position++;
+
+    jsSkipWhitespace(p);
+    if (p->position < p->length && p->input[p->position] == '}') {
+        p->position++;
+        p->depth--;
+        return v;
+    }
+
+    while (true) {
+        jsSkipWhitespace(p);
+        if (p->position >= p->length || p->input[p->position] != '"') {
+            jsFree(v);
+            return NULL;
+        }
+
+        char *key = jsParseString(p);
+        if (!key) {
+            jsFree(v);
+            return NULL;
+        }
+
+        jsSkipWhitespace(p);
+        if (p->position >= p->length || p->input[p->position] != ':') {
+            free(key);
+            jsFree(v);
+            return NULL;
+        }
+        p->position++;
+
+        jsValue *item = jsParseValue(p);
+        if (!item) {
+            free(key);
+            jsFree(v);
+            return NULL;
+        }
+
+        jsAdd(v, key, item);
+
+        jsSkipWhitespace(p);
+        if (p->position >= p->length) {
+            jsFree(v);
+            return NULL;
+        }
+
+        char ch = p->input[p->position++];
+        if (ch == '}') {
+            break;
+        }
+        if (ch != ',') {
+            jsFree(v);
+            return NULL;
+        }
+    }
+
+    p->depth--;
+    return v;
+}
+
+// Parse a string, the current character is the opening quote, escapes are decoded to UTF-8
+char *jsParseString(jsParser *p) {
+    p->position++;
+
+    // The decoded string is never longer than the encoded one
+    uint64_t end = p->position;
+    while (end < p->length && p->input[end] != '"') {
+        end += p->input[end] == '\\' ? 2 : 1;
+    }
+    if (end >= p->length) {
+        return NULL;
+    }
+
+    char    *str    = (char *)malloc(end - p->position + 1);
+    uint64_t length = 0;
+
+    while (p->position < end) {
+        char ch = p->input[p->position++];
+        if (ch != '\\') {
+            str[length++] = ch;
+            continue;
+        }
+
+        ch = p->input[p->position++];
+        switch (ch) {
+            case 'b':
+                str[length++] = '\b';
+                break;
+            case 'f':
+                str[length++] = '\f';
+                break;
+            case 'n':
+                str[length++] = '\n';
+                break;
+            case 'r':
+                str[length++] = '\r';
+                break;
+            case 't':
+                str[length++] = '\t';
+                break;
+            case 'u': {
+                uint32_t code = 0;
+                char     hex[5];
+                for (uint32_t pass = 0; pass < 2; pass++) {
+                    if (p->position + 4 > end) {
+                        free(str);
+                        return NULL;
+                    }
+
+                    memcpy(hex, p->input + p->position, 4);
+                    hex[4] = '\0';
+
+                    char    *rest  = NULL;
+                    uint32_t value = (uint32_t)strtoul(hex, &rest, 16);
+                    if (rest != hex + 4) {
+                        free(str);
+                        return NULL;
+                    }
+                    p->position += 4;
+
+                    // A high surrogate is followed by `\u` and the low one, together they make one code point
+                    if (pass == 0 && value >= 0xD800 && value < 0xDC00 && p->position + 2 <= end &&
+                        p->input[p->position] == '\\' && p->input[p->position + 1] == 'u') {
+                        code = value;
+                        p->position += 2;
+                        continue;
+                    }
+
+                    code = pass == 0 ? value : 0x10000 + ((code - 0xD800) << 10) + (value - 0xDC00);
+                    break;
+                }
+
+                if (code < 0x80) {
+                    str[length++] = (char)code;
+                } else if (code < 0x800) {
+                    str[length++] = (char)(0xC0 | (code >> 6));
+                    str[length++] = (char)(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    str[length++] = (char)(0xE0 | (code >> 12));
+                    str[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    str[length++] = (char)(0x80 | (code & 0x3F));
+                } else {
+                    str[length++] = (char)(0xF0 | (code >> 18));
+                    str[length++] = (char)(0x80 | ((code >> 12) & 0x3F));
+                    str[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    str[length++] = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:  // `"`, `\` and `/` stand for themselves
+                str[length++] = ch;
+                break;
+        }
+    }
+
+    str[length] = '\0';
+    p->position = end + 1;
+
+    return str;
+}
+
+// Parse `true`, `false` or `null`
+bool jsParseLiteral(jsParser *p, char *literal) {
+    uint64_t length = strlen(literal);
+    if (p->position + length > p->length || memcmp(p->input + p->position, literal, length) != 0) {
+        return false;
+    }
+
+    p->position += length;
+    return true;
+}
+
+//
+// Access
+//
+
+// Value of a key of an object, NULL if the key is missing or `object` isn't an object
+jsValue *jsGet(jsValue *object, char *key) {
+    if (!object || object->type != JS_OBJECT) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < object->size; i++) {
+        if (strcmp(object->keys[i], key) == 0) {
+            return object->items[i];
+        }
+    }
+
+    return NULL;
+}
+
+// String of a string value, NULL for any other value
+char *jsString(jsValue *v) {
+    return v && v->type == JS_STRING ? v->string : NULL;
+}
+
+// Integer of a number value, `fallback` for any other value
+int64_t jsInteger(jsValue *v, int64_t fallback) {
+    return v && v->type == JS_NUMBER ? (int64_t)v->number : fallback;
+}
+
+//
+// Writing
+//
+
+// Append a string as a quoted JSON string
+void jsAppendString(astString *buffer, char *str) {
+    // Characters are gathered in a chunk and appended a chunk at a time
+    char     chunk[256];
+    uint32_t length = 0;
+
+    chunk[length++] = '"';
+
+    for (char *ch = str;; ch++) {
+        if (length > sizeof(chunk) - 8 || !*ch) {
+            chunk[length] = '\0';
+            astAppendToString(buffer, chunk);
+            length = 0;
+        }
+
+        if (!*ch) {
+            break;
+        }
+
+        switch (*ch) {
+            case '"':
+                chunk[length++] = '\\';
+                chunk[length++] = '"';
+                break;
+            case '\\':
+                chunk[length++] = '\\';
+                chunk[length++] = '\\';
+                break;
+            case '\n':
+                chunk[length++] = '\\';
+                chunk[length++] = 'n';
+                break;
+            case '\t':
+                chunk[length++] = '\\';
+                chunk[length++] = 't';
+                break;
+            case '\r':
+                chunk[length++] = '\\';
+                chunk[length++] = 'r';
+                break;
+            default: {
+                unsigned char byte = (unsigned char)*ch;
+
+                // JSON text is UTF-8, a byte that doesn't start a whole sequence becomes the replacement character
+                uint32_t sequence = 0;
+                if (byte < 0x80) {
+                    sequence = 1;
+                } else if (byte >= 0xC2 && byte < 0xE0) {
+                    sequence = 2;
+                } else if (byte >= 0xE0 && byte < 0xF0) {
+                    sequence = 3;
+                } else if (byte >= 0xF0 && byte < 0xF5) {
+                    sequence = 4;
+                }
+
+                for (uint32_t i = 1; i < sequence; i++) {
+                    if (((unsigned char)ch[i] & 0xC0) != 0x80) {
+                        sequence = 0;
+                        break;
+                    }
+                }
+
+                if (byte < 0x20) {
+                    length += sprintf(chunk + length, "\\u%04x", byte);
+                } else if (sequence == 0) {
+                    length += sprintf(chunk + length, "\\ufffd");
+                } else {
+                    memcpy(chunk + length, ch, sequence);
+                    length += sequence;
+                    ch += sequence - 1;
+                }
+                break;
+            }
+        }
+    }
+
+    astAppendToString(buffer, "\"");
+}
\ No newline at end of file
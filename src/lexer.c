@@ -1,10 +1,12 @@
 #include "lexer.h"
 
 #include <ctype.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "budget.h"
 #include "error.h"
 #include "hash.h"
 #include "token.h"
@@ -15,17 +17,30 @@
 
 // Create a new lexer
 Lexer *lNew(char *input) {
+    HashMap *keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(keywords);
+
+    Lexer *l        = lNewWithKeywords(input, keywords);
+    l->ownsKeywords = true;
+
+    return l;
+}
+
+// Create a new lexer sharing a keyword hashmap, which is only read so it can be shared between threads
+Lexer *lNewWithKeywords(char *input, HashMap *keywords) {
     Lexer *l        = malloc(sizeof(Lexer));
     l->input        = input;
+    l->length       = strlen(input);
     l->position     = 0;
     l->readPosition = 0;
     l->varCounter   = 0;
     l->litCounter   = 0;
     l->line         = 1;
+    l->lineStart    = 0;
     l->errors       = eNew();
-
-    l->keywords = hmNew(hStrHash, hStrCmp, 64);
-    tInitKeywords(l->keywords);
+    l->budget       = NULL;
+    l->keywords     = keywords;
+    l->ownsKeywords = false;
 
     lReadChar(l);
 
@@ -35,111 +50,161 @@ Lexer *lNew(char *input) {
 // Free the lexer
 void lFree(Lexer *l) {
     free(l->input);
-    hmFree(l->keywords);
+    if (l->ownsKeywords) {
+        hmFree(l->keywords);
+    }
     eFree(l->errors);
     free(l);
 }
 
 // Get the next token
 Token *lNextToken(Lexer *l) {
-    Token *tok;
+    TokenSpan span;
+    lScanToken(l, &span);
+
+    // A token the tree can't afford ends the input, before its literal is copied
+    if (l->budget && !pbAllocate(l->budget, sizeof(Token) + span.length + 1)) {
+        span.type   = _EOF;
+        span.length = 0;
+    }
+
+    return lSpanToken(l, &span);
+}
+
+// Create a token from a scanned token, copying its literal out of the input
+Token *lSpanToken(Lexer *l, TokenSpan *t) {
+    Token *tok   = malloc(sizeof(Token));
+    tok->type    = t->type;
+    tok->literal = strndup(l->input + t->start, t->length);
+    tok->line    = t->line;
+    tok->column  = t->column;
+
+    // Identifiers and keywords are case insensitive, literals keep their case
+    if (t->type != STR && t->type != CHAR && t->type != ILLEGAL) {
+        for (uint64_t i = 0; i < t->length; i++) {
+            tok->literal[i] = tolower(tok->literal[i]);
+        }
+    }
+
+    return tok;
+}
 
+// Scan the next token without allocating, the literal is left in the input
+void lScanToken(Lexer *l, TokenSpan *t) {
     lSkipWhitespace(l);
 
-    char literal[2] = {l->ch, '\0'};
+    t->start  = l->position;
+    t->length = 1;
+    t->line   = l->line;  // Tokens never span lines, strings don't count their newlines
+    t->column = l->position - l->lineStart;
+
+    // Out of budget, the input ends here
+    if (l->budget && l->ch != 0 && !pbTick(l->budget)) {
+        t->type   = _EOF;
+        t->length = 0;
+        return;
+    }
 
     switch (l->ch) {
         case '+':
-            tok = tNewToken(PLUS, literal);
+            t->type = PLUS;
             break;
         case '-':
-            tok = tNewToken(MINUS, literal);
+            t->type = MINUS;
             break;
         case '*':
-            tok = tNewToken(ASTERISK, literal);
+            t->type = ASTERISK;
             break;
         case '/':
-            tok = tNewToken(SLASH, literal);
+            t->type = SLASH;
             break;
         case '=':
-            tok = tNewToken(EQ, literal);
+            t->type = EQ;
             break;
         case '<':
-            tok = lCompoundableToken(l, ">=", LT, (TokenType[]){NOT_EQ, LTE});
+            lCompoundableToken(l, ">=", LT, (TokenType[]){NOT_EQ, LTE}, t);
             break;
         case '>':
-            tok = lCompoundableToken(l, "=", GT, (TokenType[]){GTE});
+            lCompoundableToken(l, "=", GT, (TokenType[]){GTE}, t);
             break;
         case ',':
-            tok = tNewToken(COMMA, literal);
+            t->type = COMMA;
             break;
         case '.':
-            tok = tNewToken(DOT, literal);
+            t->type = DOT;
             break;
         case ';':
-            tok = tNewToken(SEMICOLON, literal);
+            t->type = SEMICOLON;
             break;
         case ':':
-            tok = lCompoundableToken(l, "=", COLON, (TokenType[]){ASSIGN});
+            lCompoundableToken(l, "=", COLON, (TokenType[]){ASSIGN}, t);
             break;
         case '(':
-            tok = tNewToken(LPAREN, literal);
+            t->type = LPAREN;
             break;
         case ')':
-            tok = tNewToken(RPAREN, literal);
+            t->type = RPAREN;
             break;
         case '{':
-            tok = tNewToken(LBRACE, literal);
+            t->type = LBRACE;
             break;
         case '}':
-            tok = tNewToken(RBRACE, literal);
+            t->type = RBRACE;
             break;
         case '[':
-            tok = tNewToken(LBRACKET, literal);
+            t->type = LBRACKET;
             break;
         case ']':
-            tok = tNewToken(RBRACKET, literal);
+            t->type = RBRACKET;
             break;
         case '"':
-            tok       = malloc(sizeof(Token));
-            tok->type = lReadString(l, &tok->literal);
+            lReadString(l, t);
             break;
         case '\'':
-            tok       = malloc(sizeof(Token));
-            tok->type = lReadCharLiteral(l, &tok->literal);
+            lReadCharLiteral(l, t);
             break;
         case 0:
-            tok = tNewToken(_EOF, "");
+            t->type   = _EOF;
+            t->length = 0;
             break;
         default:
             if (isalpha(l->ch)) {
-                tok          = malloc(sizeof(Token));
-                tok->literal = lReadIdentifier(l);
-                tok->type    = tLookupIdent(l->keywords, tok->literal);
-                if (tok->type == IDENT) {
+                lReadIdentifier(l, t);
+                if (t->type == IDENT) {
                     l->varCounter++;
                 }
-                return tok;
+                return;
             } else if (isdigit(l->ch) || (l->ch == '.' && isdigit(lPeekChar(l)))) {
-                tok       = malloc(sizeof(Token));
-                tok->type = lReadNumber(l, &tok->literal);
-                return tok;
+                lReadNumber(l, t);
+                return;
             } else {
-                tok = tNewToken(ILLEGAL, literal);
-                char error[64];
-                sprintf(error, "Caractere inválido: '%c', linha: %d", l->ch, l->line);
+                t->type = ILLEGAL;
+                char error[96];
+                sprintf(error, "Caractere inválido: '%c', linha: %" PRIu64, l->ch, l->line);
                 eAdd(l->errors, error);
             }
             break;
     }
 
     lReadChar(l);
-    return tok;
+}
+
+// Copy the literal of a scanned token into a buffer, truncating it if needed
+void lSpanLiteral(Lexer *l, TokenSpan *t, char *buffer, uint32_t size) {
+    uint32_t length = t->length < size - 1 ? (uint32_t)t->length : size - 1;
+    memcpy(buffer, l->input + t->start, length);
+    buffer[length] = '\0';
+
+    if (t->type != STR && t->type != CHAR && t->type != ILLEGAL) {
+        for (uint32_t i = 0; i < length; i++) {
+            buffer[i] = tolower(buffer[i]);
+        }
+    }
 }
 
 // Read the next character and update both positions
 void lReadChar(Lexer *l) {
-    if (l->readPosition >= strlen(l->input)) {
+    if (l->readPosition >= l->length) {
         l->ch = 0;
     } else {
         l->ch = l->input[l->readPosition];
@@ -154,6 +219,7 @@ void lSkipWhitespace(Lexer *l) {
     while (l->ch == ' ' || l->ch == '\t' || l->ch == '\n' || l->ch == '\r') {
         if (l->ch == '\n') {
             l->line++;
+            l->lineStart = l->readPosition;
         }
         lReadChar(l);
     }
@@ -161,43 +227,51 @@ void lSkipWhitespace(Lexer *l) {
 
 // Peek the next character
 char lPeekChar(Lexer *l) {
-    if (l->readPosition >= strlen(l->input)) {
+    if (l->readPosition >= l->length) {
         return 0;
     } else {
         return l->input[l->readPosition];
     }
 }
 
-// Create a new token for compoundable tokens e.g :=, <=, >=, <>
-Token *lCompoundableToken(Lexer *l, char *nextCh, TokenType singleToken, TokenType *compoundToken) {
-    char ch = l->ch;
-
+// Scan compoundable tokens e.g :=, <=, >=, <>
+void lCompoundableToken(Lexer *l, char *nextCh, TokenType singleToken, TokenType *compoundToken, TokenSpan *t) {
     for (uint8_t i = 0; i < strlen(nextCh); i++) {
         if (lPeekChar(l) == nextCh[i]) {
             lReadChar(l);
-            char compoundLiteral[3] = {ch, nextCh[i], '\0'};
-            return tNewToken(compoundToken[i], compoundLiteral);
+            t->type   = compoundToken[i];
+            t->length = 2;
+            return;
         }
     }
 
-    char singleLiteral[2] = {ch, '\0'};
-    return tNewToken(singleToken, singleLiteral);
+    t->type = singleToken;
 }
 
-// Read an identifier
-char *lReadIdentifier(Lexer *l) {
-    uint32_t position = l->position;
+// Read an identifier or keyword
+void lReadIdentifier(Lexer *l, TokenSpan *t) {
+    uint64_t position = l->position;
 
     while (isalnum(l->ch)) {
         lReadChar(l);
     }
 
-    char *ident = strndup(l->input + position, l->position - position);
-    for (uint32_t i = 0; i < strlen(ident); i++) {
-        ident[i] = tolower(ident[i]);
+    t->start  = position;
+    t->length = l->position - position;
+
+    // No keyword is longer than the buffer, longer words are always identifiers
+    char word[16];
+    if (t->length >= sizeof(word)) {
+        t->type = IDENT;
+        return;
+    }
+
+    for (uint64_t i = 0; i < t->length; i++) {
+        word[i] = tolower(l->input[position + i]);
     }
+    word[t->length] = '\0';
 
-    return ident;
+    t->type = tLookupIdent(l->keywords, word);
 }
 
 // Check if a character is a possible terminator
@@ -207,8 +281,8 @@ bool lIsPossibleTerminator(char ch) {
 }
 
 // Read a number literal, integers and floats, checks for malformed numbers
-TokenType lReadNumber(Lexer *l, char **literal) {
-    uint32_t position = l->position;
+void lReadNumber(Lexer *l, TokenSpan *t) {
+    uint64_t position = l->position;
     bool     isFloat  = false;
     uint8_t  dotCount = 0;
     bool     illegal  = false;
@@ -229,27 +303,33 @@ TokenType lReadNumber(Lexer *l, char **literal) {
         lReadChar(l);
     }
 
-    *literal = strndup(l->input + position, l->position - position);
+    t->start  = position;
+    t->length = l->position - position;
 
     if (illegal) {
-        char error[64];
-        sprintf(error, "Número inválido: '%s', linha: %d", *literal, l->line);
+        char literal[32];
+        lSpanLiteral(l, t, literal, sizeof(literal));
+
+        char error[96];
+        sprintf(error, "Número inválido: '%s', linha: %" PRIu64, literal, l->line);
         eAdd(l->errors, error);
-        return ILLEGAL;
+
+        t->type = ILLEGAL;
+        return;
     }
 
     l->litCounter++;
 
     if (isFloat) {
-        return FLOAT;
+        t->type = FLOAT;
     } else {
-        return INT;
+        t->type = INT;
     }
 }
 
 // Read a string literal enclosed by double quotes " "
-TokenType lReadString(Lexer *l, char **literal) {
-    uint32_t position = l->position + 1;
+void lReadString(Lexer *l, TokenSpan *t) {
+    uint64_t position = l->position + 1;
 
     while (true) {
         lReadChar(l);
@@ -259,51 +339,57 @@ TokenType lReadString(Lexer *l, char **literal) {
     }
 
     if (l->ch == 0) {
-        char error[64];
-        sprintf(error, "Fim de arquivo inesperado, linha: %d", l->line);
+        char error[96];
+        sprintf(error, "Fim de arquivo inesperado, linha: %" PRIu64, l->line);
         eAdd(l->errors, error);
 
-        *literal = strndup(l->input + position - 1, l->position - position + 1);
+        t->type   = ILLEGAL;
+        t->start  = position - 1;
+        t->length = l->position - position + 1;
 
-        return ILLEGAL;
+        return;
     }
 
-    *literal = strndup(l->input + position, l->position - position);
+    t->type   = STR;
+    t->start  = position;
+    t->length = l->position - position;
     l->litCounter++;
-
-    return STR;
 }
 
 // Read a character literal enclosed by single quotes ' '
-TokenType lReadCharLiteral(Lexer *l, char **literal) {
-    uint32_t position = l->position + 1;
+void lReadCharLiteral(Lexer *l, TokenSpan *t) {
+    uint64_t position = l->position + 1;
 
     lReadChar(l);
 
     if (l->ch == 0) {
-        char error[64];
-        sprintf(error, "Fim de arquivo inesperado, linha: %d", l->line);
+        char error[96];
+        sprintf(error, "Fim de arquivo inesperado, linha: %" PRIu64, l->line);
         eAdd(l->errors, error);
 
-        *literal = strndup(l->input + position - 1, l->position - position + 1);
+        t->type   = ILLEGAL;
+        t->start  = position - 1;
+        t->length = l->position - position + 1;
 
-        return ILLEGAL;
+        return;
     }
 
     lReadChar(l);
 
     if (l->ch != '\'') {
-        char error[64];
-        sprintf(error, "Caractere inválido: '%c', linha: %d", l->ch, l->line);
+        char error[96];
+        sprintf(error, "Caractere inválido: '%c', linha: %" PRIu64, l->ch, l->line);
         eAdd(l->errors, error);
 
-        *literal = strndup(l->input + position - 1, l->position - position + 1);
+        t->type   = ILLEGAL;
+        t->start  = position - 1;
+        t->length = l->position - position + 1;
 
-        return ILLEGAL;
+        return;
     }
 
-    *literal = strndup(l->input + position, l->position - position);
+    t->type   = CHAR;
+    t->start  = position;
+    t->length = l->position - position;
     l->litCounter++;
-
-    return CHAR;
 }
\ No newline at end of file
@@ -0,0 +1,975 @@
+#include "lsp.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ast.h"
+#include "checker.h"
+#include "error.h"
+#include "events.h"
+#include "hash.h"
+#include "hashmap.h"
+#include "json.h"
+#include "lexer.h"
+#include "parser.h"
+#include "token.h"
+
+//
+// Server
+//
+
+// Create a language server reading messages from `in` and writing them to `out`
+LanguageServer *lspNew(FILE *in, FILE *out) {
+    LanguageServer *s = (LanguageServer *)calloc(1, sizeof(LanguageServer));
+    if (!s) {
+        return NULL;
+    }
+
+    s->in  = in;
+    s->out = out;
+
+    s->keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(s->keywords);
+
+    s->tables = pNewTables();
+
+    return s;
+}
+
+// Free the server and every open document
+void lspFree(LanguageServer *s) {
+    for (uint32_t i = 0; i < s->size; i++) {
+        lspDocumentFree(s->documents[i]);
+    }
+
+    free(s->documents);
+    hmFree(s->keywords);
+    pFree(s->tables);
+    free(s);
+}
+
+// Serve messages until `exit` or the end of the input, returns the exit code the protocol asks for
+int lspRun(LanguageServer *s) {
+    while (true) {
+        uint64_t length = 0;
+        char    *body   = lspReadMessage(s, &length);
+        if (!body) {
+            break;
+        }
+
+        jsValue *message = jsParse(body, length);
+        free(body);
+
+        if (!message) {
+            lspRespondError(s, NULL, -32700, "Mensagem invalida");
+            continue;
+        }
+
+        bool running = lspHandle(s, message);
+        jsFree(message);
+
+        if (!running) {
+            break;
+        }
+    }
+
+    return s->shutdown ? 0 : 1;
+}
+
+// Read the next message body, NULL at the end of the input or on a broken header
+char *lspReadMessage(LanguageServer *s, uint64_t *length) {
+    char     header[256];
+    uint64_t size    = 0;
+    bool     headers = false;
+
+    // Headers end with an empty line, Content-Length is the only one used
+    while (true) {
+        if (!fgets(header, sizeof(header), s->in)) {
+            return NULL;
+        }
+
+        if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+            if (headers) {
+                break;
+            }
+            continue;
+        }
+
+        headers = true;
+        if (strncasecmp(header, "Content-Length:", 15) == 0) {
+            size = strtoull(header + 15, NULL, 10);
+        }
+    }
+
+    if (size == 0 || size > LSP_MAX_MESSAGE) {
+        return NULL;
+    }
+
+    char *body = (char *)malloc(size + 1);
+    if (!body || fread(body, 1, size, s->in) != size) {
+        free(body);
+        return NULL;
+    }
+
+    body[size] = '\0';
+    *length    = size;
+
+    return body;
+}
+
+// Write a message with its header
+void lspSend(LanguageServer *s, astString *body) {
+    fprintf(s->out, "Content-Length: %zu\r\n\r\n", body->length);
+    fwrite(body->data, 1, body->length, s->out);
+    fflush(s->out);
+}
+
+// Answer a request, `result` is JSON text
+void lspRespond(LanguageServer *s, jsValue *id, char *result) {
+    astString buffer = {NULL, 0, 0};
+
+    astAppendToString(&buffer, "{\"jsonrpc\":\"2.0\",\"id\":");
+    lspAppendId(&buffer, id);
+    astAppendToString(&buffer, ",\"result\":");
+    astAppendToString(&buffer, result);
+    astAppendToString(&buffer, "}");
+
+    lspSend(s, &buffer);
+    free(buffer.data);
+}
+
+// Answer a request with an error
+void lspRespondError(LanguageServer *s, jsValue *id, int32_t code, char *message) {
+    astString buffer = {NULL, 0, 0};
+    char      number[32];
+
+    astAppendToString(&buffer, "{\"jsonrpc\":\"2.0\",\"id\":");
+    lspAppendId(&buffer, id);
+    snprintf(number, sizeof(number), "%" PRId32, code);
+    astAppendToString(&buffer, ",\"error\":{\"code\":");
+    astAppendToString(&buffer, number);
+    astAppendToString(&buffer, ",\"message\":");
+    jsAppendString(&buffer, message);
+    astAppendToString(&buffer, "}}");
+
+    lspSend(s, &buffer);
+    free(buffer.data);
+}
+
+// Append a request id as it was sent, a number or a string
+void lspAppendId(astString *buffer, jsValue *id) {
+    if (id && id->type == JS_STRING) {
+        jsAppendString(buffer, id->string);
+    } else if (id && id->type == JS_NUMBER) {
+        char number[32];
+        snprintf(number, sizeof(number), "%" PRId64, (int64_t)id->number);
+        astAppendToString(buffer, number);
+    } else {
+        astAppendToString(buffer, "null");
+    }
+}
+
+// Dispatch a message, returns false once the client asks the server to exit
+bool lspHandle(LanguageServer *s, jsValue *message) {
+    char    *method = jsString(jsGet(message, "method"));
+    jsValue *id     = jsGet(message, "id");
+    jsValue *params = jsGet(message, "params");
+
+    // A response, the server sends no requests so there's nothing waiting for it
+    if (!method) {
+        return true;
+    }
+
+    if (strcmp(method, "exit") == 0) {
+        return false;
+    }
+
+    if (!s->initialized && strcmp(method, "initialize") != 0) {
+        if (id) {
+            lspRespondError(s, id, -32002, "Servidor nao inicializado");
+        }
+        return true;
+    }
+
+    if (strcmp(method, "initialize") == 0) {
+        lspInitialize(s, id);
+    } else if (strcmp(method, "shutdown") == 0) {
+        s->shutdown = true;
+        lspRespond(s, id, "null");
+    } else if (strcmp(method, "textDocument/didOpen") == 0) {
+        lspDidOpen(s, params);
+    } else if (strcmp(method, "textDocument/didChange") == 0) {
+        lspDidChange(s, params);
+    } else if (strcmp(method, "textDocument/didClose") == 0) {
+        lspDidClose(s, params);
+    } else if (strcmp(method, "textDocument/documentSymbol") == 0) {
+        lspDocumentSymbols(s, id, params);
+    } else if (strcmp(method, "textDocument/definition") == 0) {
+        lspDefinition(s, id, params);
+    } else if (id) {
+        lspRespondError(s, id, -32601, "Metodo desconhecido");
+    }
+
+    return true;
+}
+
+//
+// Requests and notifications
+//
+
+// Answer `initialize` with what the server supports, changes are sent as edits
+void lspInitialize(LanguageServer *s, jsValue *id) {
+    s->initialized = true;
+
+    lspRespond(s, id,
+               "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+               "\"documentSymbolProvider\":true,\"definitionProvider\":true},"
+               "\"serverInfo\":{\"name\":\"PascalSyntaxAnalyzer\",\"version\":\"0.1.0\"}}");
+}
+
+// Start tracking a document, replacing one already open with the same URI
+void lspDidOpen(LanguageServer *s, jsValue *params) {
+    jsValue *document = jsGet(params, "textDocument");
+    char    *uri      = jsString(jsGet(document, "uri"));
+    char    *text     = jsString(jsGet(document, "text"));
+    if (!uri || !text) {
+        return;
+    }
+
+    lspDocument *d = lspDocumentNew(uri, text, jsInteger(jsGet(document, "version"), 0));
+
+    lspDocument *open = lspFindDocument(s, params);
+    if (open) {
+        for (uint32_t i = 0; i < s->size; i++) {
+            if (s->documents[i] == open) {
+                s->documents[i] = d;
+            }
+        }
+        lspDocumentFree(open);
+    } else {
+        if (s->size == s->capacity) {
+            s->capacity  = s->capacity ? s->capacity * 2 : 4;
+            s->documents = (lspDocument **)realloc(s->documents, s->capacity * sizeof(lspDocument *));
+        }
+        s->documents[s->size++] = d;
+    }
+
+    lspCheck(s, d);
+    lspPublish(s, d);
+}
+
+// Apply the edits of a change in order, then check the document again
+void lspDidChange(LanguageServer *s, jsValue *params) {
+    lspDocument *d       = lspFindDocument(s, params);
+    jsValue     *changes = jsGet(params, "contentChanges");
+    if (!d || !changes || changes->type != JS_ARRAY) {
+        return;
+    }
+
+    d->version = jsInteger(jsGet(jsGet(params, "textDocument"), "version"), d->version);
+
+    for (uint32_t i = 0; i < changes->size; i++) {
+        lspApplyChange(d, changes->items[i]);
+    }
+
+    lspCheck(s, d);
+    lspPublish(s, d);
+}
+
+// Stop tracking a document and clear its diagnostics
+void lspDidClose(LanguageServer *s, jsValue *params) {
+    lspDocument *d = lspFindDocument(s, params);
+    if (!d) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < s->size; i++) {
+        if (s->documents[i] == d) {
+            s->documents[i] = s->documents[--s->size];
+            break;
+        }
+    }
+
+    astString buffer = {NULL, 0, 0};
+    astAppendToString(&buffer, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    jsAppendString(&buffer, d->uri);
+    astAppendToString(&buffer, ",\"diagnostics\":[]}}");
+
+    lspSend(s, &buffer);
+    free(buffer.data);
+
+    lspDocumentFree(d);
+}
+
+// Answer `documentSymbol` with the program, its variables and its functions, nested as in the source
+void lspDocumentSymbols(LanguageServer *s, jsValue *id, jsValue *params) {
+    lspDocument *d       = lspFindDocument(s, params);
+    astProgram  *program = d ? lspParse(s, d) : NULL;
+    if (!program) {
+        lspRespond(s, id, "[]");
+        return;
+    }
+
+    astString buffer = {NULL, 0, 0};
+
+    astAppendToString(&buffer, "[");
+    lspAppendSymbol(&buffer, d, program->identifier->token, 2, "program");
+    lspAppendBlockSymbols(&buffer, d, program->block);
+    astAppendToString(&buffer, "]}]");
+
+    lspRespond(s, id, buffer.data);
+    free(buffer.data);
+}
+
+// Answer `definition` with the declaration the identifier under the cursor refers to
+void lspDefinition(LanguageServer *s, jsValue *id, jsValue *params) {
+    lspDocument *d = lspFindDocument(s, params);
+    if (!d) {
+        lspRespond(s, id, "null");
+        return;
+    }
+
+    uint64_t offset = lspOffset(d, jsGet(params, "position"));
+    uint64_t start  = offset;
+    uint64_t end    = offset;
+
+    while (start > 0 && (isalnum((unsigned char)d->text[start - 1]) || d->text[start - 1] == '_')) {
+        start--;
+    }
+    while (end < d->length && (isalnum((unsigned char)d->text[end]) || d->text[end] == '_')) {
+        end++;
+    }
+
+    astProgram *program = lspParse(s, d);
+    if (start == end || !program) {
+        lspRespond(s, id, "null");
+        return;
+    }
+
+    // Identifiers are case insensitive, the tree keeps them in lower case
+    char *name = strndup(d->text + start, end - start);
+    for (char *ch = name; *ch; ch++) {
+        *ch = tolower((unsigned char)*ch);
+    }
+
+    uint32_t low  = 0;
+    uint32_t high = d->lineCount;
+    while (low + 1 < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (d->lines[middle] <= start) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    lspLookup *lookup = (lspLookup *)calloc(1, sizeof(lspLookup));
+    lookup->line      = low + 1;
+    lookup->column    = start - d->lines[low];
+    lookup->program   = program;
+
+    lspVisit(lookup, program);
+
+    // The tree can be older than the text, then only the global declarations are known
+    Token *found = lookup->done ? lookup->found : lspResolve(lookup, name);
+
+    if (!found) {
+        lspRespond(s, id, "null");
+    } else {
+        astString buffer = {NULL, 0, 0};
+
+        astAppendToString(&buffer, "{\"uri\":");
+        jsAppendString(&buffer, d->uri);
+        astAppendToString(&buffer, ",\"range\":");
+        lspAppendRange(&buffer, d, found);
+        astAppendToString(&buffer, "}");
+
+        lspRespond(s, id, buffer.data);
+        free(buffer.data);
+    }
+
+    free(lookup);
+    free(name);
+}
+
+//
+// Documents
+//
+
+// Create a document with its initial contents
+lspDocument *lspDocumentNew(char *uri, char *text, int64_t version) {
+    lspDocument *d = (lspDocument *)calloc(1, sizeof(lspDocument));
+    if (!d) {
+        return NULL;
+    }
+
+    d->uri      = strdup(uri);
+    d->version  = version;
+    d->text     = strdup(text);
+    d->length   = strlen(text);
+    d->capacity = d->length + 1;
+
+    d->lines        = (uint64_t *)malloc(sizeof(uint64_t) * 64);
+    d->lines[0]     = 0;
+    d->lineCount    = 1;
+    d->lineCapacity = 64;
+    lspIndexLines(d, 0, 0, d->length);
+
+    d->checks = cMemoNew();
+
+    return d;
+}
+
+// Free the document with its tree and checks
+void lspDocumentFree(lspDocument *d) {
+    if (d) {
+        if (d->program) {
+            astProgramFree(d->program);
+        }
+        cMemoFree(d->checks);
+        free(d->lines);
+        free(d->text);
+        free(d->uri);
+        free(d);
+    }
+}
+
+// Open document named by `params.textDocument.uri`, NULL if it isn't open
+lspDocument *lspFindDocument(LanguageServer *s, jsValue *params) {
+    char *uri = jsString(jsGet(jsGet(params, "textDocument"), "uri"));
+    if (!uri) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < s->size; i++) {
+        if (strcmp(s->documents[i]->uri, uri) == 0) {
+            return s->documents[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Apply one content change, an edit of a range or, without a range, the whole new contents
+bool lspApplyChange(lspDocument *d, jsValue *change) {
+    char *text = jsString(jsGet(change, "text"));
+    if (!text) {
+        return false;
+    }
+
+    jsValue *range = jsGet(change, "range");
+    if (!range) {
+        lspReplace(d, 0, d->length, text);
+        return true;
+    }
+
+    uint64_t start = lspOffset(d, jsGet(range, "start"));
+    uint64_t end   = lspOffset(d, jsGet(range, "end"));
+    if (end < start) {
+        uint64_t swap = start;
+        start         = end;
+        end           = swap;
+    }
+
+    lspReplace(d, start, end, text);
+    return true;
+}
+
+// Replace the bytes from `start` to `end` with `text`, keeping the lines and function checks in step
+void lspReplace(lspDocument *d, uint64_t start, uint64_t end, char *text) {
+    uint64_t length = strlen(text);
+    uint64_t size   = d->length - (end - start) + length;
+
+    if (size + 1 > d->capacity) {
+        d->capacity = size + 1 > d->capacity * 2 ? size + 1 : d->capacity * 2;
+        d->text     = (char *)realloc(d->text, d->capacity);
+    }
+
+    memmove(d->text + start + length, d->text + end, d->length - end + 1);
+    memcpy(d->text + start, text, length);
+    d->length = size;
+
+    cMemoShift(d->checks, start, end, length);
+    lspIndexLines(d, start, end, length);
+    d->parsed = false;
+}
+
+// Update the line starts after the bytes from `start` to `end` were replaced with `length` bytes
+void lspIndexLines(lspDocument *d, uint64_t start, uint64_t end, uint64_t length) {
+    // Lines starting in the replaced bytes are gone, the first line always starts at 0
+    uint32_t first = 1;
+    uint32_t high  = d->lineCount;
+    while (first < high) {
+        uint32_t middle = first + (high - first) / 2;
+        if (d->lines[middle] <= start) {
+            first = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    uint32_t last = first;
+    while (last < d->lineCount && d->lines[last] <= end) {
+        last++;
+    }
+
+    uint32_t added = 0;
+    for (uint64_t i = start; i < start + length; i++) {
+        added += d->text[i] == '\n';
+    }
+
+    uint32_t count = d->lineCount - (last - first) + added;
+    if (count > d->lineCapacity) {
+        d->lineCapacity = count > d->lineCapacity * 2 ? count : d->lineCapacity * 2;
+        d->lines        = (uint64_t *)realloc(d->lines, sizeof(uint64_t) * d->lineCapacity);
+    }
+
+    memmove(d->lines + first + added, d->lines + last, sizeof(uint64_t) * (d->lineCount - last));
+
+    for (uint32_t i = first + added; i < count; i++) {
+        d->lines[i] = d->lines[i] - (end - start) + length;
+    }
+
+    uint32_t line = first;
+    for (uint64_t i = start; i < start + length; i++) {
+        if (d->text[i] == '\n') {
+            d->lines[line++] = i + 1;
+        }
+    }
+
+    d->lineCount = count;
+}
+
+// Byte offset of a protocol position, whose character counts UTF-16 code units
+uint64_t lspOffset(lspDocument *d, jsValue *position) {
+    int64_t line      = jsInteger(jsGet(position, "line"), 0);
+    int64_t character = jsInteger(jsGet(position, "character"), 0);
+
+    if (line < 0) {
+        return 0;
+    }
+    if ((uint64_t)line >= d->lineCount) {
+        return d->length;
+    }
+
+    uint64_t offset = d->lines[line];
+    uint64_t end    = (uint64_t)line + 1 < d->lineCount ? d->lines[line + 1] : d->length;
+    int64_t  units  = 0;
+
+    while (offset < end && units < character && d->text[offset] != '\n') {
+        // Characters past the basic plane take two code units, continuation bytes none
+        units += (unsigned char)d->text[offset] >= 0xF0 ? 2 : 1;
+        offset++;
+
+        while (offset < end && ((unsigned char)d->text[offset] & 0xC0) == 0x80) {
+            offset++;
+        }
+    }
+
+    return offset;
+}
+
+// Protocol character of a byte column of a line, in UTF-16 code units
+uint64_t lspCharacter(lspDocument *d, uint64_t line, uint64_t column) {
+    if (line >= d->lineCount) {
+        return column;
+    }
+
+    uint64_t start = d->lines[line];
+    uint64_t units = 0;
+
+    for (uint64_t i = start; i < start + column && i < d->length; i++) {
+        unsigned char byte = (unsigned char)d->text[i];
+        if ((byte & 0xC0) != 0x80) {
+            units += byte >= 0xF0 ? 2 : 1;
+        }
+    }
+
+    return units;
+}
+
+//
+// Checking and parsing
+//
+
+// Check the contents, reusing the checks of the functions the edits since the last check didn't touch
+void lspCheck(LanguageServer *s, lspDocument *d) {
+    Lexer   *l = lNewWithKeywords(d->text, s->keywords);
+    Checker *c = cNew(l);
+
+    c->reuse  = d->checks;
+    c->record = cMemoNew();
+    cCheckProgram(c);
+
+    cMemoAdopt(c->record, c);
+    cMemoFree(d->checks);
+    d->checks = c->record;
+
+    cFree(c);
+
+    // The text belongs to the document
+    l->input = NULL;
+    lFree(l);
+}
+
+// Send the diagnostics of the last check, each one covers the line it was reported on
+void lspPublish(LanguageServer *s, lspDocument *d) {
+    astString buffer = {NULL, 0, 0};
+    char      number[160];
+
+    astAppendToString(&buffer, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    jsAppendString(&buffer, d->uri);
+    snprintf(number, sizeof(number), ",\"version\":%" PRId64 ",\"diagnostics\":[", d->version);
+    astAppendToString(&buffer, number);
+
+    eErrorList *errors = d->checks->errors;
+    for (uint32_t i = 0; i < errors->size; i++) {
+        char    *message = errors->data[i];
+        uint64_t line    = 0;
+
+        if (strncmp(message, "Linha ", 6) == 0) {
+            char *rest = NULL;
+            line       = strtoull(message + 6, &rest, 10);
+            message    = strncmp(rest, ": ", 2) == 0 ? rest + 2 : rest;
+        }
+
+        line = line > 0 ? line - 1 : 0;
+        if (line >= d->lineCount) {
+            line = d->lineCount - 1;
+        }
+
+        uint64_t end = line + 1 < d->lineCount ? d->lines[line + 1] - 1 : d->length;
+        while (end > d->lines[line] && (d->text[end - 1] == '\r' || d->text[end - 1] == '\n')) {
+            end--;
+        }
+
+        snprintf(number, sizeof(number),
+                 "%s{\"range\":{\"start\":{\"line\":%" PRIu64 ",\"character\":0},\"end\":{\"line\":%" PRIu64
+                 ",\"character\":",
+                 i > 0 ? "," : "", line, line);
+        astAppendToString(&buffer, number);
+        snprintf(number, sizeof(number), "%" PRIu64 "}},\"severity\":1,\"source\":\"pascal\",\"message\":",
+                 lspCharacter(d, line, end - d->lines[line]));
+        astAppendToString(&buffer, number);
+        jsAppendString(&buffer, message);
+        astAppendToString(&buffer, "}");
+    }
+
+    astAppendToString(&buffer, "]}}");
+
+    lspSend(s, &buffer);
+    free(buffer.data);
+}
+
+// Tree of the contents, built when first asked for after a change, the last good tree while the contents have errors
+astProgram *lspParse(LanguageServer *s, lspDocument *d) {
+    // Contents the diagnostics already found errors in keep the last good tree
+    if (d->parsed || d->checks->errors->size > 0) {
+        return d->program;
+    }
+
+    Lexer      *l       = lNewWithKeywords(d->text, s->keywords);
+    Parser     *p       = pNewShared(l, NULL, NULL, s->tables);
+    astProgram *program = pParseProgram(p);
+
+    if (p->errors->size == 0) {
+        if (d->program) {
+            astProgramFree(d->program);
+        }
+        d->program = program;
+        d->parsed  = true;
+    } else {
+        astProgramFree(program);
+    }
+
+    pFree(p);
+
+    // The text belongs to the document
+    l->input = NULL;
+    lFree(l);
+
+    return d->program;
+}
+
+//
+// Symbols
+//
+
+// Append the range of a token
+void lspAppendRange(astString *buffer, lspDocument *d, Token *t) {
+    uint64_t line  = t->line > 0 ? t->line - 1 : 0;
+    uint64_t start = lspCharacter(d, line, t->column);
+    uint64_t end   = lspCharacter(d, line, t->column + strlen(t->literal));
+
+    char range[160];
+    snprintf(range, sizeof(range),
+             "{\"start\":{\"line\":%" PRIu64 ",\"character\":%" PRIu64 "},\"end\":{\"line\":%" PRIu64
+             ",\"character\":%" PRIu64 "}}",
+             line, start, line, end);
+
+    astAppendToString(buffer, range);
+}
+
+// Open a symbol, the caller appends its children and closes it with `]}`
+void lspAppendSymbol(astString *buffer, lspDocument *d, Token *name, uint32_t kind, char *detail) {
+    if (buffer->length > 0 && buffer->data[buffer->length - 1] != '[') {
+        astAppendToString(buffer, ",");
+    }
+
+    char number[32];
+    snprintf(number, sizeof(number), ",\"kind\":%" PRIu32, kind);
+
+    astAppendToString(buffer, "{\"name\":");
+    jsAppendString(buffer, name->literal);
+    astAppendToString(buffer, ",\"detail\":");
+    jsAppendString(buffer, detail);
+    astAppendToString(buffer, number);
+    astAppendToString(buffer, ",\"range\":");
+    lspAppendRange(buffer, d, name);
+    astAppendToString(buffer, ",\"selectionRange\":");
+    lspAppendRange(buffer, d, name);
+    astAppendToString(buffer, ",\"children\":[");
+}
+
+// Append a variable symbol for every identifier of the declarations
+void lspAppendDeclarations(astString *buffer, lspDocument *d, astDeclarationStmt **declarations, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        char               *type        = declaration->type ? declaration->type->token->literal : "";
+
+        for (uint32_t j = 0; j < declaration->size; j++) {
+            lspAppendSymbol(buffer, d, declaration->identifier[j]->token, 13, type);
+            astAppendToString(buffer, "]}");
+        }
+    }
+}
+
+// Append the variables and functions declared in a block, functions hold their parameters and declarations
+void lspAppendBlockSymbols(astString *buffer, lspDocument *d, astBlockStmt *b) {
+    for (uint32_t i = 0; b && i < b->size; i++) {
+        astStatement *statement = b->statements[i];
+
+        switch (evKindOf(statement)) {
+            case EV_VAR: {
+                astVarStmt *var = (astVarStmt *)statement;
+                lspAppendDeclarations(buffer, d, var->declarations, var->size);
+                break;
+            }
+            case EV_FUNCTION: {
+                astFunctionStmt *function = (astFunctionStmt *)statement;
+                char            *detail   = function->returnType ? function->returnType->token->literal : "procedure";
+
+                lspAppendSymbol(buffer, d, function->identifier->token, 12, detail);
+                for (uint32_t j = 0; j < function->size; j++) {
+                    lspAppendDeclarations(buffer, d, function->parameters[j]->declarations,
+                                          function->parameters[j]->size);
+                }
+                lspAppendBlockSymbols(buffer, d, function->block);
+                astAppendToString(buffer, "]}");
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+//
+// Definitions
+//
+
+// Walk the tree down to the identifier being looked up, keeping track of the functions around it
+void lspVisit(lspLookup *lookup, void *node) {
+    if (!node || lookup->done) {
+        return;
+    }
+
+    switch (evKindOf(node)) {
+        case EV_PROGRAM: {
+            astProgram *program = (astProgram *)node;
+            lspVisit(lookup, program->identifier);
+            lspVisit(lookup, program->block);
+            break;
+        }
+        case EV_BLOCK: {
+            astBlockStmt *block = (astBlockStmt *)node;
+            for (uint32_t i = 0; i < block->size; i++) {
+                lspVisit(lookup, block->statements[i]);
+            }
+            break;
+        }
+        case EV_VAR: {
+            astVarStmt *var = (astVarStmt *)node;
+            for (uint32_t i = 0; i < var->size; i++) {
+                lspVisit(lookup, var->declarations[i]);
+            }
+            break;
+        }
+        case EV_DECLARATION: {
+            astDeclarationStmt *declaration = (astDeclarationStmt *)node;
+            for (uint32_t i = 0; i < declaration->size; i++) {
+                lspVisit(lookup, declaration->identifier[i]);
+            }
+            break;
+        }
+        case EV_FUNCTION: {
+            astFunctionStmt *function = (astFunctionStmt *)node;
+
+            // The name belongs to the enclosing scope, the parameters and the block to the function
+            lspVisit(lookup, function->identifier);
+
+            bool nested = lookup->depth < LSP_MAX_SCOPES;
+            if (nested) {
+                lookup->scopes[lookup->depth++] = function;
+            }
+
+            for (uint32_t i = 0; i < function->size; i++) {
+                lspVisit(lookup, function->parameters[i]);
+            }
+            lspVisit(lookup, function->block);
+
+            if (nested) {
+                lookup->depth--;
+            }
+            break;
+        }
+        case EV_PARAMETER: {
+            astParameterStmt *parameter = (astParameterStmt *)node;
+            for (uint32_t i = 0; i < parameter->size; i++) {
+                lspVisit(lookup, parameter->declarations[i]);
+            }
+            break;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)node;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                lspVisit(lookup, beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)node;
+            lspVisit(lookup, conditional->condition);
+            lspVisit(lookup, conditional->consequence);
+            lspVisit(lookup, conditional->alternative);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)node;
+            lspVisit(lookup, loop->condition);
+            lspVisit(lookup, loop->body);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            lspVisit(lookup, ((astExpressionStmt *)node)->expr);
+            break;
+        case EV_PREFIX:
+            lspVisit(lookup, ((astPrefixExpr *)node)->right);
+            break;
+        case EV_INFIX:
+            lspVisit(lookup, ((astInfixExpr *)node)->left);
+            lspVisit(lookup, ((astInfixExpr *)node)->right);
+            break;
+        case EV_ASSIGNMENT:
+            lspVisit(lookup, ((astAssignmentExpr *)node)->identifier);
+            lspVisit(lookup, ((astAssignmentExpr *)node)->value);
+            break;
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)node;
+            lspVisit(lookup, call->identifier);
+            for (uint32_t i = 0; i < call->size; i++) {
+                lspVisit(lookup, call->arguments[i]);
+            }
+            break;
+        }
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)node;
+            if (identifier->token->line == lookup->line && identifier->token->column == lookup->column) {
+                lookup->done  = true;
+                lookup->found = lspResolve(lookup, identifier->value);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Declaration of a name as seen from the current scope, innermost function first, NULL if it's undeclared
+Token *lspResolve(lspLookup *lookup, char *name) {
+    for (uint32_t i = lookup->depth; i > 0; i--) {
+        astFunctionStmt *function = lookup->scopes[i - 1];
+
+        for (uint32_t j = 0; j < function->size; j++) {
+            Token *found =
+                lspResolveDeclarations(function->parameters[j]->declarations, function->parameters[j]->size, name);
+            if (found) {
+                return found;
+            }
+        }
+
+        Token *found = lspResolveBlock(function->block, name);
+        if (found) {
+            return found;
+        }
+    }
+
+    Token *found = lspResolveBlock(lookup->program->block, name);
+    if (found) {
+        return found;
+    }
+
+    if (strcmp(lookup->program->identifier->value, name) == 0) {
+        return lookup->program->identifier->token;
+    }
+
+    return NULL;
+}
+
+// Identifier token of a name in a list of declarations, NULL if it isn't there
+Token *lspResolveDeclarations(astDeclarationStmt **declarations, uint32_t size, char *name) {
+    for (uint32_t i = 0; i < size; i++) {
+        for (uint32_t j = 0; j < declarations[i]->size; j++) {
+            if (strcmp(declarations[i]->identifier[j]->value, name) == 0) {
+                return declarations[i]->identifier[j]->token;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// Variable or function of a name declared directly in a block, NULL if it isn't there
+Token *lspResolveBlock(astBlockStmt *b, char *name) {
+    for (uint32_t i = 0; b && i < b->size; i++) {
+        astStatement *statement = b->statements[i];
+
+        switch (evKindOf(statement)) {
+            case EV_VAR: {
+                astVarStmt *var   = (astVarStmt *)statement;
+                Token      *found = lspResolveDeclarations(var->declarations, var->size, name);
+                if (found) {
+                    return found;
+                }
+                break;
+            }
+            case EV_FUNCTION: {
+                astFunctionStmt *function = (astFunctionStmt *)statement;
+                if (strcmp(function->identifier->value, name) == 0) {
+                    return function->identifier->token;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    return NULL;
+}
\ No newline at end of file
@@ -0,0 +1,1840 @@
+#include "native.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "error.h"
+#include "escapes.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Write a program the type checker accepted as x86-64 assembly, returns false if it uses strings
+bool ncEmitProgram(TypeChecker *types, astProgram *program, FILE *out, eErrorList *errors) {
+    if (!program) {
+        return false;
+    }
+
+    uint32_t symbols = types->symbols->size;
+
+    Native g;
+    memset(&g, 0, sizeof(g));
+    g.out     = out;
+    g.types   = types;
+    g.program = program;
+    g.slots   = (uint32_t *)calloc(symbols, sizeof(uint32_t));
+    g.homes   = (ncHome *)calloc(symbols, sizeof(ncHome));
+    g.escapes = (bool *)calloc(symbols, sizeof(bool));
+    g.errors  = errors;
+
+    // Function 0 is the program body
+    g.functions = (ncFunction *)astGrowArray(g.functions, g.size, &g.functionCapacity, sizeof(ncFunction));
+    char *name            = program->identifier ? program->identifier->value : "program";
+    g.functions[g.size++] = (ncFunction){NULL, name, 0, 0, 0, 0};
+    ncCollect(&g, program->block, 0);
+
+    // Where a variable lives depends on every function that reaches it, so every function is scanned first
+    for (uint32_t i = 0; i < g.size; i++) {
+        ncScanBlock(&g, i == 0 ? program->block : g.functions[i].function->block, i);
+    }
+    for (uint32_t i = 0; i < g.size && !g.failed; i++) {
+        ncPlace(&g, i);
+    }
+
+    if (!g.failed) {
+        fprintf(out, "# Gerado a partir de `%s` por PascalSyntaxAnalyzer --emit-asm\n", g.functions[0].name);
+        fprintf(out, "\t.text\n");
+
+        for (uint32_t i = 1; i < g.size; i++) {
+            ncEmitFunction(&g, i);
+        }
+        ncEmitFunction(&g, 0);
+
+        fprintf(out, "\n\t.section .rodata\n\t.balign 16\n.LCsign:\n\t.quad 0x8000000000000000, 0\n");
+        for (uint32_t i = 0; i < g.constantSize; i++) {
+            uint64_t bits;
+            memcpy(&bits, &g.constants[i], sizeof(bits));
+            fprintf(out, ".LC%u:\n\t.quad 0x%016" PRIx64 "  # %.17g\n", i, bits, g.constants[i]);
+        }
+        fprintf(out, ".Ltrue:\n\t.string \"true\"\n.Lfalse:\n\t.string \"false\"\n");
+
+        fprintf(out, "\n\t.bss\n\t.balign 16\n.Lstack:\n\t.zero %" PRIu64 "\n.Ldepth:\n\t.zero 8\n", ncStackSize(&g));
+        for (uint32_t i = 1; i < symbols; i++) {
+            sySymbol *s = &types->symbols->symbols[i];
+            if (s->kind == SY_VARIABLE && s->depth == 0) {
+                fprintf(out, "pv_%s:\n\t.zero 8\n", s->name);
+            }
+        }
+
+        fprintf(out, "\n\t.section .note.GNU-stack,\"\",@progbits\n");
+    }
+
+    free(g.functions);
+    free(g.slots);
+    free(g.homes);
+    free(g.escapes);
+    free(g.code);
+    free(g.classes);
+    free(g.variables);
+    free(g.locations);
+    free(g.stubs);
+    free(g.constants);
+
+    return !g.failed && !ferror(out);
+}
+
+// Number the functions declared in a block and in the functions it declares
+void ncCollect(Native *g, astBlockStmt *block, uint32_t parent) {
+    if (!block) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (evKindOf(s) != EV_FUNCTION || !((astFunctionStmt *)s)->identifier) {
+            continue;
+        }
+
+        astFunctionStmt *function = (astFunctionStmt *)s;
+        uint32_t         depth    = g->functions[parent].depth + 1;
+
+        g->functions = (ncFunction *)astGrowArray(g->functions, g->size, &g->functionCapacity, sizeof(ncFunction));
+        g->functions[g->size] = (ncFunction){function, function->identifier->value, parent, depth, 0, 0};
+
+        uint32_t index                         = g->size++;
+        g->slots[function->identifier->symbol] = index;
+
+        ncCollect(g, function->block, index);
+    }
+}
+
+//
+// Escapes
+//
+
+// Find the variables of a function body that live in memory, and the strings the generator can't hold
+void ncScanBlock(Native *g, astBlockStmt *block, uint32_t index) {
+    Escapes x = {g->types, g->escapes, ncScanExpression, g};
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+
+        switch (evKindOf(s)) {
+            case EV_VAR: {
+                astVarStmt *var = (astVarStmt *)s;
+                ncScanDeclarations(g, var->declarations, var->size);
+                break;
+            }
+            case EV_FUNCTION: {
+                astFunctionStmt *function = (astFunctionStmt *)s;
+                for (uint32_t j = 0; j < function->size; j++) {
+                    if (function->parameters[j]) {
+                        ncScanDeclarations(g, function->parameters[j]->declarations, function->parameters[j]->size);
+                    }
+                }
+                if (function->returnType && tyOfTypeExpr(function->returnType) == TY_STRING) {
+                    g->line = function->token->line;
+                    ncError(g, "O gerador nativo não suporta strings");
+                }
+                break;
+            }
+            default:
+                esScanStatement(&x, s, g->functions[index].depth);
+                break;
+        }
+    }
+}
+
+// Reject string expressions, the escape scan skips their operands
+bool ncScanExpression(void *context, astExpression *e) {
+    Native *g = (Native *)context;
+
+    if (e->type == TY_STRING) {
+        g->line = e->token->line;
+        ncError(g, "O gerador nativo não suporta strings");
+        return false;
+    }
+
+    return true;
+}
+
+// Reject string variables and parameters
+void ncScanDeclarations(Native *g, astDeclarationStmt **declarations, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        if (declarations[i] && tyOfTypeExpr(declarations[i]->type) == TY_STRING) {
+            g->line = declarations[i]->token->line;
+            ncError(g, "O gerador nativo não suporta strings");
+        }
+    }
+}
+
+// Give the parameters, the result and the variables of a function their homes, the escaping ones in memory
+void ncPlace(Native *g, uint32_t index) {
+    ncFunction *f = &g->functions[index];
+
+    if (index == 0) {
+        ncPlaceDeclarations(g, NULL, 0, 0);
+    } else {
+        f->arguments = f->parent != 0;
+        for (uint32_t i = 0; i < f->function->size; i++) {
+            astParameterStmt *parameter = f->function->parameters[i];
+            for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+                astDeclarationStmt *declaration = parameter->declarations[j];
+                for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                    uint32_t symbol  = declaration->identifier[k]->symbol;
+                    g->homes[symbol] = (ncHome){g->escapes[symbol] ? NC_ARG_SLOT : NC_REGISTER, f->arguments++};
+                }
+            }
+        }
+
+        if (f->function->returnType) {
+            uint32_t symbol  = f->function->identifier->symbol;
+            g->homes[symbol] = g->escapes[symbol] ? (ncHome){NC_SLOT, f->slots++} : (ncHome){NC_REGISTER, 0};
+        }
+    }
+
+    astBlockStmt *block = index == 0 ? g->program->block : f->function->block;
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) == EV_VAR) {
+            astVarStmt *var = (astVarStmt *)block->statements[i];
+            ncPlaceDeclarations(g, var->declarations, var->size, index);
+        }
+    }
+}
+
+// Give declared variables their homes, an escaping variable of the program is a global, of a function a frame slot
+void ncPlaceDeclarations(Native *g, astDeclarationStmt **declarations, uint32_t size, uint32_t index) {
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        for (uint32_t j = 0; declaration && j < declaration->size; j++) {
+            uint32_t symbol = declaration->identifier[j]->symbol;
+
+            if (!g->escapes[symbol]) {
+                g->homes[symbol] = (ncHome){NC_REGISTER, 0};
+            } else if (index == 0) {
+                g->homes[symbol] = (ncHome){NC_GLOBAL, symbol};
+            } else {
+                g->homes[symbol] = (ncHome){NC_SLOT, g->functions[index].slots++};
+            }
+        }
+    }
+}
+
+//
+// Lowering
+//
+
+// Lower a function to three-address code, the program body ends showing the variables of the program
+void ncLowerFunction(Native *g, uint32_t index) {
+    ncFunction *f = &g->functions[index];
+
+    g->current   = index;
+    g->codeSize  = 0;
+    g->registers = 0;
+    g->labels    = 0;
+    g->outgoing  = 0;
+    g->stubSize  = 0;
+    g->line      = index == 0 ? (g->program->token ? g->program->token->line : 0) : f->function->token->line;
+
+    astBlockStmt *block = index == 0 ? g->program->block : f->function->block;
+
+    if (index != 0) {
+        uint32_t argument = f->parent != 0;
+        for (uint32_t i = 0; i < f->function->size; i++) {
+            astParameterStmt *parameter = f->function->parameters[i];
+            for (uint32_t j = 0; parameter && j < parameter->size; j++) {
+                astDeclarationStmt *declaration = parameter->declarations[j];
+                for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                    ncHome *home = &g->homes[declaration->identifier[k]->symbol];
+                    if (home->base == NC_REGISTER) {
+                        uint32_t type = tyOfTypeExpr(declaration->type);
+
+                        ncInstr memory;
+                        memory.base = NC_ARG_SLOT;
+                        memory.imm  = argument;
+                        memory.c    = NC_NONE;
+
+                        home->index                = ncRegister(g, !parameter->isVar && type == TY_REAL);
+                        g->variables[home->index] = true;
+                        ncEmitMemory(g, NC_LOAD, home->index, &memory);
+                    }
+                    argument++;
+                }
+            }
+        }
+
+        if (f->function->returnType) {
+            ncLowerZero(g, f->function->identifier->symbol);
+        }
+    }
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)block->statements[i];
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                ncLowerZero(g, declaration->identifier[k]->symbol);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) == EV_BEGIN_END) {
+            ncLowerStatement(g, block->statements[i]);
+        }
+    }
+
+    if (index == 0) {
+        // The variables kept in registers go to their globals, where the program shows them from
+        for (uint32_t i = 1; i < g->types->symbols->size; i++) {
+            sySymbol *s = &g->types->symbols->symbols[i];
+            if (s->kind == SY_VARIABLE && s->depth == 0 && g->homes[i].base == NC_REGISTER) {
+                ncInstr memory;
+                memory.base = NC_GLOBAL;
+                memory.imm  = i;
+                memory.c    = NC_NONE;
+                ncEmitMemory(g, NC_STORE, g->homes[i].index, &memory);
+            }
+        }
+        ncEmit(g, NC_EXIT, NC_NONE, NC_NONE, NC_NONE);
+        return;
+    }
+
+    uint32_t result = NC_NONE;
+    if (f->function->returnType) {
+        result = ncLowerVariable(g, f->function->identifier);
+    }
+    ncEmit(g, NC_RET, NC_NONE, result, NC_NONE);
+}
+
+// Start a variable at zero, in a new virtual register or in its frame slot, globals start zeroed
+void ncLowerZero(Native *g, uint32_t symbol) {
+    ncHome *home = &g->homes[symbol];
+
+    if (home->base == NC_REGISTER) {
+        bool real                 = ncTypeOf(g, symbol) == TY_REAL;
+        home->index               = ncRegister(g, real ? NC_REAL : NC_INT);
+        g->variables[home->index] = true;
+
+        if (real) {
+            ncEmitImmediate(g, NC_LOADF, home->index, NC_NONE, ncConstant(g, 0.0));
+        } else {
+            ncEmitImmediate(g, NC_LOADI, home->index, NC_NONE, 0);
+        }
+    } else if (home->base == NC_SLOT) {
+        uint32_t zero = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_LOADI, zero, NC_NONE, 0);
+
+        ncInstr memory;
+        memory.base = NC_SLOT;
+        memory.imm  = home->index;
+        memory.c    = NC_NONE;
+        ncEmitMemory(g, NC_STORE, zero, &memory);
+    }
+}
+
+// Lower a statement
+void ncLowerStatement(Native *g, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                ncLowerStatement(g, (astStatement *)beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            uint32_t            otherwise   = ncLabel(g);
+
+            g->line = conditional->token->line;
+            ncLowerBranch(g, conditional->condition, false, otherwise);
+            ncLowerStatement(g, conditional->consequence);
+
+            if (conditional->alternative) {
+                uint32_t end = ncLabel(g);
+                ncEmit(g, NC_JUMP, end, NC_NONE, NC_NONE);
+                ncEmit(g, NC_LABEL, otherwise, NC_NONE, NC_NONE);
+                ncLowerStatement(g, conditional->alternative);
+                otherwise = end;
+            }
+
+            ncEmit(g, NC_LABEL, otherwise, NC_NONE, NC_NONE);
+            break;
+        }
+        case EV_WHILE: {
+            // The test sits after the body, so each iteration runs a single branch
+            astWhileStmt *loop = (astWhileStmt *)s;
+            uint32_t      body = ncLabel(g);
+            uint32_t      test = ncLabel(g);
+
+            g->line = loop->token->line;
+            ncEmit(g, NC_JUMP, test, NC_NONE, NC_NONE);
+            ncEmit(g, NC_LABEL, body, NC_NONE, NC_NONE);
+            ncLowerStatement(g, loop->body);
+            ncEmit(g, NC_LABEL, test, NC_NONE, NC_NONE);
+            g->line = loop->token->line;
+            ncLowerBranch(g, loop->condition, true, body);
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *statement = (astExpressionStmt *)s;
+
+            g->line = statement->token ? statement->token->line : g->line;
+            ncLowerExpression(g, statement->expr);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Lower a branch to `label` taken when a condition is `when`, comparisons branch on the flags they set
+void ncLowerBranch(Native *g, astExpression *condition, bool when, uint32_t label) {
+    if (evKindOf(condition) == EV_PREFIX && ((astPrefixExpr *)condition)->token->type == NOT) {
+        ncLowerBranch(g, ((astPrefixExpr *)condition)->right, !when, label);
+        return;
+    }
+
+    if (evKindOf(condition) == EV_INFIX) {
+        astInfixExpr *infix = (astInfixExpr *)condition;
+        TokenType     op    = infix->token->type;
+
+        if (op == EQ || op == NOT_EQ || op == LT || op == GT || op == LTE || op == GTE) {
+            bool     real = infix->left->type == TY_REAL || infix->right->type == TY_REAL;
+            uint32_t type = real ? TY_REAL : TY_INTEGER;
+
+            g->line    = infix->token->line;
+            uint32_t a = ncLowerConverted(g, infix->left, type);
+
+            int64_t  immediate;
+            uint32_t branch;
+            if (!real && ncIsImmediate(infix->right, &immediate)) {
+                branch = ncEmitImmediate(g, NC_BRANCH, label, a, immediate);
+            } else {
+                branch = ncEmit(g, NC_BRANCH, label, a, ncLowerConverted(g, infix->right, type));
+            }
+
+            g->code[branch].cc       = op;
+            g->code[branch].real     = real;
+            g->code[branch].inverted = !when;
+            return;
+        }
+    }
+
+    uint32_t value  = ncLowerExpression(g, condition);
+    uint32_t branch = ncEmitImmediate(g, NC_BRANCH, label, value, 0);
+
+    g->code[branch].cc       = NOT_EQ;
+    g->code[branch].inverted = !when;
+}
+
+// Lower an expression, returns the virtual register holding its value, variables are read in place
+uint32_t ncLowerExpression(Native *g, astExpression *e) {
+    if (!e) {
+        return NC_NONE;
+    }
+
+    int64_t immediate = 0;
+    if (ncIsImmediate(e, &immediate) || evKindOf(e) == EV_INTEGER) {
+        uint32_t d = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_LOADI, d, NC_NONE, evKindOf(e) == EV_INTEGER ? ((astIntegerExpr *)e)->value : immediate);
+        return d;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_FLOAT: {
+            uint32_t d = ncRegister(g, NC_REAL);
+            ncEmitImmediate(g, NC_LOADF, d, NC_NONE, ncConstant(g, ((astFloatExpr *)e)->value));
+            return d;
+        }
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(g->types->symbols, identifier);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                return ncLowerCall(g, identifier, NULL, 0);
+            }
+            return ncLowerVariable(g, identifier);
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            return ncLowerCall(g, call->identifier, call->arguments, call->size);
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+            uint32_t       right  = ncLowerExpression(g, prefix->right);
+
+            if (prefix->token->type == NOT) {
+                uint32_t d = ncRegister(g, NC_INT);
+                ncEmitImmediate(g, NC_XOR, d, right, 1);
+                return d;
+            }
+
+            bool     real = prefix->type == TY_REAL;
+            uint32_t d    = ncRegister(g, real ? NC_REAL : NC_INT);
+            ncEmit(g, real ? NC_FNEG : NC_NEG, d, right, NC_NONE);
+            return d;
+        }
+        case EV_INFIX:
+            return ncLowerInfix(g, (astInfixExpr *)e);
+        case EV_ASSIGNMENT:
+            ncLowerAssignment(g, (astAssignmentExpr *)e);
+            return NC_NONE;
+        default:
+            return NC_NONE;
+    }
+}
+
+// Lower an expression converted to a type it's assignable to, integers widen to real
+uint32_t ncLowerConverted(Native *g, astExpression *e, uint32_t type) {
+    if (e->type != TY_INTEGER || type != TY_REAL) {
+        return ncLowerExpression(g, e);
+    }
+
+    uint32_t d = ncRegister(g, NC_REAL);
+    if (evKindOf(e) == EV_INTEGER) {
+        ncEmitImmediate(g, NC_LOADF, d, NC_NONE, ncConstant(g, (double)((astIntegerExpr *)e)->value));
+    } else {
+        ncEmit(g, NC_CVT, d, ncLowerExpression(g, e), NC_NONE);
+    }
+    return d;
+}
+
+// Lower an infix expression, the operands are converted to the type the operator computes in, and a small integer
+// constant on the right is taken inline
+uint32_t ncLowerInfix(Native *g, astInfixExpr *infix) {
+    TokenType op   = infix->token->type;
+    bool      real = infix->left->type == TY_REAL || infix->right->type == TY_REAL || op == SLASH;
+    uint32_t  type = real ? TY_REAL : TY_INTEGER;
+
+    bool    comparison = op == EQ || op == NOT_EQ || op == LT || op == GT || op == LTE || op == GTE;
+    ncOp    code       = NC_ADD;
+    int64_t immediate;
+
+    switch (op) {
+        case PLUS:
+            code = real ? NC_FADD : NC_ADD;
+            break;
+        case MINUS:
+            code = real ? NC_FSUB : NC_SUB;
+            break;
+        case ASTERISK:
+            code = real ? NC_FMUL : NC_MUL;
+            break;
+        case SLASH:
+            code = NC_FDIV;
+            break;
+        case DIV:
+            code = NC_DIV;
+            break;
+        case MOD:
+            code = NC_MOD;
+            break;
+        case AND:
+            code = NC_AND;
+            break;
+        case OR:
+            code = NC_OR;
+            break;
+        default:
+            code = NC_SET;
+            break;
+    }
+
+    astExpression *left  = infix->left;
+    astExpression *right = infix->right;
+
+    // A constant on the left of a commutative operator moves to the right, where it can be inline
+    bool commutative = code == NC_ADD || code == NC_MUL || code == NC_AND || code == NC_OR;
+    if (commutative && ncIsImmediate(left, &immediate) && !ncIsImmediate(right, &immediate)) {
+        left  = infix->right;
+        right = infix->left;
+    }
+
+    g->line    = infix->token->line;
+    uint32_t a = ncLowerConverted(g, left, type);
+    uint32_t d = ncRegister(g, real && !comparison ? NC_REAL : NC_INT);
+
+    // A constant multiplier or divisor turns into shifts and a high multiply when it can, whatever its width
+    if (!real && ncIsConstant(right, &immediate) && ncLowerConstant(g, code, d, a, immediate)) {
+        return d;
+    }
+
+    uint32_t instr;
+    if (!real && ncIsImmediate(right, &immediate)) {
+        instr = ncEmitImmediate(g, code, d, a, immediate);
+    } else {
+        instr = ncEmit(g, code, d, a, ncLowerConverted(g, right, type));
+    }
+
+    if (comparison) {
+        g->code[instr].cc   = op;
+        g->code[instr].real = real;
+    }
+
+    // A literal divisor other than zero needs no check
+    if (code == NC_FDIV) {
+        double value = evKindOf(right) == EV_FLOAT     ? ((astFloatExpr *)right)->value
+                       : evKindOf(right) == EV_INTEGER ? (double)((astIntegerExpr *)right)->value
+                                                       : 0;
+        g->code[instr].imm = value != 0;
+    }
+
+    return d;
+}
+
+// Lower a multiplication, division or remainder of d = a by the constant k with shifts and a high multiply instead of
+// imul and idiv, false if k gains nothing. Division truncates towards zero like idiv, so a negative dividend is biased
+// by the divisor less one before the shift, and the quotient by another constant is rounded up when it's negative.
+// Any 64-bit k works, masks and multipliers that don't fit an instruction are loaded with movabs first
+bool ncLowerConstant(Native *g, ncOp op, uint32_t d, uint32_t a, int64_t k) {
+    uint64_t magnitude = k < 0 ? -(uint64_t)k : (uint64_t)k;
+    bool     power     = (magnitude & (magnitude - 1)) == 0;
+    uint32_t log       = 0;
+
+    if (magnitude < 2 || (op != NC_MUL && op != NC_DIV && op != NC_MOD) || (op == NC_MUL && !power)) {
+        return false;
+    }
+    while (((uint64_t)1 << log) < magnitude) {
+        log++;
+    }
+
+    if (op == NC_MUL) {
+        uint32_t shifted = k < 0 ? ncRegister(g, NC_INT) : d;
+        ncEmitImmediate(g, NC_SHL, shifted, a, log);
+        if (k < 0) {
+            ncEmit(g, NC_NEG, d, shifted, NC_NONE);
+        }
+        return true;
+    }
+
+    if (power) {
+        // The bias is 2^log - 1 for a negative dividend and 0 otherwise, the low bits of its sign extended to 64
+        uint32_t sign = a;
+        if (log > 1) {
+            sign = ncRegister(g, NC_INT);
+            ncEmitImmediate(g, NC_SAR, sign, a, 63);
+        }
+        uint32_t bias   = ncRegister(g, NC_INT);
+        uint32_t biased = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_SHR, bias, sign, 64 - log);
+        ncEmit(g, NC_ADD, biased, a, bias);
+
+        if (op == NC_MOD) {
+            uint32_t rounded = ncRegister(g, NC_INT);
+            ncEmitWide(g, NC_AND, rounded, biased, -(int64_t)((uint64_t)1 << log));
+            ncEmit(g, NC_SUB, d, a, rounded);
+        } else if (k < 0) {
+            uint32_t quotient = ncRegister(g, NC_INT);
+            ncEmitImmediate(g, NC_SAR, quotient, biased, log);
+            ncEmit(g, NC_NEG, d, quotient, NC_NONE);
+        } else {
+            ncEmitImmediate(g, NC_SAR, d, biased, log);
+        }
+        return true;
+    }
+
+    int64_t  magic;
+    uint32_t shift;
+    ncMagic(k, &magic, &shift);
+
+    uint32_t high = ncRegister(g, NC_INT);
+    ncEmitImmediate(g, NC_MULHI, high, a, magic);
+    if ((k > 0 && magic < 0) || (k < 0 && magic > 0)) {
+        uint32_t corrected = ncRegister(g, NC_INT);
+        ncEmit(g, k > 0 ? NC_ADD : NC_SUB, corrected, high, a);
+        high = corrected;
+    }
+    if (shift) {
+        uint32_t shifted = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_SAR, shifted, high, shift);
+        high = shifted;
+    }
+
+    uint32_t negative = ncRegister(g, NC_INT);
+    ncEmitImmediate(g, NC_SHR, negative, high, 63);
+    if (op == NC_DIV) {
+        ncEmit(g, NC_ADD, d, high, negative);
+        return true;
+    }
+
+    uint32_t quotient = ncRegister(g, NC_INT);
+    uint32_t product  = ncRegister(g, NC_INT);
+    ncEmit(g, NC_ADD, quotient, high, negative);
+    ncEmitWide(g, NC_MUL, product, quotient, k);
+    ncEmit(g, NC_SUB, d, a, product);
+    return true;
+}
+
+// Find the multiplier and shift dividing by a constant that isn't 0, 1, -1 or a power of two, from Hacker's Delight:
+// the smallest shift whose rounded up reciprocal is exact for every 64-bit dividend
+void ncMagic(int64_t divisor, int64_t *magic, uint32_t *shift) {
+    uint64_t two63     = (uint64_t)1 << 63;
+    uint64_t magnitude = divisor < 0 ? -(uint64_t)divisor : (uint64_t)divisor;
+    uint64_t t         = two63 + ((uint64_t)divisor >> 63);
+    uint64_t limit     = t - 1 - t % magnitude;
+    uint64_t q1        = two63 / limit;
+    uint64_t r1        = two63 - q1 * limit;
+    uint64_t q2        = two63 / magnitude;
+    uint64_t r2        = two63 - q2 * magnitude;
+    uint32_t p         = 63;
+    uint64_t delta;
+
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= limit) {
+            q1++;
+            r1 -= limit;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= magnitude) {
+            q2++;
+            r2 -= magnitude;
+        }
+        delta = magnitude - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    *magic = (int64_t)(divisor < 0 ? -(q2 + 1) : q2 + 1);
+    *shift = p - 64;
+}
+
+// Lower a call, the arguments go to the outgoing area of the frame after the static link of a nested callee
+uint32_t ncLowerCall(Native *g, astIdentifierExpr *callee, astExpression **arguments, uint32_t size) {
+    sySymbol    *s         = sySymbolOf(g->types->symbols, callee);
+    tySignature *signature = tySignatureOf(g->types, s->typeId);
+    uint32_t     index     = g->slots[callee->symbol];
+    ncFunction  *f         = &g->functions[index];
+
+    // Every argument is computed before any is stored, a call in an argument uses the same outgoing area
+    uint32_t *values = (uint32_t *)malloc((size + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < size; i++) {
+        if (signature->parameters[i] & TY_REFERENCE) {
+            values[i] = ncLowerAddress(g, (astIdentifierExpr *)arguments[i]);
+        } else {
+            values[i] = ncLowerConverted(g, arguments[i], signature->parameters[i]);
+        }
+    }
+
+    g->line        = callee->token->line;
+    uint32_t first = 0;
+    if (f->parent != 0) {
+        uint32_t link = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_FRAME, link, NC_NONE, g->functions[g->current].depth - g->functions[f->parent].depth);
+        ncEmitImmediate(g, NC_ARG, NC_NONE, link, 0);
+        first = 1;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        ncEmitImmediate(g, NC_ARG, NC_NONE, values[i], first + i);
+    }
+    free(values);
+
+    if (first + size > g->outgoing) {
+        g->outgoing = first + size;
+    }
+
+    uint32_t d = NC_NONE;
+    if (s->kind == SY_FUNCTION) {
+        d = ncRegister(g, signature->result == TY_REAL ? NC_REAL : NC_INT);
+    }
+    ncEmitImmediate(g, NC_CALL, d, NC_NONE, index);
+
+    return d;
+}
+
+// Lower a read of a variable, in place if it's a virtual register, a load from its frame or global otherwise
+uint32_t ncLowerVariable(Native *g, astIdentifierExpr *identifier) {
+    sySymbol *s    = sySymbolOf(g->types->symbols, identifier);
+    bool      real = ncTypeOf(g, identifier->symbol) == TY_REAL;
+
+    ncInstr memory;
+    ncLocate(g, identifier->symbol, &memory);
+
+    uint32_t value = (uint32_t)memory.imm;
+    if (memory.base != NC_REGISTER) {
+        value = ncRegister(g, real && !s->reference ? NC_REAL : NC_INT);
+        ncEmitMemory(g, NC_LOAD, value, &memory);
+    }
+
+    if (!s->reference) {
+        return value;
+    }
+
+    memory.base = NC_DEREF;
+    memory.imm  = 0;
+    memory.c    = value;
+
+    uint32_t d = ncRegister(g, real ? NC_REAL : NC_INT);
+    ncEmitMemory(g, NC_LOAD, d, &memory);
+    return d;
+}
+
+// Lower an assignment, a value computed just for a variable in a virtual register is computed into it
+void ncLowerAssignment(Native *g, astAssignmentExpr *assignment) {
+    astIdentifierExpr *identifier = assignment->identifier;
+    sySymbol          *s          = sySymbolOf(g->types->symbols, identifier);
+
+    uint32_t value = ncLowerConverted(g, assignment->value, identifier->type);
+    g->line        = assignment->token->line;
+
+    ncInstr memory;
+    ncLocate(g, identifier->symbol, &memory);
+
+    if (memory.base == NC_REGISTER && !s->reference) {
+        ncInstr *last = g->codeSize ? &g->code[g->codeSize - 1] : NULL;
+        if (last && ncDefines(last) == value && !g->variables[value]) {
+            last->a = (uint32_t)memory.imm;
+        } else {
+            ncEmit(g, NC_MOVE, (uint32_t)memory.imm, value, NC_NONE);
+        }
+        return;
+    }
+
+    if (s->reference) {
+        uint32_t pointer = (uint32_t)memory.imm;
+        if (memory.base != NC_REGISTER) {
+            pointer = ncRegister(g, NC_INT);
+            ncEmitMemory(g, NC_LOAD, pointer, &memory);
+        }
+
+        memory.base = NC_DEREF;
+        memory.imm  = 0;
+        memory.c    = pointer;
+    }
+
+    ncEmitMemory(g, NC_STORE, value, &memory);
+}
+
+// Lower the address of a variable passed by reference, a reference parameter passes on the address it holds
+uint32_t ncLowerAddress(Native *g, astIdentifierExpr *identifier) {
+    sySymbol *s = sySymbolOf(g->types->symbols, identifier);
+
+    ncInstr memory;
+    ncLocate(g, identifier->symbol, &memory);
+
+    if (memory.base == NC_REGISTER) {
+        return (uint32_t)memory.imm;
+    }
+
+    uint32_t d = ncRegister(g, NC_INT);
+    ncEmitMemory(g, s->reference ? NC_LOAD : NC_ADDR, d, &memory);
+    return d;
+}
+
+// Find where a variable lives from the function being lowered, the frame of an enclosing function is reached through
+// the static links
+void ncLocate(Native *g, uint32_t symbol, ncInstr *memory) {
+    ncHome *home = &g->homes[symbol];
+
+    memory->base = home->base;
+    memory->imm  = home->index;
+    memory->c    = NC_NONE;
+
+    uint32_t owner = ncOwnerOf(g, symbol);
+    if ((home->base == NC_SLOT || home->base == NC_ARG_SLOT) && owner != g->current) {
+        memory->c = ncRegister(g, NC_INT);
+        ncEmitImmediate(g, NC_FRAME, memory->c, NC_NONE,
+                        g->functions[g->current].depth - g->functions[owner].depth);
+    }
+}
+
+//
+// Code
+//
+
+// Append an instruction to the function being lowered, returns its index
+uint32_t ncEmit(Native *g, ncOp op, uint32_t a, uint32_t b, uint32_t c) {
+    g->code = (ncInstr *)astGrowArray(g->code, g->codeSize, &g->codeCapacity, sizeof(ncInstr));
+
+    ncInstr *in   = &g->code[g->codeSize];
+    in->op        = op;
+    in->cc        = 0;
+    in->base      = NC_REGISTER;
+    in->real      = false;
+    in->immediate = false;
+    in->inverted  = false;
+    in->a         = a;
+    in->b         = b;
+    in->c         = c;
+    in->imm       = 0;
+    in->line      = g->line;
+
+    return g->codeSize++;
+}
+
+// Append an instruction whose last operand is an immediate
+uint32_t ncEmitImmediate(Native *g, ncOp op, uint32_t a, uint32_t b, int64_t imm) {
+    uint32_t i           = ncEmit(g, op, a, b, NC_NONE);
+    g->code[i].immediate = true;
+    g->code[i].imm       = imm;
+    return i;
+}
+
+// Append an instruction with a constant operand, loaded into a register first when it doesn't fit 32 bits
+uint32_t ncEmitWide(Native *g, ncOp op, uint32_t a, uint32_t b, int64_t imm) {
+    if (imm >= INT32_MIN && imm <= INT32_MAX) {
+        return ncEmitImmediate(g, op, a, b, imm);
+    }
+
+    uint32_t constant = ncRegister(g, NC_INT);
+    ncEmitImmediate(g, NC_LOADI, constant, NC_NONE, imm);
+    return ncEmit(g, op, a, b, constant);
+}
+
+// Append a load, store or address of a memory operand, `reg` is the destination or the value stored
+uint32_t ncEmitMemory(Native *g, ncOp op, uint32_t reg, ncInstr *memory) {
+    uint32_t i      = op == NC_STORE ? ncEmit(g, op, NC_NONE, reg, memory->c) : ncEmit(g, op, reg, NC_NONE, memory->c);
+    g->code[i].base = memory->base;
+    g->code[i].imm  = memory->imm;
+    return i;
+}
+
+// Take a new virtual register
+uint32_t ncRegister(Native *g, ncClass class) {
+    if (g->registers == g->registerCapacity) {
+        g->registerCapacity = g->registerCapacity ? g->registerCapacity * 2 : 64;
+        g->classes          = (uint8_t *)realloc(g->classes, g->registerCapacity * sizeof(uint8_t));
+        g->variables        = (bool *)realloc(g->variables, g->registerCapacity * sizeof(bool));
+    }
+
+    g->classes[g->registers]   = class;
+    g->variables[g->registers] = false;
+
+    return g->registers++;
+}
+
+// Take a new label
+uint32_t ncLabel(Native *g) {
+    return g->labels++;
+}
+
+// Add a real constant to the program, returns its index
+uint32_t ncConstant(Native *g, double value) {
+    for (uint32_t i = 0; i < g->constantSize; i++) {
+        if (memcmp(&g->constants[i], &value, sizeof(double)) == 0) {
+            return i;
+        }
+    }
+
+    g->constants = (double *)astGrowArray(g->constants, g->constantSize, &g->constantCapacity, sizeof(double));
+    g->constants[g->constantSize] = value;
+
+    return g->constantSize++;
+}
+
+// Type id of a variable, the result type for a function symbol
+uint32_t ncTypeOf(Native *g, uint32_t symbol) {
+    sySymbol *s = &g->types->symbols->symbols[symbol];
+    return s->kind == SY_FUNCTION ? tySignatureOf(g->types, s->typeId)->result : tyOfTypeExpr(s->type);
+}
+
+// Index of the function a variable belongs to, a function symbol stands for its result, which belongs to itself
+uint32_t ncOwnerOf(Native *g, uint32_t symbol) {
+    sySymbol *s = &g->types->symbols->symbols[symbol];
+
+    if (s->kind == SY_FUNCTION) {
+        return g->slots[symbol];
+    }
+    return s->scope ? g->slots[s->scope->identifier->symbol] : 0;
+}
+
+// Check if an expression is an integer, char or boolean literal that fits an instruction, and get its value
+bool ncIsImmediate(astExpression *e, int64_t *value) {
+    return ncIsConstant(e, value) && *value >= INT32_MIN && *value <= INT32_MAX;
+}
+
+// Check if an expression is an integer, char or boolean literal of any width, and get its value, a negated integer
+// literal counts since negating it can't stop the program
+bool ncIsConstant(astExpression *e, int64_t *value) {
+    astPrefixExpr *prefix = (astPrefixExpr *)e;
+
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            *value = ((astIntegerExpr *)e)->value;
+            break;
+        case EV_PREFIX:
+            if (prefix->token->type != MINUS || evKindOf(prefix->right) != EV_INTEGER) {
+                return false;
+            }
+            *value = (int64_t)(0 - (uint64_t)((astIntegerExpr *)prefix->right)->value);
+            break;
+        case EV_CHAR:
+            *value = (unsigned char)((astCharExpr *)e)->value;
+            break;
+        case EV_BOOLEAN:
+            *value = ((astBooleanExpr *)e)->value;
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+// Report a program the generator can't write, only the first problem is reported
+void ncError(Native *g, char *msg) {
+    if (g->failed) {
+        return;
+    }
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": %s", g->line, msg);
+    eAdd(g->errors, error);
+
+    g->failed = true;
+}
+
+//
+// Register allocation
+//
+
+// Order intervals by their first position
+int ncCompareIntervals(const void *a, const void *b) {
+    uint32_t left  = ((ncInterval *)a)->start;
+    uint32_t right = ((ncInterval *)b)->start;
+    return (left > right) - (left < right);
+}
+
+// Map the virtual registers of the function being lowered to machine registers and spill slots
+// Live ranges come from a liveness analysis over the basic blocks, each one a single interval from the first to the
+// last position where the register is live, and a linear scan hands out the registers in order of the first position
+void ncAllocate(Native *g) {
+    uint32_t n     = g->codeSize;
+    uint32_t regs  = g->registers;
+    uint32_t words = (regs + 63) / 64;
+
+    g->locations = (int32_t *)realloc(g->locations, (regs + 1) * sizeof(int32_t));
+    g->spills    = 0;
+    g->saved     = 0;
+
+    // Basic blocks, each label starts one and each jump ends one
+    uint32_t *blockStart = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+    uint32_t *blockOf    = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+    uint32_t *labelBlock = (uint32_t *)calloc(g->labels + 1, sizeof(uint32_t));
+    uint32_t  blocks     = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t previous = i ? g->code[i - 1].op : NC_JUMP;
+        if (i == 0 || g->code[i].op == NC_LABEL || previous == NC_JUMP || previous == NC_BRANCH ||
+            previous == NC_RET || previous == NC_EXIT) {
+            blockStart[blocks++] = i;
+        }
+        blockOf[i] = blocks - 1;
+        if (g->code[i].op == NC_LABEL) {
+            labelBlock[g->code[i].a] = blocks - 1;
+        }
+    }
+    blockStart[blocks] = n;
+
+    // Liveness, iterated backwards until nothing changes
+    uint64_t *use = (uint64_t *)calloc((size_t)blocks * words + 1, sizeof(uint64_t));
+    uint64_t *def = (uint64_t *)calloc((size_t)blocks * words + 1, sizeof(uint64_t));
+    uint64_t *in  = (uint64_t *)calloc((size_t)blocks * words + 1, sizeof(uint64_t));
+    uint64_t *out = (uint64_t *)calloc((size_t)blocks * words + 1, sizeof(uint64_t));
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (uint32_t i = blockStart[b]; i < blockStart[b + 1]; i++) {
+            uint32_t uses[3];
+            uint32_t count = ncUses(&g->code[i], uses);
+            for (uint32_t k = 0; k < count; k++) {
+                uint32_t v = uses[k];
+                if (!(def[b * words + v / 64] & (1ull << (v % 64)))) {
+                    use[b * words + v / 64] |= 1ull << (v % 64);
+                }
+            }
+
+            uint32_t v = ncDefines(&g->code[i]);
+            if (v != NC_NONE) {
+                def[b * words + v / 64] |= 1ull << (v % 64);
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint32_t b = blocks; b-- > 0;) {
+            ncInstr *last = &g->code[blockStart[b + 1] - 1];
+
+            uint32_t successors[2];
+            uint32_t count = 0;
+            if (last->op == NC_JUMP || last->op == NC_BRANCH) {
+                successors[count++] = labelBlock[last->a];
+            }
+            if (last->op != NC_JUMP && last->op != NC_RET && last->op != NC_EXIT && b + 1 < blocks) {
+                successors[count++] = b + 1;
+            }
+
+            for (uint32_t w = 0; w < words; w++) {
+                uint64_t live = 0;
+                for (uint32_t k = 0; k < count; k++) {
+                    live |= in[successors[k] * words + w];
+                }
+
+                uint64_t entry = use[b * words + w] | (live & ~def[b * words + w]);
+                if (entry != in[b * words + w]) {
+                    changed = true;
+                }
+                out[b * words + w] = live;
+                in[b * words + w]  = entry;
+            }
+        }
+    }
+
+    // Intervals, from the first to the last position each register is live at
+    ncInterval *intervals = (ncInterval *)malloc((regs + 1) * sizeof(ncInterval));
+    for (uint32_t v = 0; v < regs; v++) {
+        intervals[v].reg   = v;
+        intervals[v].start = UINT32_MAX;
+        intervals[v].end   = 0;
+        intervals[v].call  = false;
+    }
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (uint32_t v = 0; v < regs; v++) {
+            uint64_t bit = 1ull << (v % 64);
+            if (in[b * words + v / 64] & bit) {
+                intervals[v].start = intervals[v].start < blockStart[b] ? intervals[v].start : blockStart[b];
+                intervals[v].end   = intervals[v].end > blockStart[b] ? intervals[v].end : blockStart[b];
+            }
+            if (out[b * words + v / 64] & bit) {
+                uint32_t last      = blockStart[b + 1] - 1;
+                intervals[v].start = intervals[v].start < last ? intervals[v].start : last;
+                intervals[v].end   = intervals[v].end > last ? intervals[v].end : last;
+            }
+        }
+    }
+
+    // Calls before each position, a call strictly inside an interval clobbers the registers not preserved
+    uint32_t *calls = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+    calls[0]        = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t uses[3];
+        uint32_t count = ncUses(&g->code[i], uses);
+        uint32_t v     = ncDefines(&g->code[i]);
+        for (uint32_t k = 0; k <= count; k++) {
+            uint32_t r = k < count ? uses[k] : v;
+            if (r == NC_NONE) {
+                continue;
+            }
+            intervals[r].start = intervals[r].start < i ? intervals[r].start : i;
+            intervals[r].end   = intervals[r].end > i ? intervals[r].end : i;
+        }
+        calls[i + 1] = calls[i] + (g->code[i].op == NC_CALL);
+    }
+
+    uint32_t size = 0;
+    for (uint32_t v = 0; v < regs; v++) {
+        g->locations[v] = 0;
+        if (intervals[v].start != UINT32_MAX) {
+            intervals[v].call = calls[intervals[v].end] > calls[intervals[v].start + 1];
+            intervals[size++] = intervals[v];
+        }
+    }
+    qsort(intervals, size, sizeof(ncInterval), ncCompareIntervals);
+
+    // Linear scan
+    ncInterval *active[NC_INT_REGS + NC_REAL_REGS];
+    uint32_t    activeSize = 0;
+    bool        taken[NC_INT_REGS + NC_REAL_REGS];
+    memset(taken, 0, sizeof(taken));
+
+    for (uint32_t i = 0; i < size; i++) {
+        ncInterval *current = &intervals[i];
+        bool        real    = g->classes[current->reg] == NC_REAL;
+
+        for (uint32_t k = 0; k < activeSize;) {
+            if (active[k]->end < current->start) {
+                int32_t location = g->locations[active[k]->reg];
+                taken[g->classes[active[k]->reg] == NC_REAL ? NC_INT_REGS + location : location] = false;
+                active[k]                                                                        = active[--activeSize];
+            } else {
+                k++;
+            }
+        }
+
+        // A range with a call inside takes a preserved register, the others try the scratch registers first
+        int32_t found = -1;
+        if (real) {
+            for (int32_t r = 0; r < NC_REAL_REGS && !current->call && found < 0; r++) {
+                found = taken[NC_INT_REGS + r] ? -1 : r;
+            }
+        } else {
+            for (int32_t k = 0; k < NC_INT_REGS && found < 0; k++) {
+                int32_t r = current->call ? k : (k + NC_SAVED_REGS) % NC_INT_REGS;
+                if (!taken[r] && (!current->call || r < NC_SAVED_REGS)) {
+                    found = r;
+                }
+            }
+        }
+
+        if (found < 0) {
+            // Out of registers, the range ending last gives its register up if it ends after this one
+            ncInterval *victim = NULL;
+            for (uint32_t k = 0; k < activeSize; k++) {
+                ncInterval *candidate = active[k];
+                int32_t     location  = g->locations[candidate->reg];
+                if ((g->classes[candidate->reg] == NC_REAL) != real || (current->call && location >= NC_SAVED_REGS)) {
+                    continue;
+                }
+                if (!victim || candidate->end > victim->end) {
+                    victim = candidate;
+                }
+            }
+
+            if (victim && victim->end > current->end && !(real && current->call)) {
+                found                      = g->locations[victim->reg];
+                g->locations[victim->reg] = -1 - (int32_t)g->spills++;
+                for (uint32_t k = 0; k < activeSize; k++) {
+                    if (active[k] == victim) {
+                        active[k] = active[--activeSize];
+                        break;
+                    }
+                }
+            } else {
+                g->locations[current->reg] = -1 - (int32_t)g->spills++;
+                continue;
+            }
+        }
+
+        g->locations[current->reg]                = found;
+        taken[real ? NC_INT_REGS + found : found] = true;
+        active[activeSize++]                      = current;
+        if (!real && found < NC_SAVED_REGS) {
+            g->saved |= 1u << found;
+        }
+    }
+
+    free(blockStart);
+    free(blockOf);
+    free(labelBlock);
+    free(use);
+    free(def);
+    free(in);
+    free(out);
+    free(intervals);
+    free(calls);
+}
+
+// Get the virtual registers an instruction reads, returns how many
+uint32_t ncUses(ncInstr *in, uint32_t *uses) {
+    uint32_t count = 0;
+
+    switch (in->op) {
+        case NC_LABEL:
+        case NC_JUMP:
+        case NC_LOADI:
+        case NC_LOADF:
+        case NC_FRAME:
+        case NC_CALL:
+        case NC_EXIT:
+            return 0;
+        case NC_LOAD:
+        case NC_STORE:
+        case NC_ADDR:
+            if (in->op == NC_STORE) {
+                uses[count++] = in->b;
+            }
+            if (in->c != NC_NONE && in->base != NC_GLOBAL) {
+                uses[count++] = in->c;
+            }
+            return count;
+        default:
+            if (in->b != NC_NONE) {
+                uses[count++] = in->b;
+            }
+            if (!in->immediate && in->c != NC_NONE) {
+                uses[count++] = in->c;
+            }
+            return count;
+    }
+}
+
+// Get the virtual register an instruction writes, NC_NONE if none
+uint32_t ncDefines(ncInstr *in) {
+    switch (in->op) {
+        case NC_LABEL:
+        case NC_JUMP:
+        case NC_BRANCH:
+        case NC_STORE:
+        case NC_ARG:
+        case NC_RET:
+        case NC_EXIT:
+            return NC_NONE;
+        default:
+            return in->a;
+    }
+}
+
+//
+// Assembly
+//
+
+// Lower, allocate and write a function, the program body is `main`
+void ncEmitFunction(Native *g, uint32_t index) {
+    ncLowerFunction(g, index);
+    ncAllocate(g);
+
+    ncFunction *f     = &g->functions[index];
+    uint32_t    saved = 0;
+    for (uint32_t r = 0; r < NC_SAVED_REGS; r++) {
+        saved += (g->saved >> r) & 1;
+    }
+
+    g->spillBase   = f->slots + saved;
+    uint32_t frame = 8 * (f->slots + saved + g->spills + g->outgoing);
+    frame          = (frame + 15) & ~15u;
+
+    char *savedNames[] = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+
+    fprintf(g->out, "\n# %s: %u instruções, %u registradores virtuais, %u derramados\n", f->name, g->codeSize,
+            g->registers, g->spills);
+    if (index == 0) {
+        fprintf(g->out, "\t.globl main\n\t.type main, @function\nmain:\n");
+    } else {
+        fprintf(g->out, "\t.type pf%u_%s, @function\npf%u_%s:\n", index, f->name, index, f->name);
+    }
+
+    fprintf(g->out, "\tpushq %%rbp\n\tmovq %%rsp, %%rbp\n");
+    if (frame) {
+        fprintf(g->out, "\tsubq $%u, %%rsp\n", frame);
+    }
+    for (uint32_t r = 0, k = 0; r < NC_SAVED_REGS; r++) {
+        if ((g->saved >> r) & 1) {
+            fprintf(g->out, "\tmovq %s, %d(%%rbp)\n", savedNames[r], -8 * (int32_t)(f->slots + ++k));
+        }
+    }
+
+    // The program body keeps its frame and calls from the stack of the program, `leave` switches back
+    if (index == 0) {
+        fprintf(g->out, "\tleaq .Lstack+%" PRIu64 "(%%rip), %%rsp\n", ncStackSize(g));
+        if (frame) {
+            fprintf(g->out, "\tsubq $%u, %%rsp\n", frame);
+        }
+    }
+    if (frame + 16 > g->largestFrame) {
+        g->largestFrame = frame + 16;
+    }
+
+    for (uint32_t i = 0; i < g->codeSize; i++) {
+        ncInstr *in = &g->code[i];
+
+        // A jump to the next instruction falls through
+        if (in->op == NC_JUMP && i + 1 < g->codeSize && g->code[i + 1].op == NC_LABEL && g->code[i + 1].a == in->a) {
+            continue;
+        }
+        ncEmitInstr(g, in);
+    }
+
+    fprintf(g->out, ".L%u_ret:\n", index);
+    for (uint32_t r = 0, k = 0; r < NC_SAVED_REGS; r++) {
+        if ((g->saved >> r) & 1) {
+            fprintf(g->out, "\tmovq %d(%%rbp), %s\n", -8 * (int32_t)(f->slots + ++k), savedNames[r]);
+        }
+    }
+    fprintf(g->out, "\tleave\n\tret\n");
+
+    // Runtime errors leave through stubs out of the way of the code that runs
+    for (uint32_t i = 0; i < g->stubSize; i++) {
+        fprintf(g->out, ".L%u_e%u:\n", index, i);
+        fprintf(g->out, "\tleaq .L%u_m%u(%%rip), %%rdi\n", index, i);
+        fprintf(g->out, "\tmovq stderr@GOTPCREL(%%rip), %%rsi\n\tmovq (%%rsi), %%rsi\n\tcall fputs@PLT\n");
+        fprintf(g->out, "\tmovl $1, %%edi\n\tcall exit@PLT\n");
+    }
+    if (g->stubSize) {
+        fprintf(g->out, "\t.section .rodata\n");
+        for (uint32_t i = 0; i < g->stubSize; i++) {
+            char msg[320];
+            snprintf(msg, sizeof(msg), "Linha %" PRIu64 ": Erro de execução em `%.127s`: %s\n", g->stubs[i].line,
+                     f->name, g->stubs[i].msg);
+            fprintf(g->out, ".L%u_m%u:\n\t.string ", index, i);
+            ncEmitString(g, msg);
+            fprintf(g->out, "\n");
+        }
+        fprintf(g->out, "\t.text\n");
+    }
+}
+
+// Write an instruction, memory operands and spilled registers go through rax, rcx, rdx, xmm0 and xmm1
+void ncEmitInstr(Native *g, ncInstr *in) {
+    char d[64], a[64], b[64], m[64];
+    bool real = in->a != NC_NONE && in->op != NC_LABEL && in->op != NC_JUMP && in->op != NC_BRANCH &&
+                g->classes[in->a] == NC_REAL;
+
+    if (in->a != NC_NONE && in->op != NC_LABEL && in->op != NC_JUMP && in->op != NC_BRANCH) {
+        ncLocation(g, in->a, d);
+    }
+    if (in->b != NC_NONE) {
+        ncLocation(g, in->b, a);
+    }
+
+    switch (in->op) {
+        case NC_LABEL:
+            fprintf(g->out, ".L%u_%u:\n", g->current, in->a);
+            break;
+        case NC_JUMP:
+            fprintf(g->out, "\tjmp .L%u_%u\n", g->current, in->a);
+            break;
+        case NC_BRANCH:
+            ncEmitCompare(g, in);
+            break;
+        case NC_MOVE:
+            ncEmitMove(g, a, d, real);
+            break;
+        case NC_LOADI:
+            if (in->imm >= INT32_MIN && in->imm <= INT32_MAX) {
+                fprintf(g->out, "\tmovq $%" PRId64 ", %s\n", in->imm, d);
+            } else {
+                fprintf(g->out, "\tmovabsq $%" PRId64 ", %%rax\n", in->imm);
+                ncEmitMove(g, "%rax", d, false);
+            }
+            break;
+        case NC_LOADF:
+            snprintf(m, sizeof(m), ".LC%" PRId64 "(%%rip)", in->imm);
+            ncEmitMove(g, m, d, true);
+            break;
+        case NC_ADD:
+            ncEmitBinary(g, in, "addq", true);
+            break;
+        case NC_SUB:
+            ncEmitBinary(g, in, "subq", false);
+            break;
+        case NC_MUL:
+            ncEmitBinary(g, in, "imulq", true);
+            break;
+        case NC_AND:
+            ncEmitBinary(g, in, "andq", true);
+            break;
+        case NC_OR:
+            ncEmitBinary(g, in, "orq", true);
+            break;
+        case NC_XOR:
+            ncEmitBinary(g, in, "xorq", true);
+            break;
+        case NC_FADD:
+            ncEmitBinary(g, in, "addsd", true);
+            break;
+        case NC_FSUB:
+            ncEmitBinary(g, in, "subsd", false);
+            break;
+        case NC_FMUL:
+            ncEmitBinary(g, in, "mulsd", true);
+            break;
+        case NC_FDIV:
+            if (!in->imm) {
+                ncOperand(g, in, b);
+                ncEmitMove(g, b, "%xmm1", true);
+                fprintf(g->out, "\tpxor %%xmm0, %%xmm0\n\tucomisd %%xmm0, %%xmm1\n\tjp 1f\n");
+                fprintf(g->out, "\tje .L%u_e%u\n1:\n", g->current, g->stubSize);
+                ncEmitStub(g, in->line, "divisão por zero");
+            }
+            ncEmitBinary(g, in, "divsd", false);
+            break;
+        case NC_DIV:
+        case NC_MOD: {
+            // idiv faults on the most negative integer divided by -1, which wraps around instead
+            char *result = in->op == NC_DIV ? "%rax" : "%rdx";
+            if (in->immediate && in->imm == 0) {
+                fprintf(g->out, "\tjmp .L%u_e%u\n", g->current, g->stubSize);
+                ncEmitStub(g, in->line, "divisão por zero");
+            } else if (in->immediate && in->imm == -1) {
+                ncEmitMove(g, a, "%rax", false);
+                fprintf(g->out, in->op == NC_DIV ? "\tnegq %%rax\n" : "\txorl %%eax, %%eax\n");
+                ncEmitMove(g, "%rax", d, false);
+            } else if (in->immediate) {
+                ncEmitMove(g, a, "%rax", false);
+                fprintf(g->out, "\tmovq $%" PRId64 ", %%rcx\n\tcqto\n\tidivq %%rcx\n", in->imm);
+                ncEmitMove(g, result, d, false);
+            } else {
+                ncOperand(g, in, b);
+                ncEmitMove(g, b, "%rcx", false);
+                fprintf(g->out, "\ttestq %%rcx, %%rcx\n\tje .L%u_e%u\n", g->current, g->stubSize);
+                ncEmitStub(g, in->line, "divisão por zero");
+                ncEmitMove(g, a, "%rax", false);
+                fprintf(g->out, "\tcmpq $-1, %%rcx\n\tjne 1f\n");
+                fprintf(g->out, in->op == NC_DIV ? "\tnegq %%rax\n" : "\txorl %%eax, %%eax\n");
+                fprintf(g->out, "\tjmp 2f\n1:\n\tcqto\n\tidivq %%rcx\n");
+                if (in->op == NC_MOD) {
+                    fprintf(g->out, "\tmovq %%rdx, %%rax\n");
+                }
+                fprintf(g->out, "2:\n");
+                ncEmitMove(g, "%rax", d, false);
+            }
+            break;
+        }
+        case NC_SHL:
+            ncEmitBinary(g, in, "shlq", false);
+            break;
+        case NC_SAR:
+            ncEmitBinary(g, in, "sarq", false);
+            break;
+        case NC_SHR:
+            ncEmitBinary(g, in, "shrq", false);
+            break;
+        case NC_MULHI:
+            fprintf(g->out, "\tmovabsq $%" PRId64 ", %%rax\n\timulq %s\n", in->imm, a);
+            ncEmitMove(g, "%rdx", d, false);
+            break;
+        case NC_NEG: {
+            char *t = d[0] == '%' ? d : "%rax";
+            ncEmitMove(g, a, t, false);
+            fprintf(g->out, "\tnegq %s\n", t);
+            ncEmitMove(g, t, d, false);
+            break;
+        }
+        case NC_FNEG: {
+            char *t = d[0] == '%' ? d : "%xmm0";
+            ncEmitMove(g, a, t, true);
+            fprintf(g->out, "\txorpd .LCsign(%%rip), %s\n", t);
+            ncEmitMove(g, t, d, true);
+            break;
+        }
+        case NC_CVT: {
+            char *t = d[0] == '%' ? d : "%xmm0";
+            fprintf(g->out, "\tpxor %s, %s\n\tcvtsi2sdq %s, %s\n", t, t, a, t);
+            ncEmitMove(g, t, d, true);
+            break;
+        }
+        case NC_SET:
+            ncEmitCompare(g, in);
+            break;
+        case NC_LOAD:
+            ncAddress(g, in, m);
+            ncEmitMove(g, m, d, real);
+            break;
+        case NC_STORE:
+            ncAddress(g, in, m);
+            ncEmitMove(g, a, m, g->classes[in->b] == NC_REAL);
+            break;
+        case NC_ADDR:
+            ncAddress(g, in, m);
+            fprintf(g->out, "\tleaq %s, %s\n", m, d[0] == '%' ? d : "%rax");
+            if (d[0] != '%') {
+                ncEmitMove(g, "%rax", d, false);
+            }
+            break;
+        case NC_FRAME:
+            if (in->imm == 0) {
+                ncEmitMove(g, "%rbp", d, false);
+                break;
+            }
+            fprintf(g->out, "\tmovq 16(%%rbp), %%rax\n");
+            for (int64_t k = 1; k < in->imm; k++) {
+                fprintf(g->out, "\tmovq 16(%%rax), %%rax\n");
+            }
+            ncEmitMove(g, "%rax", d, false);
+            break;
+        case NC_ARG:
+            snprintf(m, sizeof(m), "%" PRId64 "(%%rsp)", 8 * in->imm);
+            ncEmitMove(g, a, m, g->classes[in->b] == NC_REAL);
+            break;
+        case NC_CALL:
+            fprintf(g->out, "\tcmpq $%u, .Ldepth(%%rip)\n\tjae .L%u_e%u\n", NC_MAX_CALLS, g->current, g->stubSize);
+            ncEmitStub(g, in->line, "estouro de pilha");
+            fprintf(g->out, "\tincq .Ldepth(%%rip)\n\tcall pf%" PRId64 "_%s\n", in->imm, g->functions[in->imm].name);
+            fprintf(g->out, "\tdecq .Ldepth(%%rip)\n");
+            if (in->a != NC_NONE) {
+                ncEmitMove(g, real ? "%xmm0" : "%rax", d, real);
+            }
+            break;
+        case NC_RET:
+            if (in->b != NC_NONE) {
+                bool result = g->classes[in->b] == NC_REAL;
+                ncEmitMove(g, a, result ? "%xmm0" : "%rax", result);
+            }
+            if (in != &g->code[g->codeSize - 1]) {
+                fprintf(g->out, "\tjmp .L%u_ret\n", g->current);
+            }
+            break;
+        case NC_EXIT:
+            ncEmitGlobals(g);
+            fprintf(g->out, "\txorl %%eax, %%eax\n");
+            if (in != &g->code[g->codeSize - 1]) {
+                fprintf(g->out, "\tjmp .L%u_ret\n", g->current);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Write a move between registers and memory, through a scratch register when both ends are memory
+void ncEmitMove(Native *g, char *from, char *to, bool real) {
+    if (strcmp(from, to) == 0) {
+        return;
+    }
+
+    bool memory = from[0] != '%' && from[0] != '$';
+    if (memory && to[0] != '%') {
+        char *scratch = real ? "%xmm0" : "%rax";
+        fprintf(g->out, real ? "\tmovsd %s, %s\n" : "\tmovq %s, %s\n", from, scratch);
+        from = scratch;
+    }
+
+    if (!real) {
+        fprintf(g->out, "\tmovq %s, %s\n", from, to);
+    } else if (from[0] == '%' && to[0] == '%') {
+        fprintf(g->out, "\tmovapd %s, %s\n", from, to);
+    } else {
+        fprintf(g->out, "\tmovsd %s, %s\n", from, to);
+    }
+}
+
+// Write a two-operand instruction for a three-address one, computing in the destination when it's a register
+void ncEmitBinary(Native *g, ncInstr *in, char *op, bool commutative) {
+    char d[64], a[64], b[64];
+    bool real = g->classes[in->a] == NC_REAL;
+
+    ncLocation(g, in->a, d);
+    ncLocation(g, in->b, a);
+    ncOperand(g, in, b);
+
+    char *left  = a;
+    char *right = b;
+    if (commutative && !in->immediate && strcmp(d, b) == 0 && strcmp(d, a) != 0) {
+        left  = b;
+        right = a;
+    }
+
+    char *t = real ? "%xmm0" : "%rax";
+    if (d[0] == '%' && (strcmp(d, right) != 0 || strcmp(d, left) == 0)) {
+        t = d;
+    }
+
+    ncEmitMove(g, left, t, real);
+    fprintf(g->out, "\t%s %s, %s\n", op, right, t);
+    ncEmitMove(g, t, d, real);
+}
+
+// Write a comparison and the branch or flag it feeds, reals compare so that unordered operands are false
+void ncEmitCompare(Native *g, ncInstr *in) {
+    char a[64], b[64], target[64];
+
+    ncLocation(g, in->b, a);
+    ncOperand(g, in, b);
+    snprintf(target, sizeof(target), ".L%u_%u", g->current, in->a);
+
+    char *condition = NULL;
+    if (!in->real) {
+        char *left = a;
+        if (left[0] != '%' && b[0] != '%' && b[0] != '$') {
+            ncEmitMove(g, left, "%rcx", false);
+            left = "%rcx";
+        }
+        fprintf(g->out, "\tcmpq %s, %s\n", b, left);
+        condition = ncCondition(in->cc, in->op == NC_BRANCH && in->inverted);
+    } else {
+        // `a < b` is tested as `b > a`, so the condition is one the unordered flags fail
+        bool  swap   = in->cc == LT || in->cc == LTE;
+        char *first  = swap ? b : a;
+        char *second = swap ? a : b;
+        if (first[0] != '%') {
+            ncEmitMove(g, first, "%xmm0", true);
+            first = "%xmm0";
+        }
+        fprintf(g->out, "\tucomisd %s, %s\n", second, first);
+
+        bool strict = in->cc == LT || in->cc == GT;
+        bool negate = in->op == NC_BRANCH && in->inverted;
+        if (in->cc != EQ && in->cc != NOT_EQ) {
+            condition = strict ? (negate ? "be" : "a") : (negate ? "b" : "ae");
+        } else if (in->op == NC_BRANCH) {
+            // Equal is ZF set and PF clear
+            bool equal = (in->cc == EQ) != negate;
+            if (equal) {
+                fprintf(g->out, "\tjne 1f\n\tjnp %s\n1:\n", target);
+            } else {
+                fprintf(g->out, "\tjne %s\n\tjp %s\n", target, target);
+            }
+            return;
+        } else {
+            bool equal = in->cc == EQ;
+            fprintf(g->out, equal ? "\tsete %%al\n\tsetnp %%cl\n\tandb %%cl, %%al\n"
+                                  : "\tsetne %%al\n\tsetp %%cl\n\torb %%cl, %%al\n");
+        }
+    }
+
+    if (in->op == NC_BRANCH) {
+        fprintf(g->out, "\tj%s %s\n", condition, target);
+        return;
+    }
+
+    char d[64];
+    ncLocation(g, in->a, d);
+    if (condition) {
+        fprintf(g->out, "\tset%s %%al\n", condition);
+    }
+    fprintf(g->out, "\tmovzbl %%al, %%eax\n");
+    ncEmitMove(g, "%rax", d, false);
+}
+
+// Record the runtime error exit of a check just written
+void ncEmitStub(Native *g, uint64_t line, char *msg) {
+    g->stubs = (ncStub *)astGrowArray(g->stubs, g->stubSize, &g->stubCapacity, sizeof(ncStub));
+    g->stubs[g->stubSize++] = (ncStub){line, msg};
+}
+
+// Size of the stack the program runs on, room for the most calls in progress in the largest frame and for the C library
+uint64_t ncStackSize(Native *g) {
+    return ((uint64_t)NC_MAX_CALLS + 1) * g->largestFrame + (1u << 20);
+}
+
+// Write a string literal for the assembler, anything but printable ASCII is escaped
+void ncEmitString(Native *g, char *value) {
+    fputc('"', g->out);
+
+    for (unsigned char *ch = (unsigned char *)value; *ch; ch++) {
+        if (*ch == '"' || *ch == '\\') {
+            fprintf(g->out, "\\%c", *ch);
+        } else if (*ch >= 0x20 && *ch < 0x7F) {
+            fputc(*ch, g->out);
+        } else {
+            fprintf(g->out, "\\%03o", *ch);
+        }
+    }
+
+    fputc('"', g->out);
+}
+
+// Write the calls to printf that show the variables of the program, the same way `--run` does
+void ncEmitGlobals(Native *g) {
+    astBlockStmt *block = g->program->block;
+
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        if (evKindOf(block->statements[i]) != EV_VAR) {
+            continue;
+        }
+
+        astVarStmt *var = (astVarStmt *)block->statements[i];
+        for (uint32_t j = 0; j < var->size; j++) {
+            astDeclarationStmt *declaration = var->declarations[j];
+            for (uint32_t k = 0; declaration && k < declaration->size; k++) {
+                // The optimizer's temporaries aren't variables of the program
+                if (sySymbolOf(g->types->symbols, declaration->identifier[k])->temporary) {
+                    continue;
+                }
+
+                char    *name   = declaration->identifier[k]->value;
+                uint32_t symbol = declaration->identifier[k]->symbol;
+                uint32_t type   = tyOfTypeExpr(declaration->type);
+
+                char format[160];
+                switch (type) {
+                    case TY_REAL:
+                        snprintf(format, sizeof(format), "%s = %%.17g\n", name);
+                        fprintf(g->out, "\tmovsd pv_%s(%%rip), %%xmm0\n\tmovl $1, %%eax\n", name);
+                        break;
+                    case TY_BOOLEAN:
+                        snprintf(format, sizeof(format), "%s = %%s\n", name);
+                        fprintf(g->out, "\tleaq .Ltrue(%%rip), %%rsi\n\tleaq .Lfalse(%%rip), %%rax\n");
+                        fprintf(g->out, "\tcmpq $0, pv_%s(%%rip)\n\tcmove %%rax, %%rsi\n\txorl %%eax, %%eax\n", name);
+                        break;
+                    case TY_CHAR:
+                        snprintf(format, sizeof(format), "%s = '%%c'\n", name);
+                        fprintf(g->out, "\tmovq pv_%s(%%rip), %%rsi\n\txorl %%eax, %%eax\n", name);
+                        break;
+                    default:
+                        snprintf(format, sizeof(format), "%s = %%ld\n", name);
+                        fprintf(g->out, "\tmovq pv_%s(%%rip), %%rsi\n\txorl %%eax, %%eax\n", name);
+                        break;
+                }
+
+                fprintf(g->out, "\t.pushsection .rodata\n.Lv%u:\n\t.string ", symbol);
+                ncEmitString(g, format);
+                fprintf(g->out, "\n\t.popsection\n\tleaq .Lv%u(%%rip), %%rdi\n\tcall printf@PLT\n", symbol);
+            }
+        }
+    }
+}
+
+// Location of a virtual register, a machine register or a spill slot of the frame
+char *ncLocation(Native *g, uint32_t reg, char *buffer) {
+    char *intNames[]  = {"%rbx", "%r12", "%r13", "%r14", "%r15", "%rsi", "%rdi", "%r8", "%r9", "%r10", "%r11"};
+    char *realNames[] = {"%xmm2",  "%xmm3",  "%xmm4",  "%xmm5",  "%xmm6",  "%xmm7",  "%xmm8",
+                         "%xmm9",  "%xmm10", "%xmm11", "%xmm12", "%xmm13", "%xmm14", "%xmm15"};
+
+    int32_t location = g->locations[reg];
+    if (location >= 0) {
+        strcpy(buffer, g->classes[reg] == NC_REAL ? realNames[location] : intNames[location]);
+    } else {
+        sprintf(buffer, "%d(%%rbp)", -8 * (int32_t)(g->spillBase + (uint32_t)(-1 - location) + 1));
+    }
+
+    return buffer;
+}
+
+// Text of the last operand of an instruction, an immediate or a location
+char *ncOperand(Native *g, ncInstr *in, char *buffer) {
+    if (in->immediate) {
+        sprintf(buffer, "$%" PRId64, in->imm);
+        return buffer;
+    }
+    return ncLocation(g, in->c, buffer);
+}
+
+// Text of the memory operand of an instruction, a spilled frame or pointer is loaded into rcx first
+char *ncAddress(Native *g, ncInstr *in, char *buffer) {
+    if (in->base == NC_GLOBAL) {
+        sprintf(buffer, "pv_%s(%%rip)", g->types->symbols->symbols[in->imm].name);
+        return buffer;
+    }
+
+    char frame[64] = "%rbp";
+    if (in->c != NC_NONE) {
+        ncLocation(g, in->c, frame);
+        if (frame[0] != '%') {
+            fprintf(g->out, "\tmovq %s, %%rcx\n", frame);
+            strcpy(frame, "%rcx");
+        }
+    }
+
+    switch (in->base) {
+        case NC_SLOT:
+            sprintf(buffer, "%" PRId64 "(%s)", -8 * (in->imm + 1), frame);
+            break;
+        case NC_ARG_SLOT:
+            sprintf(buffer, "%" PRId64 "(%s)", 16 + 8 * in->imm, frame);
+            break;
+        default:
+            sprintf(buffer, "(%s)", frame);
+            break;
+    }
+
+    return buffer;
+}
+
+// Suffix of the jump or set instruction for an integer comparison
+char *ncCondition(uint8_t cc, bool inverted) {
+    switch (cc) {
+        case EQ:
+            return inverted ? "ne" : "e";
+        case NOT_EQ:
+            return inverted ? "e" : "ne";
+        case LT:
+            return inverted ? "ge" : "l";
+        case GT:
+            return inverted ? "le" : "g";
+        case LTE:
+            return inverted ? "g" : "le";
+        default:
+            return inverted ? "l" : "ge";
+    }
+}
\ No newline at end of file
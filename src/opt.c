@@ -0,0 +1,1277 @@
+#include "opt.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "error.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+#include "types.h"
+
+// Integer arithmetic wraps around like the virtual machine's
+#define OP_WRAP(x) ((int64_t)(uint64_t)(x))
+
+// Create an optimizer for a program the type checker accepted
+Optimizer *opNew(TypeChecker *types, astProgram *program) {
+    Optimizer *o = (Optimizer *)calloc(1, sizeof(Optimizer));
+    if (!o) {
+        return NULL;
+    }
+
+    o->types    = types;
+    o->program  = program;
+    o->warnings = eNew();
+
+    return o;
+}
+
+// Free the optimizer, the tree and the types are left alone
+void opFree(Optimizer *o) {
+    eFree(o->warnings);
+    free(o);
+}
+
+// Run the passes over the tree
+void opOptimize(Optimizer *o) {
+    o->nodes = opCount(o->program);
+
+    uint64_t start = pbNow();
+    opFoldBlock(o, o->program->block);
+    o->stats[OP_FOLD].time  = pbNow() - start;
+    o->stats[OP_FOLD].nodes = opCount(o->program);
+
+    start      = pbNow();
+    o->symbols = o->types->symbols->size;
+    o->shared  = (bool *)calloc(o->symbols, sizeof(bool));
+    o->killed  = (uint32_t *)calloc(o->symbols, sizeof(uint32_t));
+    if (o->shared && o->killed) {
+        opScanBlock(o, o->program->block, 0);
+        opHoistBlock(o, o->program->block, NULL, 0);
+    }
+    free(o->shared);
+    free(o->killed);
+    o->shared                = NULL;
+    o->killed                = NULL;
+    o->stats[OP_HOIST].time  = pbNow() - start;
+    o->stats[OP_HOIST].nodes = opCount(o->program);
+}
+
+// Count the nodes of a subtree
+uint64_t opCount(void *node) {
+    if (!node) {
+        return 0;
+    }
+
+    uint64_t count = 1;
+    switch (evKindOf(node)) {
+        case EV_PROGRAM: {
+            astProgram *program = (astProgram *)node;
+            count += opCount(program->identifier) + opCount(program->block);
+            break;
+        }
+        case EV_BLOCK: {
+            astBlockStmt *block = (astBlockStmt *)node;
+            for (uint32_t i = 0; i < block->size; i++) {
+                count += opCount(block->statements[i]);
+            }
+            break;
+        }
+        case EV_VAR: {
+            astVarStmt *var = (astVarStmt *)node;
+            for (uint32_t i = 0; i < var->size; i++) {
+                count += opCount(var->declarations[i]);
+            }
+            break;
+        }
+        case EV_DECLARATION: {
+            astDeclarationStmt *declaration = (astDeclarationStmt *)node;
+            count += declaration->size + opCount(declaration->type);
+            break;
+        }
+        case EV_FUNCTION: {
+            astFunctionStmt *function = (astFunctionStmt *)node;
+            count += opCount(function->identifier) + opCount(function->returnType) + opCount(function->block);
+            for (uint32_t i = 0; i < function->size; i++) {
+                count += opCount(function->parameters[i]);
+            }
+            break;
+        }
+        case EV_PARAMETER: {
+            astParameterStmt *parameter = (astParameterStmt *)node;
+            for (uint32_t i = 0; i < parameter->size; i++) {
+                count += opCount(parameter->declarations[i]);
+            }
+            break;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)node;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                count += opCount(beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)node;
+            count += opCount(conditional->condition) + opCount(conditional->consequence) +
+                     opCount(conditional->alternative);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)node;
+            count += opCount(loop->condition) + opCount(loop->body);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            count += opCount(((astExpressionStmt *)node)->expr);
+            break;
+        case EV_PREFIX:
+            count += opCount(((astPrefixExpr *)node)->right);
+            break;
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)node;
+            count += opCount(infix->left) + opCount(infix->right);
+            break;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)node;
+            count += opCount(assignment->identifier) + opCount(assignment->value);
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)node;
+            count += opCount(call->identifier);
+            for (uint32_t i = 0; i < call->size; i++) {
+                count += opCount(call->arguments[i]);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return count;
+}
+
+//
+// Constant folding
+//
+
+// Fold the statements of a block and of the functions declared in it
+void opFoldBlock(Optimizer *o, astBlockStmt *block) {
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (!s || evKindOf(s) == EV_VAR) {
+            continue;
+        }
+
+        if (evKindOf(s) == EV_FUNCTION) {
+            opFoldBlock(o, ((astFunctionStmt *)s)->block);
+        } else {
+            block->statements[i] = opFoldStatement(o, s);
+        }
+    }
+}
+
+/*
+Fold a statement, returns the statement that takes its place.
+An `if` on a constant condition becomes the branch it takes, and a `while` that never runs an empty begin-end. The
+branch left out is dropped without being folded, so a division by zero in it isn't reported.
+*/
+astStatement *opFoldStatement(Optimizer *o, astStatement *s) {
+    if (!s) {
+        return NULL;
+    }
+
+    opContext c;
+    bcValue   value;
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                beginEnd->statements[i] =
+                    (astExpressionStmt *)opFoldStatement(o, (astStatement *)beginEnd->statements[i]);
+            }
+            return s;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+
+            memset(&c, 0, sizeof(c));
+            conditional->condition = opFoldExpression(o, conditional->condition, &c);
+
+            if (evKindOf(conditional->condition) == EV_BOOLEAN && opIsLiteral(conditional->condition, &value)) {
+                astStatement *taken = value.i ? conditional->consequence : conditional->alternative;
+                if (value.i) {
+                    conditional->consequence = NULL;
+                } else {
+                    conditional->alternative = NULL;
+                }
+
+                astStatement *replacement = taken ? opFoldStatement(o, taken) : opEmpty(conditional->token);
+                conditional->free(conditional);
+                o->pruned++;
+                return replacement;
+            }
+
+            conditional->consequence = opFoldStatement(o, conditional->consequence);
+            conditional->alternative = opFoldStatement(o, conditional->alternative);
+            return s;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+
+            memset(&c, 0, sizeof(c));
+            loop->condition = opFoldExpression(o, loop->condition, &c);
+
+            if (evKindOf(loop->condition) == EV_BOOLEAN && opIsLiteral(loop->condition, &value) && !value.i) {
+                astStatement *replacement = opEmpty(loop->token);
+                loop->free(loop);
+                o->pruned++;
+                return replacement;
+            }
+
+            loop->body = opFoldStatement(o, loop->body);
+            return s;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *statement = (astExpressionStmt *)s;
+            if (statement->expr) {
+                memset(&c, 0, sizeof(c));
+                statement->expr = opFoldExpression(o, statement->expr, &c);
+            }
+            return s;
+        }
+        default:
+            return s;
+    }
+}
+
+// Fold an expression, returns the expression that takes its place and sets the lines of `c`
+astExpression *opFoldExpression(Optimizer *o, astExpression *e, opContext *c) {
+    c->before = 0;
+    c->after  = 0;
+
+    switch (evKindOf(e)) {
+        case EV_PREFIX:
+            return opFoldPrefix(o, (astPrefixExpr *)e, c);
+        case EV_INFIX:
+            return opFoldInfix(o, (astInfixExpr *)e, c);
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+
+            opContext value;
+            memset(&value, 0, sizeof(value));
+            assignment->value = opFoldExpression(o, assignment->value, &value);
+
+            c->before = value.after ? value.after : assignment->token->line;
+            c->after  = c->before;
+            return e;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            for (uint32_t i = 0; i < call->size; i++) {
+                opContext argument;
+                memset(&argument, 0, sizeof(argument));
+                call->arguments[i] = opFoldExpression(o, call->arguments[i], &argument);
+            }
+
+            // The line is set after the arguments, the ones they set don't reach past the call
+            c->before = call->identifier->token->line;
+            c->after  = c->before;
+            return e;
+        }
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(o->types->symbols, (astIdentifierExpr *)e);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                c->before = e->token->line;
+                c->after  = c->before;
+            }
+            return e;
+        }
+        default:
+            return e;
+    }
+}
+
+// Fold a prefix expression over a literal, and `not not x` and `-(-x)` into `x`
+astExpression *opFoldPrefix(Optimizer *o, astPrefixExpr *prefix, opContext *c) {
+    // The operator sets no line, its operand's passes through it
+    opContext right;
+    memset(&right, 0, sizeof(right));
+    right.consumed = c->consumed;
+    right.fallback = c->fallback;
+    prefix->right  = opFoldExpression(o, prefix->right, &right);
+
+    c->before = right.before;
+    c->after  = right.after;
+
+    bcValue value;
+    if (opIsLiteral(prefix->right, &value) && opReplaceable(c, 0)) {
+        if (prefix->token->type == NOT) {
+            value.i = !value.i;
+        } else if (prefix->type == TY_REAL) {
+            value.r = -value.r;
+        } else {
+            value.i = OP_WRAP(0 - (uint64_t)value.i);
+        }
+
+        astExpression *literal = opLiteral((astExpression *)prefix, prefix->type, value);
+        if (literal) {
+            prefix->free(prefix);
+            o->folded++;
+            c->after = 0;
+            return literal;
+        }
+    }
+
+    // Negating twice gives the operand back for integers that wrap as much as for reals
+    astExpression *inner = prefix->right;
+    if (evKindOf(inner) == EV_PREFIX && inner->token->type == prefix->token->type) {
+        astPrefixExpr *twice = (astPrefixExpr *)inner;
+        astExpression *x     = twice->right;
+        if (opReplaceable(c, right.after)) {
+            twice->right = NULL;
+            prefix->free(prefix);
+            o->simplified++;
+            return x;
+        }
+    }
+
+    return (astExpression *)prefix;
+}
+
+/*
+Fold an infix expression over two literals, or into one of its operands when it's an identity on it.
+The operands are folded first, the right one knowing the line the left one left, so the line the expression sets is
+the same after folding wherever a division needs it.
+*/
+astExpression *opFoldInfix(Optimizer *o, astInfixExpr *infix, opContext *c) {
+    TokenType op      = infix->token->type;
+    uint64_t  line    = infix->token->line;
+    bool      divides = op == DIV || op == MOD || op == SLASH;
+
+    opContext left;
+    memset(&left, 0, sizeof(left));
+    left.consumed = c->consumed || divides;
+    infix->left   = opFoldExpression(o, infix->left, &left);
+
+    opContext right;
+    memset(&right, 0, sizeof(right));
+    right.consumed = left.consumed;
+    right.fallback = left.after;
+    infix->right   = opFoldExpression(o, infix->right, &right);
+
+    c->before = right.before ? right.before : left.before ? left.before : line;
+
+    // Type the operands are compared or computed in
+    uint32_t type = TY_INTEGER;
+    if (infix->left->type == TY_REAL || infix->right->type == TY_REAL || op == SLASH) {
+        type = TY_REAL;
+    } else if (infix->left->type == TY_STRING || infix->right->type == TY_STRING || infix->type == TY_STRING) {
+        type = TY_STRING;
+    }
+
+    bcValue a, b, value;
+    if (divides && opIsZero(infix->right)) {
+        // The operator stays, only the runs that reach it stop there
+        char warning[320];
+        snprintf(warning, sizeof(warning), "Linha %" PRIu64 ": Divisão por zero no operador `%s`", line, infix->op);
+        eAdd(o->warnings, warning);
+    } else if (type != TY_STRING && opIsLiteral(infix->left, &a) && opIsLiteral(infix->right, &b) &&
+               opReplaceable(c, 0)) {
+        if (type == TY_REAL && infix->left->type != TY_REAL) {
+            a.r = (double)a.i;
+        }
+        if (type == TY_REAL && infix->right->type != TY_REAL) {
+            b.r = (double)b.i;
+        }
+
+        astExpression *literal = NULL;
+        if (opEvaluate(op, type, a, b, &value)) {
+            literal = opLiteral((astExpression *)infix, infix->type, value);
+        }
+        if (literal) {
+            infix->free(infix);
+            o->folded++;
+            c->after = 0;
+            return literal;
+        }
+    } else {
+        bool           side;
+        astExpression *x = opIdentity(infix, &side);
+        if (x && opReplaceable(c, side ? right.after : left.after)) {
+            if (side) {
+                infix->right = NULL;
+            } else {
+                infix->left = NULL;
+            }
+            infix->free(infix);
+            o->simplified++;
+            c->after = side ? right.after : left.after;
+            return x;
+        }
+    }
+
+    // An operand that no longer sets a line leaves it to the operator's own token, which takes the old one
+    if (!left.after && !right.after) {
+        infix->token->line = c->before;
+    }
+    c->after = right.after ? right.after : left.after ? left.after : infix->token->line;
+
+    return (astExpression *)infix;
+}
+
+/*
+Operand an infix expression is an identity on, NULL if none, `right` tells which one.
+x+0, 0+x, x-0, x*1, 1*x and x div 1 on integers, x*1, 1*x, x-0 and x/1 on reals, x and true, x or false and their
+mirrors on booleans. Adding zero to a real isn't one, -0 + 0 is 0.
+*/
+astExpression *opIdentity(astInfixExpr *infix, bool *right) {
+    astExpression *l = infix->left;
+    astExpression *r = infix->right;
+    astExpression *x = NULL;
+    bcValue        value;
+
+    switch (infix->token->type) {
+        case PLUS:
+            if (infix->type == TY_INTEGER && opIsZero(r)) {
+                x = l;
+            } else if (infix->type == TY_INTEGER && opIsZero(l)) {
+                x = r;
+            }
+            break;
+        case MINUS:
+            if (opIsZero(r) && !(evKindOf(r) == EV_FLOAT && signbit(((astFloatExpr *)r)->value))) {
+                x = l;
+            }
+            break;
+        case ASTERISK:
+            if (opIsOne(r)) {
+                x = l;
+            } else if (opIsOne(l)) {
+                x = r;
+            }
+            break;
+        case SLASH:
+        case DIV:
+            if (opIsOne(r)) {
+                x = l;
+            }
+            break;
+        case AND:
+        case OR: {
+            // `x and true` and `x or false` are x
+            bool neutral = infix->token->type == AND;
+            if (evKindOf(r) == EV_BOOLEAN && opIsLiteral(r, &value) && (bool)value.i == neutral) {
+                x = l;
+            } else if (evKindOf(l) == EV_BOOLEAN && opIsLiteral(l, &value) && (bool)value.i == neutral) {
+                x = r;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // An integer operand of a real operator would compute in integers without the operator
+    if (!x || x->type != infix->type) {
+        return NULL;
+    }
+
+    *right = x == r;
+    return x;
+}
+
+// Evaluate an operator over two values in the type it computes in, false if it would stop on a division by zero
+bool opEvaluate(TokenType op, uint32_t type, bcValue a, bcValue b, bcValue *result) {
+    if (type == TY_REAL) {
+        switch (op) {
+            case PLUS:
+                result->r = a.r + b.r;
+                return true;
+            case MINUS:
+                result->r = a.r - b.r;
+                return true;
+            case ASTERISK:
+                result->r = a.r * b.r;
+                return true;
+            case SLASH:
+                if (b.r == 0) {
+                    return false;
+                }
+                result->r = a.r / b.r;
+                return true;
+            case EQ:
+                result->i = a.r == b.r;
+                return true;
+            case NOT_EQ:
+                result->i = a.r != b.r;
+                return true;
+            case LT:
+                result->i = a.r < b.r;
+                return true;
+            case GT:
+                result->i = a.r > b.r;
+                return true;
+            case LTE:
+                result->i = a.r <= b.r;
+                return true;
+            case GTE:
+                result->i = a.r >= b.r;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    switch (op) {
+        case PLUS:
+            result->i = OP_WRAP((uint64_t)a.i + (uint64_t)b.i);
+            return true;
+        case MINUS:
+            result->i = OP_WRAP((uint64_t)a.i - (uint64_t)b.i);
+            return true;
+        case ASTERISK:
+            result->i = OP_WRAP((uint64_t)a.i * (uint64_t)b.i);
+            return true;
+        case DIV:
+            if (b.i == 0) {
+                return false;
+            }
+            result->i = b.i == -1 ? OP_WRAP(0 - (uint64_t)a.i) : a.i / b.i;
+            return true;
+        case MOD:
+            if (b.i == 0) {
+                return false;
+            }
+            result->i = b.i == -1 ? 0 : a.i % b.i;
+            return true;
+        case EQ:
+            result->i = a.i == b.i;
+            return true;
+        case NOT_EQ:
+            result->i = a.i != b.i;
+            return true;
+        case LT:
+            result->i = a.i < b.i;
+            return true;
+        case GT:
+            result->i = a.i > b.i;
+            return true;
+        case LTE:
+            result->i = a.i <= b.i;
+            return true;
+        case GTE:
+            result->i = a.i >= b.i;
+            return true;
+        case AND:
+            result->i = a.i & b.i;
+            return true;
+        case OR:
+            result->i = a.i | b.i;
+            return true;
+        default:
+            return false;
+    }
+}
+
+//
+// Loop-invariant code motion
+//
+
+// Scan the bodies of a block at `depth`, and of the functions declared in it one deeper
+void opScanBlock(Optimizer *o, astBlockStmt *block, uint32_t depth) {
+    for (uint32_t i = 0; block && i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (!s || evKindOf(s) == EV_VAR) {
+            continue;
+        }
+
+        if (evKindOf(s) == EV_FUNCTION) {
+            opScanBlock(o, ((astFunctionStmt *)s)->block, depth + 1);
+        } else {
+            opScanStatement(o, s, depth);
+        }
+    }
+}
+
+// Scan a statement of a body at `depth`
+void opScanStatement(Optimizer *o, astStatement *s, uint32_t depth) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                opScanStatement(o, (astStatement *)beginEnd->statements[i], depth);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            opScanExpression(o, conditional->condition, depth);
+            opScanStatement(o, conditional->consequence, depth);
+            opScanStatement(o, conditional->alternative, depth);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+            opScanExpression(o, loop->condition, depth);
+            opScanStatement(o, loop->body, depth);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            opScanExpression(o, ((astExpressionStmt *)s)->expr, depth);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+Scan an expression for the variables that are shared: the ones a body other than their own uses, the ones passed as a
+`var` argument and the reference parameters. A call can change the first two, and a write through a reference
+parameter any of them.
+*/
+void opScanExpression(Optimizer *o, astExpression *e, uint32_t depth) {
+    if (!e) {
+        return;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(o->types->symbols, identifier);
+            if ((s->kind == SY_VARIABLE || s->kind == SY_PARAMETER) && (s->depth != depth || s->reference)) {
+                o->shared[identifier->symbol] = true;
+            }
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call      = (astCallExpr *)e;
+            sySymbol    *s         = sySymbolOf(o->types->symbols, call->identifier);
+            tySignature *signature = tySignatureOf(o->types, s->typeId);
+
+            for (uint32_t i = 0; i < call->size; i++) {
+                if (signature->parameters[i] & TY_REFERENCE) {
+                    o->shared[((astIdentifierExpr *)call->arguments[i])->symbol] = true;
+                }
+                opScanExpression(o, call->arguments[i], depth);
+            }
+            break;
+        }
+        case EV_PREFIX:
+            opScanExpression(o, ((astPrefixExpr *)e)->right, depth);
+            break;
+        case EV_INFIX:
+            opScanExpression(o, ((astInfixExpr *)e)->left, depth);
+            opScanExpression(o, ((astInfixExpr *)e)->right, depth);
+            break;
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            sySymbol          *s          = sySymbolOf(o->types->symbols, assignment->identifier);
+
+            // The result of a function belongs to its body, one depth below the function's name
+            if ((s->kind == SY_FUNCTION ? s->depth + 1 : s->depth) != depth || s->reference) {
+                o->shared[assignment->identifier->symbol] = true;
+            }
+            opScanExpression(o, assignment->value, depth);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Hoist out of the loops of a block's body and of the functions declared in it, `scope` is the block's function
+void opHoistBlock(Optimizer *o, astBlockStmt *block, astFunctionStmt *scope, uint32_t depth) {
+    if (!block) {
+        return;
+    }
+
+    astBlockStmt    *outerBlock = o->block;
+    astVarStmt      *outerVar   = o->var;
+    astFunctionStmt *outerScope = o->scope;
+    uint32_t         outerDepth = o->depth;
+
+    o->block = block;
+    o->var   = NULL;
+    o->scope = scope;
+    o->depth = depth;
+    for (uint32_t i = 0; i < block->size && !o->var; i++) {
+        if (evKindOf(block->statements[i]) == EV_VAR) {
+            o->var = (astVarStmt *)block->statements[i];
+        }
+    }
+    astVarStmt *var = o->var;
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        astStatement *s = block->statements[i];
+        if (!s || evKindOf(s) == EV_VAR) {
+            continue;
+        }
+
+        if (evKindOf(s) == EV_FUNCTION) {
+            astFunctionStmt *function = (astFunctionStmt *)s;
+            opHoistBlock(o, function->block, function, depth + 1);
+        } else {
+            block->statements[i] = opHoistLoops(o, s);
+        }
+    }
+
+    // A block without variables gets a `var` for its temporaries, first so the registers are laid out before the body
+    if (o->var && !var) {
+        block->statements = (astStatement **)astGrowArray(block->statements, block->size, &block->capacity,
+                                                          sizeof(astStatement *));
+        memmove(block->statements + 1, block->statements, block->size * sizeof(astStatement *));
+        block->statements[0] = (astStatement *)o->var;
+        block->size++;
+    }
+
+    o->block = outerBlock;
+    o->var   = outerVar;
+    o->scope = outerScope;
+    o->depth = outerDepth;
+}
+
+// Find the loops of a statement, returns the statement that takes its place
+astStatement *opHoistLoops(Optimizer *o, astStatement *s) {
+    if (!s) {
+        return NULL;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                beginEnd->statements[i] =
+                    (astExpressionStmt *)opHoistLoops(o, (astStatement *)beginEnd->statements[i]);
+            }
+            return s;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            conditional->consequence        = opHoistLoops(o, conditional->consequence);
+            conditional->alternative        = opHoistLoops(o, conditional->alternative);
+            return s;
+        }
+        case EV_WHILE:
+            return opHoistLoop(o, (astWhileStmt *)s);
+        default:
+            return s;
+    }
+}
+
+/*
+Move the invariant expressions of a loop to temporaries, returns a begin-end that assigns them and then runs the loop,
+or the loop if none moved.
+An outer loop goes first, so an expression moves out of every loop it's invariant in, and then its inner loops move
+out what only varies in the outer one.
+*/
+astStatement *opHoistLoop(Optimizer *o, astWhileStmt *loop) {
+    o->loop++;
+    o->clobbers = false;
+    opKillStatement(o, (astStatement *)loop);
+
+    astBeginEndStmt *header = astBeginEndStmtNew(tNewToken(BEGIN, "begin"));
+    header->token->line     = loop->token->line;
+    header->token->column   = loop->token->column;
+
+    opContext c;
+    memset(&c, 0, sizeof(c));
+    loop->condition = opHoistExpression(o, loop->condition, &c, header);
+    opHoistStatement(o, loop->body, header);
+
+    loop->body = opHoistLoops(o, loop->body);
+
+    if (header->size == 0) {
+        header->free(header);
+        return (astStatement *)loop;
+    }
+
+    header->statements = (astExpressionStmt **)astGrowArray(header->statements, header->size, &header->capacity,
+                                                            sizeof(astExpressionStmt *));
+    header->statements[header->size++] = (astExpressionStmt *)loop;
+    o->loops++;
+
+    return (astStatement *)header;
+}
+
+// Hoist the invariant expressions of a statement of the loop to `header`, the ones of inner loops too
+void opHoistStatement(Optimizer *o, astStatement *s, astBeginEndStmt *header) {
+    if (!s) {
+        return;
+    }
+
+    opContext c;
+    memset(&c, 0, sizeof(c));
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                opHoistStatement(o, (astStatement *)beginEnd->statements[i], header);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            conditional->condition          = opHoistExpression(o, conditional->condition, &c, header);
+            opHoistStatement(o, conditional->consequence, header);
+            opHoistStatement(o, conditional->alternative, header);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+            loop->condition    = opHoistExpression(o, loop->condition, &c, header);
+            opHoistStatement(o, loop->body, header);
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *statement = (astExpressionStmt *)s;
+            if (statement->expr) {
+                statement->expr = opHoistExpression(o, statement->expr, &c, header);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*
+Hoist the largest invariant subexpressions of an expression, returns the expression that takes its place and sets the
+lines of `c` like opFoldExpression.
+A temporary sets no line, so an expression only moves where its line isn't needed, and the VM can't read a temporary
+after a call changed it, so it may be the left operand of one that calls.
+*/
+astExpression *opHoistExpression(Optimizer *o, astExpression *e, opContext *c, astBeginEndStmt *header) {
+    c->before = 0;
+    c->after  = 0;
+
+    // An operator on literals left unfolded is worth a temporary, a variable or a literal isn't
+    bcValue   value;
+    EventKind kind = evKindOf(e);
+    if ((kind == EV_INFIX || (kind == EV_PREFIX && !opIsLiteral(((astPrefixExpr *)e)->right, &value))) &&
+        e->type != TY_STRING && opInvariant(o, e)) {
+        c->before = opLine(o, e);
+
+        if (opReplaceable(c, 0)) {
+            astIdentifierExpr *temporary = opTemporary(o, e->type);
+
+            astAssignmentExpr *assignment = astAssignmentExprNew(tNewToken(ASSIGN, ":="));
+            assignment->token->line       = header->token->line;
+            assignment->token->column     = header->token->column;
+            assignment->identifier        = opUse(temporary, header->token);
+            assignment->value             = e;
+            assignment->type              = TY_VOID;
+
+            astExpressionStmt *statement = astExpressionStmtNew(assignment->identifier->token);
+            statement->expr              = (astExpression *)assignment;
+
+            header->statements = (astExpressionStmt **)astGrowArray(header->statements, header->size,
+                                                                    &header->capacity, sizeof(astExpressionStmt *));
+            header->statements[header->size++] = statement;
+            o->hoisted++;
+
+            return (astExpression *)opUse(temporary, e->token);
+        }
+    }
+
+    switch (kind) {
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)e;
+
+            opContext right;
+            memset(&right, 0, sizeof(right));
+            right.consumed = c->consumed;
+            right.fallback = c->fallback;
+            prefix->right  = opHoistExpression(o, prefix->right, &right, header);
+
+            c->before = right.before;
+            c->after  = right.after;
+            return e;
+        }
+        case EV_INFIX: {
+            astInfixExpr *infix   = (astInfixExpr *)e;
+            TokenType     op      = infix->token->type;
+            bool          divides = op == DIV || op == MOD || op == SLASH;
+
+            opContext left;
+            memset(&left, 0, sizeof(left));
+            left.consumed = c->consumed || divides;
+            infix->left   = opHoistExpression(o, infix->left, &left, header);
+
+            opContext right;
+            memset(&right, 0, sizeof(right));
+            right.consumed = left.consumed;
+            right.fallback = left.after;
+            infix->right   = opHoistExpression(o, infix->right, &right, header);
+
+            c->before = right.before ? right.before : left.before ? left.before : infix->token->line;
+            if (!left.after && !right.after) {
+                infix->token->line = c->before;
+            }
+            c->after = right.after ? right.after : left.after ? left.after : infix->token->line;
+            return e;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+
+            opContext value;
+            memset(&value, 0, sizeof(value));
+            assignment->value = opHoistExpression(o, assignment->value, &value, header);
+
+            c->before = value.after ? value.after : assignment->token->line;
+            c->after  = c->before;
+            return e;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            for (uint32_t i = 0; i < call->size; i++) {
+                opContext argument;
+                memset(&argument, 0, sizeof(argument));
+                call->arguments[i] = opHoistExpression(o, call->arguments[i], &argument, header);
+            }
+
+            c->before = call->identifier->token->line;
+            c->after  = c->before;
+            return e;
+        }
+        case EV_IDENTIFIER:
+            c->before = opLine(o, e);
+            c->after  = c->before;
+            return e;
+        default:
+            return e;
+    }
+}
+
+// Mark the variables a statement of the loop assigns, and whether it calls or writes a shared variable
+void opKillStatement(Optimizer *o, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                opKillStatement(o, (astStatement *)beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            opKillExpression(o, conditional->condition);
+            opKillStatement(o, conditional->consequence);
+            opKillStatement(o, conditional->alternative);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+            opKillExpression(o, loop->condition);
+            opKillStatement(o, loop->body);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            opKillExpression(o, ((astExpressionStmt *)s)->expr);
+            break;
+        default:
+            break;
+    }
+}
+
+// Mark the variables an expression of the loop assigns, and whether it calls or writes a shared variable
+void opKillExpression(Optimizer *o, astExpression *e) {
+    switch (evKindOf(e)) {
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            uint32_t           symbol     = assignment->identifier->symbol;
+            if (symbol < o->symbols) {
+                o->killed[symbol] = o->loop;
+                o->clobbers       = o->clobbers || o->shared[symbol];
+            }
+            opKillExpression(o, assignment->value);
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)e;
+            o->clobbers       = true;
+            for (uint32_t i = 0; i < call->size; i++) {
+                opKillExpression(o, call->arguments[i]);
+            }
+            break;
+        }
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(o->types->symbols, (astIdentifierExpr *)e);
+            if (s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE) {
+                o->clobbers = true;
+            }
+            break;
+        }
+        case EV_PREFIX:
+            opKillExpression(o, ((astPrefixExpr *)e)->right);
+            break;
+        case EV_INFIX:
+            opKillExpression(o, ((astInfixExpr *)e)->left);
+            opKillExpression(o, ((astInfixExpr *)e)->right);
+            break;
+        default:
+            break;
+    }
+}
+
+// Check if the loop being hoisted from can change a variable
+bool opKilled(Optimizer *o, uint32_t symbol) {
+    // Temporaries are only assigned before their loop
+    if (symbol >= o->symbols) {
+        return false;
+    }
+
+    return o->killed[symbol] == o->loop || (o->clobbers && o->shared[symbol]);
+}
+
+/*
+Check if an expression has the same value on every iteration of the loop and can't stop the program: it only reads
+variables the loop doesn't change, and only divides by literals other than zero.
+*/
+bool opInvariant(Optimizer *o, astExpression *e) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+        case EV_FLOAT:
+        case EV_BOOLEAN:
+        case EV_CHAR:
+        case EV_STRING:
+            return true;
+        case EV_IDENTIFIER: {
+            astIdentifierExpr *identifier = (astIdentifierExpr *)e;
+            sySymbol          *s          = sySymbolOf(o->types->symbols, identifier);
+            return (s->kind == SY_VARIABLE || s->kind == SY_PARAMETER) && !opKilled(o, identifier->symbol);
+        }
+        case EV_PREFIX:
+            return opInvariant(o, ((astPrefixExpr *)e)->right);
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)e;
+            TokenType     op    = infix->token->type;
+            EventKind     kind  = evKindOf(infix->right);
+            if ((op == DIV || op == MOD || op == SLASH) &&
+                ((kind != EV_INTEGER && kind != EV_FLOAT) || opIsZero(infix->right))) {
+                return false;
+            }
+            return opInvariant(o, infix->left) && opInvariant(o, infix->right);
+        }
+        default:
+            return false;
+    }
+}
+
+// Declare a temporary of a type in the function being hoisted from, returns its declaring identifier
+astIdentifierExpr *opTemporary(Optimizer *o, uint32_t type) {
+    // An identifier starts with a letter, so no declared name can be the same
+    char name[32];
+    snprintf(name, sizeof(name), "_t%" PRIu32, ++o->temporaries);
+
+    TokenType token   = INTEGER;
+    char     *literal = "integer";
+    if (type == TY_REAL) {
+        token   = REAL;
+        literal = "real";
+    } else if (type == TY_BOOLEAN) {
+        token   = BOOLEAN;
+        literal = "boolean";
+    } else if (type == TY_CHAR) {
+        token   = CHARACTER;
+        literal = "char";
+    }
+
+    astIdentifierExpr *identifier = astIdentifierExprNew(tNewToken(IDENT, name));
+    identifier->type              = type;
+
+    astTypeExpr *typeExpr = astTypeExprNew(tNewToken(token, literal));
+    typeExpr->type        = type;
+
+    astDeclarationStmt *declaration = astDeclarationStmtNew(identifier->token);
+    declaration->identifier         = (astIdentifierExpr **)malloc(sizeof(astIdentifierExpr *));
+    declaration->identifier[0]      = identifier;
+    declaration->size               = 1;
+    declaration->capacity           = 1;
+    declaration->type               = typeExpr;
+
+    if (!o->var) {
+        o->var = astVarStmtNew(tNewToken(VAR, "var"));
+    }
+    o->var->declarations = (astDeclarationStmt **)astGrowArray(o->var->declarations, o->var->size,
+                                                               &o->var->capacity, sizeof(astDeclarationStmt *));
+    o->var->declarations[o->var->size++] = declaration;
+
+    SymbolTable *t            = o->types->symbols;
+    uint32_t     symbol       = syTemporary(t, identifier, typeExpr, o->depth, o->scope);
+    t->symbols[symbol].typeId = type;
+
+    return identifier;
+}
+
+// Use of a temporary at a token's place
+astIdentifierExpr *opUse(astIdentifierExpr *temporary, Token *at) {
+    astIdentifierExpr *identifier = astIdentifierExprNew(tNewToken(IDENT, temporary->value));
+    identifier->symbol            = temporary->symbol;
+    identifier->type              = temporary->type;
+    identifier->token->line       = at->line;
+    identifier->token->column     = at->column;
+
+    return identifier;
+}
+
+// Line an expression sets for the runtime errors of the operators it's in, 0 if none, see opContext
+uint64_t opLine(Optimizer *o, astExpression *e) {
+    switch (evKindOf(e)) {
+        case EV_PREFIX:
+            return opLine(o, ((astPrefixExpr *)e)->right);
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)e;
+            uint64_t      right = opLine(o, infix->right);
+            uint64_t      left  = opLine(o, infix->left);
+            return right ? right : left ? left : infix->token->line;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)e;
+            uint64_t           value      = opLine(o, assignment->value);
+            return value ? value : assignment->token->line;
+        }
+        case EV_CALL:
+            return ((astCallExpr *)e)->identifier->token->line;
+        case EV_IDENTIFIER: {
+            sySymbol *s = sySymbolOf(o->types->symbols, (astIdentifierExpr *)e);
+            return s->kind == SY_FUNCTION || s->kind == SY_PROCEDURE ? e->token->line : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+//
+// Tree helpers
+//
+
+// Check if an expression is an integer, real, boolean or character literal and get its value
+bool opIsLiteral(astExpression *e, bcValue *value) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            value->i = ((astIntegerExpr *)e)->value;
+            return true;
+        case EV_FLOAT:
+            value->r = ((astFloatExpr *)e)->value;
+            return true;
+        case EV_BOOLEAN:
+            value->i = ((astBooleanExpr *)e)->value;
+            return true;
+        case EV_CHAR:
+            value->i = (unsigned char)((astCharExpr *)e)->value;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Check if an expression is a numeric literal equal to zero
+bool opIsZero(astExpression *e) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            return ((astIntegerExpr *)e)->value == 0;
+        case EV_FLOAT:
+            return ((astFloatExpr *)e)->value == 0;
+        default:
+            return false;
+    }
+}
+
+// Check if an expression is a numeric literal equal to one
+bool opIsOne(astExpression *e) {
+    switch (evKindOf(e)) {
+        case EV_INTEGER:
+            return ((astIntegerExpr *)e)->value == 1;
+        case EV_FLOAT:
+            return ((astFloatExpr *)e)->value == 1;
+        default:
+            return false;
+    }
+}
+
+/*
+Literal of a value, typed and on the line of the expression it replaces, NULL if the value has no literal.
+A real that isn't finite and the smallest integer have none, the C backend couldn't write them back.
+*/
+astExpression *opLiteral(astExpression *at, uint32_t type, bcValue value) {
+    char literal[64];
+    switch (type) {
+        case TY_INTEGER: {
+            if (value.i == INT64_MIN) {
+                return NULL;
+            }
+            snprintf(literal, sizeof(literal), "%" PRId64, value.i);
+
+            astIntegerExpr *integer = astIntegerExprNew(tNewToken(INT, literal));
+            integer->value          = value.i;
+            integer->type           = TY_INTEGER;
+            integer->token->line    = at->token->line;
+            integer->token->column  = at->token->column;
+            return (astExpression *)integer;
+        }
+        case TY_REAL: {
+            if (!isfinite(value.r)) {
+                return NULL;
+            }
+            snprintf(literal, sizeof(literal), "%.17g", value.r);
+            if (!strpbrk(literal, ".e")) {
+                strcat(literal, ".0");
+            }
+
+            astFloatExpr *real   = astFloatExprNew(tNewToken(FLOAT, literal));
+            real->value          = value.r;
+            real->type           = TY_REAL;
+            real->token->line    = at->token->line;
+            real->token->column  = at->token->column;
+            return (astExpression *)real;
+        }
+        case TY_BOOLEAN: {
+            astBooleanExpr *boolean = astBooleanExprNew(tNewToken(value.i ? TRUE : FALSE, value.i ? "true" : "false"));
+            boolean->value          = value.i != 0;
+            boolean->type           = TY_BOOLEAN;
+            boolean->token->line    = at->token->line;
+            boolean->token->column  = at->token->column;
+            return (astExpression *)boolean;
+        }
+        default:
+            return NULL;
+    }
+}
+
+// Empty begin-end on the line of a statement, what a statement that never runs is replaced by
+astStatement *opEmpty(Token *at) {
+    astBeginEndStmt *beginEnd = astBeginEndStmtNew(tNewToken(BEGIN, "begin"));
+    beginEnd->token->line     = at->line;
+    beginEnd->token->column   = at->column;
+
+    return (astStatement *)beginEnd;
+}
+
+/*
+Check if an expression may be replaced by one that sets the line `after`, 0 for a literal that sets none.
+The line must stay the same wherever a division reports it.
+*/
+bool opReplaceable(opContext *c, uint64_t after) {
+    return !c->consumed || after == c->before || (!after && (!c->fallback || c->fallback == c->before));
+}
\ No newline at end of file
@@ -1,11 +1,13 @@
 #include "parser.h"
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "ast.h"
+#include "budget.h"
 #include "error.h"
 #include "hash.h"
 #include "hashmap.h"
@@ -16,39 +18,71 @@
 //
 
 // Create a new parser
-Parser *pNew(Lexer *l) {
+Parser *pNew(Lexer *l) { return pNewWithSource(l, NULL, NULL); }
+
+// Create a new parser reading its tokens from a token source, e.g. a token pipeline
+Parser *pNewWithSource(Lexer *l, pTokenSource source, void *ctx) { return pNewShared(l, source, ctx, NULL); }
+
+// Create a parser that only holds the dispatch tables, to be shared through pNewShared
+Parser *pNewTables() { return pNewShared(NULL, NULL, NULL, NULL); }
+
+// Create a new parser, reusing the dispatch tables of `tables` when given, they're only read so threads can share them
+Parser *pNewShared(Lexer *l, pTokenSource source, void *ctx, Parser *tables) {
     Parser *p = (Parser *)malloc(sizeof(Parser));
     if (!p) {
         return NULL;
     }
 
-    p->l = l;
+    p->l           = l;
+    p->tokenSource = source;
+    p->sourceCtx   = ctx;
 
-    p->precedences = hmNew(hI32Hash, hI32Cmp, 32);
-    pInitPrecedences(p);
+    if (tables) {
+        p->precedences    = tables->precedences;
+        p->prefixParseFns = tables->prefixParseFns;
+        p->infixParseFns  = tables->infixParseFns;
+        p->ownsTables     = false;
+    } else {
+        p->precedences = hmNew(hI32Hash, hI32Cmp, 32);
+        pInitPrecedences(p);
 
-    p->prefixParseFns = hmNew(hI32Hash, hI32Cmp, 32);
-    pInitPrefixParseFns(p);
+        p->prefixParseFns = hmNew(hI32Hash, hI32Cmp, 32);
+        pInitPrefixParseFns(p);
 
-    p->infixParseFns = hmNew(hI32Hash, hI32Cmp, 32);
-    pInitInfixParseFns(p);
+        p->infixParseFns = hmNew(hI32Hash, hI32Cmp, 32);
+        pInitInfixParseFns(p);
+
+        p->ownsTables = true;
+    }
 
     p->errors = eNew();
 
     // Read two tokens, so curToken and peekToken are both set
-    pNextToken(p);
-    pNextToken(p);
+    p->curToken  = NULL;
+    p->peekToken = NULL;
+    if (l || source) {
+        pNextToken(p);
+        pNextToken(p);
+    }
 
     p->assignCounter = 0;
 
+    p->stmtSink   = NULL;
+    p->sinkCtx    = NULL;
+    p->program    = NULL;
+    p->blockDepth = 0;
+
     return p;
 }
 
-// Free the parser
+// Free the parser, and the token it read ahead, which no node owns
 void pFree(Parser *p) {
-    hmFree(p->precedences);
-    hmFree(p->prefixParseFns);
-    hmFree(p->infixParseFns);
+    tFreeToken(p->peekToken);
+    if (p->ownsTables) {
+        hmFree(p->precedences);
+        hmFree(p->prefixParseFns);
+        hmFree(p->infixParseFns);
+    }
     eFree(p->errors);
     free(p);
 }
@@ -114,6 +148,8 @@ void pInitInfixParseFns(Parser *p) {
     pRegisterInfix(p, GT, (pInfixParseFn)pParseInfixExpr);           // >
     pRegisterInfix(p, LTE, (pInfixParseFn)pParseInfixExpr);          // <=
     pRegisterInfix(p, GTE, (pInfixParseFn)pParseInfixExpr);          // >=
+    pRegisterInfix(p, AND, (pInfixParseFn)pParseInfixExpr);          // and
+    pRegisterInfix(p, OR, (pInfixParseFn)pParseInfixExpr);           // or
     pRegisterInfix(p, LPAREN, (pInfixParseFn)pParseCallExpr);        // ( // call function/procedure
 }
 
@@ -135,8 +171,13 @@ void pRegisterInfix(Parser *p, TokenType t, pInfixParseFn fn) {
 
 // Get the next token, setting the current and peek tokens
 void pNextToken(Parser *p) {
-    p->curToken  = p->peekToken;
-    p->peekToken = lNextToken(p->l);
+    p->curToken = p->peekToken;
+
+    if (p->tokenSource) {
+        p->peekToken = p->tokenSource(p->sourceCtx);
+    } else {
+        p->peekToken = lNextToken(p->l);
+    }
 }
 
 // Check if the current token is of a given type
@@ -185,14 +226,16 @@ astProgram *pParseProgram(Parser *p) {
         return NULL;
     }
 
+    p->program = program;
+
     if (!pExpectPeek(p, IDENT, "IDENT")) {
-        return NULL;
+        return pDropProgram(p, program);
     }
 
     program->identifier = pParseIdentifierExpr(p);
 
     if (!pExpectPeek(p, SEMICOLON, ";")) {
-        return NULL;
+        return pDropProgram(p, program);
     }
 
     tFreeToken(p->curToken);  // Free the unused `;` token
@@ -201,24 +244,55 @@ astProgram *pParseProgram(Parser *p) {
     program->block = pParseBlockStmt(p);
 
     if (!pExpectPeek(p, DOT, ".")) {
-        return NULL;
+        return pDropProgram(p, program);
     }
 
     tFreeToken(p->curToken);  // Free the unused `.` token
 
     if (!pExpectPeek(p, _EOF, "EOF")) {
-        return NULL;
+        return pDropProgram(p, program);
     }
 
-    tFreeToken(p->curToken);  // Free the unused `EOF` token
+    tFreeToken(p->curToken);   // Free the unused `EOF` token
+    tFreeToken(p->peekToken);  // Free the token read past the end
+    p->peekToken = NULL;
 
     return program;
 }
 
+// Free a program that couldn't be parsed, returns NULL
+astProgram *pDropProgram(Parser *p, astProgram *program) {
+    astProgramFree(program);
+    p->program = NULL;
+    return NULL;
+}
+
+// Free the current token when nothing took it, a parse function that fails frees the tokens it read
+void pDropToken(Parser *p) {
+    tFreeToken(p->curToken);
+    p->curToken = NULL;
+}
+
 //
 // Statement parsing functions
 //
 
+// Append a statement to a block, top-level statements go to the statement sink instead when there's one
+void pBlockAppend(Parser *p, astBlockStmt *b, astStatement *s) {
+    if (p->stmtSink && p->blockDepth == 1) {
+        // Statements parsed after an error may be incomplete, the output is discarded anyway
+        if (p->errors->size == 0) {
+            p->stmtSink(p->sinkCtx, p->program, s);
+        }
+        s->free(s);
+        return;
+    }
+
+    b->statements = (astStatement **)astGrowArray(b->statements, b->size, &b->capacity, sizeof(astStatement *));
+    b->statements[b->size] = s;
+    b->size++;
+}
+
 // Block statement parsing function
 astBlockStmt *pParseBlockStmt(Parser *p) {
     astBlockStmt *stmt = astBlockStmtNew(p->curToken);
@@ -226,19 +300,14 @@ astBlockStmt *pParseBlockStmt(Parser *p) {
         return NULL;
     }
 
+    p->blockDepth++;
+
     if (pPeekTokenIs(p, VAR)) {
         pNextToken(p);
         astStatement *s = (astStatement *)pParseVarStmt(p, true);
 
         if (s) {
-            if (stmt->size == 0 && !stmt->statements) {
-                stmt->statements = (astStatement **)malloc(sizeof(astStatement *));
-                stmt->size       = 1;
-            } else {
-                stmt->size++;
-                stmt->statements = (astStatement **)realloc(stmt->statements, sizeof(astStatement *) * stmt->size);
-            }
-            stmt->statements[stmt->size - 1] = s;
+            pBlockAppend(p, stmt, s);
         }
     }
 
@@ -247,14 +316,7 @@ astBlockStmt *pParseBlockStmt(Parser *p) {
         astStatement *s = (astStatement *)pParseFunctionStmt(p);
 
         if (s) {
-            if (stmt->size == 0 && !stmt->statements) {
-                stmt->statements = (astStatement **)malloc(sizeof(astStatement *));
-                stmt->size       = 1;
-            } else {
-                stmt->size++;
-                stmt->statements = (astStatement **)realloc(stmt->statements, sizeof(astStatement *) * stmt->size);
-            }
-            stmt->statements[stmt->size - 1] = s;
+            pBlockAppend(p, stmt, s);
         }
     }
 
@@ -263,21 +325,19 @@ astBlockStmt *pParseBlockStmt(Parser *p) {
         astStatement *s = (astStatement *)pParseBeginEndStmt(p);
 
         if (s) {
-            if (stmt->size == 0 && !stmt->statements) {
-                stmt->statements = (astStatement **)malloc(sizeof(astStatement *));
-                stmt->size       = 1;
-            } else {
-                stmt->size++;
-                stmt->statements = (astStatement **)realloc(stmt->statements, sizeof(astStatement *) * stmt->size);
-            }
-            stmt->statements[stmt->size - 1] = s;
+            pBlockAppend(p, stmt, s);
         }
     } else {
         pCustomError(p, "Bloco inválido, esperava-se `BEGIN`");
+        p->blockDepth--;
+        stmt->free(stmt);
         return NULL;
     }
 
+    p->blockDepth--;
+
     if (!pExpectPeek(p, END, "END")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -297,19 +357,15 @@ astVarStmt *pParseVarStmt(Parser *p, bool isGlobal) {
         pNextToken(p);
         astDeclarationStmt *decl = pParseDeclarationStmt(p);
         if (decl) {
-            if (stmt->size == 0 && !stmt->declarations) {
-                stmt->declarations = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *));
-                stmt->size         = 1;
-            } else {
-                stmt->size++;
-                stmt->declarations =
-                    (astDeclarationStmt **)realloc(stmt->declarations, sizeof(astDeclarationStmt *) * stmt->size);
-            }
-            stmt->declarations[stmt->size - 1] = decl;
+            stmt->declarations = (astDeclarationStmt **)astGrowArray(stmt->declarations, stmt->size, &stmt->capacity,
+                                                                     sizeof(astDeclarationStmt *));
+            stmt->declarations[stmt->size] = decl;
+            stmt->size++;
         }
 
         if (isGlobal) {
             if (!pExpectPeek(p, SEMICOLON, ";")) {
+                stmt->free(stmt);
                 return NULL;
             }
 
@@ -327,7 +383,8 @@ astDeclarationStmt *pParseDeclarationStmt(Parser *p) {
         return NULL;
     }
 
-    stmt->identifier    = (astIdentifierExpr **)malloc(sizeof(astIdentifierExpr *));
+    stmt->identifier =
+        (astIdentifierExpr **)astGrowArray(stmt->identifier, stmt->size, &stmt->capacity, sizeof(astIdentifierExpr *));
     stmt->identifier[0] = pParseIdentifierExpr(p);
     stmt->size          = 1;
 
@@ -336,12 +393,14 @@ astDeclarationStmt *pParseDeclarationStmt(Parser *p) {
         tFreeToken(p->curToken);  // Free the unused `,` token
         pNextToken(p);
 
+        stmt->identifier = (astIdentifierExpr **)astGrowArray(stmt->identifier, stmt->size, &stmt->capacity,
+                                                              sizeof(astIdentifierExpr *));
+        stmt->identifier[stmt->size] = pParseIdentifierExpr(p);
         stmt->size++;
-        stmt->identifier = (astIdentifierExpr **)realloc(stmt->identifier, sizeof(astIdentifierExpr *) * stmt->size);
-        stmt->identifier[stmt->size - 1] = pParseIdentifierExpr(p);
     }
 
     if (!pExpectPeek(p, COLON, ":")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -361,6 +420,7 @@ astFunctionStmt *pParseFunctionStmt(Parser *p) {
     }
 
     if (!pExpectPeek(p, IDENT, "IDENT")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -374,21 +434,18 @@ astFunctionStmt *pParseFunctionStmt(Parser *p) {
             astParameterStmt *param = pParseParameterStmt(p);
             if (!param) {
                 pCustomError(p, "Parâmetro inválido");
+                stmt->free(stmt);
                 return NULL;
             }
 
-            if (stmt->size == 0 && !stmt->parameters) {
-                stmt->parameters = (astParameterStmt **)malloc(sizeof(astParameterStmt *));
-                stmt->size       = 1;
-            } else {
-                stmt->size++;
-                stmt->parameters =
-                    (astParameterStmt **)realloc(stmt->parameters, sizeof(astParameterStmt *) * stmt->size);
-            }
-            stmt->parameters[stmt->size - 1] = param;
+            stmt->parameters = (astParameterStmt **)astGrowArray(stmt->parameters, stmt->size, &stmt->capacity,
+                                                                 sizeof(astParameterStmt *));
+            stmt->parameters[stmt->size] = param;
+            stmt->size++;
 
             if (!pPeekTokenIs(p, RPAREN)) {
                 if (!pExpectPeek(p, SEMICOLON, ";")) {
+                    stmt->free(stmt);
                     return NULL;
                 }
 
@@ -397,6 +454,7 @@ astFunctionStmt *pParseFunctionStmt(Parser *p) {
         }
 
         if (!pExpectPeek(p, RPAREN, ")")) {
+            stmt->free(stmt);
             return NULL;
         }
 
@@ -405,6 +463,7 @@ astFunctionStmt *pParseFunctionStmt(Parser *p) {
 
     if (stmt->token->type == FUNCTION) {
         if (!pExpectPeek(p, COLON, ":")) {
+            stmt->free(stmt);
             return NULL;
         }
 
@@ -415,13 +474,22 @@ astFunctionStmt *pParseFunctionStmt(Parser *p) {
     }
 
     if (!pExpectPeek(p, SEMICOLON, ";")) {
+        stmt->free(stmt);
         return NULL;
     }
 
     tFreeToken(p->curToken);  // Free the unused `;` token
 
+    // Functions nest through their blocks
+    if (!pbEnter(p->l->budget)) {
+        pBudgetError(p);
+        return stmt;
+    }
+
     stmt->block = pParseBlockStmt(p);
 
+    pbLeave(p->l->budget);
+
     return stmt;
 }
 
@@ -440,17 +508,20 @@ astParameterStmt *pParseParameterStmt(Parser *p) {
     }
 
     if (!pExpectPeek(p, IDENT, "IDENT")) {
+        stmt->free(stmt);
         return NULL;
     }
 
     astDeclarationStmt *decl = pParseDeclarationStmt(p);
     if (!decl) {
         pCustomError(p, "Declaração de parâmetro inválida");
+        stmt->free(stmt);
         return NULL;
     }
-    stmt->declarations                 = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *));
-    stmt->size                         = 1;
-    stmt->declarations[stmt->size - 1] = decl;
+    stmt->declarations = (astDeclarationStmt **)astGrowArray(stmt->declarations, stmt->size, &stmt->capacity,
+                                                             sizeof(astDeclarationStmt *));
+    stmt->declarations[0] = decl;
+    stmt->size            = 1;
 
     while (pPeekTokenIs(p, COMMA)) {
         pNextToken(p);
@@ -461,13 +532,14 @@ astParameterStmt *pParseParameterStmt(Parser *p) {
         decl = pParseDeclarationStmt(p);
         if (!decl) {
             pCustomError(p, "Declaração de parâmetro inválida");
+            stmt->free(stmt);
             return NULL;
         }
 
+        stmt->declarations = (astDeclarationStmt **)astGrowArray(stmt->declarations, stmt->size, &stmt->capacity,
+                                                                 sizeof(astDeclarationStmt *));
+        stmt->declarations[stmt->size] = decl;
         stmt->size++;
-        stmt->declarations =
-            (astDeclarationStmt **)realloc(stmt->declarations, sizeof(astDeclarationStmt *) * stmt->size);
-        stmt->declarations[stmt->size - 1] = decl;
     }
 
     return stmt;
@@ -480,19 +552,15 @@ astBeginEndStmt *pParseBeginEndStmt(Parser *p) {
         return NULL;
     }
 
-    while (!pPeekTokenIs(p, END)) {
+    // Stops at the end of the input too, the caller reports the missing `END`
+    while (!pPeekTokenIs(p, END) && !pPeekTokenIs(p, _EOF)) {
         pNextToken(p);
         astExpressionStmt *expr = pParseExpressionStmt(p);
         if (expr) {
-            if (stmt->size == 0 && !stmt->statements) {
-                stmt->statements = (astExpressionStmt **)malloc(sizeof(astExpressionStmt *));
-                stmt->size       = 1;
-            } else {
-                stmt->size++;
-                stmt->statements =
-                    (astExpressionStmt **)realloc(stmt->statements, sizeof(astExpressionStmt *) * stmt->size);
-            }
-            stmt->statements[stmt->size - 1] = expr;
+            stmt->statements = (astExpressionStmt **)astGrowArray(stmt->statements, stmt->size, &stmt->capacity,
+                                                                  sizeof(astExpressionStmt *));
+            stmt->statements[stmt->size] = expr;
+            stmt->size++;
         }
     }
 
@@ -510,6 +578,7 @@ astConditionalStmt *pParseConditionalStmt(Parser *p) {
     stmt->condition = pParseExpression(p, LOWEST);
 
     if (!pExpectPeek(p, THEN, "THEN")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -520,6 +589,7 @@ astConditionalStmt *pParseConditionalStmt(Parser *p) {
         stmt->consequence = (astStatement *)pParseBeginEndStmt(p);
 
         if (!pExpectPeek(p, END, "END")) {
+            stmt->free(stmt);
             return NULL;
         }
 
@@ -537,6 +607,7 @@ astConditionalStmt *pParseConditionalStmt(Parser *p) {
             stmt->alternative = (astStatement *)pParseBeginEndStmt(p);
 
             if (!pExpectPeek(p, END, "END")) {
+                stmt->free(stmt);
                 return NULL;
             }
 
@@ -560,6 +631,7 @@ astWhileStmt *pParseWhileStmt(Parser *p) {
     stmt->condition = pParseExpression(p, LOWEST);
 
     if (!pExpectPeek(p, DO, "DO")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -570,6 +642,7 @@ astWhileStmt *pParseWhileStmt(Parser *p) {
         stmt->body = (astStatement *)pParseBeginEndStmt(p);
 
         if (!pExpectPeek(p, END, "END")) {
+            stmt->free(stmt);
             return NULL;
         }
 
@@ -583,10 +656,20 @@ astWhileStmt *pParseWhileStmt(Parser *p) {
 
 // Expression statement parsing function
 astExpressionStmt *pParseExpressionStmt(Parser *p) {
-    if (pCurTokenIs(p, IF)) {
-        return (astExpressionStmt *)pParseConditionalStmt(p);
-    } else if (pCurTokenIs(p, WHILE)) {
-        return (astExpressionStmt *)pParseWhileStmt(p);
+    // Statements nest through conditionals and loops
+    if (pCurTokenIs(p, IF) || pCurTokenIs(p, WHILE)) {
+        if (!pbEnter(p->l->budget)) {
+            pBudgetError(p);
+            pDropToken(p);
+            return NULL;
+        }
+
+        astExpressionStmt *stmt = pCurTokenIs(p, IF) ? (astExpressionStmt *)pParseConditionalStmt(p)
+                                                     : (astExpressionStmt *)pParseWhileStmt(p);
+
+        pbLeave(p->l->budget);
+
+        return stmt;
     }
 
     astExpressionStmt *stmt = astExpressionStmtNew(p->curToken);
@@ -599,6 +682,7 @@ astExpressionStmt *pParseExpressionStmt(Parser *p) {
     stmt->expr = pParseExpression(p, LOWEST);
 
     if (!pExpectPeek(p, SEMICOLON, ";")) {
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -611,6 +695,7 @@ astExpressionStmt *pParseExpressionStmt(Parser *p) {
 
     if (p->assignCounter > 1) {
         pCustomError(p, "Multiplos operadores de atribuição em uma única expressão");
+        stmt->free(stmt);
         return NULL;
     }
 
@@ -623,9 +708,18 @@ astExpressionStmt *pParseExpressionStmt(Parser *p) {
 
 // Expression parsing function
 astExpression *pParseExpression(Parser *p, Precedence pr) {
+    // Every nested expression passes through here
+    if (!pbEnter(p->l->budget)) {
+        pBudgetError(p);
+        pDropToken(p);
+        return NULL;
+    }
+
     HashMapResult res = hmGet(p->prefixParseFns, &p->curToken->type);
     if (!res.ok) {
         pNoPrefixParseFnError(p, p->curToken);
+        pDropToken(p);
+        pbLeave(p->l->budget);
         return NULL;
     }
 
@@ -636,7 +730,7 @@ astExpression *pParseExpression(Parser *p, Precedence pr) {
     while (!pPeekTokenIs(p, SEMICOLON) && pr < pPeekPrecedence(p)) {
         res = hmGet(p->infixParseFns, &p->peekToken->type);
         if (!res.ok) {
-            return left;
+            break;
         }
 
         pInfixParseFn infix = (pInfixParseFn)res.data;
@@ -646,6 +740,8 @@ astExpression *pParseExpression(Parser *p, Precedence pr) {
         left = infix(p, left);
     }
 
+    pbLeave(p->l->budget);
+
     return left;
 }
 
@@ -680,14 +776,20 @@ astInfixExpr *pParseInfixExpr(Parser *p, astExpression *left) {
 
 // Grouped expression parsing function
 astExpression *pParseGroupedExpr(Parser *p) {
+    tFreeToken(p->curToken);  // Free the unused `(` token
     pNextToken(p);
 
     astExpression *expr = pParseExpression(p, LOWEST);
 
     if (!pExpectPeek(p, RPAREN, ")")) {
+        if (expr) {
+            expr->free(expr);
+        }
         return NULL;
     }
 
+    tFreeToken(p->curToken);  // Free the unused `)` token
+
     return expr;
 }
 
@@ -782,6 +884,7 @@ astTypeExpr *pParseTypeExpr(Parser *p) {
     if (!pCurTokenIs(p, INTEGER) && !pCurTokenIs(p, REAL) && !pCurTokenIs(p, BOOLEAN) && !pCurTokenIs(p, CHARACTER) &&
         !pCurTokenIs(p, STRING)) {
         pCustomError(p, "Tipo inválido");
+        pDropToken(p);
         return NULL;
     }
 
@@ -810,7 +913,8 @@ astCallExpr *pParseCallExpr(Parser *p, astExpression *function) {
 
     pNextToken(p);
 
-    expr->arguments    = (astExpression **)malloc(sizeof(astExpression *));
+    expr->arguments =
+        (astExpression **)astGrowArray(expr->arguments, expr->size, &expr->capacity, sizeof(astExpression *));
     expr->arguments[0] = pParseExpression(p, LOWEST);
     expr->size         = 1;
 
@@ -819,12 +923,14 @@ astCallExpr *pParseCallExpr(Parser *p, astExpression *function) {
         tFreeToken(p->curToken);  // Free the unused `,` token
         pNextToken(p);
 
+        expr->arguments =
+            (astExpression **)astGrowArray(expr->arguments, expr->size, &expr->capacity, sizeof(astExpression *));
+        expr->arguments[expr->size] = pParseExpression(p, LOWEST);
         expr->size++;
-        expr->arguments = (astExpression **)realloc(expr->arguments, sizeof(astExpression *) * expr->size);
-        expr->arguments[expr->size - 1] = pParseExpression(p, LOWEST);
     }
 
     if (!pExpectPeek(p, RPAREN, ")")) {
+        expr->free(expr);
         return NULL;
     }
 
@@ -833,30 +939,54 @@ astCallExpr *pParseCallExpr(Parser *p, astExpression *function) {
     return expr;
 }
 //
-// Error handling
+// Error handling, errors report the line of the peek token since the lexer may be further ahead
 //
 
 // Add a custom error to the parser error list
 void pCustomError(Parser *p, char *msg) {
-    char error[256];
-    sprintf(error, "Linha %d: %s", p->l->line, msg);
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": %s", p->peekToken->line, msg);
 
-    eAdd(p->errors, error);
+    pAddError(p, error);
 }
 
 // Add a peek error to the parser error list
 void pPeekError(Parser *p, char *str) {
-    char error[256];
-    sprintf(error, "Linha %d: Esperava-se que o próximo token fosse: `%s`, em vez disso, obteve: `%s`", p->l->line, str,
-            p->peekToken->literal);
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Esperava-se que o próximo token fosse: `%s`, em vez disso, obteve: `%.127s`",
+            p->peekToken->line, str, p->peekToken->literal);
 
-    eAdd(p->errors, error);
+    pAddError(p, error);
 }
 
 // Add a missing prefix parse function error to the parser error list
 void pNoPrefixParseFnError(Parser *p, Token *t) {
-    char error[256];
-    sprintf(error, "Linha %d: Nenhuma função de análise de prefixo encontrada para: `%s`", p->l->line, t->literal);
+    char error[320];
+    sprintf(error, "Linha %" PRIu64 ": Nenhuma função de análise de prefixo encontrada para: `%.127s`",
+            p->peekToken->line, t->literal);
+
+    pAddError(p, error);
+}
+
+// Add an error to the parser error list, once the parse is over budget only the error that says why is added
+void pAddError(Parser *p, char *error) {
+    ParseBudget *b = p->l ? p->l->budget : NULL;
+    if (b && b->status != PB_OK) {
+        pBudgetError(p);
+        return;
+    }
 
     eAdd(p->errors, error);
+
+    if (b) {
+        pbErrors(b, p->errors->size);
+    }
+}
+
+// Add the error that says why the parse stopped early, only the first time
+void pBudgetError(Parser *p) {
+    char error[160];
+    if (pbReport(p->l->budget, error, sizeof(error), p->peekToken->line)) {
+        eAdd(p->errors, error);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "pascalfront.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "error.h"
+#include "hash.h"
+#include "hashmap.h"
+#include "lexer.h"
+#include "parser.h"
+#include "shard.h"
+#include "token.h"
+
+// Tables every parse reads and none writes
+struct pfContext {
+    HashMap *keywords;  // Shared keyword table
+    Parser  *tables;    // Shared parser dispatch tables
+};
+
+// Diagnostics and tree of one source, the encoded tree is built the first time it's asked for
+struct pfResult {
+    eErrorList *errors;   // Diagnostics, the tree is only there when there are none
+    astProgram *program;  // Tree, NULL when the source has errors
+
+    shHeader *region;  // Encoded tree, NULL until serialised or walked
+};
+
+// Not exported, only pfWalk reaches it
+static void pfWalkNode(const void *region, uint64_t offset, uint32_t index, const pfVisitor *visitor, void *ctx);
+
+// Version of this header the library was built with
+uint32_t pfVersion(void) {
+    return PF_API_VERSION;
+}
+
+// Create a context, its tables are built once and shared by every parse that uses it
+pfContext *pfContextNew(void) {
+    pfContext *ctx = (pfContext *)malloc(sizeof(pfContext));
+    if (ctx == NULL) {
+        return NULL;
+    }
+
+    ctx->keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(ctx->keywords);
+
+    ctx->tables = pNewTables();
+
+    return ctx;
+}
+
+// Free the context, every parse that uses it must have returned
+void pfContextFree(pfContext *ctx) {
+    if (ctx) {
+        hmFree(ctx->keywords);
+        pFree(ctx->tables);
+        free(ctx);
+    }
+}
+
+// Parse `length` bytes of source, the source is copied and may be freed once this returns
+pfResult *pfParse(pfContext *ctx, const char *source, uint64_t length) {
+    pfResult *r = (pfResult *)malloc(sizeof(pfResult));
+    if (r == NULL) {
+        return NULL;
+    }
+
+    r->errors  = eNew();
+    r->program = NULL;
+    r->region  = NULL;
+
+    Lexer  *l  = lNewWithKeywords(strndup(source, length), ctx->keywords);
+    Parser *p  = pNewShared(l, NULL, NULL, ctx->tables);
+    r->program = pParseProgram(p);
+
+    if (p->errors->size > 0) {
+        eErrorList *errors = p->errors;
+        p->errors          = r->errors;
+        r->errors          = errors;
+
+        astProgramFree(r->program);
+        r->program = NULL;
+    }
+
+    pFree(p);
+    lFree(l);
+
+    return r;
+}
+
+// Free the result, with its tree and diagnostics
+void pfResultFree(pfResult *r) {
+    if (r) {
+        if (r->program) {
+            astProgramFree(r->program);
+        }
+        eFree(r->errors);
+        free(r->region);
+        free(r);
+    }
+}
+
+// Whether the source parsed without errors
+bool pfHasTree(pfResult *r) {
+    return r->program != NULL;
+}
+
+// Number of diagnostics
+uint32_t pfErrorCount(pfResult *r) {
+    return r->errors->size;
+}
+
+// Diagnostic at `index`, NULL past the last one, owned by the result
+const char *pfError(pfResult *r, uint32_t index) {
+    return index < r->errors->size ? r->errors->data[index] : NULL;
+}
+
+// The tree as text, the same text the analyzer writes, freed with pfStringFree
+char *pfToString(pfResult *r) {
+    return r->program ? astProgramToString(r->program) : NULL;
+}
+
+// Free a string returned by the library, it may not use the allocator of the caller
+void pfStringFree(char *str) {
+    free(str);
+}
+
+/*
+The tree encoded in one block with offsets instead of pointers, owned by the result.
+The block starts with a shard region header and the program node follows it, laid out as in shard.h.
+*/
+const void *pfSerialize(pfResult *r, uint64_t *length) {
+    if (!r->program) {
+        return NULL;
+    }
+
+    // Sized like the server's regions, and doubled until the tree fits
+    uint64_t capacity = sizeof(shHeader) + (1 << 20);
+    while (!r->region) {
+        shHeader *region = (shHeader *)malloc(capacity);
+        if (region == NULL) {
+            return NULL;
+        }
+
+        memset(region, 0, sizeof(shHeader));
+        region->used     = sizeof(shHeader);
+        region->capacity = capacity;
+
+        shEncode(region, r->program);
+
+        if (region->full) {
+            free(region);
+            capacity *= 2;
+        } else {
+            region->capacity = region->used;
+            r->region        = region;
+        }
+    }
+
+    if (length) {
+        *length = r->region->used;
+    }
+
+    return r->region;
+}
+
+// Walk the tree depth first, false when the source has no tree
+bool pfWalk(pfResult *r, const pfVisitor *visitor, void *ctx) {
+    if (!pfSerialize(r, NULL)) {
+        return false;
+    }
+
+    pfWalkNode(r->region, sizeof(shHeader), 0, visitor, ctx);
+    return true;
+}
+
+// Visit an encoded node and its children
+static void pfWalkNode(const void *region, uint64_t offset, uint32_t index, const pfVisitor *visitor, void *ctx) {
+    shNode *n = (shNode *)shAt((shHeader *)region, offset);
+
+    pfNode node;
+    node.kind     = (pfNodeKind)n->kind;
+    node.literal  = n->literal ? (const char *)shAt((shHeader *)region, n->literal) : NULL;
+    node.line     = n->line;
+    node.index    = index;
+    node.children = n->count;
+    node.flags    = n->flags;
+
+    if (!visitor->enter || visitor->enter(ctx, &node)) {
+        for (uint32_t i = 0; i < n->count; i++) {
+            if (n->children[i]) {
+                pfWalkNode(region, n->children[i], i, visitor, ctx);
+            }
+        }
+    }
+
+    if (visitor->exit) {
+        visitor->exit(ctx, &node);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "pipeline.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "lexer.h"
+#include "token.h"
+
+// Create a pipeline and start lexing, the capacity is rounded up to a power of two
+TokenPipeline *tpNew(Lexer *l, uint32_t capacity) {
+    TokenPipeline *tp = (TokenPipeline *)malloc(sizeof(TokenPipeline));
+    if (!tp) {
+        return NULL;
+    }
+
+    uint32_t slots = 2;
+    while (slots < capacity) {
+        slots *= 2;
+    }
+
+    tp->l        = l;
+    tp->ring     = (Token **)malloc(sizeof(Token *) * slots);
+    tp->capacity = slots;
+    tp->mask     = slots - 1;
+    tp->done     = false;
+
+    atomic_init(&tp->head, 0);
+    atomic_init(&tp->tail, 0);
+    atomic_init(&tp->stop, false);
+
+    if (pthread_create(&tp->thread, NULL, tpProduce, tp) != 0) {
+        free(tp->ring);
+        free(tp);
+        return NULL;
+    }
+
+    return tp;
+}
+
+// Stop the producer and free the tokens nobody consumed, the lexer is left to the caller
+void tpFree(TokenPipeline *tp) {
+    atomic_store_explicit(&tp->stop, true, memory_order_relaxed);
+    pthread_join(tp->thread, NULL);
+
+    uint64_t head = atomic_load_explicit(&tp->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&tp->tail, memory_order_relaxed);
+    for (uint64_t i = tail; i < head; i++) {
+        tFreeToken(tp->ring[i & tp->mask]);
+    }
+
+    free(tp->ring);
+    free(tp);
+}
+
+// Producer thread, lexes until EOF or until asked to stop
+void *tpProduce(void *arg) {
+    TokenPipeline *tp   = (TokenPipeline *)arg;
+    uint64_t       head = 0;
+
+    while (true) {
+        Token *tok = lNextToken(tp->l);
+
+        // Wait for a free slot
+        while (head - atomic_load_explicit(&tp->tail, memory_order_acquire) == tp->capacity) {
+            if (atomic_load_explicit(&tp->stop, memory_order_relaxed)) {
+                tFreeToken(tok);
+                return NULL;
+            }
+            sched_yield();
+        }
+
+        // The token belongs to the consumer as soon as it's published
+        bool eof = tok->type == _EOF;
+
+        tp->ring[head & tp->mask] = tok;
+        head++;
+        atomic_store_explicit(&tp->head, head, memory_order_release);
+
+        if (eof) {
+            return NULL;
+        }
+    }
+}
+
+// Consumer side, same contract as lNextToken, usable as a parser token source
+Token *tpNextToken(void *ctx) {
+    TokenPipeline *tp = (TokenPipeline *)ctx;
+
+    // The producer is finished, the lexer keeps returning EOF tokens
+    if (tp->done) {
+        return lNextToken(tp->l);
+    }
+
+    uint64_t tail = atomic_load_explicit(&tp->tail, memory_order_relaxed);
+
+    // Wait for a token
+    while (atomic_load_explicit(&tp->head, memory_order_acquire) == tail) {
+        sched_yield();
+    }
+
+    Token *tok = tp->ring[tail & tp->mask];
+    atomic_store_explicit(&tp->tail, tail + 1, memory_order_release);
+
+    if (tok->type == _EOF) {
+        tp->done = true;
+    }
+
+    return tok;
+}
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "reader.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif  // __linux__
+
+// Create a reader for a number of files, the caller fills in their paths and sizes before starting it
+SourceReader *srNew(uint32_t size, uint32_t window) {
+    SourceReader *r = (SourceReader *)malloc(sizeof(SourceReader));
+    if (!r) {
+        return NULL;
+    }
+
+    r->sources = (srSource *)calloc(size + 1, sizeof(srSource));
+    r->size    = size;
+    r->order   = NULL;
+    r->window  = window ? window : 1;
+    r->ahead   = 0;
+    r->stop    = false;
+    r->started = false;
+    r->uring   = false;
+
+    for (uint32_t i = 0; i < size; i++) {
+        r->sources[i].fd = -1;
+        atomic_init(&r->sources[i].state, SR_PENDING);
+    }
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->changed, NULL);
+
+    return r;
+}
+
+// Stop the reader thread and free the buffers nobody took
+void srFree(SourceReader *r) {
+    if (r->started) {
+        pthread_mutex_lock(&r->lock);
+        r->stop = true;
+        pthread_cond_broadcast(&r->changed);
+        pthread_mutex_unlock(&r->lock);
+
+        pthread_join(r->thread, NULL);
+    }
+
+#ifdef __linux__
+    if (r->uring) {
+        srRingFree(&r->ring);
+    }
+#endif  // __linux__
+
+    for (uint32_t i = 0; i < r->size; i++) {
+        free(r->sources[i].buffer);
+    }
+
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->changed);
+
+    free(r->order);
+    free(r->sources);
+    free(r);
+}
+
+// Start reading ahead, going through the files in `order`
+bool srStart(SourceReader *r, uint32_t *order) {
+    r->order = (uint32_t *)malloc(sizeof(uint32_t) * (r->size + 1));
+    memcpy(r->order, order, sizeof(uint32_t) * r->size);
+
+#ifdef __linux__
+    r->uring = srRingSetup(&r->ring, 64);
+#endif  // __linux__
+
+    r->started = pthread_create(&r->thread, NULL, srReadAhead, r) == 0;
+
+    return r->started;
+}
+
+// Take the contents of a file, waiting for the reader or reading it right away if the reader hasn't got to it yet
+char *srTake(SourceReader *r, uint32_t index) {
+    srSource *s = &r->sources[index];
+
+    int expected = SR_PENDING;
+    if (atomic_compare_exchange_strong(&s->state, &expected, SR_TAKEN)) {
+        srReadSync(s);
+    } else {
+        pthread_mutex_lock(&r->lock);
+        while (atomic_load(&s->state) != SR_READY) {
+            pthread_cond_wait(&r->changed, &r->lock);
+        }
+        atomic_store(&s->state, SR_TAKEN);
+        r->ahead--;
+        pthread_cond_broadcast(&r->changed);
+        pthread_mutex_unlock(&r->lock);
+    }
+
+    // The caller owns the buffer
+    char *buffer = s->buffer;
+    s->buffer    = NULL;
+
+    return buffer;
+}
+
+// Mark a file read by the reader thread as ready to be taken
+void srPublish(SourceReader *r, srSource *s) {
+    pthread_mutex_lock(&r->lock);
+    atomic_store(&s->state, SR_READY);
+    r->ahead++;
+    pthread_cond_broadcast(&r->changed);
+    pthread_mutex_unlock(&r->lock);
+}
+
+// Reader thread
+void *srReadAhead(void *arg) {
+    SourceReader *r = (SourceReader *)arg;
+
+#ifdef __linux__
+    if (r->uring) {
+        srReadAheadRing(r);
+        return NULL;
+    }
+#endif  // __linux__
+
+    srReadAheadSync(r);
+    return NULL;
+}
+
+// Read ahead with one pread sequence per file, used when io_uring isn't available
+void srReadAheadSync(SourceReader *r) {
+    for (uint32_t next = 0; next < r->size; next++) {
+        pthread_mutex_lock(&r->lock);
+        while (!r->stop && r->ahead >= r->window) {
+            pthread_cond_wait(&r->changed, &r->lock);
+        }
+        bool stop = r->stop;
+        pthread_mutex_unlock(&r->lock);
+
+        if (stop) {
+            return;
+        }
+
+        srSource *s        = &r->sources[r->order[next]];
+        int       expected = SR_PENDING;
+        if (!atomic_compare_exchange_strong(&s->state, &expected, SR_READING)) {
+            continue;
+        }
+
+        srReadSync(s);
+        srPublish(r, s);
+    }
+}
+
+// Open a file and allocate its buffer, the buffer is left NULL if the file can't be opened
+bool srOpen(srSource *s) {
+    s->fd = open(s->path, O_RDONLY | O_CLOEXEC);
+    if (s->fd < 0) {
+        return false;
+    }
+
+    s->buffer = (char *)malloc(s->size + 1);
+    s->read   = 0;
+    if (!s->buffer) {
+        close(s->fd);
+        s->fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+// Read a whole file on the calling thread
+void srReadSync(srSource *s) {
+    if (!srOpen(s)) {
+        return;
+    }
+
+    while (s->read < s->size) {
+        ssize_t n = pread(s->fd, s->buffer + s->read, s->size - s->read, s->read);
+        if (n < 0) {
+            free(s->buffer);
+            s->buffer = NULL;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        s->read += n;
+    }
+
+    if (s->buffer) {
+        s->buffer[s->read] = '\0';
+    }
+
+    close(s->fd);
+    s->fd = -1;
+}
+
+// Read a single file, NULL if it can't be read
+char *srReadFile(char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return NULL;
+    }
+
+    srSource s = {path, st.st_size, NULL, 0, -1, SR_READING};
+    srReadSync(&s);
+
+    return s.buffer;
+}
+
+#ifdef __linux__
+
+//
+// io_uring, driven through the raw system calls so there's no dependency on liburing
+//
+
+// Set up the rings, false if the kernel doesn't support io_uring or doesn't allow it
+bool srRingSetup(srRing *ring, uint32_t entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring->sqRing = NULL;
+    ring->cqRing = NULL;
+    ring->sqes   = NULL;
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return false;
+    }
+
+    // Reads need IORING_OP_READ, older kernels only have the vectored reads
+    size_t                 probeSize = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe     = (struct io_uring_probe *)calloc(1, probeSize);
+    bool supported = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+                     probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+
+    if (!supported) {
+        close(ring->fd);
+        return false;
+    }
+
+    ring->entries    = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize   = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_SQ_RING);
+    ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_CQ_RING);
+    ring->sqes   = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_SQES);
+
+    if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        srRingFree(ring);
+        return false;
+    }
+
+    char *sq      = (char *)ring->sqRing;
+    ring->sqHead  = (_Atomic uint32_t *)(sq + params.sq_off.head);
+    ring->sqTail  = (_Atomic uint32_t *)(sq + params.sq_off.tail);
+    ring->sqMask  = (uint32_t *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (uint32_t *)(sq + params.sq_off.array);
+
+    char *cq     = (char *)ring->cqRing;
+    ring->cqHead = (_Atomic uint32_t *)(cq + params.cq_off.head);
+    ring->cqTail = (_Atomic uint32_t *)(cq + params.cq_off.tail);
+    ring->cqMask = (uint32_t *)(cq + params.cq_off.ring_mask);
+    ring->cqes   = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+// Unmap the rings and close the ring descriptor
+void srRingFree(srRing *ring) {
+    if (ring->sqRing && ring->sqRing != MAP_FAILED) {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    if (ring->cqRing && ring->cqRing != MAP_FAILED) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqes && ring->sqes != MAP_FAILED) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+
+    close(ring->fd);
+}
+
+// Queue a read of the rest of a file, submitted with the next io_uring_enter
+void srRingSubmitRead(srRing *ring, srSource *s, uint32_t index) {
+    uint32_t tail = atomic_load_explicit(ring->sqTail, memory_order_relaxed);
+    uint32_t slot = tail & *ring->sqMask;
+
+    struct io_uring_sqe *sqe = &ring->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = s->fd;
+    sqe->addr      = (uint64_t)(uintptr_t)(s->buffer + s->read);
+    sqe->len       = (uint32_t)(s->size - s->read < UINT32_MAX ? s->size - s->read : UINT32_MAX);
+    sqe->off       = s->read;
+    sqe->user_data = index;
+
+    ring->sqArray[slot] = slot;
+    atomic_store_explicit(ring->sqTail, tail + 1, memory_order_release);
+}
+
+// Read ahead through io_uring, keeping up to a ring full of reads in flight
+void srReadAheadRing(SourceReader *r) {
+    srRing  *ring     = &r->ring;
+    uint32_t next     = 0;  // Next file in the read order
+    uint32_t inflight = 0;  // Reads submitted or queued
+    uint32_t queued   = 0;  // Reads queued since the last submission
+
+    while (true) {
+        // Wait for room in the window when there's nothing else to do
+        pthread_mutex_lock(&r->lock);
+        while (!r->stop && inflight == 0 && next < r->size && r->ahead >= r->window) {
+            pthread_cond_wait(&r->changed, &r->lock);
+        }
+        bool     stop  = r->stop;
+        uint32_t ahead = r->ahead;
+        pthread_mutex_unlock(&r->lock);
+
+        // Queue as many reads as the ring and the window allow
+        while (!stop && next < r->size && inflight < ring->entries && ahead + inflight < r->window) {
+            uint32_t  index    = r->order[next++];
+            srSource *s        = &r->sources[index];
+            int       expected = SR_PENDING;
+            if (!atomic_compare_exchange_strong(&s->state, &expected, SR_READING)) {
+                continue;
+            }
+
+            if (!srOpen(s) || s->size == 0) {
+                if (s->fd >= 0) {
+                    s->buffer[0] = '\0';
+                    close(s->fd);
+                    s->fd = -1;
+                }
+                srPublish(r, s);
+                ahead++;
+                continue;
+            }
+
+            srRingSubmitRead(ring, s, index);
+            inflight++;
+            queued++;
+        }
+
+        if (inflight == 0) {
+            if (stop || next >= r->size) {
+                return;
+            }
+            continue;
+        }
+
+        if (syscall(__NR_io_uring_enter, ring->fd, queued, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) {
+            // Interrupted, the queued reads are submitted on the next call
+            continue;
+        }
+        queued = 0;
+
+        // Reap the completions
+        uint32_t head = atomic_load_explicit(ring->cqHead, memory_order_relaxed);
+        uint32_t tail = atomic_load_explicit(ring->cqTail, memory_order_acquire);
+
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+            srSource            *s   = &r->sources[cqe->user_data];
+
+            if (cqe->res > 0) {
+                s->read += cqe->res;
+                if (s->read < s->size) {
+                    srRingSubmitRead(ring, s, cqe->user_data);
+                    queued++;
+                    continue;
+                }
+            }
+
+            close(s->fd);
+            s->fd = -1;
+
+            // Failed reads are retried with preads, which report the error by leaving the buffer NULL
+            if (cqe->res < 0) {
+                free(s->buffer);
+                s->buffer = NULL;
+                srReadSync(s);
+            } else {
+                s->buffer[s->read] = '\0';
+            }
+
+            srPublish(r, s);
+            inflight--;
+        }
+
+        atomic_store_explicit(ring->cqHead, head, memory_order_release);
+    }
+}
+
+#endif  // __linux__
\ No newline at end of file
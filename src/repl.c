@@ -2,16 +2,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ast.h"
+#include "bytecode.h"
 #include "error.h"
+#include "exec.h"
+#include "jit.h"
 #include "lexer.h"
+#include "opt.h"
 #include "parser.h"
+#include "types.h"
+#include "vm.h"
 
 #define PROMPT ">> "
 
-// Start the REPL
-void rStartRepl() {
+// Start the REPL, with `optimize` each program's tree is optimized before it runs
+void rStartRepl(bool optimize) {
     char    line[1024];
     Lexer  *l = lNew("");
     Parser *p;
@@ -29,7 +36,7 @@ void rStartRepl() {
         astProgram *prg = pParseProgram(p);
 
         if (p->errors->size != 0) {
-            for (uint16_t i = 0; i < p->errors->size; i++) {
+            for (uint32_t i = 0; i < p->errors->size; i++) {
                 printf("\t%s\n", p->errors->data[i]);
             }
 
@@ -39,6 +46,7 @@ void rStartRepl() {
         }
 
         printf("%s\n", astProgramToString(prg));
+        rRun(prg, optimize);
 
         astProgramFree(prg);
         pFree(p);
@@ -47,12 +55,93 @@ void rStartRepl() {
     rFreeLexerNoInput(l);
 }
 
+// Type check and run a program, then print its variables
+// The program starts straight from the tree, each node becomes a closure the first time it runs, so short programs
+// start without compiling anything. One that runs more than REPL_BUDGET loop iterations and calls is handed to rCompile
+// With `optimize` the tree is optimized first, both the executor and the compiler run the rewritten tree
+void rRun(astProgram *program, bool optimize) {
+    TypeChecker *y = tyNew();
+    tyCheck(y, program);
+
+    eErrorList *errors = y->errors;
+    Optimizer  *o      = NULL;
+    if (errors->size == 0 && optimize) {
+        o = opNew(y, program);
+        opOptimize(o);
+        for (uint32_t i = 0; i < o->warnings->size; i++) {
+            printf("\t%s\n", o->warnings->data[i]);
+        }
+    }
+
+    Executor *x = errors->size == 0 ? exNew(y, program) : NULL;
+    if (x) {
+        x->budget = REPL_BUDGET;
+        if (!exRun(x)) {
+            errors = x->errors;
+        }
+    }
+
+    if (errors->size == 0 && (!x || x->exhausted)) {
+        rCompile(y, program);
+    } else {
+        for (uint32_t i = 0; i < errors->size; i++) {
+            printf("\t%s\n", errors->data[i]);
+        }
+        if (x && errors->size == 0) {
+            exPrintGlobals(x, stdout);
+        }
+    }
+
+    if (x) {
+        exFree(x);
+    }
+    if (o) {
+        opFree(o);
+    }
+    tyFree(y);
+}
+
+// Compile a program and run it from the start, then print its variables
+// The program runs as machine code, or on the virtual machine when the host can't run it. A program shows nothing
+// until it ends, so starting over after the executor gave up can't be told apart from carrying on
+void rCompile(TypeChecker *y, astProgram *program) {
+    eErrorList *errors = y->errors;
+    bcProgram  *bc     = bcCompile(y, program, errors);
+    VM         *vm     = NULL;
+    if (bc) {
+        vm       = vmNew(bc);
+        Jit *jit = jitNew(bc);
+        if (jit ? !jitRun(jit, vm, 0) : !vmRun(vm)) {
+            errors = vm->errors;
+        }
+        if (jit) {
+            jitFree(jit);
+        }
+    }
+
+    for (uint32_t i = 0; i < errors->size; i++) {
+        printf("\t%s\n", errors->data[i]);
+    }
+    if (vm && errors->size == 0) {
+        vmPrintGlobals(vm, stdout);
+    }
+
+    if (vm) {
+        vmFree(vm);
+    }
+    if (bc) {
+        bcFree(bc);
+    }
+}
+
 // Create a new with a given input, no memory allocation
 void rLexerNewInput(Lexer *l, char *input) {
     l->input        = input;
+    l->length       = strlen(input);
     l->position     = 0;
     l->readPosition = 0;
     l->line         = 1;
+    l->lineStart    = 0;
     eFree(l->errors);
     l->errors = eNew();
 
@@ -0,0 +1,710 @@
+#include "server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#endif  // __linux__
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "checker.h"
+#include "error.h"
+#include "hash.h"
+#include "hashmap.h"
+#include "jit.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "shard.h"
+#include "token.h"
+#include "types.h"
+#include "vm.h"
+
+#ifdef __linux__
+
+// Create a server listening on a Unix socket, NULL if the socket can't be set up
+Server *svNew(char *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return NULL;
+    }
+
+    Server *s = (Server *)malloc(sizeof(Server));
+    if (!s) {
+        return NULL;
+    }
+
+    s->path           = strdup(path);
+    s->listener       = -1;
+    s->epoll          = -1;
+    s->signals        = -1;
+    s->connections    = NULL;
+    s->size           = 0;
+    s->capacity       = 0;
+    s->requests       = 0;
+    s->region         = NULL;
+    s->regionCapacity = 0;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    // A socket left behind by a server that didn't stop cleanly would make bind fail
+    unlink(path);
+
+    s->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->listener < 0 || bind(s->listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(s->listener, SOMAXCONN) != 0) {
+        if (s->listener >= 0) {
+            close(s->listener);
+        }
+        free(s->path);
+        free(s);
+        return NULL;
+    }
+
+    // Stop signals are read from the event loop, so nothing is interrupted halfway
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    s->signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    s->epoll   = epoll_create1(EPOLL_CLOEXEC);
+
+    struct epoll_event event;
+    event.events   = EPOLLIN;
+    event.data.ptr = &s->listener;
+    epoll_ctl(s->epoll, EPOLL_CTL_ADD, s->listener, &event);
+
+    event.data.ptr = &s->signals;
+    epoll_ctl(s->epoll, EPOLL_CTL_ADD, s->signals, &event);
+
+    s->keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(s->keywords);
+
+    s->tables = pNewTables();
+
+    s->limits.maxTokens   = SV_MAX_TOKENS;
+    s->limits.maxDepth    = SV_MAX_DEPTH;
+    s->limits.maxAstBytes = SV_MAX_AST_BYTES;
+    s->limits.maxErrors   = SV_MAX_ERRORS;
+    s->limits.deadline    = 0;
+    s->limits.cancel      = NULL;
+
+    return s;
+}
+
+// Close every connection, remove the socket and free the server
+void svFree(Server *s) {
+    while (s->size > 0) {
+        svClose(s, s->connections[s->size - 1]);
+    }
+
+    close(s->listener);
+    close(s->epoll);
+    close(s->signals);
+    unlink(s->path);
+
+    free(s->connections);
+    free(s->region);
+    free(s->path);
+    hmFree(s->keywords);
+    pFree(s->tables);
+    free(s);
+}
+
+// Serve connections until SIGINT or SIGTERM
+void svRun(Server *s) {
+    struct epoll_event events[64];
+    bool               running = true;
+
+    while (running) {
+        int ready = epoll_wait(s->epoll, events, 64, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            void *ptr = events[i].data.ptr;
+
+            if (ptr == &s->listener) {
+                svAccept(s);
+            } else if (ptr == &s->signals) {
+                running = false;
+            } else {
+                svConnection *c = (svConnection *)ptr;
+
+                if (c->writing && (events[i].events & EPOLLOUT)) {
+                    if (!svFlush(s, c)) {
+                        continue;
+                    }
+                    svProcess(s, c);
+                } else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    svRead(s, c);
+                }
+            }
+        }
+    }
+}
+
+// Accept every pending connection
+void svAccept(Server *s) {
+    int fd;
+    while ((fd = accept(s->listener, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        svConnection *c = (svConnection *)calloc(1, sizeof(svConnection));
+        if (!c) {
+            close(fd);
+            continue;
+        }
+
+        c->fd = fd;
+
+        s->connections = (svConnection **)astGrowArray(s->connections, s->size, &s->capacity, sizeof(svConnection *));
+        s->connections[s->size] = c;
+        c->index                = s->size;
+        s->size++;
+
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.ptr = c;
+        epoll_ctl(s->epoll, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+// Close a connection, dropping whatever it hadn't sent or received
+void svClose(Server *s, svConnection *c) {
+    epoll_ctl(s->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+
+    // The last connection takes the freed slot
+    s->size--;
+    s->connections[c->index]        = s->connections[s->size];
+    s->connections[c->index]->index = c->index;
+
+    free(c->input);
+    free(c->output);
+    free(c);
+}
+
+// Read what the client sent, then answer every complete request
+void svRead(Server *s, svConnection *c) {
+    while (true) {
+        if (c->inputCapacity - c->inputSize < 65536) {
+            c->inputCapacity = c->inputCapacity ? c->inputCapacity * 2 : 131072;
+            c->input         = (char *)realloc(c->input, c->inputCapacity);
+        }
+
+        ssize_t received = recv(c->fd, c->input + c->inputSize, c->inputCapacity - c->inputSize, 0);
+        if (received > 0) {
+            c->inputSize += received;
+            continue;
+        }
+
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+
+        // Closed by the client or broken
+        svClose(s, c);
+        return;
+    }
+
+    svProcess(s, c);
+}
+
+// Answer the complete requests in the input, until a response has to wait for the socket
+void svProcess(Server *s, svConnection *c) {
+    uint64_t handled = 0;
+
+    while (!c->writing && c->inputSize - handled >= sizeof(svRequest)) {
+        svRequest request;
+        memcpy(&request, c->input + handled, sizeof(svRequest));
+
+        // Nothing after a broken frame can be trusted
+        if (request.magic != SV_MAGIC || request.length > SV_MAX_REQUEST) {
+            svClose(s, c);
+            return;
+        }
+
+        if (c->inputSize - handled - sizeof(svRequest) < request.length) {
+            break;
+        }
+
+        svHandle(s, c, &request, c->input + handled + sizeof(svRequest));
+        handled += sizeof(svRequest) + request.length;
+        s->requests++;
+
+        if (!svFlush(s, c)) {
+            return;
+        }
+    }
+
+    memmove(c->input, c->input + handled, c->inputSize - handled);
+    c->inputSize -= handled;
+}
+
+// Send as much of the response as the socket takes, false if the connection was closed
+bool svFlush(Server *s, svConnection *c) {
+    while (c->sent < c->outputSize) {
+        ssize_t sent = send(c->fd, c->output + c->sent, c->outputSize - c->sent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            c->sent += sent;
+            continue;
+        }
+
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // No more requests are read until the client takes the response
+            if (!c->writing) {
+                struct epoll_event event;
+                event.events   = EPOLLOUT;
+                event.data.ptr = c;
+                epoll_ctl(s->epoll, EPOLL_CTL_MOD, c->fd, &event);
+                c->writing = true;
+            }
+            return true;
+        }
+
+        svClose(s, c);
+        return false;
+    }
+
+    if (c->writing) {
+        struct epoll_event event;
+        event.events   = EPOLLIN;
+        event.data.ptr = c;
+        epoll_ctl(s->epoll, EPOLL_CTL_MOD, c->fd, &event);
+        c->writing = false;
+    }
+
+    c->outputSize = 0;
+    c->sent       = 0;
+
+    return true;
+}
+
+// Parse the source of a request and build its response
+void svHandle(Server *s, svConnection *c, svRequest *request, char *payload) {
+    eErrorList *errors = eNew();
+
+    if (request->source > SV_BYTES || request->format > SV_RUN) {
+        eAdd(errors, "Pedido invalido, fonte ou formato desconhecido");
+        svRespond(c, SV_BAD_REQUEST, errors, NULL, 0);
+        eFree(errors);
+        return;
+    }
+
+    char *input = NULL;
+    if (request->source == SV_PATH) {
+        char *path = strndup(payload, request->length);
+        input      = srReadFile(path);
+        free(path);
+    } else {
+        input = strndup(payload, request->length);
+    }
+
+    if (!input) {
+        eAdd(errors, "Nao foi possivel abrir o arquivo");
+        svRespond(c, SV_ERRORS, errors, NULL, 0);
+        eFree(errors);
+        return;
+    }
+
+    // The check, the parse and the run of a request share its deadline, each one has the rest of the limits to itself
+    ParseOptions options = s->limits;
+    options.deadline     = pbNow() + (uint64_t)SV_TIMEOUT_MS * 1000000;
+
+    ParseBudget *budget = pbNew(&options);
+    Lexer       *l      = lNewWithKeywords(input, s->keywords);
+    l->budget           = budget;
+
+    // Diagnostics only need the checker, which builds no tree
+    if (request->format == SV_DIAGNOSTICS) {
+        Checker *checker = cNew(l);
+        cCheckProgram(checker);
+        svRespond(c, checker->errors->size > 0 ? SV_ERRORS : SV_OK, checker->errors, NULL, 0);
+
+        cFree(checker);
+        lFree(l);
+        pbFree(budget);
+        eFree(errors);
+        return;
+    }
+
+    Parser     *p       = pNewShared(l, NULL, NULL, s->tables);
+    astProgram *program = pParseProgram(p);
+
+    if (p->errors->size > 0) {
+        svRespond(c, SV_ERRORS, p->errors, NULL, 0);
+    } else if (request->format == SV_RUN) {
+        svExecute(c, program, options.deadline);
+    } else if (request->format == SV_TEXT) {
+        char *text = astProgramToString(program);
+        svRespond(c, SV_OK, errors, text, strlen(text));
+        free(text);
+    } else {
+        // Sized like the shard regions up to SV_MAX_REGION, a tree that doesn't fit is refused
+        uint64_t capacity = sizeof(shHeader) + l->length * 64 + (1 << 20);
+        if (capacity > SV_MAX_REGION) {
+            capacity = SV_MAX_REGION;
+        }
+        if (capacity > s->regionCapacity) {
+            free(s->region);
+            s->region         = (shHeader *)malloc(capacity);
+            s->regionCapacity = s->region ? capacity : 0;
+        }
+
+        shHeader *region = s->region;
+        if (region) {
+            memset(region, 0, sizeof(shHeader));
+            region->used     = sizeof(shHeader);
+            region->capacity = capacity;
+
+            shEncode(region, program);
+        }
+
+        if (!region || region->full) {
+            eAdd(errors, "Memoria insuficiente para a arvore sintatica");
+            svRespond(c, SV_ERRORS, errors, NULL, 0);
+        } else {
+            // Only the used part is sent, so that's all the client maps
+            region->capacity = region->used;
+            svRespond(c, SV_OK, errors, (char *)region, region->used);
+        }
+
+        // The response holds a copy, a buffer grown for a large tree would stay for the life of the server
+        if (s->regionCapacity > SV_KEEP_REGION) {
+            free(s->region);
+            s->region         = NULL;
+            s->regionCapacity = 0;
+        }
+    }
+
+    astProgramFree(program);
+    pFree(p);
+    lFree(l);
+    pbFree(budget);
+    eFree(errors);
+}
+
+// Append bytes to the response of a connection
+void svAppend(svConnection *c, void *data, uint64_t length) {
+    if (c->outputSize + length > c->outputCapacity) {
+        while (c->outputSize + length > c->outputCapacity) {
+            c->outputCapacity = c->outputCapacity ? c->outputCapacity * 2 : 4096;
+        }
+        c->output = (char *)realloc(c->output, c->outputCapacity);
+    }
+
+    memcpy(c->output + c->outputSize, data, length);
+    c->outputSize += length;
+}
+
+// Write a whole response, header, diagnostics and AST
+void svRespond(svConnection *c, svStatus status, eErrorList *errors, char *ast, uint64_t astLength) {
+    svResponse response = {status, errors->size, 0, astLength};
+    for (uint32_t i = 0; i < errors->size; i++) {
+        response.errorsLength += strlen(errors->data[i]) + 1;
+    }
+
+    svAppend(c, &response, sizeof(svResponse));
+    for (uint32_t i = 0; i < errors->size; i++) {
+        svAppend(c, errors->data[i], strlen(errors->data[i]) + 1);
+    }
+
+    if (astLength > 0) {
+        svAppend(c, ast, astLength);
+    }
+}
+
+// Type check, compile and run a parsed program, the response body is the variables it ends with
+// Only machine code can be stopped at the deadline, so a server that can't generate it refuses to run programs
+void svExecute(svConnection *c, astProgram *program, uint64_t deadline) {
+    TypeChecker *y = tyNew();
+    tyCheck(y, program);
+
+    bcProgram *bc  = y->errors->size == 0 ? bcCompile(y, program, y->errors) : NULL;
+    Jit       *jit = bc ? jitNew(bc) : NULL;
+    if (bc && !jit) {
+        eAdd(y->errors, "Execucao indisponivel, o servidor nao pode gerar codigo de maquina");
+    }
+
+    if (jit) {
+        VM *vm = vmNew(bc);
+
+        if (jitRun(jit, vm, deadline)) {
+            char  *text   = NULL;
+            size_t length = 0;
+            FILE  *out    = open_memstream(&text, &length);
+            vmPrintGlobals(vm, out);
+            fclose(out);
+
+            svRespond(c, SV_OK, y->errors, text, length);
+            free(text);
+        } else {
+            svRespond(c, SV_ERRORS, vm->errors, NULL, 0);
+        }
+
+        vmFree(vm);
+        jitFree(jit);
+    } else {
+        svRespond(c, SV_ERRORS, y->errors, NULL, 0);
+    }
+
+    if (bc) {
+        bcFree(bc);
+    }
+    tyFree(y);
+}
+
+#endif  // __linux__
+
+//
+// Client side
+//
+
+// Connect to a server, -1 if it isn't there
+int svConnect(char *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Send every byte, false if the connection broke
+bool svSendAll(int fd, void *data, uint64_t length) {
+    char *bytes = (char *)data;
+
+    while (length > 0) {
+        ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+
+        bytes += sent;
+        length -= sent;
+    }
+
+    return true;
+}
+
+// Receive exactly `length` bytes, false if the connection broke
+bool svRecvAll(int fd, void *data, uint64_t length) {
+    char *bytes = (char *)data;
+
+    while (length > 0) {
+        ssize_t received = recv(fd, bytes, length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+
+        bytes += received;
+        length -= received;
+    }
+
+    return true;
+}
+
+// Send a request and wait for its response, the body is the diagnostics followed by the AST
+bool svRoundTrip(int fd, svRequest *request, char *payload, svResponse *response, char **body) {
+    *body = NULL;
+
+    if (!svSendAll(fd, request, sizeof(svRequest)) || !svSendAll(fd, payload, request->length)) {
+        return false;
+    }
+
+    if (!svRecvAll(fd, response, sizeof(svResponse))) {
+        return false;
+    }
+
+    uint64_t length = response->errorsLength + response->astLength;
+
+    *body = (char *)malloc(length + 1);
+    if (!*body || !svRecvAll(fd, *body, length)) {
+        free(*body);
+        *body = NULL;
+        return false;
+    }
+
+    (*body)[length] = '\0';
+
+    return true;
+}
+
+// Load generator thread, one connection sending its requests back to back
+void *svLoadWork(void *arg) {
+    svLoadWorker *w  = (svLoadWorker *)arg;
+    int           fd = svConnect(w->path);
+    if (fd < 0) {
+        w->failed = w->requests;
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < w->requests; i++) {
+        uint32_t  source  = (w->first + i) % w->count;
+        svRequest request = {SV_MAGIC, SV_BYTES, w->format, 0, w->lengths[source]};
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        svResponse response;
+        char      *body;
+        if (!svRoundTrip(fd, &request, w->sources[source], &response, &body)) {
+            w->failed += w->requests - i;
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        free(body);
+
+        w->latencies[w->done] = (end.tv_sec - start.tv_sec) * 1000000000ull + (end.tv_nsec - start.tv_nsec);
+        w->done++;
+    }
+
+    close(fd);
+
+    return NULL;
+}
+
+// Compare latencies, smallest first
+int svCompareLatencies(const void *a, const void *b) {
+    uint64_t latencyA = *(uint64_t *)a;
+    uint64_t latencyB = *(uint64_t *)b;
+    return (latencyA > latencyB) - (latencyA < latencyB);
+}
+
+// Send the inputs to a server over a number of connections and report the latencies
+int svLoad(char *path, svFormat format, char **inputs, uint32_t count, uint32_t connections, uint32_t requests) {
+    if (connections == 0) {
+        connections = 1;
+    }
+
+    char    **sources = (char **)malloc(sizeof(char *) * count);
+    uint32_t *lengths = (uint32_t *)malloc(sizeof(uint32_t) * count);
+    for (uint32_t i = 0; i < count; i++) {
+        sources[i] = srReadFile(inputs[i]);
+        if (!sources[i]) {
+            printf("Nao foi possivel abrir o arquivo %s\n", inputs[i]);
+            for (uint32_t j = 0; j < i; j++) {
+                free(sources[j]);
+            }
+            free(sources);
+            free(lengths);
+            return 1;
+        }
+        lengths[i] = strlen(sources[i]);
+    }
+
+    svLoadWorker *workers   = (svLoadWorker *)calloc(connections, sizeof(svLoadWorker));
+    pthread_t    *threads   = (pthread_t *)malloc(sizeof(pthread_t) * connections);
+    uint64_t     *latencies = (uint64_t *)malloc(sizeof(uint64_t) * ((uint64_t)connections * requests + 1));
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Connections whose thread fails to start count as failed
+    uint32_t started = 0;
+    for (; started < connections; started++) {
+        uint64_t *slice  = latencies + (uint64_t)started * requests;
+        workers[started] = (svLoadWorker){path, format, sources, lengths, count, requests, started, slice, 0, 0};
+        if (pthread_create(&threads[started], NULL, svLoadWork, &workers[started]) != 0) {
+            break;
+        }
+    }
+
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (uint32_t i = started; i < connections; i++) {
+        workers[i].latencies = latencies;
+        workers[i].failed    = requests;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    // Gather the latencies of every connection in front of the array
+    uint64_t done   = 0;
+    uint64_t failed = 0;
+    for (uint32_t i = 0; i < connections; i++) {
+        memmove(latencies + done, workers[i].latencies, sizeof(uint64_t) * workers[i].done);
+        done += workers[i].done;
+        failed += workers[i].failed;
+    }
+
+    qsort(latencies, done, sizeof(uint64_t), svCompareLatencies);
+
+    printf("%" PRIu64 " pedido(s) em %.3f s, %.0f pedidos/s\n", done, elapsed, elapsed > 0 ? done / elapsed : 0.0);
+    if (done > 0) {
+        printf("p50: %.3f ms\n", latencies[(done - 1) * 50 / 100] / 1e6);
+        printf("p99: %.3f ms\n", latencies[(done - 1) * 99 / 100] / 1e6);
+        printf("max: %.3f ms\n", latencies[done - 1] / 1e6);
+    }
+    if (failed > 0) {
+        printf("%" PRIu64 " pedido(s) sem resposta\n", failed);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        free(sources[i]);
+    }
+    free(sources);
+    free(lengths);
+    free(workers);
+    free(threads);
+    free(latencies);
+
+    return failed > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,838 @@
+#include "shard.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+#endif  // __linux__
+
+#include "ast.h"
+#include "batch.h"
+#include "error.h"
+#include "events.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "token.h"
+
+//
+// Driver
+//
+
+// Parse every file of the batch in worker processes, one shard of files per worker
+void shRun(Batch *b, uint32_t workers) {
+    if (workers == 0) {
+        workers = 1;
+    }
+    if (workers > b->size && b->size > 0) {
+        workers = b->size;
+    }
+    if (b->size == 0) {
+        return;
+    }
+
+    // Deal the files by size, largest first, so every shard gets its share of large files
+    BatchFile **order = (BatchFile **)malloc(sizeof(BatchFile *) * b->size);
+    for (uint32_t i = 0; i < b->size; i++) {
+        order[i] = &b->files[i];
+    }
+
+    qsort(order, b->size, sizeof(BatchFile *), bCompareSizes);
+
+    uint32_t *counts = (uint32_t *)calloc(workers, sizeof(uint32_t));
+    uint64_t *bytes  = (uint64_t *)calloc(workers, sizeof(uint64_t));
+    for (uint32_t i = 0; i < b->size; i++) {
+        counts[i % workers]++;
+        bytes[i % workers] += order[b->size - 1 - i]->size;
+    }
+
+    // The regions are sparse, only the pages the workers write are ever backed
+    Shard *shards = (Shard *)calloc(workers, sizeof(Shard));
+    for (uint32_t i = 0; i < workers; i++) {
+        uint64_t capacity = sizeof(shHeader) + counts[i] * (sizeof(shResult) + sizeof(uint32_t) + 16) + bytes[i] * 64 +
+                            (1 << 20);
+
+        if (shMap(&shards[i], capacity)) {
+            shHeader *region = shards[i].region;
+            region->used     = sizeof(shHeader);
+            region->capacity = capacity;
+            region->results  = shAlloc(region, sizeof(shResult) * counts[i]);
+            region->files    = shAlloc(region, sizeof(uint32_t) * counts[i]);
+        }
+    }
+
+    for (uint32_t i = 0; i < b->size; i++) {
+        Shard *s = &shards[i % workers];
+        if (s->region) {
+            uint32_t *files          = (uint32_t *)shAt(s->region, s->region->files);
+            files[s->region->size++] = order[b->size - 1 - i] - b->files;
+        } else {
+            BatchFile *f = order[b->size - 1 - i];
+            f->errors    = eNew();
+            eAdd(f->errors, "Nao foi possivel criar a memoria compartilhada");
+        }
+    }
+
+    free(order);
+    free(counts);
+    free(bytes);
+
+    // Buffered output would be written again by every worker
+    fflush(stdout);
+    fflush(stderr);
+
+    uint32_t running = 0;
+    for (uint32_t i = 0; i < workers; i++) {
+        if (!shards[i].region) {
+            continue;
+        }
+
+        if (shSpawn(b, &shards[i])) {
+            running++;
+        } else {
+            // No process to isolate the shard in, it's parsed here instead
+            shWork(b, &shards[i]);
+            shCollect(b, &shards[i]);
+        }
+    }
+
+    while (running > 0) {
+        int   status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        Shard *s = NULL;
+        for (uint32_t i = 0; i < workers; i++) {
+            if (shards[i].pid == pid) {
+                s = &shards[i];
+            }
+        }
+        if (!s) {
+            continue;
+        }
+
+        s->pid    = 0;
+        s->status = status;
+        running--;
+
+        // The worker died before the end of its shard, the rest of the shard goes to a new worker
+        if (s->region->next < s->region->size) {
+            shCrashed(b, s);
+            if (s->region->next < s->region->size && shSpawn(b, s)) {
+                running++;
+                continue;
+            }
+        }
+
+        shCollect(b, s);
+    }
+
+    free(shards);
+}
+
+// Fork a worker for the files of the shard that are left
+bool shSpawn(Batch *b, Shard *s) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+
+    if (pid == 0) {
+        shWork(b, s);
+        _exit(0);
+    }
+
+    s->pid = pid;
+
+    return true;
+}
+
+// Worker process, parses the files of the shard from where the last worker stopped
+void shWork(Batch *b, Shard *s) {
+    shHeader *region  = s->region;
+    shResult *results = (shResult *)shAt(region, region->results);
+    uint32_t *files   = (uint32_t *)shAt(region, region->files);
+
+    while (region->next < region->size) {
+        shResult *result = &results[region->next];
+
+        if (result->state == SH_PENDING) {
+            result->state = SH_STARTED;
+            shParseFile(b, region, files[region->next], result);
+        }
+
+        region->next++;
+    }
+}
+
+// Parse a file, encoding its diagnostics and its tree into the region
+void shParseFile(Batch *b, shHeader *region, uint32_t index, shResult *result) {
+    BatchFile  *f       = &b->files[index];
+    uint64_t    mark    = region->used;
+    uint64_t    program = 0;
+    eErrorList *errors  = NULL;
+
+    char *input = srReadFile(f->input);
+    if (!input) {
+        errors = eNew();
+        eAdd(errors, "Nao foi possivel abrir o arquivo");
+    } else {
+        Lexer  *l = lNewWithKeywords(input, b->keywords);
+        Parser *p = pNewShared(l, NULL, NULL, b->tables);
+
+        // Top-level statements are encoded and freed as soon as they're parsed
+        shEncoder encoder = {region, NULL, 0, 0};
+        p->stmtSink       = shEncodeStatement;
+        p->sinkCtx        = &encoder;
+
+        astProgram *parsed = pParseProgram(p);
+
+        if (p->errors->size == 0 && parsed) {
+            uint64_t block = shNodeNew(region, EV_BLOCK, NULL, encoder.size);
+            program        = shNodeNew(region, EV_PROGRAM, parsed->token, 2);
+
+            if (block && program) {
+                memcpy(((shNode *)shAt(region, block))->children, encoder.statements, sizeof(uint64_t) * encoder.size);
+
+                shNode *n      = (shNode *)shAt(region, program);
+                n->children[0] = shEncode(region, parsed->identifier);
+                n->children[1] = block;
+            }
+        }
+
+        // Statements encoded before the first error are of no use
+        if (p->errors->size > 0) {
+            region->used = mark;
+        }
+
+        // The worker keeps the diagnostics
+        errors    = p->errors;
+        p->errors = eNew();
+
+        free(encoder.statements);
+        astProgramFree(parsed);
+        lFree(l);
+        pFree(p);
+    }
+
+    uint64_t error = shAlloc(region, sizeof(uint64_t) * (errors->size + 1));
+    if (error) {
+        uint64_t *offsets = (uint64_t *)shAt(region, error);
+        for (uint32_t i = 0; i < errors->size; i++) {
+            offsets[i] = shEncodeString(region, errors->data[i]);
+        }
+    }
+
+    if (region->full) {
+        // Whatever was encoded for the file is dropped, the next file starts from the same place
+        region->used  = mark;
+        region->full  = 0;
+        result->state = SH_FULL;
+    } else {
+        result->errors  = errors->size;
+        result->error   = error;
+        result->program = program;
+        result->state   = SH_DONE;
+    }
+
+    eFree(errors);
+}
+
+// Blame the file the dead worker was parsing and skip it
+void shCrashed(Batch *b, Shard *s) {
+    shResult *results = (shResult *)shAt(s->region, s->region->results);
+    uint32_t *files   = (uint32_t *)shAt(s->region, s->region->files);
+    uint32_t  next    = s->region->next;
+
+    // It died between finishing a file and moving on to the next one
+    if (results[next].state == SH_DONE) {
+        s->region->next++;
+        return;
+    }
+
+    char error[96];
+    if (WIFSIGNALED(s->status)) {
+        snprintf(error, sizeof(error), "Processo de analise encerrado pelo sinal %d", WTERMSIG(s->status));
+    } else {
+        snprintf(error, sizeof(error), "Processo de analise encerrado com codigo %d", WEXITSTATUS(s->status));
+    }
+
+    BatchFile *f = &b->files[files[next]];
+    f->errors    = eNew();
+    eAdd(f->errors, error);
+
+    results[next].state = SH_CRASHED;
+    s->region->next++;
+}
+
+// Read the results of a finished shard straight out of its region and release it
+void shCollect(Batch *b, Shard *s) {
+    shResult *results = (shResult *)shAt(s->region, s->region->results);
+    uint32_t *files   = (uint32_t *)shAt(s->region, s->region->files);
+
+    for (uint32_t i = 0; i < s->region->size; i++) {
+        BatchFile *f = &b->files[files[i]];
+        if (f->errors) {
+            continue;
+        }
+
+        f->errors = eNew();
+
+        switch (results[i].state) {
+            case SH_DONE: {
+                uint64_t *offsets = (uint64_t *)shAt(s->region, results[i].error);
+                for (uint32_t j = 0; j < results[i].errors; j++) {
+                    eAdd(f->errors, (char *)shAt(s->region, offsets[j]));
+                }
+
+                shWriteFile(f, s->region, &results[i]);
+                break;
+            }
+            case SH_FULL:
+                eAdd(f->errors, "Memoria compartilhada insuficiente");
+                break;
+            default:
+                eAdd(f->errors, "Arquivo nao analisado");
+                break;
+        }
+    }
+
+    shUnmap(s);
+}
+
+// Write the AST of a file next to it, decoding one top-level statement at a time
+void shWriteFile(BatchFile *f, shHeader *region, shResult *result) {
+    char *outputFile = (char *)malloc(strlen(f->input) + 5);
+    sprintf(outputFile, "%s.ast", f->input);
+
+    if (result->errors > 0 || !result->program) {
+        remove(outputFile);
+        free(outputFile);
+        return;
+    }
+
+    FILE *file = fopen(outputFile, "w");
+    if (!file) {
+        eAdd(f->errors, "Nao foi possivel abrir o arquivo de saida");
+        free(outputFile);
+        return;
+    }
+
+    shNode *n     = (shNode *)shAt(region, result->program);
+    shNode *block = (shNode *)shAt(region, n->children[1]);
+
+    astProgram *program = astProgramNew(shDecodeToken(region, n));
+    program->identifier = (astIdentifierExpr *)shDecode(region, n->children[0]);
+
+    astTextSink *sink = astTextSinkNew(file);
+    for (uint32_t i = 0; i < block->count; i++) {
+        astStatement *stmt = (astStatement *)shDecode(region, block->children[i]);
+        astTextSinkStatement(sink, program, stmt);
+        stmt->free(stmt);
+    }
+
+    astTextSinkEnd(sink);
+    fprintf(file, "\n");
+    fclose(file);
+
+    astTextSinkFree(sink);
+    astProgramFree(program);
+    free(outputFile);
+}
+
+//
+// Shared regions
+//
+
+// Map a shared region the workers inherit, backed by a memfd where there is one
+bool shMap(Shard *s, uint64_t capacity) {
+    s->region = NULL;
+    s->fd     = -1;
+    s->pid    = 0;
+    s->status = 0;
+
+    void *base = MAP_FAILED;
+
+#ifdef __linux__
+    s->fd = syscall(SYS_memfd_create, "pascal-shard", MFD_CLOEXEC);
+    if (s->fd >= 0 && ftruncate(s->fd, capacity) == 0) {
+        base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    }
+#endif  // __linux__
+
+    if (base == MAP_FAILED) {
+        if (s->fd >= 0) {
+            close(s->fd);
+            s->fd = -1;
+        }
+
+        base = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED) {
+            return false;
+        }
+    }
+
+    // Both kinds of mapping start zeroed, so every file starts as SH_PENDING
+    s->region = (shHeader *)base;
+
+    return true;
+}
+
+// Unmap the region of a shard
+void shUnmap(Shard *s) {
+    if (!s->region) {
+        return;
+    }
+
+    munmap(s->region, s->region->capacity);
+    if (s->fd >= 0) {
+        close(s->fd);
+    }
+
+    s->region = NULL;
+    s->fd     = -1;
+}
+
+//
+// Encoding
+//
+
+// Address of an offset in the region
+void *shAt(shHeader *region, uint64_t offset) { return (char *)region + offset; }
+
+// Allocate 8-byte aligned space in the region, 0 and marks the region full when it doesn't fit
+uint64_t shAlloc(shHeader *region, uint64_t size) {
+    uint64_t offset = region->used;
+    size            = (size + 7) & ~(uint64_t)7;
+
+    if (region->full || offset + size > region->capacity) {
+        region->full = 1;
+        return 0;
+    }
+
+    region->used += size;
+
+    return offset;
+}
+
+// Copy a string into the region
+uint64_t shEncodeString(shHeader *region, char *str) {
+    size_t   length = strlen(str);
+    uint64_t offset = shAlloc(region, length + 1);
+    if (offset) {
+        memcpy(shAt(region, offset), str, length + 1);
+    }
+
+    return offset;
+}
+
+// Allocate a node with room for its children, the children start out missing
+uint64_t shNodeNew(shHeader *region, EventKind kind, Token *token, uint32_t count) {
+    // The node goes first, so the root of a tree encoded on its own is the first node of the region
+    uint64_t offset  = shAlloc(region, sizeof(shNode) + sizeof(uint64_t) * count);
+    uint64_t literal = token ? shEncodeString(region, token->literal) : 0;
+    if (!offset || (token && !literal)) {
+        return 0;
+    }
+
+    shNode *n  = (shNode *)shAt(region, offset);
+    n->kind    = kind;
+    n->type    = token ? token->type : 0;
+    n->flags   = 0;
+    n->count   = count;
+    n->literal = literal;
+    n->line    = token ? token->line : 0;
+    memset(n->children, 0, sizeof(uint64_t) * count);
+
+    return offset;
+}
+
+// Encode a subtree, returns the offset of its root or 0 for a missing node or a full region
+uint64_t shEncode(shHeader *region, void *node) {
+    if (!node) {
+        return 0;
+    }
+
+    EventKind kind   = evKindOf(node);
+    uint64_t  offset = 0;
+    shNode   *n      = NULL;
+
+    switch (kind) {
+        case EV_PROGRAM: {
+            astProgram *program = (astProgram *)node;
+            if ((offset = shNodeNew(region, kind, program->token, 2))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, program->identifier);
+                n->children[1] = shEncode(region, program->block);
+            }
+            break;
+        }
+        case EV_BLOCK: {
+            astBlockStmt *block = (astBlockStmt *)node;
+            if ((offset = shNodeNew(region, kind, NULL, block->size))) {
+                n = (shNode *)shAt(region, offset);
+                for (uint32_t i = 0; i < block->size; i++) {
+                    n->children[i] = shEncode(region, block->statements[i]);
+                }
+            }
+            break;
+        }
+        case EV_VAR: {
+            astVarStmt *var = (astVarStmt *)node;
+            if ((offset = shNodeNew(region, kind, var->token, var->size))) {
+                n = (shNode *)shAt(region, offset);
+                for (uint32_t i = 0; i < var->size; i++) {
+                    n->children[i] = shEncode(region, var->declarations[i]);
+                }
+            }
+            break;
+        }
+        case EV_DECLARATION: {
+            astDeclarationStmt *decl = (astDeclarationStmt *)node;
+            if ((offset = shNodeNew(region, kind, NULL, decl->size + 1))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, decl->type);
+                for (uint32_t i = 0; i < decl->size; i++) {
+                    n->children[i + 1] = shEncode(region, decl->identifier[i]);
+                }
+            }
+            break;
+        }
+        case EV_FUNCTION: {
+            astFunctionStmt *function = (astFunctionStmt *)node;
+            if ((offset = shNodeNew(region, kind, function->token, function->size + 3))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, function->identifier);
+                n->children[1] = shEncode(region, function->returnType);
+                n->children[2] = shEncode(region, function->block);
+                for (uint32_t i = 0; i < function->size; i++) {
+                    n->children[i + 3] = shEncode(region, function->parameters[i]);
+                }
+            }
+            break;
+        }
+        case EV_PARAMETER: {
+            astParameterStmt *param = (astParameterStmt *)node;
+            if ((offset = shNodeNew(region, kind, NULL, param->size))) {
+                n        = (shNode *)shAt(region, offset);
+                n->flags = param->isVar;
+                for (uint32_t i = 0; i < param->size; i++) {
+                    n->children[i] = shEncode(region, param->declarations[i]);
+                }
+            }
+            break;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)node;
+            if ((offset = shNodeNew(region, kind, beginEnd->token, beginEnd->size))) {
+                n = (shNode *)shAt(region, offset);
+                for (uint32_t i = 0; i < beginEnd->size; i++) {
+                    n->children[i] = shEncode(region, beginEnd->statements[i]);
+                }
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)node;
+            if ((offset = shNodeNew(region, kind, conditional->token, 3))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, conditional->condition);
+                n->children[1] = shEncode(region, conditional->consequence);
+                n->children[2] = shEncode(region, conditional->alternative);
+            }
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)node;
+            if ((offset = shNodeNew(region, kind, loop->token, 2))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, loop->condition);
+                n->children[1] = shEncode(region, loop->body);
+            }
+            break;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpressionStmt *stmt = (astExpressionStmt *)node;
+            if ((offset = shNodeNew(region, kind, NULL, 1))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, stmt->expr);
+            }
+            break;
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = (astPrefixExpr *)node;
+            if ((offset = shNodeNew(region, kind, prefix->token, 1))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, prefix->right);
+            }
+            break;
+        }
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)node;
+            if ((offset = shNodeNew(region, kind, infix->token, 2))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, infix->left);
+                n->children[1] = shEncode(region, infix->right);
+            }
+            break;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)node;
+            if ((offset = shNodeNew(region, kind, assignment->token, 2))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, assignment->identifier);
+                n->children[1] = shEncode(region, assignment->value);
+            }
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)node;
+            if ((offset = shNodeNew(region, kind, call->token, call->size + 1))) {
+                n              = (shNode *)shAt(region, offset);
+                n->children[0] = shEncode(region, call->identifier);
+                for (uint32_t i = 0; i < call->size; i++) {
+                    n->children[i + 1] = shEncode(region, call->arguments[i]);
+                }
+            }
+            break;
+        }
+        default:
+            // Literals, the value is parsed again from the literal when decoding
+            offset = shNodeNew(region, kind, ((astExpression *)node)->token, 0);
+            break;
+    }
+
+    return offset;
+}
+
+// Statement sink callback, encodes a top-level statement, the parser frees it afterwards
+void shEncodeStatement(void *ctx, astProgram *p, astStatement *s) {
+    shEncoder *encoder = (shEncoder *)ctx;
+    (void)p;
+
+    encoder->statements = (uint64_t *)astGrowArray(encoder->statements, encoder->size, &encoder->capacity,
+                                                   sizeof(uint64_t));
+    encoder->statements[encoder->size] = shEncode(encoder->region, s);
+    encoder->size++;
+}
+
+//
+// Decoding
+//
+
+// Token of an encoded node, NULL for nodes without one
+Token *shDecodeToken(shHeader *region, shNode *n) {
+    if (!n->literal) {
+        return NULL;
+    }
+
+    Token *token = tNewToken(n->type, (char *)shAt(region, n->literal));
+    token->line  = n->line;
+
+    return token;
+}
+
+// First token of an expression, what an expression statement refers to
+Token *shFirstToken(astExpression *e) {
+    if (!e) {
+        return NULL;
+    }
+
+    switch (evKindOf(e)) {
+        case EV_INFIX:
+            return ((astInfixExpr *)e)->left ? shFirstToken(((astInfixExpr *)e)->left) : e->token;
+        case EV_ASSIGNMENT:
+            return ((astAssignmentExpr *)e)->identifier ? ((astAssignmentExpr *)e)->identifier->token : e->token;
+        case EV_CALL:
+            return ((astCallExpr *)e)->identifier ? ((astCallExpr *)e)->identifier->token : e->token;
+        default:
+            return e->token;
+    }
+}
+
+// Rebuild the AST of an encoded subtree, the same tree pParseProgram built
+void *shDecode(shHeader *region, uint64_t offset) {
+    if (!offset) {
+        return NULL;
+    }
+
+    shNode   *n        = (shNode *)shAt(region, offset);
+    uint64_t *children = n->children;
+
+    switch ((EventKind)n->kind) {
+        case EV_PROGRAM: {
+            astProgram *program = astProgramNew(shDecodeToken(region, n));
+            program->identifier = (astIdentifierExpr *)shDecode(region, children[0]);
+            program->block      = (astBlockStmt *)shDecode(region, children[1]);
+            return program;
+        }
+        case EV_BLOCK: {
+            astBlockStmt *block = astBlockStmtNew(NULL);
+            if (n->count > 0) {
+                block->statements = (astStatement **)malloc(sizeof(astStatement *) * n->count);
+                for (uint32_t i = 0; i < n->count; i++) {
+                    block->statements[i] = (astStatement *)shDecode(region, children[i]);
+                }
+                block->size     = n->count;
+                block->capacity = n->count;
+            }
+            return block;
+        }
+        case EV_VAR: {
+            astVarStmt *var = astVarStmtNew(shDecodeToken(region, n));
+            if (n->count > 0) {
+                var->declarations = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *) * n->count);
+                for (uint32_t i = 0; i < n->count; i++) {
+                    var->declarations[i] = (astDeclarationStmt *)shDecode(region, children[i]);
+                }
+                var->size     = n->count;
+                var->capacity = n->count;
+            }
+            return var;
+        }
+        case EV_DECLARATION: {
+            astDeclarationStmt *decl = astDeclarationStmtNew(NULL);
+            decl->type               = (astTypeExpr *)shDecode(region, children[0]);
+            decl->identifier         = (astIdentifierExpr **)malloc(sizeof(astIdentifierExpr *) * n->count);
+            for (uint32_t i = 1; i < n->count; i++) {
+                decl->identifier[i - 1] = (astIdentifierExpr *)shDecode(region, children[i]);
+            }
+            decl->size     = n->count - 1;
+            decl->capacity = n->count;
+            if (decl->size > 0) {
+                decl->token = decl->identifier[0]->token;
+            }
+            return decl;
+        }
+        case EV_FUNCTION: {
+            astFunctionStmt *function = astFunctionStmtNew(shDecodeToken(region, n));
+            function->identifier      = (astIdentifierExpr *)shDecode(region, children[0]);
+            function->returnType      = (astTypeExpr *)shDecode(region, children[1]);
+            function->block           = (astBlockStmt *)shDecode(region, children[2]);
+            if (n->count > 3) {
+                function->parameters = (astParameterStmt **)malloc(sizeof(astParameterStmt *) * (n->count - 3));
+                for (uint32_t i = 3; i < n->count; i++) {
+                    function->parameters[i - 3] = (astParameterStmt *)shDecode(region, children[i]);
+                }
+                function->size     = n->count - 3;
+                function->capacity = n->count - 3;
+            }
+            return function;
+        }
+        case EV_PARAMETER: {
+            astParameterStmt *param = astParameterStmtNew(NULL);
+            param->isVar            = n->flags;
+            if (n->count > 0) {
+                param->declarations = (astDeclarationStmt **)malloc(sizeof(astDeclarationStmt *) * n->count);
+                for (uint32_t i = 0; i < n->count; i++) {
+                    param->declarations[i] = (astDeclarationStmt *)shDecode(region, children[i]);
+                }
+                param->size     = n->count;
+                param->capacity = n->count;
+            }
+            return param;
+        }
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = astBeginEndStmtNew(shDecodeToken(region, n));
+            if (n->count > 0) {
+                beginEnd->statements = (astExpressionStmt **)malloc(sizeof(astExpressionStmt *) * n->count);
+                for (uint32_t i = 0; i < n->count; i++) {
+                    beginEnd->statements[i] = (astExpressionStmt *)shDecode(region, children[i]);
+                }
+                beginEnd->size     = n->count;
+                beginEnd->capacity = n->count;
+            }
+            return beginEnd;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = astConditionalStmtNew(shDecodeToken(region, n));
+            conditional->condition          = (astExpression *)shDecode(region, children[0]);
+            conditional->consequence        = (astStatement *)shDecode(region, children[1]);
+            conditional->alternative        = (astStatement *)shDecode(region, children[2]);
+            return conditional;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = astWhileStmtNew(shDecodeToken(region, n));
+            loop->condition    = (astExpression *)shDecode(region, children[0]);
+            loop->body         = (astStatement *)shDecode(region, children[1]);
+            return loop;
+        }
+        case EV_EXPRESSION_STMT: {
+            astExpression     *expr = (astExpression *)shDecode(region, children[0]);
+            astExpressionStmt *stmt = astExpressionStmtNew(shFirstToken(expr));
+            stmt->expr              = expr;
+            return stmt;
+        }
+        case EV_PREFIX: {
+            astPrefixExpr *prefix = astPrefixExprNew(shDecodeToken(region, n));
+            prefix->right         = (astExpression *)shDecode(region, children[0]);
+            return prefix;
+        }
+        case EV_INFIX: {
+            astInfixExpr *infix = astInfixExprNew(shDecodeToken(region, n));
+            infix->left         = (astExpression *)shDecode(region, children[0]);
+            infix->right        = (astExpression *)shDecode(region, children[1]);
+            return infix;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = astAssignmentExprNew(shDecodeToken(region, n));
+            assignment->identifier        = (astIdentifierExpr *)shDecode(region, children[0]);
+            assignment->value             = (astExpression *)shDecode(region, children[1]);
+            return assignment;
+        }
+        case EV_CALL: {
+            astCallExpr *call = astCallExprNew(shDecodeToken(region, n));
+            call->identifier  = (astIdentifierExpr *)shDecode(region, children[0]);
+            if (n->count > 1) {
+                call->arguments = (astExpression **)malloc(sizeof(astExpression *) * (n->count - 1));
+                for (uint32_t i = 1; i < n->count; i++) {
+                    call->arguments[i - 1] = (astExpression *)shDecode(region, children[i]);
+                }
+                call->size     = n->count - 1;
+                call->capacity = n->count - 1;
+            }
+            return call;
+        }
+        case EV_IDENTIFIER:
+            return astIdentifierExprNew(shDecodeToken(region, n));
+        case EV_INTEGER: {
+            astIntegerExpr *integer = astIntegerExprNew(shDecodeToken(region, n));
+            integer->value          = strtoll(integer->token->literal, NULL, 10);
+            return integer;
+        }
+        case EV_FLOAT: {
+            astFloatExpr *real = astFloatExprNew(shDecodeToken(region, n));
+            real->value        = strtod(real->token->literal, NULL);
+            return real;
+        }
+        case EV_BOOLEAN: {
+            astBooleanExpr *boolean = astBooleanExprNew(shDecodeToken(region, n));
+            boolean->value          = n->type == TRUE;
+            return boolean;
+        }
+        case EV_STRING:
+            return astStringExprNew(shDecodeToken(region, n));
+        case EV_CHAR:
+            return astCharExprNew(shDecodeToken(region, n));
+        case EV_TYPE:
+            return astTypeExprNew(shDecodeToken(region, n));
+    }
+
+    return NULL;
+}
\ No newline at end of file
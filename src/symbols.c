@@ -0,0 +1,371 @@
+#include "symbols.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "error.h"
+#include "events.h"
+
+// Create an empty symbol table
+SymbolTable *syNew() {
+    SymbolTable *t = (SymbolTable *)malloc(sizeof(SymbolTable));
+    if (!t) {
+        return NULL;
+    }
+
+    t->names    = 0;
+    t->capacity = 64;
+    t->entries  = (syEntry *)calloc(t->capacity, sizeof(syEntry));
+
+    // Symbol 0 stands for "no symbol", so bindings and slots can use 0 for none
+    t->size           = 1;
+    t->symbolCapacity = 64;
+    t->symbols        = (sySymbol *)calloc(t->symbolCapacity, sizeof(sySymbol));
+
+    t->undo         = NULL;
+    t->undoSize     = 0;
+    t->undoCapacity = 0;
+
+    t->depth  = 0;
+    t->scope  = NULL;
+    t->uses   = 0;
+    t->errors = eNew();
+
+    return t;
+}
+
+// Free the table, the tree it resolved keeps its bindings but they mean nothing without the table
+void syFree(SymbolTable *t) {
+    free(t->entries);
+    free(t->symbols);
+    free(t->undo);
+    eFree(t->errors);
+    free(t);
+}
+
+// Bind every identifier of a program to its symbol, returns true if every name was declared once and used declared
+bool syResolve(SymbolTable *t, astProgram *program) {
+    if (!program) {
+        return false;
+    }
+
+    if (program->identifier) {
+        syDeclare(t, program->identifier, SY_PROGRAM, NULL);
+    }
+
+    syResolveBlock(t, program->block);
+
+    return t->errors->size == 0;
+}
+
+// Symbol an identifier was bound to, NULL if it wasn't resolved
+sySymbol *sySymbolOf(SymbolTable *t, astIdentifierExpr *identifier) {
+    return identifier->symbol ? &t->symbols[identifier->symbol] : NULL;
+}
+
+//
+// Walk
+//
+
+// Resolve a block in the current scope, declarations come before the statements that use them
+void syResolveBlock(SymbolTable *t, astBlockStmt *block) {
+    if (!block) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        astStatement *s = block->statements[i];
+
+        switch (evKindOf(s)) {
+            case EV_VAR: {
+                astVarStmt *var = (astVarStmt *)s;
+                syResolveDeclarations(t, var->declarations, var->size, SY_VARIABLE, false);
+                break;
+            }
+            case EV_FUNCTION:
+                syResolveFunction(t, (astFunctionStmt *)s);
+                break;
+            default:
+                syResolveNode(t, s);
+                break;
+        }
+    }
+}
+
+// Resolve a function, its name belongs to the enclosing scope so it can call itself, the rest to its own scope
+void syResolveFunction(SymbolTable *t, astFunctionStmt *function) {
+    if (function->identifier) {
+        uint32_t symbol = syDeclare(t, function->identifier, function->returnType ? SY_FUNCTION : SY_PROCEDURE,
+                                    function->returnType);
+        t->symbols[symbol].function = function;
+    }
+
+    astFunctionStmt *scope = t->scope;
+    uint32_t         mark  = syEnter(t);
+    t->scope               = function;
+
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        if (parameter) {
+            syResolveDeclarations(t, parameter->declarations, parameter->size, SY_PARAMETER, parameter->isVar);
+        }
+    }
+
+    syResolveBlock(t, function->block);
+
+    syLeave(t, mark);
+    t->scope = scope;
+}
+
+// Declare the names of a series of declarations in the current scope
+void syResolveDeclarations(SymbolTable *t, astDeclarationStmt **declarations, uint32_t size, syKind kind,
+                           bool reference) {
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        if (!declaration) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < declaration->size; j++) {
+            if (declaration->identifier[j]) {
+                uint32_t symbol              = syDeclare(t, declaration->identifier[j], kind, declaration->type);
+                t->symbols[symbol].reference = reference;
+            }
+        }
+    }
+}
+
+// Resolve the identifiers used by a statement or expression
+void syResolveNode(SymbolTable *t, void *node) {
+    if (!node) {
+        return;
+    }
+
+    switch (evKindOf(node)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)node;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                syResolveNode(t, beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)node;
+            syResolveNode(t, conditional->condition);
+            syResolveNode(t, conditional->consequence);
+            syResolveNode(t, conditional->alternative);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)node;
+            syResolveNode(t, loop->condition);
+            syResolveNode(t, loop->body);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            syResolveNode(t, ((astExpressionStmt *)node)->expr);
+            break;
+        case EV_PREFIX:
+            syResolveNode(t, ((astPrefixExpr *)node)->right);
+            break;
+        case EV_INFIX: {
+            astInfixExpr *infix = (astInfixExpr *)node;
+            syResolveNode(t, infix->left);
+            syResolveNode(t, infix->right);
+            break;
+        }
+        case EV_ASSIGNMENT: {
+            astAssignmentExpr *assignment = (astAssignmentExpr *)node;
+            syResolveNode(t, assignment->identifier);
+            syResolveNode(t, assignment->value);
+            break;
+        }
+        case EV_CALL: {
+            astCallExpr *call = (astCallExpr *)node;
+            syResolveNode(t, call->identifier);
+            for (uint32_t i = 0; i < call->size; i++) {
+                syResolveNode(t, call->arguments[i]);
+            }
+            break;
+        }
+        case EV_IDENTIFIER:
+            syUse(t, (astIdentifierExpr *)node);
+            break;
+        default:  // Literals and types name nothing
+            break;
+    }
+}
+
+// Bind a use of a name to the innermost visible symbol of that name
+void syUse(SymbolTable *t, astIdentifierExpr *identifier) {
+    t->uses++;
+
+    identifier->symbol = syLookup(t, identifier->value);
+    if (identifier->symbol == 0) {
+        char error[320];
+        sprintf(error, "Linha %" PRIu64 ": Identificador não declarado: `%.127s`", identifier->token->line,
+                identifier->value);
+        eAdd(t->errors, error);
+    }
+}
+
+//
+// Scopes
+//
+
+// Declare a name in the current scope, hiding any symbol of the same name from an enclosing scope
+// The identifier is bound to the new symbol, which is returned
+uint32_t syDeclare(SymbolTable *t, astIdentifierExpr *identifier, syKind kind, astTypeExpr *type) {
+    uint32_t  symbol = syDeclareName(t, identifier->value, identifier->token->line, kind);
+    sySymbol *s      = &t->symbols[symbol];
+    s->identifier    = identifier;
+    s->type          = type;
+
+    identifier->symbol = symbol;
+
+    return symbol;
+}
+
+// Declare a name that has no identifier node, the name must outlive the table, `line` is where it's declared
+uint32_t syDeclareName(SymbolTable *t, char *name, uint64_t line, syKind kind) {
+    uint32_t hash  = syHash(name);
+    syEntry *entry = syFind(t, name, hash);
+
+    if (!entry->name) {
+        // Kept at most half full, so probes stay short
+        if ((t->names + 1) * 2 > t->capacity) {
+            syGrow(t);
+            entry = syFind(t, name, hash);
+        }
+
+        entry->name = name;
+        entry->hash = hash;
+        t->names++;
+    } else if (entry->symbol && t->symbols[entry->symbol].depth == t->depth) {
+        char error[320];
+        sprintf(error, "Linha %" PRIu64 ": Identificador já declarado neste escopo: `%.127s`", line, name);
+        eAdd(t->errors, error);
+    }
+
+    t->symbols = (sySymbol *)astGrowArray(t->symbols, t->size, &t->symbolCapacity, sizeof(sySymbol));
+
+    uint32_t  symbol = t->size++;
+    sySymbol *s      = &t->symbols[symbol];
+    s->name          = name;
+    s->hash          = hash;
+    s->kind          = kind;
+    s->depth         = t->depth;
+    s->shadowed      = entry->symbol;
+    s->typeId        = 0;
+    s->identifier    = NULL;
+    s->type          = NULL;
+    s->function      = NULL;
+    s->scope         = t->scope;
+    s->reference     = false;
+    s->temporary     = false;
+
+    entry->symbol = symbol;
+
+    t->undo                = (uint32_t *)astGrowArray(t->undo, t->undoSize, &t->undoCapacity, sizeof(uint32_t));
+    t->undo[t->undoSize++] = symbol;
+
+    return symbol;
+}
+
+/*
+Declare a variable of the scope of `scope` at `depth` for a tree that was already resolved, the variables an optimizer
+introduces. Its name isn't bound and the scope isn't open, so it can't hide or clash with a declared name.
+*/
+uint32_t syTemporary(SymbolTable *t, astIdentifierExpr *identifier, astTypeExpr *type, uint32_t depth,
+                     astFunctionStmt *scope) {
+    t->symbols = (sySymbol *)astGrowArray(t->symbols, t->size, &t->symbolCapacity, sizeof(sySymbol));
+
+    uint32_t  symbol = t->size++;
+    sySymbol *s      = &t->symbols[symbol];
+    s->name          = identifier->value;
+    s->hash          = syHash(identifier->value);
+    s->kind          = SY_VARIABLE;
+    s->depth         = depth;
+    s->shadowed      = 0;
+    s->typeId        = 0;
+    s->identifier    = identifier;
+    s->type          = type;
+    s->function      = NULL;
+    s->scope         = scope;
+    s->reference     = false;
+    s->temporary     = true;
+
+    identifier->symbol = symbol;
+
+    return symbol;
+}
+
+// Innermost visible symbol of a name, 0 if there's none
+uint32_t syLookup(SymbolTable *t, char *name) {
+    syEntry *entry = syFind(t, name, syHash(name));
+    return entry->name ? entry->symbol : 0;
+}
+
+// Open a scope, returns the mark to close it with
+uint32_t syEnter(SymbolTable *t) {
+    t->depth++;
+    return t->undoSize;
+}
+
+// Close the scope opened at `mark`, every symbol declared since then goes out of scope, innermost first
+void syLeave(SymbolTable *t, uint32_t mark) {
+    while (t->undoSize > mark) {
+        sySymbol *s = &t->symbols[t->undo[--t->undoSize]];
+        syFind(t, s->name, s->hash)->symbol = s->shadowed;
+    }
+
+    t->depth--;
+}
+
+//
+// Name table
+//
+
+// Slot of a name, or the empty slot where it would go
+syEntry *syFind(SymbolTable *t, char *name, uint32_t hash) {
+    uint32_t mask = t->capacity - 1;
+
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        syEntry *entry = &t->entries[i];
+        if (!entry->name || (entry->hash == hash && strcmp(entry->name, name) == 0)) {
+            return entry;
+        }
+    }
+}
+
+// Double the name table, every name moves to its slot in the larger table
+void syGrow(SymbolTable *t) {
+    syEntry *entries  = t->entries;
+    uint32_t capacity = t->capacity;
+
+    t->capacity *= 2;
+    t->entries = (syEntry *)calloc(t->capacity, sizeof(syEntry));
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (entries[i].name) {
+            *syFind(t, entries[i].name, entries[i].hash) = entries[i];
+        }
+    }
+
+    free(entries);
+}
+
+// 32-bit FNV-1a hash of a name, spreads names that only differ in a trailing digit
+uint32_t syHash(char *name) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char *ch = (unsigned char *)name; *ch; ch++) {
+        hash = (hash ^ *ch) * 16777619u;
+    }
+
+    return hash;
+}
\ No newline at end of file
@@ -15,6 +15,8 @@ Token *tNewToken(TokenType type, char *literal) {
     tok->type    = type;
     tok->literal = malloc(strlen(literal) + 1);
     strcpy(tok->literal, literal);
+    tok->line   = 0;
+    tok->column = 0;
 
     return tok;
 }
@@ -0,0 +1,663 @@
+#include "types.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "error.h"
+#include "events.h"
+#include "symbols.h"
+#include "token.h"
+
+// Create a type checker with only the builtin types
+TypeChecker *tyNew() {
+    TypeChecker *y = (TypeChecker *)malloc(sizeof(TypeChecker));
+    if (!y) {
+        return NULL;
+    }
+
+    y->symbols = syNew();
+    if (!y->symbols) {
+        free(y);
+        return NULL;
+    }
+
+    y->signatures        = NULL;
+    y->size              = 0;
+    y->signatureCapacity = 0;
+
+    y->slotCapacity = 64;
+    y->slots        = (uint32_t *)calloc(y->slotCapacity, sizeof(uint32_t));
+
+    y->parameters        = NULL;
+    y->parameterCapacity = 0;
+
+    y->functions        = NULL;
+    y->depth            = 0;
+    y->functionCapacity = 0;
+
+    y->expressions = 0;
+    y->errors      = y->symbols->errors;
+
+    return y;
+}
+
+// Free the checker and its symbol table, the tree keeps its cached type ids
+void tyFree(TypeChecker *y) {
+    for (uint32_t i = 0; i < y->size; i++) {
+        free(y->signatures[i].parameters);
+    }
+
+    free(y->signatures);
+    free(y->slots);
+    free(y->parameters);
+    free(y->functions);
+    syFree(y->symbols);
+    free(y);
+}
+
+// Type a program, returns true if every name is declared and every expression is well-typed
+bool tyCheck(TypeChecker *y, astProgram *program) {
+    if (!program) {
+        return false;
+    }
+
+    if (program->identifier) {
+        syDeclare(y->symbols, program->identifier, SY_PROGRAM, NULL);
+    }
+
+    tyCheckBlock(y, program->block);
+
+    return y->errors->size == 0;
+}
+
+//
+// Walk, mirrors the walk of the symbol table so names are resolved as they're typed
+//
+
+// Type a block in the current scope, declarations come before the statements that use them
+void tyCheckBlock(TypeChecker *y, astBlockStmt *block) {
+    if (!block) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < block->size; i++) {
+        tyCheckBlockStatement(y, block->statements[i]);
+    }
+}
+
+// Type a statement of a block, declaring the names it declares
+void tyCheckBlockStatement(TypeChecker *y, astStatement *s) {
+    switch (evKindOf(s)) {
+        case EV_VAR: {
+            astVarStmt *var = (astVarStmt *)s;
+            tyCheckDeclarations(y, var->declarations, var->size, SY_VARIABLE, false);
+            break;
+        }
+        case EV_FUNCTION:
+            tyCheckFunction(y, (astFunctionStmt *)s);
+            break;
+        default:
+            tyCheckStatement(y, s);
+            break;
+    }
+}
+
+// Type a function, its signature is interned before its block so it can call itself
+void tyCheckFunction(TypeChecker *y, astFunctionStmt *function) {
+    SymbolTable *t = y->symbols;
+
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        if (!parameter) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < parameter->size; j++) {
+            astDeclarationStmt *declaration = parameter->declarations[j];
+            if (!declaration) {
+                continue;
+            }
+
+            uint32_t type = tyOfTypeExpr(declaration->type) | (parameter->isVar ? TY_REFERENCE : 0);
+            for (uint32_t k = 0; k < declaration->size; k++) {
+                y->parameters = (uint32_t *)astGrowArray(y->parameters, size, &y->parameterCapacity, sizeof(uint32_t));
+                y->parameters[size++] = type;
+            }
+        }
+    }
+
+    uint32_t result    = function->returnType ? tyOfTypeExpr(function->returnType) : TY_VOID;
+    uint32_t signature = tyIntern(y, result, y->parameters, size);
+
+    if (function->identifier) {
+        uint32_t symbol = syDeclare(t, function->identifier, function->returnType ? SY_FUNCTION : SY_PROCEDURE,
+                                    function->returnType);
+        t->symbols[symbol].function = function;
+        t->symbols[symbol].typeId   = signature;
+        function->identifier->type  = signature;
+    }
+
+    y->functions = (astFunctionStmt **)astGrowArray(y->functions, y->depth, &y->functionCapacity,
+                                                    sizeof(astFunctionStmt *));
+    y->functions[y->depth++] = function;
+
+    astFunctionStmt *scope = t->scope;
+    uint32_t         mark  = syEnter(t);
+    t->scope               = function;
+
+    for (uint32_t i = 0; i < function->size; i++) {
+        astParameterStmt *parameter = function->parameters[i];
+        if (parameter) {
+            tyCheckDeclarations(y, parameter->declarations, parameter->size, SY_PARAMETER, parameter->isVar);
+        }
+    }
+
+    tyCheckBlock(y, function->block);
+
+    syLeave(t, mark);
+    t->scope = scope;
+    y->depth--;
+}
+
+// Declare the names of a series of declarations in the current scope, each one with the type id of its declaration
+void tyCheckDeclarations(TypeChecker *y, astDeclarationStmt **declarations, uint32_t size, syKind kind,
+                         bool reference) {
+    SymbolTable *t = y->symbols;
+
+    syResolveDeclarations(t, declarations, size, kind, reference);
+
+    for (uint32_t i = 0; i < size; i++) {
+        astDeclarationStmt *declaration = declarations[i];
+        if (!declaration) {
+            continue;
+        }
+
+        uint32_t type = tyOfTypeExpr(declaration->type);
+        for (uint32_t j = 0; j < declaration->size; j++) {
+            astIdentifierExpr *identifier = declaration->identifier[j];
+            if (identifier) {
+                t->symbols[identifier->symbol].typeId = type;
+                identifier->type                      = type;
+            }
+        }
+    }
+}
+
+// Type the expressions of a statement, conditions must be boolean
+void tyCheckStatement(TypeChecker *y, astStatement *s) {
+    if (!s) {
+        return;
+    }
+
+    switch (evKindOf(s)) {
+        case EV_BEGIN_END: {
+            astBeginEndStmt *beginEnd = (astBeginEndStmt *)s;
+            for (uint32_t i = 0; i < beginEnd->size; i++) {
+                tyCheckStatement(y, (astStatement *)beginEnd->statements[i]);
+            }
+            break;
+        }
+        case EV_CONDITIONAL: {
+            astConditionalStmt *conditional = (astConditionalStmt *)s;
+            tyCheckCondition(y, conditional->condition);
+            tyCheckStatement(y, conditional->consequence);
+            tyCheckStatement(y, conditional->alternative);
+            break;
+        }
+        case EV_WHILE: {
+            astWhileStmt *loop = (astWhileStmt *)s;
+            tyCheckCondition(y, loop->condition);
+            tyCheckStatement(y, loop->body);
+            break;
+        }
+        case EV_EXPRESSION_STMT:
+            tyCheckExpression(y, ((astExpressionStmt *)s)->expr);
+            break;
+        default:
+            break;
+    }
+}
+
+// Type the condition of an `if` or `while`
+void tyCheckCondition(TypeChecker *y, astExpression *condition) {
+    uint32_t type = tyCheckExpression(y, condition);
+    if (type != TY_BOOLEAN && type != TY_ERROR) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Condição deve ser `boolean`, obteve `%s`",
+                 condition->token->line, tyName(type));
+        eAdd(y->errors, error);
+    }
+}
+
+// Type an expression and cache its type id on the node
+uint32_t tyCheckExpression(TypeChecker *y, astExpression *e) {
+    if (!e) {
+        return TY_ERROR;
+    }
+
+    y->expressions++;
+
+    uint32_t type = TY_ERROR;
+    switch (evKindOf(e)) {
+        case EV_IDENTIFIER:
+            type = tyCheckIdentifier(y, (astIdentifierExpr *)e);
+            break;
+        case EV_INTEGER:
+            type = TY_INTEGER;
+            break;
+        case EV_FLOAT:
+            type = TY_REAL;
+            break;
+        case EV_BOOLEAN:
+            type = TY_BOOLEAN;
+            break;
+        case EV_CHAR:
+            type = TY_CHAR;
+            break;
+        case EV_STRING:
+            type = TY_STRING;
+            break;
+        case EV_INFIX:
+            type = tyCheckInfix(y, (astInfixExpr *)e);
+            break;
+        case EV_PREFIX:
+            type = tyCheckPrefix(y, (astPrefixExpr *)e);
+            break;
+        case EV_ASSIGNMENT:
+            type = tyCheckAssignment(y, (astAssignmentExpr *)e);
+            break;
+        case EV_CALL:
+            type = tyCheckCallExpr(y, (astCallExpr *)e);
+            break;
+        default:
+            break;
+    }
+
+    e->type = type;
+    return type;
+}
+
+// Type a prefix expression, `-` takes a number and `not` a boolean
+uint32_t tyCheckPrefix(TypeChecker *y, astPrefixExpr *prefix) {
+    uint32_t right = tyCheckExpression(y, prefix->right);
+    if (right == TY_ERROR) {
+        return TY_ERROR;
+    }
+
+    if (prefix->token->type == MINUS && (right == TY_INTEGER || right == TY_REAL)) {
+        return right;
+    }
+    if (prefix->token->type == NOT && right == TY_BOOLEAN) {
+        return TY_BOOLEAN;
+    }
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": Operador `%s` não se aplica a `%s`", prefix->token->line,
+             prefix->op, tyName(right));
+    eAdd(y->errors, error);
+
+    return TY_ERROR;
+}
+
+// Type an infix expression by its operator token
+uint32_t tyCheckInfix(TypeChecker *y, astInfixExpr *infix) {
+    uint32_t left  = tyCheckExpression(y, infix->left);
+    uint32_t right = tyCheckExpression(y, infix->right);
+    if (left == TY_ERROR || right == TY_ERROR) {
+        return TY_ERROR;
+    }
+
+    uint32_t type = tyOperator(infix->token->type, left, right);
+    if (type == TY_NONE) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Operador `%s` não se aplica a `%s` e `%s`",
+                 infix->token->line, infix->op, tyName(left), tyName(right));
+        eAdd(y->errors, error);
+        return TY_ERROR;
+    }
+
+    return type;
+}
+
+// Type an assignment, the target is a variable, a parameter, or a function inside its own block
+uint32_t tyCheckAssignment(TypeChecker *y, astAssignmentExpr *assignment) {
+    SymbolTable       *t          = y->symbols;
+    astIdentifierExpr *identifier = assignment->identifier;
+
+    uint32_t target = TY_ERROR;
+    if (identifier && evKindOf(identifier) == EV_IDENTIFIER) {
+        y->expressions++;
+        syUse(t, identifier);
+
+        sySymbol *s = sySymbolOf(t, identifier);
+        if (s && (s->kind == SY_VARIABLE || s->kind == SY_PARAMETER)) {
+            target = s->typeId;
+        } else if (s && s->kind == SY_FUNCTION && tyIsOpen(y, s->function)) {
+            target = tySignatureOf(y, s->typeId)->result;
+        } else if (s) {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": Não é possível atribuir a `%.127s`",
+                     assignment->token->line, identifier->value);
+            eAdd(y->errors, error);
+        }
+
+        identifier->type = target;
+    } else {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Atribuição deve ter um identificador à esquerda",
+                 assignment->token->line);
+        eAdd(y->errors, error);
+    }
+
+    uint32_t value = tyCheckExpression(y, assignment->value);
+    if (target != TY_ERROR && value != TY_ERROR && !tyAssignable(target, value)) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Atribuição incompatível, `%.127s` é `%s` e o valor é `%s`",
+                 assignment->token->line, identifier->value, tyName(target), tyName(value));
+        eAdd(y->errors, error);
+    }
+
+    return TY_VOID;
+}
+
+// Type a use of a name, a function or procedure named without arguments is a call without arguments
+uint32_t tyCheckIdentifier(TypeChecker *y, astIdentifierExpr *identifier) {
+    SymbolTable *t = y->symbols;
+
+    syUse(t, identifier);
+
+    sySymbol *s = sySymbolOf(t, identifier);
+    if (!s) {
+        return TY_ERROR;
+    }
+
+    switch (s->kind) {
+        case SY_VARIABLE:
+        case SY_PARAMETER:
+            return s->typeId;
+        case SY_FUNCTION:
+        case SY_PROCEDURE:
+            return tyCheckCall(y, identifier, NULL, 0);
+        default: {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` não tem valor", identifier->token->line,
+                     identifier->value);
+            eAdd(y->errors, error);
+            return TY_ERROR;
+        }
+    }
+}
+
+// Type a call with parentheses, only a name can be called
+uint32_t tyCheckCallExpr(TypeChecker *y, astCallExpr *call) {
+    astIdentifierExpr *callee = call->identifier;
+
+    if (callee && evKindOf(callee) == EV_IDENTIFIER) {
+        y->expressions++;
+        syUse(y->symbols, callee);
+        return tyCheckCall(y, callee, call->arguments, call->size);
+    }
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": Apenas funções e procedimentos podem ser chamados",
+             call->token->line);
+    eAdd(y->errors, error);
+
+    for (uint32_t i = 0; i < call->size; i++) {
+        tyCheckExpression(y, call->arguments[i]);
+    }
+
+    return TY_ERROR;
+}
+
+// Type a call of a resolved name against the signature of its function, returns the result type
+uint32_t tyCheckCall(TypeChecker *y, astIdentifierExpr *callee, astExpression **arguments, uint32_t size) {
+    sySymbol *s = sySymbolOf(y->symbols, callee);
+    if (!s || (s->kind != SY_FUNCTION && s->kind != SY_PROCEDURE)) {
+        if (s) {
+            char error[320];
+            snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` não é uma função nem um procedimento",
+                     callee->token->line, callee->value);
+            eAdd(y->errors, error);
+        }
+
+        for (uint32_t i = 0; i < size; i++) {
+            tyCheckExpression(y, arguments[i]);
+        }
+        callee->type = TY_ERROR;
+        return TY_ERROR;
+    }
+
+    callee->type = s->typeId;
+
+    tySignature *signature = tySignatureOf(y, s->typeId);
+    if (signature->size != size) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": `%.127s` espera %u argumento(s), obteve %u",
+                 callee->token->line, callee->value, signature->size, size);
+        eAdd(y->errors, error);
+
+        for (uint32_t i = 0; i < size; i++) {
+            tyCheckExpression(y, arguments[i]);
+        }
+        return signature->result;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        tyCheckArgument(y, callee, i, signature->parameters[i], arguments[i]);
+    }
+
+    return signature->result;
+}
+
+// Type an argument against its parameter, a reference parameter takes a variable of the same type
+void tyCheckArgument(TypeChecker *y, astIdentifierExpr *callee, uint32_t index, uint32_t parameter,
+                     astExpression *argument) {
+    uint32_t type = tyCheckExpression(y, argument);
+    if (type == TY_ERROR) {
+        return;
+    }
+
+    if (parameter & TY_REFERENCE) {
+        parameter &= ~TY_REFERENCE;
+
+        sySymbol *s = NULL;
+        if (evKindOf(argument) == EV_IDENTIFIER) {
+            s = sySymbolOf(y->symbols, (astIdentifierExpr *)argument);
+        }
+
+        if (!s || (s->kind != SY_VARIABLE && s->kind != SY_PARAMETER) || type != parameter) {
+            char error[320];
+            snprintf(error, sizeof(error),
+                     "Linha %" PRIu64 ": Argumento %u de `%.127s` é passado por referência, deve ser uma variável `%s`",
+                     callee->token->line, index + 1, callee->value, tyName(parameter));
+            eAdd(y->errors, error);
+        }
+        return;
+    }
+
+    if (!tyAssignable(parameter, type)) {
+        char error[320];
+        snprintf(error, sizeof(error), "Linha %" PRIu64 ": Argumento %u de `%.127s` deve ser `%s`, obteve `%s`",
+                 callee->token->line, index + 1, callee->value, tyName(parameter), tyName(type));
+        eAdd(y->errors, error);
+    }
+}
+
+//
+// Types
+//
+
+// Type id of a type expression, by its token so type names are never compared, cached on the node
+uint32_t tyOfTypeExpr(astTypeExpr *type) {
+    if (!type) {
+        return TY_ERROR;
+    }
+
+    if (type->type == TY_NONE) {
+        switch (type->token->type) {
+            case INTEGER:
+                type->type = TY_INTEGER;
+                break;
+            case REAL:
+                type->type = TY_REAL;
+                break;
+            case BOOLEAN:
+                type->type = TY_BOOLEAN;
+                break;
+            case CHARACTER:
+                type->type = TY_CHAR;
+                break;
+            case STRING:
+                type->type = TY_STRING;
+                break;
+            default:
+                type->type = TY_ERROR;
+                break;
+        }
+    }
+
+    return type->type;
+}
+
+// Result type of an infix operator, TY_NONE if it doesn't apply to its operands
+// Arithmetic on two integers is integer and real otherwise, `+` also joins strings and characters
+uint32_t tyOperator(TokenType op, uint32_t left, uint32_t right) {
+    bool numeric = (left == TY_INTEGER || left == TY_REAL) && (right == TY_INTEGER || right == TY_REAL);
+    bool text    = (left == TY_CHAR || left == TY_STRING) && (right == TY_CHAR || right == TY_STRING);
+
+    switch (op) {
+        case PLUS:
+            if (text) {
+                return TY_STRING;
+            }
+            // fall through
+        case MINUS:
+        case ASTERISK:
+            if (!numeric) {
+                return TY_NONE;
+            }
+            return left == TY_INTEGER && right == TY_INTEGER ? TY_INTEGER : TY_REAL;
+        case SLASH:
+            return numeric ? TY_REAL : TY_NONE;
+        case DIV:
+        case MOD:
+            return left == TY_INTEGER && right == TY_INTEGER ? TY_INTEGER : TY_NONE;
+        case EQ:
+        case NOT_EQ:
+        case LT:
+        case GT:
+        case LTE:
+        case GTE:
+            return numeric || text || (left == TY_BOOLEAN && right == TY_BOOLEAN) ? TY_BOOLEAN : TY_NONE;
+        case AND:
+        case OR:
+            return left == TY_BOOLEAN && right == TY_BOOLEAN ? TY_BOOLEAN : TY_NONE;
+        default:
+            return TY_NONE;
+    }
+}
+
+// Check if a value can be stored in a target, integers widen to real and characters to string
+bool tyAssignable(uint32_t target, uint32_t value) {
+    if (target == value) {
+        return target != TY_VOID && target < TY_BUILTINS;
+    }
+
+    return (target == TY_REAL && value == TY_INTEGER) || (target == TY_STRING && value == TY_CHAR);
+}
+
+// Check if a function is being checked, its name is then also the variable of its result
+bool tyIsOpen(TypeChecker *y, astFunctionStmt *function) {
+    for (uint32_t i = y->depth; i > 0; i--) {
+        if (y->functions[i - 1] == function) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Type id of a signature, equal signatures get the same id
+uint32_t tyIntern(TypeChecker *y, uint32_t result, uint32_t *parameters, uint32_t size) {
+    // 32-bit FNV-1a over the type ids
+    uint32_t hash = (2166136261u ^ result) * 16777619u;
+    for (uint32_t i = 0; i < size; i++) {
+        hash = (hash ^ parameters[i]) * 16777619u;
+    }
+
+    uint32_t mask = y->slotCapacity - 1;
+    uint32_t slot = hash & mask;
+    for (; y->slots[slot]; slot = (slot + 1) & mask) {
+        tySignature *s = &y->signatures[y->slots[slot] - TY_BUILTINS];
+        if (s->hash == hash && s->result == result && s->size == size &&
+            (size == 0 || memcmp(s->parameters, parameters, size * sizeof(uint32_t)) == 0)) {
+            return y->slots[slot];
+        }
+    }
+
+    y->signatures = (tySignature *)astGrowArray(y->signatures, y->size, &y->signatureCapacity, sizeof(tySignature));
+
+    tySignature *s = &y->signatures[y->size];
+    s->result      = result;
+    s->size        = size;
+    s->hash        = hash;
+    s->parameters  = NULL;
+    if (size > 0) {
+        s->parameters = (uint32_t *)malloc(size * sizeof(uint32_t));
+        memcpy(s->parameters, parameters, size * sizeof(uint32_t));
+    }
+
+    uint32_t id = TY_BUILTINS + y->size++;
+    y->slots[slot] = id;
+
+    // Kept at most half full, the ids move to their slots in the larger table
+    if (y->size * 2 > y->slotCapacity) {
+        free(y->slots);
+        y->slotCapacity *= 2;
+        y->slots = (uint32_t *)calloc(y->slotCapacity, sizeof(uint32_t));
+
+        mask = y->slotCapacity - 1;
+        for (uint32_t i = 0; i < y->size; i++) {
+            for (slot = y->signatures[i].hash & mask; y->slots[slot]; slot = (slot + 1) & mask) {
+            }
+            y->slots[slot] = TY_BUILTINS + i;
+        }
+    }
+
+    return id;
+}
+
+// Signature of a type id, NULL for the builtin types
+tySignature *tySignatureOf(TypeChecker *y, uint32_t type) {
+    return type >= TY_BUILTINS ? &y->signatures[type - TY_BUILTINS] : NULL;
+}
+
+// Name of a type for diagnostics
+char *tyName(uint32_t type) {
+    switch (type) {
+        case TY_VOID:
+            return "sem valor";
+        case TY_INTEGER:
+            return "integer";
+        case TY_REAL:
+            return "real";
+        case TY_BOOLEAN:
+            return "boolean";
+        case TY_CHAR:
+            return "char";
+        case TY_STRING:
+            return "string";
+        case TY_NONE:
+        case TY_ERROR:
+            return "inválido";
+        default:
+            return "função";
+    }
+}
\ No newline at end of file
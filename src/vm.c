@@ -0,0 +1,557 @@
+#include "vm.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "budget.h"
+#include "bytecode.h"
+#include "error.h"
+#include "types.h"
+
+// Signed immediates of the `b` and `c` operands
+#define VM_B(in) ((int64_t)(int16_t)(in).b)
+#define VM_C(in) (((int64_t)(in).c ^ 0x800000) - 0x800000)
+
+// Fetch the next instruction, counting it when built with VM_COUNT
+#ifdef VM_COUNT
+#define VM_FETCH() (vm->executed++, in = *ip++)
+#else
+#define VM_FETCH() (in = *ip++)
+#endif
+
+// Integer arithmetic wraps around like the machine's, instead of being undefined on overflow
+#define VM_WRAP(x) ((int64_t)(uint64_t)(x))
+
+// Text of a string register
+#define VM_TEXT(s) ((s) ? (s) : "")
+
+// Instructions each micro benchmark loop runs per iteration, besides the loop itself
+#define VM_UNROLL 8
+
+// Create a machine for a compiled program
+VM *vmNew(bcProgram *program) {
+    VM *vm = (VM *)malloc(sizeof(VM));
+    if (!vm) {
+        return NULL;
+    }
+
+    vm->program = program;
+    vm->stack   = (bcValue *)calloc(VM_STACK_SIZE, sizeof(bcValue));
+    vm->frames  = (vmFrame *)malloc(VM_MAX_FRAMES * sizeof(vmFrame));
+
+    vm->strings        = NULL;
+    vm->stringSize     = 0;
+    vm->stringCapacity = 0;
+
+    vm->executed = 0;
+    vm->errors   = eNew();
+
+    if (!vm->stack || !vm->frames) {
+        vmFree(vm);
+        return NULL;
+    }
+
+    return vm;
+}
+
+// Free the machine and the strings it built, the program is left alone
+void vmFree(VM *vm) {
+    for (uint32_t i = 0; i < vm->stringSize; i++) {
+        free(vm->strings[i]);
+    }
+
+    free(vm->strings);
+    free(vm->stack);
+    free(vm->frames);
+    eFree(vm->errors);
+    free(vm);
+}
+
+/*
+Run the program from its first instruction, returns false if it stopped on a runtime error.
+Each handler ends by dispatching the next instruction itself, through a table of label addresses when the compiler
+supports computed goto, so every handler has its own indirect branch for the predictor to learn.
+*/
+bool vmRun(VM *vm) {
+    bcProgram  *p     = vm->program;
+    bcFunction *f     = &p->functions[0];
+    bcValue    *K     = p->constants;
+    bcValue    *G     = vm->stack;
+    bcValue    *R     = vm->stack;
+    bcValue    *end   = vm->stack + VM_STACK_SIZE;
+    vmFrame    *frame = vm->frames;
+    vmFrame    *last  = vm->frames + VM_MAX_FRAMES - 1;
+    bcInstr    *code  = f->code;
+    bcInstr    *ip    = code;
+    bcInstr     in;
+
+    frame->function = f;
+    frame->ip       = NULL;
+    frame->base     = R;
+    frame->link     = NULL;
+
+    if (f->registers > VM_STACK_SIZE) {
+        vmError(vm, frame, ip + 1, "estouro de pilha");
+        return false;
+    }
+    memset(R, 0, f->registers * sizeof(bcValue));
+
+#ifdef VM_COMPUTED_GOTO
+    // In the order of bcOp
+    void *labels[BC_OPCODES] = {
+        &&op_BC_HALT,  &&op_BC_MOVE,  &&op_BC_LOADI, &&op_BC_LOADK, &&op_BC_GETG,   &&op_BC_SETG,    &&op_BC_GETUP,
+        &&op_BC_SETUP, &&op_BC_ADDR,  &&op_BC_ADDRG, &&op_BC_ADDRUP, &&op_BC_LOADREF, &&op_BC_STOREREF,
+        &&op_BC_ADDI,  &&op_BC_SUBI,  &&op_BC_MULI,  &&op_BC_DIVI,  &&op_BC_MODI,   &&op_BC_ADDIK,   &&op_BC_SUBIK,
+        &&op_BC_NEGI,
+        &&op_BC_ADDF,  &&op_BC_SUBF,  &&op_BC_MULF,  &&op_BC_DIVF,  &&op_BC_NEGF,   &&op_BC_I2F,
+        &&op_BC_EQI,   &&op_BC_NEI,   &&op_BC_LTI,   &&op_BC_LEI,   &&op_BC_EQF,    &&op_BC_NEF,     &&op_BC_LTF,
+        &&op_BC_LEF,   &&op_BC_EQS,   &&op_BC_NES,   &&op_BC_LTS,   &&op_BC_LES,
+        &&op_BC_NOT,   &&op_BC_AND,   &&op_BC_OR,    &&op_BC_CONCAT, &&op_BC_C2S,
+        &&op_BC_JMP,   &&op_BC_JMPF,  &&op_BC_JMPT,  &&op_BC_JLTI,  &&op_BC_JLEI,   &&op_BC_JEQI,    &&op_BC_JNEI,
+        &&op_BC_JLTIK, &&op_BC_JLEIK, &&op_BC_JGTIK, &&op_BC_JGEIK, &&op_BC_JEQIK,  &&op_BC_JNEIK,
+        &&op_BC_CALL,  &&op_BC_RET,
+    };
+
+#define VM_CASE(op) op_##op
+#define VM_NEXT()   goto *labels[VM_FETCH().op]
+
+    VM_NEXT();
+    {
+#else
+#define VM_CASE(op) case op
+#define VM_NEXT()   goto dispatch
+
+dispatch:
+    VM_FETCH();
+    switch (in.op) {
+#endif
+        VM_CASE(BC_HALT):
+            return true;
+
+        VM_CASE(BC_MOVE):
+            R[in.a] = R[in.b];
+            VM_NEXT();
+        VM_CASE(BC_LOADI):
+            R[in.a].i = VM_C(in);
+            VM_NEXT();
+        VM_CASE(BC_LOADK):
+            R[in.a] = K[in.c];
+            VM_NEXT();
+        VM_CASE(BC_GETG):
+            R[in.a] = G[in.c];
+            VM_NEXT();
+        VM_CASE(BC_SETG):
+            G[in.c] = R[in.a];
+            VM_NEXT();
+        VM_CASE(BC_GETUP): {
+            vmFrame *up = frame;
+            for (uint32_t k = in.b; k > 0; k--) {
+                up = up->link;
+            }
+            R[in.a] = up->base[in.c];
+            VM_NEXT();
+        }
+        VM_CASE(BC_SETUP): {
+            vmFrame *up = frame;
+            for (uint32_t k = in.b; k > 0; k--) {
+                up = up->link;
+            }
+            up->base[in.c] = R[in.a];
+            VM_NEXT();
+        }
+        VM_CASE(BC_ADDR):
+            R[in.a].p = &R[in.b];
+            VM_NEXT();
+        VM_CASE(BC_ADDRG):
+            R[in.a].p = &G[in.c];
+            VM_NEXT();
+        VM_CASE(BC_ADDRUP): {
+            vmFrame *up = frame;
+            for (uint32_t k = in.b; k > 0; k--) {
+                up = up->link;
+            }
+            R[in.a].p = &up->base[in.c];
+            VM_NEXT();
+        }
+        VM_CASE(BC_LOADREF):
+            R[in.a] = *R[in.b].p;
+            VM_NEXT();
+        VM_CASE(BC_STOREREF):
+            *R[in.a].p = R[in.b];
+            VM_NEXT();
+
+        VM_CASE(BC_ADDI):
+            R[in.a].i = VM_WRAP((uint64_t)R[in.b].i + (uint64_t)R[in.c].i);
+            VM_NEXT();
+        VM_CASE(BC_SUBI):
+            R[in.a].i = VM_WRAP((uint64_t)R[in.b].i - (uint64_t)R[in.c].i);
+            VM_NEXT();
+        VM_CASE(BC_MULI):
+            R[in.a].i = VM_WRAP((uint64_t)R[in.b].i * (uint64_t)R[in.c].i);
+            VM_NEXT();
+        VM_CASE(BC_DIVI):
+            if (R[in.c].i == 0) {
+                vmError(vm, frame, ip, "divisão por zero");
+                return false;
+            }
+            R[in.a].i = R[in.c].i == -1 ? VM_WRAP(0 - (uint64_t)R[in.b].i) : R[in.b].i / R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_MODI):
+            if (R[in.c].i == 0) {
+                vmError(vm, frame, ip, "divisão por zero");
+                return false;
+            }
+            R[in.a].i = R[in.c].i == -1 ? 0 : R[in.b].i % R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_ADDIK):
+            R[in.a].i = VM_WRAP((uint64_t)R[in.b].i + (uint64_t)VM_C(in));
+            VM_NEXT();
+        VM_CASE(BC_SUBIK):
+            R[in.a].i = VM_WRAP((uint64_t)R[in.b].i - (uint64_t)VM_C(in));
+            VM_NEXT();
+        VM_CASE(BC_NEGI):
+            R[in.a].i = VM_WRAP(0 - (uint64_t)R[in.b].i);
+            VM_NEXT();
+
+        VM_CASE(BC_ADDF):
+            R[in.a].r = R[in.b].r + R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_SUBF):
+            R[in.a].r = R[in.b].r - R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_MULF):
+            R[in.a].r = R[in.b].r * R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_DIVF):
+            if (R[in.c].r == 0) {
+                vmError(vm, frame, ip, "divisão por zero");
+                return false;
+            }
+            R[in.a].r = R[in.b].r / R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_NEGF):
+            R[in.a].r = -R[in.b].r;
+            VM_NEXT();
+        VM_CASE(BC_I2F):
+            R[in.a].r = (double)R[in.b].i;
+            VM_NEXT();
+
+        VM_CASE(BC_EQI):
+            R[in.a].i = R[in.b].i == R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_NEI):
+            R[in.a].i = R[in.b].i != R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_LTI):
+            R[in.a].i = R[in.b].i < R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_LEI):
+            R[in.a].i = R[in.b].i <= R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_EQF):
+            R[in.a].i = R[in.b].r == R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_NEF):
+            R[in.a].i = R[in.b].r != R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_LTF):
+            R[in.a].i = R[in.b].r < R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_LEF):
+            R[in.a].i = R[in.b].r <= R[in.c].r;
+            VM_NEXT();
+        VM_CASE(BC_EQS):
+            R[in.a].i = strcmp(VM_TEXT(R[in.b].s), VM_TEXT(R[in.c].s)) == 0;
+            VM_NEXT();
+        VM_CASE(BC_NES):
+            R[in.a].i = strcmp(VM_TEXT(R[in.b].s), VM_TEXT(R[in.c].s)) != 0;
+            VM_NEXT();
+        VM_CASE(BC_LTS):
+            R[in.a].i = strcmp(VM_TEXT(R[in.b].s), VM_TEXT(R[in.c].s)) < 0;
+            VM_NEXT();
+        VM_CASE(BC_LES):
+            R[in.a].i = strcmp(VM_TEXT(R[in.b].s), VM_TEXT(R[in.c].s)) <= 0;
+            VM_NEXT();
+
+        VM_CASE(BC_NOT):
+            R[in.a].i = !R[in.b].i;
+            VM_NEXT();
+        VM_CASE(BC_AND):
+            R[in.a].i = R[in.b].i & R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_OR):
+            R[in.a].i = R[in.b].i | R[in.c].i;
+            VM_NEXT();
+        VM_CASE(BC_CONCAT):
+            R[in.a].s = vmString(vm, R[in.b].s, R[in.c].s);
+            VM_NEXT();
+        VM_CASE(BC_C2S): {
+            char ch[2] = {(char)R[in.b].i, '\0'};
+            R[in.a].s  = vmString(vm, ch, NULL);
+            VM_NEXT();
+        }
+
+        VM_CASE(BC_JMP):
+            ip = code + in.c;
+            VM_NEXT();
+        VM_CASE(BC_JMPF):
+            if (!R[in.a].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JMPT):
+            if (R[in.a].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JLTI):
+            if (R[in.a].i < R[in.b].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JLEI):
+            if (R[in.a].i <= R[in.b].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JEQI):
+            if (R[in.a].i == R[in.b].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JNEI):
+            if (R[in.a].i != R[in.b].i) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JLTIK):
+            if (R[in.a].i < VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JLEIK):
+            if (R[in.a].i <= VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JGTIK):
+            if (R[in.a].i > VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JGEIK):
+            if (R[in.a].i >= VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JEQIK):
+            if (R[in.a].i == VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+        VM_CASE(BC_JNEIK):
+            if (R[in.a].i != VM_B(in)) {
+                ip = code + in.c;
+            }
+            VM_NEXT();
+
+        VM_CASE(BC_CALL): {
+            bcFunction *callee = &p->functions[in.b];
+            bcValue    *base   = R + in.a;
+            if (frame == last || (uint64_t)(end - base) < callee->registers) {
+                vmError(vm, frame, ip, "estouro de pilha");
+                return false;
+            }
+
+            vmFrame *link = frame;
+            for (uint32_t k = in.c; k > 0; k--) {
+                link = link->link;
+            }
+
+            frame->ip = ip;
+            frame++;
+            frame->function = callee;
+            frame->base     = base;
+            frame->link     = link;
+
+            // The arguments are in place, the rest of the frame starts zeroed
+            memset(base + callee->parameters, 0, (callee->registers - callee->parameters) * sizeof(bcValue));
+
+            R    = base;
+            code = callee->code;
+            ip   = code;
+            VM_NEXT();
+        }
+        VM_CASE(BC_RET):
+            if (frame->function->result != BC_ANY) {
+                R[0] = R[frame->function->result];
+            }
+
+            frame--;
+            R    = frame->base;
+            code = frame->function->code;
+            ip   = frame->ip;
+            VM_NEXT();
+
+#ifndef VM_COMPUTED_GOTO
+        default:
+            vmError(vm, frame, ip, "instrução inválida");
+            return false;
+#endif
+    }
+
+#undef VM_CASE
+#undef VM_NEXT
+
+    return false;
+}
+
+// Join two strings into a new one the machine owns, NULL stands for the empty string
+char *vmString(VM *vm, char *left, char *right) {
+    size_t leftLength  = strlen(VM_TEXT(left));
+    size_t rightLength = strlen(VM_TEXT(right));
+    if (leftLength + rightLength == 0) {
+        return NULL;
+    }
+
+    char *s = (char *)malloc(leftLength + rightLength + 1);
+    memcpy(s, VM_TEXT(left), leftLength);
+    memcpy(s + leftLength, VM_TEXT(right), rightLength + 1);
+
+    vm->strings = (char **)astGrowArray(vm->strings, vm->stringSize, &vm->stringCapacity, sizeof(char *));
+    vm->strings[vm->stringSize++] = s;
+
+    return s;
+}
+
+// Report a runtime error at the instruction before `ip`, the one that failed
+void vmError(VM *vm, vmFrame *frame, bcInstr *ip, char *msg) {
+    bcFunction *f    = frame->function;
+    uint64_t    line = f->lines ? f->lines[ip - 1 - f->code] : 0;
+
+    char error[320];
+    snprintf(error, sizeof(error), "Linha %" PRIu64 ": Erro de execução em `%.127s`: %s", line, f->name, msg);
+    eAdd(vm->errors, error);
+}
+
+// Print the variables of the program scope as `name = value`, the program's results since it has no output
+void vmPrintGlobals(VM *vm, FILE *out) {
+    bcProgram *p = vm->program;
+
+    for (uint32_t i = 0; i < p->globalSize; i++) {
+        bcGlobal *g     = &p->globals[i];
+        bcValue   value = vm->stack[g->slot];
+
+        switch (g->type) {
+            case TY_INTEGER:
+                fprintf(out, "%s = %" PRId64 "\n", g->name, value.i);
+                break;
+            case TY_REAL:
+                fprintf(out, "%s = %.17g\n", g->name, value.r);
+                break;
+            case TY_BOOLEAN:
+                fprintf(out, "%s = %s\n", g->name, value.i ? "true" : "false");
+                break;
+            case TY_CHAR:
+                fprintf(out, "%s = '%c'\n", g->name, (char)value.i);
+                break;
+            case TY_STRING:
+                fprintf(out, "%s = \"%s\"\n", g->name, VM_TEXT(value.s));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+//
+// Micro benchmarks
+//
+
+// Time the instructions the compiler emits most, each one net of the loop that repeats it
+void vmBenchmark(FILE *out, uint64_t iterations) {
+    // Registers of the benchmark frame: 0 counter, 1 and 2 integers, 3 and 4 reals, 5 address of 1, 6 destination
+    // and 8 the frame of a call, constant 0 is the iteration count
+    uint32_t operands[][4] = {
+        {BC_MOVE, 6, 1, 0},   {BC_LOADI, 6, 0, 42}, {BC_LOADK, 6, 0, 0}, {BC_GETG, 6, 0, 1},  {BC_GETUP, 6, 0, 1},
+        {BC_ADDI, 6, 1, 2},   {BC_ADDIK, 6, 1, 5},  {BC_MULI, 6, 1, 2},  {BC_DIVI, 6, 1, 2},  {BC_MODI, 6, 1, 2},
+        {BC_ADDF, 6, 3, 4},   {BC_MULF, 6, 3, 4},   {BC_DIVF, 6, 3, 4},  {BC_I2F, 6, 1, 0},   {BC_LTI, 6, 2, 1},
+        {BC_LTF, 6, 4, 3},    {BC_NOT, 6, 1, 0},    {BC_LOADREF, 6, 5, 0}, {BC_STOREREF, 5, 1, 0},
+        {BC_JMP, 0, 0, 0},    {BC_JMPF, 1, 0, 0},   {BC_JLTI, 2, 1, 0},  {BC_JLTIK, 1, 100, 0},
+        {BC_CALL, 8, 1, 0},
+    };
+    uint32_t count = sizeof(operands) / sizeof(operands[0]);
+
+#ifdef VM_COMPUTED_GOTO
+    fprintf(out, "Despacho: goto computado\n");
+#else
+    fprintf(out, "Despacho: switch\n");
+#endif
+    fprintf(out, "%" PRIu64 " iterações de %d instruções por medida\n\n", iterations, VM_UNROLL);
+
+    double loop = vmBenchmarkOp(BC_HALT, 0, 0, 0, iterations);
+    fprintf(out, "%-10s %8.2f ns por iteração\n", "laço", loop);
+
+    for (uint32_t i = 0; i < count; i++) {
+        double time = vmBenchmarkOp(operands[i][0], operands[i][1], operands[i][2], operands[i][3], iterations);
+        fprintf(out, "%-10s %8.2f ns\n", bcOpName(operands[i][0]), (time - loop) / VM_UNROLL);
+    }
+}
+
+// Nanoseconds per iteration of a loop running an instruction VM_UNROLL times, BC_HALT times the bare loop
+// Jumps go to the next instruction, taken or not
+double vmBenchmarkOp(bcOp op, uint32_t a, uint32_t b, uint32_t c, uint64_t iterations) {
+    bcProgram *p = (bcProgram *)calloc(1, sizeof(bcProgram));
+
+    bcCompiler compiler;
+    compiler.program = p;
+    compiler.types   = NULL;
+    compiler.slots   = NULL;
+    compiler.index   = bcNewFunction(p, "benchmark");
+    compiler.depth   = 0;
+    compiler.top     = 0;
+    compiler.line    = 0;
+    compiler.failed  = false;
+    compiler.errors  = NULL;
+
+    bcValue value;
+    value.i = iterations;
+    bcEmit(&compiler, BC_LOADK, 0, 0, bcConstant(&compiler, value));
+    bcEmit(&compiler, BC_LOADI, 1, 0, 7);
+    bcEmit(&compiler, BC_LOADI, 2, 0, 3);
+    value.r = 2.5;
+    bcEmit(&compiler, BC_LOADK, 3, 0, bcConstant(&compiler, value));
+    value.r = 1.5;
+    bcEmit(&compiler, BC_LOADK, 4, 0, bcConstant(&compiler, value));
+    bcEmit(&compiler, BC_ADDR, 5, 1, 0);
+
+    uint32_t body = p->functions[0].size;
+    for (uint32_t i = 0; op != BC_HALT && i < VM_UNROLL; i++) {
+        bool jump = op >= BC_JMP && op <= BC_JNEIK;
+        bcEmit(&compiler, op, a, b, jump ? p->functions[0].size + 1 : c);
+    }
+    bcEmit(&compiler, BC_SUBIK, 0, 0, 1);
+    bcEmit(&compiler, BC_JGTIK, 0, 0, body);
+    bcEmit(&compiler, BC_HALT, 0, 0, 0);
+    p->functions[0].registers = 16;
+
+    // Called by the CALL benchmark, returns right away
+    compiler.index = bcNewFunction(p, "empty");
+    bcEmit(&compiler, BC_RET, 0, 0, 0);
+
+    VM *vm = vmNew(p);
+
+    uint64_t start = pbNow();
+    vmRun(vm);
+    uint64_t elapsed = pbNow() - start;
+
+    vmFree(vm);
+    bcFree(p);
+
+    return (double)elapsed / iterations;
+}
\ No newline at end of file
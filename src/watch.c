@@ -0,0 +1,551 @@
+#include "watch.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#endif  // __linux__
+
+#include "ast.h"
+#include "batch.h"
+#include "error.h"
+#include "hash.h"
+#include "hashmap.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "token.h"
+
+#ifdef __linux__
+
+// Writes that finished, files and directories moved in or out, created or removed
+#define WT_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR)
+
+// Create a watcher for a directory tree, NULL if inotify can't be set up
+Watcher *wtNew(char *root) {
+    Watcher *w = (Watcher *)malloc(sizeof(Watcher));
+    if (!w) {
+        return NULL;
+    }
+
+    w->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w->inotify < 0) {
+        free(w);
+        return NULL;
+    }
+
+    w->root              = strdup(root);
+    w->files             = NULL;
+    w->size              = 0;
+    w->capacity          = 0;
+    w->directories       = NULL;
+    w->directoryCount    = 0;
+    w->directoryCapacity = 0;
+    w->failed            = 0;
+    w->rescan            = false;
+
+    // A trailing slash would be repeated in every path built from the root
+    size_t length = strlen(w->root);
+    while (length > 1 && w->root[length - 1] == '/') {
+        w->root[--length] = '\0';
+    }
+
+    // Stop signals are read from the event loop, so a round is never interrupted halfway
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    w->signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    w->keywords = hmNew(hStrHash, hStrCmp, 64);
+    tInitKeywords(w->keywords);
+
+    w->tables = pNewTables();
+
+    return w;
+}
+
+// Stop watching and free every file kept in memory
+void wtFree(Watcher *w) {
+    for (uint32_t i = 0; i < w->size; i++) {
+        wtClear(w, &w->files[i]);
+        free(w->files[i].path);
+    }
+
+    for (uint32_t i = 0; i < w->directoryCount; i++) {
+        free(w->directories[i].path);
+    }
+
+    close(w->inotify);
+    close(w->signals);
+
+    free(w->files);
+    free(w->directories);
+    free(w->root);
+    hmFree(w->keywords);
+    pFree(w->tables);
+    free(w);
+}
+
+// Check every file once, then check the files that change until SIGINT or SIGTERM
+void wtRun(Watcher *w) {
+    double start = wtMilliseconds();
+
+    wtAddDirectory(w, w->root);
+    wtCheckPending(w, false);
+
+    printf("%u arquivo(s) analisado(s) em %.2f ms, %u com erros\n", w->size, wtMilliseconds() - start, w->failed);
+    printf("Observando alteracoes em %s\n", w->root);
+    fflush(stdout);
+
+    struct pollfd fds[2];
+    fds[0].fd     = w->inotify;
+    fds[0].events = POLLIN;
+    fds[1].fd     = w->signals;
+    fds[1].events = POLLIN;
+
+    // A round starts at its first event and is checked once no event arrived for WT_QUIET_MS
+    double first = 0;
+    double last  = 0;
+
+    while (true) {
+        int timeout = -1;
+        if (first > 0) {
+            timeout = (int)(WT_QUIET_MS - (wtMilliseconds() - last) + 1);
+            timeout = timeout < 0 ? 0 : timeout;
+        }
+
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (wtRead(w)) {
+                last  = wtMilliseconds();
+                first = first > 0 ? first : last;
+            }
+            continue;
+        }
+
+        if (first == 0 || wtMilliseconds() - last < WT_QUIET_MS) {
+            continue;
+        }
+
+        // Dropped events could have been about any file, so every file is looked at again
+        if (w->rescan) {
+            w->rescan = false;
+            for (uint32_t i = 0; i < w->size; i++) {
+                w->files[i].pending = true;
+            }
+            wtAddDirectory(w, w->root);
+        }
+
+        double   checkStart = wtMilliseconds();
+        uint32_t checked    = wtCheckPending(w, true);
+        double   end        = wtMilliseconds();
+
+        if (checked > 0) {
+            printf("%u arquivo(s) reverificado(s) em %.2f ms, %.2f ms apos a alteracao, %u de %u com erros\n", checked,
+                   end - checkStart, end - first, w->failed, w->size);
+            fflush(stdout);
+        }
+
+        first = 0;
+    }
+}
+
+//
+// Files and directories
+//
+
+// Watch a directory and its subdirectories, every `.pas` file in them is marked to be checked
+void wtAddDirectory(Watcher *w, char *dir) {
+    // The watch is added before the walk, so a file created during the walk isn't missed
+    int wd = inotify_add_watch(w->inotify, dir, WT_EVENTS);
+    if (wd >= 0) {
+        uint32_t index = wtFindDirectory(w, wd);
+        if (index < w->directoryCount) {
+            // Watching the same directory again returns the same descriptor
+            free(w->directories[index].path);
+            w->directories[index].path = strdup(dir);
+        } else {
+            // Descriptors only grow, so appending keeps the list sorted
+            w->directories = (wtDirectory *)astGrowArray(w->directories, w->directoryCount, &w->directoryCapacity,
+                                                         sizeof(wtDirectory));
+            w->directories[w->directoryCount].wd   = wd;
+            w->directories[w->directoryCount].path = strdup(dir);
+            w->directoryCount++;
+        }
+    }
+
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+
+    char   **names    = NULL;
+    uint32_t size     = 0;
+    uint32_t capacity = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(d))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        names       = (char **)astGrowArray(names, size, &capacity, sizeof(char *));
+        names[size] = (char *)malloc(strlen(dir) + strlen(entry->d_name) + 2);
+        sprintf(names[size], "%s/%s", dir, entry->d_name);
+        size++;
+    }
+
+    closedir(d);
+
+    qsort(names, size, sizeof(char *), bCompareNames);
+
+    for (uint32_t i = 0; i < size; i++) {
+        // Linked directories aren't followed, a link back up the tree would be walked forever
+        struct stat st;
+        if (lstat(names[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+            wtAddDirectory(w, names[i]);
+        } else if (stat(names[i], &st) == 0 && S_ISREG(st.st_mode)) {
+            size_t length = strlen(names[i]);
+            if (length > 4 && strcmp(names[i] + length - 4, ".pas") == 0) {
+                wtFind(w, names[i], true)->pending = true;
+            }
+        }
+
+        free(names[i]);
+    }
+
+    free(names);
+}
+
+// Index of the directory of a watch descriptor, `directoryCount` if it isn't watched
+uint32_t wtFindDirectory(Watcher *w, int wd) {
+    uint32_t low  = 0;
+    uint32_t high = w->directoryCount;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (w->directories[middle].wd < wd) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low < w->directoryCount && w->directories[low].wd == wd ? low : w->directoryCount;
+}
+
+// Forget a watched directory
+void wtRemoveDirectory(Watcher *w, uint32_t index) {
+    free(w->directories[index].path);
+
+    w->directoryCount--;
+    memmove(&w->directories[index], &w->directories[index + 1],
+            sizeof(wtDirectory) * (w->directoryCount - index));
+}
+
+// Stop watching a directory that was moved or removed, its files are dropped when they can't be read anymore
+void wtDropDirectory(Watcher *w, char *dir) {
+    size_t length = strlen(dir);
+
+    for (uint32_t i = 0; i < w->directoryCount;) {
+        char *path = w->directories[i].path;
+        if (strncmp(path, dir, length) == 0 && (path[length] == '\0' || path[length] == '/')) {
+            // A moved directory is still watched at its new place, a removed one isn't watched anymore either way
+            inotify_rm_watch(w->inotify, w->directories[i].wd);
+            wtRemoveDirectory(w, i);
+        } else {
+            i++;
+        }
+    }
+
+    // The files of the directory follow each other in path order
+    char *prefix = (char *)malloc(length + 2);
+    sprintf(prefix, "%s/", dir);
+
+    for (uint32_t i = wtLowerBound(w, prefix); i < w->size && strncmp(w->files[i].path, prefix, length + 1) == 0; i++) {
+        w->files[i].pending = true;
+    }
+
+    free(prefix);
+}
+
+// The file of a path, added when `create` is set and it isn't known yet, NULL otherwise
+wtFile *wtFind(Watcher *w, char *path, bool create) {
+    uint32_t index = wtLowerBound(w, path);
+    if (index < w->size && strcmp(w->files[index].path, path) == 0) {
+        return &w->files[index];
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    w->files = (wtFile *)astGrowArray(w->files, w->size, &w->capacity, sizeof(wtFile));
+    memmove(&w->files[index + 1], &w->files[index], sizeof(wtFile) * (w->size - index));
+    w->size++;
+
+    wtFile *f = &w->files[index];
+    memset(f, 0, sizeof(wtFile));
+    f->path = strdup(path);
+
+    return f;
+}
+
+// Forget a file, with its tree and diagnostics
+void wtRemove(Watcher *w, uint32_t index) {
+    wtClear(w, &w->files[index]);
+    free(w->files[index].path);
+
+    w->size--;
+    memmove(&w->files[index], &w->files[index + 1], sizeof(wtFile) * (w->size - index));
+}
+
+// Index of the first file whose path isn't before `path`
+uint32_t wtLowerBound(Watcher *w, char *path) {
+    uint32_t low  = 0;
+    uint32_t high = w->size;
+
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (strcmp(w->files[middle].path, path) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+//
+// Events
+//
+
+// Read every queued event, returns whether any of them could have changed a file
+bool wtRead(Watcher *w) {
+    char buffer[65536] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+
+    while (true) {
+        ssize_t length = read(w->inotify, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            struct inotify_event *event = (struct inotify_event *)ptr;
+            if (wtEvent(w, event->wd, event->mask, event->len > 0 ? event->name : NULL)) {
+                changed = true;
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+// Mark the files an event is about, returns whether it could have changed a file
+bool wtEvent(Watcher *w, int wd, uint32_t mask, char *name) {
+    if (mask & IN_Q_OVERFLOW) {
+        w->rescan = true;
+        return true;
+    }
+
+    uint32_t index = wtFindDirectory(w, wd);
+    if (index == w->directoryCount) {
+        return false;
+    }
+
+    if (mask & IN_IGNORED) {
+        wtRemoveDirectory(w, index);
+        return false;
+    }
+
+    if (!name) {
+        return false;
+    }
+
+    char *dir  = w->directories[index].path;
+    char *path = (char *)malloc(strlen(dir) + strlen(name) + 2);
+    sprintf(path, "%s/%s", dir, name);
+
+    bool   changed = false;
+    size_t length  = strlen(path);
+
+    if (mask & IN_ISDIR) {
+        if (mask & (IN_CREATE | IN_MOVED_TO)) {
+            wtAddDirectory(w, path);
+            changed = true;
+        } else if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+            wtDropDirectory(w, path);
+            changed = true;
+        }
+    } else if (length > 4 && strcmp(path + length - 4, ".pas") == 0) {
+        // A file removed or moved out is only checked if it was known, the check finds it's gone and drops it
+        wtFile *f = wtFind(w, path, !(mask & (IN_DELETE | IN_MOVED_FROM)));
+        if (f) {
+            f->pending = true;
+            changed    = true;
+        }
+    }
+
+    free(path);
+
+    return changed;
+}
+
+//
+// Checking
+//
+
+// Check every pending file and print the diagnostics of the ones that changed, returns how many changed
+// Without `report`, only the files with errors are printed
+uint32_t wtCheckPending(Watcher *w, bool report) {
+    uint32_t changed = 0;
+
+    for (uint32_t i = 0; i < w->size;) {
+        wtFile *f = &w->files[i];
+        if (!f->pending) {
+            i++;
+            continue;
+        }
+
+        f->pending = false;
+
+        char *input = srReadFile(f->path);
+        if (!input) {
+            if (report) {
+                printf("%s: removido\n", f->path);
+            }
+            wtRemove(w, i);
+            changed++;
+            continue;
+        }
+
+        if (wtCheckFile(w, f, input)) {
+            if (report || f->errors->size > 0) {
+                wtReport(f);
+            }
+            changed++;
+        }
+
+        i++;
+    }
+
+    return changed;
+}
+
+// Check and parse the contents of a file, returns false if they're the same contents it had the last time
+// The file takes the input
+bool wtCheckFile(Watcher *w, wtFile *f, char *input) {
+    uint64_t hash = wtHash(input);
+    if (f->checked && f->hash == hash) {
+        free(input);
+        return false;
+    }
+
+    wtClear(w, f);
+
+    // The file keeps the tree, or the diagnostics when there's none
+    Lexer  *l = lNewWithKeywords(input, w->keywords);
+    Parser *p = pNewShared(l, NULL, NULL, w->tables);
+
+    f->program = pParseProgram(p);
+    f->errors  = p->errors;
+    p->errors  = eNew();
+
+    if (f->errors->size > 0) {
+        astProgramFree(f->program);
+        f->program = NULL;
+    }
+
+    pFree(p);
+    lFree(l);
+
+    f->hash    = hash;
+    f->checked = true;
+
+    if (f->errors->size > 0) {
+        w->failed++;
+    }
+
+    return true;
+}
+
+// Print the diagnostics of a file, in the same format as the check mode, or that it has none
+void wtReport(wtFile *f) {
+    if (f->errors->size == 0) {
+        printf("%s: OK\n", f->path);
+        return;
+    }
+
+    for (uint32_t i = 0; i < f->errors->size; i++) {
+        printf("%s: Erro %04d: %s\n", f->path, i + 1, f->errors->data[i]);
+    }
+}
+
+// Free the tree and diagnostics of a file
+void wtClear(Watcher *w, wtFile *f) {
+    if (!f->checked) {
+        return;
+    }
+
+    if (f->errors->size > 0) {
+        w->failed--;
+    }
+
+    if (f->program) {
+        astProgramFree(f->program);
+    }
+    eFree(f->errors);
+
+    f->program = NULL;
+    f->errors  = NULL;
+    f->checked = false;
+}
+
+// 64-bit FNV-1a hash of the contents of a file
+uint64_t wtHash(char *data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (unsigned char *ch = (unsigned char *)data; *ch; ch++) {
+        hash = (hash ^ *ch) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// Monotonic time in milliseconds
+double wtMilliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+#endif  // __linux__
\ No newline at end of file
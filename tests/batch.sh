@@ -0,0 +1,57 @@
+#!/bin/sh
+# Compara --batch com uma thread, com várias threads e --shards com vários processos sobre o mesmo corpus gerado,
+# conferindo as mensagens, o código de saída e as árvores escritas ao lado de cada entrada
+# O corpus mistura programas válidos, estragados, aumentados até alguns centos de KB e um arquivo que não existe,
+# para que as threads roubem tarefas umas das outras e terminem fora de ordem
+# Uso: tests/batch.sh [primeira semente] [última semente] [threads] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-100}
+threads=${3:-8}
+psa=${4:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+mkdir "$tmp/corpus"
+for seed in $(seq "$first" "$last"); do
+    python3 "$dir/gen.py" "$seed" > "$tmp/corpus/p$seed.pas"
+    python3 "$dir/mutate.py" "$tmp/corpus/p$seed.pas" "$seed" > "$tmp/corpus/m$seed.pas"
+
+    # Uma semente em dez ganha uma versão com o bloco principal repetido
+    if [ $((seed % 10)) -eq 0 ]; then
+        awk '/^begin$/ { main = NR } { line[NR] = $0 } END {
+            for (i = 1; i <= main; i++) print line[i]
+            for (k = 0; k < 100; k++) for (i = main + 1; i < NR; i++) print line[i]
+            print line[NR]
+        }' "$tmp/corpus/p$seed.pas" > "$tmp/corpus/g$seed.pas"
+    fi
+done
+
+# Roda "$@" em uma cópia do corpus, com caminhos relativos para que as mensagens não dependam da pasta
+run() {
+    name=$1
+    shift
+    cp -r "$tmp/corpus" "$tmp/$name"
+    (cd "$tmp/$name" && "$psa" "$@" $(ls) ausente.pas > "$tmp/$name.log" 2>&1; echo "saída $?" >> "$tmp/$name.log")
+}
+
+run um --batch -j 1
+run threads --batch -j "$threads"
+run shards --shards -j "$threads"
+
+failed=0
+for name in threads shards; do
+    if ! cmp -s "$tmp/um.log" "$tmp/$name.log"; then
+        echo "$name: mensagens diferentes de --batch -j 1"
+        diff "$tmp/um.log" "$tmp/$name.log" | head -5
+        failed=$((failed + 1))
+    fi
+    if ! diff -r -q "$tmp/um" "$tmp/$name" > "$tmp/diff"; then
+        echo "$name: árvores diferentes de --batch -j 1"
+        head -5 "$tmp/diff"
+        failed=$((failed + 1))
+    fi
+done
+
+echo "$(ls "$tmp/corpus" | wc -l) arquivos, $(ls "$tmp/um" | grep -c '\.ast$') árvores, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Gera programas com gen.py e uma versão estragada de cada um com mutate.py, e passa todos para um programa de checagem
+# Uso: tests/check.sh <checagem> [primeira semente] [última semente]
+dir=$(cd "$(dirname "$0")" && pwd)
+check=$1
+first=${2:-1}
+last=${3:-200}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+for seed in $(seq "$first" "$last"); do
+    python3 "$dir/gen.py" "$seed" > "$tmp/p$seed.pas"
+    python3 "$dir/mutate.py" "$tmp/p$seed.pas" "$seed" > "$tmp/m$seed.pas"
+done
+
+"$check" "$tmp"/*.pas
\ No newline at end of file
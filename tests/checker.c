@@ -0,0 +1,68 @@
+// Compara os erros do verificador de sintaxe, usado por --check, com os do analisador que constrói a árvore
+// Os dois seguem a mesma gramática em código separado, então devem dar as mesmas mensagens na mesma ordem
+// Uso: CheckerCheck <entrada>...
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checker.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+
+bool compareFile(char *file);
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!compareFile(argv[i])) {
+            failed++;
+        }
+    }
+
+    printf("%d arquivo(s), %d diferença(s)\n", argc - 1, failed);
+
+    return failed > 0;
+}
+
+// Parse and check the file, printing both lists of errors when they differ
+bool compareFile(char *file) {
+    char *input = srReadFile(file);
+    if (!input) {
+        printf("%s: não foi possível abrir o arquivo\n", file);
+        return false;
+    }
+
+    Lexer      *l       = lNew(input);
+    Parser     *p       = pNew(l);
+    astProgram *program = pParseProgram(p);
+
+    Lexer   *cl = lNew(srReadFile(file));
+    Checker *c  = cNew(cl);
+    cCheckProgram(c);
+
+    bool same = p->errors->size == c->errors->size;
+    for (uint32_t i = 0; same && i < p->errors->size; i++) {
+        same = strcmp(p->errors->data[i], c->errors->data[i]) == 0;
+    }
+    if (!same) {
+        printf("%s: %u erro(s) no analisador contra %u no verificador\n", file, p->errors->size, c->errors->size);
+        for (uint32_t i = 0; i < p->errors->size; i++) {
+            printf("  analisador: %s\n", p->errors->data[i]);
+        }
+        for (uint32_t i = 0; i < c->errors->size; i++) {
+            printf("  verificador: %s\n", c->errors->data[i]);
+        }
+    }
+
+    cFree(c);
+    lFree(cl);
+    astProgramFree(program);
+    pFree(p);
+    lFree(l);
+
+    return same;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+# Gera um programa Pascal com multiplicações, `div` e `mod` por constantes, para exercitar a troca dessas operações por
+# deslocamentos e multiplicações pela parte alta no código nativo
+# As constantes são positivas e negativas, potências de dois até 2^62, vizinhas das potências, divisores pequenos e
+# divisores grandes de até 63 bits, e os dividendos incluem os vizinhos de INT_MIN e INT_MAX
+# Uso: python3 tests/consts.py <semente>
+import random
+import sys
+
+r = random.Random(int(sys.argv[1]))
+
+INT_MAX = (1 << 63) - 1
+NAMES = ['a', 'b', 'c', 'd', 'e', 'f', 'g', 'h']
+
+
+def literal(value):
+    # -2^63 não tem literal, é escrito como uma subtração
+    if value == -INT_MAX - 1:
+        return '(-%d - 1)' % INT_MAX
+    return str(value) if value >= 0 else '-%d' % -value
+
+
+def constant():
+    k = r.random()
+    if k < 0.35:
+        value = 1 << r.randint(0, 62)
+    elif k < 0.5:
+        value = (1 << r.randint(1, 62)) + r.choice([-1, 1])
+    elif k < 0.7:
+        value = r.choice([3, 5, 6, 7, 9, 10, 12, 25, 100, 641, 1000, 1 << 31, (1 << 32) + 1, 1000000007])
+    elif k < 0.9:
+        value = r.randint(2, INT_MAX)
+    else:
+        value = r.choice([INT_MAX, INT_MAX - 1, (1 << 62) + 1, 1 << 32, 1 << 31])
+    return value if r.random() < 0.5 else -value
+
+
+def dividend():
+    k = r.random()
+    if k < 0.3:
+        return r.choice([-INT_MAX - 1, -INT_MAX, -INT_MAX + 1, INT_MAX, INT_MAX - 1, -1, 0, 1])
+    if k < 0.6:
+        return r.randint(-1000, 1000)
+    return r.randint(-INT_MAX - 1, INT_MAX)
+
+
+def expression(depth=0):
+    if depth > 2 or r.random() < 0.4:
+        return r.choice(NAMES)
+    return '(%s %s %s)' % (expression(depth + 1), r.choice(['div', 'mod', '*', 'div', 'mod']), literal(constant()))
+
+
+out = ['program consts;', 'var', '   %s : integer;' % ', '.join(NAMES), '   i : integer;', 'begin']
+out += ['    %s := %s;' % (name, literal(dividend())) for name in NAMES]
+for _ in range(r.randint(20, 40)):
+    out.append('    %s := %s;' % (r.choice(NAMES), expression()))
+
+# Um laço mantém as constantes dentro dele, com os dividendos mudando a cada volta
+out += ['    i := 0;', '    while i < 6 do begin']
+for _ in range(r.randint(3, 8)):
+    out.append('        %s := %s + %s;' % (r.choice(NAMES), expression(1), r.choice(NAMES + ['i'])))
+out += ['        i := i + 1;', '    end', 'end.']
+print('\n'.join(out))
\ No newline at end of file
@@ -0,0 +1,196 @@
+// Compara o bytecode de dcCompile, escrito durante a análise, com o de bcCompile, escrito a partir da árvore tipada
+// Os dois devem dar os mesmos erros e as mesmas funções, instruções e variáveis globais
+// As linhas só são comparadas nas instruções que podem falhar, as únicas que aparecem em uma mensagem
+// Uso: DirectCheck <entrada>...
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bytecode.h"
+#include "direct.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "types.h"
+
+bool compareFile(char *file);
+bool compareErrors(char *file, eErrorList *tree, eErrorList *direct);
+bool compareFunction(char *file, bcProgram *tree, bcProgram *direct, uint32_t index);
+bool compareConstants(bcProgram *tree, bcProgram *direct, uint32_t a, uint32_t b);
+bool isString(bcProgram *program, uint32_t constant);
+bool canFail(bcOp op);
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!compareFile(argv[i])) {
+            failed++;
+        }
+    }
+
+    printf("%d arquivo(s), %d diferença(s)\n", argc - 1, failed);
+
+    return failed > 0;
+}
+
+// Compile the file both ways and print the first difference
+bool compareFile(char *file) {
+    char *input = srReadFile(file);
+    if (!input) {
+        printf("%s: não foi possível abrir o arquivo\n", file);
+        return false;
+    }
+
+    Lexer      *l       = lNew(input);
+    Parser     *p       = pNew(l);
+    astProgram *program = pParseProgram(p);
+    eErrorList *errors  = p->errors;
+
+    TypeChecker *y    = NULL;
+    bcProgram   *tree = NULL;
+    if (errors->size == 0) {
+        y = tyNew();
+        tyCheck(y, program);
+        errors = y->errors;
+    }
+    if (errors->size == 0) {
+        tree = bcCompile(y, program, errors);
+    }
+
+    Lexer      *dl           = lNew(srReadFile(file));
+    eErrorList *directErrors = eNew();
+    bcProgram  *direct       = dcCompile(dl, directErrors);
+
+    bool same = compareErrors(file, errors, directErrors);
+    if (same && !tree != !direct) {
+        printf("%s: só um dos compiladores escreveu o programa\n", file);
+        same = false;
+    }
+    if (same && tree && tree->size != direct->size) {
+        printf("%s: %u funções contra %u\n", file, tree->size, direct->size);
+        same = false;
+    }
+    for (uint32_t i = 0; same && tree && i < tree->size; i++) {
+        same = compareFunction(file, tree, direct, i);
+    }
+    if (same && tree && tree->globalSize != direct->globalSize) {
+        printf("%s: %u variáveis globais contra %u\n", file, tree->globalSize, direct->globalSize);
+        same = false;
+    }
+    for (uint32_t i = 0; same && tree && i < tree->globalSize; i++) {
+        bcGlobal a = tree->globals[i];
+        bcGlobal b = direct->globals[i];
+        if (strcmp(a.name, b.name) != 0 || a.type != b.type || a.slot != b.slot) {
+            printf("%s: variável global %u: %s contra %s\n", file, i, a.name, b.name);
+            same = false;
+        }
+    }
+
+    if (tree) {
+        bcFree(tree);
+    }
+    if (direct) {
+        bcFree(direct);
+    }
+    if (y) {
+        tyFree(y);
+    }
+    eFree(directErrors);
+    astProgramFree(program);
+    pFree(p);
+    lFree(l);
+    lFree(dl);
+
+    return same;
+}
+
+// Both compilers must report the same messages in the same order
+bool compareErrors(char *file, eErrorList *tree, eErrorList *direct) {
+    if (tree->size != direct->size) {
+        printf("%s: %u erro(s) contra %u\n", file, tree->size, direct->size);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tree->size; i++) {
+        if (strcmp(tree->data[i], direct->data[i]) != 0) {
+            printf("%s: erro %u\n  árvore: %s\n  direto: %s\n", file, i + 1, tree->data[i], direct->data[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Compare the header and the instructions of a function, constants by value since both pools are built in order
+bool compareFunction(char *file, bcProgram *tree, bcProgram *direct, uint32_t index) {
+    bcFunction *a = &tree->functions[index];
+    bcFunction *b = &direct->functions[index];
+
+    if (strcmp(a->name, b->name) != 0 || a->parameters != b->parameters || a->result != b->result ||
+        a->registers != b->registers || a->depth != b->depth || a->size != b->size) {
+        printf("%s: função %s: %u parâmetros, resultado %u, %u registradores, profundidade %u e %u instruções "
+               "contra %u, %u, %u, %u e %u\n",
+               file, a->name, a->parameters, a->result, a->registers, a->depth, a->size, b->parameters, b->result,
+               b->registers, b->depth, b->size);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < a->size; i++) {
+        bcInstr x = a->code[i];
+        bcInstr y = b->code[i];
+
+        bool same = x.op == y.op && x.a == y.a && x.b == y.b;
+        if (same && x.op == BC_LOADK) {
+            same = compareConstants(tree, direct, x.c, y.c);
+        } else if (same) {
+            same = x.c == y.c;
+        }
+        if (!same) {
+            printf("%s: função %s, instrução %u: %s %u %u %u contra %s %u %u %u\n", file, a->name, i,
+                   bcOpName(x.op), x.a, x.b, x.c, bcOpName(y.op), y.a, y.b, y.c);
+            return false;
+        }
+
+        if (canFail(x.op) && a->lines[i] != b->lines[i]) {
+            printf("%s: função %s, instrução %u: %s na linha %" PRIu64 " contra %" PRIu64 "\n", file, a->name, i,
+                   bcOpName(x.op), a->lines[i], b->lines[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Strings are compared by their text, every other constant by its bits
+bool compareConstants(bcProgram *tree, bcProgram *direct, uint32_t a, uint32_t b) {
+    bcValue x = tree->constants[a];
+    bcValue y = direct->constants[b];
+
+    if (isString(tree, a) || isString(direct, b)) {
+        return isString(tree, a) && isString(direct, b) && strcmp(x.s, y.s) == 0;
+    }
+
+    return x.i == y.i;
+}
+
+// Tell if a constant points to one of the strings owned by the program
+bool isString(bcProgram *program, uint32_t constant) {
+    char *s = program->constants[constant].s;
+
+    for (uint32_t i = 0; s && i < program->stringSize; i++) {
+        if (program->strings[i] == s) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Instructions whose line can appear in a runtime error
+bool canFail(bcOp op) {
+    return op == BC_DIVI || op == BC_MODI || op == BC_DIVF || op == BC_CALL;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Compara a saída de --run com a do programa gerado por --emit-asm, com e sem -O, e montado com o cc, em programas
+# gerados por gen.py sem strings, que o código nativo não suporta, e por consts.py, com multiplicações e divisões por
+# constantes
+# Uso: tests/emitasm.sh [primeira semente] [última semente] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-200}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+failed=0
+total=0
+for seed in $(seq "$first" "$last"); do
+    python3 "$dir/gen.py" "$seed" --sem-string > "$tmp/g$seed.pas"
+    python3 "$dir/consts.py" "$seed" > "$tmp/k$seed.pas"
+
+    for name in "g$seed" "k$seed"; do
+        pas=$tmp/$name.pas
+
+        # Um erro de execução sai em stderr nos dois, com o nome do arquivo só no --run
+        "$psa" --run "$pas" 2>&1 | sed "s|^$pas: Erro 0001: ||" > "$tmp/vm"
+        for flag in "" -O; do
+            total=$((total + 1))
+            if ! "$psa" --emit-asm $flag "$pas" "$tmp/$name.s" > /dev/null 2>&1 ||
+                ! cc -o "$tmp/$name" "$tmp/$name.s" 2> "$tmp/cc"; then
+                echo "$name $flag: o assembly gerado não monta"
+                head -5 "$tmp/cc"
+                failed=$((failed + 1))
+                continue
+            fi
+
+            "$tmp/$name" > "$tmp/native" 2>&1
+            if ! cmp -s "$tmp/vm" "$tmp/native"; then
+                echo "$name $flag: saídas diferentes"
+                diff "$tmp/vm" "$tmp/native" | head -5
+                failed=$((failed + 1))
+            fi
+        done
+    done
+done
+
+echo "$total programas, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
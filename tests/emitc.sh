@@ -0,0 +1,38 @@
+#!/bin/sh
+# Compara a saída de --run com a do programa gerado por --emit-c, com e sem -O, e compilado com o gcc -O2, em programas
+# gerados
+# Uso: tests/emitc.sh [primeira semente] [última semente] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-200}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+failed=0
+for seed in $(seq "$first" "$last"); do
+    pas=$tmp/p$seed.pas
+    python3 "$dir/gen.py" "$seed" > "$pas"
+
+    # Um erro de execução sai em stderr nos dois, com o nome do arquivo só no --run
+    vm=$("$psa" --run "$pas" 2>&1 | sed "s|^$pas: Erro 0001: ||")
+    for flag in "" -O; do
+        if ! "$psa" --emit-c $flag "$pas" "$tmp/p$seed.c" > /dev/null 2>&1 ||
+            ! gcc -std=c99 -O2 -Wall -Wextra -Wno-unused -Wno-tautological-compare -Werror -o "$tmp/p$seed" \
+                "$tmp/p$seed.c" 2> "$tmp/cc"; then
+            echo "semente $seed $flag: o C gerado não compila"
+            head -5 "$tmp/cc"
+            failed=$((failed + 1))
+            continue
+        fi
+
+        c=$("$tmp/p$seed" 2>&1)
+        if [ "$vm" != "$c" ]; then
+            echo "semente $seed $flag: saídas diferentes"
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+echo "$((last - first + 1)) programas, com e sem -O, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
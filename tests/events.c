@@ -0,0 +1,81 @@
+// Compara a árvore montada a partir dos eventos do verificador, em evParseProgram, com a do analisador
+// Os erros devem ser os mesmos e, sem erros, as duas árvores devem ser escritas com o mesmo texto
+// Uso: EventsCheck <entrada>...
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast.h"
+#include "events.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+
+bool compareFile(char *file);
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!compareFile(argv[i])) {
+            failed++;
+        }
+    }
+
+    printf("%d arquivo(s), %d diferença(s)\n", argc - 1, failed);
+
+    return failed > 0;
+}
+
+// Build both trees and compare the errors, then the text of the trees when there are none
+bool compareFile(char *file) {
+    char *input = srReadFile(file);
+    if (!input) {
+        printf("%s: não foi possível abrir o arquivo\n", file);
+        return false;
+    }
+
+    Lexer      *l       = lNew(input);
+    Parser     *p       = pNew(l);
+    astProgram *program = pParseProgram(p);
+
+    Lexer      *el = lNew(srReadFile(file));
+    eErrorList *errors;
+    astProgram *built = evParseProgram(el, &errors);
+
+    bool same = p->errors->size == errors->size;
+    for (uint32_t i = 0; same && i < errors->size; i++) {
+        same = strcmp(p->errors->data[i], errors->data[i]) == 0;
+    }
+    if (!same) {
+        printf("%s: %u erro(s) no analisador contra %u nos eventos\n", file, p->errors->size, errors->size);
+        for (uint32_t i = 0; i < p->errors->size; i++) {
+            printf("  analisador: %s\n", p->errors->data[i]);
+        }
+        for (uint32_t i = 0; i < errors->size; i++) {
+            printf("  eventos: %s\n", errors->data[i]);
+        }
+    }
+
+    if (same && errors->size == 0) {
+        char *a = astProgramToString(program);
+        char *b = astProgramToString(built);
+        same    = strcmp(a, b) == 0;
+        if (!same) {
+            printf("%s: árvores diferentes\n", file);
+        }
+        free(a);
+        free(b);
+    }
+
+    astProgramFree(built);
+    eFree(errors);
+    lFree(el);
+    astProgramFree(program);
+    pFree(p);
+    lFree(l);
+
+    return same;
+}
\ No newline at end of file
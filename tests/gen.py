@@ -0,0 +1,250 @@
+# Gera um programa Pascal aleatório que o verificador de tipos aceita e que termina
+# As chamadas só descem enquanto o parâmetro `dd` é positivo, e os laços contam até no máximo 4
+# Funções sem efeitos só leem as próprias variáveis, as outras recebem parâmetros `var`, declaram funções aninhadas e
+# são chamadas no meio das expressões, para que a ordem de avaliação conte
+# Uso: python3 tests/gen.py <semente> [--sem-string]
+import random
+import sys
+
+TYPES = ['integer', 'real', 'boolean', 'char', 'string']
+if '--sem-string' in sys.argv:
+    TYPES.remove('string')
+
+class Fn:
+    def __init__(s, name, params, ret, pure, depth):
+        s.name, s.params, s.ret, s.pure, s.depth = name, params, ret, pure, depth
+
+class Gen:
+    def __init__(s, seed):
+        s.r = random.Random(seed)
+        s.n = 0
+
+    def fresh(s, p):
+        s.n += 1
+        return '%s%d' % (p, s.n)
+
+    # Escopos: lista de dicionários, vars {nome: (tipo, atribuível, legível)} e as funções declaradas
+    def lit(s, t):
+        r = s.r
+        if t == 'integer': return str(r.choice([0, 1, 2, 3, 7, 10, 100, 12345, 2147483647, r.randint(0, 1000)]))
+        if t == 'real': return r.choice(['0.5', '1.25', '3.0', '100.125', '0.1', '2.0'])
+        if t == 'boolean': return r.choice(['true', 'false'])
+        if t == 'char': return "'%s'" % r.choice('abcxyzAZ09')
+        return '"%s"' % ''.join(r.choice('abcXY?z') for _ in range(r.randint(0, 4)))
+
+    def visible(s, scopes, t, assignable=False):
+        out = []
+        seen = set()
+        for sc in reversed(scopes):
+            for name, (vt, asg, readable) in sc['vars'].items():
+                if name in seen: continue
+                seen.add(name)
+                if vt == t and (asg if assignable else readable):
+                    out.append(name)
+        return out
+
+    def fns(s, scopes, pure_only):
+        out = []
+        for sc in scopes:
+            for f in sc['fns']:
+                if not pure_only or f.pure:
+                    out.append(f)
+        return out
+
+    def expr(s, scopes, t, d, pure):
+        r = s.r
+        vs = s.visible(scopes, t)
+        if pure:
+            vs = [v for v in vs if s.local_ok(scopes, v)]
+        if d <= 0 or r.random() < 0.25:
+            if vs and r.random() < 0.6: return r.choice(vs)
+            if t == 'integer' and r.random() < 0.2: return '(-%s)' % s.lit(t)
+            return s.lit(t)
+        if t == 'integer' and not pure and r.random() < 0.2:
+            # Uma variável lida ao lado de uma chamada que a recebe como `var`, só a ordem diz qual valor é lido
+            fs = [f for f in s.fns(scopes, False) if f.ret == t and any(ref and pt == t for _, pt, ref in f.params)]
+            ws = [v for v in s.visible(scopes, t, True) if v in s.visible(scopes, t)]
+            if fs and ws:
+                v = r.choice(ws)
+                c = s.call(scopes, r.choice(fs), d - 1, pure, v)
+                if c:
+                    a, b = (v, c) if r.random() < 0.5 else (c, v)
+                    return '(%s %s %s)' % (a, r.choice(['+', '-', '*', 'div', 'mod']), b)
+        k = r.random()
+        if k < (0.12 if pure else 0.3):
+            cands = [f for f in s.fns(scopes, pure) if f.ret == t]
+            if cands:
+                c = s.call(scopes, r.choice(cands), d - 1, pure)
+                if c:
+                    return c
+        if t == 'integer':
+            op = r.choice(['+', '-', '*', 'div', 'mod', 'neg', '+', '-'])
+            if op == 'neg': return '-' + s.paren(s.expr(scopes, t, d - 1, pure))
+            if op in ('div', 'mod') and r.random() < 0.8:
+                divisor = r.choice(['1', '2', '3', '7', '-1', '-4', '1000'])
+                return '(%s %s %s)' % (s.expr(scopes, t, d - 1, pure), op, divisor)
+            return '(%s %s %s)' % (s.expr(scopes, t, d - 1, pure), op, s.expr(scopes, t, d - 1, pure))
+        if t == 'real':
+            op = r.choice(['+', '-', '*', '/', 'mix', 'neg'])
+            if op == 'mix':
+                a, b = s.expr(scopes, 'integer', d - 1, pure), s.expr(scopes, 'real', d - 1, pure)
+                return '(%s %s %s)' % (a, r.choice('+-*'), b)
+            if op == 'neg': return '-' + s.paren(s.expr(scopes, t, d - 1, pure))
+            if op == '/' and r.random() < 0.8:
+                return '(%s / %s)' % (s.expr(scopes, t, d - 1, pure), r.choice(['2.0', '0.1', '3.0', '7']))
+            return '(%s %s %s)' % (s.expr(scopes, t, d - 1, pure), op, s.expr(scopes, t, d - 1, pure))
+        if t == 'boolean':
+            k = r.random()
+            if k < 0.3:
+                a, b = s.expr(scopes, t, d - 1, pure), s.expr(scopes, t, d - 1, pure)
+                return '(%s %s %s)' % (a, r.choice(['and', 'or', 'and', '=', '<>']), b)
+            if k < 0.4: return '(not %s)' % s.expr(scopes, t, d - 1, pure)
+            ct = r.choice(['integer', 'integer', 'real'] + TYPES[3:])
+            a, b = s.expr(scopes, ct, d - 1, pure), s.expr(scopes, ct, d - 1, pure)
+            return '(%s %s %s)' % (a, r.choice(['<', '>', '<=', '>=', '=', '<>']), b)
+        if t == 'char':
+            return vs and r.choice(vs) or s.lit(t)
+        # string, um dos lados é literal para que os laços não dobrem o tamanho a cada volta
+        a = s.expr(scopes, r.choice(['string', 'char']), d - 1, pure)
+        b = s.lit('string')
+        return '(%s + %s)' % ((a, b) if r.random() < 0.5 else (b, a))
+
+    def local_ok(s, scopes, v):
+        # Uma função sem efeitos só usa as próprias variáveis e parâmetros
+        return v in scopes[-1]['vars']
+
+    def paren(s, e):
+        return e if e.startswith('(') else '(' + e + ')'
+
+    def call(s, scopes, f, d, pure, var=None):
+        args = ['(dd - 1)' if 'dd' in scopes[-1]['vars'] else str(s.r.randint(0, 3))]
+        for (pn, pt, ref) in f.params[1:]:
+            if ref and var and pt == 'integer':
+                args.append(var)
+                var = None
+            elif ref:
+                readable = s.visible(scopes, pt)
+                cands = [c for c in s.visible(scopes, pt, True) if c in readable]
+                if pure: cands = [c for c in cands if s.local_ok(scopes, c)]
+                if not cands: return None
+                args.append(s.r.choice(cands))
+            else:
+                args.append(s.expr(scopes, pt, min(d, 2), pure))
+        return '%s(%s)' % (f.name, ', '.join(args))
+
+    def stmts(s, scopes, n, ind, pure, loopdepth):
+        return ''.join(s.stmt(scopes, ind, pure, loopdepth) for _ in range(n))
+
+    def body(s, scopes, ind, pure, loopdepth, extra=''):
+        # Um begin..end ou um único comando, depois de `then`, `else` ou `do`
+        sp = '    ' * ind
+        if s.r.random() < 0.5 or extra:
+            inner = s.stmts(scopes, s.r.randint(1, 3), ind + 1, pure, loopdepth) + extra
+            return 'begin\n%s%send\n' % (inner, sp), True
+        return s.stmt(scopes, ind + 1, pure, loopdepth).lstrip(' ').rstrip('\n') + '\n', False
+
+    def stmt(s, scopes, ind, pure, loopdepth):
+        r = s.r
+        sp = '    ' * ind
+        k = r.random()
+        if k < 0.15 and loopdepth < 2:
+            lc = scopes[-1]['loops'][loopdepth]
+            b, _ = s.body(scopes, ind, pure, loopdepth + 1, '%s    %s := %s + 1;\n' % (sp, lc, lc))
+            return '%s%s := 0;\n%swhile %s < %d do %s' % (sp, lc, sp, lc, r.randint(0, 4), b)
+        if k < 0.3:
+            c = s.expr(scopes, 'boolean', 2, pure)
+            a, _ = s.body(scopes, ind, pure, loopdepth)
+            text = '%sif %s then %s' % (sp, c, a)
+            if r.random() < 0.5 and (a.startswith('begin') or a.rstrip().endswith(';')):
+                b, _ = s.body(scopes, ind, pure, loopdepth)
+                text += '%selse %s' % (sp, b)
+            return text
+        if k < 0.45 and not pure:
+            cands = [f for f in s.fns(scopes, False)]
+            if cands:
+                f = r.choice(cands)
+                c = s.call(scopes, f, 2, False)
+                if c and f.ret is None:
+                    return sp + c + ';\n'
+                tgt = s.visible(scopes, f.ret, True)
+                if c and tgt:
+                    return '%s%s := %s;\n' % (sp, r.choice(tgt), c)
+        # Atribuição
+        t = r.choice(TYPES)
+        tgt = s.visible(scopes, t, True)
+        if pure: tgt = [v for v in tgt if s.local_ok(scopes, v)]
+        if not tgt:
+            t = 'integer'
+            tgt = [scopes[-1]['scratch']]
+        st = t
+        if t == 'real' and r.random() < 0.2: st = 'integer'
+        if t == 'string' and r.random() < 0.2: st = 'char'
+        return '%s%s := %s;\n' % (sp, r.choice(tgt), s.expr(scopes, st, 3, pure))
+
+    def decls(s, vs, ind):
+        sp = '    ' * ind
+        if not vs: return ''
+        return sp + 'var\n' + ''.join('%s   %s : %s;\n' % (sp, n, t) for n, t in vs)
+
+    def function(s, scopes, depth, ind):
+        r = s.r
+        pure = r.random() < 0.4
+        name = s.fresh('fn')
+        ret = r.choice(TYPES + [None, None])
+        params = [('dd', 'integer', False)]
+        for _ in range(r.randint(0, 3)):
+            ref = (not pure) and r.random() < 0.35
+            params.append((s.fresh('p'), 'integer' if ref and r.random() < 0.5 else r.choice(TYPES), ref))
+        if not pure and ret == 'integer' and r.random() < 0.7:
+            params.append((s.fresh('p'), 'integer', True))
+        f = Fn(name, params, ret, pure, depth)
+        sc = {'vars': {}, 'fns': [], 'loops': [s.fresh('lc'), s.fresh('lc')], 'result': name if ret else None,
+              'rtype': ret}
+        for pn, pt, ref in params:
+            sc['vars'][pn] = (pt, pn != 'dd', True)
+        if ret:
+            sc['vars'][name] = (ret, True, False)
+        sc['scratch'] = s.fresh('l')
+        locs = [(l, 'integer') for l in sc['loops']] + [(sc['scratch'], 'integer')]
+        locs += [(s.fresh('l'), r.choice(TYPES)) for _ in range(r.randint(0, 3))]
+        for n, t in locs:
+            sc['vars'][n] = (t, n not in sc['loops'], True)
+        scopes[-1]['fns'].append(f)  # Visível para a recursão e depois dela
+        inner = scopes + [sc]
+        nested = ''
+        if depth < 3 and not pure:
+            for _ in range(r.randint(0, 2)):
+                nested += s.function(inner, depth + 1, ind + 1)
+        body = s.stmts(inner, r.randint(1, 4), ind + 2, pure, 0)
+        # Os parâmetros `var` inteiros mudam a cada chamada, e o resultado depende deles
+        bumps = [pn for pn, pt, ref in params if ref and pt == 'integer']
+        for pn in bumps:
+            body = '%s%s := %s + 1;\n' % ('    ' * (ind + 2), pn, pn) + body
+        if bumps and ret == 'integer':
+            body += '%s%s := %s;\n' % ('    ' * (ind + 2), name, ' + '.join(bumps))
+        sp = '    ' * ind
+        # O corpo só roda enquanto dd > 0
+        ps = []
+        for pn, pt, ref in params:
+            ps.append('%s%s: %s' % ('var ' if ref else '', pn, pt))
+        head = '%s%s %s(%s)%s;\n' % (sp, 'function' if ret else 'procedure', name, '; '.join(ps),
+                                     ': ' + ret if ret else '')
+        guarded = '%sbegin\n%s    if dd > 0 then\n%s    begin\n%s%s    end\n%send\n' % (sp, sp, sp, body, sp, sp)
+        text = head + s.decls(locs, ind) + nested + guarded
+        return text
+
+    def program(s):
+        r = s.r
+        sc = {'vars': {}, 'fns': [], 'loops': ['g0', 'g1'], 'result': None, 'rtype': None, 'scratch': 'g2'}
+        gs = [('g0', 'integer'), ('g1', 'integer'), ('g2', 'integer')]
+        gs += [(s.fresh('v'), t) for t in TYPES for _ in range(r.randint(1, 2))]
+        for n, t in gs:
+            sc['vars'][n] = (t, n not in sc['loops'], True)
+        scopes = [sc]
+        fns = ''
+        for _ in range(r.randint(1, 4)):
+            fns += s.function(scopes, 1, 0)
+        body = s.stmts(scopes, r.randint(3, 8), 1, False, 0)
+        return 'program prog;\n' + s.decls(gs, 0) + fns + 'begin\n' + body + 'end.\n'
+
+print(Gen(int(sys.argv[1])).program(), end='')
\ No newline at end of file
@@ -0,0 +1,419 @@
+// Executa a forma SSA de cada programa, antes e depois de irOptimize, e compara com a máquina virtual
+// Os três devem parar no mesmo erro de execução, com a mesma linha, ou deixar os mesmos valores nas variáveis globais
+// Uso: IRCheck <entrada>...
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bytecode.h"
+#include "error.h"
+#include "ir.h"
+#include "lexer.h"
+#include "parser.h"
+#include "reader.h"
+#include "symbols.h"
+#include "types.h"
+#include "vm.h"
+
+#define TEXT(s) ((s) ? (s) : "")
+
+// Frame of a running function, variables in memory are indexed by symbol like the SSA values by instruction
+typedef struct Frame {
+    bcValue      *memory;  // Variables in memory, a reference parameter holds the address it points to
+    bcValue      *values;  // Value of each instruction
+    struct Frame *link;    // Frame of the function the function is declared in
+    uint32_t      depth;   // Scope depth of the body
+} Frame;
+
+// Interpreter of the SSA form
+typedef struct {
+    irProgram *p;
+    uint32_t  *functionOf;  // Function of each function symbol
+    uint32_t   calls;       // Calls in progress
+    bool       failed;      // Stopped on a runtime error
+    char       error[320];  // Message of the error
+} Machine;
+
+// Program to check and the output of each run
+typedef struct {
+    char *file;
+    char *vm;
+    char *plain;
+    char *optimized;
+} Check;
+
+bool     checkFile(char *file);
+void    *checkMain(void *arg);
+char    *runVM(TypeChecker *y, astProgram *program);
+char    *runSSA(irProgram *p);
+bcValue  mCall(Machine *m, uint32_t index, Frame *link, bcValue *arguments, bcValue *results);
+bcValue  mExecute(Machine *m, irFunction *f, Frame *frame, bcValue *results);
+void     mFail(Machine *m, uint64_t line, char *function, char *msg);
+Frame   *mFrameAt(Frame *frame, uint32_t depth);
+bcValue *mAddress(Machine *m, Frame *frame, uint32_t symbol);
+void     printGlobal(FILE *out, sySymbol *s, bcValue value);
+
+int main(int argc, char *argv[]) {
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!checkFile(argv[i])) {
+            failed++;
+        }
+    }
+
+    printf("%d arquivo(s), %d diferença(s)\n", argc - 1, failed);
+
+    return failed > 0;
+}
+
+// Run the file the three ways and print the first difference, on a thread with the stack the construction needs
+bool checkFile(char *file) {
+    Check c = {file, NULL, NULL, NULL};
+
+    pthread_attr_t attributes;
+    pthread_t      thread;
+    pthread_attr_init(&attributes);
+    if (pthread_attr_setstacksize(&attributes, IR_STACK_SIZE) != 0 ||
+        pthread_create(&thread, &attributes, checkMain, &c) != 0) {
+        checkMain(&c);
+    } else {
+        pthread_join(thread, NULL);
+    }
+    pthread_attr_destroy(&attributes);
+
+    bool same = c.vm && c.plain && c.optimized && strcmp(c.vm, c.plain) == 0 && strcmp(c.vm, c.optimized) == 0;
+    if (!c.vm) {
+        printf("%s: não foi possível abrir o arquivo\n", file);
+    } else if (!same) {
+        char *other = strcmp(c.vm, c.plain) != 0 ? c.plain : c.optimized;
+        printf("%s: %s difere da máquina virtual\n", file, other == c.plain ? "SSA" : "SSA otimizada");
+        printf("  vm:  %.200s\n  ssa: %.200s\n", c.vm, other);
+    }
+
+    free(c.vm);
+    free(c.plain);
+    free(c.optimized);
+
+    return same;
+}
+
+// Compile and run the file on the VM, then build the SSA form and run it before and after the passes
+void *checkMain(void *arg) {
+    Check *c     = (Check *)arg;
+    char  *input = srReadFile(c->file);
+    if (!input) {
+        return NULL;
+    }
+
+    Lexer      *l       = lNew(input);
+    Parser     *p       = pNew(l);
+    astProgram *program = pParseProgram(p);
+
+    // Programs that don't compile have nothing to run, the VM's output stands for all three
+    TypeChecker *y = NULL;
+    if (p->errors->size == 0) {
+        y = tyNew();
+        tyCheck(y, program);
+    }
+    if (y && y->errors->size == 0) {
+        c->vm = runVM(y, program);
+
+        irProgram *ir = irBuild(y, program);
+        c->plain      = runSSA(ir);
+        irOptimize(ir);
+        c->optimized = runSSA(ir);
+        irFree(ir);
+    } else {
+        c->vm        = strdup("");
+        c->plain     = strdup("");
+        c->optimized = strdup("");
+    }
+
+    if (y) {
+        tyFree(y);
+    }
+    astProgramFree(program);
+    lFree(l);
+    pFree(p);
+
+    return NULL;
+}
+
+// Output of the VM, the runtime error or the globals
+char *runVM(TypeChecker *y, astProgram *program) {
+    char  *text = NULL;
+    size_t size = 0;
+    FILE  *out  = open_memstream(&text, &size);
+
+    eErrorList *errors = eNew();
+    bcProgram  *bc     = bcCompile(y, program, errors);
+    VM         *vm     = vmNew(bc);
+
+    if (!vmRun(vm)) {
+        fprintf(out, "%s\n", vm->errors->data[0]);
+    } else {
+        vmPrintGlobals(vm, out);
+    }
+
+    vmFree(vm);
+    bcFree(bc);
+    eFree(errors);
+    fclose(out);
+
+    return text;
+}
+
+// Output of the SSA form, like runVM's
+char *runSSA(irProgram *p) {
+    char  *text = NULL;
+    size_t size = 0;
+    FILE  *out  = open_memstream(&text, &size);
+
+    Machine m;
+    memset(&m, 0, sizeof(m));
+    m.p          = p;
+    m.functionOf = (uint32_t *)calloc(p->types->symbols->size, sizeof(uint32_t));
+    for (uint32_t i = 1; i < p->size; i++) {
+        m.functionOf[p->functions[i].symbol] = i;
+    }
+
+    bcValue *globals = (bcValue *)calloc(p->globalSize + 1, sizeof(bcValue));
+    mCall(&m, 0, NULL, NULL, globals);
+
+    if (m.failed) {
+        fprintf(out, "%s\n", m.error);
+    } else {
+        for (uint32_t i = 0; i < p->globalSize; i++) {
+            printGlobal(out, &p->types->symbols->symbols[p->globals[i]], globals[i]);
+        }
+    }
+
+    free(globals);
+    free(m.functionOf);
+    fclose(out);
+
+    return text;
+}
+
+// Call a function, or the program body with `results` receiving the globals
+bcValue mCall(Machine *m, uint32_t index, Frame *link, bcValue *arguments, bcValue *results) {
+    irFunction  *f       = &m->p->functions[index];
+    SymbolTable *symbols = m->p->types->symbols;
+
+    Frame frame;
+    frame.memory = (bcValue *)calloc(symbols->size, sizeof(bcValue));
+    frame.values = (bcValue *)calloc(f->size + 1, sizeof(bcValue));
+    frame.link   = link;
+    frame.depth  = f->depth;
+
+    // Every argument lands in memory, the ones in SSA form are also the IR_PARAM values
+    if (index > 0) {
+        astFunctionStmt *function = symbols->symbols[f->symbol].function;
+        uint32_t         k        = 0;
+        for (uint32_t i = 0; i < function->size; i++) {
+            for (uint32_t j = 0; function->parameters[i] && j < function->parameters[i]->size; j++) {
+                astDeclarationStmt *declaration = function->parameters[i]->declarations[j];
+                for (uint32_t n = 0; declaration && n < declaration->size; n++) {
+                    frame.memory[declaration->identifier[n]->symbol] = arguments[k++];
+                }
+            }
+        }
+        for (uint32_t v = 0; v < f->size; v++) {
+            if (!f->instrs[v].dead && f->instrs[v].op == IR_PARAM) {
+                frame.values[v] = arguments[f->instrs[v].k.i];
+            }
+        }
+    }
+
+    bcValue result = mExecute(m, f, &frame, results);
+
+    free(frame.memory);
+    free(frame.values);
+
+    return result;
+}
+
+// Run a function from its entry block to its IR_RETURN
+bcValue mExecute(Machine *m, irFunction *f, Frame *frame, bcValue *results) {
+    bcValue  zero     = {.i = 0};
+    uint32_t block    = 0;
+    uint32_t previous = IR_NONE;
+
+    for (;;) {
+        irBlock *b = &f->blocks[block];
+
+        // The phis read their operands all at once, before any of them is written
+        uint32_t edge = 0;
+        for (uint32_t i = 0; previous != IR_NONE && i < b->predSize; i++) {
+            if (b->preds[i] == previous) {
+                edge = i;
+                break;
+            }
+        }
+        uint32_t phis = 0;
+        while (phis < b->size && f->instrs[b->instrs[phis]].op == IR_PHI) {
+            phis++;
+        }
+        bcValue *incoming = (bcValue *)malloc(sizeof(bcValue) * (phis + 1));
+        for (uint32_t k = 0; k < phis; k++) {
+            incoming[k] = frame->values[f->instrs[b->instrs[k]].args[edge]];
+        }
+        for (uint32_t k = 0; k < phis; k++) {
+            frame->values[b->instrs[k]] = incoming[k];
+        }
+        free(incoming);
+
+        for (uint32_t k = phis; k < b->size; k++) {
+            uint32_t v  = b->instrs[k];
+            irInstr *in = &f->instrs[v];
+            bcValue  a  = in->size > 0 ? frame->values[in->args[0]] : zero;
+            bcValue  c  = in->size > 1 ? frame->values[in->args[1]] : zero;
+            bcValue  r  = zero;
+
+            switch (in->op) {
+                case IR_CONST:
+                    r = in->k;
+                    break;
+                case IR_PARAM:
+                    continue;
+                case IR_DIVI:
+                case IR_MODI:
+                    if (c.i == 0) {
+                        mFail(m, in->line, f->name, "divisão por zero");
+                        return zero;
+                    }
+                    if (c.i == -1) {
+                        r.i = in->op == IR_DIVI ? (int64_t)(0 - (uint64_t)a.i) : 0;
+                    } else {
+                        r.i = in->op == IR_DIVI ? a.i / c.i : a.i % c.i;
+                    }
+                    break;
+                case IR_DIVF:
+                    if (c.r == 0) {
+                        mFail(m, in->line, f->name, "divisão por zero");
+                        return zero;
+                    }
+                    r.r = a.r / c.r;
+                    break;
+                case IR_CONCAT: {
+                    size_t length = strlen(TEXT(a.s)) + strlen(TEXT(c.s));
+                    if (length > 0) {
+                        r.s = (char *)malloc(length + 1);
+                        strcpy(r.s, TEXT(a.s));
+                        strcat(r.s, TEXT(c.s));
+                    }
+                    break;
+                }
+                case IR_C2S:
+                    r.s    = (char *)malloc(2);
+                    r.s[0] = (char)a.i;
+                    r.s[1] = '\0';
+                    break;
+                case IR_LOAD:
+                    r = *mAddress(m, frame, in->symbol);
+                    break;
+                case IR_STORE:
+                    *mAddress(m, frame, in->symbol) = a;
+                    continue;
+                case IR_ADDR:
+                    r.p = mAddress(m, frame, in->symbol);
+                    break;
+                case IR_CALL: {
+                    // The VM counts the program body as a call in progress
+                    if (m->calls + 1 >= VM_MAX_FRAMES) {
+                        mFail(m, in->line, f->name, "estouro de pilha");
+                        return zero;
+                    }
+
+                    bcValue *arguments = (bcValue *)malloc(sizeof(bcValue) * (in->size + 1));
+                    for (uint32_t i = 0; i < in->size; i++) {
+                        arguments[i] = frame->values[in->args[i]];
+                    }
+
+                    sySymbol *callee = &m->p->types->symbols->symbols[in->symbol];
+                    m->calls++;
+                    r = mCall(m, m->functionOf[in->symbol], mFrameAt(frame, callee->depth), arguments, NULL);
+                    m->calls--;
+                    free(arguments);
+
+                    if (m->failed) {
+                        return zero;
+                    }
+                    break;
+                }
+                case IR_JUMP:
+                case IR_BRANCH:
+                    previous = block;
+                    block    = b->succs[in->op == IR_JUMP || a.i ? 0 : 1];
+                    break;
+                case IR_RETURN:
+                    for (uint32_t i = 0; results && i < in->size; i++) {
+                        results[i] = frame->values[in->args[i]];
+                    }
+                    return in->size > 0 ? a : zero;
+                default:
+                    irFold((irOp)in->op, a, in->size > 1 ? c : a, &r);
+                    break;
+            }
+
+            if (in->op == IR_JUMP || in->op == IR_BRANCH) {
+                break;
+            }
+            frame->values[v] = r;
+        }
+    }
+}
+
+// Stop the program on a runtime error, with the VM's message
+void mFail(Machine *m, uint64_t line, char *function, char *msg) {
+    if (!m->failed) {
+        snprintf(m->error, sizeof(m->error), "Linha %" PRIu64 ": Erro de execução em `%.127s`: %s", line, function,
+                 msg);
+    }
+    m->failed = true;
+}
+
+// Frame of the enclosing function whose body is at `depth`
+Frame *mFrameAt(Frame *frame, uint32_t depth) {
+    while (frame->depth != depth) {
+        frame = frame->link;
+    }
+    return frame;
+}
+
+// Memory of a variable, a function symbol stands for its result, in the frame of its body
+bcValue *mAddress(Machine *m, Frame *frame, uint32_t symbol) {
+    sySymbol *s     = &m->p->types->symbols->symbols[symbol];
+    Frame    *owner = mFrameAt(frame, s->kind == SY_FUNCTION ? s->depth + 1 : s->depth);
+
+    return s->reference ? (bcValue *)owner->memory[symbol].p : &owner->memory[symbol];
+}
+
+// Print a global like vmPrintGlobals
+void printGlobal(FILE *out, sySymbol *s, bcValue value) {
+    switch (tyOfTypeExpr(s->type)) {
+        case TY_INTEGER:
+            fprintf(out, "%s = %" PRId64 "\n", s->name, value.i);
+            break;
+        case TY_REAL:
+            fprintf(out, "%s = %.17g\n", s->name, value.r);
+            break;
+        case TY_BOOLEAN:
+            fprintf(out, "%s = %s\n", s->name, value.i ? "true" : "false");
+            break;
+        case TY_CHAR:
+            fprintf(out, "%s = '%c'\n", s->name, (char)value.i);
+            break;
+        case TY_STRING:
+            fprintf(out, "%s = \"%s\"\n", s->name, TEXT(value.s));
+            break;
+        default:
+            break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Compara a saída de --run com a de --jit em programas gerados por gen.py, loops.py e consts.py, incluindo a linha dos
+# erros de execução, para conferir os stencils copiados e preenchidos pelo JIT
+# O tamanho do código e o tempo de compilação saem em stderr e não entram na comparação
+# Uso: tests/jit.sh [primeira semente] [última semente] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-200}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+failed=0
+for seed in $(seq "$first" "$last"); do
+    python3 "$dir/gen.py" "$seed" > "$tmp/p$seed.pas"
+    python3 "$dir/loops.py" "$seed" > "$tmp/l$seed.pas"
+    python3 "$dir/consts.py" "$seed" > "$tmp/k$seed.pas"
+
+    for pas in "$tmp/p$seed.pas" "$tmp/l$seed.pas" "$tmp/k$seed.pas"; do
+        "$psa" --run "$pas" > "$tmp/vm" 2> /dev/null
+        echo "saída $?" >> "$tmp/vm"
+        "$psa" --jit "$pas" > "$tmp/jit" 2> /dev/null
+        echo "saída $?" >> "$tmp/jit"
+        if ! cmp -s "$tmp/vm" "$tmp/jit"; then
+            echo "semente $seed, $(basename "$pas"): saídas diferentes"
+            failed=$((failed + 1))
+        fi
+    done
+done
+
+echo "$((3 * (last - first + 1))) programas, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
@@ -0,0 +1,102 @@
+# Gera um programa Pascal com laços aninhados, para exercitar a remoção de expressões invariantes dos laços
+# Os laços contam até no máximo 4 e usam variáveis globais, parâmetros `var`, variáveis de uma função usadas por uma
+# função aninhada e chamadas que mudam essas variáveis, que impedem mover uma expressão
+# As divisões por um valor que pode ser zero param o programa em uma linha que não pode mudar
+# Uso: python3 tests/loops.py <semente>
+import random
+import sys
+
+r = random.Random(int(sys.argv[1]))
+
+
+# Quebra de linha entre um operador e o operando da direita, para que a linha de um erro dependa da posição
+def gap():
+    return '\n' if r.random() < 0.25 else ' '
+
+
+def integer(names, depth=0, calls=None):
+    k = r.random()
+    if depth > 3 or k < 0.3:
+        return r.choice(names + [str(r.randint(-3, 9))])
+    if calls and k < 0.38:
+        return '%s(%s)' % (r.choice(calls), integer(names, depth + 1))
+    op = r.choice(['+', '-', '*', 'div', 'mod', '+', '*'])
+    if op in ('div', 'mod'):
+        k = r.random()
+        if k < 0.7:
+            return '(%s %s%s%s)' % (integer(names, depth + 1, calls), op, gap(), r.choice(['2', '3', '7', '-1', '1']))
+        if k < 0.95:
+            return '(%s %s%s((%s mod 5) + 6))' % (integer(names, depth + 1, calls), op, gap(),
+                                                  integer(names, depth + 1, calls))
+    if r.random() < 0.15:
+        return '-(%s)' % integer(names, depth + 1, calls)
+    return '(%s %s%s%s)' % (integer(names, depth + 1, calls), op, gap(), integer(names, depth + 1, calls))
+
+
+def condition(names, calls):
+    return '(%s %s %s)' % (integer(names, 1, calls), r.choice(['<', '>', '=', '<>', '<=', '>=']),
+                           integer(names, 1, calls))
+
+
+def body(names, targets, calls, counters, depth, indent, procs):
+    lines = []
+    for _ in range(r.randint(1, 4)):
+        k = r.random()
+        if k < 0.45:
+            lines.append('%s%s := %s;' % (indent, r.choice(targets), integer(names, 0, calls)))
+        elif k < 0.55 and procs:
+            name, arguments = r.choice(procs)
+            lines.append('%s%s(%s);' % (indent, name, arguments()))
+        elif k < 0.62:
+            lines.append('%sr := r + %s / %s;' % (indent, integer(names, 1, calls),
+                                                  r.choice(['2.0', '3', '(r + 1.5)', integer(names, 2)])))
+        elif k < 0.75:
+            lines.append('%sif %s then %s := %s;' % (indent, condition(names, calls), r.choice(targets),
+                                                     integer(names, 0, calls)))
+        elif k < 0.9 and depth < 3 and counters:
+            lines += loop(names, targets, calls, counters, depth + 1, indent, procs)
+        else:
+            divisor = integer(names, 1, calls) if r.random() < 0.2 else '((%s mod 5) + 6)' % integer(names, 1, calls)
+            lines.append('%s%s := %s div%s%s;' % (indent, r.choice(targets), integer(names, 1, calls), gap(), divisor))
+    return lines
+
+
+def loop(names, targets, calls, counters, depth, indent, procs):
+    counter = counters[0]
+    limit = r.choice(['3', '4', '2', '(n mod 5)', '((a mod 3) + 2)'])
+    lines = ['%s%s := 0;' % (indent, counter), '%swhile %s < %s do begin' % (indent, counter, limit)]
+    lines += body(names + [counter], targets, calls, counters[1:], depth, indent + '    ', procs)
+    lines.append('%s    %s := %s + 1;' % (indent, counter, counter))
+    lines.append('%send' % indent)
+    return lines
+
+
+out = ['program p;', 'var']
+out += ['   %s : integer;' % g for g in ['a', 'b', 'c', 'n', 'i', 'j', 'k']]
+out.append('   r : real;')
+
+# f muda uma global em metade dos programas, q recebe um parâmetro `var` e inner muda uma variável de h
+out += ['function f(x: integer): integer;', 'begin']
+if r.random() < 0.5:
+    out.append('    b := b + 1;')
+out += ['    f := x * 2 + b;', 'end']
+out += ['procedure q(var v: integer; w: integer);', 'begin', '    v := v + w;', 'end']
+out += ['function h(x: integer; var y: integer): integer;', 'var', '   i : integer;', '   j : integer;',
+        '   t : integer;', '   u : integer;', '    procedure inner;', '    begin', '        u := u + 1;', '    end',
+        'begin', '    t := x + 1;']
+local = ['x', 'y', 't', 'u', 'a', 'c']
+procs = [('inner', lambda: '')] if r.random() < 0.5 else []
+if r.random() < 0.5:
+    procs.append(('q', lambda: '%s, %s' % (r.choice(['t', 'u', 'y']), integer(local, 2))))
+out += loop(local, ['t', 'u', 'y', r.choice(['t', 'c', 'x'])], r.choice([None, ['f']]), ['i', 'j'], 1, '    ', procs)
+out += ['    h := t + u + y;', 'end']
+
+out += ['begin', '    a := %d;' % r.randint(-5, 9), '    c := %d;' % r.randint(-5, 9), '    n := %d;' % r.randint(0, 9),
+        '    b := %d;' % r.randint(-2, 5)]
+names = ['a', 'b', 'c', 'n']
+procs = [('q', lambda: '%s, %s' % (r.choice(['a', 'b', 'c']), integer(names, 2))),
+         ('c := h', lambda: '%s, %s' % (integer(names, 2), r.choice(['a', 'b'])))]
+out += loop(names, ['a', 'b', 'c'], r.choice([None, ['f']]), ['i', 'j', 'k'], 1, '    ', procs)
+out += loop(names, ['a', 'c'], None, ['i', 'j', 'k'], 1, '    ', [])
+out.append('end.')
+print('\n'.join(out))
\ No newline at end of file
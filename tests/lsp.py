@@ -0,0 +1,133 @@
+# Abre programas gerados por gen.py no servidor de --lsp e aplica edições aleatórias incrementais, conferindo depois de
+# cada edição se os diagnósticos publicados são os mesmos que --check dá para o texto inteiro, mensagens e linhas
+# As edições inserem e apagam trechos em qualquer posição, inclusive caracteres fora do ASCII, para que o servidor
+# reaproveite as verificações das funções que a edição não tocou e desloque as linhas dos seus erros
+# Uso: python3 tests/lsp.py <PascalSyntaxAnalyzer> [primeira semente] [última semente] [edições]
+import json
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+psa = sys.argv[1]
+first = int(sys.argv[2]) if len(sys.argv) > 2 else 1
+last = int(sys.argv[3]) if len(sys.argv) > 3 else 20
+steps = int(sys.argv[4]) if len(sys.argv) > 4 else 100
+here = os.path.dirname(os.path.abspath(__file__))
+
+
+def send(p, message):
+    body = json.dumps(message).encode()
+    p.stdin.write(b'Content-Length: %d\r\n\r\n' % len(body) + body)
+    p.stdin.flush()
+
+
+def receive(p):
+    header = b''
+    while not header.endswith(b'\r\n\r\n'):
+        c = p.stdout.read(1)
+        if not c:
+            raise EOFError('o servidor fechou a saída')
+        header += c
+    length = int(re.search(rb'Content-Length: (\d+)', header).group(1))
+    return json.loads(p.stdout.read(length))
+
+
+# Resposta a um pedido, pulando as notificações no caminho
+def request(p, id, method, params):
+    send(p, {'jsonrpc': '2.0', 'id': id, 'method': method, 'params': params})
+    while True:
+        message = receive(p)
+        if message.get('id') == id:
+            return message
+
+
+# Posição do LSP de um índice do texto, a coluna conta unidades de UTF-16
+def position(text, offset):
+    before = text[:offset]
+    start = before.rfind('\n') + 1
+    return {'line': before.count('\n'), 'character': len(before[start:].encode('utf-16-le')) // 2}
+
+
+# A mensagem corta o token em um número de bytes e pode partir um caractere, o servidor troca cada byte solto por um
+# U+FFFD e o Python troca a sequência inteira por um só
+def replaced(message):
+    return re.sub('\ufffd+', '\ufffd', message)
+
+
+def check(path, text):
+    with open(path, 'w') as f:
+        f.write(text)
+    out = subprocess.run([psa, '--check', path], capture_output=True).stdout.decode('utf-8', 'replace')
+    # Uma mensagem pode ter várias linhas quando o token tem quebras de linha, vai até o próximo erro ou o resumo
+    error = re.escape(path) + r': Erro \d+: '
+    found = re.findall(r'^' + error + r'Linha (\d+): (.*?)\n(?=' + error + r'|\d+ de \d+ arquivo)', out, re.S | re.M)
+    return [(int(line) - 1, replaced(message)) for line, message in found]
+
+
+def replay(seed, path):
+    r = random.Random(seed)
+    text = subprocess.run([sys.executable, os.path.join(here, 'gen.py'), str(seed)], capture_output=True,
+                          text=True).stdout
+    wide  = ['ção', '😀', "'é😀'"]
+    words = re.findall(r'[A-Za-z_]\w*|\d+|:=|.', text)
+    extra = ['begin', 'end', ';', '(', ')', 'if', 'then', 'while', 'do', '\n', 'end.', '"abc',
+             'function f(a: integer): integer;', 'var x : integer;', 'procedure q; begin end\n', 'a := 1;\n']
+
+    p = subprocess.Popen([psa, '--lsp'], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+    request(p, 1, 'initialize', {'capabilities': {}})
+    send(p, {'jsonrpc': '2.0', 'method': 'initialized', 'params': {}})
+
+    uri = 'file:///p%d.pas' % seed
+    send(p, {'jsonrpc': '2.0', 'method': 'textDocument/didOpen',
+             'params': {'textDocument': {'uri': uri, 'languageId': 'pascal', 'version': 1, 'text': text}}})
+    receive(p)
+
+    # Metade das edições cai perto da anterior, como ao digitar, e passa pelos caracteres que ela inseriu
+    start = 0
+    for step in range(steps):
+        if r.random() < 0.5:
+            start = r.randrange(len(text) + 1)
+        else:
+            start = max(0, min(len(text), start + r.randint(-8, 8)))
+        end = min(len(text), start + r.choice([0, 0, 1, 2, 5, 20]))
+        inserted = r.choice(['', '', r.choice(words + extra), ' ' + r.choice(words) + ' ', r.choice(wide)])
+        change = {'range': {'start': position(text, start), 'end': position(text, end)}, 'text': inserted}
+        text = text[:start] + inserted + text[end:]
+
+        send(p, {'jsonrpc': '2.0', 'method': 'textDocument/didChange',
+                 'params': {'textDocument': {'uri': uri, 'version': step + 2}, 'contentChanges': [change]}})
+        published = receive(p)['params']['diagnostics']
+
+        got = [(d['range']['start']['line'], replaced(d['message'])) for d in published]
+        expected = check(path, text)
+        if got != expected:
+            print('semente %d, edição %d: diagnósticos diferentes' % (seed, step))
+            i = next((i for i, (a, b) in enumerate(zip(got, expected)) if a != b), min(len(got), len(expected)))
+            print('  --lsp:   %s' % got[i:i + 2])
+            print('  --check: %s' % expected[i:i + 2])
+            p.kill()
+            return False
+
+        # Os pedidos que constroem a árvore não podem mudar o que as próximas edições reaproveitam
+        if r.random() < 0.1:
+            request(p, 100 + step, 'textDocument/documentSymbol', {'textDocument': {'uri': uri}})
+
+    request(p, 2, 'shutdown', None)
+    send(p, {'jsonrpc': '2.0', 'method': 'exit', 'params': None})
+    if p.wait() != 0:
+        print('semente %d: o servidor saiu com código %d' % (seed, p.returncode))
+        return False
+    return True
+
+
+failed = 0
+with tempfile.TemporaryDirectory() as tmp:
+    for seed in range(first, last + 1):
+        if not replay(seed, os.path.join(tmp, 'p.pas')):
+            failed += 1
+
+print('%d programa(s), %d edições cada, %d diferença(s)' % (last - first + 1, steps, failed))
+sys.exit(1 if failed else 0)
\ No newline at end of file
@@ -0,0 +1,24 @@
+# Estraga um programa Pascal removendo, inserindo ou trocando de um a quatro tokens, para exercitar os erros de sintaxe
+# Os tokens inseridos vêm do próprio programa e de uma lista de palavras-chave, símbolos e literais malformados
+# Uso: python3 tests/mutate.py <arquivo> <semente>
+import random
+import re
+import sys
+
+TOKENS = r'\s+|[A-Za-z_][A-Za-z0-9_]*|\d+\.?\d*|"[^"]*"|\'.\'|:=|<>|<=|>=|.'
+EXTRA = ['(', ')', ';', ',', ':', 'begin', 'end', 'if', 'then', 'else', 'while', 'do', 'var', 'function',
+         'procedure', ':=', '1.2.3', '"sem fim', "'ab'", '@', 'and', 'or', 'not', '[', ']', 'end.']
+
+r = random.Random(int(sys.argv[2]))
+tokens = re.findall(TOKENS, open(sys.argv[1]).read())
+pool = [t for t in tokens if not t.isspace()] + EXTRA
+for _ in range(r.randint(1, 4)):
+    k = r.randrange(len(tokens))
+    op = r.random()
+    if op < 0.4:
+        del tokens[k]
+    elif op < 0.8:
+        tokens.insert(k, ' ' + r.choice(pool) + ' ')
+    else:
+        tokens[k] = ' ' + r.choice(pool) + ' '
+print(''.join(tokens), end='')
\ No newline at end of file
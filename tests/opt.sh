@@ -0,0 +1,31 @@
+#!/bin/sh
+# Compara a saída de --run com a de --run-opt, --jit -O e --interp -O em programas gerados por gen.py e por loops.py,
+# incluindo a linha dos erros de execução. O -O de --emit-c e --emit-asm é comparado em emitc.sh e emitasm.sh
+# Os avisos e o tempo do otimizador saem em stderr e não entram na comparação
+# Uso: tests/opt.sh [primeira semente] [última semente] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-200}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+failed=0
+for seed in $(seq "$first" "$last"); do
+    python3 "$dir/gen.py" "$seed" > "$tmp/p$seed.pas"
+    python3 "$dir/loops.py" "$seed" > "$tmp/l$seed.pas"
+
+    for pas in "$tmp/p$seed.pas" "$tmp/l$seed.pas"; do
+        vm=$("$psa" --run "$pas" 2> /dev/null; echo "saída $?")
+        for mode in --run-opt "--jit -O" "--interp -O"; do
+            opt=$("$psa" $mode "$pas" 2> /dev/null; echo "saída $?")
+            if [ "$vm" != "$opt" ]; then
+                echo "semente $seed, $(basename "$pas"), $mode: saídas diferentes"
+                failed=$((failed + 1))
+            fi
+        done
+    done
+done
+
+echo "$((2 * (last - first + 1))) programas em 3 modos, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
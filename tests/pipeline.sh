@@ -0,0 +1,52 @@
+#!/bin/sh
+# Compara o uso arquivo com --pipeline em programas gerados, nas versões válidas, estragadas e aumentadas, conferindo
+# a árvore escrita, as mensagens e o código de saída
+# A versão aumentada repete o bloco principal até passar da capacidade do anel de tokens
+# Uso: tests/pipeline.sh [primeira semente] [última semente] [PascalSyntaxAnalyzer]
+dir=$(cd "$(dirname "$0")" && pwd)
+first=${1:-1}
+last=${2:-200}
+psa=${3:-$dir/../bin/PascalSyntaxAnalyzer}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# Analisa $2 com o uso arquivo e com --pipeline e mostra as diferenças, identificadas por $1
+compare() {
+    rm -f "$tmp/file.out" "$tmp/pipe.out"
+    "$psa" "$2" "$tmp/file.out" > "$tmp/file.log" 2>&1
+    echo "saída $?" >> "$tmp/file.log"
+    "$psa" --pipeline "$2" "$tmp/pipe.out" > "$tmp/pipe.log" 2>&1
+    echo "saída $?" >> "$tmp/pipe.log"
+    if ! cmp -s "$tmp/file.log" "$tmp/pipe.log"; then
+        echo "$1: mensagens diferentes"
+        diff "$tmp/file.log" "$tmp/pipe.log" | head -5
+        return 1
+    fi
+    if [ -f "$tmp/file.out" ] || [ -f "$tmp/pipe.out" ] && ! cmp -s "$tmp/file.out" "$tmp/pipe.out"; then
+        echo "$1: árvores diferentes"
+        return 1
+    fi
+    return 0
+}
+
+failed=0
+count=0
+for seed in $(seq "$first" "$last"); do
+    pas=$tmp/p$seed.pas
+    python3 "$dir/gen.py" "$seed" > "$pas"
+    python3 "$dir/mutate.py" "$pas" "$seed" > "$tmp/m$seed.pas"
+    awk '/^begin$/ { main = NR } { line[NR] = $0 } END {
+        for (i = 1; i <= main; i++) print line[i]
+        for (k = 0; k < 200; k++) for (i = main + 1; i < NR; i++) print line[i]
+        print line[NR]
+    }' "$pas" > "$tmp/g$seed.pas"
+    python3 "$dir/mutate.py" "$tmp/g$seed.pas" "$seed" > "$tmp/h$seed.pas"
+
+    for input in "$pas" "$tmp/m$seed.pas" "$tmp/g$seed.pas" "$tmp/h$seed.pas"; do
+        count=$((count + 1))
+        compare "semente $seed, $(basename "$input")" "$input" || failed=$((failed + 1))
+    done
+done
+
+echo "$count arquivos, $failed diferença(s)"
+[ "$failed" -eq 0 ]
\ No newline at end of file
@@ -0,0 +1,162 @@
+# Monta tools/stencils.s com o GNU as e escreve a tabela jitStencils de src/jit.c a partir do objeto gerado
+# Cada stencil é uma seção, seus bytes são o código de máquina e cada relocação contra um símbolo JIT_HOLE_* é um buraco
+# O comentário de cada stencil é o seu código, com os buracos pelos nomes curtos usados no comentário de src/jit.c
+# Sem arquivo, mostra a tabela. Com o arquivo, troca a tabela dele, ou só confere se está atualizada com --check
+# Uso: python3 tools/stencils.py [src/jit.c [--check]]
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+WIDTH = 120  # Colunas de uma linha
+BYTES = 24   # Bytes de cada literal de string
+
+# Nome curto de cada buraco no comentário, os outros usam o nome sem o prefixo JIT_HOLE_
+SHORT = {'JIT_HOLE_IMMEDIATE': 'I', 'JIT_HOLE_CONSTANT': 'K', 'JIT_HOLE_MESSAGE': 'MSG'}
+
+# Relocações aceitas em cada tamanho de buraco: R_X86_64_64, R_X86_64_PC32 e R_X86_64_PLT32, R_X86_64_32 e 32S
+ABSOLUTE64 = {'JIT_HOLE_CONSTANT', 'JIT_HOLE_FUNCTION', 'JIT_HOLE_MESSAGE', 'JIT_HOLE_FAIL', 'JIT_HOLE_TICK',
+              'JIT_HOLE_COMPARE', 'JIT_HOLE_STRING', 'JIT_HOLE_CHAR'}
+RELATIVE = {'JIT_HOLE_TARGET', 'JIT_HOLE_CALL', 'JIT_HOLE_ERROR', 'JIT_HOLE_EXIT'}
+
+
+def fail(msg):
+    sys.stderr.write('stencils: %s\n' % msg)
+    sys.exit(1)
+
+
+def cstring(data, offset):
+    return data[offset:data.index(b'\0', offset)].decode()
+
+
+# Seções do objeto ELF64: nome -> (tipo, offset, tamanho, link, info)
+def sections(data):
+    shoff, = struct.unpack_from('<Q', data, 0x28)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x3a)
+    headers = [struct.unpack_from('<IIQQQQIIQQ', data, shoff + i * shentsize) for i in range(shnum)]
+    names = headers[shstrndx][4]
+    return [(cstring(data, names + h[0]), h[1], h[4], h[5], h[6], h[7]) for h in headers]
+
+
+# Bytes e buracos de cada seção .text.JIT_*, na ordem do arquivo
+def stencils(path):
+    data = open(path, 'rb').read()
+    secs = sections(data)
+    out = {}
+    order = []
+    for index, (name, kind, offset, size, link, info) in enumerate(secs):
+        if name.startswith('.text.JIT_'):
+            out[index] = [name[len('.text.'):], data[offset:offset + size], []]
+            order.append(index)
+
+    for name, kind, offset, size, link, info in secs:
+        if kind != 4 or info not in out:  # SHT_RELA
+            continue
+        symtab = secs[link]
+        strtab = secs[symtab[4]]
+        stencil = out[info]
+        for at in range(offset, offset + size, 24):
+            where, rinfo, addend = struct.unpack_from('<QQq', data, at)
+            symbol = rinfo >> 32
+            rtype = rinfo & 0xffffffff
+            st_name, = struct.unpack_from('<I', data, symtab[2] + symbol * 24)
+            hole = cstring(data, strtab[2] + st_name)
+            if not hole.startswith('JIT_HOLE_'):
+                fail('%s: relocação contra %s no byte %d' % (stencil[0], hole or 'uma seção', where))
+            if hole in ABSOLUTE64:
+                ok = rtype == 1 and addend == 0
+            elif hole in RELATIVE:
+                ok = rtype in (2, 4) and addend == -4
+            else:
+                ok = rtype in (10, 11) and addend == 0
+            if not ok:
+                fail('%s: relocação %d com %d para %s no byte %d' % (stencil[0], rtype, addend, hole, where))
+            stencil[2].append((where, hole))
+
+    for index in order:
+        out[index][2].sort()
+    return [out[i] for i in order]
+
+
+# Instruções de cada seção, como escritas em tools/stencils.s
+def listings(path):
+    code = {}
+    name = None
+    for line in open(path):
+        line = line.split('#')[0].strip()
+        m = re.match(r'\.section\s+\.text\.(JIT_\w+)', line)
+        if m:
+            name = m.group(1)
+            code[name] = []
+        elif name and line and not line.startswith('.'):
+            line = re.sub(r'\s+', ' ', line).replace('qword ptr ', '').replace('offset ', '')
+            line = re.sub(r'\bJIT_HOLE_\w+', lambda h: SHORT.get(h.group(0), h.group(0)[len('JIT_HOLE_'):]), line)
+            code[name].append(line)
+    return code
+
+
+# Junta os itens com o separador em linhas de até WIDTH colunas
+def wrap(first, rest, items, sep):
+    lines = [first + items[0]]
+    for item in items[1:]:
+        if len(lines[-1]) + len(sep) + len(item) <= WIDTH:
+            lines[-1] += sep + item
+        else:
+            lines.append(rest + item)
+    return lines
+
+
+def entry(name, code, holes, listing):
+    lines = wrap('    // %s: ' % name, '    // ', listing, '; ')
+
+    literals = [''.join('\\x%02x' % b for b in code[i:i + BYTES]) for i in range(0, len(code), BYTES)]
+    lines.append('    {"' + literals[0])
+    for literal in literals[1:]:
+        lines[-1] += '"'
+        lines.append('     "' + literal)
+
+    text = ', '.join('{%d, %s}' % h for h in holes) if holes else '{0, 0}'
+    tail = '%d, %d, {%s}},' % (len(code), len(holes), text)
+    if len(lines[-1]) + len('", ') + len(tail) <= WIDTH:
+        lines[-1] += '", ' + tail
+    else:
+        lines[-1] += '",'
+        lines.append('     ' + tail)
+    return lines
+
+
+def table(root):
+    source = os.path.join(root, 'tools', 'stencils.s')
+    with tempfile.TemporaryDirectory() as tmp:
+        obj = os.path.join(tmp, 'stencils.o')
+        subprocess.run(['as', '--64', '-o', obj, source], check=True)
+        assembled = stencils(obj)
+    code = listings(source)
+
+    lines = []
+    for name, data, holes in assembled:
+        for at, hole in holes:
+            if any(data[at:at + (8 if hole in ABSOLUTE64 else 4)]):
+                fail('%s: o buraco %s no byte %d não está zerado' % (name, hole, at))
+        lines += entry(name, data, holes, code[name])
+    return '\n'.join(lines) + '\n'
+
+
+root = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+generated = table(root)
+if len(sys.argv) < 2:
+    print(generated, end='')
+    sys.exit(0)
+
+start = 'static const jitStencil jitStencils[JIT_STENCILS] = {\n'
+text = open(sys.argv[1]).read()
+begin = text.index(start) + len(start)
+end = text.index('};', begin)
+if '--check' in sys.argv:
+    if text[begin:end] != generated:
+        fail('a tabela de %s não é a gerada por tools/stencils.s' % sys.argv[1])
+    sys.exit(0)
+with open(sys.argv[1], 'w') as out:
+    out.write(text[:begin] + generated + text[end:])
\ No newline at end of file
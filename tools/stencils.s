@@ -0,0 +1,463 @@
+# Stencils of the JIT, one section each in the order of jitStencilId, written into src/jit.c by tools/stencils.py
+# Each hole is an undefined symbol named for its jitHoleKind, so the assembler zeroes its bytes and leaves a relocation
+# where the JIT patches the instruction. Relative holes are jump and call targets, so they all end their instruction
+# rbx holds the registers of the running frame, r12 the running vmFrame, r13 the globals and r14 the jitContext
+    .intel_syntax noprefix
+
+# Called from C, saves the registers the code takes over and runs the program body
+    .section .text.JIT_ENTRY
+    push    rbp
+    push    rbx
+    push    r12
+    push    r13
+    push    r14
+    push    r15
+    sub     rsp, 8
+    mov     r14, rdi
+    mov     rbx, rsi
+    mov     r12, rdx
+    mov     r13, rcx
+    mov     [r14+24], rsp
+    call    r8
+    add     rsp, 8
+    pop     r15
+    pop     r14
+    pop     r13
+    pop     r12
+    pop     rbx
+    pop     rbp
+    ret
+
+# Unwinds the native stack of a run stopped by a runtime error
+    .section .text.JIT_EXIT
+    mov     rsp, [r14+24]
+    xor     eax, eax
+    add     rsp, 8
+    pop     r15
+    pop     r14
+    pop     r13
+    pop     r12
+    pop     rbx
+    pop     rbp
+    ret
+
+# Start of a function
+    .section .text.JIT_PROLOGUE
+    sub     rsp, 8
+
+# Counts down the fuel, checks the deadline once it runs out
+    .section .text.JIT_TICK
+    sub     qword ptr [r14+32], 1
+    jnz     1f
+    mov     rdi, r14
+    mov     rsi, r12
+    mov     edx, offset JIT_HOLE_PC
+    movabs  rax, offset JIT_HOLE_TICK
+    call    rax
+    test    al, al
+    jz      JIT_HOLE_EXIT
+1:
+
+# Runtime error exit of an instruction
+    .section .text.JIT_FAIL
+    mov     rdi, r14
+    mov     rsi, r12
+    mov     edx, offset JIT_HOLE_PC
+    movabs  rcx, offset JIT_HOLE_MESSAGE
+    movabs  rax, offset JIT_HOLE_FAIL
+    call    rax
+    jmp     JIT_HOLE_EXIT
+
+    .section .text.JIT_HALT
+    add     rsp, 8
+    mov     eax, 1
+    ret
+
+    .section .text.JIT_MOVE
+    mov     rax, [rbx+JIT_HOLE_B]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LOADI
+    mov     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+
+    .section .text.JIT_LOADK
+    movabs  rax, offset JIT_HOLE_CONSTANT
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_GETG
+    mov     rax, [r13+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_SETG
+    mov     rax, [rbx+JIT_HOLE_A]
+    mov     [r13+JIT_HOLE_C], rax
+
+# rcx = running frame, the start of a walk up the static links
+    .section .text.JIT_FRAME
+    mov     rcx, r12
+
+# rcx = static link of rcx
+    .section .text.JIT_LINK
+    mov     rcx, [rcx+24]
+
+    .section .text.JIT_GETUP
+    mov     rcx, [rcx+16]
+    mov     rax, [rcx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_SETUP
+    mov     rcx, [rcx+16]
+    mov     rax, [rbx+JIT_HOLE_A]
+    mov     [rcx+JIT_HOLE_C], rax
+
+    .section .text.JIT_ADDRUP
+    mov     rcx, [rcx+16]
+    lea     rax, [rcx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_ADDR
+    lea     rax, [rbx+JIT_HOLE_B]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_ADDRG
+    lea     rax, [r13+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LOADREF
+    mov     rax, [rbx+JIT_HOLE_B]
+    mov     rax, [rax]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_STOREREF
+    mov     rax, [rbx+JIT_HOLE_A]
+    mov     rcx, [rbx+JIT_HOLE_B]
+    mov     [rax], rcx
+
+    .section .text.JIT_ADDI
+    mov     rax, [rbx+JIT_HOLE_B]
+    add     rax, [rbx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_SUBI
+    mov     rax, [rbx+JIT_HOLE_B]
+    sub     rax, [rbx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_MULI
+    mov     rax, [rbx+JIT_HOLE_B]
+    imul    rax, [rbx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_AND
+    mov     rax, [rbx+JIT_HOLE_B]
+    and     rax, [rbx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_OR
+    mov     rax, [rbx+JIT_HOLE_B]
+    or      rax, [rbx+JIT_HOLE_C]
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_DIVI
+    mov     rcx, [rbx+JIT_HOLE_C]
+    test    rcx, rcx
+    je      JIT_HOLE_ERROR
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rcx, -1
+    jne     1f
+    neg     rax
+    jmp     2f
+1:
+    cqo
+    idiv    rcx
+2:
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_MODI
+    mov     rcx, [rbx+JIT_HOLE_C]
+    test    rcx, rcx
+    je      JIT_HOLE_ERROR
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rcx, -1
+    jne     1f
+    xor     eax, eax
+    jmp     2f
+1:
+    cqo
+    idiv    rcx
+    mov     rax, rdx
+2:
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_ADDIK
+    mov     rax, [rbx+JIT_HOLE_B]
+    add     rax, offset JIT_HOLE_IMMEDIATE
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_SUBIK
+    mov     rax, [rbx+JIT_HOLE_B]
+    sub     rax, offset JIT_HOLE_IMMEDIATE
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_NEGI
+    mov     rax, [rbx+JIT_HOLE_B]
+    neg     rax
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_ADDF
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    addsd   xmm0, [rbx+JIT_HOLE_C]
+    movsd   [rbx+JIT_HOLE_A], xmm0
+
+    .section .text.JIT_SUBF
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    subsd   xmm0, [rbx+JIT_HOLE_C]
+    movsd   [rbx+JIT_HOLE_A], xmm0
+
+    .section .text.JIT_MULF
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    mulsd   xmm0, [rbx+JIT_HOLE_C]
+    movsd   [rbx+JIT_HOLE_A], xmm0
+
+    .section .text.JIT_DIVF
+    movsd   xmm1, [rbx+JIT_HOLE_C]
+    xorpd   xmm0, xmm0
+    ucomisd xmm1, xmm0
+    jp      1f
+    je      JIT_HOLE_ERROR
+1:
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    divsd   xmm0, xmm1
+    movsd   [rbx+JIT_HOLE_A], xmm0
+
+    .section .text.JIT_NEGF
+    mov     rax, [rbx+JIT_HOLE_B]
+    btc     rax, 63
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_I2F
+    pxor    xmm0, xmm0
+    cvtsi2sd xmm0, qword ptr [rbx+JIT_HOLE_B]
+    movsd   [rbx+JIT_HOLE_A], xmm0
+
+    .section .text.JIT_EQI
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rax, [rbx+JIT_HOLE_C]
+    sete    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_NEI
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rax, [rbx+JIT_HOLE_C]
+    setne   al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LTI
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rax, [rbx+JIT_HOLE_C]
+    setl    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LEI
+    mov     rax, [rbx+JIT_HOLE_B]
+    cmp     rax, [rbx+JIT_HOLE_C]
+    setle   al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_EQF
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    ucomisd xmm0, [rbx+JIT_HOLE_C]
+    sete    al
+    setnp   cl
+    and     al, cl
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_NEF
+    movsd   xmm0, [rbx+JIT_HOLE_B]
+    ucomisd xmm0, [rbx+JIT_HOLE_C]
+    setne   al
+    setp    cl
+    or      al, cl
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LTF
+    movsd   xmm0, [rbx+JIT_HOLE_C]
+    ucomisd xmm0, [rbx+JIT_HOLE_B]
+    seta    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LEF
+    movsd   xmm0, [rbx+JIT_HOLE_C]
+    ucomisd xmm0, [rbx+JIT_HOLE_B]
+    setae   al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_EQS
+    mov     rdi, [rbx+JIT_HOLE_B]
+    mov     rsi, [rbx+JIT_HOLE_C]
+    movabs  rax, offset JIT_HOLE_COMPARE
+    call    rax
+    test    eax, eax
+    sete    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_NES
+    mov     rdi, [rbx+JIT_HOLE_B]
+    mov     rsi, [rbx+JIT_HOLE_C]
+    movabs  rax, offset JIT_HOLE_COMPARE
+    call    rax
+    test    eax, eax
+    setne   al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LTS
+    mov     rdi, [rbx+JIT_HOLE_B]
+    mov     rsi, [rbx+JIT_HOLE_C]
+    movabs  rax, offset JIT_HOLE_COMPARE
+    call    rax
+    test    eax, eax
+    setl    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_LES
+    mov     rdi, [rbx+JIT_HOLE_B]
+    mov     rsi, [rbx+JIT_HOLE_C]
+    movabs  rax, offset JIT_HOLE_COMPARE
+    call    rax
+    test    eax, eax
+    setle   al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_NOT
+    cmp     qword ptr [rbx+JIT_HOLE_B], 0
+    sete    al
+    movzx   eax, al
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_CONCAT
+    mov     rdi, [r14]
+    mov     rsi, [rbx+JIT_HOLE_B]
+    mov     rdx, [rbx+JIT_HOLE_C]
+    movabs  rax, offset JIT_HOLE_STRING
+    call    rax
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_C2S
+    mov     rdi, [r14]
+    mov     rsi, [rbx+JIT_HOLE_B]
+    movabs  rax, offset JIT_HOLE_CHAR
+    call    rax
+    mov     [rbx+JIT_HOLE_A], rax
+
+    .section .text.JIT_JMP
+    jmp     JIT_HOLE_TARGET
+
+    .section .text.JIT_JMPF
+    cmp     qword ptr [rbx+JIT_HOLE_A], 0
+    je      JIT_HOLE_TARGET
+
+    .section .text.JIT_JMPT
+    cmp     qword ptr [rbx+JIT_HOLE_A], 0
+    jne     JIT_HOLE_TARGET
+
+    .section .text.JIT_JLTI
+    mov     rax, [rbx+JIT_HOLE_A]
+    cmp     rax, [rbx+JIT_HOLE_B]
+    jl      JIT_HOLE_TARGET
+
+    .section .text.JIT_JLEI
+    mov     rax, [rbx+JIT_HOLE_A]
+    cmp     rax, [rbx+JIT_HOLE_B]
+    jle     JIT_HOLE_TARGET
+
+    .section .text.JIT_JEQI
+    mov     rax, [rbx+JIT_HOLE_A]
+    cmp     rax, [rbx+JIT_HOLE_B]
+    je      JIT_HOLE_TARGET
+
+    .section .text.JIT_JNEI
+    mov     rax, [rbx+JIT_HOLE_A]
+    cmp     rax, [rbx+JIT_HOLE_B]
+    jne     JIT_HOLE_TARGET
+
+    .section .text.JIT_JLTIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    jl      JIT_HOLE_TARGET
+
+    .section .text.JIT_JLEIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    jle     JIT_HOLE_TARGET
+
+    .section .text.JIT_JGTIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    jg      JIT_HOLE_TARGET
+
+    .section .text.JIT_JGEIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    jge     JIT_HOLE_TARGET
+
+    .section .text.JIT_JEQIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    je      JIT_HOLE_TARGET
+
+    .section .text.JIT_JNEIK
+    cmp     qword ptr [rbx+JIT_HOLE_A], offset JIT_HOLE_IMMEDIATE
+    jne     JIT_HOLE_TARGET
+
+# Checks the frame limits of a call and starts the walk to its static link
+    .section .text.JIT_CALL
+    lea     rax, [rbx+JIT_HOLE_A]
+    cmp     r12, [r14+16]
+    je      JIT_HOLE_ERROR
+    mov     rdx, [r14+8]
+    sub     rdx, rax
+    cmp     rdx, offset JIT_HOLE_SIZE
+    jb      JIT_HOLE_ERROR
+    mov     rcx, r12
+
+# Pushes the frame of a callee and moves to its registers
+    .section .text.JIT_ENTER
+    add     r12, 32
+    movabs  rdx, offset JIT_HOLE_FUNCTION
+    mov     [r12], rdx
+    mov     [r12+16], rax
+    mov     [r12+24], rcx
+    mov     rbx, rax
+
+# Zeroes a register of a callee
+    .section .text.JIT_ZERO
+    mov     qword ptr [rbx+JIT_HOLE_A], 0
+
+# Zeroes a run of registers of a callee
+    .section .text.JIT_ZEROS
+    lea     rdi, [rbx+JIT_HOLE_A]
+    mov     ecx, offset JIT_HOLE_COUNT
+    xor     eax, eax
+    rep     stosq
+
+# Calls a callee
+    .section .text.JIT_INVOKE
+    call    JIT_HOLE_CALL
+
+# Copies the result of a function to the first register of its frame
+    .section .text.JIT_RESULT
+    mov     rax, [rbx+JIT_HOLE_B]
+    mov     [rbx], rax
+
+    .section .text.JIT_RET
+    sub     r12, 32
+    mov     rbx, [r12+16]
+    add     rsp, 8
+    ret